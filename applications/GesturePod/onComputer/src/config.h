@@ -17,6 +17,11 @@
  * measurements (instances) that is used for featurization.
  */
 #define STRIDE					20
+/*
+ * The number of measurements in the window that is
+ * featurized.
+ */
+#define WINDOW_LENGTH 			(STRIDE * NUM_BUCKETS)
 /*
  * The width of the internal buffer that retains
  * a subwindow worth of measurements. 2 x because
@@ -138,3 +138,161 @@ int Featurizer::getBucket(
     if(bucketIndex>124 || bucketIndex<23) return 0;
     return 1;
 }
+
+RunTracker::RunTracker(){
+    runHead = 0;
+    runTail = 0;
+    candidateHead = 0;
+    candidateTail = 0;
+}
+
+RunTracker::Run& RunTracker::getRun(long id){
+    return runs[id % WINDOW_LENGTH];
+}
+
+/*
+ * Adds the measurement at `position`, the one following the last
+ * added measurement, which extends or starts a run if `inRun`.
+ */
+void RunTracker::add(long position, bool inRun){
+    if(!inRun)
+        return;
+    if(runTail > runHead && getRun(runTail - 1).start +
+        getRun(runTail - 1).length == position){
+        getRun(runTail - 1).length++;
+    } else {
+        getRun(runTail).start = position;
+        getRun(runTail).length = 1;
+        runTail++;
+    }
+    // The last run now dominates the shorter candidates before it
+    long last = runTail - 1;
+    if(candidateTail > candidateHead &&
+        candidates[(candidateTail - 1) % WINDOW_LENGTH] == last)
+        candidateTail--;
+    while(candidateTail > candidateHead &&
+        getRun(candidates[(candidateTail - 1) % WINDOW_LENGTH]).length <
+        getRun(last).length)
+        candidateTail--;
+    candidates[(candidateTail++) % WINDOW_LENGTH] = last;
+}
+
+/*
+ * Removes the measurement at `position`, the earliest one of the
+ * window.
+ */
+void RunTracker::remove(long position){
+    if(runTail == runHead || getRun(runHead).start != position)
+        return;
+    Run& first = getRun(runHead);
+    first.start++;
+    first.length--;
+    // Only the first run shrinks, which is the first candidate if any
+    bool isCandidate = candidateTail > candidateHead &&
+        candidates[candidateHead % WINDOW_LENGTH] == runHead;
+    if(first.length == 0){
+        if(isCandidate)
+            candidateHead++;
+        runHead++;
+    } else if(isCandidate && candidateTail - candidateHead > 1 &&
+        first.length < getRun(candidates[(candidateHead + 1) %
+        WINDOW_LENGTH]).length){
+        candidateHead++;
+    }
+}
+
+/*
+ * Returns the length of the longest run, 0 if there is none, and
+ * sets `index` to its start relative to `windowStart`.
+ */
+int RunTracker::longest(long windowStart, int *index){
+    if(candidateTail == candidateHead)
+        return 0;
+    Run& run = getRun(candidates[candidateHead % WINDOW_LENGTH]);
+    *index = (int)(run.start - windowStart);
+    return run.length;
+}
+
+IncrementalFeaturizer::IncrementalFeaturizer(int _bucketWidth){
+    if(_bucketWidth != 20)
+        exit(-1);
+    this->numSamples = 0;
+    for(int axis = 0; axis < 6; axis++)
+        for(int i = 0; i <= NUM_BUCKETS; i++)
+            this->histogram[axis][i] = 0;
+}
+
+/*
+ * Adds a measurement to the window, removing the earliest one once
+ * the window is full. The buckets and edge thresholds are those of
+ * Featurizer::getBucket.
+ */
+void IncrementalFeaturizer::addSample(const Vector3D<float> *acc,
+    const Vector3D<float> *gyr){
+    float values[6] = {acc->x, acc->y, acc->z, gyr->x, gyr->y, gyr->z};
+    long position = this->numSamples;
+    int slot = position % WINDOW_LENGTH;
+    bool full = position >= WINDOW_LENGTH;
+    if(full){
+        this->posEdges.remove(position - WINDOW_LENGTH);
+        this->negEdges.remove(position - WINDOW_LENGTH);
+    }
+    for(int axis = 0; axis < 6; axis++){
+        int val = (int)100 * values[axis];
+        int bucket;
+        if(val < 0)
+            bucket = 0;
+        else if(val > 100)
+            bucket = 19;
+        else
+            bucket = val/5;
+        if(full)
+            this->histogram[axis][this->buckets[axis][slot]]--;
+        this->buckets[axis][slot] = bucket;
+        this->histogram[axis][bucket]++;
+        // gy
+        if(axis == 4){
+            this->posEdges.add(position, val > 62);
+            this->negEdges.add(position, val < 32);
+        }
+    }
+    this->numSamples++;
+}
+
+/*
+ * Writes the features of the window to bucketDistribution, in the
+ * format of Featurizer::featurize. The bucket counts are added to
+ * those of bucketDistribution.
+ *
+ * @returns 1, or 0 until the window is full.
+ */
+int IncrementalFeaturizer::featurize(int bucketDistribution[]){
+    if(this->numSamples < WINDOW_LENGTH)
+        return 0;
+    bucketDistribution[0]=-1;
+    bucketDistribution[3]=-1;
+    for(int axis = 0; axis < 6; axis++){
+        int bucketIndex = 4 + axis * this->bucketWidth;
+        for(int i = 0; i <= NUM_BUCKETS; i++){
+            // Featurizer writes the extra bucket of gz past the
+            // feature vector
+            if(bucketIndex + i < FEATURE_LENGTH)
+                bucketDistribution[bucketIndex + i] += this->histogram[axis][i];
+        }
+    }
+    // Runs of at least 4 measurements, as in Featurizer::getBucket
+    int thresholdCount = 3;
+    long windowStart = this->numSamples - WINDOW_LENGTH;
+    int index = 0;
+    int count = this->posEdges.longest(windowStart, &index);
+    if(count > thresholdCount){
+        bucketDistribution[1] = count;
+        bucketDistribution[0] = index;
+    }
+    count = this->negEdges.longest(windowStart, &index);
+    if(count > thresholdCount){
+        bucketDistribution[2] = count;
+        bucketDistribution[3] = index;
+    }
+    return 1;
+}
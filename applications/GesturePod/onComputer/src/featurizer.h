@@ -39,4 +39,51 @@ public:
     int featurize(int bucketDistribution[]);
 };
 
+/*
+ * Runs of consecutive measurements of the window that meet a
+ * condition, such as the positive edges of gy. The longest run,
+ * the earliest one among runs of the same length, is kept up to
+ * date as measurements enter and leave the window.
+ */
+class RunTracker {
+    struct Run {
+        long start;
+        int length;
+    };
+    // The runs of the window, oldest first, in a ring indexed by run id
+    Run runs[WINDOW_LENGTH];
+    long runHead, runTail;
+    // Ids of the runs that can still become the longest one, with
+    // non-increasing lengths. The first one is the longest run.
+    long candidates[WINDOW_LENGTH];
+    long candidateHead, candidateTail;
+    Run& getRun(long id);
+public:
+    RunTracker();
+    void add(long position, bool inRun);
+    void remove(long position);
+    int longest(long windowStart, int *index);
+};
+
+/*
+ * Featurizer computing the same feature vector as Featurizer, but
+ * updating the bucket histograms and the gy edge runs as each
+ * measurement enters and leaves the window, rather than going over
+ * the whole window on every stride.
+ */
+class IncrementalFeaturizer {
+    // Bucket of each measurement of the window, per axis in the order
+    // ax, ay, az, gx, gy, gz. A value of exactly 100 falls in the extra
+    // bucket, which Featurizer adds to the first bucket of the next axis.
+    uint8_t buckets[6][WINDOW_LENGTH];
+    int histogram[6][NUM_BUCKETS + 1];
+    RunTracker posEdges, negEdges;
+    long numSamples;
+    int bucketWidth=20;
+public:
+    IncrementalFeaturizer(int bucketWidth);
+    void addSample(const Vector3D<float> *acc, const Vector3D<float> *gyr);
+    int featurize(int bucketDistribution[]);
+};
+
 #endif //__Featurizer__
\ No newline at end of file
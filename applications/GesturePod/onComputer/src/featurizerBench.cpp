@@ -0,0 +1,222 @@
+/*
+ * Copyright (c) Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT license.
+ *
+ * Validation of the incremental featurizer: replays the sensor data, as the
+ * simulation does, and checks that IncrementalFeaturizer computes the same
+ * feature vector as Featurizer on every window. Reports the featurization
+ * time per stride of both featurizers.
+ *
+ * Usage: featurizerbench [-s] [data file]
+ * With -s, a synthetic stream is replayed instead of the data file. Its gy
+ * axis holds edges longer than the window, edges crossing the start of the
+ * window as they leave it, edges of equal lengths and values of exactly 32,
+ * 62 and 65, where the edge detection of Featurizer changes branches.
+ */
+#include <iostream>
+#include <iomanip>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <vector>
+#include <chrono>
+#include "config.h"
+#include "featurizer.h"
+#include "utils.h"
+
+#define DATA_FILE "./data/taps.txt"
+// The data is replayed REPEAT times as one stream for the timing
+#define REPEAT 20
+// Number of randomly drawn gy segments of the synthetic stream
+#define SYNTHETIC_SEGMENTS 1000
+
+FIFOCircularQ<float, 400> normAX, normAY, normAZ;
+FIFOCircularQ<float, 400> normGX, normGY, normGZ;
+Featurizer featurizer(BUCKET_WIDTH, &normAX, &normAY, &normAZ,
+                      &normGX, &normGY, &normGZ);
+IncrementalFeaturizer incrementalFeaturizer(BUCKET_WIDTH);
+
+Vector3D<float> normAcc, normGyr;
+Vector3D<int16_t> minAcc(MIN_ACC, MIN_ACC, MIN_ACC);
+Vector3D<int16_t> maxAcc(MAX_ACC, MAX_ACC, MAX_ACC);
+Vector3D<int16_t> minGyr(MIN_GYR_X, MIN_GYR_Y, MIN_GYR_Z);
+Vector3D<int16_t> maxGyr(MAX_GYR_X, MAX_GYR_Y, MAX_GYR_Z);
+
+// Classes of gy values, by the scaled value val = (int)(100 * normalized gy)
+// that Featurizer compares to the edge thresholds
+enum GyClass { GY_HIGH, GY_LOW, GY_MID, GY_AT_62, GY_AT_32, GY_AT_65 };
+
+// Raw gy measurement of the class. HIGH is above 62, LOW below 32 and MID
+// in between, including a few values outside of [MIN_GYR_Y, MAX_GYR_Y]
+int gyValue(GyClass c) {
+    switch (c) {
+    case GY_HIGH: return 560 + rand() % 1640;    // val 63 to 103
+    case GY_LOW: return -2200 + rand() % 1450;   // val -3 to 31
+    case GY_MID: return -680 + rand() % 1160;    // val 33 to 61
+    case GY_AT_62: return 512;                   // val 62
+    case GY_AT_32: return -717;                  // val 32
+    default: return 632;                         // val 65
+    }
+}
+
+// Measurement of an axis other than gy, at the bounds of the range now and
+// then, so that the first, last and extra buckets are all hit
+int axisValue(int minValue, int maxValue) {
+    int r = rand() % 20;
+    if (r == 0)
+        return maxValue;
+    if (r == 1)
+        return minValue;
+    int range = maxValue - minValue;
+    return minValue - range / 20 + rand() % (range + range / 10);
+}
+
+void addSegment(std::vector<int> *data, GyClass c, int length) {
+    for (int i = 0; i < length; i++) {
+        data->push_back(axisValue(MIN_ACC, MAX_ACC));
+        data->push_back(axisValue(MIN_ACC, MAX_ACC));
+        data->push_back(axisValue(MIN_ACC, MAX_ACC));
+        data->push_back(axisValue(MIN_GYR_X, MAX_GYR_X));
+        data->push_back(gyValue(c));
+        data->push_back(axisValue(MIN_GYR_Z, MAX_GYR_Z));
+    }
+}
+
+/*
+ * Synthetic stream of measurements exercising the gy edge runs.
+ */
+void syntheticStream(std::vector<int> *data) {
+    srand(42);
+    // Edges longer than the window, leaving it one stride at a time
+    addSegment(data, GY_HIGH, 3 * WINDOW_LENGTH / 2);
+    addSegment(data, GY_LOW, WINDOW_LENGTH + STRIDE / 2);
+    addSegment(data, GY_MID, WINDOW_LENGTH);
+    // Edges of equal lengths, around the minimum length of 4 reported by
+    // Featurizer, which keeps the earliest one. As the first one crosses the
+    // start of the window, the next one becomes the longest.
+    for (int length = 3; length <= 3 * STRIDE; length += length < 6 ? 1 : 7) {
+        for (int k = 0; k < 5; k++) {
+            addSegment(data, GY_HIGH, length);
+            addSegment(data, GY_MID, 1 + k);
+            addSegment(data, GY_LOW, length);
+            addSegment(data, GY_MID, 2);
+        }
+        addSegment(data, GY_MID, WINDOW_LENGTH / 2);
+    }
+    // Values exactly at the thresholds, which break an edge, and direct
+    // transitions between positive and negative edges
+    GyClass boundaries[] = { GY_AT_62, GY_AT_32, GY_AT_65 };
+    for (int b = 0; b < 3; b++) {
+        for (int k = 0; k < 10; k++) {
+            addSegment(data, GY_HIGH, 5 + k);
+            addSegment(data, boundaries[b], 1 + k % 3);
+            addSegment(data, GY_HIGH, 5 + k);
+            addSegment(data, GY_LOW, 5 + k);
+            addSegment(data, boundaries[b], 1 + k % 3);
+            addSegment(data, GY_LOW, 5 + k);
+            addSegment(data, GY_HIGH, 4 + k);
+        }
+    }
+    // Random segments, from single measurements to edges of several strides
+    GyClass classes[] = { GY_HIGH, GY_LOW, GY_MID, GY_AT_62, GY_AT_32, GY_AT_65 };
+    for (int k = 0; k < SYNTHETIC_SEGMENTS; k++) {
+        GyClass c = classes[rand() % 6];
+        int length = (c == GY_HIGH || c == GY_LOW || c == GY_MID) ?
+            1 + rand() % (rand() % 8 == 0 ? 6 * STRIDE : STRIDE) : 1;
+        addSegment(data, c, length);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    const char *dataFile = DATA_FILE;
+    bool synthetic = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-s") == 0)
+            synthetic = true;
+        else if (argv[i][0] == '-') {
+            std::cout<<"Usage: "<<argv[0]<<" [-s] [data file]"<<std::endl;
+            return 1;
+        } else
+            dataFile = argv[i];
+    }
+    std::vector<int> data;
+    int repeat = REPEAT;
+    if (synthetic) {
+        syntheticStream(&data);
+        dataFile = "the synthetic stream";
+        repeat = 1;
+    } else {
+        std::ifstream infile(dataFile);
+        int value;
+        while (infile >> value)
+            data.push_back(value);
+    }
+    int numSamples = data.size() / 6;
+    if (numSamples == 0) {
+        std::cout<<"No data in "<<dataFile<<std::endl;
+        return 1;
+    }
+
+    long count = 0;
+    int windows = 0, mismatches = 0;
+    double time = 0, timeIncremental = 0;
+    std::vector<Vector3D<float> > strideAcc, strideGyr;
+    for (int r = 0; r < repeat; r++) {
+        for (int s = 0; s < numSamples; s++) {
+            const int *v = &data[6 * s];
+            count++;
+            Vector3D<int16_t> acc(v[0], v[1], v[2]);
+            Vector3D<int16_t> gyr(v[3], v[4], v[5]);
+            minMaxNormalize(&acc, &minAcc, &maxAcc, &normAcc);
+            minMaxNormalize(&gyr, &minGyr, &maxGyr, &normGyr);
+            normAX.forceAdd(normAcc.x); normGX.forceAdd(normGyr.x);
+            normAY.forceAdd(normAcc.y); normGY.forceAdd(normGyr.y);
+            normAZ.forceAdd(normAcc.z); normGZ.forceAdd(normGyr.z);
+            // The incremental featurizer is fed once per stride, for the timing
+            strideAcc.push_back(normAcc);
+            strideGyr.push_back(normGyr);
+            if (count % STRIDE != 0)
+                continue;
+
+            auto start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < strideAcc.size(); i++)
+                incrementalFeaturizer.addSample(&strideAcc[i], &strideGyr[i]);
+            strideAcc.clear();
+            strideGyr.clear();
+            // Same windows as the simulation
+            if (count <= WINDOW_LENGTH)
+                continue;
+            // Featurizer writes one past the feature vector for a value of
+            // exactly 100 in the last bucket of gz
+            int featureVector[FEATURE_LENGTH + 1] = {0};
+            int featureVectorIncremental[FEATURE_LENGTH + 1] = {0};
+            incrementalFeaturizer.featurize(featureVectorIncremental);
+            auto mid = std::chrono::steady_clock::now();
+            featurizer.featurize(featureVector);
+            auto end = std::chrono::steady_clock::now();
+            timeIncremental += std::chrono::duration<double, std::micro>(mid - start).count();
+            time += std::chrono::duration<double, std::micro>(end - mid).count();
+
+            windows++;
+            if (memcmp(featureVector, featureVectorIncremental,
+                FEATURE_LENGTH * sizeof(int)) != 0) {
+                mismatches++;
+                std::cout<<"Window "<<windows<<": the feature vectors differ"<<std::endl;
+            }
+        }
+    }
+
+    if (windows == 0) {
+        std::cout<<"No window in "<<dataFile<<std::endl;
+        return 1;
+    }
+    time /= windows;
+    timeIncremental /= windows;
+    std::cout<<std::fixed<<std::setprecision(3);
+    std::cout<<"Windows: "<<windows<<std::endl;
+    std::cout<<"Feature vector mismatches: "<<mismatches<<std::endl;
+    std::cout<<"Featurizer: "<<time<<" us per stride"<<std::endl;
+    std::cout<<"IncrementalFeaturizer: "<<timeIncremental<<" us per stride ("<<time / timeIncremental<<"x)"<<std::endl;
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT license.
+ *
+ * Definition of the gesture recognition pipeline
+ */
+
+#include "pipeline.h"
+
+/* Used for min-max normalization.
+ * These values may have to be changed depending on MPU
+ * Values defined in config.h
+ */
+static const Vector3D<int16_t> minAcc(MIN_ACC, MIN_ACC, MIN_ACC);
+static const Vector3D<int16_t> maxAcc(MAX_ACC, MAX_ACC, MAX_ACC);
+static const Vector3D<int16_t> minGyr(MIN_GYR_X, MIN_GYR_Y, MIN_GYR_Z);
+static const Vector3D<int16_t> maxGyr(MAX_GYR_X, MAX_GYR_Y, MAX_GYR_Z);
+
+// Gestures are mapped to classes - Do not change ordering!
+static const char *GESTURE_TO_COMMUNICATE[10] = {"", "", "", "double_tap",
+                                                 "right_twist", "left_twist", "",
+                                                 "twirl", "", "double_swipe"};
+
+GesturePipeline::GesturePipeline() : featurizer(BUCKET_WIDTH), vote(10) {
+    this->countAfterReset = 0;
+    this->firstWindowFull = false;
+}
+
+/*
+ * Returns the error code of the ProtoNN predictor.
+ */
+int8_t GesturePipeline::getErrorCode() {
+    return this->predictor.getErrorCode();
+}
+
+/*
+ * Adds a measurement to the stream. Every STRIDE measurements once the
+ * first window is full, the window is featurized, the gesture predicted
+ * and the vote updated.
+ *
+ * @param result Receives the prediction on the window, if any.
+ * @returns 1 if a window was predicted, 0 otherwise.
+ */
+int GesturePipeline::addSample(int acc_x, int acc_y, int acc_z, int gyr_x,
+                               int gyr_y, int gyr_z, GestureResult *result) {
+    this->countAfterReset++;
+    // Converting values to vectors for consistency
+    Vector3D<int16_t> acc(acc_x, acc_y, acc_z);
+    Vector3D<int16_t> gyr(gyr_x, gyr_y, gyr_z);
+    minMaxNormalize(&acc, &minAcc, &maxAcc, &this->normAcc);
+    minMaxNormalize(&gyr, &minGyr, &maxGyr, &this->normGyr);
+    this->featurizer.addSample(&this->normAcc, &this->normGyr);
+    // Wait till first window is full
+    if (!this->firstWindowFull) {
+        if (this->countAfterReset % (STRIDE * NUM_BUCKETS) == 0)
+            this->firstWindowFull = true;
+        return 0;
+    }
+    // If not STRIDE steps then return
+    if ((this->countAfterReset % STRIDE) != 0)
+        return 0;
+    /* format of feature vector:[indexPosEdge, countPosEdge, countNegEdge,
+     * indexNegEdge, ax(20buckets), ay(20buckets), az(20buckets),
+     * gx(20buckets), gy(20buckets), gz(20buckets)]
+     */
+    int featureVector[FEATURE_LENGTH] = {0};
+    float featureVectorF[FEATURE_LENGTH] = {0};
+    this->featurizer.featurize(featureVector);
+    // Since predictor expects a float type.
+    // But feature computation with floats is expensive.
+    for (int i = 0; i < FEATURE_LENGTH; i++) {
+        featureVectorF[i] = featureVector[i];
+    }
+    result->label = this->predictor.predict(featureVectorF,
+                                            FEATURE_LENGTH,
+                                            this->scores);
+    result->score = this->scores[result->label];
+    // Voting to get rid of stray gestures
+    this->vote.forcePush(result->label);
+    result->vote = this->vote.result();
+    return 1;
+}
+
+/*
+ * Returns the name of the gesture of a vote result, or nullptr if it is
+ * not a gesture.
+ */
+const char* getGestureName(int vote) {
+    if ((vote == 3) || (vote == 4) || (vote == 5) ||
+        (vote == 7) || (vote == 9))
+        return GESTURE_TO_COMMUNICATE[vote];
+    return nullptr;
+}
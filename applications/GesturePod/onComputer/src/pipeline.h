@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT license.
+ *
+ * Gesture recognition pipeline of one stream of measurements
+ */
+
+#ifndef __PIPELINE__
+#define __PIPELINE__
+
+#include <cstdint>
+#include "config.h"
+#include "featurizer.h"
+#include "protoNN.h"
+#include "utils.h"
+
+/*
+ * Outcome of the prediction on a window.
+ */
+struct GestureResult {
+    int label;
+    int score;
+    int vote;
+};
+
+/*
+ * The normalization, featurization, prediction and voting state of
+ * one stream of IMU measurements. Streams share no state, so each
+ * one can be run on its own thread.
+ */
+class GesturePipeline {
+    IncrementalFeaturizer featurizer;
+    ProtoNNF predictor;
+    // Voting class constructor takes as input the (index of max no of labels + 1)
+    Vote vote;
+    int countAfterReset;
+    bool firstWindowFull;
+    Vector3D<float> normAcc, normGyr;
+    int scores[protoNNParam::numLabels];
+public:
+    GesturePipeline();
+    int8_t getErrorCode();
+    int addSample(int acc_x, int acc_y, int acc_z, int gyr_x,
+                  int gyr_y, int gyr_z, GestureResult *result);
+};
+
+const char* getGestureName(int vote);
+
+#endif // __PIPELINE__
@@ -284,4 +284,173 @@ float ProtoNNF::predict(float *x, unsigned length,
  */
 int8_t ProtoNNF::getErrorCode(){
 	return this->errorCode;
-}
\ No newline at end of file
+}
+
+/**
+ * Constructor quantizes the ProtoNN parameters of the data.h file
+ * and fills the exp tables.
+ *
+ * @see getErrorCode()
+ */
+ProtoNNQ::ProtoNNQ() {
+	this->featDim = protoNNParam::featDim;
+	this->ldDim = protoNNParam::ldDim;
+	this->numPrototypes = protoNNParam::numPrototypes;
+	this->numLabels = protoNNParam::numLabels;
+	this->errorCode = 0;
+	float gamma = protoNNParam::gamma;
+	unsigned d = this->featDim;
+	unsigned d_cap = this->ldDim;
+	unsigned m = this->numPrototypes;
+	unsigned L = this->numLabels;
+
+	quantize(protoNNParam::ldProjectionMatrix, d_cap * d, gamma, this->W, &(this->qW));
+	quantize(protoNNParam::prototypeLabelMatrix, m * L, 1.0, this->Z, &(this->qZ));
+	// The prototypes have the scale of the projected features, in 32 bits
+	for(unsigned i = 0; i < m * d_cap; i++){
+		double b = round(ldexp((double)gamma * protoNNParam::prototypeMatrix[i], this->qW));
+		if (b >= 2147483647.0 || b <= -2147483647.0)
+			this->errorCode |= 2;
+		else
+			this->B[i] = (int32_t)b;
+	}
+
+	for(unsigned i = 0; i < EXP_TABLE_HI_SIZE; i++)
+		this->expHi[i] = (int32_t)round(ldexp(exp(-ldexp((double)i, EXP_LO_BITS - 16)), 30));
+	for(unsigned i = 0; i < EXP_TABLE_LO_SIZE; i++)
+		this->expLo[i] = (int32_t)round(ldexp(exp(-ldexp((double)i, -16)), 30));
+}
+
+/**
+ * Quantizes `scalar * src` to 16 bit integers in Q(q), with the largest
+ * q up to 28 for which the values fit.
+ *
+ * @param src The float values.
+ * @param length The number of values.
+ * @param scalar The scalar the values are multiplied by.
+ * @param dst The destination of the integers.
+ * @param q The destination of q.
+ * Bit 0 of the error code is set, and q to 0, if the values are not finite.
+ */
+void ProtoNNQ::quantize(const float *src, unsigned length,
+	float scalar, int16_t *dst, int *q) {
+
+	double maxAbs = 0.0;
+	for(unsigned i = 0; i < length; i++){
+		double v = fabs((double)scalar * src[i]);
+		if (!(v < DBL_MAX)) {
+			this->errorCode |= 1;
+			*q = 0;
+			return;
+		}
+		if (v > maxAbs)
+			maxAbs = v;
+	}
+	int shift = 28;
+	while (shift > -16 && round(ldexp(maxAbs, shift)) > 32767.0)
+		shift--;
+	for(unsigned i = 0; i < length; i++)
+		dst[i] = (int16_t)round(ldexp((double)scalar * src[i], shift));
+	*q = shift;
+}
+
+/**
+ * Gaussian kernel between the projected features and a prototype,
+ * both in Q(qW) and already multiplied by gamma.
+ *
+ * @param x_cap Pointer to the projected features.
+ * @param prototype Pointer to the prototype.
+ * @returns exp(-||x_cap - prototype||^2) in Q30, 0 if the exponent
+ * is beyond the exp tables.
+ */
+int32_t ProtoNNQ::gaussian(const int32_t *x_cap, const int32_t *prototype) {
+	// Squares are in Q(2qW), the exponent t in Q16
+	int shr = 2 * this->qW - 16;
+	// A difference of 2^(qW + 3) alone is an exponent of 64, beyond the
+	// tables. Below Q(-3), any non-zero difference is
+	int64_t limit = this->qW >= -3 ? (int64_t)1 << (this->qW + 3) : 1;
+	int64_t t = 0;
+	for(unsigned i = 0; i < this->ldDim; i++){
+		int64_t diff = (int64_t)x_cap[i] - prototype[i];
+		if (diff >= limit || diff <= -limit)
+			return 0;
+		int64_t sq = diff * diff;
+		t += shr >= 0 ? (sq >> shr) : (sq << -shr);
+		if (t >= ((int64_t)1 << EXP_ARG_BITS))
+			return 0;
+	}
+	int64_t w = (int64_t)this->expHi[t >> EXP_LO_BITS] *
+		this->expLo[t & (EXP_TABLE_LO_SIZE - 1)];
+	return (int32_t)(w >> 30);
+}
+
+/**
+ * The method used to perform prediction with integer arithmetic.
+ * @param x The feature vector of the featurizer.
+ * @param length The length of the feature vector.
+ * @param scores If not nullptr, receives the scores of the labels,
+ * scaled by 100000 as in ProtoNNF::predict.
+ * @returns The label, or -1 if the length and expected feature
+ * vector length mismatch.
+ */
+int ProtoNNQ::predict(const int *x, unsigned length, int *scores) {
+	unsigned m = this->numPrototypes;
+	unsigned int d = this->featDim;
+	unsigned int d_cap = this->ldDim;
+	unsigned int L = this->numLabels;
+	if (length != d)
+		return -1;
+	int32_t x_cap[protoNNParam::ldDim];
+	int64_t y_cap[protoNNParam::numLabels];
+
+	// Project x onto the d_cap dimension, saturating to 32 bits
+	for(unsigned i = 0; i < d_cap; i++){
+		const int16_t *w = &(this->W[i * d]);
+		int64_t dotProd = 0;
+		for(unsigned j = 0; j < d; j++)
+			dotProd += (int32_t)w[j] * x[j];
+		if (dotProd > INT32_MAX)
+			dotProd = INT32_MAX;
+		else if (dotProd < -INT32_MAX)
+			dotProd = -INT32_MAX;
+		x_cap[i] = (int32_t)dotProd;
+	}
+
+	for(unsigned i = 0; i < L; i++)
+		y_cap[i] = 0;
+	for(unsigned k = 0; k < m; k++){
+		int32_t weight = gaussian(x_cap, &(this->B[k * d_cap]));
+		if (weight == 0)
+			continue;
+		const int16_t *z = &(this->Z[k * L]);
+		for(unsigned i = 0; i < L; i++)
+			y_cap[i] += (int64_t)weight * z[i];
+	}
+
+	// y_cap is in Q(30 + qZ)
+	int maxIndex = 0;
+	for(unsigned i = 0; i < L; i++){
+		if (y_cap[i] > y_cap[maxIndex])
+			maxIndex = i;
+		if (scores != nullptr)
+			scores[i] = (int)(((y_cap[i] >> 14) * 100000) >> (16 + this->qZ));
+	}
+	return maxIndex;
+}
+
+/**
+ * Returns the error code of the quantization of the parameters.
+ *
+ * * **Error codes:**
+ *
+ *        |    1    |    0    |
+ *        |    B    | W, B, Z |
+ *
+ * Bit 0 is set when a parameter is not finite, bit 1 when a
+ * prototype does not fit in 32 bits.
+ *
+ * @returns int8_t errorCode
+ */
+int8_t ProtoNNQ::getErrorCode(){
+	return this->errorCode;
+}
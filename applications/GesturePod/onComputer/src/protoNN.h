@@ -40,4 +40,48 @@ public:
 
 	int8_t getErrorCode();
 };
+
+/*
+ * Fixed-point parameters of ProtoNNQ. The exponent of the gaussian
+ * kernel is a Q16 number below 2^EXP_ARG_BITS / 2^16, split into
+ * its high bits and its low EXP_LO_BITS bits to index two tables.
+ */
+#define EXP_ARG_BITS 			21
+#define EXP_LO_BITS 			10
+#define EXP_TABLE_HI_SIZE 		(1 << (EXP_ARG_BITS - EXP_LO_BITS))
+#define EXP_TABLE_LO_SIZE 		(1 << EXP_LO_BITS)
+
+/**
+ * Fixed-point ProtoNN predictor, with the same ProtoNN parameters as
+ * ProtoNNF. It takes the integer feature vector of the featurizer.
+ *
+ * The gamma of the kernel is folded into the projection matrix W and the
+ * prototypes B, which are quantized to Q(qW) integers once, so that the
+ * exponent of the kernel is the plain sum of squares of the differences.
+ * exp() is replaced by the product of two precomputed Q30 tables, and
+ * W, B and Z are read as contiguous integer arrays.
+ */
+class ProtoNNQ {
+	int8_t errorCode;
+	unsigned featDim, ldDim, numPrototypes, numLabels;
+	// gamma * W, d_cap x d, and gamma * B, m x d_cap, in Q(qW)
+	int16_t W[protoNNParam::ldDim * protoNNParam::featDim];
+	int32_t B[protoNNParam::numPrototypes * protoNNParam::ldDim];
+	int qW;
+	// Z, m x L, in Q(qZ)
+	int16_t Z[protoNNParam::numPrototypes * protoNNParam::numLabels];
+	int qZ;
+	// exp(-t) = expHi[t >> EXP_LO_BITS] * expLo[t & (EXP_TABLE_LO_SIZE - 1)], for t in Q16
+	int32_t expHi[EXP_TABLE_HI_SIZE];
+	int32_t expLo[EXP_TABLE_LO_SIZE];
+private:
+	void quantize(const float *src, unsigned length, float scalar, int16_t *dst, int *q);
+	int32_t gaussian(const int32_t *x_cap, const int32_t *prototype);
+
+public:
+	ProtoNNQ();
+	int predict(const int *x, unsigned length, int *scores);
+
+	int8_t getErrorCode();
+};
 #endif // __PROTONN__
\ No newline at end of file
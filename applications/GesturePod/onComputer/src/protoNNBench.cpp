@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT license.
+ *
+ * Validation of the fixed-point ProtoNN predictor: replays the sensor data
+ * through the featurizer, as the simulation does, and compares the labels
+ * and scores of ProtoNNQ with those of ProtoNNF on every window. Reports the
+ * prediction time per window of both predictors.
+ */
+#include <iostream>
+#include <iomanip>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <chrono>
+#include "config.h"
+#include "featurizer.h"
+#include "protoNN.h"
+#include "utils.h"
+
+#define DATA_FILE "./data/taps.txt"
+// Each window is predicted REPEAT times for the timing
+#define REPEAT 200
+
+FIFOCircularQ<float, 400> normAX, normAY, normAZ;
+FIFOCircularQ<float, 400> normGX, normGY, normGZ;
+Featurizer featurizer(BUCKET_WIDTH, &normAX, &normAY, &normAZ,
+                      &normGX, &normGY, &normGZ);
+ProtoNNF predictorF;
+ProtoNNQ predictorQ;
+
+Vector3D<float> normAcc, normGyr;
+Vector3D<int16_t> minAcc(MIN_ACC, MIN_ACC, MIN_ACC);
+Vector3D<int16_t> maxAcc(MAX_ACC, MAX_ACC, MAX_ACC);
+Vector3D<int16_t> minGyr(MIN_GYR_X, MIN_GYR_Y, MIN_GYR_Z);
+Vector3D<int16_t> maxGyr(MAX_GYR_X, MAX_GYR_Y, MAX_GYR_Z);
+
+const int L = protoNNParam::numLabels;
+
+int main(int argc, char *argv[]) {
+    const char *dataFile = argc > 1 ? argv[1] : DATA_FILE;
+    std::ifstream infile(dataFile);
+    if (!infile) {
+        std::cout<<"Cannot open "<<dataFile<<std::endl;
+        return 1;
+    }
+    if (predictorF.getErrorCode() || predictorQ.getErrorCode()) {
+        std::cout<<"ProtoNN initialization failed with codes ";
+        std::cout<<(int)predictorF.getErrorCode()<<", ";
+        std::cout<<(int)predictorQ.getErrorCode()<<std::endl;
+        return 1;
+    }
+
+    int acc_x, acc_y, acc_z, gyr_x, gyr_y, gyr_z;
+    int count = 0, windows = 0, mismatches = 0, maxScoreDiff = 0;
+    double timeF = 0, timeQ = 0;
+    volatile int sink = 0;
+    while (infile >> acc_x >> acc_y >> acc_z >> gyr_x >> gyr_y >> gyr_z) {
+        count++;
+        Vector3D<int16_t> acc(acc_x, acc_y, acc_z);
+        Vector3D<int16_t> gyr(gyr_x, gyr_y, gyr_z);
+        minMaxNormalize(&acc, &minAcc, &maxAcc, &normAcc);
+        minMaxNormalize(&gyr, &minGyr, &maxGyr, &normGyr);
+        normAX.forceAdd(normAcc.x); normGX.forceAdd(normGyr.x);
+        normAY.forceAdd(normAcc.y); normGY.forceAdd(normGyr.y);
+        normAZ.forceAdd(normAcc.z); normGZ.forceAdd(normGyr.z);
+        // Same windows as the simulation
+        if (count <= STRIDE * NUM_BUCKETS || count % STRIDE != 0)
+            continue;
+
+        int featureVector[FEATURE_LENGTH] = {0};
+        float featureVectorF[FEATURE_LENGTH] = {0};
+        featurizer.featurize(featureVector);
+        for (int i = 0; i < FEATURE_LENGTH; i++)
+            featureVectorF[i] = featureVector[i];
+
+        int scoresF[L], scoresQ[L];
+        int resultF = 0, resultQ = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < REPEAT; r++)
+            sink += resultF = predictorF.predict(featureVectorF, FEATURE_LENGTH, scoresF);
+        auto mid = std::chrono::steady_clock::now();
+        for (int r = 0; r < REPEAT; r++)
+            sink += resultQ = predictorQ.predict(featureVector, FEATURE_LENGTH, scoresQ);
+        auto end = std::chrono::steady_clock::now();
+        timeF += std::chrono::duration<double, std::micro>(mid - start).count();
+        timeQ += std::chrono::duration<double, std::micro>(end - mid).count();
+
+        windows++;
+        if (resultF != resultQ) {
+            mismatches++;
+            std::cout<<"Window "<<windows<<": float label "<<resultF;
+            std::cout<<", fixed-point label "<<resultQ<<std::endl;
+        }
+        for (int i = 0; i < L; i++)
+            maxScoreDiff = std::max(maxScoreDiff, std::abs(scoresF[i] - scoresQ[i]));
+    }
+
+    if (windows == 0) {
+        std::cout<<"No window in "<<dataFile<<std::endl;
+        return 1;
+    }
+    timeF /= (double)windows * REPEAT;
+    timeQ /= (double)windows * REPEAT;
+    std::cout<<std::fixed<<std::setprecision(3);
+    std::cout<<"Windows: "<<windows<<std::endl;
+    std::cout<<"Label mismatches: "<<mismatches<<std::endl;
+    std::cout<<"Max score difference (x100000): "<<maxScoreDiff<<std::endl;
+    std::cout<<"ProtoNNF: "<<timeF<<" us per window"<<std::endl;
+    std::cout<<"ProtoNNQ: "<<timeQ<<" us per window ("<<timeF / timeQ<<"x)"<<std::endl;
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT license.
+ *
+ * Replay of many streams of measurements through independent gesture
+ * recognition pipelines, on several threads, with the output suppressed.
+ * Reports the throughput and the latency percentiles of the windows.
+ *
+ * Usage: gesturepodreplay [-n streams] [-t threads] [-r repeat] [data files]
+ * Stream i replays data file i modulo the number of files, repeat times.
+ */
+#include <iostream>
+#include <iomanip>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include "config.h"
+#include "pipeline.h"
+
+#define DATA_FILE "./data/taps.txt"
+
+struct Trace {
+    std::vector<int> values;
+    int numSamples;
+};
+
+struct WorkerStats {
+    long samples;
+    long windows;
+    long gestures;
+    // Time of the measurements completing a window, in microseconds
+    std::vector<float> latencies;
+};
+
+/*
+ * Runs the streams first, first + step, ... to completion.
+ * The counters are kept local and stored once at the end, as the stats of
+ * neighbouring threads share cache lines.
+ */
+void replayStreams(std::vector<GesturePipeline> *pipelines,
+                   const std::vector<Trace> *traces, int first, int step,
+                   int repeat, WorkerStats *stats) {
+    long samples = 0, windows = 0, gestures = 0;
+    std::vector<float> latencies;
+    for (size_t s = first; s < pipelines->size(); s += step) {
+        GesturePipeline &pipeline = (*pipelines)[s];
+        const Trace &trace = (*traces)[s % traces->size()];
+        long count = 0;
+        for (int r = 0; r < repeat; r++) {
+            for (int i = 0; i < trace.numSamples; i++) {
+                const int *v = &trace.values[6 * i];
+                GestureResult result;
+                count++;
+                // Windows are only predicted on the last measurement of a stride
+                if (count % STRIDE != 0) {
+                    pipeline.addSample(v[0], v[1], v[2], v[3], v[4], v[5], &result);
+                    continue;
+                }
+                auto start = std::chrono::steady_clock::now();
+                int predicted = pipeline.addSample(v[0], v[1], v[2], v[3], v[4], v[5], &result);
+                auto end = std::chrono::steady_clock::now();
+                if (!predicted)
+                    continue;
+                latencies.push_back(
+                    std::chrono::duration<float, std::micro>(end - start).count());
+                windows++;
+                if (getGestureName(result.vote) != nullptr)
+                    gestures++;
+            }
+        }
+        samples += count;
+    }
+    stats->samples = samples;
+    stats->windows = windows;
+    stats->gestures = gestures;
+    stats->latencies.swap(latencies);
+}
+
+void usage(const char *name) {
+    std::cout<<"Usage: "<<name<<" [-n streams] [-t threads] [-r repeat] [data files]"<<std::endl;
+}
+
+float percentile(std::vector<float> &values, double p) {
+    size_t k = (size_t)(p / 100.0 * (values.size() - 1) + 0.5);
+    std::nth_element(values.begin(), values.begin() + k, values.end());
+    return values[k];
+}
+
+int main(int argc, char *argv[]) {
+    int numStreams = 1000;
+    int numThreads = std::max(1u, std::thread::hardware_concurrency());
+    int repeat = 1;
+    std::vector<const char *> dataFiles;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+            numStreams = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+            numThreads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+            repeat = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+            usage(argv[0]);
+            return 0;
+        } else if (argv[i][0] == '-') {
+            // An unknown flag or a flag without its value
+            usage(argv[0]);
+            return 1;
+        } else
+            dataFiles.push_back(argv[i]);
+    }
+    if (dataFiles.empty())
+        dataFiles.push_back(DATA_FILE);
+    if (numStreams < 1 || numThreads < 1 || repeat < 1) {
+        usage(argv[0]);
+        return 1;
+    }
+    numThreads = std::min(numThreads, numStreams);
+
+    std::vector<Trace> traces(dataFiles.size());
+    for (size_t f = 0; f < dataFiles.size(); f++) {
+        std::ifstream infile(dataFiles[f]);
+        int value;
+        while (infile >> value)
+            traces[f].values.push_back(value);
+        traces[f].numSamples = traces[f].values.size() / 6;
+        if (traces[f].numSamples == 0) {
+            std::cout<<"No data in "<<dataFiles[f]<<std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<GesturePipeline> pipelines(numStreams);
+    if (pipelines[0].getErrorCode()) {
+        std::cout<<"ProtoNNF initialization failed with code ";
+        std::cout<<(int)pipelines[0].getErrorCode()<<std::endl;
+        return 1;
+    }
+
+    std::vector<WorkerStats> stats(numThreads);
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < numThreads; t++)
+        threads.push_back(std::thread(replayStreams, &pipelines, &traces,
+                                      t, numThreads, repeat, &stats[t]));
+    for (auto &thread : threads)
+        thread.join();
+    double seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+
+    long samples = 0, windows = 0, gestures = 0;
+    std::vector<float> latencies;
+    for (auto &s : stats) {
+        samples += s.samples;
+        windows += s.windows;
+        gestures += s.gestures;
+        latencies.insert(latencies.end(), s.latencies.begin(), s.latencies.end());
+    }
+
+    std::cout<<std::fixed<<std::setprecision(3);
+    std::cout<<"Streams: "<<numStreams<<", threads: "<<numThreads<<std::endl;
+    std::cout<<"Samples: "<<samples<<", windows: "<<windows;
+    std::cout<<", gestures detected: "<<gestures<<std::endl;
+    std::cout<<"Time: "<<seconds<<" s"<<std::endl;
+    std::cout<<std::setprecision(0);
+    std::cout<<"Throughput: "<<samples / seconds<<" samples/s, ";
+    std::cout<<windows / seconds<<" windows/s"<<std::endl;
+    if (!latencies.empty()) {
+        std::cout<<std::setprecision(3);
+        std::cout<<"Window latency (us): p50 "<<percentile(latencies, 50);
+        std::cout<<", p90 "<<percentile(latencies, 90);
+        std::cout<<", p99 "<<percentile(latencies, 99);
+        std::cout<<", p99.9 "<<percentile(latencies, 99.9);
+        std::cout<<", max "<<*std::max_element(latencies.begin(), latencies.end())<<std::endl;
+    }
+    return 0;
+}
@@ -4,3 +4,6 @@
 LDFLAGS= -lm -ldl
 CC=gcc
 CFLAGS= -g -fPIC -O3 -Wall
+# Optional compile flags : -DLOOP_UNROLL, -DSHIFT
+# -DSIMD enables the SSE4.1/AVX2/NEON kernels of the quantized operators (selected at runtime, bit-exact with the scalar code)
+# -DMULTITHREADED enables the num_threads parameter of conv1d_parallel, conv1d_lr_parallel, the bricked RNN and the threaded face detection pipelines (add -pthread as well)
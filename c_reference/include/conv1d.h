@@ -26,6 +26,10 @@
    We need at least 2 rows for a good a MatMul performace. In the worst case the starting time step would be (stride - 1). Hence we choose 2 * num_steps_one_row + stride as the threshold
    For the short input cases, the code will skip the MatMul computation and use MatVec instead (but the MatMul-variable computation overhead would remain)
    For such cases, the MatVec code (conv1d and conv1d_lr) would work more efficiently due to the lower RAM usage and lack of any major overheads
+-> With num_threads > 1, the parallel layers split the output time steps into contiguous ranges, one per thread
+   Each range computes all its fully-inside time steps with one MatMul (the rows of the input overlap in memory when stride < kernel_size) and its edge time steps with the MatVec
+   The result does not depend on the number of threads. It can differ in the last bits from the single-threaded result if block_size < kernel_size * in_channels,
+   since a few time steps close to the end are computed by the MatMul instead of the MatVec
 -> There is no support for depthwise for conv1d_parallel
    The regular convolution acts on all the channels while the depthwise acts only on one channel at a time
    This results in a non-contiguos memory access. MatMul would need to process multiple such time-steps, while the MatVec would only need to process one
@@ -76,11 +80,14 @@ int conv1d(float* output_signal, unsigned out_time, unsigned out_channels,
  * @var   W           pointer to the flattened conv weights, original shape for regular = [out_channels, kernel_size, in_channels], shape for depthwise = [in_channels, kernel_size, 1]
  * @var   B           pointer to the bias vector, original shape = [out_channels]
  * @var   block_size  block/tile size for the cache. Used for tiled MatMul
+ * @var   num_threads number of threads used by conv1d_parallel. The output time steps are split into num_threads contiguous ranges
+ *                    0 or 1 runs the single-threaded code. Threads are only created if compiled with MULTITHREADED, else the ranges run one after the other
  */
 typedef struct ConvLayers_Parallel_Params {
   const float* const W;
   const float* const B;
   unsigned block_size;
+  unsigned num_threads;
 } ConvLayers_Parallel_Params;
 
 /**
@@ -108,6 +115,52 @@ int conv1d_parallel(float* output_signal, unsigned out_time, unsigned out_channe
   unsigned padding, unsigned kernel_size,
   const void* params, unsigned stride, unsigned activation);
 
+// Number of output time steps unrolled into one im2col buffer. Bounds the scratch memory to CONV1D_IM2COL_STEPS * kernel_size * in_channels floats
+#define CONV1D_IM2COL_STEPS 64
+
+/**
+ * @brief Model definition for the 1D Convolution Layer using im2col and a packed GEMM. Currently only for dilation = 1. No depthwise.
+ * @brief The zero-padded input patches for CONV1D_IM2COL_STEPS output time steps are laid out contiguously (im2col),
+ * @brief and the whole block is multiplied with the packed weights using a register-blocked MatMul (packed_tiledMatMul)
+ * @brief Unlike conv1d_parallel, the edge time steps do not fall back to a MatVec. Recommended for long inputs with many channels
+ * @param[out]   output_signal    pointer to the output signal, size = out_time * out_channels
+ * @param[in]    out_time         number of time steps in the output
+ * @param[in]    out_channels     number of output channels for the output of the conv layer
+ * @param[in]    input_signal     pointer to the input signal. size = in_time * in_channels
+ * @param[in]    in_time          number of time steps in the input
+ * @param[in]    in_channels      number of input channels
+ * @param[in]    padding          padding applied to the input before the conv is performed.
+ *                                Note: padding is applied to both the starting and ending of the input, along the time axis
+ *                                E.g : padding = 3, the input is padded with zeros(for 3 time steps), both before the input_signal(time step 0) and after the input_signal(time step in_time-1)
+ * @param[in]    kernel_size      kernel size of the conv filter
+ * @param[in]    params           weights, bias and other essential parameters used to describe the layer. Uses ConvLayers_Parallel_Params
+ *                                block_size is used for blocking the kernel_size * in_channels axis of the MatMul. Pass 0 for no blocking
+ *                                The output is identical to conv1d if block_size = 0 or block_size >= kernel_size * in_channels
+ *                                Else the partial sums of the blocks are added separately, and the output can differ from conv1d in the last bits
+ * @param[in]    stride           stride length for the layer. input_time_iterator += stride for output_time_iterator +=1
+ * @param[in]    activation       an integer to choose the type of activation function. More can be added as per the necessity
+ *                                0: none
+ *                                1: sigmoid
+ *                                2: tanh
+ *                                3: relu
+ */
+int conv1d_im2col(float* output_signal, unsigned out_time, unsigned out_channels,
+  const float* input_signal, unsigned in_time, unsigned in_channels,
+  unsigned padding, unsigned kernel_size,
+  const void* params, unsigned stride, unsigned activation);
+
+/**
+ * @brief Model definition for the 1D Convolution Layer with the implementation selected by the shape of the layer. No depthwise.
+ * @brief Uses conv1d_im2col when there are enough output time steps and output channels to fill the MatMul register blocks.
+ * @brief Else uses the MatVec based conv1d, which has no packing overhead and a lower RAM usage
+ * @param[in]    params           weights, bias and other essential parameters used to describe the layer. Uses ConvLayers_Parallel_Params
+ * @note         All the other parameters are identical to conv1d_im2col
+ */
+int conv1d_auto(float* output_signal, unsigned out_time, unsigned out_channels,
+  const float* input_signal, unsigned in_time, unsigned in_channels,
+  unsigned padding, unsigned kernel_size,
+  const void* params, unsigned stride, unsigned activation);
+
 /**
  * @brief Model parameters for the 1D Low Rank Convolution Layer.
  * @var    W1      pointer to the flattened 1st low-rank component of the weights, original shape = [out_channels, rank]. For depthwise out_channels = in_channels
@@ -156,6 +209,8 @@ int conv1d_lr(float* output_signal, unsigned out_time, unsigned out_channels,
  * @var    rank                rank of the weight tensor. A low-rank decomposition typically used to reduce computation and storage
  * @var    block_size_to_lr    block/tile size for the cache. Used for tiled MatMul. Used for the input -> low-rank computation
  * @var    block_size_from_lr  block/tile size for the cache. Used for tiled MatMul. Used for the low-rank -> output computation
+ * @var    num_threads         number of threads used by conv1d_lr_parallel. The output time steps are split into num_threads contiguous ranges
+ *                             0 or 1 runs the single-threaded code. Threads are only created if compiled with MULTITHREADED, else the ranges run one after the other
  */
 typedef struct ConvLayers_LR_Parallel_Params {
   const float* const W1;
@@ -164,6 +219,7 @@ typedef struct ConvLayers_LR_Parallel_Params {
   unsigned rank;
   unsigned block_size_to_lr;
   unsigned block_size_from_lr;
+  unsigned num_threads;
 } ConvLayers_LR_Parallel_Params;
 
 /**
@@ -192,6 +248,99 @@ int conv1d_lr_parallel(float* output_signal, unsigned out_time, unsigned out_cha
   unsigned padding, unsigned kernel_size,
   const void* params, unsigned stride, unsigned activation);
 
+/**
+ * @brief Model parameters for the fused 1D Convolution Layer (batchnorm folded into the conv)
+ * @var   W           pointer to the folded weights. For regular conv, shape = [out_channels, kernel_size, in_channels]. For depthwise, shape = [in_channels, kernel_size, 1]
+ *                    For low-rank conv, the folded 2nd low-rank component W2, shape = [rank, kernel_size, in_channels]
+ * @var   W1          pointer to the 1st low-rank component, shape = [out_channels, rank]. Pass NULL/0 for the full-rank conv
+ * @var   B           pointer to the folded bias vector, shape = [out_channels]
+ * @var   tap_bias    pointer to the bias contribution of every filter tap, shape = [out_channels, kernel_size]. Pass NULL/0 if no batchnorm was folded
+ *                    The batchnorm offset is folded into B assuming all the taps are inside the input. For the taps in the zero padding, this contribution is removed
+ * @var   rank        rank of the low-rank conv. Ignored for the full-rank conv
+ * @var   depthwise   flag for deciding between regular(=0) and depthwise(=1) conv. No low-rank for depthwise
+ */
+typedef struct ConvLayers_Fused_Params {
+  const float* W;
+  const float* W1;
+  const float* B;
+  const float* tap_bias;
+  unsigned rank;
+  unsigned depthwise;
+} ConvLayers_Fused_Params;
+
+/**
+ * @brief Fold an inference-time batchnorm applied to the input of a conv layer (batchnorm1d -> conv1d) into the weights and the bias. Meant to be run once, at load time
+ * @brief conv(W, gamma * x + beta) = conv(W * gamma, x) + (B + W * beta). The last term depends on the number of taps inside the input, hence it is also stored per tap
+ * @param[out]   W_folded       pointer to the folded weights, same shape as W. Can be the same as W for in-place folding
+ * @param[out]   B_folded       pointer to the folded bias, size = out_channels
+ * @param[out]   tap_bias       pointer to the bias contribution of every tap, size = out_channels * kernel_size
+ * @param[in]    W              pointer to the conv weights. shape for regular = [out_channels, kernel_size, in_channels], shape for depthwise = [in_channels, kernel_size, 1]
+ * @param[in]    B              pointer to the conv bias, size = out_channels
+ * @param[in]    out_channels   number of output channels. Ignored for depthwise (= in_channels)
+ * @param[in]    in_channels    number of input channels
+ * @param[in]    kernel_size    kernel size of the conv filter
+ * @param[in]    depthwise      flag for deciding between regular(=0) and depthwise(=1) conv
+ * @param[in]    mean           pointer to the mean for the batch normalization, size = in_channels. Pass NULL/0 for affine_config = 2
+ * @param[in]    var            pointer to the variance for the batch normalization, size = in_channels. Pass NULL/0 for affine_config = 2
+ * @param[in]    affine_config  same as batchnorm1d
+ * @param[in]    gamma          pointer to the scaling factors for the post-norm affine operation, size = in_channels. Pass NULL/0 for affine_config = 0
+ * @param[in]    beta           pointer to the offsets for the post-norm affine operation, size = in_channels. Pass NULL/0 for affine_config = 0
+ * @param[in]    eps            a very small +ve value to avoid division by 0. For the default value, assign = 0.00001
+ */
+int conv1d_fold_batchnorm(float* W_folded, float* B_folded, float* tap_bias,
+  const float* W, const float* B, unsigned out_channels, unsigned in_channels,
+  unsigned kernel_size, unsigned depthwise,
+  const float* const mean, const float* const var,
+  unsigned affine_config, const float* const gamma, const float* const beta, float eps);
+
+/**
+ * @brief Fold an inference-time batchnorm applied to the input of a low-rank conv layer (batchnorm1d -> conv1d_lr) into W2 and the bias. Meant to be run once, at load time
+ * @param[out]   W2_folded      pointer to the folded 2nd low-rank component, same shape as W2. Can be the same as W2 for in-place folding
+ * @param[out]   B_folded       pointer to the folded bias, size = out_channels
+ * @param[out]   tap_bias       pointer to the bias contribution of every tap, size = out_channels * kernel_size
+ * @param[in]    W1             pointer to the 1st low-rank component, shape = [out_channels, rank]
+ * @param[in]    W2             pointer to the 2nd low-rank component, shape = [rank, kernel_size, in_channels]
+ * @param[in]    B              pointer to the conv bias, size = out_channels
+ * @param[in]    rank           rank of the weight tensor
+ * @note         All the other parameters are identical to conv1d_fold_batchnorm
+ */
+int conv1d_lr_fold_batchnorm(float* W2_folded, float* B_folded, float* tap_bias,
+  const float* W1, const float* W2, const float* B, unsigned rank,
+  unsigned out_channels, unsigned in_channels, unsigned kernel_size,
+  const float* const mean, const float* const var,
+  unsigned affine_config, const float* const gamma, const float* const beta, float eps);
+
+/**
+ * @brief Model definition for the fused 1D Convolution Layer : (folded batchnorm) -> conv1d/conv1d_lr -> activation -> avgpool1d (optional) -> activation
+ * @brief The activation and the avgpool are applied in the epilogue of every conv time step. The conv output is kept in a ring buffer of pool_kernel_size time steps,
+ * @brief hence no intermediate tensor is written to memory. Currently only for dilation = 1
+ * @param[out]   output_signal      pointer to the output signal, size = out_time * out_channels. out_time is the number of time steps after the pool (if any)
+ * @param[in]    out_time           number of time steps in the output
+ * @param[in]    out_channels       number of output channels. NOTE: out_channels = in_channels for depthwise. This is set manually in the function
+ * @param[in]    input_signal       pointer to the input signal. size = in_time * in_channels
+ * @param[in]    in_time            number of time steps in the input
+ * @param[in]    in_channels        number of input channels
+ * @param[in]    padding            padding applied to the input before the conv is performed. Same as conv1d
+ * @param[in]    kernel_size        kernel size of the conv filter
+ * @param[in]    params             weights, bias and other essential parameters used to describe the layer. Uses ConvLayers_Fused_Params
+ * @param[in]    stride             stride length for the conv
+ * @param[in]    activation         activation applied to the conv output. Same as conv1d
+ *                                  0: none
+ *                                  1: sigmoid
+ *                                  2: tanh
+ *                                  3: relu
+ * @param[in]    pool_padding       padding for the avgpool. Same as avgpool1d
+ * @param[in]    pool_kernel_size   kernel size of the avgpool. Pass 0 for no pooling (pool_padding, pool_stride and pool_activation are then ignored)
+ * @param[in]    pool_stride        stride length for the avgpool
+ * @param[in]    pool_activation    activation applied to the avgpool output. Same as avgpool1d
+ */
+int conv1d_fused(float* output_signal, unsigned out_time, unsigned out_channels,
+  const float* input_signal, unsigned in_time, unsigned in_channels,
+  unsigned padding, unsigned kernel_size,
+  const void* params, unsigned stride, unsigned activation,
+  unsigned pool_padding, unsigned pool_kernel_size, unsigned pool_stride,
+  unsigned pool_activation);
+
 // Auxiliary Layers
 /**
  * @brief Model definition for the 1D Average Pooling Layer. Currently only for dilation = 1
@@ -125,4 +125,26 @@ int fastgrnn(float* const hiddenState, unsigned hiddenDims,
   const float* const input, unsigned inputDims, unsigned steps,
   const void* params, void* buffers, int backward, int normalize);
 
+/**
+ * @brief Single step update of a batch of independent FastGRNN cells sharing the same parameters
+ * @brief The output is identical to one call of fastgrnn() with steps = 1 per cell, but every row of W and U is applied to
+ * @brief the whole batch before moving to the next one (a small matrix-matrix product instead of batch matrix-vector products)
+ * @param[in,out]   hiddenStates pointer to the hidden states of the cells, stored one after the other, size batch * hiddenDims
+ * @param[in]       hiddenDims   dimension of hidden state of the FastGRNN cell
+ * @param[in]       input        pointer to the input vector of the first cell
+ * @param[in]       inputDims    dimension of input vector of each cell
+ * @param[in]       inputStride  distance between the input vectors of two consecutive cells. Pass inputDims for contiguous inputs
+ * @param[in]       batch        number of cells
+ * @param[in]       params       pointer to model parameter
+ * @param[in]       buffers      pointer to buffer spaces. preComp must be of size batch * hiddenDims.
+ *                               normFeatures must be of size batch * inputDims, and is only required when normalize is set
+ * @param[in]       normalize    apply mean-var normalization, 0 for no, 1 for yes
+ * @return     The function returns <code>0</code> on success
+ *             <code>ERR_PRECOMP_NOT_INIT</code> if preComp not allocated
+ *             <code>ERR_NORMFEAT_NOT_INIT</code> if normFeatures not allocated and normalize is set
+*/
+int fastgrnn_batch(float* const hiddenStates, unsigned hiddenDims,
+  const float* const input, unsigned inputDims, unsigned inputStride,
+  unsigned batch, const void* params, void* buffers, int normalize);
+
 #endif
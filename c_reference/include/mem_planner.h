@@ -0,0 +1,50 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#ifndef __MEM_PLANNER_H__
+#define __MEM_PLANNER_H__
+
+#define ERR_MEM_PLAN_INVALID_TENSOR -1
+#define ERR_MEM_PLAN_NO_MEMORY -2
+
+/**
+ * @brief Description of one intermediate tensor for the static memory planner
+ * @var   size        size of the tensor in bytes
+ * @var   first_use   index of the layer which produces the tensor
+ * @var   last_use    index of the last layer which reads the tensor. Has to be >= first_use
+ * @var   offset      (output) byte offset of the tensor inside the shared memory buffer
+ */
+typedef struct MemPlan_Tensor {
+  unsigned size;
+  unsigned first_use;
+  unsigned last_use;
+  unsigned offset;
+} MemPlan_Tensor;
+
+/**
+ * @brief Liveness-based static memory planner. Assigns every tensor an offset in a single shared buffer,
+ * @brief such that two tensors share memory only if their lifetimes [first_use, last_use] do not overlap
+ * @param[in,out] tensors       pointer to the tensor descriptions. The offset field is filled in by the planner
+ * @param[in]     num_tensors   number of tensors to be planned
+ * @param[in]     alignment     byte alignment of every offset. Pass 0 or 1 for no alignment
+ * @param[out]    peak          size of the shared buffer (in bytes) required by the plan
+ * @return        The function returns 0 on success, ERR_MEM_PLAN_INVALID_TENSOR for a tensor with last_use < first_use
+ *                and ERR_MEM_PLAN_NO_MEMORY if the scratch space for the planner could not be allocated
+ * @example       Tensors are placed in decreasing order of size. Each tensor is put in the smallest gap left between
+ *                the already placed tensors with overlapping lifetimes (best-fit), or at the end of the buffer if no gap fits.
+ *                For a sequential pipeline A -> B -> C, the tensors A and C are mapped to the same offset
+ */
+int plan_static_memory(MemPlan_Tensor* tensors, unsigned num_tensors,
+  unsigned alignment, unsigned* peak);
+
+/**
+ * @brief Total memory required when every tensor is given its own buffer (no reuse). Used as a reference for the plan
+ * @param[in]     tensors       pointer to the tensor descriptions
+ * @param[in]     num_tensors   number of tensors
+ * @param[in]     alignment     byte alignment of every buffer. Pass 0 or 1 for no alignment
+ * @return        Sum of the (aligned) tensor sizes in bytes
+ */
+unsigned naive_memory_size(const MemPlan_Tensor* tensors, unsigned num_tensors,
+  unsigned alignment);
+
+#endif
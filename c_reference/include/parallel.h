@@ -0,0 +1,21 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#ifndef __PARALLEL_H__
+#define __PARALLEL_H__
+
+// Shared by the float and the quantized operators. Threads are only created if compiled with -DMULTITHREADED (link with -pthread)
+
+/*
+  Run num_tasks independent tasks: task(task_args + i * arg_size) for i = 0 ... num_tasks - 1
+  If compiled with MULTITHREADED, each task runs on its own thread (the calling thread runs the first one) and the call returns after all tasks finish
+  Else the tasks run one after the other on the calling thread. Used for splitting a layer into independent ranges (time steps, bricks, patches, rows)
+  task           function executing one task
+  task_args      array of num_tasks argument structs, one per task
+  arg_size       size of one argument struct in bytes
+  num_tasks      number of tasks/threads
+*/
+void parallel_for(void (*task)(void*), void* task_args, unsigned arg_size,
+  unsigned num_tasks);
+
+#endif
@@ -0,0 +1,141 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#ifndef __QUANTIZED_FACE_DETECTION_POST_H__
+#define __QUANTIZED_FACE_DETECTION_POST_H__
+
+#include "quantized_datatypes.h"
+
+/* Post-processing of the raw output of the face detection models (decode, top-k and NMS)
+   This is the fixed point counterpart of layers/functions/detection.py in examples/pytorch/vision/Face_Detection
+
+   The output tensor of a model is laid out as [conf : num_priors x 2 (background, face)] followed by [loc : num_priors x 4 (x, y, w, h)],
+   with the priors ordered head by head and row-major inside a head. A prior (i, j) of a head is the square box of side anchor
+   centered at ((j + 0.5) * step, (i + 0.5) * step) pixels
+
+   The stages are:
+   -> Pre-filter : the priors whose face - background logit is below the logit of conf_thresh are rejected with one comparison each
+   -> Score : the face probability (Q15) of the remaining priors is computed with a fixed point sigmoid
+   -> Top-k : the candidates are sorted by score with a bucket sort (256 buckets of the high score bits, each sorted by
+      insertion or by counting on the low bits, ties by prior index),
+      which stops once the first top_k candidates are in order
+   -> Decode and NMS : the candidates are decoded in the order of their scores (with a fixed point exp for the width and the height)
+      and suppressed by the kept boxes with an integer IoU test. This stops after top_k candidates or max_detections kept boxes
+
+   The work after the pre-filter is bounded by top_k and max_detections, irrespective of the number of priors above the threshold
+*/
+
+#define ERR_FACE_DETECTION_POST_INVALID_PARAMS -1
+#define ERR_FACE_DETECTION_POST_NOT_INIT -2
+
+// Number of fractional bits of the box coordinates
+#define Q_FACE_DETECTION_BOX_SCALE 4
+// Variances of the prior box encoding (0.1 and 0.2) in Q15
+#define Q_FACE_DETECTION_VARIANCE_CENTER 3277
+#define Q_FACE_DETECTION_VARIANCE_SIZE 6554
+// Defaults of detection.py in Q15 (CONF_THRESH = 0.05, NMS_THRESH = 0.3)
+#define Q_FACE_DETECTION_CONF_THRESH 1638
+#define Q_FACE_DETECTION_NMS_THRESH 9830
+
+/**
+ * @brief Prior boxes of one detection head
+ * @var   rows        number of rows of the feature map of the head
+ * @var   cols        number of columns of the feature map of the head
+ * @var   step        stride of the feature map in pixels of the input image
+ * @var   anchor      side of the square prior boxes in pixels
+ */
+typedef struct Q_Face_Detection_Head {
+  ITER_T rows;
+  ITER_T cols;
+  ITER_T step;
+  ITER_T anchor;
+} Q_Face_Detection_Head;
+
+// The four heads of the 18000 output (3000 prior) face detection models on a 240 x 320 image
+#define Q_FACE_DETECTION_QVGA_NUM_HEADS 4
+extern const Q_Face_Detection_Head q_face_detection_qvga_heads[Q_FACE_DETECTION_QVGA_NUM_HEADS];
+
+// The three heads of the 5400 output (900 prior) fast face detection model on a 240 x 320 image
+#define Q_FACE_DETECTION_QVGA_FAST_NUM_HEADS 3
+extern const Q_Face_Detection_Head q_face_detection_qvga_fast_heads[Q_FACE_DETECTION_QVGA_FAST_NUM_HEADS];
+
+/**
+ * @brief Parameters of the post-processing
+ * @var   heads            pointer to the heads of the model, in the order of the output tensor
+ * @var   num_heads        number of heads
+ * @var   img_h            height of the input image in pixels. The boxes are clipped to the image
+ * @var   img_w            width of the input image in pixels. img_h and img_w have to be below 2^(15 - Q_FACE_DETECTION_BOX_SCALE)
+ * @var   scale            scale of the output tensor, i.e. a logit or an offset of value v is stored as v * 2^{scale}
+ * @var   conf_thresh      minimum face probability of a detection in Q15
+ * @var   nms_thresh       IoU (Q15) above which a box is suppressed by a kept box of higher score
+ * @var   top_k            maximum number of candidates decoded and passed to the NMS
+ * @var   max_detections   maximum number of boxes kept by the NMS
+ */
+typedef struct Q_Face_Detection_Post_Params {
+  const Q_Face_Detection_Head* heads;
+  ITER_T num_heads;
+  ITER_T img_h;
+  ITER_T img_w;
+  SCALE_T scale;
+  Q15_T conf_thresh;
+  Q15_T nms_thresh;
+  ITER_T top_k;
+  ITER_T max_detections;
+} Q_Face_Detection_Post_Params;
+
+/**
+ * @brief One detected box
+ * @var   x1, y1      top left corner in pixels, with Q_FACE_DETECTION_BOX_SCALE fractional bits
+ * @var   x2, y2      bottom right corner in pixels, with Q_FACE_DETECTION_BOX_SCALE fractional bits
+ * @var   score       face probability in Q15
+ * @var   prior       index of the prior box the detection was decoded from
+ */
+typedef struct Q_Face_Detection_Box {
+  Q15_T x1;
+  Q15_T y1;
+  Q15_T x2;
+  Q15_T y2;
+  Q15_T score;
+  ITER_T prior;
+} Q_Face_Detection_Box;
+
+/**
+ * @brief Scratch space of the post-processing, provided by the caller
+ * @var   scores      num_priors elements
+ * @var   order       2 * num_priors elements
+ */
+typedef struct Q_Face_Detection_Post_Buffers {
+  Q15_T* scores;
+  ITER_T* order;
+} Q_Face_Detection_Post_Buffers;
+
+/**
+ * @brief Returns the number of prior boxes of a model, i.e. the sum of rows * cols over the heads
+ * @param[in]        heads            pointer to the heads of the model
+ * @param[in]        num_heads        number of heads
+ * @return           The number of priors. The output tensor of the model has 6 elements per prior
+ */
+ITER_T q_face_detection_num_priors(const Q_Face_Detection_Head* heads,
+  ITER_T num_heads);
+
+/**
+ * @brief Decodes the output tensor of a face detection model into a list of boxes, sorted by decreasing score
+ * @param[in]        output           pointer to the output tensor of the model (6 * num_priors elements)
+ * @param[in]        params           pointer to the post-processing parameters
+ * @param[in]        buffers          pointer to the scratch space
+ * @param[out]       detections       pointer to the detected boxes (max_detections elements)
+ * @param[out]       num_detections   number of detected boxes
+ * @return           The function returns 0 on success, ERR_FACE_DETECTION_POST_INVALID_PARAMS for a missing head table,
+ *                   a scale outside [0, 16] or an image too large for the box format, and ERR_FACE_DETECTION_POST_NOT_INIT
+ *                   if one of the buffers is not set
+ * @example          For the 18000 output models, use q_face_detection_qvga_heads, img_h = 240, img_w = 320 and scale = 12.
+ *                   detection.py runs the NMS on the 5000 best candidates and keeps the 750 best of the boxes left
+ *                   (top_k = 5000, max_detections = 750)
+ *                   For the fast model, use q_face_detection_qvga_fast_heads with the same image size
+ */
+int q_face_detection_postprocess(const Q15_T* output,
+  const Q_Face_Detection_Post_Params* params,
+  const Q_Face_Detection_Post_Buffers* buffers,
+  Q_Face_Detection_Box* detections, ITER_T* num_detections);
+
+#endif
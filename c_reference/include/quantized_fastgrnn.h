@@ -315,4 +315,31 @@ int q15_fastgrnn(Q15_T* const hiddenState, ITER_T hiddenDims,
   const Q15_T* const input, ITER_T inputDims, ITER_T steps, const void* params,
   void* buffers, const void* scales, int backward, int normalize);
 
+/**
+ * @brief Single step update of a batch of independent FastGRNN cells sharing the same parameters
+ * @brief The output is bit-exact with one call of q7xq15_q15_fastgrnn() / q15_fastgrnn() with steps = 1 per cell, but the matrix-vector
+ * @brief products of the whole batch are computed together and the element-wise operations are applied to the whole batch at once
+ * @param[in,out]   hiddenStates pointer to the hidden states of the cells, stored one after the other, size batch * hiddenDims
+ * @param[in]       hiddenDims   dimension of hidden state of the FastGRNN cell
+ * @param[in]       input        pointer to the input vector of the first cell
+ * @param[in]       inputDims    dimension of input vector of each cell
+ * @param[in]       inputStride  distance between the input vectors of two consecutive cells. Pass inputDims for contiguous inputs
+ * @param[in]       batch        number of cells
+ * @param[in]       params       pointer to model parameter
+ * @param[in]       buffers      pointer to buffer spaces. preComp1, preComp2 and preComp3 must be of size batch * hiddenDims,
+ *                               normFeatures must be of size batch * inputDims
+ * @param[in]       scales       pointer to model scales
+ * @param[in]       normalize    apply mean-var normalization, 0 for no, 1 for yes
+ * @return     The function returns <code>0</code> on success
+ *             <code>ERR_PRECOMP_NOT_INIT</code> if preComp1, preComp2 or preComp3 not allocated
+ *             <code>ERR_NORMFEAT_NOT_INIT</code> if normFeatures not allocated
+ * @example         Please refer the file: c_reference/tests/fastgrnn/test_quantized_fastgrnn.c
+ */
+int q7xq15_q15_fastgrnn_batch(Q15_T* const hiddenStates, ITER_T hiddenDims,
+  const Q7_T* const input, ITER_T inputDims, ITER_T inputStride, ITER_T batch,
+  const void* params, void* buffers, const void* scales, int normalize);
+int q15_fastgrnn_batch(Q15_T* const hiddenStates, ITER_T hiddenDims,
+  const Q15_T* const input, ITER_T inputDims, ITER_T inputStride, ITER_T batch,
+  const void* params, void* buffers, const void* scales, int normalize);
+
 #endif
@@ -5,6 +5,12 @@
 #define __QUANTIZED_MBCONV_H__
 
 #include "quantized_utils.h"
+#include "quantized_sparse_conv.h"
+
+// Largest number of bands of the multi-threaded MBConv blocks
+#ifndef Q_MBCONV_MAX_THREADS
+  #define Q_MBCONV_MAX_THREADS 8
+#endif
 
 /**
  * @brief Model parameters for Quantized MBConv Layer
@@ -118,4 +124,198 @@ void q15_mbconv_block(const Q15_T* const input, const Q15_T* const filter1,
   SCALE_T shrW3, SCALE_T shlU1, SCALE_T shlX1, SCALE_T shlU2, SCALE_T shlX2,
   SCALE_T shlU3, SCALE_T shlW3);
 
+/**
+ * @brief Multi-threaded versions of the MBConv blocks above. The output rows are split into num_threads bands of consecutive rows,
+ * @brief and every band is computed by the single-threaded block on the input rows it depends on (with the padding of the band).
+ * @brief The output is bit-exact with the single-threaded block for any number of threads
+ * @param[in]        bandBuffers    scratch space of the bands after the first, which uses convBuffer1 and convBuffer2. Every other band takes
+ *                                  HF * W * CTemp + CTemp elements of the type of the buffers from it, one band after the other
+ * @param[in]        bandBuffersSize size of bandBuffers in bytes. The number of bands is limited to those which fit, 1 + bandBuffersSize /
+ *                                  ((HF * W * CTemp + CTemp) * element size), hence a single band runs with bandBuffers NULL and size 0
+ * @param[in]        num_threads    number of bands, limited to Q_MBCONV_MAX_THREADS. Without MULTITHREADED, the block runs as a single band
+ * @brief The other parameters are the same as those of the single-threaded blocks
+ */
+void q7_mbconv_block_threaded(const Q7_T* const input, const Q7_T* const filter1,
+  const Q7_T* const BN1W, const Q7_T* const BN1B, const Q7_T* const filter2,
+  const Q7_T* const BN2W, const Q7_T* const BN2B, const Q7_T* const filter3,
+  const Q7_T* const BN3W, const Q7_T* const BN3B, Q7_T* const output,
+  Q7_T* const convBuffer1, Q7_T* const convBuffer2, ITER_T N, ITER_T H,
+  ITER_T W, ITER_T CIn, ITER_T CTemp, ITER_T HF, ITER_T WF, ITER_T COut,
+  ITER_T HOut, ITER_T WOut, S_ITER_T HPadU, S_ITER_T HPadD, S_ITER_T WPadL,
+  S_ITER_T WPadR, ITER_T HStride, ITER_T WStride, Q15_T limit1, Q15_T limit2,
+  SCALE_T shrU1, SCALE_T shrX1, SCALE_T shrU2, SCALE_T shrX2, SCALE_T shrU3,
+  SCALE_T shrW3, SCALE_T shlU1, SCALE_T shlX1, SCALE_T shlU2, SCALE_T shlX2,
+  SCALE_T shlU3, SCALE_T shlW3, void* const bandBuffers,
+  size_t bandBuffersSize, ITER_T num_threads);
+void q7xq15_q15_mbconv_block_threaded(const Q7_T* const input,
+  const Q15_T* const filter1, const Q15_T* const BN1W, const Q15_T* const BN1B,
+  const Q15_T* const filter2, const Q15_T* const BN2W, const Q15_T* const BN2B,
+  const Q15_T* const filter3, const Q15_T* const BN3W, const Q15_T* const BN3B,
+  Q15_T* const output, Q15_T* const convBuffer1, Q15_T* const convBuffer2,
+  ITER_T N, ITER_T H, ITER_T W, ITER_T CIn, ITER_T CTemp, ITER_T HF, ITER_T WF,
+  ITER_T COut, ITER_T HOut, ITER_T WOut, S_ITER_T HPadU, S_ITER_T HPadD,
+  S_ITER_T WPadL, S_ITER_T WPadR, ITER_T HStride, ITER_T WStride, Q31_T limit1,
+  Q31_T limit2, SCALE_T shrU1, SCALE_T shrX1, SCALE_T shrU2, SCALE_T shrX2,
+  SCALE_T shrU3, SCALE_T shrW3, SCALE_T shlU1, SCALE_T shlX1, SCALE_T shlU2,
+  SCALE_T shlX2, SCALE_T shlU3, SCALE_T shlW3, void* const bandBuffers,
+  size_t bandBuffersSize, ITER_T num_threads);
+void q15xq7_q7_mbconv_block_threaded(const Q15_T* const input,
+  const Q7_T* const filter1, const Q7_T* const BN1W, const Q15_T* const BN1B,
+  const Q7_T* const filter2, const Q7_T* const BN2W, const Q15_T* const BN2B,
+  const Q7_T* const filter3, const Q7_T* const BN3W, const Q15_T* const BN3B,
+  Q7_T* const output, Q15_T* const convBuffer1, Q15_T* const convBuffer2,
+  ITER_T N, ITER_T H, ITER_T W, ITER_T CIn, ITER_T CTemp, ITER_T HF, ITER_T WF,
+  ITER_T COut, ITER_T HOut, ITER_T WOut, S_ITER_T HPadU, S_ITER_T HPadD,
+  S_ITER_T WPadL, S_ITER_T WPadR, ITER_T HStride, ITER_T WStride, Q31_T limit1,
+  Q31_T limit2, SCALE_T shrU1, SCALE_T shrX1, SCALE_T shrU2, SCALE_T shrX2,
+  SCALE_T shrU3, SCALE_T shrW3, SCALE_T shlU1, SCALE_T shlX1, SCALE_T shlU2,
+  SCALE_T shlX2, SCALE_T shlU3, SCALE_T shlW3, void* const bandBuffers,
+  size_t bandBuffersSize, ITER_T num_threads);
+void q15xq7_q15_mbconv_block_threaded(const Q15_T* const input,
+  const Q7_T* const filter1, const Q7_T* const BN1W, const Q15_T* const BN1B,
+  const Q7_T* const filter2, const Q7_T* const BN2W, const Q15_T* const BN2B,
+  const Q7_T* const filter3, const Q7_T* const BN3W, const Q15_T* const BN3B,
+  Q15_T* const output, Q15_T* const convBuffer1, Q15_T* const convBuffer2,
+  ITER_T N, ITER_T H, ITER_T W, ITER_T CIn, ITER_T CTemp, ITER_T HF, ITER_T WF,
+  ITER_T COut, ITER_T HOut, ITER_T WOut, S_ITER_T HPadU, S_ITER_T HPadD,
+  S_ITER_T WPadL, S_ITER_T WPadR, ITER_T HStride, ITER_T WStride, Q31_T limit1,
+  Q31_T limit2, SCALE_T shrU1, SCALE_T shrX1, SCALE_T shrU2, SCALE_T shrX2,
+  SCALE_T shrU3, SCALE_T shrW3, SCALE_T shlU1, SCALE_T shlX1, SCALE_T shlU2,
+  SCALE_T shlX2, SCALE_T shlU3, SCALE_T shlW3, void* const bandBuffers,
+  size_t bandBuffersSize, ITER_T num_threads);
+void q15_mbconv_block_threaded(const Q15_T* const input, const Q15_T* const filter1,
+  const Q15_T* const BN1W, const Q15_T* const BN1B, const Q15_T* const filter2,
+  const Q15_T* const BN2W, const Q15_T* const BN2B, const Q15_T* const filter3,
+  const Q15_T* const BN3W, const Q15_T* const BN3B, Q15_T* const output,
+  Q15_T* const convBuffer1, Q15_T* const convBuffer2, ITER_T N, ITER_T H,
+  ITER_T W, ITER_T CIn, ITER_T CTemp, ITER_T HF, ITER_T WF, ITER_T COut,
+  ITER_T HOut, ITER_T WOut, S_ITER_T HPadU, S_ITER_T HPadD, S_ITER_T WPadL,
+  S_ITER_T WPadR, ITER_T HStride, ITER_T WStride, Q31_T limit1, Q31_T limit2,
+  SCALE_T shrU1, SCALE_T shrX1, SCALE_T shrU2, SCALE_T shrX2, SCALE_T shrU3,
+  SCALE_T shrW3, SCALE_T shlU1, SCALE_T shlX1, SCALE_T shlU2, SCALE_T shlX2,
+  SCALE_T shlU3, SCALE_T shlW3, void* const bandBuffers,
+  size_t bandBuffersSize, ITER_T num_threads);
+
+/**
+ * @brief MBConv blocks with packed filters (see quantized_sparse_conv.h), for pruned models. The zero weights of the sparse filters are skipped
+ * @brief The output is bit-exact with the dense blocks. If none of the three filters is sparse, the dense block runs on the dense filters
+ * @param[in]        filter1        first convolution, packed with q15_sparse_filter_pack(F1, 1, 1, CIn, CTemp, 1, ...)
+ * @param[in]        filter2        depthwise convolution, packed with q15_sparse_filter_pack(F2, HF, WF, 1, 1, CTemp, ...)
+ * @param[in]        filter3        last convolution, packed with q15_sparse_filter_pack(F3, 1, 1, CTemp, COut, 1, ...)
+ * @param[in]        num_threads    number of bands of the threaded blocks, as for the multi-threaded blocks above
+ * @brief The other parameters are the same as those of the dense blocks
+ * @example          Please refer the file: c_reference/tests/sparse_conv/test_quantized_sparse_conv.c
+ */
+void q7xq15_q15_sparse_mbconv_block(const Q7_T* const input,
+  const Q15_Sparse_Filter* const filter1, const Q15_T* const BN1W,
+  const Q15_T* const BN1B, const Q15_Sparse_Filter* const filter2,
+  const Q15_T* const BN2W, const Q15_T* const BN2B,
+  const Q15_Sparse_Filter* const filter3, const Q15_T* const BN3W,
+  const Q15_T* const BN3B, Q15_T* const output, Q15_T* const convBuffer1,
+  Q15_T* const convBuffer2, ITER_T N, ITER_T H, ITER_T W, ITER_T CIn,
+  ITER_T CTemp, ITER_T HF, ITER_T WF, ITER_T COut, ITER_T HOut, ITER_T WOut,
+  S_ITER_T HPadU, S_ITER_T HPadD, S_ITER_T WPadL, S_ITER_T WPadR,
+  ITER_T HStride, ITER_T WStride, Q31_T limit1, Q31_T limit2, SCALE_T shrU1,
+  SCALE_T shrX1, SCALE_T shrU2, SCALE_T shrX2, SCALE_T shrU3, SCALE_T shrW3,
+  SCALE_T shlU1, SCALE_T shlX1, SCALE_T shlU2, SCALE_T shlX2, SCALE_T shlU3,
+  SCALE_T shlW3);
+void q15_sparse_mbconv_block(const Q15_T* const input,
+  const Q15_Sparse_Filter* const filter1, const Q15_T* const BN1W,
+  const Q15_T* const BN1B, const Q15_Sparse_Filter* const filter2,
+  const Q15_T* const BN2W, const Q15_T* const BN2B,
+  const Q15_Sparse_Filter* const filter3, const Q15_T* const BN3W,
+  const Q15_T* const BN3B, Q15_T* const output, Q15_T* const convBuffer1,
+  Q15_T* const convBuffer2, ITER_T N, ITER_T H, ITER_T W, ITER_T CIn,
+  ITER_T CTemp, ITER_T HF, ITER_T WF, ITER_T COut, ITER_T HOut, ITER_T WOut,
+  S_ITER_T HPadU, S_ITER_T HPadD, S_ITER_T WPadL, S_ITER_T WPadR,
+  ITER_T HStride, ITER_T WStride, Q31_T limit1, Q31_T limit2, SCALE_T shrU1,
+  SCALE_T shrX1, SCALE_T shrU2, SCALE_T shrX2, SCALE_T shrU3, SCALE_T shrW3,
+  SCALE_T shlU1, SCALE_T shlX1, SCALE_T shlU2, SCALE_T shlX2, SCALE_T shlU3,
+  SCALE_T shlW3);
+void q7xq15_q15_sparse_mbconv_block_threaded(const Q7_T* const input,
+  const Q15_Sparse_Filter* const filter1, const Q15_T* const BN1W,
+  const Q15_T* const BN1B, const Q15_Sparse_Filter* const filter2,
+  const Q15_T* const BN2W, const Q15_T* const BN2B,
+  const Q15_Sparse_Filter* const filter3, const Q15_T* const BN3W,
+  const Q15_T* const BN3B, Q15_T* const output, Q15_T* const convBuffer1,
+  Q15_T* const convBuffer2, ITER_T N, ITER_T H, ITER_T W, ITER_T CIn,
+  ITER_T CTemp, ITER_T HF, ITER_T WF, ITER_T COut, ITER_T HOut, ITER_T WOut,
+  S_ITER_T HPadU, S_ITER_T HPadD, S_ITER_T WPadL, S_ITER_T WPadR,
+  ITER_T HStride, ITER_T WStride, Q31_T limit1, Q31_T limit2, SCALE_T shrU1,
+  SCALE_T shrX1, SCALE_T shrU2, SCALE_T shrX2, SCALE_T shrU3, SCALE_T shrW3,
+  SCALE_T shlU1, SCALE_T shlX1, SCALE_T shlU2, SCALE_T shlX2, SCALE_T shlU3,
+  SCALE_T shlW3, void* const bandBuffers, size_t bandBuffersSize,
+  ITER_T num_threads);
+void q15_sparse_mbconv_block_threaded(const Q15_T* const input,
+  const Q15_Sparse_Filter* const filter1, const Q15_T* const BN1W,
+  const Q15_T* const BN1B, const Q15_Sparse_Filter* const filter2,
+  const Q15_T* const BN2W, const Q15_T* const BN2B,
+  const Q15_Sparse_Filter* const filter3, const Q15_T* const BN3W,
+  const Q15_T* const BN3B, Q15_T* const output, Q15_T* const convBuffer1,
+  Q15_T* const convBuffer2, ITER_T N, ITER_T H, ITER_T W, ITER_T CIn,
+  ITER_T CTemp, ITER_T HF, ITER_T WF, ITER_T COut, ITER_T HOut, ITER_T WOut,
+  S_ITER_T HPadU, S_ITER_T HPadD, S_ITER_T WPadL, S_ITER_T WPadR,
+  ITER_T HStride, ITER_T WStride, Q31_T limit1, Q31_T limit2, SCALE_T shrU1,
+  SCALE_T shrX1, SCALE_T shrU2, SCALE_T shrX2, SCALE_T shrU3, SCALE_T shrW3,
+  SCALE_T shlU1, SCALE_T shlX1, SCALE_T shlU2, SCALE_T shlX2, SCALE_T shlU3,
+  SCALE_T shlW3, void* const bandBuffers, size_t bandBuffersSize,
+  ITER_T num_threads);
+
+/**
+ * @brief Shape and scales of an MBConv block, i.e. the scalar arguments of the MBConv functions above
+ * @brief All the fields are 32-bit, hence the struct has the same layout on all the targets and is stored as is in the model blobs
+ */
+typedef struct Q_MBConv_Config {
+  ITER_T N;
+  ITER_T H;
+  ITER_T W;
+  ITER_T CIn;
+  ITER_T CTemp;
+  ITER_T HF;
+  ITER_T WF;
+  ITER_T COut;
+  ITER_T HOut;
+  ITER_T WOut;
+  S_ITER_T HPadU;
+  S_ITER_T HPadD;
+  S_ITER_T WPadL;
+  S_ITER_T WPadR;
+  ITER_T HStride;
+  ITER_T WStride;
+  Q31_T limit1;
+  Q31_T limit2;
+  SCALE_T shrU1;
+  SCALE_T shrX1;
+  SCALE_T shrU2;
+  SCALE_T shrX2;
+  SCALE_T shrU3;
+  SCALE_T shrW3;
+  SCALE_T shlU1;
+  SCALE_T shlX1;
+  SCALE_T shlU2;
+  SCALE_T shlX2;
+  SCALE_T shlU3;
+  SCALE_T shlW3;
+} Q_MBConv_Config;
+
+/**
+ * @brief Weights of an MBConv block. The element types depend on the variant of the block (Q7_T or Q15_T)
+ * @var   filter1, BN1W, BN1B    first convolution (CIn x CTemp) and its BatchNorm (CTemp)
+ * @var   filter2, BN2W, BN2B    depthwise convolution (CTemp x HF x WF) and its BatchNorm (CTemp)
+ * @var   filter3, BN3W, BN3B    last convolution (CTemp x COut) and its BatchNorm (COut)
+ * @var   config                 shape and scales of the block
+ */
+typedef struct Q_MBConv_Params {
+  const void* filter1;
+  const void* BN1W;
+  const void* BN1B;
+  const void* filter2;
+  const void* BN2W;
+  const void* BN2B;
+  const void* filter3;
+  const void* BN3W;
+  const void* BN3B;
+  const Q_MBConv_Config* config;
+} Q_MBConv_Params;
+
 #endif
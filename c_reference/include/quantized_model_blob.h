@@ -0,0 +1,255 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#ifndef __QUANTIZED_MODEL_BLOB_H__
+#define __QUANTIZED_MODEL_BLOB_H__
+
+#include <stddef.h>
+#include "quantized_datatypes.h"
+#include "quantized_fastgrnn.h"
+#include "quantized_mbconv.h"
+
+/* Binary model blobs, an alternative to the compiled-in weight headers
+   A blob is a single file holding the weights, the scales and the layer shapes of a model:
+   -> Header : Q_Model_Blob_Header
+   -> Entry table : num_entries entries of entry_size bytes each (Q_Model_Blob_Entry)
+   -> Data : the arrays of the entries, each aligned to Q_MODEL_BLOB_ALIGN bytes from the start of the blob
+
+   An entry is a named array of Q7_T, Q15_T or 32-bit (Q31_T, ITER_T, SCALE_T) elements, or a record (a struct stored as is).
+   The entries of a layer share a prefix, e.g. "rnn1.W", "rnn1.U" and "rnn1.scales" for the FastGRNN cell "rnn1"
+
+   The loader maps the file with a single mmap and points the parameter structs of the layers at the mapped data, nothing is copied.
+   Blobs can also be used from memory (e.g. flash) with q_model_blob_init()
+
+   Versioning: the major version changes with any incompatible change of the layout and has to match. A blob of a newer minor version
+   can be read by an older loader (the entries can grow at their end and unknown entries are ignored). The blobs are written in the byte
+   order of the packer, which has to match the one of the target (checked with the magic number). The records are stored in the layout
+   of the packer, the loader only checks their size
+
+   Scale mode: the scales of a blob are either shift amounts or divisors, depending on whether the packer was built with SHIFT.
+   The header records the mode of the packer, and a loader built with the other mode rejects the blob
+*/
+
+#define ERR_MODEL_BLOB_IO -1
+#define ERR_MODEL_BLOB_FORMAT -2
+#define ERR_MODEL_BLOB_VERSION -3
+#define ERR_MODEL_BLOB_MISSING_ENTRY -4
+#define ERR_MODEL_BLOB_ENTRY_MISMATCH -5
+#define ERR_MODEL_BLOB_FULL -6
+#define ERR_MODEL_BLOB_SCALE_MODE -7
+
+#define Q_MODEL_BLOB_MAGIC 0x514C4D45 // "EMLQ"
+#define Q_MODEL_BLOB_VERSION_MAJOR 2
+#define Q_MODEL_BLOB_VERSION_MINOR 0
+#define Q_MODEL_BLOB_ALIGN 16
+#define Q_MODEL_BLOB_NAME_LEN 32
+#define Q_MODEL_BLOB_MAX_DIMS 4
+
+// Element types of the entries
+#define Q_MODEL_BLOB_Q7 1
+#define Q_MODEL_BLOB_Q15 2
+#define Q_MODEL_BLOB_Q31 3
+#define Q_MODEL_BLOB_RECORD 4
+
+// Scale modes of the blobs
+#define Q_MODEL_BLOB_SCALE_DIV 0
+#define Q_MODEL_BLOB_SCALE_SHIFT 1
+#ifdef SHIFT
+  #define Q_MODEL_BLOB_SCALE_MODE Q_MODEL_BLOB_SCALE_SHIFT
+#else
+  #define Q_MODEL_BLOB_SCALE_MODE Q_MODEL_BLOB_SCALE_DIV
+#endif
+
+typedef struct Q_Model_Blob_Header {
+  uint32_t magic;
+  uint16_t version_major;
+  uint16_t version_minor;
+  uint32_t num_entries;
+  uint32_t entry_size;
+  uint64_t size;
+  uint32_t scale_mode;
+  uint32_t reserved;
+} Q_Model_Blob_Header;
+
+/**
+ * @brief Description of one array of a blob
+ * @var   name        NUL-terminated name of the array
+ * @var   type        element type, one of the Q_MODEL_BLOB_* types. The elements of a record are bytes
+ * @var   ndims       number of dimensions of the array
+ * @var   dims        shape of the array, the unused dimensions are 1
+ * @var   offset      byte offset of the data from the start of the blob
+ * @var   count       number of elements, i.e. the product of the dimensions
+ */
+typedef struct Q_Model_Blob_Entry {
+  char name[Q_MODEL_BLOB_NAME_LEN];
+  uint32_t type;
+  uint32_t ndims;
+  uint32_t dims[Q_MODEL_BLOB_MAX_DIMS];
+  uint64_t offset;
+  uint64_t count;
+} Q_Model_Blob_Entry;
+
+/**
+ * @brief A blob opened for reading
+ * @var   data          pointer to the start of the blob
+ * @var   size          size of the blob in bytes
+ * @var   num_entries   number of entries
+ * @var   entry_size    stride of the entry table in bytes
+ * @var   mapped        1 if the blob was mapped by q_model_blob_open(), 0 if it was provided by the caller
+ */
+typedef struct Q_Model_Blob {
+  const unsigned char* data;
+  size_t size;
+  ITER_T num_entries;
+  ITER_T entry_size;
+  int mapped;
+} Q_Model_Blob;
+
+/**
+ * @brief Maps a blob file to memory (read-only) and checks its header and its entry table
+ * @param[in]        path     path of the blob file
+ * @param[out]       blob     pointer to the opened blob. Released with q_model_blob_close()
+ * @return           The function returns 0 on success, ERR_MODEL_BLOB_IO if the file could not be opened or mapped,
+ *                   ERR_MODEL_BLOB_FORMAT for a malformed blob, ERR_MODEL_BLOB_VERSION for an unsupported major version
+ *                   and ERR_MODEL_BLOB_SCALE_MODE for a blob packed with the other scale mode (SHIFT or division)
+ */
+int q_model_blob_open(const char* path, Q_Model_Blob* blob);
+
+/**
+ * @brief Opens a blob already in memory. The memory has to stay valid, and is not released by q_model_blob_close()
+ * @param[in]        data     pointer to the blob, aligned to Q_MODEL_BLOB_ALIGN bytes
+ * @param[in]        size     size of the blob in bytes
+ * @param[out]       blob     pointer to the opened blob
+ * @return           Same as q_model_blob_open(), without ERR_MODEL_BLOB_IO
+ */
+int q_model_blob_init(const void* data, size_t size, Q_Model_Blob* blob);
+
+/**
+ * @brief Unmaps a blob opened with q_model_blob_open(). The parameters loaded from it become invalid
+ * @param[in,out]    blob     pointer to the blob
+ * @return           none
+ */
+void q_model_blob_close(Q_Model_Blob* blob);
+
+/**
+ * @brief Looks up an entry of a blob by name
+ * @param[in]        blob     pointer to the blob
+ * @param[in]        name     name of the entry
+ * @return           Pointer to the entry in the blob, 0 if there is none of that name
+ */
+const Q_Model_Blob_Entry* q_model_blob_find(const Q_Model_Blob* blob,
+  const char* name);
+
+/**
+ * @brief Returns the data of an entry, after checking its type and its number of elements
+ * @param[in]        blob     pointer to the blob
+ * @param[in]        name     name of the entry
+ * @param[in]        type     expected element type
+ * @param[in]        count    expected number of elements. Pass 0 to accept any number
+ * @param[out]       data     pointer to the data of the entry in the blob
+ * @return           The function returns 0 on success, ERR_MODEL_BLOB_MISSING_ENTRY if there is no such entry
+ *                   and ERR_MODEL_BLOB_ENTRY_MISMATCH for an entry of a different type or size
+ */
+int q_model_blob_array(const Q_Model_Blob* blob, const char* name,
+  ITER_T type, ITER_T count, const void** data);
+
+/**
+ * @brief Loads the parameters of a FastGRNN cell. Reads the entries <prefix>.W, .U, .Bg, .Bh, .sigmoid (zeta, nu) and .scales,
+ * @brief and the optional ones .mean, .stdDev, .Wids, .Wvals, .Uids and .Uvals (left NULL if missing)
+ * @param[in]        blob         pointer to the blob
+ * @param[in]        prefix       name of the cell
+ * @param[in]        inputDims    dimension of the input vector of the cell, checked against the blob
+ * @param[in]        hiddenDims   dimension of the hidden state of the cell, checked against the blob
+ * @param[out]       params       pointer to the parameters. The arrays point into the blob
+ * @param[out]       scales       pointer to the scales in the blob
+ * @return           The function returns 0 on success, or the error of the first entry which could not be loaded
+ */
+int q_model_blob_q15_fastgrnn(const Q_Model_Blob* blob, const char* prefix,
+  ITER_T inputDims, ITER_T hiddenDims, Q15_FastGRNN_Params* params,
+  const Q15_FastGRNN_Scales** scales);
+int q_model_blob_q7xq15_fastgrnn(const Q_Model_Blob* blob, const char* prefix,
+  ITER_T inputDims, ITER_T hiddenDims, Q7xQ15_FastGRNN_Params* params,
+  const Q15_FastGRNN_Scales** scales);
+
+/**
+ * @brief Loads the parameters of an MBConv block. Reads the entries <prefix>.config, .filter1, .BN1W, .BN1B, .filter2, .BN2W, .BN2B,
+ * @brief .filter3, .BN3W and .BN3B. The sizes of the arrays are checked against the config
+ * @param[in]        blob          pointer to the blob
+ * @param[in]        prefix        name of the block
+ * @param[in]        weight_type   element type of the filters and of the BatchNorm multipliers (Q_MODEL_BLOB_Q7 or Q_MODEL_BLOB_Q15)
+ * @param[in]        bias_type     element type of the BatchNorm offsets
+ * @param[out]       params        pointer to the parameters. The arrays and the config point into the blob
+ * @return           The function returns 0 on success, or the error of the first entry which could not be loaded
+ */
+int q_model_blob_mbconv(const Q_Model_Blob* blob, const char* prefix,
+  ITER_T weight_type, ITER_T bias_type, Q_MBConv_Params* params);
+
+#define Q_MODEL_BLOB_PACKER_MAX_ENTRIES 256
+
+/**
+ * @brief Offline packer. Collects the arrays of a model, then writes them to a blob file
+ * @var   entries       descriptions of the collected arrays (the offsets are assigned when writing)
+ * @var   data          pointers to the data of the collected arrays, which have to stay valid until the blob is written
+ * @var   sigmoid       storage of the sigmoid parameters of the FastGRNN cells
+ * @var   num_entries   number of collected arrays
+ */
+typedef struct Q_Model_Blob_Packer {
+  Q_Model_Blob_Entry entries[Q_MODEL_BLOB_PACKER_MAX_ENTRIES];
+  const void* data[Q_MODEL_BLOB_PACKER_MAX_ENTRIES];
+  Q15_T sigmoid[Q_MODEL_BLOB_PACKER_MAX_ENTRIES][2];
+  ITER_T num_entries;
+} Q_Model_Blob_Packer;
+
+/**
+ * @brief Adds an array to a packer
+ * @param[in,out]    packer   pointer to the packer. Set num_entries to 0 before the first call
+ * @param[in]        name     name of the array, shorter than Q_MODEL_BLOB_NAME_LEN
+ * @param[in]        type     element type of the array
+ * @param[in]        ndims    number of dimensions, at most Q_MODEL_BLOB_MAX_DIMS
+ * @param[in]        dims     shape of the array
+ * @param[in]        data     pointer to the data of the array
+ * @return           The function returns 0 on success, ERR_MODEL_BLOB_FULL if the packer is full
+ *                   and ERR_MODEL_BLOB_FORMAT for an invalid name, type or shape
+ */
+int q_model_blob_pack_array(Q_Model_Blob_Packer* packer, const char* name,
+  ITER_T type, ITER_T ndims, const ITER_T* dims, const void* data);
+
+/**
+ * @brief Adds the parameters and the scales of a FastGRNN cell to a packer, with the names read by q_model_blob_q15_fastgrnn()
+ * @brief The sizes of the sparse matrices (Wids / Wvals and Uids / Uvals) are found from their zero-terminated columns
+ * @param[in,out]    packer       pointer to the packer
+ * @param[in]        prefix       name of the cell
+ * @param[in]        params       pointer to the parameters of the cell. The arrays have to stay valid until the blob is written
+ * @param[in]        scales       pointer to the scales of the cell
+ * @param[in]        inputDims    dimension of the input vector of the cell
+ * @param[in]        hiddenDims   dimension of the hidden state of the cell
+ * @return           Same as q_model_blob_pack_array()
+ */
+int q_model_blob_pack_q15_fastgrnn(Q_Model_Blob_Packer* packer,
+  const char* prefix, const Q15_FastGRNN_Params* params,
+  const Q15_FastGRNN_Scales* scales, ITER_T inputDims, ITER_T hiddenDims);
+int q_model_blob_pack_q7xq15_fastgrnn(Q_Model_Blob_Packer* packer,
+  const char* prefix, const Q7xQ15_FastGRNN_Params* params,
+  const Q15_FastGRNN_Scales* scales, ITER_T inputDims, ITER_T hiddenDims);
+
+/**
+ * @brief Adds the parameters of an MBConv block to a packer, with the names read by q_model_blob_mbconv()
+ * @param[in,out]    packer        pointer to the packer
+ * @param[in]        prefix        name of the block
+ * @param[in]        params        pointer to the parameters of the block, including its config
+ * @param[in]        weight_type   element type of the filters and of the BatchNorm multipliers
+ * @param[in]        bias_type     element type of the BatchNorm offsets
+ * @return           Same as q_model_blob_pack_array()
+ */
+int q_model_blob_pack_mbconv(Q_Model_Blob_Packer* packer, const char* prefix,
+  const Q_MBConv_Params* params, ITER_T weight_type, ITER_T bias_type);
+
+/**
+ * @brief Writes the arrays of a packer to a blob file, with the scale mode of the build (Q_MODEL_BLOB_SCALE_MODE)
+ * @param[in]        packer   pointer to the packer
+ * @param[in]        path     path of the blob file
+ * @return           The function returns 0 on success and ERR_MODEL_BLOB_IO if the file could not be written
+ */
+int q_model_blob_write(const Q_Model_Blob_Packer* packer, const char* path);
+
+#endif
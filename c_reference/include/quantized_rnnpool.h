@@ -8,6 +8,9 @@
 
 typedef int (*q7xq15_q15_rnn_t)(Q15_T* const, ITER_T, const Q7_T* const, ITER_T, ITER_T, const void*, void*, const void*, int, int);
 typedef int (*q15_rnn_t)(Q15_T* const, ITER_T, const Q15_T* const, ITER_T, ITER_T, const void*, void*, const void*, int, int);
+// Single step of a batch of cells, e.g. q7xq15_q15_fastgrnn_batch() and q15_fastgrnn_batch()
+typedef int (*q7xq15_q15_rnn_batch_t)(Q15_T* const, ITER_T, const Q7_T* const, ITER_T, ITER_T, ITER_T, const void*, void*, const void*, int);
+typedef int (*q15_rnn_batch_t)(Q15_T* const, ITER_T, const Q15_T* const, ITER_T, ITER_T, ITER_T, const void*, void*, const void*, int);
 
 /**
  * @brief Block implementation of RNNPool operator
@@ -20,6 +23,9 @@ typedef int (*q15_rnn_t)(Q15_T* const, ITER_T, const Q15_T* const, ITER_T, ITER_
  * @param[in]        rnn1_params    pointer to parameters of RNN1
  * @param[in]        rnn1_buffers   pointer to buffers needed for RNN1
  * @param[in]        rnn1_scales    pointer to the scales needed for RNN1
+ * @param[in]        rnn1_batch     function pointer to the batched RNN1 cell. The horizontal pass advances all the rows at once,
+ *                                  and the vertical pass all the columns at once. Pass NULL to run both passes one sequence at a time with rnn1
+ * @param[in]        rnn1_batch_buffers  pointer to buffers needed for the batched RNN1 cell, sized for a batch of patchDim cells
  * @param[in]        rnn2           function pointer to RNN2
  * @param[in]        hiddenDims2    dimension of the hidden state of RNN2
  * @param[in]        rnn2_params    pointer to parameters of RNN2
@@ -33,14 +39,69 @@ typedef int (*q15_rnn_t)(Q15_T* const, ITER_T, const Q15_T* const, ITER_T, ITER_
 int q7xq15_q15_rnnpool_block(const Q7_T* const patch, ITER_T inputDims,
   ITER_T patchDim, ITER_T stride, q7xq15_q15_rnn_t rnn1, ITER_T hiddenDims1,
   const void* rnn1_params, void* rnn1_buffers, const void* rnn1_scales,
+  q7xq15_q15_rnn_batch_t rnn1_batch, void* rnn1_batch_buffers,
   q15_rnn_t rnn2, ITER_T hiddenDims2, const void* rnn2_params,
   void* rnn2_buffers, const void* rnn2_scales, Q15_T* const output,
   Q15_T* const buffer, SCALE_T ShR1, SCALE_T ShL1, SCALE_T ShR2, SCALE_T ShL2);
 int q15_rnnpool_block(const Q15_T* const patch, ITER_T inputDims,
   ITER_T patchDim, ITER_T stride, q15_rnn_t rnn1, ITER_T hiddenDims1,
   const void* rnn1_params, void* rnn1_buffers, const void* rnn1_scales,
+  q15_rnn_batch_t rnn1_batch, void* rnn1_batch_buffers,
   q15_rnn_t rnn2, ITER_T hiddenDims2, const void* rnn2_params,
   void* rnn2_buffers, const void* rnn2_scales, Q15_T* const output,
   Q15_T* const buffer, SCALE_T ShR1, SCALE_T ShL1, SCALE_T ShR2, SCALE_T ShL2);
 
+/**
+ * @brief Buffers of one worker of q7xq15_q15_rnnpool_patches() and q15_rnnpool_patches(). Every worker needs its own set
+ * @var   rnn1_buffers        pointer to buffers needed for RNN1
+ * @var   rnn1_batch_buffers  pointer to buffers needed for the batched RNN1 cell, NULL if rnn1_batch is not used
+ * @var   rnn2_buffers        pointer to buffers needed for RNN2
+ * @var   output              pointer to the RNNPool output of one patch, size 4 * hiddenDims2
+ * @var   buffer              pointer to the RNNPool buffer, size hiddenDims1 * patchDim
+ */
+typedef struct Q_RNNPool_Worker_Buffers {
+  void* rnn1_buffers;
+  void* rnn1_batch_buffers;
+  void* rnn2_buffers;
+  Q15_T* output;
+  Q15_T* buffer;
+} Q_RNNPool_Worker_Buffers;
+
+/**
+ * @brief RNNPool over a grid of patchesX * patchesY patches, split over num_threads workers
+ * @brief Patch (x, y) reads the input at patch + x * patchStrideX + y * patchStrideY and writes its 4 * hiddenDims2 outputs
+ * @brief at output + x * outputStrideX + y * 4 * hiddenDims2. The patches are independent, hence the output does not depend on num_threads
+ * @param[in]        patch          pointer to the input of the first patch
+ * @param[in]        patchesX       number of patches along the rows of the grid
+ * @param[in]        patchesY       number of patches along the columns of the grid
+ * @param[in]        patchStrideX   distance between the inputs of two consecutive rows of patches
+ * @param[in]        patchStrideY   distance between the inputs of two consecutive patches of a row
+ * @param[out]       output         pointer to the output of the first patch. The q7xq15_q15 version demotes the outputs to Q7_T
+ * @param[in]        outputStrideX  distance between the outputs of two consecutive rows of patches
+ * @param[in]        mask           patchesX * patchesY flags in row-major order. Only the patches with a non-zero flag are computed,
+ *                                  the outputs of the others are left unchanged. Pass NULL to compute all the patches
+ * @param[in]        workers        pointer to num_threads sets of buffers, one per worker
+ * @param[in]        num_threads    number of workers. Threads are only created if compiled with MULTITHREADED
+ * @return           The function returns 0 on success, and the first non-zero error of rnnpool_block otherwise
+ * @brief            The other parameters are the same as those of q7xq15_q15_rnnpool_block()
+ */
+int q7xq15_q15_rnnpool_patches(const Q7_T* const patch, ITER_T inputDims,
+  ITER_T patchDim, ITER_T stride, ITER_T patchesX, ITER_T patchesY,
+  ITER_T patchStrideX, ITER_T patchStrideY, q7xq15_q15_rnn_t rnn1,
+  ITER_T hiddenDims1, const void* rnn1_params, const void* rnn1_scales,
+  q7xq15_q15_rnn_batch_t rnn1_batch, q15_rnn_t rnn2, ITER_T hiddenDims2,
+  const void* rnn2_params, const void* rnn2_scales, Q7_T* const output,
+  ITER_T outputStrideX, SCALE_T ShR1, SCALE_T ShL1, SCALE_T ShR2,
+  SCALE_T ShL2, const unsigned char* mask,
+  const Q_RNNPool_Worker_Buffers* workers, ITER_T num_threads);
+int q15_rnnpool_patches(const Q15_T* const patch, ITER_T inputDims,
+  ITER_T patchDim, ITER_T stride, ITER_T patchesX, ITER_T patchesY,
+  ITER_T patchStrideX, ITER_T patchStrideY, q15_rnn_t rnn1,
+  ITER_T hiddenDims1, const void* rnn1_params, const void* rnn1_scales,
+  q15_rnn_batch_t rnn1_batch, q15_rnn_t rnn2, ITER_T hiddenDims2,
+  const void* rnn2_params, const void* rnn2_scales, Q15_T* const output,
+  ITER_T outputStrideX, SCALE_T ShR1, SCALE_T ShL1, SCALE_T ShR2,
+  SCALE_T ShL2, const unsigned char* mask,
+  const Q_RNNPool_Worker_Buffers* workers, ITER_T num_threads);
+
 #endif
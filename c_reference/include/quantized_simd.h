@@ -0,0 +1,130 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#ifndef __QUANTIZED_SIMD_H__
+#define __QUANTIZED_SIMD_H__
+
+#include "quantized_datatypes.h"
+
+/* SIMD kernels for the quantized operators in quantized_utils.c
+   These are enabled by compiling with -DSIMD. The instruction set is chosen at runtime on x86 (AVX2, else SSE4.1, else scalar)
+   and at compile time on ARM (NEON, if __ARM_NEON is defined). The target specific code is compiled with function attributes,
+   hence no -m flags are required
+
+   All the kernels are bit-exact with the scalar code in both the SHIFT and the divide modes:
+   -> The accumulations are integer additions of the same terms as the scalar code. Only the order of the additions is changed
+   -> The SHIFT mode uses arithmetic shifts, same as the >> of the scalar code
+   -> In the divide mode, only the power of 2 scales are vectorized. These are computed as a shift with a round-towards-zero
+      correction for the negative numbers, same as the C integer division. Any other scale falls back to the scalar code
+
+   The vector kernels return the number of elements they have processed. The callers finish the remaining elements with their
+   scalar loops
+*/
+
+#define Q_SIMD_NONE 0
+#define Q_SIMD_SSE41 1
+#define Q_SIMD_AVX2 2
+#define Q_SIMD_NEON 3
+
+// Number of output channels computed together by the convolution kernels
+#define Q_SIMD_CONV_BLOCK 8
+
+/**
+ * @brief Returns the instruction set used by the SIMD kernels. The best one supported by the processor is detected on the first call
+ * @brief The detection runs once, also when several threads make the first call at the same time (-DMULTITHREADED)
+ * @return          One of Q_SIMD_NONE, Q_SIMD_SSE41, Q_SIMD_AVX2 and Q_SIMD_NEON
+ */
+int q_simd_level(void);
+
+/**
+ * @brief Overrides the instruction set used by the SIMD kernels. Used for testing and benchmarking the different code paths
+ * @brief Not thread-safe: call it before starting the threads running the kernels
+ * @param[in]       level     requested instruction set. Q_SIMD_NONE forces the scalar code
+ * @return          The instruction set in use after the call. A level not supported by the processor leaves the detected one unchanged
+ */
+int q_simd_set_level(int level);
+
+/**
+ * @brief Vectorized part of q15_v_add() and q15_t_add_vec(). ret[i] = ((vec1[i] >> scale1) + (vec2[i] >> scale2)) >> demote
+ * @brief In the divide mode, the shifts are replaced by divisions
+ * @param[in]       vec1      pointer to the first input vector
+ * @param[in]       vec2      pointer to the second input vector
+ * @param[in]       len       length of the input vectors
+ * @param[out]      ret       pointer to the output vector
+ * @param[in]       scale1    combined scale of the first input vector
+ * @param[in]       scale2    combined scale of the second input vector
+ * @param[in]       demote    scale of the sum. Pass 0 (SHIFT) or 1 (divide) for no demotion
+ * @return          Number of elements processed. The first len elements of ret which are not processed are left unchanged
+ */
+ITER_T q15_v_add_simd(const Q15_T* vec1, const Q15_T* vec2, ITER_T len,
+                      Q15_T* ret, SCALE_T scale1, SCALE_T scale2,
+                      SCALE_T demote);
+
+/**
+ * @brief Vectorized part of q15_v_hadamard(). ret[i] = ((Q31_T)vec1[i] * vec2[i]) >> scale (divide in the divide mode)
+ * @param[in]       vec1      pointer to the first input vector
+ * @param[in]       vec2      pointer to the second input vector
+ * @param[in]       len       length of the input vectors
+ * @param[out]      ret       pointer to the output vector
+ * @param[in]       scale     combined scale of the product
+ * @return          Number of elements processed
+ */
+ITER_T q15_v_hadamard_simd(const Q15_T* vec1, const Q15_T* vec2, ITER_T len,
+                           Q15_T* ret, SCALE_T scale);
+
+/**
+ * @brief Vectorized part of the dot product of q15xq7_q15_m_mulvec(). The products are accumulated with the (wrapping) Q31 arithmetic of the scalar code
+ * @param[in]       vec1      pointer to the Q15 vector
+ * @param[in]       vec2      pointer to the Q7 vector
+ * @param[in]       len       length of the input vectors
+ * @param[in,out]   sum       pointer to the accumulator. The products of the processed elements are added to it
+ * @return          Number of elements processed
+ */
+ITER_T q15xq7_v_dot_simd(const Q15_T* vec1, const Q7_T* vec2, ITER_T len,
+                         Q31_T* sum);
+
+/**
+ * @brief Vectorized part of the dot product of q15_m_mulvec(). The products are accumulated exactly in Q63
+ * @param[in]       vec1      pointer to the first vector
+ * @param[in]       vec2      pointer to the second vector
+ * @param[in]       len       length of the input vectors
+ * @param[in,out]   sum       pointer to the accumulator. The products of the processed elements are added to it
+ * @return          Number of elements processed
+ */
+ITER_T q15_v_dot_simd(const Q15_T* vec1, const Q15_T* vec2, ITER_T len,
+                      Q63_T* sum);
+
+/**
+ * @brief Vectorized part of q15_v_sigmoid_lut() and q15_v_tanh_lut(), which interpolate a table sampled every 2^shift inputs
+ * @brief With v = min(|vec[i]|, limit) and k = (v >> shift) + (vec[i] > 0 ? offset : 0), ret[i] = table[k] +
+ * @brief (((table[k + 1] - table[k]) * (v & (2^shift - 1)) + 2^(shift - 1)) >> shift), negated for vec[i] < 0 if odd is set
+ * @param[in]       vec       pointer to the input vector
+ * @param[in]       len       length of the input vector
+ * @param[out]      ret       pointer to the output vector
+ * @param[in]       table     pointer to the table. Entry k + 1 is read for every input
+ * @param[in]       shift     log2 of the sampling step of the table, at least 1
+ * @param[in]       limit     largest magnitude of the inputs, above which the table saturates
+ * @param[in]       offset    index of the table of the positive inputs, 0 for a single table
+ * @param[in]       odd       1 for an odd function, whose negative inputs are looked up as positive ones
+ * @return          Number of elements processed. The table lookups need gathers, hence only AVX2 processes any
+ */
+ITER_T q15_v_lut_simd(const Q15_T* vec, ITER_T len, Q15_T* ret,
+                      const Q15_T* table, SCALE_T shift, Q15_T limit,
+                      ITER_T offset, int odd);
+
+/**
+ * @brief Accumulates one filter tap of the convolution for Q_SIMD_CONV_BLOCK consecutive output channels
+ * @brief acc[j] += sum_{i < CF} input[i] * filter[i * COut + j], for j in [0, Q_SIMD_CONV_BLOCK)
+ * @param[in]       input     pointer to the CF input channels of the tap
+ * @param[in]       filter    pointer to the filter weight of the first input channel and the first output channel of the block
+ * @param[in]       CF        number of input channels of the filter
+ * @param[in]       COut      number of output channels of the filter, i.e. the stride between two input channels of the filter
+ * @param[in,out]   acc       pointer to the Q_SIMD_CONV_BLOCK accumulators
+ * @return          none
+ */
+void q7xq15_conv_tap_simd(const Q7_T* input, const Q15_T* filter, ITER_T CF,
+                          ITER_T COut, Q31_T* acc);
+void q15_conv_tap_simd(const Q15_T* input, const Q15_T* filter, ITER_T CF,
+                       ITER_T COut, Q63_T* acc);
+
+#endif
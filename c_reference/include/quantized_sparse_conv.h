@@ -0,0 +1,140 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#ifndef __QUANTIZED_SPARSE_CONV_H__
+#define __QUANTIZED_SPARSE_CONV_H__
+
+#include <stdio.h>
+#include "quantized_utils.h"
+
+/* Sparse convolution filters, for pruned 1x1 and depthwise convolutions
+   A filter of the dense layout F[G][HF][WF][CF][COut] is packed in CSR form, with one row per output channel (g * COut + c)
+   and one column per tap and input channel. The column index of a non-zero weight is (tap << Q_SPARSE_FILTER_TAP_SHIFT) | cf
+   with tap = hf * WF + wf, so that the kernels find the input element without any division.
+   A 1x1 filter has a single tap and its columns are the input channels, a depthwise filter (CF = COut = 1) has one column per tap.
+
+   The filters are packed once, offline or at initialization, with q15_sparse_filter_pack(). Filters denser than
+   Q_SPARSE_FILTER_DENSITY_THRESHOLD are kept dense and the sparse kernels run the dense ones on them, so that the sparse
+   kernels can be used for all the layers of a pruned model. Both paths are bit-exact, only the products with zero weights are skipped.
+*/
+
+#define ERR_SPARSE_FILTER_INVALID_PARAMS -1
+#define ERR_SPARSE_FILTER_FULL -2
+
+// Percentage of non-zero weights under which a filter is packed in CSR form. On the 30x40x32->64 pointwise convolution of
+// bench_kernels, the CSR kernel only gets ahead of the vectorized dense one (-O3 -DSIMD) at about 12% of non-zero weights,
+// and is twice as slow at 25%. The depthwise convolutions break even at about 30%
+#ifndef Q_SPARSE_FILTER_DENSITY_THRESHOLD
+  #define Q_SPARSE_FILTER_DENSITY_THRESHOLD 10
+#endif
+// Maximum number of taps (HF * WF) and input channels (CF) of a sparse filter
+#define Q_SPARSE_FILTER_MAX_TAPS 64
+#define Q_SPARSE_FILTER_TAP_SHIFT 16
+#define Q_SPARSE_FILTER_CHANNEL_MASK ((1 << Q_SPARSE_FILTER_TAP_SHIFT) - 1)
+
+/**
+ * @brief Convolution filter with its optional CSR form
+ * @var   dense       pointer to the filter in the dense layout [G][HF][WF][CF][COut]
+ * @var   row_ptr     pointer to the G * COut + 1 offsets of the rows in col_idx and values, NULL if the filter is kept dense
+ * @var   col_idx     pointer to the column indices of the non-zero weights, (tap << Q_SPARSE_FILTER_TAP_SHIFT) | cf
+ * @var   values      pointer to the non-zero weights
+ * @var   HF          number of rows of the filter
+ * @var   WF          number of columns of the filter
+ * @var   CF          number of channels of the filter
+ * @var   COut        number of output channels per group
+ * @var   G           number of groups
+ * @var   nnz         number of non-zero weights, also set for the dense filters
+ */
+typedef struct Q15_Sparse_Filter {
+  const Q15_T* dense;
+  const ITER_T* row_ptr;
+  const ITER_T* col_idx;
+  const Q15_T* values;
+  ITER_T HF, WF, CF, COut, G;
+  ITER_T nnz;
+} Q15_Sparse_Filter;
+
+/**
+ * @brief Packs a convolution filter, in CSR form if its density is below Q_SPARSE_FILTER_DENSITY_THRESHOLD
+ * @param[in]       filter       pointer to the dense filter [G][HF][WF][CF][COut], referenced by the packed filter
+ * @param[in]       HF           number of rows of the filter
+ * @param[in]       WF           number of columns of the filter
+ * @param[in]       CF           number of channels of the filter
+ * @param[in]       COut         number of output channels per group
+ * @param[in]       G            number of groups
+ * @param[out]      row_ptr      pointer to the storage of the G * COut + 1 row offsets
+ * @param[out]      col_idx      pointer to the storage of max_nnz column indices
+ * @param[out]      values       pointer to the storage of max_nnz weights
+ * @param[in]       max_nnz      size of the storage of the column indices and the weights
+ * @param[out]      packed       pointer to the packed filter. packed->nnz is set even on ERR_SPARSE_FILTER_FULL, hence a call with max_nnz = 0 sizes the storage
+ * @return          0 on success, ERR_SPARSE_FILTER_INVALID_PARAMS if the filter has more than Q_SPARSE_FILTER_MAX_TAPS taps or 2^16 channels, ERR_SPARSE_FILTER_FULL if the non-zero weights do not fit
+ * @example         filter       = {0, 3,
+ *                                  0, 0,
+ *                                  5, 0}  (1x1, CF = 3, COut = 2)
+ *                  row_ptr      = {0, 1, 2}
+ *                  col_idx      = {2, 0}
+ *                  values       = {5, 3}
+ */
+int q15_sparse_filter_pack(const Q15_T* const filter, ITER_T HF, ITER_T WF,
+  ITER_T CF, ITER_T COut, ITER_T G, ITER_T* const row_ptr,
+  ITER_T* const col_idx, Q15_T* const values, ITER_T max_nnz,
+  Q15_Sparse_Filter* const packed);
+
+/**
+ * @brief Writes a packed filter as C source, for compiling sparse filters into the model headers
+ * @brief The arrays are written as <name>_row_ptr, <name>_col_idx and <name>_values and the filter as <name>, referencing the dense filter dense_name
+ * @param[in]       file         stream to write to
+ * @param[in]       name         name of the packed filter
+ * @param[in]       dense_name   name of the dense filter array
+ * @param[in]       packed       pointer to the packed filter
+ * @return          0 on success, ERR_SPARSE_FILTER_INVALID_PARAMS on a write error
+ */
+int q15_sparse_filter_write(FILE* file, const char* name,
+  const char* dense_name, const Q15_Sparse_Filter* const packed);
+
+/**
+ * @brief Computes the convolution of the input tensor with a packed filter, skipping the zero weights of the sparse filters
+ * @brief The output is bit-exact with q7xq15_q7_convolution(), q7xq15_q15_convolution() and q15_convolution() on the dense filter
+ * @param[in]       input          pointer to the tensor on which convolution is to be performed
+ * @param[in]       filter         pointer to the packed filter, which holds HF, WF, CF, COut and G
+ * @param[out]      output         pointer to the output tensor
+ * @param[in]       N              number of batches of the input tensor
+ * @param[in]       H              number of rows of the input tensor
+ * @param[in]       W              number of columns of the input tensor
+ * @param[in]       CIn            number of channels of the input tensor
+ * @param[in]       HOut           number of rows of the output tensor
+ * @param[in]       WOut           number of columns of the output tensor
+ * @param[in]       HPadU          padding over the top row
+ * @param[in]       HPadD          padding under the bottom row
+ * @param[in]       WPadL          padding before the leftmost column
+ * @param[in]       WPadR          padding after the rightmost column
+ * @param[in]       HStride        stride of the convolution filter along the rows
+ * @param[in]       WStride        stride of the convolution filter along the columns
+ * @param[in]       HDilation      dilation of the convolution filter along the rows
+ * @param[in]       WDilation      dilation of the convolution filter along the columns
+ * @param[in]       scinput        scale of the input tensor
+ * @param[in]       scoutput       scale of the output tensor
+ * @param[in]       demote         scale factor for output variable demotion
+ * @return          none
+ * @example         Please refer the file: c_reference/tests/sparse_conv/test_quantized_sparse_conv.c
+ */
+void q7xq15_q7_sparse_convolution(const Q7_T* const input,
+  const Q15_Sparse_Filter* const filter, Q7_T* const output, ITER_T N,
+  ITER_T H, ITER_T W, ITER_T CIn, ITER_T HOut, ITER_T WOut, S_ITER_T HPadU,
+  S_ITER_T HPadD, S_ITER_T WPadL, S_ITER_T WPadR, ITER_T HStride,
+  ITER_T WStride, ITER_T HDilation, ITER_T WDilation, SCALE_T scinput,
+  SCALE_T scoutput, SCALE_T demote);
+void q7xq15_q15_sparse_convolution(const Q7_T* const input,
+  const Q15_Sparse_Filter* const filter, Q15_T* const output, ITER_T N,
+  ITER_T H, ITER_T W, ITER_T CIn, ITER_T HOut, ITER_T WOut, S_ITER_T HPadU,
+  S_ITER_T HPadD, S_ITER_T WPadL, S_ITER_T WPadR, ITER_T HStride,
+  ITER_T WStride, ITER_T HDilation, ITER_T WDilation, SCALE_T scinput,
+  SCALE_T scoutput, SCALE_T demote);
+void q15_sparse_convolution(const Q15_T* const input,
+  const Q15_Sparse_Filter* const filter, Q15_T* const output, ITER_T N,
+  ITER_T H, ITER_T W, ITER_T CIn, ITER_T HOut, ITER_T WOut, S_ITER_T HPadU,
+  S_ITER_T HPadD, S_ITER_T WPadL, S_ITER_T WPadR, ITER_T HStride,
+  ITER_T WStride, ITER_T HDilation, ITER_T WDilation, SCALE_T scinput,
+  SCALE_T scoutput, SCALE_T demote);
+
+#endif
@@ -127,6 +127,11 @@ void q7_v_hadamard(const Q7_T* vec1, const Q7_T* vec2, ITER_T len, Q7_T* ret,
                    SCALE_T scvec1, SCALE_T scvec2);
 void q15_v_hadamard(const Q15_T* vec1, const Q15_T* vec2, ITER_T len, Q15_T* ret,
                     SCALE_T scvec1, SCALE_T scvec2);
+// Values of the use_tables flag of q15_v_sigmoid() and q15_v_tanh()
+#define Q_ACTIVATION_HARD 0
+#define Q_ACTIVATION_EXP_TABLES 1
+#define Q_ACTIVATION_LUT 2
+
 /**
  * @brief Compute the element-wise Sigmoid activation on the input vector.
  * @param[in]       vec            pointer to the input vector
@@ -137,7 +142,7 @@ void q15_v_hadamard(const Q15_T* vec1, const Q15_T* vec2, ITER_T len, Q15_T* ret
  * @param[in]       sigmoid_limit  saturation limit for the Sigmoid activation
  * @param[in]       scale_in       scale factor of the input vector
  * @param[in]       scale_out      scale factor of the output vector
- * @param[in]       use_tables     flag for using pre-computed (base 16) exp tables for calculating Sigmoid on the input
+ * @param[in]       use_tables     Q_ACTIVATION_HARD for the hard Sigmoid, Q_ACTIVATION_EXP_TABLES for pre-computed (base 16) exp tables, Q_ACTIVATION_LUT for their interpolated table (see q15_v_sigmoid_lut())
  * @return          none
  * @example         formula        = saturate(0, (vec_{i} / div) + add, sigmoid_limit) * 2^{scale_out - scale_in} (use_tables set to 0)
  *                  vec            = {-2772, -1358, -3028, -389, -1666, -2070, -608, -699}
@@ -160,7 +165,7 @@ void q15_v_sigmoid(const Q15_T* vec, ITER_T len, Q15_T* ret, Q15_T div,
  * @param[out]      ret            pointer to the vector storing the output
  * @param[in]       scale_in       scale factor of the input vector
  * @param[in]       scale_out      scale factor of the output vector
- * @param[in]       use_tables     flag for using pre-computed (base 16) exp tables for calculating TanH on the input
+ * @param[in]       use_tables     Q_ACTIVATION_HARD for the hard TanH, Q_ACTIVATION_EXP_TABLES for pre-computed (base 16) exp tables, Q_ACTIVATION_LUT for their interpolated table (see q15_v_tanh_lut())
  * @return          none
  * @example         formula        = saturate(-2^{scale_in}, vec_{i}, 2^{scale_in}) * 2^{scale_out - scale_in} (use_tables set to 0)
  *                  vec            = {178, 1064, -4162, 1718, -1663, 851, 1244, 1282}
@@ -172,6 +177,32 @@ void q15_v_sigmoid(const Q15_T* vec, ITER_T len, Q15_T* ret, Q15_T div,
  */
 void q15_v_tanh(const Q15_T* vec, ITER_T len, Q15_T* ret, SCALE_T scale_in,
                 SCALE_T scale_out, ITER_T use_tables);
+/**
+ * @brief Compute the element-wise Sigmoid activation with a linearly interpolated table, without any division.
+ * @brief Approximates q15_v_sigmoid() with use_tables = Q_ACTIVATION_EXP_TABLES within 2 (output scale 2^14).
+ * @brief With -DSIMD, the lookups are gathered with AVX2, about 4 times faster than the exp tables. The scalar code is about as fast as them.
+ * @param[in]       vec            pointer to the input vector
+ * @param[in]       len            length of the input vector
+ * @param[out]      ret            pointer to the vector storing the output
+ * @return          none
+ * @example         vec            = {-2772, -1358, -3028, -389, -1666, -2070, -608, -699}
+ *                  len            = 8
+ *                  ret            = {3363, 5571, 3042, 7416, 5032, 4371, 6985, 6807}
+ */
+void q15_v_sigmoid_lut(const Q15_T* vec, ITER_T len, Q15_T* ret);
+/**
+ * @brief Compute the element-wise TanHyperbolic activation with a linearly interpolated table, without any division.
+ * @brief Approximates q15_v_tanh() with use_tables = Q_ACTIVATION_EXP_TABLES within 3 (output scale 2^14).
+ * @brief Vectorized as q15_v_sigmoid_lut().
+ * @param[in]       vec            pointer to the input vector
+ * @param[in]       len            length of the input vector
+ * @param[out]      ret            pointer to the vector storing the output
+ * @return          none
+ * @example         vec            = {178, 1064, -4162, 1718, -1663, 853, 1244, 1282}
+ *                  len            = 8
+ *                  ret            = {1420, 7821, -15830, 11226, -10989, 6454, 8884, 9097}
+ */
+void q15_v_tanh_lut(const Q15_T* vec, ITER_T len, Q15_T* ret);
 /**
  * @brief Compute the addition of a scalar to every element of a vector.
  * @param[in]       scalar    the input scalar to be added to a vector
@@ -304,6 +335,31 @@ void q15xq7_q15_m_mulvec(const Q15_T* mat, const Q7_T* const vec, ITER_T nrows,
 void q15_m_mulvec(const Q15_T* mat, const Q15_T* const vec, ITER_T nrows,
                   ITER_T ncols, Q15_T* ret, SCALE_T scmat, SCALE_T scvec,
                   SCALE_T H1, SCALE_T H2);
+/**
+ * @brief Multiplies a matrix with a batch of vectors. Each output is bit-exact with q15xq7_q15_m_mulvec() / q15_m_mulvec() on the
+ * corresponding vector, but a row of the matrix is loaded once for the whole batch.
+ * dim(mat) = [nrows][ncols]; dim(vecs) = [nvecs][ncols]; dim(ret) = [nvecs][nrows].
+ * @param[in]       mat       pointer to input matrix in row-major order
+ * @param[in]       vecs      pointer to the input vectors, stored one after the other
+ * @param[in]       nrows     number of rows of the input matrix
+ * @param[in]       ncols     number of columns of the input matrix
+ * @param[in]       nvecs     number of input vectors
+ * @param[out]      ret       pointer to the output vectors, stored one after the other
+ * @param[in]       scmat     scale factor of the input matrix
+ * @param[in]       scvec     scale factor of the input vectors
+ * @param[in]       H1        depth parameter for division-by-two used in TreeSum
+ * @param[in]       H2        depth parameter for direct sum used in TreeSum
+ * @return          none
+ * @example         Please refer the test-case: test_quantized_fastgrnn_batch() in file: c_reference/tests/fastgrnn/test_quantized_fastgrnn.c
+ */
+void q15xq7_q15_m_mulvec_batch(const Q15_T* const mat, const Q7_T* const vecs,
+                               ITER_T nrows, ITER_T ncols, ITER_T nvecs,
+                               Q15_T* const ret, SCALE_T scmat, SCALE_T scvec,
+                               SCALE_T H1, SCALE_T H2);
+void q15_m_mulvec_batch(const Q15_T* const mat, const Q15_T* const vecs,
+                        ITER_T nrows, ITER_T ncols, ITER_T nvecs,
+                        Q15_T* const ret, SCALE_T scmat, SCALE_T scvec,
+                        SCALE_T H1, SCALE_T H2);
 /**
  * @brief Performs sparse matrix multiplication of a matrix and a vector.
  * row_indices and mat_values combined are a sparse representation; dim(vec) = [ncols].
@@ -482,8 +538,14 @@ void q15_t_l2_norm(const Q15_T* ten, ITER_T nbatches, ITER_T nrows,
                    ITER_T ncols, ITER_T nchannels, Q15_T* ret,
                    SCALE_T scale_in, SCALE_T scale_out);
 
+// Output channels per tile of the specialized pointwise and depthwise convolution kernels
+#define Q_CONV_TILE 16
+// Largest depthwise filter, in taps (HF * WF), run by the specialized depthwise kernel
+#define Q_CONV_DEPTHWISE_MAX_TAPS 49
+
 /**
  * @brief Computes the maxpool operation on the input tensor with the given parameters.
+ * @brief 1x1 convolutions with a single group and no padding, and depthwise convolutions (CF = COut = 1) of up to Q_CONV_DEPTHWISE_MAX_TAPS taps, are dispatched to specialized kernels with the same output
  * @param[in]       input          pointer to the tensor on which convolution is to be performed
  * @param[in]       filter         pointer to the convolutional filter tensor
  * @param[out]      output         pointer to the output tensor
@@ -46,6 +46,8 @@
  * @var   block_size_w_from_lr   block/tile size for the cache. Used for tiled MatMul. For W2 * result(W1 * x) 
  * @var   block_size_u_to_lr     block/tile size for the cache. Used for tiled MatMul. For U1 * h
  * @var   block_size_u_from_lr   block/tile size for the cache. Used for tiled MatMul. For U2 * result(U1 * h)
+ * @var   num_threads            number of threads. The Wx computation is split into num_threads ranges of time steps and the recurrence into num_threads ranges of bricks
+ *                               0 or 1 runs on the calling thread. Threads are only created if compiled with MULTITHREADED. The result does not depend on the number of threads
  */
 typedef struct BrickedFastGRNN_LR_Params {
   float* W1; 
@@ -62,6 +64,7 @@ typedef struct BrickedFastGRNN_LR_Params {
   unsigned block_size_w_from_lr;
   unsigned block_size_u_to_lr;
   unsigned block_size_u_from_lr;
+  unsigned num_threads;
 } BrickedFastGRNN_LR_Params;
 
 /** Forward Bricking and application of the forward RNN for an input signal
@@ -5,6 +5,8 @@
 #define __RNNPOOL_H__
 
 typedef int (*rnn_t)(float* const, unsigned, const float* const, unsigned, unsigned, const void*, void*, int, int);
+// Single step of a batch of cells, e.g. fastgrnn_batch()
+typedef int (*rnn_batch_t)(float* const, unsigned, const float* const, unsigned, unsigned, unsigned, const void*, void*, int);
 
 /**
  * @param[in]        patch          pointer to activation of patch (row, col, channel)
@@ -15,6 +17,9 @@ typedef int (*rnn_t)(float* const, unsigned, const float* const, unsigned, unsig
  * @param[in]        hiddenDims1    dimension of the hidden state of RNN1
  * @param[in]        rnn1_params    pointer to parameters of RNN1
  * @param[in]        rnn1_buffers   pointer to buffers needed for RNN1
+ * @param[in]        rnn1_batch     function pointer to the batched RNN1 cell. The horizontal pass advances all the rows at once,
+ *                                  and the vertical pass all the columns at once. Pass NULL to run both passes one sequence at a time with rnn1
+ * @param[in]        rnn1_batch_buffers  pointer to buffers needed for the batched RNN1 cell, sized for a batch of patchDim cells
  * @param[in]        rnn2           function pointer to RNN2
  * @param[in]        hiddenDims2    dimension of the hidden state of RNN2
  * @param[in]        rnn2_params    pointer to parameters of RNN2
@@ -25,6 +30,7 @@ typedef int (*rnn_t)(float* const, unsigned, const float* const, unsigned, unsig
 int rnnpool_block(const float* const patch, unsigned inputDims,
   unsigned patchDim, unsigned stride,
   rnn_t rnn1, unsigned hiddenDims1, const void* rnn1_params, void* rnn1_buffers,
+  rnn_batch_t rnn1_batch, void* rnn1_batch_buffers,
   rnn_t rnn2, unsigned hiddenDims2, const void* rnn2_params, void* rnn2_buffers,
   float* const output, float* const buffer);
 
@@ -109,6 +109,41 @@ void transposed_tiledMatMul(const float* const matA, const float* const matB,
   unsigned total_comm_A, unsigned total_comm_B,
   float* const ret, unsigned block_size);
 
+// Register block (micro-kernel) dimensions used by packed_tiledMatMul
+#define PACKED_MATMUL_ROWS 4
+#define PACKED_MATMUL_COLS 8
+
+/*
+  Pack the transposed second matrix of a MatMul into column panels for packed_tiledMatMul
+  Each panel holds PACKED_MATMUL_COLS consecutive columns of the product, interleaved along the ncommon axis
+  i.e. packed[panel][comm][0 : PACKED_MATMUL_COLS]. The last panel is zero padded
+  matB           matrix to be packed; shape = [ncols, ncommon] (same as the matB of transposed_tiledMatMul)
+  ncols          number of rows of matB/number of columns of the MatMul output
+  ncommon        number of columns of matB
+  total_comm_B   The actual offset factor between 2 rows for matB
+  packed         packed output. size = ceil(ncols / PACKED_MATMUL_COLS) * PACKED_MATMUL_COLS * ncommon
+*/
+void pack_transposed_matB(const float* const matB, unsigned ncols, unsigned ncommon,
+  unsigned total_comm_B, float* const packed);
+
+/*
+  Register and cache blocked MatMul with a pre-packed transposed second matrix. Computes the same result as transposed_tiledMatMul with the same block_size
+  The sum of each block along the ncommon axis is added to ret separately. Hence the result only matches an unblocked dot product if block_size = 0 or block_size >= ncommon
+  The output is computed in PACKED_MATMUL_ROWS x PACKED_MATMUL_COLS blocks held in registers, which the compiler can vectorize
+  This MatMul adds the result on the pre-existing values in ret. Hence either a zero initialized or a pre-existing mat is needed
+  matA           first matrix; shape = [nrows, ncommon]
+  packedB        second matrix packed by pack_transposed_matB
+  nrows          number of rows in the first matrix
+  ncommon        number of columns in the first matrix/number of rows in the second matrix
+  ncols          number of columns in the second matrix
+  total_comm_A   The actual offset factor between 2 rows for matA
+  ret            matrix multiplication output. shape = [nrows, ncols]
+  block_size     block size along the ncommon axis, for keeping the panels in the cache. A hardware specific parameter. Pass 0 for no blocking
+*/
+void packed_tiledMatMul(const float* const matA, const float* const packedB,
+  unsigned nrows, unsigned ncommon, unsigned ncols,
+  unsigned total_comm_A, float* const ret, unsigned block_size);
+
 // scaled vector addition: ret = scalar1 * vec1 + scalar2 * vector2
 void v_add(float scalar1, const float* const vec1,
   float scalar2, const float* const vec2,
@@ -20,7 +20,28 @@
 #include "q_scut_head_b_face3_model/mbconv4.h"
 #include "q_scut_head_b_face3_model/detection3.h"
 
-void q_face_detection_fast(char* const mem_buf) {
+#include "quantized_face_detection_workers.h"
+
+// RNNPool buffers of the first worker. The other workers, and the MBConv bands
+// after the first, use the scratch buffer of the caller
+static Q15_T worker_buffers[FACE_DETECTION_WORKER_SIZE(INPUT_CHANNELS, PATCH_DIM, HIDDEN_DIM1, HIDDEN_DIM2)];
+
+static const Face_Detection_Workers WORKERS = {
+  .buffers = worker_buffers,
+  .rnn1_model_buffers = (void*)(&RNN1_BUFFERS),
+  .rnn2_model_buffers = (void*)(&RNN2_BUFFERS),
+  .input_channels = INPUT_CHANNELS,
+  .patch_dim = PATCH_DIM,
+  .hidden_dim1 = HIDDEN_DIM1,
+  .hidden_dim2 = HIDDEN_DIM2
+};
+
+// Grid of the RNNPool patches over the output of the Conv2D sub-pipeline
+#define RNNPOOL_PATCHES_X 14
+#define RNNPOOL_PATCHES_Y 19
+#define RNNPOOL_PATCH_STRIDE 8
+
+static void q_face_detection_fast_conv2d(char* const mem_buf) {
   // Conv2D Sub-Pipeline
   q7xq15_q7_convolution((Q7_T*)mem_buf, CBR1F, (Q7_T*)(mem_buf + 76800),
     CONV2D_N, CBR1F_H, CBR1F_W, CBR1F_CIN, CBR1F_HF, CBR1F_WF, CBR1F_CF,
@@ -40,30 +61,38 @@ void q_face_detection_fast(char* const mem_buf) {
 
   q7_t_relu((Q7_T*)mem_buf, CONV2D_N, CONV2D_HOUT, CONV2D_WOUT, CONV2D_COUT,
     (Q7_T*)(mem_buf + 76800), CONV2D_Limit, CONV2D_Div);
+}
 
-  Q7_T* mem_buf_offset_q7 = (Q7_T*)mem_buf;
-  Q15_T* mem_buf_offset_q15 = (Q15_T*)mem_buf;
-
+// Computes the patches with a non-zero flag in mask, or all of them if mask is NULL
+static void q_face_detection_fast_rnnpool(char* const mem_buf,
+  char* const scratch_buf, const unsigned char* mask, unsigned first_worker,
+  unsigned num_workers) {
   // RNNPool Sub-Pipeline
   memset(mem_buf, 0, sizeof(Q7_T) * 19200);
   memset((mem_buf + 19200), 0, sizeof(Q15_T));
   memset((mem_buf + 19202), 0, sizeof(Q15_T));
 
-  for (ITER_T patchX = 0; patchX < 14; patchX++) {
-    for (ITER_T patchY = 0; patchY < 19; patchY++) {
-      q7xq15_q15_rnnpool_block((Q7_T*)(mem_buf + 76800 + ((5120 * patchX) + (32 * patchY))),
-        INPUT_CHANNELS, PATCH_DIM, CONV2D_WOUT, q7xq15_q15_fastgrnn, HIDDEN_DIM1,
-        (const void*)(&RNN1_PARAMS), (void*)(&RNN1_BUFFERS),
-        (const void*)(&RNN1_SCALES), q15_fastgrnn, HIDDEN_DIM2,
-        (const void*)(&RNN2_PARAMS), (void*)(&RNN2_BUFFERS),
-        (const void*)(&RNN2_SCALES), (Q15_T*)(mem_buf + 19204),
-        (Q15_T*)(mem_buf + 21252), ShR1, ShL1, ShR2, ShL2);
-
-      for (ITER_T i = 0; i < 64; i++) {
-        mem_buf_offset_q7[patchX * 1280 + patchY * 64 + i] = (Q7_T)(mem_buf_offset_q15[9602 + i]);
-      }
-    }
-  }
+  // The patches are split over the workers, each with its own RNN buffers
+  Q_RNNPool_Worker_Buffers workers[FACE_DETECTION_MAX_THREADS];
+  Face_Detection_RNN_Buffers rnn_buffers[FACE_DETECTION_MAX_THREADS];
+  face_detection_workers(workers, rnn_buffers, &WORKERS, scratch_buf,
+    first_worker, num_workers, (Q15_T*)(mem_buf + 19204),
+    (Q15_T*)(mem_buf + 21252));
+  q7xq15_q15_rnnpool_patches((const Q7_T*)(mem_buf + 76800), INPUT_CHANNELS,
+    PATCH_DIM, CONV2D_WOUT, RNNPOOL_PATCHES_X, RNNPOOL_PATCHES_Y,
+    RNNPOOL_PATCH_STRIDE * CONV2D_WOUT * INPUT_CHANNELS,
+    RNNPOOL_PATCH_STRIDE * INPUT_CHANNELS, q7xq15_q15_fastgrnn, HIDDEN_DIM1,
+    (const void*)(&RNN1_PARAMS), (const void*)(&RNN1_SCALES),
+    q7xq15_q15_fastgrnn_batch, q15_fastgrnn, HIDDEN_DIM2,
+    (const void*)(&RNN2_PARAMS), (const void*)(&RNN2_SCALES),
+    (Q7_T*)mem_buf, 1280, ShR1, ShL1, ShR2, ShL2, mask, workers,
+    num_workers);
+}
+
+static void q_face_detection_fast_mbconv(char* const mem_buf,
+  char* const scratch_buf, unsigned num_workers) {
+  Q7_T* mem_buf_offset_q7 = (Q7_T*)mem_buf;
+  Q15_T* mem_buf_offset_q15 = (Q15_T*)mem_buf;
 
   memcpy(&mem_buf_offset_q7[14 * 1280], &mem_buf_offset_q7[13 * 1280],
          19 * 64 * sizeof(Q7_T));
@@ -74,13 +103,14 @@ void q_face_detection_fast(char* const mem_buf) {
 
   // MBConv Sub-Pipeline
   // MBConv Layer 1
-  q7xq15_q15_mbconv_block((Q7_T*)mem_buf, L1_F1, L1_W1, L1_B1, L1_F2, L1_W2,
+  q7xq15_q15_mbconv_block_threaded((Q7_T*)mem_buf, L1_F1, L1_W1, L1_B1, L1_F2, L1_W2,
     L1_B2, L1_F3, L1_W3, L1_B3, (Q15_T*)(mem_buf + 19200),
     (Q15_T*)(mem_buf + 38400), (Q15_T*)(mem_buf + 54272), L1_N, L1_H, L1_W,
     L1_CIN, L1_CTEMP, L1_HF, L1_WF, L1_COUT, L1_HOUT, L1_WOUT, L1_HPADL,
     L1_HPADR, L1_WPADL, L1_WPADR, L1_HSTRIDE, L1_WSTRIDE, L1_Limit1, L1_Limit2,
     L1_ShRU1, L1_ShRX1, L1_ShRU2, L1_ShRX2, L1_ShRU3, L1_ShRW3, L1_ShLU1,
-    L1_ShLX1, L1_ShLU2, L1_ShLX2, L1_ShLU3, L1_ShLW3);
+    L1_ShLX1, L1_ShLU2, L1_ShLX2, L1_ShLU3, L1_ShLW3, scratch_buf,
+    (num_workers - 1) * FACE_DETECTION_BAND_BUFFERS_SIZE, num_workers);
 
   // Detection Layer 1 Sub-Pipeline
   q15_t_l2_norm((Q15_T*)(mem_buf + 19200), L1_N, L1_HOUT, L1_WOUT, L1_COUT,
@@ -129,13 +159,14 @@ void q_face_detection_fast(char* const mem_buf) {
   }
 
   // MBConv Layer 2
-  q15_mbconv_block((Q15_T*)(mem_buf + 19200), L2_F1, L2_W1, L2_B1, L2_F2,
+  q15_mbconv_block_threaded((Q15_T*)(mem_buf + 19200), L2_F1, L2_W1, L2_B1, L2_F2,
     L2_W2, L2_B2, L2_F3, L2_W3, L2_B3, (Q15_T*)(mem_buf + 38400),
     (Q15_T*)(mem_buf + 6000), (Q15_T*)(mem_buf + 256), L2_N, L2_H, L2_W,
     L2_CIN, L2_CTEMP, L2_HF, L2_WF, L2_COUT, L2_HOUT, L2_WOUT, L2_HPADL,
     L2_HPADR, L2_WPADL, L2_WPADR, L2_HSTRIDE, L2_WSTRIDE, L2_Limit1, L2_Limit2,
     L2_ShRU1, L2_ShRX1, L2_ShRU2, L2_ShRX2, L2_ShRU3, L2_ShRW3, L2_ShLU1,
-    L2_ShLX1, L2_ShLU2, L2_ShLX2, L2_ShLU3, L2_ShLW3);
+    L2_ShLX1, L2_ShLU2, L2_ShLX2, L2_ShLU3, L2_ShLW3, scratch_buf,
+    (num_workers - 1) * FACE_DETECTION_BAND_BUFFERS_SIZE, num_workers);
 
   // Detection Layer 2 Sub-Pipeline
   q15_t_l2_norm((Q15_T*)(mem_buf + 38400), L2_N, L2_HOUT, L2_WOUT, L2_COUT,
@@ -166,26 +197,28 @@ void q_face_detection_fast(char* const mem_buf) {
     D2LW_COUT, (Q15_T*)(mem_buf + 6000), D2LB_Scten, D2LB_Scvec, D2LB_Scret);
 
   // MBConv Layer 3
-  q15xq7_q15_mbconv_block((Q15_T*)(mem_buf + 38400), L3_F1, L3_W1, L3_B1,
+  q15xq7_q15_mbconv_block_threaded((Q15_T*)(mem_buf + 38400), L3_F1, L3_W1, L3_B1,
     L3_F2, L3_W2, L3_B2, L3_F3, L3_W3, L3_B3, (Q15_T*)(mem_buf + 96000),
     (Q15_T*)(mem_buf + 8400), (Q15_T*)(mem_buf + 1968), L3_N, L3_H, L3_W,
     L3_CIN, L3_CTEMP, L3_HF, L3_WF, L3_COUT, L3_HOUT, L3_WOUT, L3_HPADL,
     L3_HPADR, L3_WPADL, L3_WPADR, L3_HSTRIDE, L3_WSTRIDE, L3_Limit1, L3_Limit2,
     L3_ShRU1, L3_ShRX1, L3_ShRU2, L3_ShRX2, L3_ShRU3, L3_ShRW3, L3_ShLU1,
-    L3_ShLX1, L3_ShLU2, L3_ShLX2, L3_ShLU3, L3_ShLW3);
+    L3_ShLX1, L3_ShLU2, L3_ShLX2, L3_ShLU3, L3_ShLW3, scratch_buf,
+    (num_workers - 1) * FACE_DETECTION_BAND_BUFFERS_SIZE, num_workers);
 
   // MBConv2 + MBConv3
   q15_t_add((Q15_T*)(mem_buf + 38400), (Q15_T*)(mem_buf + 96000), L3_N, L3_HOUT,
     L3_WOUT, L3_COUT, (Q15_T*)(mem_buf + 8400), L3_Scten1, L3_Scten2, L3_Scret);
 
   // MBConv Layer 4
-  q15xq7_q15_mbconv_block((Q15_T*)(mem_buf + 8400), L4_F1, L4_W1, L4_B1, L4_F2,
+  q15xq7_q15_mbconv_block_threaded((Q15_T*)(mem_buf + 8400), L4_F1, L4_W1, L4_B1, L4_F2,
     L4_W2, L4_B2, L4_F3, L4_W3, L4_B3, (Q15_T*)(mem_buf + 66000),
     (Q15_T*)(mem_buf + 142800), (Q15_T*)(mem_buf + 1968), L4_N, L4_H, L4_W,
     L4_CIN, L4_CTEMP, L4_HF, L4_WF, L4_COUT, L4_HOUT, L4_WOUT, L4_HPADL,
     L4_HPADR, L4_WPADL, L4_WPADR, L4_HSTRIDE, L4_WSTRIDE, L4_Limit1, L4_Limit2,
     L4_ShRU1, L4_ShRX1, L4_ShRU2, L4_ShRX2, L4_ShRU3, L4_ShRW3, L4_ShLU1,
-    L4_ShLX1, L4_ShLU2, L4_ShLX2, L4_ShLU3, L4_ShLW3);
+    L4_ShLX1, L4_ShLU2, L4_ShLX2, L4_ShLU3, L4_ShLW3, scratch_buf,
+    (num_workers - 1) * FACE_DETECTION_BAND_BUFFERS_SIZE, num_workers);
 
   // Detection Layer 3 Sub-Pipeline
   q15_t_l2_norm((Q15_T*)(mem_buf + 66000), L4_N, L4_HOUT, L4_WOUT, L4_COUT,
@@ -231,3 +264,267 @@ void q_face_detection_fast(char* const mem_buf) {
     mem_buf_offset_q15[5400 + (i + 4200)] = (mem_buf_offset_q15[4200 + i] / 2);
   }
 }
+
+static void q_face_detection_fast_frame(char* const mem_buf,
+  char* const scratch_buf, unsigned first_worker, unsigned num_threads) {
+  unsigned num_workers = face_detection_num_workers(first_worker, num_threads);
+  q_face_detection_fast_conv2d(mem_buf);
+  q_face_detection_fast_rnnpool(mem_buf, scratch_buf, NULL, first_worker,
+    num_workers);
+  q_face_detection_fast_mbconv(mem_buf, scratch_buf, num_workers);
+}
+
+unsigned q_face_detection_fast_scratch_size(unsigned num_threads) {
+  return FACE_DETECTION_SCRATCH_SIZE(face_detection_num_workers(0, num_threads),
+    INPUT_CHANNELS, PATCH_DIM, HIDDEN_DIM1, HIDDEN_DIM2);
+}
+
+void q_face_detection_fast_threaded(char* const mem_buf, char* const scratch_buf,
+  unsigned num_threads) {
+  q_face_detection_fast_frame(mem_buf, scratch_buf, 0, num_threads);
+}
+
+void q_face_detection_fast_batch(char* const mem_buf, char* const scratch_buf,
+  unsigned num_frames, unsigned num_threads) {
+  face_detection_batch(q_face_detection_fast_frame, mem_buf, scratch_buf,
+    FACE_DETECTION_FAST_MEM_BUF_SIZE, num_frames, num_threads);
+}
+
+// Side of the square blocks of the input image compared against the reference
+#define STREAM_BLOCK 8
+#define STREAM_BLOCKS_H ((CBR1F_H + STREAM_BLOCK - 1) / STREAM_BLOCK)
+#define STREAM_BLOCKS_W ((CBR1F_W + STREAM_BLOCK - 1) / STREAM_BLOCK)
+
+// Range [*in_lo, *in_hi) of the input rows (or columns) of a convolution read
+// by the output rows (or columns) [lo, hi)
+static void receptive_field(ITER_T lo, ITER_T hi, ITER_T F, ITER_T stride,
+  S_ITER_T pad, ITER_T dilation, ITER_T size, ITER_T* in_lo, ITER_T* in_hi) {
+  S_ITER_T first = (S_ITER_T)(lo * stride) - pad;
+  S_ITER_T last = (S_ITER_T)((hi - 1) * stride) - pad +
+                  (S_ITER_T)(dilation * (F - 1));
+  *in_lo = first < 0 ? 0 : (ITER_T)first;
+  *in_hi = last >= (S_ITER_T)size ? size : (ITER_T)(last + 1);
+}
+
+// Range [*out_lo, *out_hi) of the output rows of a convolution reading any of
+// the input rows [lo, hi), for an output of out_size rows. Empty if out_lo >= out_hi
+static void dependent_rows(ITER_T lo, ITER_T hi, ITER_T F, ITER_T stride,
+  S_ITER_T pad, ITER_T dilation, ITER_T out_size, ITER_T* out_lo,
+  ITER_T* out_hi) {
+  S_ITER_T first = (S_ITER_T)lo + pad - (S_ITER_T)(dilation * (F - 1));
+  S_ITER_T last = (S_ITER_T)(hi - 1) + pad;
+  *out_lo = first <= 0 ? 0 : (ITER_T)((first + stride - 1) / stride);
+  *out_hi = last < 0 ? 0 : (ITER_T)(last / stride + 1);
+  *out_hi = *out_hi < out_size ? *out_hi : out_size;
+}
+
+// End of the rows (or columns) of block b of an image of the given size
+static ITER_T block_end(ITER_T b, ITER_T size) {
+  return (b + 1) * STREAM_BLOCK < size ? (b + 1) * STREAM_BLOCK : size;
+}
+
+// Conv2D sub-pipeline on the output rows [hout_begin, hout_end) only. The first
+// convolution runs on the input rows under its filters, with the padding of
+// the band. The second one has to be pointwise. The other rows of the output
+// are left as they are
+static void q_face_detection_fast_conv2d_rows(char* const mem_buf,
+  ITER_T hout_begin, ITER_T hout_end) {
+  if (hout_begin >= hout_end) {
+    return;
+  }
+  S_ITER_T lo = (S_ITER_T)(hout_begin * CBR1F_HSTRIDE) - CBR1F_HPADL;
+  S_ITER_T hi = (S_ITER_T)((hout_end - 1) * CBR1F_HSTRIDE +
+                CBR1F_HDILATION * (CBR1F_HF - 1) + 1) - CBR1F_HPADL;
+  ITER_T top = lo > 0 ? (ITER_T)lo : 0;
+  ITER_T bottom = hi < (S_ITER_T)CBR1F_H ? (ITER_T)hi : CBR1F_H;
+  ITER_T rows = hout_end - hout_begin;
+  Q7_T* conv_output = (Q7_T*)(mem_buf + 76800) +
+                      hout_begin * CONV2D_WOUT * CONV2D_COUT;
+  Q7_T* temp = (Q7_T*)mem_buf + hout_begin * CONV2D_WOUT * CONV2D_COUT;
+
+  q7xq15_q7_convolution((Q7_T*)mem_buf + top * CBR1F_W * CBR1F_CIN, CBR1F,
+    conv_output, 1, bottom - top, CBR1F_W, CBR1F_CIN, CBR1F_HF, CBR1F_WF,
+    CBR1F_CF, CONV2D_COUT, rows, CONV2D_WOUT, CBR1F_G, (S_ITER_T)top - lo,
+    hi - (S_ITER_T)bottom, CBR1F_WPADL, CBR1F_WPADR, CBR1F_HSTRIDE,
+    CBR1F_WSTRIDE, CBR1F_HDILATION, CBR1F_WDILATION, CBR1F_Scinput,
+    CBR1F_Scoutput, CBR1F_Demote);
+
+  q7xq15_q7_t_add_vec(conv_output, CBR1B, 1, rows, CONV2D_WOUT, CONV2D_COUT,
+    temp, CBR1B_Scten, CBR1B_Scvec, CBR1B_Scret);
+
+  q7xq15_q7_convolution(temp, CBR1W, temp, 1, rows, CONV2D_WOUT, CONV2D_COUT,
+    CBR1W_HF, CBR1W_WF, CBR1W_CF, CBR1W_COUT, rows, CONV2D_WOUT, CBR1W_G,
+    CBR1W_HPADL, CBR1W_HPADR, CBR1W_WPADL, CBR1W_WPADR, CBR1W_HSTRIDE,
+    CBR1W_WSTRIDE, CBR1W_HDILATION, CBR1W_WDILATION, CBR1W_Scinput,
+    CBR1W_Scoutput, CBR1W_Demote);
+
+  q7_t_relu(temp, 1, rows, CONV2D_WOUT, CONV2D_COUT, conv_output,
+    CONV2D_Limit, CONV2D_Div);
+}
+
+void q_face_detection_fast_stream_init(Q_Face_Detection_Fast_Stream* stream) {
+  stream->valid = 0;
+  stream->frames = 0;
+  stream->conv2d_rows_computed = 0;
+  stream->conv2d_rows_total = 0;
+  stream->patches_computed = 0;
+  stream->patches_total = 0;
+}
+
+unsigned q_face_detection_fast_stream(char* const mem_buf,
+  char* const scratch_buf, Q_Face_Detection_Fast_Stream* stream,
+  Q7_T threshold, unsigned num_threads) {
+  const Q7_T* input = (const Q7_T*)mem_buf;
+  unsigned char changed[STREAM_BLOCKS_H][STREAM_BLOCKS_W];
+  unsigned char mask[RNNPOOL_PATCHES_X * RNNPOOL_PATCHES_Y];
+
+  // Flag the blocks of the input which moved away from the reference
+  for (ITER_T bh = 0; bh < STREAM_BLOCKS_H; bh++) {
+    for (ITER_T bw = 0; bw < STREAM_BLOCKS_W; bw++) {
+      ITER_T h_end = block_end(bh, CBR1F_H), w_end = block_end(bw, CBR1F_W);
+      changed[bh][bw] = !stream->valid;
+      for (ITER_T h = bh * STREAM_BLOCK; h < h_end && !changed[bh][bw]; h++) {
+        for (ITER_T w = bw * STREAM_BLOCK; w < w_end; w++) {
+          ITER_T i = h * CBR1F_W + w;
+          Q15_T diff = (Q15_T)input[i] - (Q15_T)stream->reference[i];
+          if (diff > threshold || diff < -threshold) {
+            changed[bh][bw] = 1;
+            break;
+          }
+        }
+      }
+    }
+  }
+
+  // The second convolution of the Conv2D sub-pipeline runs in place. Unless it
+  // is pointwise, its outputs depend on all the previous rows, hence any change
+  // recomputes all the patches and the whole Conv2D output. Else only the
+  // output rows under a changed block are recomputed, in a single band as the
+  // intermediate values of the band overwrite the input image
+  unsigned char pointwise = CBR1W_HF == 1 && CBR1W_WF == 1 &&
+    CONV2D_HOUT * CONV2D_WOUT * CONV2D_COUT <= FACE_DETECTION_FAST_CONV2D_SIZE;
+  unsigned char any_changed = 0;
+  ITER_T conv_begin = CONV2D_HOUT, conv_end = 0;
+  for (ITER_T bh = 0; bh < STREAM_BLOCKS_H; bh++) {
+    unsigned char row_changed = 0;
+    for (ITER_T bw = 0; bw < STREAM_BLOCKS_W; bw++) {
+      row_changed |= changed[bh][bw];
+    }
+    if (row_changed) {
+      ITER_T lo, hi;
+      dependent_rows(bh * STREAM_BLOCK, block_end(bh, CBR1F_H), CBR1F_HF,
+        CBR1F_HSTRIDE, CBR1F_HPADL, CBR1F_HDILATION, CONV2D_HOUT, &lo, &hi);
+      conv_begin = lo < conv_begin ? lo : conv_begin;
+      conv_end = hi > conv_end ? hi : conv_end;
+    }
+    any_changed |= row_changed && !pointwise;
+  }
+  if (conv_begin > conv_end) {
+    conv_begin = conv_end;
+  }
+
+  // A patch is recomputed if any block of its receptive field has changed
+  unsigned num_computed = 0;
+  for (ITER_T x = 0; x < RNNPOOL_PATCHES_X; x++) {
+    for (ITER_T y = 0; y < RNNPOOL_PATCHES_Y; y++) {
+      ITER_T h_lo, h_hi, w_lo, w_hi;
+      receptive_field(x * RNNPOOL_PATCH_STRIDE,
+        x * RNNPOOL_PATCH_STRIDE + PATCH_DIM, CBR1W_HF, CBR1W_HSTRIDE,
+        CBR1W_HPADL, CBR1W_HDILATION, CONV2D_HOUT, &h_lo, &h_hi);
+      receptive_field(h_lo, h_hi, CBR1F_HF, CBR1F_HSTRIDE, CBR1F_HPADL,
+        CBR1F_HDILATION, CBR1F_H, &h_lo, &h_hi);
+      receptive_field(y * RNNPOOL_PATCH_STRIDE,
+        y * RNNPOOL_PATCH_STRIDE + PATCH_DIM, CBR1W_WF, CBR1W_WSTRIDE,
+        CBR1W_WPADL, CBR1W_WDILATION, CONV2D_WOUT, &w_lo, &w_hi);
+      receptive_field(w_lo, w_hi, CBR1F_WF, CBR1F_WSTRIDE, CBR1F_WPADL,
+        CBR1F_WDILATION, CBR1F_W, &w_lo, &w_hi);
+
+      unsigned char compute = any_changed;
+      ITER_T bh_end = (h_hi - 1) / STREAM_BLOCK;
+      ITER_T bw_end = (w_hi - 1) / STREAM_BLOCK;
+      for (ITER_T bh = h_lo / STREAM_BLOCK; bh <= bh_end && !compute; bh++) {
+        for (ITER_T bw = w_lo / STREAM_BLOCK; bw <= bw_end; bw++) {
+          if (changed[bh][bw]) {
+            compute = 1;
+            break;
+          }
+        }
+      }
+      mask[x * RNNPOOL_PATCHES_Y + y] = compute;
+      num_computed += compute;
+    }
+  }
+
+  stream->frames++;
+  stream->patches_computed += num_computed;
+  stream->patches_total += RNNPOOL_PATCHES_X * RNNPOOL_PATCHES_Y;
+  stream->conv2d_rows_total += CONV2D_HOUT;
+  if (num_computed == 0) {
+    memcpy(mem_buf + FACE_DETECTION_FAST_OUTPUT_OFFSET, stream->output,
+           FACE_DETECTION_FAST_OUTPUT_SIZE * sizeof(Q15_T));
+    return 0;
+  }
+
+  // Every patch reading a changed block is recomputed, hence the reference of
+  // the changed blocks moves to the current frame. The other blocks keep their
+  // reference, so that a slow drift is still caught by the threshold
+  for (ITER_T bh = 0; bh < STREAM_BLOCKS_H; bh++) {
+    for (ITER_T bw = 0; bw < STREAM_BLOCKS_W; bw++) {
+      if (!changed[bh][bw]) {
+        continue;
+      }
+      ITER_T w_begin = bw * STREAM_BLOCK;
+      ITER_T w_end = block_end(bw, CBR1F_W);
+      for (ITER_T h = bh * STREAM_BLOCK; h < block_end(bh, CBR1F_H); h++) {
+        memcpy(&stream->reference[h * CBR1F_W + w_begin],
+               &input[h * CBR1F_W + w_begin], (w_end - w_begin) * sizeof(Q7_T));
+      }
+    }
+  }
+
+  // The rows of the Conv2D output outside the band reuse their outputs from
+  // the previous frames
+  if (!pointwise) {
+    q_face_detection_fast_conv2d(mem_buf);
+    stream->conv2d_rows_computed += CONV2D_HOUT;
+  } else {
+    q_face_detection_fast_conv2d_rows(mem_buf, conv_begin, conv_end);
+    stream->conv2d_rows_computed += conv_end - conv_begin;
+    ITER_T row_size = CONV2D_WOUT * CONV2D_COUT;
+    Q7_T* conv2d_output = (Q7_T*)(mem_buf + 76800);
+    memcpy(conv2d_output, stream->conv2d_output,
+           conv_begin * row_size * sizeof(Q7_T));
+    memcpy(&conv2d_output[conv_end * row_size],
+           &stream->conv2d_output[conv_end * row_size],
+           (CONV2D_HOUT - conv_end) * row_size * sizeof(Q7_T));
+    memcpy(&stream->conv2d_output[conv_begin * row_size],
+           &conv2d_output[conv_begin * row_size],
+           (conv_end - conv_begin) * row_size * sizeof(Q7_T));
+  }
+  unsigned num_workers = face_detection_num_workers(0, num_threads);
+  q_face_detection_fast_rnnpool(mem_buf, scratch_buf, mask, 0, num_workers);
+
+  // The other patches reuse their outputs from the previous frames
+  Q7_T* rnnpool_output = (Q7_T*)mem_buf;
+  for (ITER_T x = 0; x < RNNPOOL_PATCHES_X; x++) {
+    for (ITER_T y = 0; y < RNNPOOL_PATCHES_Y; y++) {
+      if (!mask[x * RNNPOOL_PATCHES_Y + y]) {
+        ITER_T offset = x * 1280 + y * 4 * HIDDEN_DIM2;
+        memcpy(&rnnpool_output[offset], &stream->rnnpool_output[offset],
+               4 * HIDDEN_DIM2 * sizeof(Q7_T));
+      }
+    }
+  }
+  memcpy(stream->rnnpool_output, rnnpool_output,
+         FACE_DETECTION_FAST_RNNPOOL_SIZE * sizeof(Q7_T));
+
+  q_face_detection_fast_mbconv(mem_buf, scratch_buf, num_workers);
+  memcpy(stream->output, mem_buf + FACE_DETECTION_FAST_OUTPUT_OFFSET,
+         FACE_DETECTION_FAST_OUTPUT_SIZE * sizeof(Q15_T));
+  stream->valid = 1;
+  return num_computed;
+}
+
+void q_face_detection_fast(char* const mem_buf) {
+  q_face_detection_fast_threaded(mem_buf, NULL, 1);
+}
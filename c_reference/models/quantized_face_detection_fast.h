@@ -4,6 +4,43 @@
 #ifndef __QUANTIZED_FACE_DETECTION_FAST_H__
 #define __QUANTIZED_FACE_DETECTION_FAST_H__
 
+#include "quantized_datatypes.h"
+
+// Size in bytes of the memory buffer of one frame. The 240x320 Q7 input image
+// starts at byte 0, the 5400 Q15 outputs at byte FACE_DETECTION_FAST_OUTPUT_OFFSET
+#define FACE_DETECTION_FAST_MEM_BUF_SIZE 165840
+#define FACE_DETECTION_FAST_OUTPUT_OFFSET 10800
+#define FACE_DETECTION_FAST_OUTPUT_SIZE 5400
+#define FACE_DETECTION_FAST_INPUT_SIZE 76800
+#define FACE_DETECTION_FAST_RNNPOOL_SIZE 19200
+#define FACE_DETECTION_FAST_CONV2D_SIZE 76800
+
+/**
+ * @brief State of the streaming mode of the fast face detection model, kept across the frames of a video
+ * @var   reference             input pixels the cached outputs were computed from. Updated for the blocks which changed beyond the threshold
+ * @var   conv2d_output         output of the Conv2D sub-pipeline of the last computed frame
+ * @var   rnnpool_output        RNNPool outputs of the patches of the last computed frame
+ * @var   output                model outputs of the last computed frame
+ * @var   valid                 0 until the first frame is computed
+ * @var   frames                number of frames processed
+ * @var   conv2d_rows_computed  number of rows of the Conv2D output computed over all the frames
+ * @var   conv2d_rows_total     number of rows of the Conv2D output of all the frames, computed or reused
+ * @var   patches_computed      number of RNNPool patches computed over all the frames
+ * @var   patches_total         number of RNNPool patches of all the frames, computed or reused
+ */
+typedef struct Q_Face_Detection_Fast_Stream {
+  Q7_T reference[FACE_DETECTION_FAST_INPUT_SIZE];
+  Q7_T conv2d_output[FACE_DETECTION_FAST_CONV2D_SIZE];
+  Q7_T rnnpool_output[FACE_DETECTION_FAST_RNNPOOL_SIZE];
+  Q15_T output[FACE_DETECTION_FAST_OUTPUT_SIZE];
+  unsigned valid;
+  unsigned long frames;
+  unsigned long conv2d_rows_computed;
+  unsigned long conv2d_rows_total;
+  unsigned long patches_computed;
+  unsigned long patches_total;
+} Q_Face_Detection_Fast_Stream;
+
 /**
  * @brief Routine for running the entire face detection model pipeline.
  * @param[in, out]    mem_buf   pointer to the singleton memory buffer for input, intermediate computations and output, used for fragmentation invariance
@@ -12,4 +49,62 @@
  */
 void q_face_detection_fast(char* const mem_buf);
 
+/**
+ * @brief Routine for running the entire face detection model pipeline on multiple threads. The RNNPool patches and the rows of the MBConv outputs
+ * @brief are split across the threads. The output is bit-exact with q_face_detection_fast() for any number of threads
+ * @param[in, out]    mem_buf       pointer to the singleton memory buffer for input, intermediate computations and output, used for fragmentation invariance
+ * @param[in]         scratch_buf   pointer to the buffers of the threads after the first, q_face_detection_fast_scratch_size(num_threads) bytes aligned for Q15_T. NULL for a single thread
+ * @param[in]         num_threads   number of threads to use, limited to FACE_DETECTION_MAX_THREADS. Without MULTITHREADED, the pipeline runs on the calling thread
+ * @return            none
+ * @example
+ */
+void q_face_detection_fast_threaded(char* const mem_buf, char* const scratch_buf,
+  unsigned num_threads);
+
+/**
+ * @brief Routine for running the face detection model pipeline on a batch of frames, for throughput over latency
+ * @brief Frame f uses the FACE_DETECTION_FAST_MEM_BUF_SIZE bytes at mem_buf + f * FACE_DETECTION_FAST_MEM_BUF_SIZE, laid out as for q_face_detection_fast()
+ * @brief The frames are split over the threads, each thread running its frames one after the other. The outputs are bit-exact with q_face_detection_fast()
+ * @param[in, out]    mem_buf       pointer to the memory buffer of the batch, num_frames * FACE_DETECTION_FAST_MEM_BUF_SIZE bytes
+ * @param[in]         scratch_buf   pointer to the buffers of the threads after the first, q_face_detection_fast_scratch_size(num_threads) bytes aligned for Q15_T. NULL for a single thread
+ * @param[in]         num_frames    number of frames in the batch
+ * @param[in]         num_threads   number of threads to use, limited to FACE_DETECTION_MAX_THREADS. Without MULTITHREADED, the frames run on the calling thread
+ * @return            none
+ * @example
+ */
+void q_face_detection_fast_batch(char* const mem_buf, char* const scratch_buf,
+  unsigned num_frames, unsigned num_threads);
+
+/**
+ * @brief Size in bytes of the scratch buffer of the threaded and batched pipelines: the RNNPool and MBConv buffers of the threads after the first
+ * @param[in]         num_threads   number of threads to use
+ * @return            The size of the scratch buffer. 0 for a single thread, and for any number of threads without MULTITHREADED
+ */
+unsigned q_face_detection_fast_scratch_size(unsigned num_threads);
+
+/**
+ * @brief Resets the streaming state, so that the next frame is fully computed
+ * @param[out]        stream        pointer to the streaming state
+ * @return            none
+ */
+void q_face_detection_fast_stream_init(Q_Face_Detection_Fast_Stream* stream);
+
+/**
+ * @brief Routine for running the fast face detection model on the next frame of a video, reusing the work of the previous frames
+ * @brief The input is compared against the reference frame in blocks of 8x8 pixels. Only the rows of the Conv2D output and the RNNPool
+ * @brief patches whose receptive field contains a changed block are recomputed, the others reuse their cached outputs. The layers
+ * @brief after the RNNPool are skipped if no patch changed. With threshold 0, the outputs are bit-exact with q_face_detection_fast(). Else every input pixel of a
+ * @brief reused output is within 2 * threshold of the current frame
+ * @param[in, out]    mem_buf       pointer to the memory buffer of the frame, laid out as for q_face_detection_fast()
+ * @param[in]         scratch_buf   pointer to the buffers of the threads after the first, as for q_face_detection_fast_threaded()
+ * @param[in, out]    stream        pointer to the streaming state, initialized with q_face_detection_fast_stream_init()
+ * @param[in]         threshold     largest absolute difference of a Q7 input pixel with the reference still treated as unchanged
+ * @param[in]         num_threads   number of threads for the recomputed patches and MBConv layers
+ * @return            The number of RNNPool patches recomputed for the frame
+ * @example
+ */
+unsigned q_face_detection_fast_stream(char* const mem_buf,
+  char* const scratch_buf, Q_Face_Detection_Fast_Stream* stream,
+  Q7_T threshold, unsigned num_threads);
+
 #endif
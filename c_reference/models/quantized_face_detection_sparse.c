@@ -21,7 +21,24 @@
 #include "q_scut_head_b_face4_model/mbconv4.h"
 #include "q_scut_head_b_face4_model/detection4.h"
 
-void q_face_detection_sparse(char* const mem_buf) {
+#include "quantized_face_detection_workers.h"
+
+// RNNPool buffers of the first worker. The other workers, and the MBConv bands
+// after the first, use the scratch buffer of the caller
+static Q15_T worker_buffers[FACE_DETECTION_WORKER_SIZE(INPUT_CHANNELS, PATCH_DIM, HIDDEN_DIM1, HIDDEN_DIM2)];
+
+static const Face_Detection_Workers WORKERS = {
+  .buffers = worker_buffers,
+  .rnn1_model_buffers = (void*)(&RNN1_BUFFERS),
+  .rnn2_model_buffers = (void*)(&RNN2_BUFFERS),
+  .input_channels = INPUT_CHANNELS,
+  .patch_dim = PATCH_DIM,
+  .hidden_dim1 = HIDDEN_DIM1,
+  .hidden_dim2 = HIDDEN_DIM2
+};
+
+static void q_face_detection_sparse_frame(char* const mem_buf,
+  char* const scratch_buf, unsigned first_worker, unsigned num_threads) {
   // Conv2D Sub-Pipeline
   q7xq15_q7_convolution((Q7_T*)mem_buf, CBR1F, (Q7_T*)(mem_buf + 76800),
     CONV2D_N, CBR1F_H, CBR1F_W, CBR1F_CIN, CBR1F_HF, CBR1F_WF, CBR1F_CF,
@@ -50,21 +67,20 @@ void q_face_detection_sparse(char* const mem_buf) {
   memset((mem_buf + 153600), 0, sizeof(Q15_T));
   memset((mem_buf + 153602), 0, sizeof(Q15_T));
 
-  for (ITER_T patch_x = 0; (patch_x < 29); patch_x++) {
-    for (ITER_T patch_y = 0; (patch_y < 39); patch_y++) {
-      q7xq15_q15_rnnpool_block((Q7_T*)(mem_buf + ((2560 * patch_x) + (16 * patch_y))),
-        INPUT_CHANNELS, PATCH_DIM, CONV2D_WOUT, q7xq15_q15_fastgrnn, HIDDEN_DIM1,
-        (const void*)(&RNN1_PARAMS), (void*)(&RNN1_BUFFERS),
-        (const void*)(&RNN1_SCALES), q15_fastgrnn, HIDDEN_DIM2,
-        (const void*)(&RNN2_PARAMS), (void*)(&RNN2_BUFFERS),
-        (const void*)(&RNN2_SCALES), (Q15_T*)(mem_buf + 153750),
-        (Q15_T*)(mem_buf + 153900), ShR1, ShL1, ShR2, ShL2);
-
-      for (ITER_T i = 0; i < 64; i++) {
-        mem_buf_offset_q7[76800 + patch_x * 2560 + patch_y * 64 + i] = (Q7_T)(mem_buf_offset_q15[76875 + i]);
-      }
-    }
-  }
+  // The patches are split over the workers, each with its own RNN buffers
+  Q_RNNPool_Worker_Buffers workers[FACE_DETECTION_MAX_THREADS];
+  Face_Detection_RNN_Buffers rnn_buffers[FACE_DETECTION_MAX_THREADS];
+  ITER_T num_workers = face_detection_num_workers(first_worker, num_threads);
+  face_detection_workers(workers, rnn_buffers, &WORKERS, scratch_buf,
+    first_worker, num_workers, (Q15_T*)(mem_buf + 153750),
+    (Q15_T*)(mem_buf + 153900));
+  q7xq15_q15_rnnpool_patches((const Q7_T*)mem_buf, INPUT_CHANNELS, PATCH_DIM,
+    CONV2D_WOUT, 29, 39, 2560, 16, q7xq15_q15_fastgrnn, HIDDEN_DIM1,
+    (const void*)(&RNN1_PARAMS), (const void*)(&RNN1_SCALES),
+    q7xq15_q15_fastgrnn_batch, q15_fastgrnn, HIDDEN_DIM2,
+    (const void*)(&RNN2_PARAMS), (const void*)(&RNN2_SCALES),
+    mem_buf_offset_q7 + 76800, 2560, ShR1, ShL1, ShR2, ShL2, NULL, workers,
+    num_workers);
 
   memcpy(&mem_buf_offset_q7[76800 + 29 * 2560], &mem_buf_offset_q7[76800 + 28 * 2560],
          39 * 64 * sizeof(Q7_T));
@@ -75,13 +91,14 @@ void q_face_detection_sparse(char* const mem_buf) {
 
   // MBConv Sub-Pipeline
   // MBConv Layer 1
-  q7xq15_q15_mbconv_block((Q7_T*)(mem_buf + 76800), L1_F1, L1_W1, L1_B1, L1_F2,
+  q7xq15_q15_mbconv_block_threaded((Q7_T*)(mem_buf + 76800), L1_F1, L1_W1, L1_B1, L1_F2,
     L1_W2, L1_B2, L1_F3, L1_W3, L1_B3, (Q15_T*)mem_buf,
     (Q15_T*)(mem_buf + 153600), (Q15_T*)(mem_buf + 184832), L1_N, L1_H, L1_W,
     L1_CIN, L1_CTEMP, L1_HF, L1_WF, L1_COUT, L1_HOUT, L1_WOUT, L1_HPADL,
     L1_HPADR, L1_WPADL, L1_WPADR, L1_HSTRIDE, L1_WSTRIDE, L1_Limit1, L1_Limit2,
     L1_ShRU1, L1_ShRX1, L1_ShRU2, L1_ShRX2, L1_ShRU3, L1_ShRW3, L1_ShLU1,
-    L1_ShLX1, L1_ShLU2, L1_ShLX2, L1_ShLU3, L1_ShLW3);
+    L1_ShLX1, L1_ShLU2, L1_ShLX2, L1_ShLU3, L1_ShLW3, scratch_buf,
+    (num_workers - 1) * FACE_DETECTION_BAND_BUFFERS_SIZE, num_workers);
 
   // Detection Layer 1 Sub-Pipeline
   q15_t_l2_norm((Q15_T*)mem_buf, L1_N, L1_HOUT, L1_WOUT, L1_COUT,
@@ -130,13 +147,14 @@ void q_face_detection_sparse(char* const mem_buf) {
   }
 
   // MBConv Layer 2
-  q15_mbconv_block((Q15_T*)mem_buf, L2_F1, L2_W1, L2_B1, L2_F2,
+  q15_mbconv_block_threaded((Q15_T*)mem_buf, L2_F1, L2_W1, L2_B1, L2_F2,
     L2_W2, L2_B2, L2_F3, L2_W3, L2_B3, (Q15_T*)(mem_buf + 81600),
     (Q15_T*)(mem_buf + 172800), (Q15_T*)(mem_buf + 158656), L2_N, L2_H, L2_W,
     L2_CIN, L2_CTEMP, L2_HF, L2_WF, L2_COUT, L2_HOUT, L2_WOUT, L2_HPADL,
     L2_HPADR, L2_WPADL, L2_WPADR, L2_HSTRIDE, L2_WSTRIDE, L2_Limit1, L2_Limit2,
     L2_ShRU1, L2_ShRX1, L2_ShRU2, L2_ShRX2, L2_ShRU3, L2_ShRW3, L2_ShLU1,
-    L2_ShLX1, L2_ShLU2, L2_ShLX2, L2_ShLU3, L2_ShLW3);
+    L2_ShLX1, L2_ShLU2, L2_ShLX2, L2_ShLU3, L2_ShLW3, scratch_buf,
+    (num_workers - 1) * FACE_DETECTION_BAND_BUFFERS_SIZE, num_workers);
 
   // MBConv1 + MBConv2
   q15_t_add((Q15_T*)mem_buf, (Q15_T*)(mem_buf + 81600), L2_N, L2_HOUT,
@@ -171,13 +189,14 @@ void q_face_detection_sparse(char* const mem_buf) {
     D2LW_COUT, (Q15_T*)(mem_buf + 172800), D2LB_Scten, D2LB_Scvec, D2LB_Scret);
 
   // MBConv Layer 3
-  q15_mbconv_block((Q15_T*)mem_buf, L3_F1, L3_W1, L3_B1, L3_F2, L3_W2, L3_B2,
+  q15_mbconv_block_threaded((Q15_T*)mem_buf, L3_F1, L3_W1, L3_B1, L3_F2, L3_W2, L3_B2,
     L3_F3, L3_W3, L3_B3, (Q15_T*)(mem_buf + 81600), (Q15_T*)(mem_buf + 120000),
     (Q15_T*)(mem_buf + 135616), L3_N, L3_H, L3_W, L3_CIN, L3_CTEMP, L3_HF,
     L3_WF, L3_COUT, L3_HOUT, L3_WOUT, L3_HPADL, L3_HPADR, L3_WPADL, L3_WPADR,
     L3_HSTRIDE, L3_WSTRIDE, L3_Limit1, L3_Limit2, L3_ShRU1, L3_ShRX1, L3_ShRU2,
     L3_ShRX2, L3_ShRU3, L3_ShRW3, L3_ShLU1, L3_ShLX1, L3_ShLU2, L3_ShLX2,
-    L3_ShLU3, L3_ShLW3);
+    L3_ShLU3, L3_ShLW3, scratch_buf,
+    (num_workers - 1) * FACE_DETECTION_BAND_BUFFERS_SIZE, num_workers);
 
   // Detection Layer 3 Sub-Pipeline
   q15_t_l2_norm((Q15_T*)(mem_buf + 81600), L3_N, L3_HOUT, L3_WOUT, L3_COUT,
@@ -208,13 +227,14 @@ void q_face_detection_sparse(char* const mem_buf) {
     D3LW_COUT, (Q15_T*)(mem_buf + 39600), D3LB_Scten, D3LB_Scvec, D3LB_Scret);
 
   // MBConv Layer 4
-  q15_mbconv_block((Q15_T*)(mem_buf + 81600), L4_F1, L4_W1, L4_B1, L4_F2,
+  q15_mbconv_block_threaded((Q15_T*)(mem_buf + 81600), L4_F1, L4_W1, L4_B1, L4_F2,
     L4_W2, L4_B2, L4_F3, L4_W3, L4_B3, (Q15_T*)mem_buf,
     (Q15_T*)(mem_buf + 42000), (Q15_T*)(mem_buf + 57872), L4_N, L4_H, L4_W,
     L4_CIN, L4_CTEMP, L4_HF, L4_WF, L4_COUT, L4_HOUT, L4_WOUT, L4_HPADL,
     L4_HPADR, L4_WPADL, L4_WPADR, L4_HSTRIDE, L4_WSTRIDE, L4_Limit1, L4_Limit2,
     L4_ShRU1, L4_ShRX1, L4_ShRU2, L4_ShRX2, L4_ShRU3, L4_ShRW3, L4_ShLU1,
-    L4_ShLX1, L4_ShLU2, L4_ShLX2, L4_ShLU3, L4_ShLW3);
+    L4_ShLX1, L4_ShLU2, L4_ShLX2, L4_ShLU3, L4_ShLW3, scratch_buf,
+    (num_workers - 1) * FACE_DETECTION_BAND_BUFFERS_SIZE, num_workers);
 
   // MBConv3 + MBConv4
   q15_t_add((Q15_T*)(mem_buf + 81600), (Q15_T*)mem_buf, L4_N, L4_HOUT,
@@ -257,3 +277,23 @@ void q_face_detection_sparse(char* const mem_buf) {
     mem_buf_offset_q15[16800 + i] = (mem_buf_offset_q15[21000 + i] / 2);
   }
 }
+
+unsigned q_face_detection_sparse_scratch_size(unsigned num_threads) {
+  return FACE_DETECTION_SCRATCH_SIZE(face_detection_num_workers(0, num_threads),
+    INPUT_CHANNELS, PATCH_DIM, HIDDEN_DIM1, HIDDEN_DIM2);
+}
+
+void q_face_detection_sparse_threaded(char* const mem_buf, char* const scratch_buf,
+  unsigned num_threads) {
+  q_face_detection_sparse_frame(mem_buf, scratch_buf, 0, num_threads);
+}
+
+void q_face_detection_sparse_batch(char* const mem_buf, char* const scratch_buf,
+  unsigned num_frames, unsigned num_threads) {
+  face_detection_batch(q_face_detection_sparse_frame, mem_buf, scratch_buf,
+    FACE_DETECTION_SPARSE_MEM_BUF_SIZE, num_frames, num_threads);
+}
+
+void q_face_detection_sparse(char* const mem_buf) {
+  q_face_detection_sparse_threaded(mem_buf, NULL, 1);
+}
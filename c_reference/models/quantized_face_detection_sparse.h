@@ -4,6 +4,12 @@
 #ifndef __QUANTIZED_FACE_DETECTION_SPARSE_H__
 #define __QUANTIZED_FACE_DETECTION_SPARSE_H__
 
+// Size in bytes of the memory buffer of one frame. The 240x320 Q7 input image
+// starts at byte 0, the 18000 Q15 outputs at byte FACE_DETECTION_SPARSE_OUTPUT_OFFSET
+#define FACE_DETECTION_SPARSE_MEM_BUF_SIZE 188160
+#define FACE_DETECTION_SPARSE_OUTPUT_OFFSET 0
+#define FACE_DETECTION_SPARSE_OUTPUT_SIZE 18000
+
 /**
  * @brief Routine for running the entire face detection model pipeline.
  * @param[in, out]    mem_buf   pointer to the singleton memory buffer for input, intermediate computations and output, used for fragmentation invariance
@@ -12,4 +18,37 @@
  */
 void q_face_detection_sparse(char* const mem_buf);
 
+/**
+ * @brief Routine for running the entire face detection model pipeline on multiple threads. The RNNPool patches and the rows of the MBConv outputs
+ * @brief are split across the threads. The output is bit-exact with q_face_detection_sparse() for any number of threads
+ * @param[in, out]    mem_buf       pointer to the singleton memory buffer for input, intermediate computations and output, used for fragmentation invariance
+ * @param[in]         scratch_buf   pointer to the buffers of the threads after the first, q_face_detection_sparse_scratch_size(num_threads) bytes aligned for Q15_T. NULL for a single thread
+ * @param[in]         num_threads   number of threads to use, limited to FACE_DETECTION_MAX_THREADS. Without MULTITHREADED, the pipeline runs on the calling thread
+ * @return            none
+ * @example
+ */
+void q_face_detection_sparse_threaded(char* const mem_buf, char* const scratch_buf,
+  unsigned num_threads);
+
+/**
+ * @brief Routine for running the face detection model pipeline on a batch of frames, for throughput over latency
+ * @brief Frame f uses the FACE_DETECTION_SPARSE_MEM_BUF_SIZE bytes at mem_buf + f * FACE_DETECTION_SPARSE_MEM_BUF_SIZE, laid out as for q_face_detection_sparse()
+ * @brief The frames are split over the threads, each thread running its frames one after the other. The outputs are bit-exact with q_face_detection_sparse()
+ * @param[in, out]    mem_buf       pointer to the memory buffer of the batch, num_frames * FACE_DETECTION_SPARSE_MEM_BUF_SIZE bytes
+ * @param[in]         scratch_buf   pointer to the buffers of the threads after the first, q_face_detection_sparse_scratch_size(num_threads) bytes aligned for Q15_T. NULL for a single thread
+ * @param[in]         num_frames    number of frames in the batch
+ * @param[in]         num_threads   number of threads to use, limited to FACE_DETECTION_MAX_THREADS. Without MULTITHREADED, the frames run on the calling thread
+ * @return            none
+ * @example
+ */
+void q_face_detection_sparse_batch(char* const mem_buf, char* const scratch_buf,
+  unsigned num_frames, unsigned num_threads);
+
+/**
+ * @brief Size in bytes of the scratch buffer of the threaded and batched pipelines: the RNNPool and MBConv buffers of the threads after the first
+ * @param[in]         num_threads   number of threads to use
+ * @return            The size of the scratch buffer. 0 for a single thread, and for any number of threads without MULTITHREADED
+ */
+unsigned q_face_detection_sparse_scratch_size(unsigned num_threads);
+
 #endif
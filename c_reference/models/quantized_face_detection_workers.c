@@ -0,0 +1,121 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <stddef.h>
+#include "quantized_face_detection_workers.h"
+#include "parallel.h"
+
+unsigned face_detection_num_workers(unsigned first_worker, unsigned num_threads) {
+  // Without threads, the workers of a frame would run one after the other
+  #ifndef MULTITHREADED
+    num_threads = 1;
+  #endif
+  if (num_threads > FACE_DETECTION_MAX_THREADS - first_worker) {
+    num_threads = FACE_DETECTION_MAX_THREADS - first_worker;
+  }
+  if (num_threads < 1) {
+    num_threads = 1;
+  }
+  return num_threads;
+}
+
+void face_detection_workers(Q_RNNPool_Worker_Buffers* workers,
+  Face_Detection_RNN_Buffers* rnn_buffers, const Face_Detection_Workers* storage,
+  char* const scratch_buf, unsigned first_worker, unsigned num_workers,
+  Q15_T* output, Q15_T* buffer) {
+  ITER_T ic = storage->input_channels, pd = storage->patch_dim;
+  ITER_T h1 = storage->hidden_dim1, h2 = storage->hidden_dim2;
+  // The RNNPool buffers of the workers after the first follow the MBConv
+  // buffers of the bands in the scratch buffer
+  Q15_T* scratch = (Q15_T*)(scratch_buf +
+    (num_workers - 1) * FACE_DETECTION_BAND_BUFFERS_SIZE);
+  for (unsigned i = 0; i < num_workers; i++) {
+    unsigned k = first_worker + i;
+    // The Q15 buffers of worker k, followed by its Q7 buffers
+    Q15_T* buf = k == 0 ? storage->buffers :
+      scratch + (k - 1) * FACE_DETECTION_WORKER_SIZE(ic, pd, h1, h2);
+    Q7xQ15_FastGRNN_Buffers* rnn1 = &rnn_buffers[i].rnn1;
+    Q7xQ15_FastGRNN_Buffers* rnn1_batch = &rnn_buffers[i].rnn1_batch;
+    Q15_FastGRNN_Buffers* rnn2 = &rnn_buffers[i].rnn2;
+
+    rnn1->preComp1 = buf;
+    rnn1->preComp2 = buf + h1;
+    rnn1->preComp3 = buf + 2 * h1;
+    buf += 3 * h1;
+    // The batched RNN1 runs on all the rows (or all the columns) of a patch at once
+    rnn1_batch->preComp1 = buf;
+    rnn1_batch->preComp2 = buf + pd * h1;
+    rnn1_batch->preComp3 = buf + 2 * pd * h1;
+    buf += 3 * pd * h1;
+    rnn2->preComp1 = buf;
+    rnn2->preComp2 = buf + h2;
+    rnn2->preComp3 = buf + 2 * h2;
+    rnn2->normFeatures = buf + 3 * h2;
+    buf += 3 * h2 + h1;
+    workers[i].output = buf;
+    workers[i].buffer = buf + 4 * h2;
+    buf += 4 * h2 + h1 * pd;
+    rnn1->normFeatures = (Q7_T*)buf;
+    rnn1_batch->normFeatures = (Q7_T*)buf + ic;
+
+    workers[i].rnn1_buffers = (void*)rnn1;
+    workers[i].rnn1_batch_buffers = (void*)rnn1_batch;
+    workers[i].rnn2_buffers = (void*)rnn2;
+  }
+
+  if (first_worker == 0) {
+    workers[0].rnn1_buffers = storage->rnn1_model_buffers;
+    workers[0].rnn2_buffers = storage->rnn2_model_buffers;
+  }
+  workers[0].output = output;
+  workers[0].buffer = buffer;
+}
+
+typedef struct Face_Detection_Batch_Task {
+  face_detection_frame_t frame;
+  char* mem_buf;
+  char* scratch_buf;
+  unsigned frame_size;
+  unsigned num_frames;
+  unsigned worker;
+} Face_Detection_Batch_Task;
+
+static void face_detection_batch_task(void* args) {
+  const Face_Detection_Batch_Task* task = (const Face_Detection_Batch_Task*)args;
+  for (unsigned f = 0; f < task->num_frames; f++) {
+    task->frame(task->mem_buf + (size_t)f * task->frame_size,
+      task->scratch_buf, task->worker, 1);
+  }
+}
+
+void face_detection_batch(face_detection_frame_t frame, char* const mem_buf,
+  char* const scratch_buf, unsigned frame_size, unsigned num_frames,
+  unsigned num_threads) {
+  if (num_frames == 0) {
+    return;
+  }
+  if (num_frames == 1) {
+    frame(mem_buf, scratch_buf, 0, num_threads);
+    return;
+  }
+
+  unsigned num_tasks = face_detection_num_workers(0, num_threads);
+  if (num_tasks > num_frames) {
+    num_tasks = num_frames;
+  }
+
+  Face_Detection_Batch_Task tasks[FACE_DETECTION_MAX_THREADS];
+  unsigned begin = 0;
+  for (unsigned t = 0; t < num_tasks; t++) {
+    unsigned end = (unsigned)(((unsigned long long)num_frames * (t + 1)) / num_tasks);
+    tasks[t].frame = frame;
+    tasks[t].mem_buf = mem_buf + (size_t)begin * frame_size;
+    tasks[t].scratch_buf = scratch_buf;
+    tasks[t].frame_size = frame_size;
+    tasks[t].num_frames = end - begin;
+    tasks[t].worker = t;
+    begin = end;
+  }
+  parallel_for(face_detection_batch_task, (void*)tasks,
+    sizeof(Face_Detection_Batch_Task), num_tasks);
+}
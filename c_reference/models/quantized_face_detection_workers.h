@@ -0,0 +1,104 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#ifndef __QUANTIZED_FACE_DETECTION_WORKERS_H__
+#define __QUANTIZED_FACE_DETECTION_WORKERS_H__
+
+#include "quantized_fastgrnn.h"
+#include "quantized_rnnpool.h"
+#include "quantized_mbconv.h"
+
+// Worker threads of the face detection models. Every model source holds the
+// buffers of its first worker, sized with the RNN1 and RNN2 dimensions of the
+// model. The buffers of the other workers, and of their MBConv bands, are in
+// the scratch buffer passed by the caller of the threaded and batched models
+
+#ifndef FACE_DETECTION_MAX_THREADS
+  #define FACE_DETECTION_MAX_THREADS Q_MBCONV_MAX_THREADS
+#endif
+
+// Size in bytes of the MBConv buffers of one band of rows, for the largest
+// layer of the models: the tail of the memory buffer of a frame from byte 153600
+#define FACE_DETECTION_BAND_BUFFERS_SIZE 34560
+
+// Number of Q15_T elements of the RNNPool buffers of one worker
+#define FACE_DETECTION_WORKER_SIZE(input_channels, patch_dim, hidden_dim1, hidden_dim2) \
+  (3 * (hidden_dim1) + 3 * (patch_dim) * (hidden_dim1) + 3 * (hidden_dim2) + \
+   (hidden_dim1) + 4 * (hidden_dim2) + (hidden_dim1) * (patch_dim) + \
+   ((input_channels) * ((patch_dim) + 1) + 1) / 2)
+
+// Size in bytes of the scratch buffer of a frame running on num_workers
+// workers: the MBConv buffers of the bands after the first, followed by the
+// RNNPool buffers of the workers after the first
+#define FACE_DETECTION_SCRATCH_SIZE(num_workers, input_channels, patch_dim, hidden_dim1, hidden_dim2) \
+  (((num_workers) - 1) * (FACE_DETECTION_BAND_BUFFERS_SIZE + \
+   FACE_DETECTION_WORKER_SIZE(input_channels, patch_dim, hidden_dim1, hidden_dim2) * sizeof(Q15_T)))
+
+/**
+ * @brief Buffers of the RNNPool workers of a model
+ * @var   buffers              pointer to the FACE_DETECTION_WORKER_SIZE(input_channels, patch_dim, hidden_dim1, hidden_dim2) elements of the first worker
+ * @var   rnn1_model_buffers   pointer to the RNN1 buffers of the model, used by the first worker of a frame
+ * @var   rnn2_model_buffers   pointer to the RNN2 buffers of the model, used by the first worker of a frame
+ */
+typedef struct Face_Detection_Workers {
+  Q15_T* buffers;
+  void* rnn1_model_buffers;
+  void* rnn2_model_buffers;
+  ITER_T input_channels;
+  ITER_T patch_dim;
+  ITER_T hidden_dim1;
+  ITER_T hidden_dim2;
+} Face_Detection_Workers;
+
+// Buffers of the RNN cells of one worker, pointing into its RNNPool buffers
+typedef struct Face_Detection_RNN_Buffers {
+  Q7xQ15_FastGRNN_Buffers rnn1;
+  Q7xQ15_FastGRNN_Buffers rnn1_batch;
+  Q15_FastGRNN_Buffers rnn2;
+} Face_Detection_RNN_Buffers;
+
+/**
+ * @brief Number of workers of a frame
+ * @param[in]        first_worker   index of the first worker of the frame. The batched pipelines run one frame per worker
+ * @param[in]        num_threads    requested number of workers
+ * @return           num_threads limited to [1, FACE_DETECTION_MAX_THREADS - first_worker], and 1 without MULTITHREADED
+ */
+unsigned face_detection_num_workers(unsigned first_worker, unsigned num_threads);
+
+/**
+ * @brief Sets up the buffers of the RNNPool workers
+ * @param[out]       workers        pointer to num_workers sets of buffers
+ * @param[out]       rnn_buffers    pointer to num_workers sets of buffers of the RNN cells
+ * @param[in]        storage        buffers of the first worker of the model
+ * @param[in]        scratch_buf    scratch buffer of the frame, FACE_DETECTION_SCRATCH_SIZE(first_worker + num_workers, ...) bytes
+ * @param[in]        first_worker   index of the first worker of the frame
+ * @param[in]        num_workers    number of workers, from face_detection_num_workers()
+ * @param[in]        output         scratch space of the calling worker in mem_buf for the RNNPool output of a patch
+ * @param[in]        buffer         scratch space of the calling worker in mem_buf for the RNNPool buffer
+ * @return           none
+ */
+void face_detection_workers(Q_RNNPool_Worker_Buffers* workers,
+  Face_Detection_RNN_Buffers* rnn_buffers, const Face_Detection_Workers* storage,
+  char* const scratch_buf, unsigned first_worker, unsigned num_workers,
+  Q15_T* output, Q15_T* buffer);
+
+typedef void (*face_detection_frame_t)(char* const mem_buf,
+  char* const scratch_buf, unsigned first_worker, unsigned num_threads);
+
+/**
+ * @brief Runs a face detection pipeline on a batch of frames. Frame f uses the frame_size bytes at mem_buf + f * frame_size
+ * @brief The frames are split over the workers, each running its frames one after the other with its own set of buffers
+ * @brief A single frame is split over the workers instead (patches and MBConv rows)
+ * @param[in]        frame          pipeline of one frame, running on num_threads workers starting at first_worker
+ * @param[in, out]   mem_buf        pointer to num_frames consecutive memory buffers of the pipeline
+ * @param[in]        scratch_buf    scratch buffer of the workers, FACE_DETECTION_SCRATCH_SIZE(num_threads, ...) bytes
+ * @param[in]        frame_size     size of the memory buffer of one frame in bytes
+ * @param[in]        num_frames     number of frames in the batch
+ * @param[in]        num_threads    requested number of workers
+ * @return           none
+ */
+void face_detection_batch(face_detection_frame_t frame, char* const mem_buf,
+  char* const scratch_buf, unsigned frame_size, unsigned num_frames,
+  unsigned num_threads);
+
+#endif
@@ -6,6 +6,169 @@
 #include <string.h>
 #include "conv1d.h"
 #include "utils.h"
+#include "parallel.h"
+
+// Arguments for one range of output time steps of the multi-threaded conv1d_parallel and conv1d_lr_parallel
+// For the regular conv, W is the weight and W_lr = 0. For the low-rank conv, W = W2 (input -> low-rank) and W_lr = W1 (low-rank -> output)
+typedef struct Conv1d_Range_Task {
+  float* output_signal;
+  unsigned out_channels;
+  const float* input_signal;
+  unsigned in_time;
+  unsigned in_channels;
+  unsigned padding;
+  unsigned kernel_size;
+  unsigned stride;
+  unsigned activation;
+  const float* W;
+  const float* W_lr;
+  const float* B;
+  unsigned rank;
+  unsigned block_size;
+  unsigned block_size_lr;
+  unsigned t_begin;
+  unsigned t_end;
+} Conv1d_Range_Task;
+
+static void conv1d_range_task(void* args) {
+  const Conv1d_Range_Task* task = (const Conv1d_Range_Task*)args;
+  unsigned in_channels = task->in_channels, out_channels = task->out_channels;
+  unsigned padding = task->padding, kernel_size = task->kernel_size, stride = task->stride;
+  unsigned ncols = kernel_size * in_channels;
+  // Channels produced by W. rank for the low-rank conv, out_channels for the regular conv
+  unsigned first_channels = task->W_lr ? task->rank : out_channels;
+
+  // Range of the time steps where the filter is fully inside the input : [t_inside_begin, t_inside_end)
+  unsigned t_inside_begin = (padding + stride - 1) / stride;
+  unsigned t_inside_end = (task->in_time + padding >= kernel_size) ?
+                            (task->in_time + padding - kernel_size) / stride + 1 : 0;
+  t_inside_begin = (t_inside_begin > task->t_begin) ? t_inside_begin : task->t_begin;
+  t_inside_end = (t_inside_end < task->t_end) ? t_inside_end : task->t_end;
+  if (t_inside_end < t_inside_begin) {
+    t_inside_end = t_inside_begin;
+  }
+
+  float* temp_rank_out = (float*)malloc(first_channels * sizeof(float));
+  for (unsigned t_out = task->t_begin; t_out < task->t_end; t_out++) {
+    if (t_out == t_inside_begin) {
+      // Skip the fully inside time steps. They are computed below with the MatMul
+      t_out = t_inside_end;
+      if (t_out == task->t_end) {
+        break;
+      }
+    }
+    // Filter partially (or fully) in the padding region
+    // Only the part of the weight matrix overlapping with the input is used. Hence the row_stride skips the columns in the padding
+    unsigned t_in_start = t_out * stride, t_in_end = t_out * stride + kernel_size - 1;
+    unsigned t_first = (t_in_start > padding) ? t_in_start : padding;
+    unsigned t_last = (t_in_end < task->in_time + padding - 1) ? t_in_end : task->in_time + padding - 1;
+    float* output_offset = task->output_signal + t_out * out_channels;
+    if (t_last < t_first) {
+      memset(output_offset, 0, out_channels * sizeof(float));
+      continue;
+    }
+    if (task->W_lr) {
+      offset_matVec_conv1d(task->W + (t_first - t_in_start) * in_channels,
+        task->input_signal + (t_first - padding) * in_channels, first_channels,
+        (t_last - t_first + 1) * in_channels, ncols, 1, 0, temp_rank_out);
+      offset_matVec_conv1d(task->W_lr, temp_rank_out, out_channels,
+        first_channels, first_channels, 1, 0, output_offset);
+    }
+    else {
+      offset_matVec_conv1d(task->W + (t_first - t_in_start) * in_channels,
+        task->input_signal + (t_first - padding) * in_channels, out_channels,
+        (t_last - t_first + 1) * in_channels, ncols, 1, 0, output_offset);
+    }
+  }
+  free(temp_rank_out);
+
+  if (t_inside_end > t_inside_begin) {
+    // The input rows of adjacent time steps are stride * in_channels apart and overlap in memory
+    // Hence all the fully inside time steps of the range form one MatMul, without copying the input
+    unsigned rows = t_inside_end - t_inside_begin;
+    const float* input_offset = task->input_signal + (t_inside_begin * stride - padding) * in_channels;
+    float* output_offset = task->output_signal + t_inside_begin * out_channels;
+    memset(output_offset, 0, rows * out_channels * sizeof(float));
+    if (task->W_lr) {
+      float* temp_lr = (float*)calloc(rows * first_channels, sizeof(float));
+      transposed_tiledMatMul(input_offset, task->W, rows, ncols, first_channels,
+        stride * in_channels, ncols, temp_lr, task->block_size);
+      transposed_tiledMatMul(temp_lr, task->W_lr, rows, first_channels, out_channels,
+        first_channels, first_channels, output_offset, task->block_size_lr);
+      free(temp_lr);
+    }
+    else {
+      transposed_tiledMatMul(input_offset, task->W, rows, ncols, out_channels,
+        stride * in_channels, ncols, output_offset, task->block_size);
+    }
+  }
+
+  // Bias and activation
+  for (unsigned t_index = task->t_begin * out_channels;
+        t_index < task->t_end * out_channels; t_index += out_channels) {
+    float* output_signal = task->output_signal;
+    for (unsigned co = 0; co < out_channels; co++) {
+      // Post-Conv activation. More activation functions can be added should the necessity arise
+      switch (task->activation) {
+        case 1 :
+          output_signal[t_index + co] = sigmoid(output_signal[t_index + co] +
+                                          task->B[co]);
+          break;
+
+        case 2 :
+          output_signal[t_index + co] = tanh(output_signal[t_index + co] +
+                                          task->B[co]);
+          break;
+
+        case 3 :
+          output_signal[t_index + co] = relu(output_signal[t_index + co] +
+                                          task->B[co]);
+          break;
+
+        default :
+          output_signal[t_index + co] += task->B[co];
+          break;
+      }
+    }
+  }
+}
+
+// Split the output time steps into num_threads contiguous ranges and compute them with conv1d_range_task
+static int conv1d_threaded(float* output_signal, unsigned out_time, unsigned out_channels,
+  const float* input_signal, unsigned in_time, unsigned in_channels,
+  unsigned padding, unsigned kernel_size, unsigned stride, unsigned activation,
+  const float* W, const float* W_lr, const float* B, unsigned rank,
+  unsigned block_size, unsigned block_size_lr, unsigned num_threads) {
+  if (num_threads > out_time) {
+    num_threads = out_time ? out_time : 1;
+  }
+  Conv1d_Range_Task* tasks = (Conv1d_Range_Task*)malloc(num_threads * sizeof(Conv1d_Range_Task));
+  for (unsigned i = 0; i < num_threads; i++) {
+    Conv1d_Range_Task task = {
+      .output_signal = output_signal,
+      .out_channels = out_channels,
+      .input_signal = input_signal,
+      .in_time = in_time,
+      .in_channels = in_channels,
+      .padding = padding,
+      .kernel_size = kernel_size,
+      .stride = stride,
+      .activation = activation,
+      .W = W,
+      .W_lr = W_lr,
+      .B = B,
+      .rank = rank,
+      .block_size = block_size,
+      .block_size_lr = block_size_lr,
+      .t_begin = (out_time * i) / num_threads,
+      .t_end = (out_time * (i + 1)) / num_threads,
+    };
+    tasks[i] = task;
+  }
+  parallel_for(conv1d_range_task, tasks, sizeof(Conv1d_Range_Task), num_threads);
+  free(tasks);
+  return 0;
+}
 
 int conv1d_lr(float* output_signal, unsigned out_time, unsigned out_channels,
   const float* input_signal, unsigned in_time, unsigned in_channels,
@@ -111,6 +274,12 @@ int conv1d_lr_parallel(float* output_signal, unsigned out_time, unsigned out_cha
   unsigned total_in_cols = num_steps_one_row * in_channels;
   
   const ConvLayers_LR_Parallel_Params* tparams = (ConvLayers_LR_Parallel_Params*) params;
+  if (tparams->num_threads > 1) {
+    return conv1d_threaded(output_signal, out_time, out_channels, input_signal,
+      in_time, in_channels, padding, kernel_size, stride, activation,
+      tparams->W2, tparams->W1, tparams->B, tparams->rank,
+      tparams->block_size_to_lr, tparams->block_size_from_lr, tparams->num_threads);
+  }
   // Perform the convolution. Zero-pad is from 0 to padding and in_time + padding to in_time + 2 * padding
   // Buffer to hold the output. For corner cases, this will be realtively big. 
   // But will be needed for the central condition (filter inside input).
@@ -351,6 +520,11 @@ int conv1d_parallel(float* output_signal, unsigned out_time, unsigned out_channe
   unsigned total_in_cols = num_steps_one_row * in_channels;
 
   const ConvLayers_Parallel_Params* tparams = (ConvLayers_Parallel_Params*) params;
+  if (tparams->num_threads > 1) {
+    return conv1d_threaded(output_signal, out_time, out_channels, input_signal,
+      in_time, in_channels, padding, kernel_size, stride, activation,
+      tparams->W, 0, tparams->B, 0, tparams->block_size, 0, tparams->num_threads);
+  }
   // Perform the Convolution. Pad is from 0 to padding and in_time + padding to in_time + 2 * padding
   // Buffer to hold the output. For corner cases, this will be realtively big. 
   // But will be needed for the central condition (filter inside input).
@@ -478,6 +652,97 @@ int conv1d_parallel(float* output_signal, unsigned out_time, unsigned out_channe
   return 0;
 }
 
+int conv1d_im2col(float* output_signal, unsigned out_time, unsigned out_channels,
+  const float* input_signal, unsigned in_time, unsigned in_channels,
+  unsigned padding, unsigned kernel_size,
+  const void* params, unsigned stride, unsigned activation) {
+
+  const ConvLayers_Parallel_Params* tparams = (ConvLayers_Parallel_Params*) params;
+  unsigned ncols = kernel_size * in_channels;
+  unsigned num_panels = (out_channels + PACKED_MATMUL_COLS - 1) / PACKED_MATMUL_COLS;
+  unsigned buffer_steps = (out_time < CONV1D_IM2COL_STEPS) ? out_time : CONV1D_IM2COL_STEPS;
+
+  // The weights are packed once per call. Shape = [out_channels, kernel_size * in_channels] is already the transposed B matrix
+  float* packed_W = (float*)malloc(num_panels * PACKED_MATMUL_COLS * ncols * sizeof(float));
+  // Buffer for the unrolled input patches (im2col), shape = [buffer_steps, kernel_size * in_channels]
+  float* patches = (float*)malloc(buffer_steps * ncols * sizeof(float));
+  pack_transposed_matB(tparams->W, out_channels, ncols, ncols, packed_W);
+
+  for (unsigned t_block = 0; t_block < out_time; t_block += buffer_steps) {
+    unsigned block_steps = (t_block + buffer_steps < out_time) ? buffer_steps : out_time - t_block;
+    // Unroll the patches. Zero-pad is from 0 to padding and in_time + padding to in_time + 2 * padding
+    // The padding is written only once here, hence the MatMul does not need any edge conditions
+    float* patch_offset = patches;
+    for (unsigned t_out = t_block; t_out < t_block + block_steps; t_out++) {
+      unsigned t_in_start = t_out * stride;
+      for (unsigned tf = 0; tf < kernel_size; tf++, patch_offset += in_channels) {
+        if (((t_in_start + tf) < padding) || ((t_in_start + tf) >= (in_time + padding))) {
+          memset(patch_offset, 0, in_channels * sizeof(float));
+        }
+        else {
+          memcpy(patch_offset, input_signal + (t_in_start + tf - padding) * in_channels,
+            in_channels * sizeof(float));
+        }
+      }
+    }
+    float* output_offset = output_signal + t_block * out_channels;
+    memset(output_offset, 0, block_steps * out_channels * sizeof(float));
+    packed_tiledMatMul(patches, packed_W, block_steps, ncols, out_channels,
+      ncols, output_offset, tparams->block_size);
+
+    // Bias and activation, while the block is still in the cache
+    for (unsigned t_index = 0; t_index < block_steps * out_channels; t_index += out_channels) {
+      for (unsigned co = 0; co < out_channels; co++) {
+        // Post-Conv activation. More activation functions can be added should the necessity arise
+        switch (activation) {
+          case 1 :
+            output_offset[t_index + co] = sigmoid(output_offset[t_index + co] +
+                                            tparams->B[co]);
+            break;
+
+          case 2 :
+            output_offset[t_index + co] = tanh(output_offset[t_index + co] +
+                                            tparams->B[co]);
+            break;
+
+          case 3 :
+            output_offset[t_index + co] = relu(output_offset[t_index + co] +
+                                            tparams->B[co]);
+            break;
+
+          default :
+            output_offset[t_index + co] += tparams->B[co];
+            break;
+        }
+      }
+    }
+  }
+  free(patches);
+  free(packed_W);
+  return 0;
+}
+
+int conv1d_auto(float* output_signal, unsigned out_time, unsigned out_channels,
+  const float* input_signal, unsigned in_time, unsigned in_channels,
+  unsigned padding, unsigned kernel_size,
+  const void* params, unsigned stride, unsigned activation) {
+
+  const ConvLayers_Parallel_Params* tparams = (ConvLayers_Parallel_Params*) params;
+  // The packed MatMul needs at least 2 full register blocks along the time axis to amortize the packing of the weights
+  // Narrow layers would mostly compute the zero padded columns of the panels. Use the MatVec for such cases
+  if ((out_time >= (PACKED_MATMUL_ROWS << 1)) && (out_channels >= (PACKED_MATMUL_COLS >> 1))) {
+    return conv1d_im2col(output_signal, out_time, out_channels, input_signal,
+      in_time, in_channels, padding, kernel_size, params, stride, activation);
+  }
+  ConvLayers_Params conv_params = {
+    .W = tparams->W,
+    .B = tparams->B,
+    .depthwise = 0,
+  };
+  return conv1d(output_signal, out_time, out_channels, input_signal,
+    in_time, in_channels, padding, kernel_size, &conv_params, stride, activation);
+}
+
 int avgpool1d(float* output_signal, unsigned out_time, const float* input_signal,
   unsigned in_time, unsigned in_channels,
   unsigned padding, unsigned kernel_size, unsigned stride, unsigned activation) {
@@ -608,3 +873,245 @@ int batchnorm1d(float* output_signal, float* input_signal,
   }
   return 0;
 }
+
+// Per-channel scale and offset of the inference-time batchnorm : batchnorm(x) = scale * x + shift
+static void batchnorm_scale_shift(unsigned channel,
+  const float* const mean, const float* const var,
+  unsigned affine_config, const float* const gamma, const float* const beta,
+  float eps, float* scale, float* shift) {
+  if (affine_config == 1) {
+    *scale = gamma[channel] / sqrt(var[channel] + eps);
+    *shift = beta[channel] - (*scale) * mean[channel];
+  }
+  else if (affine_config == 2) {
+    *scale = gamma[channel];
+    *shift = beta[channel];
+  }
+  else {
+    *scale = 1.0f / sqrt(var[channel] + eps);
+    *shift = -mean[channel] * (*scale);
+  }
+}
+
+int conv1d_fold_batchnorm(float* W_folded, float* B_folded, float* tap_bias,
+  const float* W, const float* B, unsigned out_channels, unsigned in_channels,
+  unsigned kernel_size, unsigned depthwise,
+  const float* const mean, const float* const var,
+  unsigned affine_config, const float* const gamma, const float* const beta, float eps) {
+  if (depthwise) {
+    // Each filter acts on one channel. shape = [in_channels, kernel_size, 1]
+    for (unsigned ci = 0; ci < in_channels; ci++) {
+      float scale, shift;
+      batchnorm_scale_shift(ci, mean, var, affine_config, gamma, beta, eps, &scale, &shift);
+      B_folded[ci] = B[ci];
+      for (unsigned k = 0; k < kernel_size; k++) {
+        unsigned index = ci * kernel_size + k;
+        tap_bias[index] = W[index] * shift;
+        B_folded[ci] += tap_bias[index];
+        W_folded[index] = W[index] * scale;
+      }
+    }
+    return 0;
+  }
+
+  for (unsigned co = 0; co < out_channels; co++) {
+    B_folded[co] = B[co];
+    for (unsigned k = 0; k < kernel_size; k++) {
+      unsigned index = (co * kernel_size + k) * in_channels;
+      float sum = 0.0f;
+      for (unsigned ci = 0; ci < in_channels; ci++) {
+        float scale, shift;
+        batchnorm_scale_shift(ci, mean, var, affine_config, gamma, beta, eps, &scale, &shift);
+        sum += W[index + ci] * shift;
+        W_folded[index + ci] = W[index + ci] * scale;
+      }
+      tap_bias[co * kernel_size + k] = sum;
+      B_folded[co] += sum;
+    }
+  }
+  return 0;
+}
+
+int conv1d_lr_fold_batchnorm(float* W2_folded, float* B_folded, float* tap_bias,
+  const float* W1, const float* W2, const float* B, unsigned rank,
+  unsigned out_channels, unsigned in_channels, unsigned kernel_size,
+  const float* const mean, const float* const var,
+  unsigned affine_config, const float* const gamma, const float* const beta, float eps) {
+  // Bias contribution of every tap in the low-rank space. shape = [rank, kernel_size]
+  float* lr_tap_bias = (float*)malloc(rank * kernel_size * sizeof(float));
+  for (unsigned r = 0; r < rank; r++) {
+    for (unsigned k = 0; k < kernel_size; k++) {
+      unsigned index = (r * kernel_size + k) * in_channels;
+      float sum = 0.0f;
+      for (unsigned ci = 0; ci < in_channels; ci++) {
+        float scale, shift;
+        batchnorm_scale_shift(ci, mean, var, affine_config, gamma, beta, eps, &scale, &shift);
+        sum += W2[index + ci] * shift;
+        W2_folded[index + ci] = W2[index + ci] * scale;
+      }
+      lr_tap_bias[r * kernel_size + k] = sum;
+    }
+  }
+  // Project the low-rank tap contributions to the output channels using W1
+  for (unsigned co = 0; co < out_channels; co++) {
+    B_folded[co] = B[co];
+    for (unsigned k = 0; k < kernel_size; k++) {
+      float sum = 0.0f;
+      for (unsigned r = 0; r < rank; r++) {
+        sum += W1[co * rank + r] * lr_tap_bias[r * kernel_size + k];
+      }
+      tap_bias[co * kernel_size + k] = sum;
+      B_folded[co] += sum;
+    }
+  }
+  free(lr_tap_bias);
+  return 0;
+}
+
+// Compute one time step of the fused conv, including the bias and the activation
+static void conv1d_fused_step(float* output_row, unsigned t_out, unsigned out_channels,
+  const float* input_signal, unsigned in_time, unsigned in_channels,
+  unsigned padding, unsigned kernel_size, const ConvLayers_Fused_Params* tparams,
+  unsigned stride, unsigned activation, float* temp_rank_out) {
+  // Taps of the filter inside the input : [k_first, k_last]
+  unsigned t_in_start = t_out * stride;
+  unsigned k_first = (t_in_start < padding) ? padding - t_in_start : 0;
+  unsigned k_last = (t_in_start + kernel_size - 1 < in_time + padding) ?
+                      kernel_size - 1 : in_time + padding - 1 - t_in_start;
+  
+  if ((t_in_start + kernel_size <= padding) || (t_in_start >= in_time + padding)) {
+    // Filter completely in the padding region
+    memset(output_row, 0, out_channels * sizeof(float));
+  }
+  else {
+    const float* input_offset = input_signal + (t_in_start + k_first - padding) * in_channels;
+    unsigned num_taps = k_last - k_first + 1;
+    if (tparams->depthwise) {
+      offset_matVec_conv1d(tparams->W + k_first, input_offset, in_channels,
+        num_taps, kernel_size, in_channels, 1, output_row);
+    }
+    else if (tparams->W1) {
+      offset_matVec_conv1d(tparams->W + k_first * in_channels, input_offset,
+        tparams->rank, num_taps * in_channels, kernel_size * in_channels, 1, 0,
+        temp_rank_out);
+      offset_matVec_conv1d(tparams->W1, temp_rank_out, out_channels,
+        tparams->rank, tparams->rank, 1, 0, output_row);
+    }
+    else {
+      offset_matVec_conv1d(tparams->W + k_first * in_channels, input_offset,
+        out_channels, num_taps * in_channels, kernel_size * in_channels, 1, 0,
+        output_row);
+    }
+  }
+
+  for (unsigned co = 0; co < out_channels; co++) {
+    float bias = tparams->B[co];
+    if (tparams->tap_bias) {
+      // Remove the folded batchnorm offset of the taps in the zero padding
+      const float* tap_bias = tparams->tap_bias + co * kernel_size;
+      for (unsigned k = 0; k < kernel_size; k++) {
+        if ((t_in_start + k < padding) || (t_in_start + k >= in_time + padding)) {
+          bias -= tap_bias[k];
+        }
+      }
+    }
+    // Post-Conv activation. More activation functions can be added should the necessity arise
+    switch (activation) {
+      case 1 :
+        output_row[co] = sigmoid(output_row[co] + bias);
+        break;
+
+      case 2 :
+        output_row[co] = tanh(output_row[co] + bias);
+        break;
+
+      case 3 :
+        output_row[co] = relu(output_row[co] + bias);
+        break;
+      
+      default :
+        output_row[co] += bias;
+        break;
+    }
+  }
+}
+
+int conv1d_fused(float* output_signal, unsigned out_time, unsigned out_channels,
+  const float* input_signal, unsigned in_time, unsigned in_channels,
+  unsigned padding, unsigned kernel_size,
+  const void* params, unsigned stride, unsigned activation,
+  unsigned pool_padding, unsigned pool_kernel_size, unsigned pool_stride,
+  unsigned pool_activation) {
+
+  const ConvLayers_Fused_Params* tparams = (ConvLayers_Fused_Params*) params;
+  if (tparams->depthwise) {
+    out_channels = in_channels;
+  }
+  float* temp_rank_out = 0;
+  if (tparams->W1) {
+    temp_rank_out = (float*)malloc(tparams->rank * sizeof(float));
+  }
+
+  if (pool_kernel_size == 0) {
+    // No pooling. The conv epilogue writes directly to the output
+    for (unsigned t_out = 0; t_out < out_time; t_out++) {
+      conv1d_fused_step(output_signal + t_out * out_channels, t_out, out_channels,
+        input_signal, in_time, in_channels, padding, kernel_size, tparams,
+        stride, activation, temp_rank_out);
+    }
+    free(temp_rank_out);
+    return 0;
+  }
+
+  // Number of time steps at the output of the conv (input of the pool)
+  unsigned conv_time = (in_time + (padding << 1) - kernel_size) / stride + 1;
+  // Ring buffer holding the last pool_kernel_size time steps of the conv output
+  float* ring = (float*)malloc(pool_kernel_size * out_channels * sizeof(float));
+  float scale = 1.0/(float)pool_kernel_size; // To avoid divisions
+  unsigned next_conv = 0; // Next conv time step to be computed
+  for (unsigned t_in = 0, t_out = 0; t_out < out_time; t_out++, t_in += pool_stride) {
+    // Conv time steps covered by the pool window (excluding the pool padding) : [c_first, c_last]
+    unsigned c_first = (t_in > pool_padding) ? t_in - pool_padding : 0;
+    unsigned c_end = t_in + pool_kernel_size; // exclusive, with the padding offset
+    unsigned c_last_plus_one = (c_end > pool_padding) ? c_end - pool_padding : 0;
+    if (c_last_plus_one > conv_time) {
+      c_last_plus_one = conv_time;
+    }
+    // Conv time steps skipped by a pool stride larger than the kernel size are never computed
+    if (next_conv < c_first) {
+      next_conv = c_first;
+    }
+    for (; next_conv < c_last_plus_one; next_conv++) {
+      conv1d_fused_step(ring + (next_conv % pool_kernel_size) * out_channels,
+        next_conv, out_channels, input_signal, in_time, in_channels,
+        padding, kernel_size, tparams, stride, activation, temp_rank_out);
+    }
+    float* output_row = output_signal + t_out * out_channels;
+    for (unsigned co = 0; co < out_channels; co++) {
+      float sum = 0;
+      for (unsigned c = c_first; c < c_last_plus_one; c++) {
+        sum += ring[(c % pool_kernel_size) * out_channels + co];
+      }
+      switch (pool_activation) {
+        case 1 :
+          output_row[co] = sigmoid(sum * scale);
+          break;
+
+        case 2 :
+          output_row[co] = tanh(sum * scale);
+          break;
+
+        case 3 :
+          output_row[co] = relu(sum * scale);
+          break;
+
+        default :
+          output_row[co] = sum * scale;
+          break;
+      }
+    }
+  }
+  free(ring);
+  free(temp_rank_out);
+  return 0;
+}
@@ -91,3 +91,59 @@ int fastgrnn(float* const hiddenState, unsigned hiddenDims,
   }
   return 0;
 }
+
+int fastgrnn_batch(float* const hiddenStates, unsigned hiddenDims,
+  const float* const input, unsigned inputDims, unsigned inputStride,
+  unsigned batch, const void* params, void* buffers, int normalize) {
+
+  const FastGRNN_Params* tparams = (const FastGRNN_Params*)params;
+  FastGRNN_Buffers* tbuffers = (FastGRNN_Buffers*)buffers;
+
+  if (tbuffers->preComp == 0) return ERR_PRECOMP_NOT_INIT;
+  if (normalize && tbuffers->normFeatures == 0) return ERR_NORMFEATURES_NOT_INIT;
+
+  // Normalize the features. Without normalization, the input is used in place
+  const float* features = input;
+  unsigned featureStride = inputStride;
+  if (normalize) {
+    for (unsigned b = 0; b < batch; b++) {
+      v_add(1.0f, input + b * inputStride, -1.0f, tparams->mean, inputDims,
+        tbuffers->normFeatures + b * inputDims);
+      v_div(tparams->stdDev, tbuffers->normFeatures + b * inputDims, inputDims,
+        tbuffers->normFeatures + b * inputDims);
+    }
+    features = tbuffers->normFeatures;
+    featureStride = inputDims;
+  }
+
+  // Process the new inputs and previous hidden states. Each sum is accumulated
+  // in the same order as matVec, so the result matches fastgrnn exactly
+  for (unsigned i = 0; i < hiddenDims; i++) {
+    const float* W_row = tparams->W + i * inputDims;
+    const float* U_row = tparams->U + i * hiddenDims;
+    for (unsigned b = 0; b < batch; b++) {
+      const float* x = features + b * featureStride;
+      const float* h = hiddenStates + b * hiddenDims;
+      float sumW = 0.0f, sumU = 0.0f;
+      for (unsigned col = 0; col < inputDims; col++) {
+        sumW += W_row[col] * x[col];
+      }
+      for (unsigned col = 0; col < hiddenDims; col++) {
+        sumU += U_row[col] * h[col];
+      }
+      tbuffers->preComp[b * hiddenDims + i] = sumW + sumU;
+    }
+  }
+
+  // Apply the gate to generate the new hidden states
+  for (unsigned b = 0; b < batch; b++) {
+    float* h = hiddenStates + b * hiddenDims;
+    const float* preComp = tbuffers->preComp + b * hiddenDims;
+    for (unsigned i = 0; i < hiddenDims; i++) {
+      float gate = sigmoid(preComp[i] + tparams->Bg[i]);
+      float update = tanh(preComp[i] + tparams->Bh[i]);
+      h[i] = gate * h[i] + (tparams->sigmoid_zeta * (1.0 - gate) + tparams->sigmoid_nu) * update;
+    }
+  }
+  return 0;
+}
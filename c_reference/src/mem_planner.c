@@ -0,0 +1,98 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <stdlib.h>
+#include "mem_planner.h"
+
+static unsigned align_up(unsigned size, unsigned alignment) {
+  if (alignment <= 1) {
+    return size;
+  }
+  return ((size + alignment - 1) / alignment) * alignment;
+}
+
+unsigned naive_memory_size(const MemPlan_Tensor* tensors, unsigned num_tensors,
+  unsigned alignment) {
+  unsigned total = 0;
+  for (unsigned i = 0; i < num_tensors; i++) {
+    total += align_up(tensors[i].size, alignment);
+  }
+  return total;
+}
+
+int plan_static_memory(MemPlan_Tensor* tensors, unsigned num_tensors,
+  unsigned alignment, unsigned* peak) {
+  *peak = 0;
+  if (num_tensors == 0) {
+    return 0;
+  }
+  for (unsigned i = 0; i < num_tensors; i++) {
+    if (tensors[i].last_use < tensors[i].first_use) {
+      return ERR_MEM_PLAN_INVALID_TENSOR;
+    }
+  }
+
+  // order : tensor indices sorted by decreasing size (the placement order)
+  // placed : indices of the already placed tensors, sorted by increasing offset
+  unsigned* order = (unsigned*)malloc(2 * num_tensors * sizeof(unsigned));
+  if (order == 0) {
+    return ERR_MEM_PLAN_NO_MEMORY;
+  }
+  unsigned* placed = order + num_tensors;
+  unsigned num_placed = 0;
+
+  // Stable insertion sort. The number of tensors in a model is small
+  for (unsigned i = 0; i < num_tensors; i++) {
+    unsigned j = i;
+    while (j > 0 && tensors[order[j - 1]].size < tensors[i].size) {
+      order[j] = order[j - 1];
+      j--;
+    }
+    order[j] = i;
+  }
+
+  for (unsigned i = 0; i < num_tensors; i++) {
+    MemPlan_Tensor* cur = &tensors[order[i]];
+    unsigned cur_size = align_up(cur->size, alignment);
+    unsigned best_offset = 0, best_gap = 0, found = 0;
+    unsigned prev_end = 0;
+
+    // Walk over the live (overlapping) tensors in the order of their offsets and
+    // look for the smallest gap which can hold the current tensor
+    for (unsigned p = 0; p < num_placed; p++) {
+      const MemPlan_Tensor* other = &tensors[placed[p]];
+      if (other->last_use < cur->first_use || cur->last_use < other->first_use) {
+        continue;
+      }
+      if (other->offset >= prev_end) {
+        unsigned gap = other->offset - prev_end;
+        if (gap >= cur_size && (!found || gap < best_gap)) {
+          best_offset = prev_end;
+          best_gap = gap;
+          found = 1;
+        }
+      }
+      unsigned other_end = other->offset + align_up(other->size, alignment);
+      if (other_end > prev_end) {
+        prev_end = other_end;
+      }
+    }
+    cur->offset = found ? best_offset : prev_end;
+
+    if (cur->offset + cur_size > *peak) {
+      *peak = cur->offset + cur_size;
+    }
+
+    // Keep the placed list sorted by offset
+    unsigned p = num_placed;
+    while (p > 0 && tensors[placed[p - 1]].offset > cur->offset) {
+      placed[p] = placed[p - 1];
+      p--;
+    }
+    placed[p] = order[i];
+    num_placed++;
+  }
+
+  free(order);
+  return 0;
+}
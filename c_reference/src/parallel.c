@@ -0,0 +1,56 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#ifdef MULTITHREADED
+  #include <pthread.h>
+  #include <stdlib.h>
+#endif
+#include "parallel.h"
+
+#ifdef MULTITHREADED
+typedef struct Parallel_For_Arg {
+  void (*task)(void*);
+  void* task_args;
+} Parallel_For_Arg;
+
+static void* parallel_for_thread(void* arg) {
+  Parallel_For_Arg* thread_arg = (Parallel_For_Arg*)arg;
+  thread_arg->task(thread_arg->task_args);
+  return 0;
+}
+#endif
+
+void parallel_for(void (*task)(void*), void* task_args, unsigned arg_size,
+  unsigned num_tasks) {
+  #ifdef MULTITHREADED
+    if (num_tasks > 1) {
+      pthread_t* threads = (pthread_t*)malloc((num_tasks - 1) * sizeof(pthread_t));
+      Parallel_For_Arg* thread_args = (Parallel_For_Arg*)malloc((num_tasks - 1) * sizeof(Parallel_For_Arg));
+      unsigned num_started = 0;
+      // Without the memory for the threads, all the tasks run on the calling thread
+      for (unsigned i = 1; threads && thread_args && i < num_tasks; i++) {
+        thread_args[i - 1].task = task;
+        thread_args[i - 1].task_args = (char*)task_args + i * arg_size;
+        if (pthread_create(&threads[i - 1], 0, parallel_for_thread, &thread_args[i - 1])) {
+          // Could not start the thread. Run the remaining tasks on the calling thread
+          break;
+        }
+        num_started++;
+      }
+      task(task_args);
+      for (unsigned i = num_started + 1; i < num_tasks; i++) {
+        task((char*)task_args + i * arg_size);
+      }
+      for (unsigned i = 0; i < num_started; i++) {
+        pthread_join(threads[i], 0);
+      }
+      free(thread_args);
+      free(threads);
+      return;
+    }
+  #endif
+
+  for (unsigned i = 0; i < num_tasks; i++) {
+    task((char*)task_args + i * arg_size);
+  }
+}
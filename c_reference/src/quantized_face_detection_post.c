@@ -0,0 +1,249 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include "quantized_face_detection_post.h"
+
+// Number of score buckets of the top-k sort, and the number of score bits per bucket
+#define SCORE_BUCKETS 256
+#define SCORE_BUCKET_SHIFT 7
+// Buckets up to this size are sorted by insertion, the larger ones by counting
+#define SCORE_INSERTION_SORT_MAX 16
+// Range of the logits (Q16) passed to the sigmoid and the exp
+#define LOGIT_LIMIT (24 << 16)
+
+const Q_Face_Detection_Head q_face_detection_qvga_heads[Q_FACE_DETECTION_QVGA_NUM_HEADS] = {
+  {30, 40, 8, 8},
+  {30, 40, 8, 16},
+  {15, 20, 16, 32},
+  {15, 20, 16, 48}
+};
+
+const Q_Face_Detection_Head q_face_detection_qvga_fast_heads[Q_FACE_DETECTION_QVGA_FAST_NUM_HEADS] = {
+  {15, 20, 16, 16},
+  {15, 20, 16, 32},
+  {15, 20, 16, 48}
+};
+
+// e^{x} for x in Q16, returned in Q16 and saturated to the Q31 range
+// e^{x} = 2^{n + f} with n integer and f in [0, 1). 2^{f} is a cubic polynomial (max error 1e-4)
+static Q31_T exp_q16(Q31_T x) {
+  Q63_T y = ((Q63_T)x * 94548) >> 16;
+  Q31_T n = (Q31_T)(y >> 16);
+  Q63_T f = y & 0xFFFF;
+  Q63_T p = 65536 + ((f * (45559 + ((f * (14820 + ((f * 5157) >> 16))) >> 16))) >> 16);
+  if (n > 13) {
+    return 0x7FFFFFFF;
+  } else if (n < -17) {
+    return 0;
+  }
+  return (Q31_T)(n >= 0 ? (p << n) : (p >> (-n)));
+}
+
+// Probability (Q15) of the face class, from the face - background logit in Q16
+static Q15_T sigmoid_q15(Q63_T logit) {
+  if (logit > LOGIT_LIMIT) {
+    logit = LOGIT_LIMIT;
+  } else if (logit < -LOGIT_LIMIT) {
+    logit = -LOGIT_LIMIT;
+  }
+  Q63_T ret = ((Q63_T)65536 << 15) / (65536 + (Q63_T)exp_q16((Q31_T)(-logit)));
+  return (Q15_T)(ret > Q15_TMAX ? Q15_TMAX : ret);
+}
+
+// Smallest logit (Q16) whose probability is above conf_thresh. Used to reject the priors without computing the sigmoid
+static Q63_T logit_threshold(Q15_T conf_thresh) {
+  Q63_T lo = -LOGIT_LIMIT - 1, hi = LOGIT_LIMIT + 1;
+  while (hi - lo > 1) {
+    Q63_T mid = lo + ((hi - lo) >> 1);
+    if (sigmoid_q15(mid) > conf_thresh) {
+      hi = mid;
+    } else {
+      lo = mid;
+    }
+  }
+  return hi;
+}
+
+// Sorts order[begin, end) by decreasing score, keeping the order of the indices for equal scores
+static void sort_bucket(const Q15_T* scores, ITER_T* order, ITER_T* tmp,
+  ITER_T begin, ITER_T end) {
+  if (end - begin <= SCORE_INSERTION_SORT_MAX) {
+    for (ITER_T i = begin + 1; i < end; i++) {
+      ITER_T cur = order[i];
+      ITER_T j = i;
+      while (j > begin && scores[order[j - 1]] < scores[cur]) {
+        order[j] = order[j - 1];
+        j--;
+      }
+      order[j] = cur;
+    }
+    return;
+  }
+
+  // The scores of a bucket only differ in their SCORE_BUCKET_SHIFT low bits
+  const ITER_T mask = (1 << SCORE_BUCKET_SHIFT) - 1;
+  ITER_T start[1 << SCORE_BUCKET_SHIFT];
+  for (ITER_T v = 0; v <= mask; v++) {
+    start[v] = 0;
+  }
+  for (ITER_T i = begin; i < end; i++) {
+    start[scores[order[i]] & mask]++;
+  }
+  ITER_T offset = begin;
+  for (S_ITER_T v = mask; v >= 0; v--) {
+    ITER_T count = start[v];
+    start[v] = offset;
+    offset += count;
+  }
+  for (ITER_T i = begin; i < end; i++) {
+    tmp[start[scores[order[i]] & mask]++] = order[i];
+  }
+  for (ITER_T i = begin; i < end; i++) {
+    order[i] = tmp[i];
+  }
+}
+
+static Q15_T box_coordinate(Q63_T v, ITER_T limit) {
+  if (v < 0) {
+    v = 0;
+  } else if (v > ((Q63_T)limit << 16)) {
+    v = (Q63_T)limit << 16;
+  }
+  return (Q15_T)((v + (1 << (15 - Q_FACE_DETECTION_BOX_SCALE))) >> (16 - Q_FACE_DETECTION_BOX_SCALE));
+}
+
+static void decode_box(const Q15_T* output, const Q_Face_Detection_Post_Params* params,
+  ITER_T num_priors, ITER_T prior, Q_Face_Detection_Box* box) {
+  const Q_Face_Detection_Head* head = params->heads;
+  ITER_T r = prior;
+  while (r >= head->rows * head->cols) {
+    r -= head->rows * head->cols;
+    head++;
+  }
+  ITER_T i = r / head->cols, j = r % head->cols;
+
+  // Offsets in Q16, prior centers and sizes in pixels (Q16)
+  const Q15_T* loc = output + 2 * num_priors + 4 * prior;
+  SCALE_T shift = 16 - params->scale;
+  Q63_T lx = ((Q63_T)loc[0] * ((Q63_T)1 << shift)) * Q_FACE_DETECTION_VARIANCE_CENTER >> 15;
+  Q63_T ly = ((Q63_T)loc[1] * ((Q63_T)1 << shift)) * Q_FACE_DETECTION_VARIANCE_CENTER >> 15;
+  Q63_T lw = ((Q63_T)loc[2] * ((Q63_T)1 << shift)) * Q_FACE_DETECTION_VARIANCE_SIZE >> 15;
+  Q63_T lh = ((Q63_T)loc[3] * ((Q63_T)1 << shift)) * Q_FACE_DETECTION_VARIANCE_SIZE >> 15;
+  lw = lw > LOGIT_LIMIT ? LOGIT_LIMIT : (lw < -LOGIT_LIMIT ? -LOGIT_LIMIT : lw);
+  lh = lh > LOGIT_LIMIT ? LOGIT_LIMIT : (lh < -LOGIT_LIMIT ? -LOGIT_LIMIT : lh);
+
+  Q63_T cx = ((Q63_T)((2 * j + 1) * head->step) << 15) + lx * head->anchor;
+  Q63_T cy = ((Q63_T)((2 * i + 1) * head->step) << 15) + ly * head->anchor;
+  Q63_T half_w = ((Q63_T)head->anchor * exp_q16((Q31_T)lw)) >> 1;
+  Q63_T half_h = ((Q63_T)head->anchor * exp_q16((Q31_T)lh)) >> 1;
+
+  box->x1 = box_coordinate(cx - half_w, params->img_w);
+  box->y1 = box_coordinate(cy - half_h, params->img_h);
+  box->x2 = box_coordinate(cx + half_w, params->img_w);
+  box->y2 = box_coordinate(cy + half_h, params->img_h);
+}
+
+// IoU(a, b) > thresh, computed as inter * 2^15 > thresh * union
+static int box_overlaps(const Q_Face_Detection_Box* a,
+  const Q_Face_Detection_Box* b, Q15_T thresh) {
+  Q31_T iw = (a->x2 < b->x2 ? a->x2 : b->x2) - (a->x1 > b->x1 ? a->x1 : b->x1);
+  Q31_T ih = (a->y2 < b->y2 ? a->y2 : b->y2) - (a->y1 > b->y1 ? a->y1 : b->y1);
+  if (iw <= 0 || ih <= 0) {
+    return 0;
+  }
+  Q63_T inter = (Q63_T)iw * ih;
+  Q63_T area_a = (Q63_T)(a->x2 - a->x1) * (a->y2 - a->y1);
+  Q63_T area_b = (Q63_T)(b->x2 - b->x1) * (b->y2 - b->y1);
+  return (inter << 15) > (Q63_T)thresh * (area_a + area_b - inter);
+}
+
+ITER_T q_face_detection_num_priors(const Q_Face_Detection_Head* heads,
+  ITER_T num_heads) {
+  ITER_T num_priors = 0;
+  for (ITER_T h = 0; h < num_heads; h++) {
+    num_priors += heads[h].rows * heads[h].cols;
+  }
+  return num_priors;
+}
+
+int q_face_detection_postprocess(const Q15_T* output,
+  const Q_Face_Detection_Post_Params* params,
+  const Q_Face_Detection_Post_Buffers* buffers,
+  Q_Face_Detection_Box* detections, ITER_T* num_detections) {
+  *num_detections = 0;
+  if (params->heads == 0 || params->num_heads == 0 || params->scale < 0 ||
+      params->scale > 16 ||
+      params->img_h >= (1 << (15 - Q_FACE_DETECTION_BOX_SCALE)) ||
+      params->img_w >= (1 << (15 - Q_FACE_DETECTION_BOX_SCALE))) {
+    return ERR_FACE_DETECTION_POST_INVALID_PARAMS;
+  }
+  if (buffers->scores == 0 || buffers->order == 0) {
+    return ERR_FACE_DETECTION_POST_NOT_INIT;
+  }
+
+  const ITER_T num_priors = q_face_detection_num_priors(params->heads, params->num_heads);
+  Q15_T* scores = buffers->scores;
+  ITER_T* order = buffers->order;
+  ITER_T* tmp = buffers->order + num_priors;
+
+  // Pre-filter and score. Rejected priors get a negative score
+  const Q63_T threshold = logit_threshold(params->conf_thresh);
+  const SCALE_T shift = 16 - params->scale;
+  ITER_T start[SCORE_BUCKETS];
+  for (ITER_T b = 0; b < SCORE_BUCKETS; b++) {
+    start[b] = 0;
+  }
+  for (ITER_T p = 0; p < num_priors; p++) {
+    Q63_T logit = ((Q63_T)output[2 * p + 1] - output[2 * p]) * ((Q63_T)1 << shift);
+    scores[p] = -1;
+    if (logit >= threshold) {
+      Q15_T score = sigmoid_q15(logit);
+      if (score > params->conf_thresh) {
+        scores[p] = score;
+        start[score >> SCORE_BUCKET_SHIFT]++;
+      }
+    }
+  }
+
+  // Top-k. Bucket the candidates by their high score bits, then sort the buckets until top_k candidates are in order
+  ITER_T num_candidates = 0;
+  for (S_ITER_T b = SCORE_BUCKETS - 1; b >= 0; b--) {
+    ITER_T count = start[b];
+    start[b] = num_candidates;
+    num_candidates += count;
+  }
+  for (ITER_T p = 0; p < num_priors; p++) {
+    if (scores[p] >= 0) {
+      order[start[scores[p] >> SCORE_BUCKET_SHIFT]++] = p;
+    }
+  }
+  // start[b] is now the end of bucket b
+  ITER_T top_k = num_candidates < params->top_k ? num_candidates : params->top_k;
+  ITER_T begin = 0;
+  for (S_ITER_T b = SCORE_BUCKETS - 1; b >= 0 && begin < top_k; b--) {
+    sort_bucket(scores, order, tmp, begin, start[b]);
+    begin = start[b];
+  }
+
+  // Decode and NMS. The candidates are decoded as they are visited, hence none after the last detection
+  ITER_T kept = 0;
+  for (ITER_T k = 0; k < top_k && kept < params->max_detections; k++) {
+    Q_Face_Detection_Box box;
+    box.score = scores[order[k]];
+    box.prior = order[k];
+    decode_box(output, params, num_priors, order[k], &box);
+
+    ITER_T suppressed = 0;
+    for (ITER_T d = 0; d < kept; d++) {
+      if (box_overlaps(&detections[d], &box, params->nms_thresh)) {
+        suppressed = 1;
+        break;
+      }
+    }
+    if (!suppressed) {
+      detections[kept++] = box;
+    }
+  }
+  *num_detections = kept;
+  return 0;
+}
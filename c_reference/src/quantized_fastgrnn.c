@@ -266,3 +266,167 @@ int q15_fastgrnn(Q15_T* const hiddenState, ITER_T hiddenDims,
   }
   return 0;
 }
+
+// Gate and update of the batched FastGRNN cells, starting from preComp1 = W x
+// and preComp2 = U h for every cell of the batch. The element-wise operations
+// run over the whole batch at once, the bias additions once per cell
+static void q15_fastgrnn_batch_update(Q15_T* const hiddenStates,
+  ITER_T hiddenDims, ITER_T batch, const Q15_T* const Bg,
+  const Q15_T* const Bh, Q15_T sigmoid_zeta, Q15_T sigmoid_nu,
+  Q15_T* const preComp1, Q15_T* const preComp2, Q15_T* const preComp3,
+  const Q15_FastGRNN_Scales* tscales) {
+  ITER_T len = batch * hiddenDims;
+
+  q15_v_add(preComp1, preComp2, len, preComp1, tscales->mV1AddMV2,
+    tscales->mV2AddMV1, tscales->mV1AddMV2Out, tscales->mV1AddMV2Demote);
+
+  // Apply the gate to generate the new hidden states
+  for (ITER_T b = 0; b < batch; b++) {
+    q15_v_add(preComp1 + b * hiddenDims, Bg, hiddenDims,
+      preComp2 + b * hiddenDims, tscales->pC1AddBg, tscales->Bg,
+      tscales->pC1AddBgOut, tscales->pC1AddBgDemote);
+  }
+  q15_v_sigmoid(preComp2, len, preComp2, tscales->div, tscales->add,
+    tscales->sigmoidLimit, tscales->sigmoidScaleIn, tscales->sigmoidScaleOut,
+    tscales->useTableSigmoid);
+  for (ITER_T b = 0; b < batch; b++) {
+    q15_v_add(preComp1 + b * hiddenDims, Bh, hiddenDims,
+      preComp1 + b * hiddenDims, tscales->pC1AddBh, tscales->Bh,
+      tscales->pC1AddBhOut, tscales->pC1AddBhDemote);
+  }
+  q15_v_tanh(preComp1, len, preComp1, tscales->tanhScaleIn,
+    tscales->tanhScaleOut, tscales->useTableTanH);
+  q15_v_hadamard(preComp2, hiddenStates, len, preComp3,
+    tscales->gateHDHiddenState, tscales->hiddenStateHDGate);
+  q15_v_scalar_sub(tscales->qOne, preComp2, len, preComp2, tscales->qOneScale,
+    tscales->qOneSubGate, tscales->qOneSubGateOut);
+  q15_v_scalar_mul(sigmoid_zeta, preComp2, len, preComp2, tscales->sigmoidZeta,
+    tscales->sigmoidZetaMulQOneSubGate);
+  q15_v_scalar_add(sigmoid_nu, preComp2, len, preComp2, tscales->sigmoidNu,
+    tscales->sigmoidNuAddQOneSubGate, tscales->sigmoidNuAddQOneSubGateOut);
+  q15_v_hadamard(preComp2, preComp1, len, preComp1,
+    tscales->sigmoidNuAddQOneSubGateHDUpdate,
+    tscales->updateHDSigmoidNuAddQOneSubGate);
+  q15_v_add(preComp3, preComp1, len, hiddenStates, tscales->pC3AddPC1,
+    tscales->pC1AddPC3, tscales->hiddenStateOut, tscales->hiddenStateDemote);
+}
+
+int q7xq15_q15_fastgrnn_batch(Q15_T* const hiddenStates, ITER_T hiddenDims,
+  const Q7_T* const input, ITER_T inputDims, ITER_T inputStride, ITER_T batch,
+  const void* params, void* buffers, const void* scales, int normalize) {
+
+  const Q7xQ15_FastGRNN_Params* tparams = (const Q7xQ15_FastGRNN_Params*)params;
+  Q7xQ15_FastGRNN_Buffers* tbuffers = (Q7xQ15_FastGRNN_Buffers*)buffers;
+  const Q15_FastGRNN_Scales* tscales = (const Q15_FastGRNN_Scales*)scales;
+
+  if (tbuffers->preComp1 == 0) return ERR_PRECOMP_NOT_INIT;
+  if (tbuffers->preComp2 == 0) return ERR_PRECOMP_NOT_INIT;
+  if (tbuffers->preComp3 == 0) return ERR_PRECOMP_NOT_INIT;
+  if (tbuffers->normFeatures == 0) return ERR_NORMFEATURES_NOT_INIT;
+
+  // Gather (and normalize) the features of the batch into normFeatures
+  for (ITER_T b = 0; b < batch; b++) {
+    const Q7_T* input_offset = input + b * inputStride;
+    Q7_T* features = tbuffers->normFeatures + b * inputDims;
+    if (normalize) {
+      // This diverges from the original implementation because of
+      // impracticality of scaled addition beyond 0, 1, and -1 multipliers
+      q7_v_sub(input_offset, tparams->mean, inputDims, features, tscales->input,
+        tscales->mean, tscales->meanSub);
+      // Assuming stdDev values are stored in inverse form
+      q7_v_hadamard(tparams->stdDev, features, inputDims, features,
+        tscales->stdDev, tscales->normFeaturesHDStdDev);
+    }
+    else {
+      for (ITER_T d = 0; d < inputDims; ++d) {
+        features[d] = input_offset[d];
+      }
+    }
+  }
+
+  // Process the new inputs and previous hidden states
+  #ifdef SPARSE
+    for (ITER_T b = 0; b < batch; b++) {
+      q15xq7_q15_m_sparse_mulvec(tparams->Wids, tparams->Wvals,
+        tbuffers->normFeatures + b * inputDims, hiddenDims, inputDims,
+        tbuffers->preComp1 + b * hiddenDims, tscales->W,
+        tscales->normFeaturesMVW, tscales->H1W, tscales->H2W);
+      q15_m_sparse_mulvec(tparams->Uids, tparams->Uvals,
+        hiddenStates + b * hiddenDims, hiddenDims, hiddenDims,
+        tbuffers->preComp2 + b * hiddenDims, tscales->U,
+        tscales->hiddenStateMVU, tscales->H1U, tscales->H2U);
+    }
+  #else
+    q15xq7_q15_m_mulvec_batch(tparams->W, tbuffers->normFeatures, hiddenDims,
+      inputDims, batch, tbuffers->preComp1, tscales->W,
+      tscales->normFeaturesMVW, tscales->H1W, tscales->H2W);
+    q15_m_mulvec_batch(tparams->U, hiddenStates, hiddenDims, hiddenDims,
+      batch, tbuffers->preComp2, tscales->U, tscales->hiddenStateMVU,
+      tscales->H1U, tscales->H2U);
+  #endif
+
+  q15_fastgrnn_batch_update(hiddenStates, hiddenDims, batch, tparams->Bg,
+    tparams->Bh, tparams->sigmoid_zeta, tparams->sigmoid_nu,
+    tbuffers->preComp1, tbuffers->preComp2, tbuffers->preComp3, tscales);
+  return 0;
+}
+
+int q15_fastgrnn_batch(Q15_T* const hiddenStates, ITER_T hiddenDims,
+  const Q15_T* const input, ITER_T inputDims, ITER_T inputStride, ITER_T batch,
+  const void* params, void* buffers, const void* scales, int normalize) {
+
+  const Q15_FastGRNN_Params* tparams = (const Q15_FastGRNN_Params*)params;
+  Q15_FastGRNN_Buffers* tbuffers = (Q15_FastGRNN_Buffers*)buffers;
+  const Q15_FastGRNN_Scales* tscales = (const Q15_FastGRNN_Scales*)scales;
+
+  if (tbuffers->preComp1 == 0) return ERR_PRECOMP_NOT_INIT;
+  if (tbuffers->preComp2 == 0) return ERR_PRECOMP_NOT_INIT;
+  if (tbuffers->preComp3 == 0) return ERR_PRECOMP_NOT_INIT;
+  if (tbuffers->normFeatures == 0) return ERR_NORMFEATURES_NOT_INIT;
+
+  // Gather (and normalize) the features of the batch into normFeatures
+  for (ITER_T b = 0; b < batch; b++) {
+    const Q15_T* input_offset = input + b * inputStride;
+    Q15_T* features = tbuffers->normFeatures + b * inputDims;
+    if (normalize) {
+      // This diverges from the original implementation because of
+      // impracticality of scaled addition beyond 0, 1, and -1 multipliers
+      q15_v_sub(input_offset, tparams->mean, inputDims, features, tscales->input,
+        tscales->mean, tscales->meanSub);
+      // Assuming stdDev values are stored in inverse form
+      q15_v_hadamard(tparams->stdDev, features, inputDims, features,
+        tscales->stdDev, tscales->normFeaturesHDStdDev);
+    }
+    else {
+      for (ITER_T d = 0; d < inputDims; ++d) {
+        features[d] = input_offset[d];
+      }
+    }
+  }
+
+  // Process the new inputs and previous hidden states
+  #ifdef SPARSE
+    for (ITER_T b = 0; b < batch; b++) {
+      q15_m_sparse_mulvec(tparams->Wids, tparams->Wvals,
+        tbuffers->normFeatures + b * inputDims, hiddenDims, inputDims,
+        tbuffers->preComp1 + b * hiddenDims, tscales->W,
+        tscales->normFeaturesMVW, tscales->H1W, tscales->H2W);
+      q15_m_sparse_mulvec(tparams->Uids, tparams->Uvals,
+        hiddenStates + b * hiddenDims, hiddenDims, hiddenDims,
+        tbuffers->preComp2 + b * hiddenDims, tscales->U,
+        tscales->hiddenStateMVU, tscales->H1U, tscales->H2U);
+    }
+  #else
+    q15_m_mulvec_batch(tparams->W, tbuffers->normFeatures, hiddenDims,
+      inputDims, batch, tbuffers->preComp1, tscales->W,
+      tscales->normFeaturesMVW, tscales->H1W, tscales->H2W);
+    q15_m_mulvec_batch(tparams->U, hiddenStates, hiddenDims, hiddenDims,
+      batch, tbuffers->preComp2, tscales->U, tscales->hiddenStateMVU,
+      tscales->H1U, tscales->H2U);
+  #endif
+
+  q15_fastgrnn_batch_update(hiddenStates, hiddenDims, batch, tparams->Bg,
+    tparams->Bh, tparams->sigmoid_zeta, tparams->sigmoid_nu,
+    tbuffers->preComp1, tbuffers->preComp2, tbuffers->preComp3, tscales);
+  return 0;
+}
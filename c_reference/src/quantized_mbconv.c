@@ -2,6 +2,7 @@
 // Licensed under the MIT license.
 
 #include "quantized_mbconv.h"
+#include "parallel.h"
 
 void q7_mbconv_block(const Q7_T* const input, const Q7_T* const filter1,
   const Q7_T* const BN1W, const Q7_T* const BN1B, const Q7_T* const filter2,
@@ -40,7 +41,8 @@ void q7_mbconv_block(const Q7_T* const input, const Q7_T* const filter1,
       margin = (ITER_T)((S_ITER_T)HF - HPadU - (S_ITER_T)HStride);
     }
 
-    for (ITER_T i = 0; i < margin; i++) {
+    // The margin rows past the end of the input are padding, which is never read
+    for (ITER_T i = 0; (i < margin) && (i < H); i++) {
       ITER_T HIndexIn = i * HOffsetIn + NIndexIn;
       ITER_T HIndexC1 = i * HOffsetC1;
       for (ITER_T j = 0; j < W; j++) {
@@ -298,7 +300,8 @@ void q7xq15_q15_mbconv_block(const Q7_T* const input,
       margin = (ITER_T)((S_ITER_T)HF - HPadU - (S_ITER_T)HStride);
     }
 
-    for (ITER_T i = 0; i < margin; i++) {
+    // The margin rows past the end of the input are padding, which is never read
+    for (ITER_T i = 0; (i < margin) && (i < H); i++) {
       ITER_T HIndexIn = i * HOffsetIn + NIndexIn;
       ITER_T HIndexC1 = i * HOffsetC1;
       for (ITER_T j = 0; j < W; j++) {
@@ -556,7 +559,8 @@ void q15xq7_q7_mbconv_block(const Q15_T* const input,
       margin = (ITER_T)((S_ITER_T)HF - HPadU - (S_ITER_T)HStride);
     }
 
-    for (ITER_T i = 0; i < margin; i++) {
+    // The margin rows past the end of the input are padding, which is never read
+    for (ITER_T i = 0; (i < margin) && (i < H); i++) {
       ITER_T HIndexIn = i * HOffsetIn + NIndexIn;
       ITER_T HIndexC1 = i * HOffsetC1;
       for (ITER_T j = 0; j < W; j++) {
@@ -814,7 +818,8 @@ void q15xq7_q15_mbconv_block(const Q15_T* const input,
       margin = (ITER_T)((S_ITER_T)HF - HPadU - (S_ITER_T)HStride);
     }
 
-    for (ITER_T i = 0; i < margin; i++) {
+    // The margin rows past the end of the input are padding, which is never read
+    for (ITER_T i = 0; (i < margin) && (i < H); i++) {
       ITER_T HIndexIn = i * HOffsetIn + NIndexIn;
       ITER_T HIndexC1 = i * HOffsetC1;
       for (ITER_T j = 0; j < W; j++) {
@@ -1072,7 +1077,8 @@ void q15_mbconv_block(const Q15_T* const input, const Q15_T* const filter1,
       margin = (ITER_T)((S_ITER_T)HF - HPadU - (S_ITER_T)HStride);
     }
 
-    for (ITER_T i = 0; i < margin; i++) {
+    // The margin rows past the end of the input are padding, which is never read
+    for (ITER_T i = 0; (i < margin) && (i < H); i++) {
       ITER_T HIndexIn = i * HOffsetIn + NIndexIn;
       ITER_T HIndexC1 = i * HOffsetC1;
       for (ITER_T j = 0; j < W; j++) {
@@ -1292,3 +1298,692 @@ void q15_mbconv_block(const Q15_T* const input, const Q15_T* const filter1,
     }
   }
 }
+
+// Scales a sum of the first, second or third convolution of the sparse blocks.
+// The sums of the Q7 input block are Q31, as in q7xq15_q15_mbconv_block(), those of the Q15 input block are Q63
+static inline Q63_T q_sparse_mbconv_scale(Q63_T sum, unsigned wide,
+  SCALE_T shl, SCALE_T shr) {
+  if (!wide) {
+    Q31_T narrow = (Q31_T)sum;
+    #ifdef SHIFT
+      return ((narrow << shl) >> shr);
+    #else
+      return ((narrow * shl) / shr);
+    #endif
+  }
+  #ifdef SHIFT
+    return ((sum << shl) >> shr);
+  #else
+    return ((sum * shl) / shr);
+  #endif
+}
+
+// Dot product of the vector vec (Q7 if in_size is 1, else Q15) with the weights of output channel r of a packed 1x1 filter
+static Q63_T q_sparse_mbconv_dot(const void* const vec, unsigned in_size,
+  const Q15_Sparse_Filter* const filter, ITER_T r) {
+  Q63_T sum = 0;
+  if (filter->row_ptr) {
+    ITER_T end = filter->row_ptr[r + 1];
+    if (in_size == sizeof(Q7_T)) {
+      for (ITER_T e = filter->row_ptr[r]; e < end; e++) {
+        sum += ((Q31_T)((const Q7_T*)vec)[filter->col_idx[e]]) * ((Q31_T)filter->values[e]);
+      }
+    } else {
+      for (ITER_T e = filter->row_ptr[r]; e < end; e++) {
+        sum += ((Q31_T)((const Q15_T*)vec)[filter->col_idx[e]]) * ((Q31_T)filter->values[e]);
+      }
+    }
+  } else {
+    const Q15_T* filter_offset = filter->dense + r;
+    if (in_size == sizeof(Q7_T)) {
+      for (ITER_T c = 0; c < filter->CF; c++) {
+        sum += ((Q31_T)((const Q7_T*)vec)[c]) * ((Q31_T)*filter_offset);
+        filter_offset += filter->COut;
+      }
+    } else {
+      for (ITER_T c = 0; c < filter->CF; c++) {
+        sum += ((Q31_T)((const Q15_T*)vec)[c]) * ((Q31_T)*filter_offset);
+        filter_offset += filter->COut;
+      }
+    }
+  }
+  return sum;
+}
+
+// First convolution of one input row into a row of convBuffer1. A NULL input is a row of the padding under the input.
+// The padding rows are computed as in the dense blocks, including the Q15 remainder loop of q7xq15_q15_mbconv_block()
+static void q_sparse_mbconv_expand(const void* const input, unsigned in_size,
+  const Q15_Sparse_Filter* const filter1, const Q15_T* const BN1W,
+  const Q15_T* const BN1B, Q15_T* convBuffer1_offset, ITER_T W, ITER_T CIn,
+  ITER_T CTemp, Q31_T limit1, SCALE_T shrU1, SCALE_T shrX1, SCALE_T shlU1,
+  SCALE_T shlX1) {
+  unsigned wide = (in_size == sizeof(Q15_T));
+  #ifdef LOOP_UNROLL
+    ITER_T unrolled = wide ? CTemp : (CTemp & ~3);
+  #else
+    ITER_T unrolled = wide ? CTemp : 0;
+  #endif
+  for (ITER_T j = 0; j < W; j++) {
+    const char* vec = input ? (const char*)input + j * CIn * in_size : 0;
+    for (ITER_T k = 0; k < CTemp; k++) {
+      if (vec == 0 && k >= unrolled) {
+        Q15_T w = q15_relu((Q15_T)(BN1B[k] * BN1W[k]), (Q15_T)limit1);
+        #ifdef SHIFT
+          *convBuffer1_offset++ = ((w << shlX1) >> shrX1);
+        #else
+          *convBuffer1_offset++ = ((w * shlX1) / shrX1);
+        #endif
+        continue;
+      }
+
+      Q63_T sum = vec ? q_sparse_mbconv_dot(vec, in_size, filter1, k) : 0;
+      Q31_T x = (((Q31_T)(q_sparse_mbconv_scale(sum, wide, shlU1, shrU1) + BN1B[k])) *
+                 ((Q31_T)BN1W[k]));
+      x = q31_relu(x, limit1);
+      #ifdef SHIFT
+        *convBuffer1_offset++ = ((x << shlX1) >> shrX1);
+      #else
+        *convBuffer1_offset++ = (x * shlX1) / shrX1;
+      #endif
+    }
+  }
+}
+
+// MBConv block with packed filters, for the Q15 filter variants (Q7 or Q15 input of in_size bytes)
+static void q_sparse_mbconv_block(const void* const input, unsigned in_size,
+  const Q15_Sparse_Filter* const filter1, const Q15_T* const BN1W,
+  const Q15_T* const BN1B, const Q15_Sparse_Filter* const filter2,
+  const Q15_T* const BN2W, const Q15_T* const BN2B,
+  const Q15_Sparse_Filter* const filter3, const Q15_T* const BN3W,
+  const Q15_T* const BN3B, Q15_T* const output, Q15_T* const convBuffer1,
+  Q15_T* const convBuffer2, ITER_T N, ITER_T H, ITER_T W, ITER_T CIn,
+  ITER_T CTemp, ITER_T HF, ITER_T WF, ITER_T COut, ITER_T HOut, ITER_T WOut,
+  S_ITER_T HPadU, S_ITER_T HPadD, S_ITER_T WPadL, S_ITER_T WPadR,
+  ITER_T HStride, ITER_T WStride, Q31_T limit1, Q31_T limit2, SCALE_T shrU1,
+  SCALE_T shrX1, SCALE_T shrU2, SCALE_T shrX2, SCALE_T shrU3, SCALE_T shrW3,
+  SCALE_T shlU1, SCALE_T shlX1, SCALE_T shlU2, SCALE_T shlX2, SCALE_T shlU3,
+  SCALE_T shlW3) {
+  S_ITER_T HOffsetFL = (HF - 1) >> 1;
+  S_ITER_T WOffsetFL = (WF - 1) >> 1;
+  S_ITER_T HOffsetFR = HF >> 1;
+  S_ITER_T WOffsetFR = WF >> 1;
+
+  S_ITER_T HOffsetL = HOffsetFL - HPadU;
+  S_ITER_T WOffsetL = WOffsetFL - WPadL;
+  S_ITER_T HOffsetR = HOffsetFR - HPadD;
+  S_ITER_T WOffsetR = WOffsetFR - WPadR;
+
+  ITER_T HOffsetIn = W * CIn;
+  ITER_T NOffsetIn = H * HOffsetIn;
+  ITER_T HOffsetC1 = W * CTemp;
+  ITER_T GOffsetF = HF * WF;
+  ITER_T HOffsetOut = WOut * COut;
+  ITER_T NOffsetOut = HOut * HOffsetOut;
+  unsigned wide = (in_size == sizeof(Q15_T));
+
+  // Offsets of the depthwise taps, and the index in convBuffer1 of the pixel under each tap (-1 in the padding)
+  S_ITER_T tap_h[Q_SPARSE_FILTER_MAX_TAPS], tap_w[Q_SPARSE_FILTER_MAX_TAPS];
+  S_ITER_T pixel[Q_SPARSE_FILTER_MAX_TAPS];
+  for (ITER_T t = 0; t < GOffsetF; t++) {
+    tap_h[t] = (S_ITER_T)(t / WF) - HOffsetFL;
+    tap_w[t] = (S_ITER_T)(t % WF) - WOffsetFL;
+  }
+
+  Q63_T sum;
+  for (ITER_T n = 0; n < N; n++) {
+    const char* NInput = (const char*)input + n * NOffsetIn * in_size;
+    ITER_T NIndexOut = n * NOffsetOut;
+    ITER_T margin = 0;
+    if ((S_ITER_T)HF - HPadU - (S_ITER_T)HStride > 0) {
+      margin = (ITER_T)((S_ITER_T)HF - HPadU - (S_ITER_T)HStride);
+    }
+
+    // The margin rows past the end of the input are padding, which is never read
+    for (ITER_T i = 0; (i < margin) && (i < H); i++) {
+      q_sparse_mbconv_expand(NInput + i * HOffsetIn * in_size, in_size,
+        filter1, BN1W, BN1B, convBuffer1 + i * HOffsetC1, W, CIn, CTemp,
+        limit1, shrU1, shrX1, shlU1, shlX1);
+    }
+
+    ITER_T hout = 0;
+    for (S_ITER_T h = HOffsetL; h < (S_ITER_T)H - HOffsetR; hout++, h += (S_ITER_T)HStride) {
+      ITER_T HIndexOut = hout * HOffsetOut + NIndexOut;
+      for (ITER_T i = 0; i < HStride; i++) {
+        ITER_T iRed = (i + margin + hout * HStride) % HF;
+        ITER_T iFull = i + margin + hout * HStride;
+        q_sparse_mbconv_expand(iFull < H ? NInput + iFull * HOffsetIn * in_size : 0,
+          in_size, filter1, BN1W, BN1B, convBuffer1 + iRed * HOffsetC1, W, CIn,
+          CTemp, limit1, shrU1, shrX1, shlU1, shlX1);
+      }
+
+      ITER_T wout = 0;
+      for (S_ITER_T w = WOffsetL; w < ((S_ITER_T)W) - WOffsetR; wout++, w += ((S_ITER_T)WStride)) {
+        Q15_T* output_offset = ((Q15_T*)output) + wout * COut + HIndexOut;
+        for (ITER_T t = 0; t < GOffsetF; t++) {
+          S_ITER_T hindex = h + tap_h[t];
+          S_ITER_T windex = w + tap_w[t];
+          if ((hindex < 0) || (hindex >= (S_ITER_T)H) ||
+              (windex < 0) || (windex >= (S_ITER_T)W)) {
+            pixel[t] = -1;
+          } else {
+            pixel[t] = (S_ITER_T)((((ITER_T)hindex) % HF) * HOffsetC1 + ((ITER_T)windex) * CTemp);
+          }
+        }
+
+        for (ITER_T g = 0; g < CTemp; g++) {
+          sum = 0;
+          if (filter2->row_ptr) {
+            for (ITER_T e = filter2->row_ptr[g]; e < filter2->row_ptr[g + 1]; e++) {
+              S_ITER_T p = pixel[filter2->col_idx[e] >> Q_SPARSE_FILTER_TAP_SHIFT];
+              if (p >= 0) {
+                sum += ((Q31_T)convBuffer1[p + g]) * ((Q31_T)filter2->values[e]);
+              }
+            }
+          } else {
+            const Q15_T* filter2_offset = filter2->dense + g * GOffsetF;
+            for (ITER_T t = 0; t < GOffsetF; t++) {
+              if (pixel[t] >= 0) {
+                sum += ((Q31_T)convBuffer1[pixel[t] + g]) * ((Q31_T)filter2_offset[t]);
+              }
+            }
+          }
+
+          Q31_T x = (((Q31_T)(q_sparse_mbconv_scale(sum, wide, shlU2, shrU2) + BN2B[g])) *
+                     ((Q31_T)BN2W[g]));
+          x = q31_relu(x, limit2);
+          #ifdef SHIFT
+            convBuffer2[g] = ((x << shlX2) >> shrX2);
+          #else
+            convBuffer2[g] = (x * shlX2) / shrX2;
+          #endif
+        }
+
+        for (ITER_T i = 0; i < COut; i++) {
+          sum = q_sparse_mbconv_dot(convBuffer2, sizeof(Q15_T), filter3, i);
+          #ifdef SHIFT
+            *output_offset++ = (((((Q31_T)(q_sparse_mbconv_scale(sum, wide, shlU3, shrU3) + BN3B[i])) *
+                                  ((Q31_T) BN3W[i])) << shlW3) >> shrW3);
+          #else
+            *output_offset++ = ((((Q31_T)(q_sparse_mbconv_scale(sum, wide, shlU3, shrU3) + BN3B[i])) *
+                                 ((Q31_T) BN3W[i])) * shlW3) / shrW3;
+          #endif
+        }
+      }
+    }
+  }
+}
+
+void q7xq15_q15_sparse_mbconv_block(const Q7_T* const input,
+  const Q15_Sparse_Filter* const filter1, const Q15_T* const BN1W,
+  const Q15_T* const BN1B, const Q15_Sparse_Filter* const filter2,
+  const Q15_T* const BN2W, const Q15_T* const BN2B,
+  const Q15_Sparse_Filter* const filter3, const Q15_T* const BN3W,
+  const Q15_T* const BN3B, Q15_T* const output, Q15_T* const convBuffer1,
+  Q15_T* const convBuffer2, ITER_T N, ITER_T H, ITER_T W, ITER_T CIn,
+  ITER_T CTemp, ITER_T HF, ITER_T WF, ITER_T COut, ITER_T HOut, ITER_T WOut,
+  S_ITER_T HPadU, S_ITER_T HPadD, S_ITER_T WPadL, S_ITER_T WPadR,
+  ITER_T HStride, ITER_T WStride, Q31_T limit1, Q31_T limit2, SCALE_T shrU1,
+  SCALE_T shrX1, SCALE_T shrU2, SCALE_T shrX2, SCALE_T shrU3, SCALE_T shrW3,
+  SCALE_T shlU1, SCALE_T shlX1, SCALE_T shlU2, SCALE_T shlX2, SCALE_T shlU3,
+  SCALE_T shlW3) {
+  if (!filter1->row_ptr && !filter2->row_ptr && !filter3->row_ptr) {
+    q7xq15_q15_mbconv_block(input, filter1->dense, BN1W, BN1B, filter2->dense,
+      BN2W, BN2B, filter3->dense, BN3W, BN3B, output, convBuffer1, convBuffer2,
+      N, H, W, CIn, CTemp, HF, WF, COut, HOut, WOut, HPadU, HPadD, WPadL,
+      WPadR, HStride, WStride, limit1, limit2, shrU1, shrX1, shrU2, shrX2,
+      shrU3, shrW3, shlU1, shlX1, shlU2, shlX2, shlU3, shlW3);
+    return;
+  }
+  q_sparse_mbconv_block(input, sizeof(Q7_T), filter1, BN1W, BN1B, filter2,
+    BN2W, BN2B, filter3, BN3W, BN3B, output, convBuffer1, convBuffer2, N, H, W,
+    CIn, CTemp, HF, WF, COut, HOut, WOut, HPadU, HPadD, WPadL, WPadR, HStride,
+    WStride, limit1, limit2, shrU1, shrX1, shrU2, shrX2, shrU3, shrW3, shlU1,
+    shlX1, shlU2, shlX2, shlU3, shlW3);
+}
+
+void q15_sparse_mbconv_block(const Q15_T* const input,
+  const Q15_Sparse_Filter* const filter1, const Q15_T* const BN1W,
+  const Q15_T* const BN1B, const Q15_Sparse_Filter* const filter2,
+  const Q15_T* const BN2W, const Q15_T* const BN2B,
+  const Q15_Sparse_Filter* const filter3, const Q15_T* const BN3W,
+  const Q15_T* const BN3B, Q15_T* const output, Q15_T* const convBuffer1,
+  Q15_T* const convBuffer2, ITER_T N, ITER_T H, ITER_T W, ITER_T CIn,
+  ITER_T CTemp, ITER_T HF, ITER_T WF, ITER_T COut, ITER_T HOut, ITER_T WOut,
+  S_ITER_T HPadU, S_ITER_T HPadD, S_ITER_T WPadL, S_ITER_T WPadR,
+  ITER_T HStride, ITER_T WStride, Q31_T limit1, Q31_T limit2, SCALE_T shrU1,
+  SCALE_T shrX1, SCALE_T shrU2, SCALE_T shrX2, SCALE_T shrU3, SCALE_T shrW3,
+  SCALE_T shlU1, SCALE_T shlX1, SCALE_T shlU2, SCALE_T shlX2, SCALE_T shlU3,
+  SCALE_T shlW3) {
+  if (!filter1->row_ptr && !filter2->row_ptr && !filter3->row_ptr) {
+    q15_mbconv_block(input, filter1->dense, BN1W, BN1B, filter2->dense, BN2W,
+      BN2B, filter3->dense, BN3W, BN3B, output, convBuffer1, convBuffer2, N, H,
+      W, CIn, CTemp, HF, WF, COut, HOut, WOut, HPadU, HPadD, WPadL, WPadR,
+      HStride, WStride, limit1, limit2, shrU1, shrX1, shrU2, shrX2, shrU3,
+      shrW3, shlU1, shlX1, shlU2, shlX2, shlU3, shlW3);
+    return;
+  }
+  q_sparse_mbconv_block(input, sizeof(Q15_T), filter1, BN1W, BN1B, filter2,
+    BN2W, BN2B, filter3, BN3W, BN3B, output, convBuffer1, convBuffer2, N, H, W,
+    CIn, CTemp, HF, WF, COut, HOut, WOut, HPadU, HPadD, WPadL, WPadR, HStride,
+    WStride, limit1, limit2, shrU1, shrX1, shrU2, shrX2, shrU3, shrW3, shlU1,
+    shlX1, shlU2, shlX2, shlU3, shlW3);
+}
+
+// Arguments of one band of output rows [hout_begin, hout_end) of a multi-threaded
+// MBConv block. The tensors are stored untyped, the variant selects the block.
+// The filters of the sparse variants are Q15_Sparse_Filter
+typedef enum Q_MBConv_Variant {
+  Q_MBCONV_Q7,
+  Q_MBCONV_Q7XQ15_Q15,
+  Q_MBCONV_Q15XQ7_Q7,
+  Q_MBCONV_Q15XQ7_Q15,
+  Q_MBCONV_Q15,
+  Q_MBCONV_Q7XQ15_Q15_SPARSE,
+  Q_MBCONV_Q15_SPARSE
+} Q_MBConv_Variant;
+
+typedef struct Q_MBConv_Band_Task {
+  Q_MBConv_Variant variant;
+  const void* input;
+  const void* filter1;
+  const void* BN1W;
+  const void* BN1B;
+  const void* filter2;
+  const void* BN2W;
+  const void* BN2B;
+  const void* filter3;
+  const void* BN3W;
+  const void* BN3B;
+  void* output;
+  void* convBuffer1;
+  void* convBuffer2;
+  ITER_T N, H, W, CIn, CTemp, HF, WF, COut, HOut, WOut;
+  S_ITER_T HPadU, HPadD, WPadL, WPadR;
+  ITER_T HStride, WStride;
+  Q31_T limit1, limit2;
+  SCALE_T shrU1, shrX1, shrU2, shrX2, shrU3, shrW3;
+  SCALE_T shlU1, shlX1, shlU2, shlX2, shlU3, shlW3;
+  // Sizes of the elements of the input, the output and the buffers in bytes
+  unsigned in_size, out_size, buf_size;
+  ITER_T hout_begin;
+  ITER_T hout_end;
+} Q_MBConv_Band_Task;
+
+// Run the single-threaded block of the variant on one image of the band, with
+// the rows of the sub-tensor [top, top + H) and its own padding
+static void q_mbconv_run(const Q_MBConv_Band_Task* t, const void* input,
+  void* output, ITER_T H, ITER_T HOut, S_ITER_T HPadU, S_ITER_T HPadD) {
+  switch (t->variant) {
+    case Q_MBCONV_Q7:
+      q7_mbconv_block((const Q7_T*)input,
+        (const Q7_T*)t->filter1, (const Q7_T*)t->BN1W,
+        (const Q7_T*)t->BN1B, (const Q7_T*)t->filter2,
+        (const Q7_T*)t->BN2W, (const Q7_T*)t->BN2B,
+        (const Q7_T*)t->filter3, (const Q7_T*)t->BN3W,
+        (const Q7_T*)t->BN3B, (Q7_T*)output,
+        (Q7_T*)t->convBuffer1, (Q7_T*)t->convBuffer2,
+        1, H, t->W, t->CIn, t->CTemp, t->HF, t->WF, t->COut, HOut, t->WOut,
+        HPadU, HPadD, t->WPadL, t->WPadR, t->HStride, t->WStride,
+        (Q15_T)t->limit1, (Q15_T)t->limit2, t->shrU1, t->shrX1, t->shrU2,
+        t->shrX2, t->shrU3, t->shrW3, t->shlU1, t->shlX1, t->shlU2, t->shlX2,
+        t->shlU3, t->shlW3);
+      break;
+    case Q_MBCONV_Q7XQ15_Q15:
+      q7xq15_q15_mbconv_block((const Q7_T*)input,
+        (const Q15_T*)t->filter1, (const Q15_T*)t->BN1W,
+        (const Q15_T*)t->BN1B, (const Q15_T*)t->filter2,
+        (const Q15_T*)t->BN2W, (const Q15_T*)t->BN2B,
+        (const Q15_T*)t->filter3, (const Q15_T*)t->BN3W,
+        (const Q15_T*)t->BN3B, (Q15_T*)output,
+        (Q15_T*)t->convBuffer1, (Q15_T*)t->convBuffer2,
+        1, H, t->W, t->CIn, t->CTemp, t->HF, t->WF, t->COut, HOut, t->WOut,
+        HPadU, HPadD, t->WPadL, t->WPadR, t->HStride, t->WStride,
+        (Q31_T)t->limit1, (Q31_T)t->limit2, t->shrU1, t->shrX1, t->shrU2,
+        t->shrX2, t->shrU3, t->shrW3, t->shlU1, t->shlX1, t->shlU2, t->shlX2,
+        t->shlU3, t->shlW3);
+      break;
+    case Q_MBCONV_Q15XQ7_Q7:
+      q15xq7_q7_mbconv_block((const Q15_T*)input,
+        (const Q7_T*)t->filter1, (const Q7_T*)t->BN1W,
+        (const Q15_T*)t->BN1B, (const Q7_T*)t->filter2,
+        (const Q7_T*)t->BN2W, (const Q15_T*)t->BN2B,
+        (const Q7_T*)t->filter3, (const Q7_T*)t->BN3W,
+        (const Q15_T*)t->BN3B, (Q7_T*)output,
+        (Q15_T*)t->convBuffer1, (Q15_T*)t->convBuffer2,
+        1, H, t->W, t->CIn, t->CTemp, t->HF, t->WF, t->COut, HOut, t->WOut,
+        HPadU, HPadD, t->WPadL, t->WPadR, t->HStride, t->WStride,
+        (Q31_T)t->limit1, (Q31_T)t->limit2, t->shrU1, t->shrX1, t->shrU2,
+        t->shrX2, t->shrU3, t->shrW3, t->shlU1, t->shlX1, t->shlU2, t->shlX2,
+        t->shlU3, t->shlW3);
+      break;
+    case Q_MBCONV_Q15XQ7_Q15:
+      q15xq7_q15_mbconv_block((const Q15_T*)input,
+        (const Q7_T*)t->filter1, (const Q7_T*)t->BN1W,
+        (const Q15_T*)t->BN1B, (const Q7_T*)t->filter2,
+        (const Q7_T*)t->BN2W, (const Q15_T*)t->BN2B,
+        (const Q7_T*)t->filter3, (const Q7_T*)t->BN3W,
+        (const Q15_T*)t->BN3B, (Q15_T*)output,
+        (Q15_T*)t->convBuffer1, (Q15_T*)t->convBuffer2,
+        1, H, t->W, t->CIn, t->CTemp, t->HF, t->WF, t->COut, HOut, t->WOut,
+        HPadU, HPadD, t->WPadL, t->WPadR, t->HStride, t->WStride,
+        (Q31_T)t->limit1, (Q31_T)t->limit2, t->shrU1, t->shrX1, t->shrU2,
+        t->shrX2, t->shrU3, t->shrW3, t->shlU1, t->shlX1, t->shlU2, t->shlX2,
+        t->shlU3, t->shlW3);
+      break;
+    case Q_MBCONV_Q15:
+      q15_mbconv_block((const Q15_T*)input,
+        (const Q15_T*)t->filter1, (const Q15_T*)t->BN1W,
+        (const Q15_T*)t->BN1B, (const Q15_T*)t->filter2,
+        (const Q15_T*)t->BN2W, (const Q15_T*)t->BN2B,
+        (const Q15_T*)t->filter3, (const Q15_T*)t->BN3W,
+        (const Q15_T*)t->BN3B, (Q15_T*)output,
+        (Q15_T*)t->convBuffer1, (Q15_T*)t->convBuffer2,
+        1, H, t->W, t->CIn, t->CTemp, t->HF, t->WF, t->COut, HOut, t->WOut,
+        HPadU, HPadD, t->WPadL, t->WPadR, t->HStride, t->WStride,
+        (Q31_T)t->limit1, (Q31_T)t->limit2, t->shrU1, t->shrX1, t->shrU2,
+        t->shrX2, t->shrU3, t->shrW3, t->shlU1, t->shlX1, t->shlU2, t->shlX2,
+        t->shlU3, t->shlW3);
+      break;
+    case Q_MBCONV_Q7XQ15_Q15_SPARSE:
+      q7xq15_q15_sparse_mbconv_block((const Q7_T*)input,
+        (const Q15_Sparse_Filter*)t->filter1, (const Q15_T*)t->BN1W,
+        (const Q15_T*)t->BN1B, (const Q15_Sparse_Filter*)t->filter2,
+        (const Q15_T*)t->BN2W, (const Q15_T*)t->BN2B,
+        (const Q15_Sparse_Filter*)t->filter3, (const Q15_T*)t->BN3W,
+        (const Q15_T*)t->BN3B, (Q15_T*)output,
+        (Q15_T*)t->convBuffer1, (Q15_T*)t->convBuffer2,
+        1, H, t->W, t->CIn, t->CTemp, t->HF, t->WF, t->COut, HOut, t->WOut,
+        HPadU, HPadD, t->WPadL, t->WPadR, t->HStride, t->WStride,
+        (Q31_T)t->limit1, (Q31_T)t->limit2, t->shrU1, t->shrX1, t->shrU2,
+        t->shrX2, t->shrU3, t->shrW3, t->shlU1, t->shlX1, t->shlU2, t->shlX2,
+        t->shlU3, t->shlW3);
+      break;
+    case Q_MBCONV_Q15_SPARSE:
+      q15_sparse_mbconv_block((const Q15_T*)input,
+        (const Q15_Sparse_Filter*)t->filter1, (const Q15_T*)t->BN1W,
+        (const Q15_T*)t->BN1B, (const Q15_Sparse_Filter*)t->filter2,
+        (const Q15_T*)t->BN2W, (const Q15_T*)t->BN2B,
+        (const Q15_Sparse_Filter*)t->filter3, (const Q15_T*)t->BN3W,
+        (const Q15_T*)t->BN3B, (Q15_T*)output,
+        (Q15_T*)t->convBuffer1, (Q15_T*)t->convBuffer2,
+        1, H, t->W, t->CIn, t->CTemp, t->HF, t->WF, t->COut, HOut, t->WOut,
+        HPadU, HPadD, t->WPadL, t->WPadR, t->HStride, t->WStride,
+        (Q31_T)t->limit1, (Q31_T)t->limit2, t->shrU1, t->shrX1, t->shrU2,
+        t->shrX2, t->shrU3, t->shrW3, t->shlU1, t->shlX1, t->shlU2, t->shlX2,
+        t->shlU3, t->shlW3);
+      break;
+  }
+}
+
+static void q_mbconv_band_task(void* args) {
+  const Q_MBConv_Band_Task* t = (const Q_MBConv_Band_Task*)args;
+  if (t->hout_begin >= t->hout_end) {
+    return;
+  }
+
+  // Input rows [lo, hi) under the filters of the band, including the padding.
+  // The rows outside the input become the padding of the band
+  S_ITER_T lo = (S_ITER_T)(t->hout_begin * t->HStride) - t->HPadU;
+  S_ITER_T hi = (S_ITER_T)((t->hout_end - 1) * t->HStride + t->HF) - t->HPadU;
+  S_ITER_T top = lo > 0 ? lo : 0;
+  S_ITER_T bottom = hi < (S_ITER_T)t->H ? hi : (S_ITER_T)t->H;
+
+  for (ITER_T n = 0; n < t->N; n++) {
+    const char* input = (const char*)t->input +
+      ((n * t->H + (ITER_T)top) * t->W * t->CIn) * t->in_size;
+    char* output = (char*)t->output +
+      ((n * t->HOut + t->hout_begin) * t->WOut * t->COut) * t->out_size;
+    q_mbconv_run(t, input, output, (ITER_T)(bottom - top),
+      t->hout_end - t->hout_begin, top - lo, hi - bottom);
+  }
+}
+
+static void q_mbconv_threaded(Q_MBConv_Band_Task* base, void* bandBuffers,
+  size_t bandBuffersSize, ITER_T num_threads) {
+  // The bands after the first take their buffers from bandBuffers, with as many
+  // bands as fit in it
+  size_t buffer1_size = (size_t)base->HF * base->W * base->CTemp * base->buf_size;
+  size_t buffer2_size = (size_t)base->CTemp * base->buf_size;
+  size_t max_bands = 1 + bandBuffersSize / (buffer1_size + buffer2_size);
+  if (num_threads > max_bands) {
+    num_threads = (ITER_T)max_bands;
+  }
+  if (num_threads > Q_MBCONV_MAX_THREADS) {
+    num_threads = Q_MBCONV_MAX_THREADS;
+  }
+  if (num_threads > base->HOut) {
+    num_threads = base->HOut;
+  }
+  // Without threads, the bands would run one after the other and recompute the
+  // rows of the input they share
+  #ifndef MULTITHREADED
+    num_threads = 1;
+  #endif
+
+  if (num_threads <= 1) {
+    base->hout_begin = 0;
+    base->hout_end = base->HOut;
+    q_mbconv_band_task(base);
+    return;
+  }
+
+  Q_MBConv_Band_Task tasks[Q_MBCONV_MAX_THREADS];
+  for (ITER_T i = 0; i < num_threads; i++) {
+    tasks[i] = *base;
+    tasks[i].hout_begin = (base->HOut * i) / num_threads;
+    tasks[i].hout_end = (base->HOut * (i + 1)) / num_threads;
+    if (i > 0) {
+      char* band_buffers = (char*)bandBuffers + (i - 1) * (buffer1_size + buffer2_size);
+      tasks[i].convBuffer1 = band_buffers;
+      tasks[i].convBuffer2 = band_buffers + buffer1_size;
+    }
+  }
+  parallel_for(q_mbconv_band_task, tasks, sizeof(Q_MBConv_Band_Task), num_threads);
+}
+
+void q7_mbconv_block_threaded(const Q7_T* const input, const Q7_T* const filter1,
+  const Q7_T* const BN1W, const Q7_T* const BN1B, const Q7_T* const filter2,
+  const Q7_T* const BN2W, const Q7_T* const BN2B, const Q7_T* const filter3,
+  const Q7_T* const BN3W, const Q7_T* const BN3B, Q7_T* const output,
+  Q7_T* const convBuffer1, Q7_T* const convBuffer2, ITER_T N, ITER_T H,
+  ITER_T W, ITER_T CIn, ITER_T CTemp, ITER_T HF, ITER_T WF, ITER_T COut,
+  ITER_T HOut, ITER_T WOut, S_ITER_T HPadU, S_ITER_T HPadD, S_ITER_T WPadL,
+  S_ITER_T WPadR, ITER_T HStride, ITER_T WStride, Q15_T limit1, Q15_T limit2,
+  SCALE_T shrU1, SCALE_T shrX1, SCALE_T shrU2, SCALE_T shrX2, SCALE_T shrU3,
+  SCALE_T shrW3, SCALE_T shlU1, SCALE_T shlX1, SCALE_T shlU2, SCALE_T shlX2,
+  SCALE_T shlU3, SCALE_T shlW3, void* const bandBuffers,
+  size_t bandBuffersSize, ITER_T num_threads) {
+  Q_MBConv_Band_Task base = {
+    .variant = Q_MBCONV_Q7, .input = input, .filter1 = filter1,
+    .BN1W = BN1W, .BN1B = BN1B, .filter2 = filter2, .BN2W = BN2W,
+    .BN2B = BN2B, .filter3 = filter3, .BN3W = BN3W, .BN3B = BN3B,
+    .output = output, .convBuffer1 = convBuffer1, .convBuffer2 = convBuffer2,
+    .N = N, .H = H, .W = W, .CIn = CIn, .CTemp = CTemp, .HF = HF, .WF = WF,
+    .COut = COut, .HOut = HOut, .WOut = WOut, .HPadU = HPadU, .HPadD = HPadD,
+    .WPadL = WPadL, .WPadR = WPadR, .HStride = HStride, .WStride = WStride,
+    .limit1 = limit1, .limit2 = limit2, .shrU1 = shrU1, .shrX1 = shrX1,
+    .shrU2 = shrU2, .shrX2 = shrX2, .shrU3 = shrU3, .shrW3 = shrW3,
+    .shlU1 = shlU1, .shlX1 = shlX1, .shlU2 = shlU2, .shlX2 = shlX2,
+    .shlU3 = shlU3, .shlW3 = shlW3, .in_size = sizeof(Q7_T),
+    .out_size = sizeof(Q7_T), .buf_size = sizeof(Q7_T)
+  };
+  q_mbconv_threaded(&base, bandBuffers, bandBuffersSize, num_threads);
+}
+
+void q7xq15_q15_mbconv_block_threaded(const Q7_T* const input,
+  const Q15_T* const filter1, const Q15_T* const BN1W, const Q15_T* const BN1B,
+  const Q15_T* const filter2, const Q15_T* const BN2W, const Q15_T* const BN2B,
+  const Q15_T* const filter3, const Q15_T* const BN3W, const Q15_T* const BN3B,
+  Q15_T* const output, Q15_T* const convBuffer1, Q15_T* const convBuffer2,
+  ITER_T N, ITER_T H, ITER_T W, ITER_T CIn, ITER_T CTemp, ITER_T HF, ITER_T WF,
+  ITER_T COut, ITER_T HOut, ITER_T WOut, S_ITER_T HPadU, S_ITER_T HPadD,
+  S_ITER_T WPadL, S_ITER_T WPadR, ITER_T HStride, ITER_T WStride, Q31_T limit1,
+  Q31_T limit2, SCALE_T shrU1, SCALE_T shrX1, SCALE_T shrU2, SCALE_T shrX2,
+  SCALE_T shrU3, SCALE_T shrW3, SCALE_T shlU1, SCALE_T shlX1, SCALE_T shlU2,
+  SCALE_T shlX2, SCALE_T shlU3, SCALE_T shlW3, void* const bandBuffers,
+  size_t bandBuffersSize, ITER_T num_threads) {
+  Q_MBConv_Band_Task base = {
+    .variant = Q_MBCONV_Q7XQ15_Q15, .input = input, .filter1 = filter1,
+    .BN1W = BN1W, .BN1B = BN1B, .filter2 = filter2, .BN2W = BN2W,
+    .BN2B = BN2B, .filter3 = filter3, .BN3W = BN3W, .BN3B = BN3B,
+    .output = output, .convBuffer1 = convBuffer1, .convBuffer2 = convBuffer2,
+    .N = N, .H = H, .W = W, .CIn = CIn, .CTemp = CTemp, .HF = HF, .WF = WF,
+    .COut = COut, .HOut = HOut, .WOut = WOut, .HPadU = HPadU, .HPadD = HPadD,
+    .WPadL = WPadL, .WPadR = WPadR, .HStride = HStride, .WStride = WStride,
+    .limit1 = limit1, .limit2 = limit2, .shrU1 = shrU1, .shrX1 = shrX1,
+    .shrU2 = shrU2, .shrX2 = shrX2, .shrU3 = shrU3, .shrW3 = shrW3,
+    .shlU1 = shlU1, .shlX1 = shlX1, .shlU2 = shlU2, .shlX2 = shlX2,
+    .shlU3 = shlU3, .shlW3 = shlW3, .in_size = sizeof(Q7_T),
+    .out_size = sizeof(Q15_T), .buf_size = sizeof(Q15_T)
+  };
+  q_mbconv_threaded(&base, bandBuffers, bandBuffersSize, num_threads);
+}
+
+void q15xq7_q7_mbconv_block_threaded(const Q15_T* const input,
+  const Q7_T* const filter1, const Q7_T* const BN1W, const Q15_T* const BN1B,
+  const Q7_T* const filter2, const Q7_T* const BN2W, const Q15_T* const BN2B,
+  const Q7_T* const filter3, const Q7_T* const BN3W, const Q15_T* const BN3B,
+  Q7_T* const output, Q15_T* const convBuffer1, Q15_T* const convBuffer2,
+  ITER_T N, ITER_T H, ITER_T W, ITER_T CIn, ITER_T CTemp, ITER_T HF, ITER_T WF,
+  ITER_T COut, ITER_T HOut, ITER_T WOut, S_ITER_T HPadU, S_ITER_T HPadD,
+  S_ITER_T WPadL, S_ITER_T WPadR, ITER_T HStride, ITER_T WStride, Q31_T limit1,
+  Q31_T limit2, SCALE_T shrU1, SCALE_T shrX1, SCALE_T shrU2, SCALE_T shrX2,
+  SCALE_T shrU3, SCALE_T shrW3, SCALE_T shlU1, SCALE_T shlX1, SCALE_T shlU2,
+  SCALE_T shlX2, SCALE_T shlU3, SCALE_T shlW3, void* const bandBuffers,
+  size_t bandBuffersSize, ITER_T num_threads) {
+  Q_MBConv_Band_Task base = {
+    .variant = Q_MBCONV_Q15XQ7_Q7, .input = input, .filter1 = filter1,
+    .BN1W = BN1W, .BN1B = BN1B, .filter2 = filter2, .BN2W = BN2W,
+    .BN2B = BN2B, .filter3 = filter3, .BN3W = BN3W, .BN3B = BN3B,
+    .output = output, .convBuffer1 = convBuffer1, .convBuffer2 = convBuffer2,
+    .N = N, .H = H, .W = W, .CIn = CIn, .CTemp = CTemp, .HF = HF, .WF = WF,
+    .COut = COut, .HOut = HOut, .WOut = WOut, .HPadU = HPadU, .HPadD = HPadD,
+    .WPadL = WPadL, .WPadR = WPadR, .HStride = HStride, .WStride = WStride,
+    .limit1 = limit1, .limit2 = limit2, .shrU1 = shrU1, .shrX1 = shrX1,
+    .shrU2 = shrU2, .shrX2 = shrX2, .shrU3 = shrU3, .shrW3 = shrW3,
+    .shlU1 = shlU1, .shlX1 = shlX1, .shlU2 = shlU2, .shlX2 = shlX2,
+    .shlU3 = shlU3, .shlW3 = shlW3, .in_size = sizeof(Q15_T),
+    .out_size = sizeof(Q7_T), .buf_size = sizeof(Q15_T)
+  };
+  q_mbconv_threaded(&base, bandBuffers, bandBuffersSize, num_threads);
+}
+
+void q15xq7_q15_mbconv_block_threaded(const Q15_T* const input,
+  const Q7_T* const filter1, const Q7_T* const BN1W, const Q15_T* const BN1B,
+  const Q7_T* const filter2, const Q7_T* const BN2W, const Q15_T* const BN2B,
+  const Q7_T* const filter3, const Q7_T* const BN3W, const Q15_T* const BN3B,
+  Q15_T* const output, Q15_T* const convBuffer1, Q15_T* const convBuffer2,
+  ITER_T N, ITER_T H, ITER_T W, ITER_T CIn, ITER_T CTemp, ITER_T HF, ITER_T WF,
+  ITER_T COut, ITER_T HOut, ITER_T WOut, S_ITER_T HPadU, S_ITER_T HPadD,
+  S_ITER_T WPadL, S_ITER_T WPadR, ITER_T HStride, ITER_T WStride, Q31_T limit1,
+  Q31_T limit2, SCALE_T shrU1, SCALE_T shrX1, SCALE_T shrU2, SCALE_T shrX2,
+  SCALE_T shrU3, SCALE_T shrW3, SCALE_T shlU1, SCALE_T shlX1, SCALE_T shlU2,
+  SCALE_T shlX2, SCALE_T shlU3, SCALE_T shlW3, void* const bandBuffers,
+  size_t bandBuffersSize, ITER_T num_threads) {
+  Q_MBConv_Band_Task base = {
+    .variant = Q_MBCONV_Q15XQ7_Q15, .input = input, .filter1 = filter1,
+    .BN1W = BN1W, .BN1B = BN1B, .filter2 = filter2, .BN2W = BN2W,
+    .BN2B = BN2B, .filter3 = filter3, .BN3W = BN3W, .BN3B = BN3B,
+    .output = output, .convBuffer1 = convBuffer1, .convBuffer2 = convBuffer2,
+    .N = N, .H = H, .W = W, .CIn = CIn, .CTemp = CTemp, .HF = HF, .WF = WF,
+    .COut = COut, .HOut = HOut, .WOut = WOut, .HPadU = HPadU, .HPadD = HPadD,
+    .WPadL = WPadL, .WPadR = WPadR, .HStride = HStride, .WStride = WStride,
+    .limit1 = limit1, .limit2 = limit2, .shrU1 = shrU1, .shrX1 = shrX1,
+    .shrU2 = shrU2, .shrX2 = shrX2, .shrU3 = shrU3, .shrW3 = shrW3,
+    .shlU1 = shlU1, .shlX1 = shlX1, .shlU2 = shlU2, .shlX2 = shlX2,
+    .shlU3 = shlU3, .shlW3 = shlW3, .in_size = sizeof(Q15_T),
+    .out_size = sizeof(Q15_T), .buf_size = sizeof(Q15_T)
+  };
+  q_mbconv_threaded(&base, bandBuffers, bandBuffersSize, num_threads);
+}
+
+void q15_mbconv_block_threaded(const Q15_T* const input, const Q15_T* const filter1,
+  const Q15_T* const BN1W, const Q15_T* const BN1B, const Q15_T* const filter2,
+  const Q15_T* const BN2W, const Q15_T* const BN2B, const Q15_T* const filter3,
+  const Q15_T* const BN3W, const Q15_T* const BN3B, Q15_T* const output,
+  Q15_T* const convBuffer1, Q15_T* const convBuffer2, ITER_T N, ITER_T H,
+  ITER_T W, ITER_T CIn, ITER_T CTemp, ITER_T HF, ITER_T WF, ITER_T COut,
+  ITER_T HOut, ITER_T WOut, S_ITER_T HPadU, S_ITER_T HPadD, S_ITER_T WPadL,
+  S_ITER_T WPadR, ITER_T HStride, ITER_T WStride, Q31_T limit1, Q31_T limit2,
+  SCALE_T shrU1, SCALE_T shrX1, SCALE_T shrU2, SCALE_T shrX2, SCALE_T shrU3,
+  SCALE_T shrW3, SCALE_T shlU1, SCALE_T shlX1, SCALE_T shlU2, SCALE_T shlX2,
+  SCALE_T shlU3, SCALE_T shlW3, void* const bandBuffers,
+  size_t bandBuffersSize, ITER_T num_threads) {
+  Q_MBConv_Band_Task base = {
+    .variant = Q_MBCONV_Q15, .input = input, .filter1 = filter1,
+    .BN1W = BN1W, .BN1B = BN1B, .filter2 = filter2, .BN2W = BN2W,
+    .BN2B = BN2B, .filter3 = filter3, .BN3W = BN3W, .BN3B = BN3B,
+    .output = output, .convBuffer1 = convBuffer1, .convBuffer2 = convBuffer2,
+    .N = N, .H = H, .W = W, .CIn = CIn, .CTemp = CTemp, .HF = HF, .WF = WF,
+    .COut = COut, .HOut = HOut, .WOut = WOut, .HPadU = HPadU, .HPadD = HPadD,
+    .WPadL = WPadL, .WPadR = WPadR, .HStride = HStride, .WStride = WStride,
+    .limit1 = limit1, .limit2 = limit2, .shrU1 = shrU1, .shrX1 = shrX1,
+    .shrU2 = shrU2, .shrX2 = shrX2, .shrU3 = shrU3, .shrW3 = shrW3,
+    .shlU1 = shlU1, .shlX1 = shlX1, .shlU2 = shlU2, .shlX2 = shlX2,
+    .shlU3 = shlU3, .shlW3 = shlW3, .in_size = sizeof(Q15_T),
+    .out_size = sizeof(Q15_T), .buf_size = sizeof(Q15_T)
+  };
+  q_mbconv_threaded(&base, bandBuffers, bandBuffersSize, num_threads);
+}
+
+void q7xq15_q15_sparse_mbconv_block_threaded(const Q7_T* const input,
+  const Q15_Sparse_Filter* const filter1, const Q15_T* const BN1W,
+  const Q15_T* const BN1B, const Q15_Sparse_Filter* const filter2,
+  const Q15_T* const BN2W, const Q15_T* const BN2B,
+  const Q15_Sparse_Filter* const filter3, const Q15_T* const BN3W,
+  const Q15_T* const BN3B, Q15_T* const output, Q15_T* const convBuffer1,
+  Q15_T* const convBuffer2, ITER_T N, ITER_T H, ITER_T W, ITER_T CIn,
+  ITER_T CTemp, ITER_T HF, ITER_T WF, ITER_T COut, ITER_T HOut, ITER_T WOut,
+  S_ITER_T HPadU, S_ITER_T HPadD, S_ITER_T WPadL, S_ITER_T WPadR,
+  ITER_T HStride, ITER_T WStride, Q31_T limit1, Q31_T limit2, SCALE_T shrU1,
+  SCALE_T shrX1, SCALE_T shrU2, SCALE_T shrX2, SCALE_T shrU3, SCALE_T shrW3,
+  SCALE_T shlU1, SCALE_T shlX1, SCALE_T shlU2, SCALE_T shlX2, SCALE_T shlU3,
+  SCALE_T shlW3, void* const bandBuffers, size_t bandBuffersSize,
+  ITER_T num_threads) {
+  Q_MBConv_Band_Task base = {
+    .variant = Q_MBCONV_Q7XQ15_Q15_SPARSE, .input = input, .filter1 = filter1,
+    .BN1W = BN1W, .BN1B = BN1B, .filter2 = filter2, .BN2W = BN2W,
+    .BN2B = BN2B, .filter3 = filter3, .BN3W = BN3W, .BN3B = BN3B,
+    .output = output, .convBuffer1 = convBuffer1, .convBuffer2 = convBuffer2,
+    .N = N, .H = H, .W = W, .CIn = CIn, .CTemp = CTemp, .HF = HF, .WF = WF,
+    .COut = COut, .HOut = HOut, .WOut = WOut, .HPadU = HPadU, .HPadD = HPadD,
+    .WPadL = WPadL, .WPadR = WPadR, .HStride = HStride, .WStride = WStride,
+    .limit1 = limit1, .limit2 = limit2, .shrU1 = shrU1, .shrX1 = shrX1,
+    .shrU2 = shrU2, .shrX2 = shrX2, .shrU3 = shrU3, .shrW3 = shrW3,
+    .shlU1 = shlU1, .shlX1 = shlX1, .shlU2 = shlU2, .shlX2 = shlX2,
+    .shlU3 = shlU3, .shlW3 = shlW3, .in_size = sizeof(Q7_T),
+    .out_size = sizeof(Q15_T), .buf_size = sizeof(Q15_T)
+  };
+  q_mbconv_threaded(&base, bandBuffers, bandBuffersSize, num_threads);
+}
+
+void q15_sparse_mbconv_block_threaded(const Q15_T* const input,
+  const Q15_Sparse_Filter* const filter1, const Q15_T* const BN1W,
+  const Q15_T* const BN1B, const Q15_Sparse_Filter* const filter2,
+  const Q15_T* const BN2W, const Q15_T* const BN2B,
+  const Q15_Sparse_Filter* const filter3, const Q15_T* const BN3W,
+  const Q15_T* const BN3B, Q15_T* const output, Q15_T* const convBuffer1,
+  Q15_T* const convBuffer2, ITER_T N, ITER_T H, ITER_T W, ITER_T CIn,
+  ITER_T CTemp, ITER_T HF, ITER_T WF, ITER_T COut, ITER_T HOut, ITER_T WOut,
+  S_ITER_T HPadU, S_ITER_T HPadD, S_ITER_T WPadL, S_ITER_T WPadR,
+  ITER_T HStride, ITER_T WStride, Q31_T limit1, Q31_T limit2, SCALE_T shrU1,
+  SCALE_T shrX1, SCALE_T shrU2, SCALE_T shrX2, SCALE_T shrU3, SCALE_T shrW3,
+  SCALE_T shlU1, SCALE_T shlX1, SCALE_T shlU2, SCALE_T shlX2, SCALE_T shlU3,
+  SCALE_T shlW3, void* const bandBuffers, size_t bandBuffersSize,
+  ITER_T num_threads) {
+  Q_MBConv_Band_Task base = {
+    .variant = Q_MBCONV_Q15_SPARSE, .input = input, .filter1 = filter1,
+    .BN1W = BN1W, .BN1B = BN1B, .filter2 = filter2, .BN2W = BN2W,
+    .BN2B = BN2B, .filter3 = filter3, .BN3W = BN3W, .BN3B = BN3B,
+    .output = output, .convBuffer1 = convBuffer1, .convBuffer2 = convBuffer2,
+    .N = N, .H = H, .W = W, .CIn = CIn, .CTemp = CTemp, .HF = HF, .WF = WF,
+    .COut = COut, .HOut = HOut, .WOut = WOut, .HPadU = HPadU, .HPadD = HPadD,
+    .WPadL = WPadL, .WPadR = WPadR, .HStride = HStride, .WStride = WStride,
+    .limit1 = limit1, .limit2 = limit2, .shrU1 = shrU1, .shrX1 = shrX1,
+    .shrU2 = shrU2, .shrX2 = shrX2, .shrU3 = shrU3, .shrW3 = shrW3,
+    .shlU1 = shlU1, .shlX1 = shlX1, .shlU2 = shlU2, .shlX2 = shlX2,
+    .shlU3 = shlU3, .shlW3 = shlW3, .in_size = sizeof(Q15_T),
+    .out_size = sizeof(Q15_T), .buf_size = sizeof(Q15_T)
+  };
+  q_mbconv_threaded(&base, bandBuffers, bandBuffersSize, num_threads);
+}
@@ -0,0 +1,416 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "quantized_model_blob.h"
+
+static uint64_t align_up(uint64_t size) {
+  return (size + Q_MODEL_BLOB_ALIGN - 1) / Q_MODEL_BLOB_ALIGN * Q_MODEL_BLOB_ALIGN;
+}
+
+static uint64_t element_size(uint32_t type) {
+  switch (type) {
+    case Q_MODEL_BLOB_Q7:
+    case Q_MODEL_BLOB_RECORD:
+      return 1;
+    case Q_MODEL_BLOB_Q15:
+      return 2;
+    case Q_MODEL_BLOB_Q31:
+      return 4;
+    default:
+      return 0;
+  }
+}
+
+static const Q_Model_Blob_Entry* blob_entry(const Q_Model_Blob* blob, ITER_T i) {
+  return (const Q_Model_Blob_Entry*)(blob->data + sizeof(Q_Model_Blob_Header) + (size_t)i * blob->entry_size);
+}
+
+int q_model_blob_init(const void* data, size_t size, Q_Model_Blob* blob) {
+  const Q_Model_Blob_Header* header = (const Q_Model_Blob_Header*)data;
+  blob->data = (const unsigned char*)data;
+  blob->size = size;
+  blob->num_entries = 0;
+  blob->entry_size = 0;
+  blob->mapped = 0;
+
+  if (size < sizeof(Q_Model_Blob_Header) || header->magic != Q_MODEL_BLOB_MAGIC) {
+    return ERR_MODEL_BLOB_FORMAT;
+  }
+  if (header->version_major != Q_MODEL_BLOB_VERSION_MAJOR) {
+    return ERR_MODEL_BLOB_VERSION;
+  }
+  if (header->scale_mode != Q_MODEL_BLOB_SCALE_MODE) {
+    return ERR_MODEL_BLOB_SCALE_MODE;
+  }
+  if (header->size != size || header->entry_size < sizeof(Q_Model_Blob_Entry) ||
+      (uint64_t)header->num_entries * header->entry_size > size - sizeof(Q_Model_Blob_Header)) {
+    return ERR_MODEL_BLOB_FORMAT;
+  }
+  blob->num_entries = header->num_entries;
+  blob->entry_size = header->entry_size;
+
+  // Check all the entries once, so that the lookups can trust them
+  for (ITER_T i = 0; i < blob->num_entries; i++) {
+    const Q_Model_Blob_Entry* entry = blob_entry(blob, i);
+    uint64_t elem = element_size(entry->type);
+    if (memchr(entry->name, 0, Q_MODEL_BLOB_NAME_LEN) == 0 || elem == 0 ||
+        entry->offset % Q_MODEL_BLOB_ALIGN != 0 || entry->offset > size ||
+        entry->count > (size - entry->offset) / elem) {
+      blob->num_entries = 0;
+      return ERR_MODEL_BLOB_FORMAT;
+    }
+  }
+  return 0;
+}
+
+int q_model_blob_open(const char* path, Q_Model_Blob* blob) {
+  blob->data = 0;
+  blob->size = 0;
+  blob->num_entries = 0;
+  blob->mapped = 0;
+
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return ERR_MODEL_BLOB_IO;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+    close(fd);
+    return ERR_MODEL_BLOB_IO;
+  }
+  void* data = mmap(0, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    return ERR_MODEL_BLOB_IO;
+  }
+
+  int ret = q_model_blob_init(data, (size_t)st.st_size, blob);
+  if (ret) {
+    munmap(data, (size_t)st.st_size);
+    blob->data = 0;
+    blob->size = 0;
+    return ret;
+  }
+  blob->mapped = 1;
+  return 0;
+}
+
+void q_model_blob_close(Q_Model_Blob* blob) {
+  if (blob->mapped && blob->data) {
+    munmap((void*)blob->data, blob->size);
+  }
+  blob->data = 0;
+  blob->size = 0;
+  blob->num_entries = 0;
+  blob->mapped = 0;
+}
+
+const Q_Model_Blob_Entry* q_model_blob_find(const Q_Model_Blob* blob,
+  const char* name) {
+  for (ITER_T i = 0; i < blob->num_entries; i++) {
+    const Q_Model_Blob_Entry* entry = blob_entry(blob, i);
+    if (strncmp(entry->name, name, Q_MODEL_BLOB_NAME_LEN) == 0) {
+      return entry;
+    }
+  }
+  return 0;
+}
+
+int q_model_blob_array(const Q_Model_Blob* blob, const char* name,
+  ITER_T type, ITER_T count, const void** data) {
+  const Q_Model_Blob_Entry* entry = q_model_blob_find(blob, name);
+  *data = 0;
+  if (entry == 0) {
+    return ERR_MODEL_BLOB_MISSING_ENTRY;
+  }
+  if (entry->type != type || (count != 0 && entry->count != count)) {
+    return ERR_MODEL_BLOB_ENTRY_MISMATCH;
+  }
+  *data = (const void*)(blob->data + entry->offset);
+  return 0;
+}
+
+// Loads <prefix>.<field>. Optional entries which are missing are set to NULL
+static int load_field(const Q_Model_Blob* blob, const char* prefix,
+  const char* field, ITER_T type, ITER_T count, int optional,
+  const void** data) {
+  char name[Q_MODEL_BLOB_NAME_LEN];
+  if (snprintf(name, sizeof(name), "%s.%s", prefix, field) >= (int)sizeof(name)) {
+    return ERR_MODEL_BLOB_MISSING_ENTRY;
+  }
+  int ret = q_model_blob_array(blob, name, type, count, data);
+  if (ret == ERR_MODEL_BLOB_MISSING_ENTRY && optional) {
+    return 0;
+  }
+  return ret;
+}
+
+// Pointers to the fields of Q15_FastGRNN_Params and Q7xQ15_FastGRNN_Params, which only differ in the type of mean and stdDev
+typedef struct FastGRNN_Fields {
+  const void** mean;
+  const void** stdDev;
+  const Q15_T** W;
+  const ITER_T** Wids;
+  const Q15_T** Wvals;
+  const Q15_T** U;
+  const ITER_T** Uids;
+  const Q15_T** Uvals;
+  const Q15_T** Bg;
+  const Q15_T** Bh;
+  Q15_T* sigmoid_zeta;
+  Q15_T* sigmoid_nu;
+} FastGRNN_Fields;
+
+static int load_fastgrnn(const Q_Model_Blob* blob, const char* prefix,
+  ITER_T input_type, ITER_T inputDims, ITER_T hiddenDims,
+  const FastGRNN_Fields* fields, const Q15_FastGRNN_Scales** scales) {
+  const Q15_T* sigmoid;
+  int ret;
+  if ((ret = load_field(blob, prefix, "mean", input_type, inputDims, 1, fields->mean)) ||
+      (ret = load_field(blob, prefix, "stdDev", input_type, inputDims, 1, fields->stdDev)) ||
+      (ret = load_field(blob, prefix, "W", Q_MODEL_BLOB_Q15, hiddenDims * inputDims, 1, (const void**)fields->W)) ||
+      (ret = load_field(blob, prefix, "Wids", Q_MODEL_BLOB_Q31, 0, 1, (const void**)fields->Wids)) ||
+      (ret = load_field(blob, prefix, "Wvals", Q_MODEL_BLOB_Q15, 0, 1, (const void**)fields->Wvals)) ||
+      (ret = load_field(blob, prefix, "U", Q_MODEL_BLOB_Q15, hiddenDims * hiddenDims, 1, (const void**)fields->U)) ||
+      (ret = load_field(blob, prefix, "Uids", Q_MODEL_BLOB_Q31, 0, 1, (const void**)fields->Uids)) ||
+      (ret = load_field(blob, prefix, "Uvals", Q_MODEL_BLOB_Q15, 0, 1, (const void**)fields->Uvals)) ||
+      (ret = load_field(blob, prefix, "Bg", Q_MODEL_BLOB_Q15, hiddenDims, 0, (const void**)fields->Bg)) ||
+      (ret = load_field(blob, prefix, "Bh", Q_MODEL_BLOB_Q15, hiddenDims, 0, (const void**)fields->Bh)) ||
+      (ret = load_field(blob, prefix, "sigmoid", Q_MODEL_BLOB_Q15, 2, 0, (const void**)&sigmoid)) ||
+      (ret = load_field(blob, prefix, "scales", Q_MODEL_BLOB_RECORD, sizeof(Q15_FastGRNN_Scales), 0, (const void**)scales))) {
+    return ret;
+  }
+  // Either the dense or the sparse form of each matrix is required
+  if ((*fields->W == 0 && (*fields->Wids == 0 || *fields->Wvals == 0)) ||
+      (*fields->U == 0 && (*fields->Uids == 0 || *fields->Uvals == 0))) {
+    return ERR_MODEL_BLOB_MISSING_ENTRY;
+  }
+  *fields->sigmoid_zeta = sigmoid[0];
+  *fields->sigmoid_nu = sigmoid[1];
+  return 0;
+}
+
+int q_model_blob_q15_fastgrnn(const Q_Model_Blob* blob, const char* prefix,
+  ITER_T inputDims, ITER_T hiddenDims, Q15_FastGRNN_Params* params,
+  const Q15_FastGRNN_Scales** scales) {
+  const FastGRNN_Fields fields = {
+    (const void**)&params->mean, (const void**)&params->stdDev, &params->W,
+    &params->Wids, &params->Wvals, &params->U, &params->Uids, &params->Uvals,
+    &params->Bg, &params->Bh, &params->sigmoid_zeta, &params->sigmoid_nu
+  };
+  return load_fastgrnn(blob, prefix, Q_MODEL_BLOB_Q15, inputDims, hiddenDims,
+                       &fields, scales);
+}
+
+int q_model_blob_q7xq15_fastgrnn(const Q_Model_Blob* blob, const char* prefix,
+  ITER_T inputDims, ITER_T hiddenDims, Q7xQ15_FastGRNN_Params* params,
+  const Q15_FastGRNN_Scales** scales) {
+  const FastGRNN_Fields fields = {
+    (const void**)&params->mean, (const void**)&params->stdDev, &params->W,
+    &params->Wids, &params->Wvals, &params->U, &params->Uids, &params->Uvals,
+    &params->Bg, &params->Bh, &params->sigmoid_zeta, &params->sigmoid_nu
+  };
+  return load_fastgrnn(blob, prefix, Q_MODEL_BLOB_Q7, inputDims, hiddenDims,
+                       &fields, scales);
+}
+
+int q_model_blob_mbconv(const Q_Model_Blob* blob, const char* prefix,
+  ITER_T weight_type, ITER_T bias_type, Q_MBConv_Params* params) {
+  int ret = load_field(blob, prefix, "config", Q_MODEL_BLOB_RECORD,
+                       sizeof(Q_MBConv_Config), 0, (const void**)&params->config);
+  if (ret) {
+    return ret;
+  }
+  const Q_MBConv_Config* c = params->config;
+  if ((ret = load_field(blob, prefix, "filter1", weight_type, c->CIn * c->CTemp, 0, &params->filter1)) ||
+      (ret = load_field(blob, prefix, "BN1W", weight_type, c->CTemp, 0, &params->BN1W)) ||
+      (ret = load_field(blob, prefix, "BN1B", bias_type, c->CTemp, 0, &params->BN1B)) ||
+      (ret = load_field(blob, prefix, "filter2", weight_type, c->CTemp * c->HF * c->WF, 0, &params->filter2)) ||
+      (ret = load_field(blob, prefix, "BN2W", weight_type, c->CTemp, 0, &params->BN2W)) ||
+      (ret = load_field(blob, prefix, "BN2B", bias_type, c->CTemp, 0, &params->BN2B)) ||
+      (ret = load_field(blob, prefix, "filter3", weight_type, c->CTemp * c->COut, 0, &params->filter3)) ||
+      (ret = load_field(blob, prefix, "BN3W", weight_type, c->COut, 0, &params->BN3W)) ||
+      (ret = load_field(blob, prefix, "BN3B", bias_type, c->COut, 0, &params->BN3B))) {
+    return ret;
+  }
+  return 0;
+}
+
+int q_model_blob_pack_array(Q_Model_Blob_Packer* packer, const char* name,
+  ITER_T type, ITER_T ndims, const ITER_T* dims, const void* data) {
+  if (packer->num_entries >= Q_MODEL_BLOB_PACKER_MAX_ENTRIES) {
+    return ERR_MODEL_BLOB_FULL;
+  }
+  if (strlen(name) >= Q_MODEL_BLOB_NAME_LEN || element_size(type) == 0 ||
+      ndims > Q_MODEL_BLOB_MAX_DIMS || data == 0) {
+    return ERR_MODEL_BLOB_FORMAT;
+  }
+
+  Q_Model_Blob_Entry* entry = &packer->entries[packer->num_entries];
+  memset(entry, 0, sizeof(Q_Model_Blob_Entry));
+  strcpy(entry->name, name);
+  entry->type = type;
+  entry->ndims = ndims;
+  entry->count = 1;
+  for (ITER_T d = 0; d < Q_MODEL_BLOB_MAX_DIMS; d++) {
+    entry->dims[d] = d < ndims ? dims[d] : 1;
+    entry->count *= entry->dims[d];
+  }
+  packer->data[packer->num_entries] = data;
+  packer->num_entries++;
+  return 0;
+}
+
+// Adds <prefix>.<field> to the packer. NULL arrays are skipped
+static int pack_field(Q_Model_Blob_Packer* packer, const char* prefix,
+  const char* field, ITER_T type, ITER_T dim0, ITER_T dim1, const void* data) {
+  char name[Q_MODEL_BLOB_NAME_LEN];
+  const ITER_T dims[2] = {dim0, dim1};
+  if (data == 0) {
+    return 0;
+  }
+  if (snprintf(name, sizeof(name), "%s.%s", prefix, field) >= (int)sizeof(name)) {
+    return ERR_MODEL_BLOB_FORMAT;
+  }
+  return q_model_blob_pack_array(packer, name, type, dim1 ? 2 : 1, dims, data);
+}
+
+// Number of indices of a sparse matrix, i.e. its non-zeros and the terminating zero of each column
+static ITER_T sparse_ids_count(const ITER_T* ids, ITER_T ncols) {
+  ITER_T count = 0;
+  for (ITER_T c = 0; c < ncols; c++) {
+    while (ids[count] != 0) {
+      count++;
+    }
+    count++;
+  }
+  return count;
+}
+
+static int pack_fastgrnn(Q_Model_Blob_Packer* packer, const char* prefix,
+  ITER_T input_type, const void* mean, const void* stdDev,
+  const Q15_FastGRNN_Params* params, const Q15_FastGRNN_Scales* scales,
+  ITER_T inputDims, ITER_T hiddenDims) {
+  if (packer->num_entries >= Q_MODEL_BLOB_PACKER_MAX_ENTRIES) {
+    return ERR_MODEL_BLOB_FULL;
+  }
+  ITER_T Wids = params->Wids ? sparse_ids_count(params->Wids, inputDims) : 0;
+  ITER_T Uids = params->Uids ? sparse_ids_count(params->Uids, hiddenDims) : 0;
+  Q15_T* sigmoid = packer->sigmoid[packer->num_entries];
+  sigmoid[0] = params->sigmoid_zeta;
+  sigmoid[1] = params->sigmoid_nu;
+
+  int ret;
+  if ((ret = pack_field(packer, prefix, "mean", input_type, inputDims, 0, mean)) ||
+      (ret = pack_field(packer, prefix, "stdDev", input_type, inputDims, 0, stdDev)) ||
+      (ret = pack_field(packer, prefix, "W", Q_MODEL_BLOB_Q15, hiddenDims, inputDims, params->W)) ||
+      (ret = pack_field(packer, prefix, "Wids", Q_MODEL_BLOB_Q31, Wids, 0, params->Wids)) ||
+      (ret = pack_field(packer, prefix, "Wvals", Q_MODEL_BLOB_Q15, Wids - inputDims, 0, params->Wvals)) ||
+      (ret = pack_field(packer, prefix, "U", Q_MODEL_BLOB_Q15, hiddenDims, hiddenDims, params->U)) ||
+      (ret = pack_field(packer, prefix, "Uids", Q_MODEL_BLOB_Q31, Uids, 0, params->Uids)) ||
+      (ret = pack_field(packer, prefix, "Uvals", Q_MODEL_BLOB_Q15, Uids - hiddenDims, 0, params->Uvals)) ||
+      (ret = pack_field(packer, prefix, "Bg", Q_MODEL_BLOB_Q15, hiddenDims, 0, params->Bg)) ||
+      (ret = pack_field(packer, prefix, "Bh", Q_MODEL_BLOB_Q15, hiddenDims, 0, params->Bh)) ||
+      (ret = pack_field(packer, prefix, "sigmoid", Q_MODEL_BLOB_Q15, 2, 0, sigmoid)) ||
+      (ret = pack_field(packer, prefix, "scales", Q_MODEL_BLOB_RECORD, sizeof(Q15_FastGRNN_Scales), 0, scales))) {
+    return ret;
+  }
+  return 0;
+}
+
+int q_model_blob_pack_q15_fastgrnn(Q_Model_Blob_Packer* packer,
+  const char* prefix, const Q15_FastGRNN_Params* params,
+  const Q15_FastGRNN_Scales* scales, ITER_T inputDims, ITER_T hiddenDims) {
+  return pack_fastgrnn(packer, prefix, Q_MODEL_BLOB_Q15, params->mean,
+                       params->stdDev, params, scales, inputDims, hiddenDims);
+}
+
+int q_model_blob_pack_q7xq15_fastgrnn(Q_Model_Blob_Packer* packer,
+  const char* prefix, const Q7xQ15_FastGRNN_Params* params,
+  const Q15_FastGRNN_Scales* scales, ITER_T inputDims, ITER_T hiddenDims) {
+  // Same layout as Q15_FastGRNN_Params apart from the types of mean and stdDev, which are packed separately
+  Q15_FastGRNN_Params shared;
+  memset(&shared, 0, sizeof(shared));
+  shared.W = params->W;
+  shared.Wids = params->Wids;
+  shared.Wvals = params->Wvals;
+  shared.U = params->U;
+  shared.Uids = params->Uids;
+  shared.Uvals = params->Uvals;
+  shared.Bg = params->Bg;
+  shared.Bh = params->Bh;
+  shared.sigmoid_zeta = params->sigmoid_zeta;
+  shared.sigmoid_nu = params->sigmoid_nu;
+  return pack_fastgrnn(packer, prefix, Q_MODEL_BLOB_Q7, params->mean,
+                       params->stdDev, &shared, scales, inputDims, hiddenDims);
+}
+
+int q_model_blob_pack_mbconv(Q_Model_Blob_Packer* packer, const char* prefix,
+  const Q_MBConv_Params* params, ITER_T weight_type, ITER_T bias_type) {
+  const Q_MBConv_Config* c = params->config;
+  int ret;
+  if ((ret = pack_field(packer, prefix, "config", Q_MODEL_BLOB_RECORD, sizeof(Q_MBConv_Config), 0, c)) ||
+      (ret = pack_field(packer, prefix, "filter1", weight_type, c->CIn, c->CTemp, params->filter1)) ||
+      (ret = pack_field(packer, prefix, "BN1W", weight_type, c->CTemp, 0, params->BN1W)) ||
+      (ret = pack_field(packer, prefix, "BN1B", bias_type, c->CTemp, 0, params->BN1B)) ||
+      (ret = pack_field(packer, prefix, "filter2", weight_type, c->CTemp, c->HF * c->WF, params->filter2)) ||
+      (ret = pack_field(packer, prefix, "BN2W", weight_type, c->CTemp, 0, params->BN2W)) ||
+      (ret = pack_field(packer, prefix, "BN2B", bias_type, c->CTemp, 0, params->BN2B)) ||
+      (ret = pack_field(packer, prefix, "filter3", weight_type, c->CTemp, c->COut, params->filter3)) ||
+      (ret = pack_field(packer, prefix, "BN3W", weight_type, c->COut, 0, params->BN3W)) ||
+      (ret = pack_field(packer, prefix, "BN3B", bias_type, c->COut, 0, params->BN3B))) {
+    return ret;
+  }
+  return 0;
+}
+
+int q_model_blob_write(const Q_Model_Blob_Packer* packer, const char* path) {
+  static const unsigned char padding[Q_MODEL_BLOB_ALIGN] = {0};
+  Q_Model_Blob_Header header;
+  memset(&header, 0, sizeof(header));
+  header.magic = Q_MODEL_BLOB_MAGIC;
+  header.version_major = Q_MODEL_BLOB_VERSION_MAJOR;
+  header.version_minor = Q_MODEL_BLOB_VERSION_MINOR;
+  header.scale_mode = Q_MODEL_BLOB_SCALE_MODE;
+  header.num_entries = packer->num_entries;
+  header.entry_size = sizeof(Q_Model_Blob_Entry);
+
+  // Assign the offsets of the arrays after the entry table
+  uint64_t offset = align_up(sizeof(Q_Model_Blob_Header) + (uint64_t)packer->num_entries * sizeof(Q_Model_Blob_Entry));
+  const uint64_t data_start = offset;
+  for (ITER_T i = 0; i < packer->num_entries; i++) {
+    offset = align_up(offset + packer->entries[i].count * element_size(packer->entries[i].type));
+  }
+  header.size = offset;
+
+  FILE* file = fopen(path, "wb");
+  if (file == 0) {
+    return ERR_MODEL_BLOB_IO;
+  }
+  int ok = fwrite(&header, sizeof(header), 1, file) == 1;
+  offset = data_start;
+  for (ITER_T i = 0; ok && i < packer->num_entries; i++) {
+    Q_Model_Blob_Entry entry = packer->entries[i];
+    entry.offset = offset;
+    ok = fwrite(&entry, sizeof(entry), 1, file) == 1;
+    offset = align_up(offset + entry.count * element_size(entry.type));
+  }
+  uint64_t written = sizeof(Q_Model_Blob_Header) + (uint64_t)packer->num_entries * sizeof(Q_Model_Blob_Entry);
+  for (ITER_T i = 0; ok && i < packer->num_entries; i++) {
+    uint64_t bytes = packer->entries[i].count * element_size(packer->entries[i].type);
+    ok = fwrite(padding, 1, align_up(written) - written, file) == align_up(written) - written &&
+         fwrite(packer->data[i], 1, bytes, file) == bytes;
+    written = align_up(written) + bytes;
+  }
+  ok = ok && fwrite(padding, 1, header.size - written, file) == header.size - written;
+  if (fclose(file) != 0) {
+    ok = 0;
+  }
+  return ok ? 0 : ERR_MODEL_BLOB_IO;
+}
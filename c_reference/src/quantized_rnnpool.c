@@ -1,12 +1,15 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // Licensed under the MIT license.
 
+#include <stdlib.h>
 #include <string.h>
 #include "quantized_rnnpool.h"
+#include "parallel.h"
 
 int q7xq15_q15_rnnpool_block(const Q7_T* const patch, ITER_T inputDims,
   ITER_T patchDim, ITER_T stride, q7xq15_q15_rnn_t rnn1, ITER_T hiddenDims1,
   const void* rnn1_params, void* rnn1_buffers, const void* rnn1_scales,
+  q7xq15_q15_rnn_batch_t rnn1_batch, void* rnn1_batch_buffers,
   q15_rnn_t rnn2, ITER_T hiddenDims2, const void* rnn2_params,
   void* rnn2_buffers, const void* rnn2_scales, Q15_T* const output,
   Q15_T* const buffer, SCALE_T ShR1, SCALE_T ShL1, SCALE_T ShR2, SCALE_T ShL2) {
@@ -15,9 +18,20 @@ int q7xq15_q15_rnnpool_block(const Q7_T* const patch, ITER_T inputDims,
 
   // Horizontal pass over each row with RNN1
   memset(buffer, 0, sizeof(Q15_T) * hiddenDims1 * patchDim);
-  for (ITER_T r = 0; r < patchDim; ++r) {
-    rnn1(buffer + r * hiddenDims1, hiddenDims1, patch + stride * r * inputDims,
-         inputDims, patchDim, rnn1_params, rnn1_buffers, rnn1_scales, 0, 0);
+  if (rnn1_batch) {
+    // All the rows advance together by one column. The pixels of a column are
+    // stride pixels apart, the hidden states of the rows are contiguous
+    for (ITER_T c = 0; c < patchDim; ++c) {
+      rnn1_batch(buffer, hiddenDims1, patch + c * inputDims, inputDims,
+                 stride * inputDims, patchDim, rnn1_params,
+                 rnn1_batch_buffers, rnn1_scales, 0);
+    }
+  } else {
+    for (ITER_T r = 0; r < patchDim; ++r) {
+      rnn1(buffer + r * hiddenDims1, hiddenDims1,
+           patch + stride * r * inputDims, inputDims, patchDim, rnn1_params,
+           rnn1_buffers, rnn1_scales, 0, 0);
+    }
   }
 
   q15_v_scale_up(buffer, patchDim * hiddenDims1, buffer, ShL1);
@@ -31,11 +45,21 @@ int q7xq15_q15_rnnpool_block(const Q7_T* const patch, ITER_T inputDims,
 
   // Vertical pass over each column with RNN1
   memset(buffer, 0, sizeof(Q15_T) * hiddenDims1 * patchDim);
-  for (ITER_T c = 0; c < patchDim; ++c) {
+  if (rnn1_batch) {
+    // All the columns advance together by one row. The pixels of a row are
+    // contiguous, and so are the hidden states of the columns in the buffer
     for (ITER_T r = 0; r < patchDim; ++r) {
-      rnn1(buffer + c * hiddenDims1, hiddenDims1,
-           patch + (stride * r + c) * inputDims, inputDims, 1, rnn1_params,
-           rnn1_buffers, rnn1_scales, 0, 0);
+      rnn1_batch(buffer, hiddenDims1, patch + stride * r * inputDims,
+                 inputDims, inputDims, patchDim, rnn1_params,
+                 rnn1_batch_buffers, rnn1_scales, 0);
+    }
+  } else {
+    for (ITER_T c = 0; c < patchDim; ++c) {
+      for (ITER_T r = 0; r < patchDim; ++r) {
+        rnn1(buffer + c * hiddenDims1, hiddenDims1,
+             patch + (stride * r + c) * inputDims, inputDims, 1, rnn1_params,
+             rnn1_buffers, rnn1_scales, 0, 0);
+      }
     }
   }
 
@@ -57,6 +81,7 @@ int q7xq15_q15_rnnpool_block(const Q7_T* const patch, ITER_T inputDims,
 int q15_rnnpool_block(const Q15_T* const patch, ITER_T inputDims,
   ITER_T patchDim, ITER_T stride, q15_rnn_t rnn1, ITER_T hiddenDims1,
   const void* rnn1_params, void* rnn1_buffers, const void* rnn1_scales,
+  q15_rnn_batch_t rnn1_batch, void* rnn1_batch_buffers,
   q15_rnn_t rnn2, ITER_T hiddenDims2, const void* rnn2_params,
   void* rnn2_buffers, const void* rnn2_scales, Q15_T* const output,
   Q15_T* const buffer, SCALE_T ShR1, SCALE_T ShL1, SCALE_T ShR2, SCALE_T ShL2) {
@@ -65,9 +90,20 @@ int q15_rnnpool_block(const Q15_T* const patch, ITER_T inputDims,
 
   // Horizontal pass over each row with RNN1
   memset(buffer, 0, sizeof(Q15_T) * hiddenDims1 * patchDim);
-  for (ITER_T r = 0; r < patchDim; ++r) {
-    rnn1(buffer + r * hiddenDims1, hiddenDims1, patch + stride * r * inputDims,
-         inputDims, patchDim, rnn1_params, rnn1_buffers, rnn1_scales, 0, 0);
+  if (rnn1_batch) {
+    // All the rows advance together by one column. The pixels of a column are
+    // stride pixels apart, the hidden states of the rows are contiguous
+    for (ITER_T c = 0; c < patchDim; ++c) {
+      rnn1_batch(buffer, hiddenDims1, patch + c * inputDims, inputDims,
+                 stride * inputDims, patchDim, rnn1_params,
+                 rnn1_batch_buffers, rnn1_scales, 0);
+    }
+  } else {
+    for (ITER_T r = 0; r < patchDim; ++r) {
+      rnn1(buffer + r * hiddenDims1, hiddenDims1,
+           patch + stride * r * inputDims, inputDims, patchDim, rnn1_params,
+           rnn1_buffers, rnn1_scales, 0, 0);
+    }
   }
 
   q15_v_scale_up(buffer, patchDim * hiddenDims1, buffer, ShL1);
@@ -81,11 +117,21 @@ int q15_rnnpool_block(const Q15_T* const patch, ITER_T inputDims,
 
   // Vertical pass over each column with RNN1
   memset(buffer, 0, sizeof(Q15_T) * hiddenDims1 * patchDim);
-  for (ITER_T c = 0; c < patchDim; ++c) {
+  if (rnn1_batch) {
+    // All the columns advance together by one row. The pixels of a row are
+    // contiguous, and so are the hidden states of the columns in the buffer
     for (ITER_T r = 0; r < patchDim; ++r) {
-      rnn1(buffer + c * hiddenDims1, hiddenDims1,
-           patch + (stride * r + c) * inputDims, inputDims, 1, rnn1_params,
-           rnn1_buffers, rnn1_scales, 0, 0);
+      rnn1_batch(buffer, hiddenDims1, patch + stride * r * inputDims,
+                 inputDims, inputDims, patchDim, rnn1_params,
+                 rnn1_batch_buffers, rnn1_scales, 0);
+    }
+  } else {
+    for (ITER_T c = 0; c < patchDim; ++c) {
+      for (ITER_T r = 0; r < patchDim; ++r) {
+        rnn1(buffer + c * hiddenDims1, hiddenDims1,
+             patch + (stride * r + c) * inputDims, inputDims, 1, rnn1_params,
+             rnn1_buffers, rnn1_scales, 0, 0);
+      }
     }
   }
 
@@ -103,3 +149,190 @@ int q15_rnnpool_block(const Q15_T* const patch, ITER_T inputDims,
 
   return 0;
 }
+
+// Arguments for a range [patch_begin, patch_end) of the row-major patch grid
+typedef struct Q_RNNPool_Patches_Task {
+  const void* patch;
+  ITER_T inputDims;
+  ITER_T patchDim;
+  ITER_T stride;
+  ITER_T patchesY;
+  ITER_T patchStrideX;
+  ITER_T patchStrideY;
+  // Only the cells of the data type of the patch are set
+  q7xq15_q15_rnn_t q7xq15_q15_rnn1;
+  q7xq15_q15_rnn_batch_t q7xq15_q15_rnn1_batch;
+  q15_rnn_t q15_rnn1;
+  q15_rnn_batch_t q15_rnn1_batch;
+  ITER_T hiddenDims1;
+  const void* rnn1_params;
+  const void* rnn1_scales;
+  q15_rnn_t rnn2;
+  ITER_T hiddenDims2;
+  const void* rnn2_params;
+  const void* rnn2_scales;
+  void* output;
+  ITER_T outputStrideX;
+  SCALE_T ShR1;
+  SCALE_T ShL1;
+  SCALE_T ShR2;
+  SCALE_T ShL2;
+  const Q_RNNPool_Worker_Buffers* worker;
+  const unsigned char* mask;
+  ITER_T patch_begin;
+  ITER_T patch_end;
+  int error;
+} Q_RNNPool_Patches_Task;
+
+static void q7xq15_q15_rnnpool_patches_task(void* args) {
+  Q_RNNPool_Patches_Task* task = (Q_RNNPool_Patches_Task*)args;
+  const Q_RNNPool_Worker_Buffers* worker = task->worker;
+  ITER_T outDims = 4 * task->hiddenDims2;
+  for (ITER_T p = task->patch_begin; p < task->patch_end; p++) {
+    if (task->mask && !task->mask[p]) {
+      continue;
+    }
+    ITER_T x = p / task->patchesY, y = p % task->patchesY;
+    int error = q7xq15_q15_rnnpool_block((const Q7_T*)task->patch +
+      x * task->patchStrideX + y * task->patchStrideY, task->inputDims,
+      task->patchDim, task->stride, task->q7xq15_q15_rnn1,
+      task->hiddenDims1, task->rnn1_params, worker->rnn1_buffers,
+      task->rnn1_scales, task->q7xq15_q15_rnn1_batch,
+      worker->rnn1_batch_buffers, task->rnn2, task->hiddenDims2,
+      task->rnn2_params, worker->rnn2_buffers, task->rnn2_scales,
+      worker->output, worker->buffer, task->ShR1, task->ShL1, task->ShR2,
+      task->ShL2);
+    if (error && !task->error) {
+      task->error = error;
+    }
+
+    Q7_T* output_offset = (Q7_T*)task->output + x * task->outputStrideX + y * outDims;
+    for (ITER_T i = 0; i < outDims; i++) {
+      output_offset[i] = (Q7_T)(worker->output[i]);
+    }
+  }
+}
+
+static void q15_rnnpool_patches_task(void* args) {
+  Q_RNNPool_Patches_Task* task = (Q_RNNPool_Patches_Task*)args;
+  const Q_RNNPool_Worker_Buffers* worker = task->worker;
+  ITER_T outDims = 4 * task->hiddenDims2;
+  for (ITER_T p = task->patch_begin; p < task->patch_end; p++) {
+    if (task->mask && !task->mask[p]) {
+      continue;
+    }
+    ITER_T x = p / task->patchesY, y = p % task->patchesY;
+    int error = q15_rnnpool_block((const Q15_T*)task->patch +
+      x * task->patchStrideX + y * task->patchStrideY, task->inputDims,
+      task->patchDim, task->stride, task->q15_rnn1, task->hiddenDims1,
+      task->rnn1_params, worker->rnn1_buffers, task->rnn1_scales,
+      task->q15_rnn1_batch, worker->rnn1_batch_buffers,
+      task->rnn2, task->hiddenDims2, task->rnn2_params, worker->rnn2_buffers,
+      task->rnn2_scales, worker->output, worker->buffer, task->ShR1,
+      task->ShL1, task->ShR2, task->ShL2);
+    if (error && !task->error) {
+      task->error = error;
+    }
+
+    memcpy((Q15_T*)task->output + x * task->outputStrideX + y * outDims,
+           worker->output, outDims * sizeof(Q15_T));
+  }
+}
+
+// Split the patches into num_threads contiguous ranges of the row-major grid,
+// each with the same number of patches to compute
+static int rnnpool_patches(void (*run)(void*), Q_RNNPool_Patches_Task* base,
+  ITER_T num_patches, ITER_T num_threads) {
+  ITER_T num_computed = num_patches;
+  if (base->mask) {
+    num_computed = 0;
+    for (ITER_T p = 0; p < num_patches; p++) {
+      num_computed += (base->mask[p] != 0);
+    }
+  }
+  if (num_threads > num_computed) {
+    num_threads = num_computed ? num_computed : 1;
+  }
+
+  Q_RNNPool_Patches_Task* tasks = 0;
+  if (num_threads > 1) {
+    tasks = (Q_RNNPool_Patches_Task*)malloc(num_threads * sizeof(Q_RNNPool_Patches_Task));
+  }
+  if (tasks == 0) {
+    base->patch_begin = 0;
+    base->patch_end = num_patches;
+    run(base);
+    return base->error;
+  }
+
+  ITER_T p = 0, computed = 0;
+  for (ITER_T i = 0; i < num_threads; i++) {
+    ITER_T end = (num_computed * (i + 1)) / num_threads;
+    tasks[i] = *base;
+    tasks[i].worker = base->worker + i;
+    tasks[i].patch_begin = p;
+    while (p < num_patches && computed < end) {
+      computed += (!base->mask || base->mask[p]);
+      p++;
+    }
+    tasks[i].patch_end = (i == num_threads - 1) ? num_patches : p;
+  }
+  parallel_for(run, tasks, sizeof(Q_RNNPool_Patches_Task), num_threads);
+
+  int error = 0;
+  for (ITER_T i = 0; i < num_threads && !error; i++) {
+    error = tasks[i].error;
+  }
+  free(tasks);
+  return error;
+}
+
+int q7xq15_q15_rnnpool_patches(const Q7_T* const patch, ITER_T inputDims,
+  ITER_T patchDim, ITER_T stride, ITER_T patchesX, ITER_T patchesY,
+  ITER_T patchStrideX, ITER_T patchStrideY, q7xq15_q15_rnn_t rnn1,
+  ITER_T hiddenDims1, const void* rnn1_params, const void* rnn1_scales,
+  q7xq15_q15_rnn_batch_t rnn1_batch, q15_rnn_t rnn2, ITER_T hiddenDims2,
+  const void* rnn2_params, const void* rnn2_scales, Q7_T* const output,
+  ITER_T outputStrideX, SCALE_T ShR1, SCALE_T ShL1, SCALE_T ShR2,
+  SCALE_T ShL2, const unsigned char* mask,
+  const Q_RNNPool_Worker_Buffers* workers, ITER_T num_threads) {
+  Q_RNNPool_Patches_Task base = {
+    .patch = patch, .inputDims = inputDims, .patchDim = patchDim,
+    .stride = stride, .patchesY = patchesY, .patchStrideX = patchStrideX,
+    .patchStrideY = patchStrideY, .q7xq15_q15_rnn1 = rnn1,
+    .q7xq15_q15_rnn1_batch = rnn1_batch, .hiddenDims1 = hiddenDims1,
+    .rnn1_params = rnn1_params, .rnn1_scales = rnn1_scales,
+    .rnn2 = rnn2, .hiddenDims2 = hiddenDims2, .rnn2_params = rnn2_params,
+    .rnn2_scales = rnn2_scales, .output = output,
+    .outputStrideX = outputStrideX, .ShR1 = ShR1, .ShL1 = ShL1,
+    .ShR2 = ShR2, .ShL2 = ShL2, .worker = workers, .mask = mask,
+    .error = 0
+  };
+  return rnnpool_patches(q7xq15_q15_rnnpool_patches_task, &base,
+                         patchesX * patchesY, num_threads);
+}
+
+int q15_rnnpool_patches(const Q15_T* const patch, ITER_T inputDims,
+  ITER_T patchDim, ITER_T stride, ITER_T patchesX, ITER_T patchesY,
+  ITER_T patchStrideX, ITER_T patchStrideY, q15_rnn_t rnn1,
+  ITER_T hiddenDims1, const void* rnn1_params, const void* rnn1_scales,
+  q15_rnn_batch_t rnn1_batch, q15_rnn_t rnn2, ITER_T hiddenDims2,
+  const void* rnn2_params, const void* rnn2_scales, Q15_T* const output,
+  ITER_T outputStrideX, SCALE_T ShR1, SCALE_T ShL1, SCALE_T ShR2,
+  SCALE_T ShL2, const unsigned char* mask,
+  const Q_RNNPool_Worker_Buffers* workers, ITER_T num_threads) {
+  Q_RNNPool_Patches_Task base = {
+    .patch = patch, .inputDims = inputDims, .patchDim = patchDim,
+    .stride = stride, .patchesY = patchesY, .patchStrideX = patchStrideX,
+    .patchStrideY = patchStrideY, .q15_rnn1 = rnn1,
+    .q15_rnn1_batch = rnn1_batch, .hiddenDims1 = hiddenDims1,
+    .rnn1_params = rnn1_params, .rnn1_scales = rnn1_scales,
+    .rnn2 = rnn2, .hiddenDims2 = hiddenDims2, .rnn2_params = rnn2_params,
+    .rnn2_scales = rnn2_scales, .output = output,
+    .outputStrideX = outputStrideX, .ShR1 = ShR1, .ShL1 = ShL1,
+    .ShR2 = ShR2, .ShL2 = ShL2, .worker = workers, .mask = mask,
+    .error = 0
+  };
+  return rnnpool_patches(q15_rnnpool_patches_task, &base,
+                         patchesX * patchesY, num_threads);
+}
@@ -0,0 +1,771 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#ifdef MULTITHREADED
+  #include <pthread.h>
+#endif
+#include "quantized_simd.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+  #define Q_SIMD_X86
+  #include <immintrin.h>
+  #define TARGET_SSE41 __attribute__((target("sse4.1")))
+  #define TARGET_AVX2 __attribute__((target("avx2")))
+#elif defined(__ARM_NEON)
+  #include <arm_neon.h>
+#endif
+
+// Shortest vector handled by the kernels. Below it, the scale conversion and the
+// dispatch cost more than the scalar loop of the caller
+#define Q_SIMD_MIN_LEN 8
+
+// Shift equivalent of a scale. In the divide mode, mask = scale - 1 is added to
+// the negative numbers before the shift, so that the result is rounded towards
+// zero like the C integer division
+typedef struct Q_Simd_Scale {
+  Q31_T count;
+  Q31_T mask;
+} Q_Simd_Scale;
+
+static int to_simd_scale(SCALE_T scale, Q_Simd_Scale* out) {
+  #ifdef SHIFT
+    out->count = scale;
+    out->mask = 0;
+  #else
+    if (scale <= 0 || (scale & (scale - 1))) {
+      return 0;
+    }
+    #ifdef __GNUC__
+      out->count = __builtin_ctz((unsigned)scale);
+    #else
+      out->count = 0;
+      while ((1 << out->count) != scale) {
+        out->count++;
+      }
+    #endif
+    out->mask = scale - 1;
+  #endif
+  return 1;
+}
+
+static int detected_level = Q_SIMD_NONE;
+static int active_level = Q_SIMD_NONE;
+
+static int detect_level(void) {
+  #if defined(Q_SIMD_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+      return Q_SIMD_AVX2;
+    }
+    if (__builtin_cpu_supports("sse4.1")) {
+      return Q_SIMD_SSE41;
+    }
+    return Q_SIMD_NONE;
+  #elif defined(__ARM_NEON)
+    return Q_SIMD_NEON;
+  #else
+    return Q_SIMD_NONE;
+  #endif
+}
+
+static void init_level(void) {
+  detected_level = detect_level();
+  active_level = detected_level;
+}
+
+// The kernels of several threads can make the first call at the same time.
+// pthread_once runs the detection once and publishes it to all of them
+#ifdef MULTITHREADED
+  static pthread_once_t level_once = PTHREAD_ONCE_INIT;
+#else
+  static int level_initialized = 0;
+#endif
+
+static void init_level_once(void) {
+  #ifdef MULTITHREADED
+    pthread_once(&level_once, init_level);
+  #else
+    if (!level_initialized) {
+      init_level();
+      level_initialized = 1;
+    }
+  #endif
+}
+
+int q_simd_level(void) {
+  init_level_once();
+  return active_level;
+}
+
+int q_simd_set_level(int level) {
+  init_level_once();
+  if (level == Q_SIMD_NONE || level == detected_level) {
+    active_level = level;
+  }
+  #if defined(Q_SIMD_X86)
+    else if (level == Q_SIMD_SSE41 && detected_level == Q_SIMD_AVX2) {
+      active_level = level;
+    }
+  #endif
+  return active_level;
+}
+
+#if defined(Q_SIMD_X86)
+
+TARGET_SSE41 static inline __m128i scale_sse41(__m128i x, __m128i mask,
+                                               __m128i count) {
+  #ifndef SHIFT
+    x = _mm_add_epi32(x, _mm_and_si128(_mm_srai_epi32(x, 31), mask));
+  #endif
+  return _mm_sra_epi32(x, count);
+}
+
+// Truncates 2 x 4 Q31 values to Q15 (same as the implicit conversion in C) and packs them
+TARGET_SSE41 static inline __m128i pack_q15_sse41(__m128i lo, __m128i hi) {
+  lo = _mm_srai_epi32(_mm_slli_epi32(lo, 16), 16);
+  hi = _mm_srai_epi32(_mm_slli_epi32(hi, 16), 16);
+  return _mm_packs_epi32(lo, hi);
+}
+
+// Adds the sign extended Q31 values to the Q63 accumulators. pmaddwd overflows
+// only for (-32768 * -32768) * 2 = 2^31, which it returns as -2^31. This is
+// the only case where -2^31 is returned, so it is corrected by adding 2^32
+TARGET_SSE41 static inline void add_q63_sse41(__m128i x, __m128i* acc_lo,
+                                              __m128i* acc_hi) {
+  __m128i overflow = _mm_cmpeq_epi32(x, _mm_set1_epi32((Q31_T)0x80000000));
+  __m128i x_hi = _mm_srli_si128(x, 8);
+  __m128i overflow_hi = _mm_srli_si128(overflow, 8);
+  *acc_lo = _mm_add_epi64(*acc_lo, _mm_cvtepi32_epi64(x));
+  *acc_lo = _mm_sub_epi64(*acc_lo, _mm_slli_epi64(_mm_cvtepi32_epi64(overflow), 32));
+  *acc_hi = _mm_add_epi64(*acc_hi, _mm_cvtepi32_epi64(x_hi));
+  *acc_hi = _mm_sub_epi64(*acc_hi, _mm_slli_epi64(_mm_cvtepi32_epi64(overflow_hi), 32));
+}
+
+TARGET_SSE41 static ITER_T q15_v_add_sse41(const Q15_T* vec1,
+  const Q15_T* vec2, ITER_T len, Q15_T* ret, const Q_Simd_Scale* scales) {
+  __m128i mask1 = _mm_set1_epi32(scales[0].mask);
+  __m128i mask2 = _mm_set1_epi32(scales[1].mask);
+  __m128i mask3 = _mm_set1_epi32(scales[2].mask);
+  __m128i count1 = _mm_cvtsi32_si128(scales[0].count);
+  __m128i count2 = _mm_cvtsi32_si128(scales[1].count);
+  __m128i count3 = _mm_cvtsi32_si128(scales[2].count);
+  ITER_T done = len & ~7u;
+
+  for (ITER_T i = 0; i < done; i += 8) {
+    __m128i a = _mm_loadu_si128((const __m128i*)(vec1 + i));
+    __m128i b = _mm_loadu_si128((const __m128i*)(vec2 + i));
+    __m128i lo = _mm_add_epi32(scale_sse41(_mm_cvtepi16_epi32(a), mask1, count1),
+                               scale_sse41(_mm_cvtepi16_epi32(b), mask2, count2));
+    __m128i hi = _mm_add_epi32(scale_sse41(_mm_cvtepi16_epi32(_mm_srli_si128(a, 8)), mask1, count1),
+                               scale_sse41(_mm_cvtepi16_epi32(_mm_srli_si128(b, 8)), mask2, count2));
+    lo = scale_sse41(lo, mask3, count3);
+    hi = scale_sse41(hi, mask3, count3);
+    _mm_storeu_si128((__m128i*)(ret + i), pack_q15_sse41(lo, hi));
+  }
+  return done;
+}
+
+TARGET_SSE41 static ITER_T q15_v_hadamard_sse41(const Q15_T* vec1,
+  const Q15_T* vec2, ITER_T len, Q15_T* ret, const Q_Simd_Scale* scale) {
+  __m128i mask = _mm_set1_epi32(scale->mask);
+  __m128i count = _mm_cvtsi32_si128(scale->count);
+  ITER_T done = len & ~7u;
+
+  for (ITER_T i = 0; i < done; i += 8) {
+    __m128i a = _mm_loadu_si128((const __m128i*)(vec1 + i));
+    __m128i b = _mm_loadu_si128((const __m128i*)(vec2 + i));
+    __m128i prod_lo = _mm_mullo_epi16(a, b);
+    __m128i prod_hi = _mm_mulhi_epi16(a, b);
+    __m128i lo = scale_sse41(_mm_unpacklo_epi16(prod_lo, prod_hi), mask, count);
+    __m128i hi = scale_sse41(_mm_unpackhi_epi16(prod_lo, prod_hi), mask, count);
+    _mm_storeu_si128((__m128i*)(ret + i), pack_q15_sse41(lo, hi));
+  }
+  return done;
+}
+
+TARGET_SSE41 static ITER_T q15xq7_v_dot_sse41(const Q15_T* vec1,
+  const Q7_T* vec2, ITER_T len, Q31_T* sum) {
+  __m128i acc = _mm_setzero_si128();
+  __m128i acc1 = _mm_setzero_si128();
+  ITER_T done = len & ~7u;
+  ITER_T i = 0;
+
+  for (; i + 16 <= done; i += 16) {
+    __m128i a0 = _mm_loadu_si128((const __m128i*)(vec1 + i));
+    __m128i a1 = _mm_loadu_si128((const __m128i*)(vec1 + i + 8));
+    __m128i b = _mm_loadu_si128((const __m128i*)(vec2 + i));
+    acc = _mm_add_epi32(acc, _mm_madd_epi16(a0, _mm_cvtepi8_epi16(b)));
+    acc1 = _mm_add_epi32(acc1, _mm_madd_epi16(a1, _mm_cvtepi8_epi16(_mm_srli_si128(b, 8))));
+  }
+  if (i < done) {
+    __m128i a = _mm_loadu_si128((const __m128i*)(vec1 + i));
+    __m128i b = _mm_cvtepi8_epi16(_mm_loadl_epi64((const __m128i*)(vec2 + i)));
+    acc = _mm_add_epi32(acc, _mm_madd_epi16(a, b));
+  }
+  acc = _mm_add_epi32(acc, acc1);
+  acc = _mm_add_epi32(acc, _mm_srli_si128(acc, 8));
+  acc = _mm_add_epi32(acc, _mm_srli_si128(acc, 4));
+  *sum = (Q31_T)((uint32_t)*sum + (uint32_t)_mm_cvtsi128_si32(acc));
+  return done;
+}
+
+TARGET_SSE41 static ITER_T q15_v_dot_sse41(const Q15_T* vec1,
+  const Q15_T* vec2, ITER_T len, Q63_T* sum) {
+  __m128i acc_lo = _mm_setzero_si128();
+  __m128i acc_hi = _mm_setzero_si128();
+  ITER_T done = len & ~7u;
+
+  for (ITER_T i = 0; i < done; i += 8) {
+    __m128i a = _mm_loadu_si128((const __m128i*)(vec1 + i));
+    __m128i b = _mm_loadu_si128((const __m128i*)(vec2 + i));
+    add_q63_sse41(_mm_madd_epi16(a, b), &acc_lo, &acc_hi);
+  }
+  acc_lo = _mm_add_epi64(acc_lo, acc_hi);
+  *sum += _mm_extract_epi64(acc_lo, 0) + _mm_extract_epi64(acc_lo, 1);
+  return done;
+}
+
+// Broadcasts the input pair (input[0], input[1]) as the pmaddwd multiplier
+#define Q_SIMD_PAIR(first, second) \
+  ((Q31_T)(((uint32_t)(uint16_t)(first)) | (((uint32_t)(uint16_t)(second)) << 16)))
+
+TARGET_SSE41 static void q7xq15_conv_tap_sse41(const Q7_T* input,
+  const Q15_T* filter, ITER_T CF, ITER_T COut, Q31_T* acc) {
+  __m128i acc_lo = _mm_loadu_si128((const __m128i*)acc);
+  __m128i acc_hi = _mm_loadu_si128((const __m128i*)(acc + 4));
+  ITER_T c = 0;
+
+  for (; c + 1 < CF; c += 2) {
+    __m128i f0 = _mm_loadu_si128((const __m128i*)(filter + c * COut));
+    __m128i f1 = _mm_loadu_si128((const __m128i*)(filter + (c + 1) * COut));
+    __m128i x = _mm_set1_epi32(Q_SIMD_PAIR(input[c], input[c + 1]));
+    acc_lo = _mm_add_epi32(acc_lo, _mm_madd_epi16(_mm_unpacklo_epi16(f0, f1), x));
+    acc_hi = _mm_add_epi32(acc_hi, _mm_madd_epi16(_mm_unpackhi_epi16(f0, f1), x));
+  }
+  if (c < CF) {
+    __m128i f0 = _mm_loadu_si128((const __m128i*)(filter + c * COut));
+    __m128i x = _mm_set1_epi32(Q_SIMD_PAIR(input[c], 0));
+    acc_lo = _mm_add_epi32(acc_lo, _mm_madd_epi16(_mm_unpacklo_epi16(f0, _mm_setzero_si128()), x));
+    acc_hi = _mm_add_epi32(acc_hi, _mm_madd_epi16(_mm_unpackhi_epi16(f0, _mm_setzero_si128()), x));
+  }
+  _mm_storeu_si128((__m128i*)acc, acc_lo);
+  _mm_storeu_si128((__m128i*)(acc + 4), acc_hi);
+}
+
+TARGET_SSE41 static void q15_conv_tap_sse41(const Q15_T* input,
+  const Q15_T* filter, ITER_T CF, ITER_T COut, Q63_T* acc) {
+  __m128i acc0 = _mm_loadu_si128((const __m128i*)acc);
+  __m128i acc1 = _mm_loadu_si128((const __m128i*)(acc + 2));
+  __m128i acc2 = _mm_loadu_si128((const __m128i*)(acc + 4));
+  __m128i acc3 = _mm_loadu_si128((const __m128i*)(acc + 6));
+  ITER_T c = 0;
+
+  for (; c < CF; c += 2) {
+    __m128i f0 = _mm_loadu_si128((const __m128i*)(filter + c * COut));
+    __m128i f1 = _mm_setzero_si128();
+    Q15_T second = 0;
+    if (c + 1 < CF) {
+      f1 = _mm_loadu_si128((const __m128i*)(filter + (c + 1) * COut));
+      second = input[c + 1];
+    }
+    __m128i x = _mm_set1_epi32(Q_SIMD_PAIR(input[c], second));
+    add_q63_sse41(_mm_madd_epi16(_mm_unpacklo_epi16(f0, f1), x), &acc0, &acc1);
+    add_q63_sse41(_mm_madd_epi16(_mm_unpackhi_epi16(f0, f1), x), &acc2, &acc3);
+  }
+  _mm_storeu_si128((__m128i*)acc, acc0);
+  _mm_storeu_si128((__m128i*)(acc + 2), acc1);
+  _mm_storeu_si128((__m128i*)(acc + 4), acc2);
+  _mm_storeu_si128((__m128i*)(acc + 6), acc3);
+}
+
+TARGET_AVX2 static inline __m256i scale_avx2(__m256i x, __m256i mask,
+                                             __m128i count) {
+  #ifndef SHIFT
+    x = _mm256_add_epi32(x, _mm256_and_si256(_mm256_srai_epi32(x, 31), mask));
+  #endif
+  return _mm256_sra_epi32(x, count);
+}
+
+// The 256-bit unpack and pack instructions work within the 128-bit lanes, hence
+// unpacking and packing back the same registers keeps the order of the elements
+TARGET_AVX2 static inline __m256i pack_q15_avx2(__m256i lo, __m256i hi) {
+  lo = _mm256_srai_epi32(_mm256_slli_epi32(lo, 16), 16);
+  hi = _mm256_srai_epi32(_mm256_slli_epi32(hi, 16), 16);
+  return _mm256_packs_epi32(lo, hi);
+}
+
+TARGET_AVX2 static inline void add_q63_avx2(__m256i x, __m256i* acc_lo,
+                                            __m256i* acc_hi) {
+  __m256i overflow = _mm256_cmpeq_epi32(x, _mm256_set1_epi32((Q31_T)0x80000000));
+  *acc_lo = _mm256_add_epi64(*acc_lo, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(x)));
+  *acc_lo = _mm256_sub_epi64(*acc_lo, _mm256_slli_epi64(_mm256_cvtepi32_epi64(_mm256_castsi256_si128(overflow)), 32));
+  *acc_hi = _mm256_add_epi64(*acc_hi, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(x, 1)));
+  *acc_hi = _mm256_sub_epi64(*acc_hi, _mm256_slli_epi64(_mm256_cvtepi32_epi64(_mm256_extracti128_si256(overflow, 1)), 32));
+}
+
+TARGET_AVX2 static ITER_T q15_v_add_avx2(const Q15_T* vec1,
+  const Q15_T* vec2, ITER_T len, Q15_T* ret, const Q_Simd_Scale* scales) {
+  __m256i mask1 = _mm256_set1_epi32(scales[0].mask);
+  __m256i mask2 = _mm256_set1_epi32(scales[1].mask);
+  __m256i mask3 = _mm256_set1_epi32(scales[2].mask);
+  __m128i count1 = _mm_cvtsi32_si128(scales[0].count);
+  __m128i count2 = _mm_cvtsi32_si128(scales[1].count);
+  __m128i count3 = _mm_cvtsi32_si128(scales[2].count);
+  ITER_T done = len & ~15u;
+
+  for (ITER_T i = 0; i < done; i += 16) {
+    __m256i a = _mm256_loadu_si256((const __m256i*)(vec1 + i));
+    __m256i b = _mm256_loadu_si256((const __m256i*)(vec2 + i));
+    // Sign extension of the Q15 values to Q31 within the 128-bit lanes
+    __m256i a_lo = _mm256_srai_epi32(_mm256_unpacklo_epi16(a, a), 16);
+    __m256i a_hi = _mm256_srai_epi32(_mm256_unpackhi_epi16(a, a), 16);
+    __m256i b_lo = _mm256_srai_epi32(_mm256_unpacklo_epi16(b, b), 16);
+    __m256i b_hi = _mm256_srai_epi32(_mm256_unpackhi_epi16(b, b), 16);
+    __m256i lo = _mm256_add_epi32(scale_avx2(a_lo, mask1, count1), scale_avx2(b_lo, mask2, count2));
+    __m256i hi = _mm256_add_epi32(scale_avx2(a_hi, mask1, count1), scale_avx2(b_hi, mask2, count2));
+    lo = scale_avx2(lo, mask3, count3);
+    hi = scale_avx2(hi, mask3, count3);
+    _mm256_storeu_si256((__m256i*)(ret + i), pack_q15_avx2(lo, hi));
+  }
+  return done;
+}
+
+TARGET_AVX2 static ITER_T q15_v_hadamard_avx2(const Q15_T* vec1,
+  const Q15_T* vec2, ITER_T len, Q15_T* ret, const Q_Simd_Scale* scale) {
+  __m256i mask = _mm256_set1_epi32(scale->mask);
+  __m128i count = _mm_cvtsi32_si128(scale->count);
+  ITER_T done = len & ~15u;
+
+  for (ITER_T i = 0; i < done; i += 16) {
+    __m256i a = _mm256_loadu_si256((const __m256i*)(vec1 + i));
+    __m256i b = _mm256_loadu_si256((const __m256i*)(vec2 + i));
+    __m256i prod_lo = _mm256_mullo_epi16(a, b);
+    __m256i prod_hi = _mm256_mulhi_epi16(a, b);
+    __m256i lo = scale_avx2(_mm256_unpacklo_epi16(prod_lo, prod_hi), mask, count);
+    __m256i hi = scale_avx2(_mm256_unpackhi_epi16(prod_lo, prod_hi), mask, count);
+    _mm256_storeu_si256((__m256i*)(ret + i), pack_q15_avx2(lo, hi));
+  }
+  return done;
+}
+
+TARGET_AVX2 static ITER_T q15xq7_v_dot_avx2(const Q15_T* vec1,
+  const Q7_T* vec2, ITER_T len, Q31_T* sum) {
+  __m256i acc = _mm256_setzero_si256();
+  __m256i acc1 = _mm256_setzero_si256();
+  ITER_T done = len & ~15u;
+  ITER_T i = 0;
+
+  for (; i + 32 <= done; i += 32) {
+    __m256i a0 = _mm256_loadu_si256((const __m256i*)(vec1 + i));
+    __m256i a1 = _mm256_loadu_si256((const __m256i*)(vec1 + i + 16));
+    __m256i b0 = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(vec2 + i)));
+    __m256i b1 = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(vec2 + i + 16)));
+    acc = _mm256_add_epi32(acc, _mm256_madd_epi16(a0, b0));
+    acc1 = _mm256_add_epi32(acc1, _mm256_madd_epi16(a1, b1));
+  }
+  if (i < done) {
+    __m256i a = _mm256_loadu_si256((const __m256i*)(vec1 + i));
+    __m256i b = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(vec2 + i)));
+    acc = _mm256_add_epi32(acc, _mm256_madd_epi16(a, b));
+  }
+  acc = _mm256_add_epi32(acc, acc1);
+  __m128i res = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+  res = _mm_add_epi32(res, _mm_srli_si128(res, 8));
+  res = _mm_add_epi32(res, _mm_srli_si128(res, 4));
+  *sum = (Q31_T)((uint32_t)*sum + (uint32_t)_mm_cvtsi128_si32(res));
+  return done;
+}
+
+TARGET_AVX2 static ITER_T q15_v_dot_avx2(const Q15_T* vec1,
+  const Q15_T* vec2, ITER_T len, Q63_T* sum) {
+  __m256i acc_lo = _mm256_setzero_si256();
+  __m256i acc_hi = _mm256_setzero_si256();
+  ITER_T done = len & ~15u;
+
+  for (ITER_T i = 0; i < done; i += 16) {
+    __m256i a = _mm256_loadu_si256((const __m256i*)(vec1 + i));
+    __m256i b = _mm256_loadu_si256((const __m256i*)(vec2 + i));
+    add_q63_avx2(_mm256_madd_epi16(a, b), &acc_lo, &acc_hi);
+  }
+  acc_lo = _mm256_add_epi64(acc_lo, acc_hi);
+  __m128i res = _mm_add_epi64(_mm256_castsi256_si128(acc_lo), _mm256_extracti128_si256(acc_lo, 1));
+  *sum += _mm_extract_epi64(res, 0) + _mm_extract_epi64(res, 1);
+  return done;
+}
+
+// Four input channels per iteration: the channel pair (c, c + 1) is computed in
+// the lower 128-bit lane and the pair (c + 2, c + 3) in the upper one
+TARGET_AVX2 static void q7xq15_conv_tap_avx2(const Q7_T* input,
+  const Q15_T* filter, ITER_T CF, ITER_T COut, Q31_T* acc) {
+  __m256i acc_lo = _mm256_setzero_si256();
+  __m256i acc_hi = _mm256_setzero_si256();
+  ITER_T c = 0;
+
+  for (; c + 3 < CF; c += 4) {
+    __m128i f0 = _mm_loadu_si128((const __m128i*)(filter + c * COut));
+    __m128i f1 = _mm_loadu_si128((const __m128i*)(filter + (c + 1) * COut));
+    __m128i f2 = _mm_loadu_si128((const __m128i*)(filter + (c + 2) * COut));
+    __m128i f3 = _mm_loadu_si128((const __m128i*)(filter + (c + 3) * COut));
+    __m256i w_lo = _mm256_set_m128i(_mm_unpacklo_epi16(f2, f3), _mm_unpacklo_epi16(f0, f1));
+    __m256i w_hi = _mm256_set_m128i(_mm_unpackhi_epi16(f2, f3), _mm_unpackhi_epi16(f0, f1));
+    __m256i x = _mm256_set_m128i(_mm_set1_epi32(Q_SIMD_PAIR(input[c + 2], input[c + 3])),
+                                 _mm_set1_epi32(Q_SIMD_PAIR(input[c], input[c + 1])));
+    acc_lo = _mm256_add_epi32(acc_lo, _mm256_madd_epi16(w_lo, x));
+    acc_hi = _mm256_add_epi32(acc_hi, _mm256_madd_epi16(w_hi, x));
+  }
+  __m128i res_lo = _mm_add_epi32(_mm_loadu_si128((const __m128i*)acc),
+    _mm_add_epi32(_mm256_castsi256_si128(acc_lo), _mm256_extracti128_si256(acc_lo, 1)));
+  __m128i res_hi = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(acc + 4)),
+    _mm_add_epi32(_mm256_castsi256_si128(acc_hi), _mm256_extracti128_si256(acc_hi, 1)));
+  _mm_storeu_si128((__m128i*)acc, res_lo);
+  _mm_storeu_si128((__m128i*)(acc + 4), res_hi);
+  if (c < CF) {
+    q7xq15_conv_tap_sse41(input + c, filter + c * COut, CF - c, COut, acc);
+  }
+}
+
+TARGET_AVX2 static void q15_conv_tap_avx2(const Q15_T* input,
+  const Q15_T* filter, ITER_T CF, ITER_T COut, Q63_T* acc) {
+  __m256i acc_lo = _mm256_loadu_si256((const __m256i*)acc);
+  __m256i acc_hi = _mm256_loadu_si256((const __m256i*)(acc + 4));
+  ITER_T c = 0;
+
+  for (; c < CF; c += 2) {
+    __m128i f0 = _mm_loadu_si128((const __m128i*)(filter + c * COut));
+    __m128i f1 = _mm_setzero_si128();
+    Q15_T second = 0;
+    if (c + 1 < CF) {
+      f1 = _mm_loadu_si128((const __m128i*)(filter + (c + 1) * COut));
+      second = input[c + 1];
+    }
+    __m256i w = _mm256_set_m128i(_mm_unpackhi_epi16(f0, f1), _mm_unpacklo_epi16(f0, f1));
+    __m256i x = _mm256_set1_epi32(Q_SIMD_PAIR(input[c], second));
+    add_q63_avx2(_mm256_madd_epi16(w, x), &acc_lo, &acc_hi);
+  }
+  _mm256_storeu_si256((__m256i*)acc, acc_lo);
+  _mm256_storeu_si256((__m256i*)(acc + 4), acc_hi);
+}
+
+// Interpolates the table at 8 Q31 inputs. A 32-bit gather at the Q15 entry of
+// each input loads that entry in its low half and the next one in its high half
+TARGET_AVX2 static inline __m256i lut_avx2(__m256i w, const Q15_T* table,
+  __m128i shift, __m256i limit, __m256i offset, __m256i frac_mask,
+  __m256i round, int odd) {
+  __m256i v = _mm256_min_epi32(_mm256_abs_epi32(w), limit);
+  __m256i index = _mm256_add_epi32(_mm256_sra_epi32(v, shift),
+    _mm256_and_si256(_mm256_cmpgt_epi32(w, _mm256_setzero_si256()), offset));
+  __m256i pair = _mm256_i32gather_epi32((const int*)table, index, 2);
+  __m256i low = _mm256_srai_epi32(_mm256_slli_epi32(pair, 16), 16);
+  __m256i high = _mm256_srai_epi32(pair, 16);
+  __m256i frac = _mm256_and_si256(v, frac_mask);
+  __m256i y = _mm256_add_epi32(low, _mm256_sra_epi32(_mm256_add_epi32(
+    _mm256_mullo_epi32(_mm256_sub_epi32(high, low), frac), round), shift));
+  if (odd) {
+    __m256i negative = _mm256_cmpgt_epi32(_mm256_setzero_si256(), w);
+    y = _mm256_blendv_epi8(y, _mm256_sub_epi32(_mm256_setzero_si256(), y), negative);
+  }
+  return y;
+}
+
+TARGET_AVX2 static ITER_T q15_v_lut_avx2(const Q15_T* vec, ITER_T len,
+  Q15_T* ret, const Q15_T* table, SCALE_T shift, Q15_T limit, ITER_T offset,
+  int odd) {
+  __m128i count = _mm_cvtsi32_si128(shift);
+  __m256i limit_v = _mm256_set1_epi32(limit);
+  __m256i offset_v = _mm256_set1_epi32(offset);
+  __m256i frac_mask = _mm256_set1_epi32((1 << shift) - 1);
+  __m256i round = _mm256_set1_epi32(1 << (shift - 1));
+  ITER_T done = len & ~15u;
+
+  for (ITER_T i = 0; i < done; i += 16) {
+    __m256i a = _mm256_loadu_si256((const __m256i*)(vec + i));
+    // Sign extension of the Q15 values to Q31 within the 128-bit lanes
+    __m256i a_lo = _mm256_srai_epi32(_mm256_unpacklo_epi16(a, a), 16);
+    __m256i a_hi = _mm256_srai_epi32(_mm256_unpackhi_epi16(a, a), 16);
+    __m256i lo = lut_avx2(a_lo, table, count, limit_v, offset_v, frac_mask, round, odd);
+    __m256i hi = lut_avx2(a_hi, table, count, limit_v, offset_v, frac_mask, round, odd);
+    _mm256_storeu_si256((__m256i*)(ret + i), pack_q15_avx2(lo, hi));
+  }
+  return done;
+}
+
+#elif defined(__ARM_NEON)
+
+static inline int32x4_t scale_neon(int32x4_t x, int32x4_t mask,
+                                   int32x4_t neg_count) {
+  #ifndef SHIFT
+    x = vaddq_s32(x, vandq_s32(vshrq_n_s32(x, 31), mask));
+  #endif
+  // vshlq_s32 with a negative count is an arithmetic right shift
+  return vshlq_s32(x, neg_count);
+}
+
+static ITER_T q15_v_add_neon(const Q15_T* vec1, const Q15_T* vec2,
+  ITER_T len, Q15_T* ret, const Q_Simd_Scale* scales) {
+  int32x4_t mask1 = vdupq_n_s32(scales[0].mask);
+  int32x4_t mask2 = vdupq_n_s32(scales[1].mask);
+  int32x4_t mask3 = vdupq_n_s32(scales[2].mask);
+  int32x4_t count1 = vdupq_n_s32(-scales[0].count);
+  int32x4_t count2 = vdupq_n_s32(-scales[1].count);
+  int32x4_t count3 = vdupq_n_s32(-scales[2].count);
+  ITER_T done = len & ~7u;
+
+  for (ITER_T i = 0; i < done; i += 8) {
+    int16x8_t a = vld1q_s16(vec1 + i);
+    int16x8_t b = vld1q_s16(vec2 + i);
+    int32x4_t lo = vaddq_s32(scale_neon(vmovl_s16(vget_low_s16(a)), mask1, count1),
+                             scale_neon(vmovl_s16(vget_low_s16(b)), mask2, count2));
+    int32x4_t hi = vaddq_s32(scale_neon(vmovl_s16(vget_high_s16(a)), mask1, count1),
+                             scale_neon(vmovl_s16(vget_high_s16(b)), mask2, count2));
+    lo = scale_neon(lo, mask3, count3);
+    hi = scale_neon(hi, mask3, count3);
+    // vmovn truncates, same as the implicit conversion in C
+    vst1q_s16(ret + i, vcombine_s16(vmovn_s32(lo), vmovn_s32(hi)));
+  }
+  return done;
+}
+
+static ITER_T q15_v_hadamard_neon(const Q15_T* vec1, const Q15_T* vec2,
+  ITER_T len, Q15_T* ret, const Q_Simd_Scale* scale) {
+  int32x4_t mask = vdupq_n_s32(scale->mask);
+  int32x4_t count = vdupq_n_s32(-scale->count);
+  ITER_T done = len & ~7u;
+
+  for (ITER_T i = 0; i < done; i += 8) {
+    int16x8_t a = vld1q_s16(vec1 + i);
+    int16x8_t b = vld1q_s16(vec2 + i);
+    int32x4_t lo = scale_neon(vmull_s16(vget_low_s16(a), vget_low_s16(b)), mask, count);
+    int32x4_t hi = scale_neon(vmull_s16(vget_high_s16(a), vget_high_s16(b)), mask, count);
+    vst1q_s16(ret + i, vcombine_s16(vmovn_s32(lo), vmovn_s32(hi)));
+  }
+  return done;
+}
+
+static ITER_T q15xq7_v_dot_neon(const Q15_T* vec1, const Q7_T* vec2,
+  ITER_T len, Q31_T* sum) {
+  int32x4_t acc = vdupq_n_s32(0);
+  ITER_T done = len & ~7u;
+
+  for (ITER_T i = 0; i < done; i += 8) {
+    int16x8_t a = vld1q_s16(vec1 + i);
+    int16x8_t b = vmovl_s8(vld1_s8(vec2 + i));
+    acc = vmlal_s16(acc, vget_low_s16(a), vget_low_s16(b));
+    acc = vmlal_s16(acc, vget_high_s16(a), vget_high_s16(b));
+  }
+  uint32x4_t res = vreinterpretq_u32_s32(acc);
+  uint32_t total = vgetq_lane_u32(res, 0) + vgetq_lane_u32(res, 1) +
+                   vgetq_lane_u32(res, 2) + vgetq_lane_u32(res, 3);
+  *sum = (Q31_T)((uint32_t)*sum + total);
+  return done;
+}
+
+static ITER_T q15_v_dot_neon(const Q15_T* vec1, const Q15_T* vec2,
+  ITER_T len, Q63_T* sum) {
+  int64x2_t acc = vdupq_n_s64(0);
+  ITER_T done = len & ~7u;
+
+  for (ITER_T i = 0; i < done; i += 8) {
+    int16x8_t a = vld1q_s16(vec1 + i);
+    int16x8_t b = vld1q_s16(vec2 + i);
+    // The Q31 products are exact, their pairwise sums are widened to Q63
+    acc = vpadalq_s32(acc, vmull_s16(vget_low_s16(a), vget_low_s16(b)));
+    acc = vpadalq_s32(acc, vmull_s16(vget_high_s16(a), vget_high_s16(b)));
+  }
+  *sum += vgetq_lane_s64(acc, 0) + vgetq_lane_s64(acc, 1);
+  return done;
+}
+
+static void q7xq15_conv_tap_neon(const Q7_T* input, const Q15_T* filter,
+  ITER_T CF, ITER_T COut, Q31_T* acc) {
+  int32x4_t acc_lo = vld1q_s32(acc);
+  int32x4_t acc_hi = vld1q_s32(acc + 4);
+
+  for (ITER_T c = 0; c < CF; c++) {
+    int16x8_t f = vld1q_s16(filter + c * COut);
+    acc_lo = vmlal_n_s16(acc_lo, vget_low_s16(f), input[c]);
+    acc_hi = vmlal_n_s16(acc_hi, vget_high_s16(f), input[c]);
+  }
+  vst1q_s32(acc, acc_lo);
+  vst1q_s32(acc + 4, acc_hi);
+}
+
+static void q15_conv_tap_neon(const Q15_T* input, const Q15_T* filter,
+  ITER_T CF, ITER_T COut, Q63_T* acc) {
+  int64x2_t acc0 = vld1q_s64(acc);
+  int64x2_t acc1 = vld1q_s64(acc + 2);
+  int64x2_t acc2 = vld1q_s64(acc + 4);
+  int64x2_t acc3 = vld1q_s64(acc + 6);
+
+  for (ITER_T c = 0; c < CF; c++) {
+    int16x8_t f = vld1q_s16(filter + c * COut);
+    int32x4_t lo = vmull_n_s16(vget_low_s16(f), input[c]);
+    int32x4_t hi = vmull_n_s16(vget_high_s16(f), input[c]);
+    acc0 = vaddw_s32(acc0, vget_low_s32(lo));
+    acc1 = vaddw_s32(acc1, vget_high_s32(lo));
+    acc2 = vaddw_s32(acc2, vget_low_s32(hi));
+    acc3 = vaddw_s32(acc3, vget_high_s32(hi));
+  }
+  vst1q_s64(acc, acc0);
+  vst1q_s64(acc + 2, acc1);
+  vst1q_s64(acc + 4, acc2);
+  vst1q_s64(acc + 6, acc3);
+}
+
+#endif
+
+ITER_T q15_v_add_simd(const Q15_T* vec1, const Q15_T* vec2, ITER_T len,
+                      Q15_T* ret, SCALE_T scale1, SCALE_T scale2,
+                      SCALE_T demote) {
+  Q_Simd_Scale scales[3];
+  if (len < Q_SIMD_MIN_LEN) {
+    return 0;
+  }
+  if (!to_simd_scale(scale1, &scales[0]) || !to_simd_scale(scale2, &scales[1]) ||
+      !to_simd_scale(demote, &scales[2])) {
+    return 0;
+  }
+
+  switch (q_simd_level()) {
+    #if defined(Q_SIMD_X86)
+      case Q_SIMD_AVX2:
+        return q15_v_add_avx2(vec1, vec2, len, ret, scales);
+      case Q_SIMD_SSE41:
+        return q15_v_add_sse41(vec1, vec2, len, ret, scales);
+    #elif defined(__ARM_NEON)
+      case Q_SIMD_NEON:
+        return q15_v_add_neon(vec1, vec2, len, ret, scales);
+    #endif
+    default:
+      return 0;
+  }
+}
+
+ITER_T q15_v_hadamard_simd(const Q15_T* vec1, const Q15_T* vec2, ITER_T len,
+                           Q15_T* ret, SCALE_T scale) {
+  Q_Simd_Scale scale_shift;
+  if (len < Q_SIMD_MIN_LEN) {
+    return 0;
+  }
+  if (!to_simd_scale(scale, &scale_shift)) {
+    return 0;
+  }
+
+  switch (q_simd_level()) {
+    #if defined(Q_SIMD_X86)
+      case Q_SIMD_AVX2:
+        return q15_v_hadamard_avx2(vec1, vec2, len, ret, &scale_shift);
+      case Q_SIMD_SSE41:
+        return q15_v_hadamard_sse41(vec1, vec2, len, ret, &scale_shift);
+    #elif defined(__ARM_NEON)
+      case Q_SIMD_NEON:
+        return q15_v_hadamard_neon(vec1, vec2, len, ret, &scale_shift);
+    #endif
+    default:
+      return 0;
+  }
+}
+
+ITER_T q15xq7_v_dot_simd(const Q15_T* vec1, const Q7_T* vec2, ITER_T len,
+                         Q31_T* sum) {
+  if (len < Q_SIMD_MIN_LEN) {
+    return 0;
+  }
+  switch (q_simd_level()) {
+    #if defined(Q_SIMD_X86)
+      case Q_SIMD_AVX2:
+        return q15xq7_v_dot_avx2(vec1, vec2, len, sum);
+      case Q_SIMD_SSE41:
+        return q15xq7_v_dot_sse41(vec1, vec2, len, sum);
+    #elif defined(__ARM_NEON)
+      case Q_SIMD_NEON:
+        return q15xq7_v_dot_neon(vec1, vec2, len, sum);
+    #endif
+    default:
+      return 0;
+  }
+}
+
+ITER_T q15_v_dot_simd(const Q15_T* vec1, const Q15_T* vec2, ITER_T len,
+                      Q63_T* sum) {
+  if (len < Q_SIMD_MIN_LEN) {
+    return 0;
+  }
+  switch (q_simd_level()) {
+    #if defined(Q_SIMD_X86)
+      case Q_SIMD_AVX2:
+        return q15_v_dot_avx2(vec1, vec2, len, sum);
+      case Q_SIMD_SSE41:
+        return q15_v_dot_sse41(vec1, vec2, len, sum);
+    #elif defined(__ARM_NEON)
+      case Q_SIMD_NEON:
+        return q15_v_dot_neon(vec1, vec2, len, sum);
+    #endif
+    default:
+      return 0;
+  }
+}
+
+ITER_T q15_v_lut_simd(const Q15_T* vec, ITER_T len, Q15_T* ret,
+                      const Q15_T* table, SCALE_T shift, Q15_T limit,
+                      ITER_T offset, int odd) {
+  if (len < Q_SIMD_MIN_LEN) {
+    return 0;
+  }
+  // Only AVX2 has gathers
+  switch (q_simd_level()) {
+    #if defined(Q_SIMD_X86)
+      case Q_SIMD_AVX2:
+        return q15_v_lut_avx2(vec, len, ret, table, shift, limit, offset, odd);
+    #endif
+    default:
+      return 0;
+  }
+}
+
+void q7xq15_conv_tap_simd(const Q7_T* input, const Q15_T* filter, ITER_T CF,
+                          ITER_T COut, Q31_T* acc) {
+  switch (q_simd_level()) {
+    #if defined(Q_SIMD_X86)
+      case Q_SIMD_AVX2:
+        q7xq15_conv_tap_avx2(input, filter, CF, COut, acc);
+        return;
+      case Q_SIMD_SSE41:
+        q7xq15_conv_tap_sse41(input, filter, CF, COut, acc);
+        return;
+    #elif defined(__ARM_NEON)
+      case Q_SIMD_NEON:
+        q7xq15_conv_tap_neon(input, filter, CF, COut, acc);
+        return;
+    #endif
+    default:
+      for (ITER_T c = 0; c < CF; c++) {
+        for (ITER_T j = 0; j < Q_SIMD_CONV_BLOCK; j++) {
+          acc[j] += ((Q31_T)input[c]) * ((Q31_T)filter[c * COut + j]);
+        }
+      }
+  }
+}
+
+void q15_conv_tap_simd(const Q15_T* input, const Q15_T* filter, ITER_T CF,
+                       ITER_T COut, Q63_T* acc) {
+  switch (q_simd_level()) {
+    #if defined(Q_SIMD_X86)
+      case Q_SIMD_AVX2:
+        q15_conv_tap_avx2(input, filter, CF, COut, acc);
+        return;
+      case Q_SIMD_SSE41:
+        q15_conv_tap_sse41(input, filter, CF, COut, acc);
+        return;
+    #elif defined(__ARM_NEON)
+      case Q_SIMD_NEON:
+        q15_conv_tap_neon(input, filter, CF, COut, acc);
+        return;
+    #endif
+    default:
+      for (ITER_T c = 0; c < CF; c++) {
+        for (ITER_T j = 0; j < Q_SIMD_CONV_BLOCK; j++) {
+          acc[j] += ((Q31_T)input[c]) * ((Q31_T)filter[c * COut + j]);
+        }
+      }
+  }
+}
@@ -0,0 +1,337 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include "quantized_sparse_conv.h"
+
+// Offsets of the taps from the centre of the receptive field, in rows and columns of the input
+static void sparse_filter_taps(const Q15_Sparse_Filter* const filter,
+  ITER_T HDilation, ITER_T WDilation, S_ITER_T* const tap_h,
+  S_ITER_T* const tap_w) {
+  S_ITER_T HOffsetFL = ((filter->HF - 1) >> 1);
+  S_ITER_T WOffsetFL = ((filter->WF - 1) >> 1);
+  for (ITER_T t = 0; t < filter->HF * filter->WF; t++) {
+    tap_h[t] = (S_ITER_T)HDilation * ((S_ITER_T)(t / filter->WF) - HOffsetFL);
+    tap_w[t] = (S_ITER_T)WDilation * ((S_ITER_T)(t % filter->WF) - WOffsetFL);
+  }
+}
+
+// Index of the input pixel under each tap of the receptive field centred on (h, w), -1 for the taps in the padding
+static void sparse_filter_pixels(ITER_T ntaps, const S_ITER_T* const tap_h,
+  const S_ITER_T* const tap_w, S_ITER_T h, S_ITER_T w, ITER_T H, ITER_T W,
+  ITER_T CIn, ITER_T NIndexIn, S_ITER_T* const pixel) {
+  for (ITER_T t = 0; t < ntaps; t++) {
+    S_ITER_T hoffset = h + tap_h[t];
+    S_ITER_T woffset = w + tap_w[t];
+    if ((hoffset < 0) || (hoffset >= (S_ITER_T)H) ||
+        (woffset < 0) || (woffset >= (S_ITER_T)W)) {
+      pixel[t] = -1;
+    } else {
+      pixel[t] = (S_ITER_T)((((ITER_T)hoffset) * W + (ITER_T)woffset) * CIn + NIndexIn);
+    }
+  }
+}
+
+int q15_sparse_filter_pack(const Q15_T* const filter, ITER_T HF, ITER_T WF,
+  ITER_T CF, ITER_T COut, ITER_T G, ITER_T* const row_ptr,
+  ITER_T* const col_idx, Q15_T* const values, ITER_T max_nnz,
+  Q15_Sparse_Filter* const packed) {
+  ITER_T ntaps = HF * WF;
+  ITER_T size = G * ntaps * CF * COut;
+  packed->dense = filter;
+  packed->row_ptr = 0;
+  packed->col_idx = 0;
+  packed->values = 0;
+  packed->HF = HF;
+  packed->WF = WF;
+  packed->CF = CF;
+  packed->COut = COut;
+  packed->G = G;
+  packed->nnz = 0;
+  if (ntaps == 0 || ntaps > Q_SPARSE_FILTER_MAX_TAPS ||
+      CF > Q_SPARSE_FILTER_CHANNEL_MASK + 1) {
+    return ERR_SPARSE_FILTER_INVALID_PARAMS;
+  }
+
+  for (ITER_T i = 0; i < size; i++) {
+    if (filter[i] != 0) {
+      packed->nnz++;
+    }
+  }
+  if ((Q63_T)packed->nnz * 100 >= (Q63_T)size * Q_SPARSE_FILTER_DENSITY_THRESHOLD) {
+    return 0;
+  }
+  if (packed->nnz > max_nnz) {
+    return ERR_SPARSE_FILTER_FULL;
+  }
+
+  // One row per output channel, its weights in the order of the taps and of the input channels
+  ITER_T GOffsetF = ntaps * CF * COut;
+  ITER_T nnz = 0;
+  for (ITER_T g = 0; g < G; g++) {
+    for (ITER_T c = 0; c < COut; c++) {
+      row_ptr[g * COut + c] = nnz;
+      const Q15_T* filter_offset = filter + g * GOffsetF + c;
+      for (ITER_T t = 0; t < ntaps; t++) {
+        for (ITER_T cf = 0; cf < CF; cf++) {
+          if (*filter_offset != 0) {
+            col_idx[nnz] = (t << Q_SPARSE_FILTER_TAP_SHIFT) | cf;
+            values[nnz++] = *filter_offset;
+          }
+          filter_offset += COut;
+        }
+      }
+    }
+  }
+  row_ptr[G * COut] = nnz;
+
+  packed->row_ptr = row_ptr;
+  packed->col_idx = col_idx;
+  packed->values = values;
+  return 0;
+}
+
+int q15_sparse_filter_write(FILE* file, const char* name,
+  const char* dense_name, const Q15_Sparse_Filter* const packed) {
+  if (packed->row_ptr) {
+    ITER_T rows = packed->G * packed->COut;
+    fprintf(file, "static const ITER_T %s_row_ptr[%u] = {", name, rows + 1);
+    for (ITER_T i = 0; i <= rows; i++) {
+      fprintf(file, i ? ", %u" : "%u", packed->row_ptr[i]);
+    }
+    fprintf(file, "};\n");
+    if (packed->nnz) {
+      fprintf(file, "static const ITER_T %s_col_idx[%u] = {", name, packed->nnz);
+      for (ITER_T i = 0; i < packed->nnz; i++) {
+        fprintf(file, i ? ", %u" : "%u", packed->col_idx[i]);
+      }
+      fprintf(file, "};\nstatic const Q15_T %s_values[%u] = {", name, packed->nnz);
+      for (ITER_T i = 0; i < packed->nnz; i++) {
+        fprintf(file, i ? ", %d" : "%d", packed->values[i]);
+      }
+      fprintf(file, "};\n");
+      fprintf(file, "static const Q15_Sparse_Filter %s = {%s, %s_row_ptr, %s_col_idx, %s_values, ",
+              name, dense_name, name, name, name);
+    } else {
+      fprintf(file, "static const Q15_Sparse_Filter %s = {%s, %s_row_ptr, 0, 0, ",
+              name, dense_name, name);
+    }
+  } else {
+    fprintf(file, "static const Q15_Sparse_Filter %s = {%s, 0, 0, 0, ", name, dense_name);
+  }
+  fprintf(file, "%u, %u, %u, %u, %u, %u};\n", packed->HF, packed->WF,
+          packed->CF, packed->COut, packed->G, packed->nnz);
+  return ferror(file) ? ERR_SPARSE_FILTER_INVALID_PARAMS : 0;
+}
+
+void q7xq15_q7_sparse_convolution(const Q7_T* const input,
+  const Q15_Sparse_Filter* const filter, Q7_T* const output, ITER_T N,
+  ITER_T H, ITER_T W, ITER_T CIn, ITER_T HOut, ITER_T WOut, S_ITER_T HPadU,
+  S_ITER_T HPadD, S_ITER_T WPadL, S_ITER_T WPadR, ITER_T HStride,
+  ITER_T WStride, ITER_T HDilation, ITER_T WDilation, SCALE_T scinput,
+  SCALE_T scoutput, SCALE_T demote) {
+  if (filter->row_ptr == 0) {
+    q7xq15_q7_convolution(input, filter->dense, output, N, H, W, CIn,
+      filter->HF, filter->WF, filter->CF, filter->COut, HOut, WOut, filter->G,
+      HPadU, HPadD, WPadL, WPadR, HStride, WStride, HDilation, WDilation,
+      scinput, scoutput, demote);
+    return;
+  }
+
+  S_ITER_T HOffsetL = ((S_ITER_T)HDilation * (S_ITER_T)((filter->HF - 1) >> 1)) - HPadU;
+  S_ITER_T WOffsetL = ((S_ITER_T)WDilation * (S_ITER_T)((filter->WF - 1) >> 1)) - WPadL;
+  S_ITER_T HOffsetR = ((S_ITER_T)HDilation * (S_ITER_T)(filter->HF >> 1)) - HPadD;
+  S_ITER_T WOffsetR = ((S_ITER_T)WDilation * (S_ITER_T)(filter->WF >> 1)) - WPadR;
+
+  ITER_T ntaps = filter->HF * filter->WF;
+  ITER_T NOffsetIn = H * W * CIn;
+  ITER_T WOffsetOut = filter->G * filter->COut;
+  ITER_T HOffsetOut = WOut * WOffsetOut;
+  ITER_T NOffsetOut = HOut * HOffsetOut;
+  S_ITER_T tap_h[Q_SPARSE_FILTER_MAX_TAPS], tap_w[Q_SPARSE_FILTER_MAX_TAPS];
+  S_ITER_T pixel[Q_SPARSE_FILTER_MAX_TAPS];
+  sparse_filter_taps(filter, HDilation, WDilation, tap_h, tap_w);
+
+  Q31_T sum;
+  #ifdef SHIFT
+    SCALE_T scale = scinput + scoutput + demote;
+  #else
+    SCALE_T scale = scinput * scoutput * demote;
+  #endif
+  for (ITER_T n = 0; n < N; n++) {
+    ITER_T hout = 0;
+    ITER_T NIndexIn = n * NOffsetIn;
+    ITER_T NIndexOut = n * NOffsetOut;
+    for (S_ITER_T h = HOffsetL; h < (S_ITER_T)H - HOffsetR; h += (S_ITER_T)HStride, hout++) {
+      ITER_T wout = 0;
+      ITER_T HIndexOut = hout * HOffsetOut + NIndexOut;
+      for (S_ITER_T w = WOffsetL; w < (S_ITER_T)W - WOffsetR; w += (S_ITER_T)WStride, wout++) {
+        sparse_filter_pixels(ntaps, tap_h, tap_w, h, w, H, W, CIn, NIndexIn, pixel);
+        Q7_T* output_offset = ((Q7_T*)output) + wout * WOffsetOut + HIndexOut;
+        const ITER_T* row_ptr = filter->row_ptr;
+        for (ITER_T g = 0; g < filter->G; g++) {
+          const Q7_T* input_offset = input + g * filter->CF;
+          for (ITER_T c = 0; c < filter->COut; c++, row_ptr++) {
+            sum = 0;
+            for (ITER_T e = row_ptr[0]; e < row_ptr[1]; e++) {
+              ITER_T col = filter->col_idx[e];
+              S_ITER_T p = pixel[col >> Q_SPARSE_FILTER_TAP_SHIFT];
+              if (p < 0) {
+                continue;
+              }
+              sum += ((Q31_T)input_offset[p + (col & Q_SPARSE_FILTER_CHANNEL_MASK)]) *
+                     ((Q31_T)filter->values[e]);
+            }
+
+            #ifdef SHIFT
+              *output_offset++ = (sum >> scale);
+            #else
+              *output_offset++ = (sum / scale);
+            #endif
+          }
+        }
+      }
+    }
+  }
+}
+
+void q7xq15_q15_sparse_convolution(const Q7_T* const input,
+  const Q15_Sparse_Filter* const filter, Q15_T* const output, ITER_T N,
+  ITER_T H, ITER_T W, ITER_T CIn, ITER_T HOut, ITER_T WOut, S_ITER_T HPadU,
+  S_ITER_T HPadD, S_ITER_T WPadL, S_ITER_T WPadR, ITER_T HStride,
+  ITER_T WStride, ITER_T HDilation, ITER_T WDilation, SCALE_T scinput,
+  SCALE_T scoutput, SCALE_T demote) {
+  if (filter->row_ptr == 0) {
+    q7xq15_q15_convolution(input, filter->dense, output, N, H, W, CIn,
+      filter->HF, filter->WF, filter->CF, filter->COut, HOut, WOut, filter->G,
+      HPadU, HPadD, WPadL, WPadR, HStride, WStride, HDilation, WDilation,
+      scinput, scoutput, demote);
+    return;
+  }
+
+  S_ITER_T HOffsetL = ((S_ITER_T)HDilation * (S_ITER_T)((filter->HF - 1) >> 1)) - HPadU;
+  S_ITER_T WOffsetL = ((S_ITER_T)WDilation * (S_ITER_T)((filter->WF - 1) >> 1)) - WPadL;
+  S_ITER_T HOffsetR = ((S_ITER_T)HDilation * (S_ITER_T)(filter->HF >> 1)) - HPadD;
+  S_ITER_T WOffsetR = ((S_ITER_T)WDilation * (S_ITER_T)(filter->WF >> 1)) - WPadR;
+
+  ITER_T ntaps = filter->HF * filter->WF;
+  ITER_T NOffsetIn = H * W * CIn;
+  ITER_T WOffsetOut = filter->G * filter->COut;
+  ITER_T HOffsetOut = WOut * WOffsetOut;
+  ITER_T NOffsetOut = HOut * HOffsetOut;
+  S_ITER_T tap_h[Q_SPARSE_FILTER_MAX_TAPS], tap_w[Q_SPARSE_FILTER_MAX_TAPS];
+  S_ITER_T pixel[Q_SPARSE_FILTER_MAX_TAPS];
+  sparse_filter_taps(filter, HDilation, WDilation, tap_h, tap_w);
+
+  Q31_T sum;
+  #ifdef SHIFT
+    SCALE_T scale = scinput + scoutput + demote;
+  #else
+    SCALE_T scale = scinput * scoutput * demote;
+  #endif
+  for (ITER_T n = 0; n < N; n++) {
+    ITER_T hout = 0;
+    ITER_T NIndexIn = n * NOffsetIn;
+    ITER_T NIndexOut = n * NOffsetOut;
+    for (S_ITER_T h = HOffsetL; h < (S_ITER_T)H - HOffsetR; h += (S_ITER_T)HStride, hout++) {
+      ITER_T wout = 0;
+      ITER_T HIndexOut = hout * HOffsetOut + NIndexOut;
+      for (S_ITER_T w = WOffsetL; w < (S_ITER_T)W - WOffsetR; w += (S_ITER_T)WStride, wout++) {
+        sparse_filter_pixels(ntaps, tap_h, tap_w, h, w, H, W, CIn, NIndexIn, pixel);
+        Q15_T* output_offset = ((Q15_T*)output) + wout * WOffsetOut + HIndexOut;
+        const ITER_T* row_ptr = filter->row_ptr;
+        for (ITER_T g = 0; g < filter->G; g++) {
+          const Q7_T* input_offset = input + g * filter->CF;
+          for (ITER_T c = 0; c < filter->COut; c++, row_ptr++) {
+            sum = 0;
+            for (ITER_T e = row_ptr[0]; e < row_ptr[1]; e++) {
+              ITER_T col = filter->col_idx[e];
+              S_ITER_T p = pixel[col >> Q_SPARSE_FILTER_TAP_SHIFT];
+              if (p < 0) {
+                continue;
+              }
+              sum += ((Q31_T)input_offset[p + (col & Q_SPARSE_FILTER_CHANNEL_MASK)]) *
+                     ((Q31_T)filter->values[e]);
+            }
+
+            #ifdef SHIFT
+              *output_offset++ = (sum >> scale);
+            #else
+              *output_offset++ = (sum / scale);
+            #endif
+          }
+        }
+      }
+    }
+  }
+}
+
+void q15_sparse_convolution(const Q15_T* const input,
+  const Q15_Sparse_Filter* const filter, Q15_T* const output, ITER_T N,
+  ITER_T H, ITER_T W, ITER_T CIn, ITER_T HOut, ITER_T WOut, S_ITER_T HPadU,
+  S_ITER_T HPadD, S_ITER_T WPadL, S_ITER_T WPadR, ITER_T HStride,
+  ITER_T WStride, ITER_T HDilation, ITER_T WDilation, SCALE_T scinput,
+  SCALE_T scoutput, SCALE_T demote) {
+  if (filter->row_ptr == 0) {
+    q15_convolution(input, filter->dense, output, N, H, W, CIn, filter->HF,
+      filter->WF, filter->CF, filter->COut, HOut, WOut, filter->G, HPadU,
+      HPadD, WPadL, WPadR, HStride, WStride, HDilation, WDilation, scinput,
+      scoutput, demote);
+    return;
+  }
+
+  S_ITER_T HOffsetL = ((S_ITER_T)HDilation * (S_ITER_T)((filter->HF - 1) >> 1)) - HPadU;
+  S_ITER_T WOffsetL = ((S_ITER_T)WDilation * (S_ITER_T)((filter->WF - 1) >> 1)) - WPadL;
+  S_ITER_T HOffsetR = ((S_ITER_T)HDilation * (S_ITER_T)(filter->HF >> 1)) - HPadD;
+  S_ITER_T WOffsetR = ((S_ITER_T)WDilation * (S_ITER_T)(filter->WF >> 1)) - WPadR;
+
+  ITER_T ntaps = filter->HF * filter->WF;
+  ITER_T NOffsetIn = H * W * CIn;
+  ITER_T WOffsetOut = filter->G * filter->COut;
+  ITER_T HOffsetOut = WOut * WOffsetOut;
+  ITER_T NOffsetOut = HOut * HOffsetOut;
+  S_ITER_T tap_h[Q_SPARSE_FILTER_MAX_TAPS], tap_w[Q_SPARSE_FILTER_MAX_TAPS];
+  S_ITER_T pixel[Q_SPARSE_FILTER_MAX_TAPS];
+  sparse_filter_taps(filter, HDilation, WDilation, tap_h, tap_w);
+
+  Q63_T sum;
+  #ifdef SHIFT
+    SCALE_T scale = scinput + scoutput + demote;
+  #else
+    SCALE_T scale = scinput * scoutput * demote;
+  #endif
+  for (ITER_T n = 0; n < N; n++) {
+    ITER_T hout = 0;
+    ITER_T NIndexIn = n * NOffsetIn;
+    ITER_T NIndexOut = n * NOffsetOut;
+    for (S_ITER_T h = HOffsetL; h < (S_ITER_T)H - HOffsetR; h += (S_ITER_T)HStride, hout++) {
+      ITER_T wout = 0;
+      ITER_T HIndexOut = hout * HOffsetOut + NIndexOut;
+      for (S_ITER_T w = WOffsetL; w < (S_ITER_T)W - WOffsetR; w += (S_ITER_T)WStride, wout++) {
+        sparse_filter_pixels(ntaps, tap_h, tap_w, h, w, H, W, CIn, NIndexIn, pixel);
+        Q15_T* output_offset = ((Q15_T*)output) + wout * WOffsetOut + HIndexOut;
+        const ITER_T* row_ptr = filter->row_ptr;
+        for (ITER_T g = 0; g < filter->G; g++) {
+          const Q15_T* input_offset = input + g * filter->CF;
+          for (ITER_T c = 0; c < filter->COut; c++, row_ptr++) {
+            sum = 0;
+            for (ITER_T e = row_ptr[0]; e < row_ptr[1]; e++) {
+              ITER_T col = filter->col_idx[e];
+              S_ITER_T p = pixel[col >> Q_SPARSE_FILTER_TAP_SHIFT];
+              if (p < 0) {
+                continue;
+              }
+              sum += ((Q31_T)input_offset[p + (col & Q_SPARSE_FILTER_CHANNEL_MASK)]) *
+                     ((Q31_T)filter->values[e]);
+            }
+
+            #ifdef SHIFT
+              *output_offset++ = (sum >> scale);
+            #else
+              *output_offset++ = (sum / scale);
+            #endif
+          }
+        }
+      }
+    }
+  }
+}
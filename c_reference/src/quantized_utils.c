@@ -4,6 +4,9 @@
 #include <stddef.h>
 #include <string.h>
 #include "quantized_utils.h"
+#ifdef SIMD
+  #include "quantized_simd.h"
+#endif
 
 void q15_v_add(const Q15_T* vec1, const Q15_T* vec2, ITER_T len, Q15_T* ret,
                SCALE_T scvec1, SCALE_T scvec2, SCALE_T scret, SCALE_T demote) {
@@ -15,6 +18,14 @@ void q15_v_add(const Q15_T* vec1, const Q15_T* vec2, ITER_T len, Q15_T* ret,
     SCALE_T scalevec2 = scvec2 * scret;
   #endif
 
+  #ifdef SIMD
+    ITER_T done = q15_v_add_simd(vec1, vec2, len, ret, scalevec1, scalevec2, demote);
+    vec1 += done;
+    vec2 += done;
+    ret += done;
+    len -= done;
+  #endif
+
   #ifdef LOOP_UNROLL
     ITER_T len_unroll = len >> 2;
     len = len % 4;
@@ -160,6 +171,14 @@ void q15_v_hadamard(const Q15_T* vec1, const Q15_T* vec2, ITER_T len,
     SCALE_T scalevec = scvec1 * scvec2;
   #endif
 
+  #ifdef SIMD
+    ITER_T done = q15_v_hadamard_simd(vec1, vec2, len, ret, scalevec);
+    vec1 += done;
+    vec2 += done;
+    ret += done;
+    len -= done;
+  #endif
+
   #ifdef LOOP_UNROLL
     ITER_T len_unroll = len >> 2;
     len = len % 4;
@@ -187,10 +206,146 @@ void q15_v_hadamard(const Q15_T* vec1, const Q15_T* vec2, ITER_T len,
   }
 }
 
+// Interpolated tables of the exp_base_16() Sigmoid and TanH (use_tables = Q_ACTIVATION_EXP_TABLES), sampled every
+// 2^Q15_SIGMOID_LUT_SHIFT (resp. 2^Q15_TANH_LUT_SHIFT) inputs. The Sigmoid has one table for the inputs <= 0 and one for
+// the inputs > 0, since the exp_base_16() formula jumps at 0. The TanH is odd and saturates before 2^14.
+#define Q15_SIGMOID_LUT_SHIFT 6
+#define Q15_SIGMOID_LUT_SIZE ((1 << (15 - Q15_SIGMOID_LUT_SHIFT)) + 1)
+#define Q15_TANH_LUT_SHIFT 5
+#define Q15_TANH_LUT_SIZE ((1 << (14 - Q15_TANH_LUT_SHIFT)) + 1)
+
+static const Q15_T q15_sigmoid_lut[2 * Q15_SIGMOID_LUT_SIZE] = {
+  8192, 8064, 7935, 7808, 7680, 7553, 7426, 7299, 7173, 7047, 6922, 6797, 6673, 6550, 6427, 6306, 6185, 6065, 5946,
+  5828, 5712, 5596, 5481, 5368, 5256, 5144, 5035, 4927, 4820, 4714, 4610, 4507, 4406, 4305, 4207, 4110, 4015, 3921,
+  3829, 3738, 3648, 3560, 3474, 3389, 3306, 3224, 3144, 3066, 2989, 2913, 2838, 2766, 2695, 2625, 2557, 2490, 2425,
+  2361, 2299, 2237, 2178, 2119, 2062, 2006, 1952, 1899, 1848, 1796, 1748, 1699, 1652, 1606, 1562, 1517, 1475, 1434,
+  1394, 1354, 1316, 1278, 1242, 1207, 1172, 1138, 1106, 1074, 1043, 1013, 984, 954, 928, 900, 874, 848, 824, 799, 777,
+  753, 731, 709, 689, 668, 649, 629, 611, 592, 576, 558, 542, 525, 510, 494, 480, 465, 452, 437, 425, 412, 399, 387,
+  376, 364, 354, 342, 333, 322, 312, 303, 294, 284, 277, 268, 260, 252, 245, 237, 230, 222, 217, 210, 203, 196, 191,
+  185, 180, 174, 169, 163, 159, 154, 149, 144, 140, 135, 131, 127, 124, 120, 117, 113, 109, 105, 103, 99, 96, 93, 91,
+  88, 85, 82, 80, 77, 75, 72, 70, 67, 66, 63, 62, 60, 58, 56, 55, 53, 51, 49, 48, 46, 45, 43, 42, 40, 40, 38, 37, 35,
+  35, 33, 33, 31, 31, 30, 29, 28, 27, 26, 25, 24, 24, 23, 22, 21, 21, 20, 19, 18, 18, 17, 17, 16, 16, 15, 15, 14, 14,
+  13, 13, 12, 12, 11, 11, 10, 11, 10, 10, 9, 9, 8, 9, 8, 8, 7, 8, 7, 7, 6, 7, 6, 6, 5, 6, 5, 5, 4, 5, 4, 4, 3, 4, 3, 4,
+  3, 4, 3, 3, 2, 3, 2, 3, 2, 3, 2, 2, 1, 2, 1, 2, 1, 2, 1, 2, 1, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 8177, 8304, 8432, 8560, 8687, 8814, 8941, 9067, 9193, 9319,
+  9444, 9568, 9692, 9815, 9937, 10059, 10179, 10299, 10418, 10536, 10652, 10767, 10882, 10995, 11107, 11218, 11327,
+  11435, 11542, 11648, 11751, 11854, 11955, 12055, 12153, 12251, 12345, 12439, 12531, 12622, 12712, 12800, 12885,
+  12970, 13053, 13135, 13214, 13293, 13370, 13446, 13520, 13592, 13663, 13733, 13800, 13868, 13932, 13996, 14058,
+  14120, 14179, 14237, 14294, 14350, 14404, 14458, 14509, 14560, 14609, 14657, 14704, 14750, 14794, 14838, 14880,
+  14922, 14962, 15001, 15039, 15077, 15113, 15149, 15183, 15217, 15249, 15281, 15311, 15342, 15371, 15400, 15427,
+  15455, 15480, 15506, 15531, 15555, 15578, 15601, 15623, 15645, 15665, 15686, 15705, 15725, 15743, 15762, 15779,
+  15796, 15812, 15829, 15844, 15860, 15874, 15889, 15902, 15916, 15929, 15942, 15954, 15967, 15978, 15989, 16000,
+  16011, 16021, 16032, 16041, 16051, 16059, 16069, 16077, 16085, 16093, 16102, 16109, 16116, 16123, 16131, 16137,
+  16144, 16150, 16157, 16162, 16168, 16174, 16180, 16185, 16190, 16194, 16199, 16204, 16209, 16213, 16218, 16222,
+  16227, 16230, 16234, 16237, 16240, 16244, 16248, 16250, 16254, 16257, 16260, 16262, 16265, 16268, 16271, 16273,
+  16276, 16278, 16281, 16283, 16286, 16287, 16290, 16291, 16293, 16295, 16297, 16298, 16300, 16302, 16304, 16305,
+  16307, 16308, 16310, 16311, 16313, 16313, 16315, 16316, 16318, 16318, 16320, 16320, 16322, 16322, 16323, 16324,
+  16325, 16326, 16327, 16328, 16329, 16329, 16330, 16331, 16332, 16332, 16333, 16334, 16335, 16335, 16336, 16336,
+  16337, 16337, 16338, 16338, 16339, 16339, 16340, 16340, 16341, 16341, 16342, 16342, 16343, 16342, 16343, 16343,
+  16344, 16344, 16345, 16344, 16345, 16345, 16346, 16345, 16346, 16346, 16347, 16346, 16347, 16347, 16348, 16347,
+  16348, 16348, 16349, 16348, 16349, 16349, 16350, 16349, 16350, 16349, 16350, 16349, 16350, 16350, 16351, 16350,
+  16351, 16350, 16351, 16350, 16351, 16351, 16352, 16351, 16352, 16351, 16352, 16351, 16352, 16351, 16352, 16352,
+  16353, 16352, 16353, 16352, 16353, 16352, 16353, 16352, 16353, 16352, 16353, 16352, 16353, 16352, 16353, 16353,
+  16354, 16353, 16354, 16353, 16354, 16353, 16354, 16353, 16354, 16353, 16354, 16353, 16354, 16353, 16354, 16353,
+  16354, 16353, 16354, 16353, 16354, 16353, 16354, 16353, 16354, 16353, 16354, 16353, 16354, 16353, 16354, 16353,
+  16354, 16353, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354,
+  16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354,
+  16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354,
+  16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354,
+  16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354,
+  16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354,
+  16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354,
+  16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354,
+  16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354,
+  16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354,
+  16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354, 16354,
+  16354, 16354, 16354, 16354, 16354, 16354
+};
+static const Q15_T q15_tanh_lut[Q15_TANH_LUT_SIZE] = {
+  0, 255, 512, 767, 1022, 1277, 1531, 1784, 2037, 2289, 2539, 2788, 3036, 3283, 3528, 3771, 4013, 4252, 4490, 4726,
+  4959, 5190, 5420, 5647, 5871, 6094, 6312, 6529, 6743, 6955, 7162, 7369, 7571, 7772, 7968, 8163, 8353, 8541, 8725,
+  8907, 9086, 9263, 9434, 9604, 9770, 9934, 10094, 10251, 10405, 10557, 10706, 10851, 10993, 11133, 11268, 11402,
+  11532, 11661, 11784, 11908, 12026, 12144, 12258, 12370, 12478, 12585, 12687, 12790, 12887, 12985, 13078, 13171,
+  13259, 13348, 13432, 13515, 13595, 13674, 13750, 13826, 13898, 13969, 14038, 14106, 14170, 14234, 14296, 14357,
+  14415, 14474, 14527, 14582, 14634, 14686, 14735, 14784, 14829, 14876, 14920, 14964, 15004, 15046, 15085, 15124,
+  15161, 15198, 15231, 15267, 15299, 15332, 15362, 15394, 15423, 15453, 15479, 15508, 15532, 15559, 15584, 15608,
+  15631, 15654, 15675, 15698, 15717, 15738, 15758, 15777, 15794, 15814, 15829, 15846, 15862, 15879, 15893, 15908,
+  15922, 15938, 15949, 15963, 15977, 15990, 16000, 16012, 16023, 16035, 16045, 16057, 16065, 16074, 16084, 16094,
+  16102, 16112, 16120, 16129, 16135, 16143, 16149, 16157, 16165, 16173, 16177, 16185, 16191, 16197, 16201, 16206,
+  16212, 16218, 16222, 16228, 16232, 16238, 16242, 16248, 16250, 16256, 16258, 16262, 16266, 16270, 16272, 16276,
+  16280, 16284, 16286, 16290, 16292, 16296, 16298, 16302, 16302, 16306, 16308, 16312, 16312, 16316, 16316, 16320,
+  16320, 16322, 16324, 16326, 16328, 16330, 16332, 16334, 16334, 16336, 16338, 16340, 16340, 16342, 16344, 16346,
+  16346, 16348, 16348, 16350, 16350, 16352, 16352, 16354, 16354, 16356, 16356, 16358, 16358, 16360, 16360, 16362,
+  16360, 16362, 16362, 16364, 16364, 16366, 16364, 16366, 16366, 16368, 16366, 16368, 16368, 16370, 16368, 16370,
+  16370, 16372, 16370, 16372, 16372, 16374, 16372, 16374, 16374, 16376, 16374, 16376, 16374, 16376, 16374, 16376,
+  16376, 16378, 16376, 16378, 16376, 16378, 16376, 16378, 16378, 16380, 16378, 16380, 16378, 16380, 16378, 16380,
+  16378, 16380, 16380, 16382, 16380, 16382, 16380, 16382, 16380, 16382, 16380, 16382, 16380, 16382, 16380, 16382,
+  16380, 16382, 16382, 16384, 16382, 16384, 16382, 16384, 16382, 16384, 16382, 16384, 16382, 16384, 16382, 16384,
+  16382, 16384, 16382, 16384, 16382, 16384, 16382, 16384, 16382, 16384, 16382, 16384, 16382, 16384, 16382, 16384,
+  16382, 16384, 16382, 16384, 16382, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384,
+  16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384,
+  16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384,
+  16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384,
+  16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384,
+  16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384,
+  16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384,
+  16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384,
+  16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384,
+  16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384,
+  16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384,
+  16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384, 16384
+};
+
+void q15_v_sigmoid_lut(const Q15_T* vec, ITER_T len, Q15_T* ret) {
+  ITER_T i = 0;
+  #ifdef SIMD
+    i = q15_v_lut_simd(vec, len, ret, q15_sigmoid_lut, Q15_SIGMOID_LUT_SHIFT,
+                       32767, Q15_SIGMOID_LUT_SIZE, 0);
+  #endif
+
+  for (; i < len; i++) {
+    Q31_T w = vec[i];
+    Q31_T v = (w < 0) ? -w : w;
+    v = (v > 32767) ? 32767 : v;
+    Q31_T index = (v >> Q15_SIGMOID_LUT_SHIFT) + ((w > 0) ? Q15_SIGMOID_LUT_SIZE : 0);
+    Q31_T frac = v & ((1 << Q15_SIGMOID_LUT_SHIFT) - 1);
+    Q31_T low = q15_sigmoid_lut[index];
+    Q31_T high = q15_sigmoid_lut[index + 1];
+    ret[i] = (Q15_T)(low + (((high - low) * frac + (1 << (Q15_SIGMOID_LUT_SHIFT - 1))) >> Q15_SIGMOID_LUT_SHIFT));
+  }
+}
+
+void q15_v_tanh_lut(const Q15_T* vec, ITER_T len, Q15_T* ret) {
+  ITER_T i = 0;
+  #ifdef SIMD
+    i = q15_v_lut_simd(vec, len, ret, q15_tanh_lut, Q15_TANH_LUT_SHIFT, 16383,
+                       0, 1);
+  #endif
+
+  for (; i < len; i++) {
+    Q31_T w = vec[i];
+    Q31_T v = (w < 0) ? -w : w;
+    v = (v > 16383) ? 16383 : v;
+    Q31_T index = v >> Q15_TANH_LUT_SHIFT;
+    Q31_T frac = v & ((1 << Q15_TANH_LUT_SHIFT) - 1);
+    Q31_T low = q15_tanh_lut[index];
+    Q31_T high = q15_tanh_lut[index + 1];
+    Q31_T y = low + (((high - low) * frac + (1 << (Q15_TANH_LUT_SHIFT - 1))) >> Q15_TANH_LUT_SHIFT);
+    ret[i] = (Q15_T)((w < 0) ? -y : y);
+  }
+}
+
 void q15_v_sigmoid(const Q15_T* vec, ITER_T len, Q15_T* ret, Q15_T div,
                    Q15_T add, Q15_T sigmoid_limit, SCALE_T scale_in,
                    SCALE_T scale_out, ITER_T use_tables) {
-  if (use_tables) {
+  if (use_tables == Q_ACTIVATION_LUT) {
+    q15_v_sigmoid_lut(vec, len, ret);
+  } else if (use_tables) {
     #ifdef LOOP_UNROLL
       ITER_T len_unroll = len >> 2;
       len = len % 4;
@@ -254,7 +409,9 @@ void q15_v_sigmoid(const Q15_T* vec, ITER_T len, Q15_T* ret, Q15_T div,
 
 void q15_v_tanh(const Q15_T* vec, ITER_T len, Q15_T* ret, SCALE_T scale_in,
                 SCALE_T scale_out, ITER_T use_tables) {
-  if (use_tables) {
+  if (use_tables == Q_ACTIVATION_LUT) {
+    q15_v_tanh_lut(vec, len, ret);
+  } else if (use_tables) {
     #ifdef LOOP_UNROLL
       ITER_T len_unroll = len >> 2;
       len = len % 4;
@@ -512,6 +669,13 @@ void q15xq7_q15_m_mulvec(const Q15_T* mat, const Q7_T* const vec, ITER_T nrows,
     ITER_T cols = ncols;
     const Q7_T* vec_offset = (const Q7_T*)vec;
 
+    #ifdef SIMD
+      ITER_T done = q15xq7_v_dot_simd(mat, vec_offset, cols, &sum);
+      mat += done;
+      vec_offset += done;
+      cols -= done;
+    #endif
+
     #ifdef LOOP_UNROLL
       ITER_T len_unroll = cols >> 2;
       cols = cols % 4;
@@ -553,6 +717,13 @@ void q15_m_mulvec(const Q15_T* mat, const Q15_T* const vec, ITER_T nrows,
     ITER_T cols = ncols;
     const Q15_T* vec_offset = (const Q15_T*)vec;
 
+    #ifdef SIMD
+      ITER_T done = q15_v_dot_simd(mat, vec_offset, cols, &sum);
+      mat += done;
+      vec_offset += done;
+      cols -= done;
+    #endif
+
     #ifdef LOOP_UNROLL
       ITER_T len_unroll = cols >> 2;
       cols = cols % 4;
@@ -576,6 +747,106 @@ void q15_m_mulvec(const Q15_T* mat, const Q15_T* const vec, ITER_T nrows,
   }
 }
 
+void q15xq7_q15_m_mulvec_batch(const Q15_T* const mat, const Q7_T* const vecs,
+                               ITER_T nrows, ITER_T ncols, ITER_T nvecs,
+                               Q15_T* const ret, SCALE_T scmat, SCALE_T scvec,
+                               SCALE_T H1, SCALE_T H2) {
+  Q31_T sum;
+  #ifdef SHIFT
+    SCALE_T scale = scmat + scvec + H1;
+  #else
+    SCALE_T scale = scmat * scvec * H1;
+  #endif
+
+  for (ITER_T row = 0; row < nrows; row++) {
+    const Q15_T* mat_row = mat + row * ncols;
+    for (ITER_T v = 0; v < nvecs; v++) {
+      sum = 0;
+      ITER_T cols = ncols;
+      const Q15_T* mat_offset = mat_row;
+      const Q7_T* vec_offset = vecs + v * ncols;
+
+      #ifdef SIMD
+        ITER_T done = q15xq7_v_dot_simd(mat_offset, vec_offset, cols, &sum);
+        mat_offset += done;
+        vec_offset += done;
+        cols -= done;
+      #endif
+
+      #ifdef LOOP_UNROLL
+        ITER_T len_unroll = cols >> 2;
+        cols = cols % 4;
+        while (len_unroll--) {
+          sum += (Q31_T)(*mat_offset++) * (Q31_T)(*vec_offset++);
+          sum += (Q31_T)(*mat_offset++) * (Q31_T)(*vec_offset++);
+          sum += (Q31_T)(*mat_offset++) * (Q31_T)(*vec_offset++);
+          sum += (Q31_T)(*mat_offset++) * (Q31_T)(*vec_offset++);
+        }
+      #endif
+
+      while (cols--) {
+        sum += (Q31_T)(*mat_offset++) * (Q31_T)(*vec_offset++);
+      }
+
+      #ifdef SHIFT
+        ret[v * nrows + row] = (sum >> scale);
+      #else
+        ret[v * nrows + row] = (sum / scale);
+      #endif
+    }
+  }
+}
+
+void q15_m_mulvec_batch(const Q15_T* const mat, const Q15_T* const vecs,
+                        ITER_T nrows, ITER_T ncols, ITER_T nvecs,
+                        Q15_T* const ret, SCALE_T scmat, SCALE_T scvec,
+                        SCALE_T H1, SCALE_T H2) {
+  Q63_T sum;
+  #ifdef SHIFT
+    SCALE_T scale = scmat + scvec + H1;
+  #else
+    SCALE_T scale = scmat * scvec * H1;
+  #endif
+
+  for (ITER_T row = 0; row < nrows; row++) {
+    const Q15_T* mat_row = mat + row * ncols;
+    for (ITER_T v = 0; v < nvecs; v++) {
+      sum = 0;
+      ITER_T cols = ncols;
+      const Q15_T* mat_offset = mat_row;
+      const Q15_T* vec_offset = vecs + v * ncols;
+
+      #ifdef SIMD
+        ITER_T done = q15_v_dot_simd(mat_offset, vec_offset, cols, &sum);
+        mat_offset += done;
+        vec_offset += done;
+        cols -= done;
+      #endif
+
+      #ifdef LOOP_UNROLL
+        ITER_T len_unroll = cols >> 2;
+        cols = cols % 4;
+        while (len_unroll--) {
+          sum += (Q31_T)(*mat_offset++) * (Q31_T)(*vec_offset++);
+          sum += (Q31_T)(*mat_offset++) * (Q31_T)(*vec_offset++);
+          sum += (Q31_T)(*mat_offset++) * (Q31_T)(*vec_offset++);
+          sum += (Q31_T)(*mat_offset++) * (Q31_T)(*vec_offset++);
+        }
+      #endif
+
+      while (cols--) {
+        sum += (Q31_T)(*mat_offset++) * (Q31_T)(*vec_offset++);
+      }
+
+      #ifdef SHIFT
+        ret[v * nrows + row] = (sum >> scale);
+      #else
+        ret[v * nrows + row] = (sum / scale);
+      #endif
+    }
+  }
+}
+
 void q15xq7_q15_m_sparse_mulvec(const ITER_T* row_indices,
                                 const Q15_T* mat_values, const Q7_T* vec,
                                 ITER_T nrows, ITER_T ncols, Q15_T* ret,
@@ -776,10 +1047,26 @@ void q15_t_add_vec(const Q15_T* ten, const Q15_T* const vec,
     SCALE_T scalevec = scvec * scret;
   #endif
 
+  #ifdef SIMD
+    #ifdef SHIFT
+      SCALE_T demote = 0;
+    #else
+      SCALE_T demote = 1;
+    #endif
+  #endif
+
   while (len--) {
     ITER_T channels = nchannels;
     const Q15_T* vec_offset = (const Q15_T*)vec;
 
+    #ifdef SIMD
+      ITER_T done = q15_v_add_simd(ten, vec_offset, channels, ret, scaleten, scalevec, demote);
+      ten += done;
+      vec_offset += done;
+      ret += done;
+      channels -= done;
+    #endif
+
     #ifdef LOOP_UNROLL
       ITER_T len_unroll = channels >> 2;
       channels = channels % 4;
@@ -907,6 +1194,321 @@ void q15_t_l2_norm(const Q15_T* ten, ITER_T nbatches, ITER_T nrows,
   }
 }
 
+// Convolutions of the shapes of the MBConv blocks. A 1x1 convolution with a single group and no padding is a GEMM of the input
+// pixels with the filter, a depthwise convolution (CF = COut = 1) multiplies each channel with its own taps.
+static int q_conv_is_pointwise(ITER_T HF, ITER_T WF, ITER_T G, S_ITER_T HPadU,
+  S_ITER_T HPadD, S_ITER_T WPadL, S_ITER_T WPadR) {
+  return (HF == 1) && (WF == 1) && (G == 1) && (HPadU == 0) && (HPadD == 0) &&
+         (WPadL == 0) && (WPadR == 0);
+}
+
+static int q_conv_is_depthwise(ITER_T HF, ITER_T WF, ITER_T CF, ITER_T COut) {
+  return (CF == 1) && (COut == 1) && (HF * WF <= Q_CONV_DEPTHWISE_MAX_TAPS);
+}
+
+// Accumulates the 1x1 convolution of one input pixel for the output channels [0, tile) of the filter
+static void q7xq15_pointwise_tile(const Q7_T* const input,
+  const Q15_T* const filter, ITER_T CF, ITER_T COut, ITER_T tile,
+  Q31_T* const acc) {
+  ITER_T j = 0;
+  #ifdef SIMD
+    for (; j + Q_SIMD_CONV_BLOCK <= tile; j += Q_SIMD_CONV_BLOCK) {
+      q7xq15_conv_tap_simd(input, filter + j, CF, COut, acc + j);
+    }
+  #endif
+
+  if (j < tile) {
+    const Q15_T* filter_offset = filter;
+    for (ITER_T cf = 0; cf < CF; cf++) {
+      Q31_T x = input[cf];
+      for (ITER_T k = j; k < tile; k++) {
+        acc[k] += x * ((Q31_T)filter_offset[k]);
+      }
+      filter_offset += COut;
+    }
+  }
+}
+
+static void q15_pointwise_tile(const Q15_T* const input,
+  const Q15_T* const filter, ITER_T CF, ITER_T COut, ITER_T tile,
+  Q63_T* const acc) {
+  ITER_T j = 0;
+  #ifdef SIMD
+    for (; j + Q_SIMD_CONV_BLOCK <= tile; j += Q_SIMD_CONV_BLOCK) {
+      q15_conv_tap_simd(input, filter + j, CF, COut, acc + j);
+    }
+  #endif
+
+  if (j < tile) {
+    const Q15_T* filter_offset = filter;
+    for (ITER_T cf = 0; cf < CF; cf++) {
+      Q31_T x = input[cf];
+      for (ITER_T k = j; k < tile; k++) {
+        acc[k] += x * ((Q31_T)filter_offset[k]);
+      }
+      filter_offset += COut;
+    }
+  }
+}
+
+// Accumulates the depthwise convolution of one output pixel for a tile of channels, over the listed taps.
+// The taps of the tile are packed as [tap][tile], input_index is the index of the centre of the receptive field
+static void q7xq15_depthwise_tile(const Q7_T* const input,
+  S_ITER_T input_index, const Q15_T* const packed,
+  const S_ITER_T* const tap_offset, const ITER_T* const taps, ITER_T ntaps,
+  ITER_T tile, Q31_T* const acc) {
+  for (ITER_T i = 0; i < ntaps; i++) {
+    const Q7_T* input_offset = input + (input_index + tap_offset[taps[i]]);
+    const Q15_T* filter_offset = packed + taps[i] * tile;
+    for (ITER_T j = 0; j < tile; j++) {
+      acc[j] += ((Q31_T)input_offset[j]) * ((Q31_T)filter_offset[j]);
+    }
+  }
+}
+
+static void q15_depthwise_tile(const Q15_T* const input,
+  S_ITER_T input_index, const Q15_T* const packed,
+  const S_ITER_T* const tap_offset, const ITER_T* const taps, ITER_T ntaps,
+  ITER_T tile, Q63_T* const acc) {
+  for (ITER_T i = 0; i < ntaps; i++) {
+    const Q15_T* input_offset = input + (input_index + tap_offset[taps[i]]);
+    const Q15_T* filter_offset = packed + taps[i] * tile;
+    for (ITER_T j = 0; j < tile; j++) {
+      acc[j] += ((Q31_T)input_offset[j]) * ((Q31_T)filter_offset[j]);
+    }
+  }
+}
+
+// Offsets of the taps of a depthwise filter from the centre of the receptive field, in rows, columns and input elements
+static void q_depthwise_taps(ITER_T HF, ITER_T WF, ITER_T W, ITER_T CIn,
+  ITER_T HDilation, ITER_T WDilation, S_ITER_T* const tap_h,
+  S_ITER_T* const tap_w, S_ITER_T* const tap_offset, ITER_T* const taps) {
+  S_ITER_T HOffsetFL = ((HF - 1) >> 1);
+  S_ITER_T WOffsetFL = ((WF - 1) >> 1);
+  for (ITER_T t = 0; t < HF * WF; t++) {
+    tap_h[t] = (S_ITER_T)HDilation * ((S_ITER_T)(t / WF) - HOffsetFL);
+    tap_w[t] = (S_ITER_T)WDilation * ((S_ITER_T)(t % WF) - WOffsetFL);
+    tap_offset[t] = (tap_h[t] * (S_ITER_T)W + tap_w[t]) * (S_ITER_T)CIn;
+    taps[t] = t;
+  }
+}
+
+// Lists the taps of the receptive field centred on (h, w) which are not in the padding, and returns their number
+static ITER_T q_depthwise_border_taps(ITER_T ntaps, const S_ITER_T* const tap_h,
+  const S_ITER_T* const tap_w, S_ITER_T h, S_ITER_T w, ITER_T H, ITER_T W,
+  ITER_T* const taps) {
+  ITER_T count = 0;
+  for (ITER_T t = 0; t < ntaps; t++) {
+    S_ITER_T hoffset = h + tap_h[t];
+    S_ITER_T woffset = w + tap_w[t];
+    if ((hoffset >= 0) && (hoffset < (S_ITER_T)H) &&
+        (woffset >= 0) && (woffset < (S_ITER_T)W)) {
+      taps[count++] = t;
+    }
+  }
+  return count;
+}
+
+// 1x1 convolution with a single group and no padding, with a Q7 or a Q15 output
+static void q7xq15_pointwise_convolution(const Q7_T* const input,
+  const Q15_T* const filter, void* const output, int q15_output, ITER_T N,
+  ITER_T H, ITER_T W, ITER_T CIn, ITER_T CF, ITER_T COut, ITER_T HOut,
+  ITER_T WOut, ITER_T HStride, ITER_T WStride, SCALE_T scale) {
+  ITER_T HOffsetIn = W * CIn;
+  ITER_T NOffsetIn = H * HOffsetIn;
+  ITER_T HOffsetOut = WOut * COut;
+  ITER_T NOffsetOut = HOut * HOffsetOut;
+  for (ITER_T n = 0; n < N; n++) {
+    ITER_T hout = 0;
+    for (ITER_T h = 0; h < H; h += HStride, hout++) {
+      const Q7_T* input_offset = input + n * NOffsetIn + h * HOffsetIn;
+      ITER_T index = n * NOffsetOut + hout * HOffsetOut;
+      for (ITER_T w = 0; w < W; w += WStride) {
+        for (ITER_T c = 0; c < COut; c += Q_CONV_TILE) {
+          ITER_T tile = (COut - c < Q_CONV_TILE) ? COut - c : Q_CONV_TILE;
+          Q31_T acc[Q_CONV_TILE] = {0};
+          q7xq15_pointwise_tile(input_offset, filter + c, CF, COut, tile, acc);
+
+          for (ITER_T j = 0; j < tile; j++, index++) {
+            #ifdef SHIFT
+              Q31_T value = (acc[j] >> scale);
+            #else
+              Q31_T value = (acc[j] / scale);
+            #endif
+            if (q15_output) {
+              ((Q15_T*)output)[index] = value;
+            } else {
+              ((Q7_T*)output)[index] = value;
+            }
+          }
+        }
+        input_offset += WStride * CIn;
+      }
+    }
+  }
+}
+
+static void q15_pointwise_convolution(const Q15_T* const input,
+  const Q15_T* const filter, Q15_T* const output, ITER_T N, ITER_T H,
+  ITER_T W, ITER_T CIn, ITER_T CF, ITER_T COut, ITER_T HOut, ITER_T WOut,
+  ITER_T HStride, ITER_T WStride, SCALE_T scale) {
+  ITER_T HOffsetIn = W * CIn;
+  ITER_T NOffsetIn = H * HOffsetIn;
+  ITER_T HOffsetOut = WOut * COut;
+  ITER_T NOffsetOut = HOut * HOffsetOut;
+  for (ITER_T n = 0; n < N; n++) {
+    ITER_T hout = 0;
+    for (ITER_T h = 0; h < H; h += HStride, hout++) {
+      const Q15_T* input_offset = input + n * NOffsetIn + h * HOffsetIn;
+      Q15_T* output_offset = output + n * NOffsetOut + hout * HOffsetOut;
+      for (ITER_T w = 0; w < W; w += WStride) {
+        for (ITER_T c = 0; c < COut; c += Q_CONV_TILE) {
+          ITER_T tile = (COut - c < Q_CONV_TILE) ? COut - c : Q_CONV_TILE;
+          Q63_T acc[Q_CONV_TILE] = {0};
+          q15_pointwise_tile(input_offset, filter + c, CF, COut, tile, acc);
+
+          for (ITER_T j = 0; j < tile; j++) {
+            #ifdef SHIFT
+              *output_offset++ = (acc[j] >> scale);
+            #else
+              *output_offset++ = (acc[j] / scale);
+            #endif
+          }
+        }
+        input_offset += WStride * CIn;
+      }
+    }
+  }
+}
+
+// Depthwise convolution, with a Q7 or a Q15 output. The channels are run by tiles, with the taps of the tile packed once.
+// The receptive fields inside the input skip the padding checks. Each output pixel only reads the input pixels under its
+// receptive field, so that a 1x1 depthwise convolution can run in place
+static void q7xq15_depthwise_convolution(const Q7_T* const input,
+  const Q15_T* const filter, void* const output, int q15_output, ITER_T N,
+  ITER_T H, ITER_T W, ITER_T CIn, ITER_T HF, ITER_T WF, ITER_T HOut,
+  ITER_T WOut, ITER_T G, S_ITER_T HPadU, S_ITER_T HPadD, S_ITER_T WPadL,
+  S_ITER_T WPadR, ITER_T HStride, ITER_T WStride, ITER_T HDilation,
+  ITER_T WDilation, SCALE_T scale) {
+  ITER_T ntaps = HF * WF;
+  S_ITER_T tap_h[Q_CONV_DEPTHWISE_MAX_TAPS], tap_w[Q_CONV_DEPTHWISE_MAX_TAPS];
+  S_ITER_T tap_offset[Q_CONV_DEPTHWISE_MAX_TAPS];
+  ITER_T all_taps[Q_CONV_DEPTHWISE_MAX_TAPS], border_taps[Q_CONV_DEPTHWISE_MAX_TAPS];
+  Q15_T packed[Q_CONV_DEPTHWISE_MAX_TAPS * Q_CONV_TILE];
+  q_depthwise_taps(HF, WF, W, CIn, HDilation, WDilation, tap_h, tap_w, tap_offset, all_taps);
+
+  S_ITER_T HOffsetL = -tap_h[0] - HPadU;
+  S_ITER_T WOffsetL = -tap_w[0] - WPadL;
+  S_ITER_T HOffsetR = tap_h[ntaps - 1] - HPadD;
+  S_ITER_T WOffsetR = tap_w[ntaps - 1] - WPadR;
+  ITER_T HOffsetIn = W * CIn;
+  ITER_T NOffsetIn = H * HOffsetIn;
+  ITER_T HOffsetOut = WOut * G;
+  ITER_T NOffsetOut = HOut * HOffsetOut;
+
+  for (ITER_T g = 0; g < G; g += Q_CONV_TILE) {
+    ITER_T tile = (G - g < Q_CONV_TILE) ? G - g : Q_CONV_TILE;
+    for (ITER_T t = 0; t < ntaps; t++) {
+      for (ITER_T j = 0; j < tile; j++) {
+        packed[t * tile + j] = filter[(g + j) * ntaps + t];
+      }
+    }
+
+    for (ITER_T n = 0; n < N; n++) {
+      ITER_T hout = 0;
+      for (S_ITER_T h = HOffsetL; h < (S_ITER_T)H - HOffsetR; h += (S_ITER_T)HStride, hout++) {
+        int interior_row = (h + tap_h[0] >= 0) && (h + tap_h[ntaps - 1] < (S_ITER_T)H);
+        ITER_T index = n * NOffsetOut + hout * HOffsetOut + g;
+        for (S_ITER_T w = WOffsetL; w < (S_ITER_T)W - WOffsetR; w += (S_ITER_T)WStride, index += G) {
+          const ITER_T* taps = all_taps;
+          ITER_T count = ntaps;
+          if (!interior_row || (w + tap_w[0] < 0) || (w + tap_w[ntaps - 1] >= (S_ITER_T)W)) {
+            taps = border_taps;
+            count = q_depthwise_border_taps(ntaps, tap_h, tap_w, h, w, H, W, border_taps);
+          }
+
+          Q31_T acc[Q_CONV_TILE] = {0};
+          q7xq15_depthwise_tile(input, (S_ITER_T)(n * NOffsetIn + g) + h * (S_ITER_T)HOffsetIn + w * (S_ITER_T)CIn,
+            packed, tap_offset, taps, count, tile, acc);
+
+          for (ITER_T j = 0; j < tile; j++) {
+            #ifdef SHIFT
+              Q31_T value = (acc[j] >> scale);
+            #else
+              Q31_T value = (acc[j] / scale);
+            #endif
+            if (q15_output) {
+              ((Q15_T*)output)[index + j] = value;
+            } else {
+              ((Q7_T*)output)[index + j] = value;
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+static void q15_depthwise_convolution(const Q15_T* const input,
+  const Q15_T* const filter, Q15_T* const output, ITER_T N, ITER_T H,
+  ITER_T W, ITER_T CIn, ITER_T HF, ITER_T WF, ITER_T HOut, ITER_T WOut,
+  ITER_T G, S_ITER_T HPadU, S_ITER_T HPadD, S_ITER_T WPadL, S_ITER_T WPadR,
+  ITER_T HStride, ITER_T WStride, ITER_T HDilation, ITER_T WDilation,
+  SCALE_T scale) {
+  ITER_T ntaps = HF * WF;
+  S_ITER_T tap_h[Q_CONV_DEPTHWISE_MAX_TAPS], tap_w[Q_CONV_DEPTHWISE_MAX_TAPS];
+  S_ITER_T tap_offset[Q_CONV_DEPTHWISE_MAX_TAPS];
+  ITER_T all_taps[Q_CONV_DEPTHWISE_MAX_TAPS], border_taps[Q_CONV_DEPTHWISE_MAX_TAPS];
+  Q15_T packed[Q_CONV_DEPTHWISE_MAX_TAPS * Q_CONV_TILE];
+  q_depthwise_taps(HF, WF, W, CIn, HDilation, WDilation, tap_h, tap_w, tap_offset, all_taps);
+
+  S_ITER_T HOffsetL = -tap_h[0] - HPadU;
+  S_ITER_T WOffsetL = -tap_w[0] - WPadL;
+  S_ITER_T HOffsetR = tap_h[ntaps - 1] - HPadD;
+  S_ITER_T WOffsetR = tap_w[ntaps - 1] - WPadR;
+  ITER_T HOffsetIn = W * CIn;
+  ITER_T NOffsetIn = H * HOffsetIn;
+  ITER_T HOffsetOut = WOut * G;
+  ITER_T NOffsetOut = HOut * HOffsetOut;
+
+  for (ITER_T g = 0; g < G; g += Q_CONV_TILE) {
+    ITER_T tile = (G - g < Q_CONV_TILE) ? G - g : Q_CONV_TILE;
+    for (ITER_T t = 0; t < ntaps; t++) {
+      for (ITER_T j = 0; j < tile; j++) {
+        packed[t * tile + j] = filter[(g + j) * ntaps + t];
+      }
+    }
+
+    for (ITER_T n = 0; n < N; n++) {
+      ITER_T hout = 0;
+      for (S_ITER_T h = HOffsetL; h < (S_ITER_T)H - HOffsetR; h += (S_ITER_T)HStride, hout++) {
+        int interior_row = (h + tap_h[0] >= 0) && (h + tap_h[ntaps - 1] < (S_ITER_T)H);
+        Q15_T* output_offset = output + n * NOffsetOut + hout * HOffsetOut + g;
+        for (S_ITER_T w = WOffsetL; w < (S_ITER_T)W - WOffsetR; w += (S_ITER_T)WStride, output_offset += G) {
+          const ITER_T* taps = all_taps;
+          ITER_T count = ntaps;
+          if (!interior_row || (w + tap_w[0] < 0) || (w + tap_w[ntaps - 1] >= (S_ITER_T)W)) {
+            taps = border_taps;
+            count = q_depthwise_border_taps(ntaps, tap_h, tap_w, h, w, H, W, border_taps);
+          }
+
+          Q63_T acc[Q_CONV_TILE] = {0};
+          q15_depthwise_tile(input, (S_ITER_T)(n * NOffsetIn + g) + h * (S_ITER_T)HOffsetIn + w * (S_ITER_T)CIn,
+            packed, tap_offset, taps, count, tile, acc);
+
+          for (ITER_T j = 0; j < tile; j++) {
+            #ifdef SHIFT
+              output_offset[j] = (acc[j] >> scale);
+            #else
+              output_offset[j] = (acc[j] / scale);
+            #endif
+          }
+        }
+      }
+    }
+  }
+}
+
 void q7xq15_q7_convolution(const Q7_T* const input, const Q15_T* const filter,
   Q7_T* const output, ITER_T N, ITER_T H, ITER_T W, ITER_T CIn, ITER_T HF,
   ITER_T WF, ITER_T CF, ITER_T COut, ITER_T HOut, ITER_T WOut, ITER_T G,
@@ -938,6 +1540,16 @@ void q7xq15_q7_convolution(const Q7_T* const input, const Q15_T* const filter,
   #else
     SCALE_T scale = scinput * scoutput * demote;
   #endif
+
+  if (q_conv_is_pointwise(HF, WF, G, HPadU, HPadD, WPadL, WPadR)) {
+    q7xq15_pointwise_convolution(input, filter, output, 0, N, H, W, CIn, CF, COut, HOut, WOut, HStride, WStride, scale);
+    return;
+  }
+  if (q_conv_is_depthwise(HF, WF, CF, COut)) {
+    q7xq15_depthwise_convolution(input, filter, output, 0, N, H, W, CIn, HF, WF, HOut, WOut, G, HPadU, HPadD, WPadL, WPadR, HStride, WStride, HDilation, WDilation, scale);
+    return;
+  }
+
   for (ITER_T n = 0; n < N; n++) {
     ITER_T hout = 0;
     ITER_T NIndexIn = n * NOffsetIn;
@@ -951,7 +1563,39 @@ void q7xq15_q7_convolution(const Q7_T* const input, const Q15_T* const filter,
           ITER_T CIndexIn = g * CF + NIndexIn;
           ITER_T GIndexF = g * GOffsetF;
           Q7_T* output_offset = ((Q7_T*)output) + g * COut + WIndexOut;
-          for (ITER_T c = 0; c < COut; c++) {
+          ITER_T c = 0;
+          #ifdef SIMD
+            for (; c + Q_SIMD_CONV_BLOCK <= COut; c += Q_SIMD_CONV_BLOCK) {
+              Q31_T acc[Q_SIMD_CONV_BLOCK] = {0};
+              for (S_ITER_T hf = -HOffsetFL; hf <= HOffsetFR; hf++) {
+                S_ITER_T hoffset = h + ((S_ITER_T)HDilation * hf);
+                if ((hoffset < 0) || (hoffset >= (S_ITER_T)H)) {
+                  continue;
+                }
+                ITER_T HIndexIn = ((ITER_T)hoffset) * HOffsetIn + CIndexIn;
+                ITER_T HIndexF = ((ITER_T)(hf + HOffsetFL)) * HOffsetF + GIndexF + c;
+                for (S_ITER_T wf = -WOffsetFL; wf <= WOffsetFR; wf++) {
+                  S_ITER_T woffset = w + ((S_ITER_T)WDilation * wf);
+                  if ((woffset < 0) || (woffset >= (S_ITER_T)W)) {
+                    continue;
+                  }
+                  q7xq15_conv_tap_simd(((const Q7_T*)input) + ((ITER_T)woffset) * CIn + HIndexIn,
+                    ((const Q15_T*)filter) + ((ITER_T)(wf + WOffsetFL)) * WOffsetF + HIndexF,
+                    CF, COut, acc);
+                }
+              }
+
+              for (ITER_T j = 0; j < Q_SIMD_CONV_BLOCK; j++) {
+                #ifdef SHIFT
+                  *output_offset++ = (acc[j] >> scale);
+                #else
+                  *output_offset++ = (acc[j] / scale);
+                #endif
+              }
+            }
+          #endif
+
+          for (; c < COut; c++) {
 
             sum = 0;
             for (S_ITER_T hf = -HOffsetFL; hf <= HOffsetFR; hf++) {
@@ -1035,6 +1679,16 @@ void q7xq15_q15_convolution(const Q7_T* const input, const Q15_T* const filter,
   #else
     SCALE_T scale = scinput * scoutput * demote;
   #endif
+
+  if (q_conv_is_pointwise(HF, WF, G, HPadU, HPadD, WPadL, WPadR)) {
+    q7xq15_pointwise_convolution(input, filter, output, 1, N, H, W, CIn, CF, COut, HOut, WOut, HStride, WStride, scale);
+    return;
+  }
+  if (q_conv_is_depthwise(HF, WF, CF, COut)) {
+    q7xq15_depthwise_convolution(input, filter, output, 1, N, H, W, CIn, HF, WF, HOut, WOut, G, HPadU, HPadD, WPadL, WPadR, HStride, WStride, HDilation, WDilation, scale);
+    return;
+  }
+
   for (ITER_T n = 0; n < N; n++) {
     ITER_T hout = 0;
     ITER_T NIndexIn = n * NOffsetIn;
@@ -1048,7 +1702,39 @@ void q7xq15_q15_convolution(const Q7_T* const input, const Q15_T* const filter,
           ITER_T CIndexIn = g * CF + NIndexIn;
           ITER_T GIndexF = g * GOffsetF;
           Q15_T* output_offset = ((Q15_T*)output) + g * COut + WIndexOut;
-          for (ITER_T c = 0; c < COut; c++) {
+          ITER_T c = 0;
+          #ifdef SIMD
+            for (; c + Q_SIMD_CONV_BLOCK <= COut; c += Q_SIMD_CONV_BLOCK) {
+              Q31_T acc[Q_SIMD_CONV_BLOCK] = {0};
+              for (S_ITER_T hf = -HOffsetFL; hf <= HOffsetFR; hf++) {
+                S_ITER_T hoffset = h + ((S_ITER_T)HDilation * hf);
+                if ((hoffset < 0) || (hoffset >= (S_ITER_T)H)) {
+                  continue;
+                }
+                ITER_T HIndexIn = ((ITER_T)hoffset) * HOffsetIn + CIndexIn;
+                ITER_T HIndexF = ((ITER_T)(hf + HOffsetFL)) * HOffsetF + GIndexF + c;
+                for (S_ITER_T wf = -WOffsetFL; wf <= WOffsetFR; wf++) {
+                  S_ITER_T woffset = w + ((S_ITER_T)WDilation * wf);
+                  if ((woffset < 0) || (woffset >= (S_ITER_T)W)) {
+                    continue;
+                  }
+                  q7xq15_conv_tap_simd(((const Q7_T*)input) + ((ITER_T)woffset) * CIn + HIndexIn,
+                    ((const Q15_T*)filter) + ((ITER_T)(wf + WOffsetFL)) * WOffsetF + HIndexF,
+                    CF, COut, acc);
+                }
+              }
+
+              for (ITER_T j = 0; j < Q_SIMD_CONV_BLOCK; j++) {
+                #ifdef SHIFT
+                  *output_offset++ = (acc[j] >> scale);
+                #else
+                  *output_offset++ = (acc[j] / scale);
+                #endif
+              }
+            }
+          #endif
+
+          for (; c < COut; c++) {
 
             sum = 0;
             for (S_ITER_T hf = -HOffsetFL; hf <= HOffsetFR; hf++) {
@@ -1132,6 +1818,16 @@ void q15_convolution(const Q15_T* const input, const Q15_T* const filter,
   #else
     SCALE_T scale = scinput * scoutput * demote;
   #endif
+
+  if (q_conv_is_pointwise(HF, WF, G, HPadU, HPadD, WPadL, WPadR)) {
+    q15_pointwise_convolution(input, filter, output, N, H, W, CIn, CF, COut, HOut, WOut, HStride, WStride, scale);
+    return;
+  }
+  if (q_conv_is_depthwise(HF, WF, CF, COut)) {
+    q15_depthwise_convolution(input, filter, output, N, H, W, CIn, HF, WF, HOut, WOut, G, HPadU, HPadD, WPadL, WPadR, HStride, WStride, HDilation, WDilation, scale);
+    return;
+  }
+
   for (ITER_T n = 0; n < N; n++) {
     ITER_T hout = 0;
     ITER_T NIndexIn = n * NOffsetIn;
@@ -1145,7 +1841,39 @@ void q15_convolution(const Q15_T* const input, const Q15_T* const filter,
           ITER_T CIndexIn = g * CF + NIndexIn;
           ITER_T GIndexF = g * GOffsetF;
           Q15_T* output_offset = ((Q15_T*)output) + g * COut + WIndexOut;
-          for (ITER_T c = 0; c < COut; c++) {
+          ITER_T c = 0;
+          #ifdef SIMD
+            for (; c + Q_SIMD_CONV_BLOCK <= COut; c += Q_SIMD_CONV_BLOCK) {
+              Q63_T acc[Q_SIMD_CONV_BLOCK] = {0};
+              for (S_ITER_T hf = -HOffsetFL; hf <= HOffsetFR; hf++) {
+                S_ITER_T hoffset = h + ((S_ITER_T)HDilation * hf);
+                if ((hoffset < 0) || (hoffset >= (S_ITER_T)H)) {
+                  continue;
+                }
+                ITER_T HIndexIn = ((ITER_T)hoffset) * HOffsetIn + CIndexIn;
+                ITER_T HIndexF = ((ITER_T)(hf + HOffsetFL)) * HOffsetF + GIndexF + c;
+                for (S_ITER_T wf = -WOffsetFL; wf <= WOffsetFR; wf++) {
+                  S_ITER_T woffset = w + ((S_ITER_T)WDilation * wf);
+                  if ((woffset < 0) || (woffset >= (S_ITER_T)W)) {
+                    continue;
+                  }
+                  q15_conv_tap_simd(((const Q15_T*)input) + ((ITER_T)woffset) * CIn + HIndexIn,
+                    ((const Q15_T*)filter) + ((ITER_T)(wf + WOffsetFL)) * WOffsetF + HIndexF,
+                    CF, COut, acc);
+                }
+              }
+
+              for (ITER_T j = 0; j < Q_SIMD_CONV_BLOCK; j++) {
+                #ifdef SHIFT
+                  *output_offset++ = (acc[j] >> scale);
+                #else
+                  *output_offset++ = (acc[j] / scale);
+                #endif
+              }
+            }
+          #endif
+
+          for (; c < COut; c++) {
 
             sum = 0;
             for (S_ITER_T hf = -HOffsetFL; hf <= HOffsetFR; hf++) {
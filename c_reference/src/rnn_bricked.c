@@ -6,40 +6,72 @@
 #include <math.h>
 #include "rnn_bricked.h"
 #include "utils.h"
+#include "parallel.h"
 
-// Forward Pass
-int forward_bricked_fastgrnn_lr(float* output_signal, unsigned rnn_hidden, 
-  float* input_signal, unsigned in_time, unsigned in_dims, 
-  unsigned window, unsigned hop, const void* params,
-  unsigned bi_direction, unsigned sample_first_brick) {
-  
-  // Buffers and params
-  const BrickedFastGRNN_LR_Params* tparams = (const BrickedFastGRNN_LR_Params*)params;
+// Arguments for the Wx computation over a range of input time steps [t_begin, t_end)
+typedef struct Bricked_Wx_Task {
+  const BrickedFastGRNN_LR_Params* params;
+  const float* input_signal;
+  unsigned in_dims;
+  unsigned rnn_hidden;
+  float* inputMulW;
+  unsigned t_begin;
+  unsigned t_end;
+} Bricked_Wx_Task;
 
-  unsigned rnn_assign_offset = rnn_hidden, out_index = 0;
-  unsigned num_bricks = (in_time - window) / hop + 1;
-  // If bi-directional is True(non-zero) then the actual output hidden state(allocated space) is twice rnn_hidden
-  // This function only processes the forward context
-  if (bi_direction) {
-    rnn_assign_offset <<= 1;
+// Arguments for the recurrence over a range of bricks [brick_begin, brick_end)
+// sample_output is non-zero only for the range holding the sampled brick (first brick for forward, last brick for backward)
+typedef struct Bricked_Brick_Task {
+  const BrickedFastGRNN_LR_Params* params;
+  const float* inputMulW;
+  float* hiddenState;
+  unsigned rnn_hidden;
+  unsigned window;
+  unsigned hop;
+  unsigned backward;
+  unsigned brick_begin;
+  unsigned brick_end;
+  float* sample_output;
+  unsigned sample_offset;
+  unsigned sample_brick;
+  unsigned sample_index;
+} Bricked_Brick_Task;
+
+// Compute W1 * W2 * X for the time steps of the task
+static void bricked_wx_task(void* args) {
+  const Bricked_Wx_Task* task = (const Bricked_Wx_Task*)args;
+  const BrickedFastGRNN_LR_Params* tparams = task->params;
+  unsigned steps = task->t_end - task->t_begin;
+  if (steps == 0) {
+    return;
   }
-  
-  // Compute W1 * W2 * X
-  float* inputMulW = (float*)calloc(in_time * rnn_hidden, sizeof(float));
-  float* tempLR = (float*)calloc(in_time * tparams->wRank, sizeof(float));
-  float* hiddenState = (float*)calloc(num_bricks * rnn_hidden, sizeof(float));
-  float* preComp = (float*)calloc(num_bricks * rnn_hidden, sizeof(float));
-  transposed_tiledMatMul(input_signal, tparams->W1, in_time, in_dims,
-    tparams->wRank, in_dims, in_dims,
-    tempLR, tparams->block_size_w_to_lr);
-  transposed_tiledMatMul(tempLR, tparams->W2, in_time, tparams->wRank,
-    rnn_hidden, tparams->wRank, tparams->wRank,
-    inputMulW, tparams->block_size_w_from_lr);
+  float* tempLR = (float*)calloc(steps * tparams->wRank, sizeof(float));
+  transposed_tiledMatMul(task->input_signal + task->t_begin * task->in_dims,
+    tparams->W1, steps, task->in_dims, tparams->wRank, task->in_dims,
+    task->in_dims, tempLR, tparams->block_size_w_to_lr);
+  transposed_tiledMatMul(tempLR, tparams->W2, steps, tparams->wRank,
+    task->rnn_hidden, tparams->wRank, tparams->wRank,
+    task->inputMulW + task->t_begin * task->rnn_hidden,
+    tparams->block_size_w_from_lr);
   free(tempLR);
-  // We can reuse the low-rank buffer from Wx to Uh, since Wx is computed at one stretch
+}
+
+// Run the recurrence over the window for the bricks of the task
+// Each brick only depends on its own hidden state. Hence the bricks can be split into independent ranges
+static void bricked_brick_task(void* args) {
+  const Bricked_Brick_Task* task = (const Bricked_Brick_Task*)args;
+  const BrickedFastGRNN_LR_Params* tparams = task->params;
+  unsigned rnn_hidden = task->rnn_hidden, hop = task->hop, window = task->window;
+  unsigned num_bricks = task->brick_end - task->brick_begin;
+  if (num_bricks == 0) {
+    return;
+  }
+  float* hiddenState = task->hiddenState + task->brick_begin * rnn_hidden;
+  float* preComp = (float*)calloc(num_bricks * rnn_hidden, sizeof(float));
   // memset is used. Hence, malloc can be used here for matMul result initialization
-  tempLR = (float*)malloc(num_bricks * tparams->uRank * sizeof(float));
-  for (unsigned t = 0; t < window; t++) {
+  float* tempLR = (float*)malloc(num_bricks * tparams->uRank * sizeof(float));
+  for (unsigned step = 0; step < window; step++) {
+    unsigned t = task->backward ? window - 1 - step : step;
     // From higher dims to lower dims
     memset(tempLR, 0, num_bricks * tparams->uRank * sizeof(float));
     transposed_tiledMatMul(hiddenState, tparams->U1, num_bricks, rnn_hidden,
@@ -51,8 +83,8 @@ int forward_bricked_fastgrnn_lr(float* output_signal, unsigned rnn_hidden,
     // Hence we use calloc and memset to equate the result to 0
     // But since we want Wx + Uh, we can store Wx and use the MatMul to add the result over the input
     float* preComp_offset = (float*)preComp;
-    for (unsigned n = 0; n < num_bricks; n++) {
-      float* inputMulW_offset = (float*)inputMulW + (n * hop + t) * rnn_hidden;
+    for (unsigned n = task->brick_begin; n < task->brick_end; n++) {
+      float* inputMulW_offset = (float*)task->inputMulW + (n * hop + t) * rnn_hidden;
       unsigned hidden = rnn_hidden;
 
       #ifdef LOOP_UNROLL
@@ -124,14 +156,102 @@ int forward_bricked_fastgrnn_lr(float* output_signal, unsigned rnn_hidden,
         hiddenState_offset++;
       }
     }
-    // Sample first block if necessary
-    if (sample_first_brick) {
-      if (t % hop == 0) {
-        memcpy(output_signal + (out_index++) * rnn_assign_offset,
-          hiddenState, rnn_hidden * sizeof(float));
-      }
+    // Sample the first (forward) or the last (backward) brick if necessary
+    if (task->sample_output && (step % hop == 0)) {
+      unsigned out_index = task->backward ? task->sample_index - step / hop :
+                                            task->sample_index + step / hop;
+      memcpy(task->sample_output + out_index * task->sample_offset,
+        task->hiddenState + task->sample_brick * rnn_hidden,
+        rnn_hidden * sizeof(float));
     }
   }
+  free(preComp);
+  free(tempLR);
+}
+
+// Compute all the bricks of one direction. Wx is computed first for all the time steps and then the recurrence for all the bricks
+// Both the phases are split into num_threads ranges
+static void bricked_fastgrnn_lr(float* hiddenState, unsigned rnn_hidden,
+  float* input_signal, unsigned in_time, unsigned in_dims,
+  unsigned window, unsigned hop, const BrickedFastGRNN_LR_Params* tparams,
+  unsigned backward, float* sample_output, unsigned sample_offset,
+  unsigned sample_index) {
+  unsigned num_bricks = (in_time - window) / hop + 1;
+  unsigned num_threads = (tparams->num_threads > 1) ? tparams->num_threads : 1;
+  if (num_threads > num_bricks) {
+    num_threads = num_bricks;
+  }
+  float* inputMulW = (float*)calloc(in_time * rnn_hidden, sizeof(float));
+
+  Bricked_Wx_Task* wx_tasks = (Bricked_Wx_Task*)malloc(num_threads * sizeof(Bricked_Wx_Task));
+  for (unsigned i = 0; i < num_threads; i++) {
+    Bricked_Wx_Task task = {
+      .params = tparams,
+      .input_signal = input_signal,
+      .in_dims = in_dims,
+      .rnn_hidden = rnn_hidden,
+      .inputMulW = inputMulW,
+      .t_begin = (in_time * i) / num_threads,
+      .t_end = (in_time * (i + 1)) / num_threads,
+    };
+    wx_tasks[i] = task;
+  }
+  parallel_for(bricked_wx_task, wx_tasks, sizeof(Bricked_Wx_Task), num_threads);
+  free(wx_tasks);
+
+  Bricked_Brick_Task* brick_tasks = (Bricked_Brick_Task*)malloc(num_threads * sizeof(Bricked_Brick_Task));
+  unsigned sample_brick = backward ? num_bricks - 1 : 0;
+  for (unsigned i = 0; i < num_threads; i++) {
+    Bricked_Brick_Task task = {
+      .params = tparams,
+      .inputMulW = inputMulW,
+      .hiddenState = hiddenState,
+      .rnn_hidden = rnn_hidden,
+      .window = window,
+      .hop = hop,
+      .backward = backward,
+      .brick_begin = (num_bricks * i) / num_threads,
+      .brick_end = (num_bricks * (i + 1)) / num_threads,
+      .sample_output = 0,
+      .sample_offset = sample_offset,
+      .sample_brick = sample_brick,
+      .sample_index = sample_index,
+    };
+    if (sample_output && (task.brick_begin <= sample_brick) && (sample_brick < task.brick_end)) {
+      task.sample_output = sample_output;
+    }
+    brick_tasks[i] = task;
+  }
+  parallel_for(bricked_brick_task, brick_tasks, sizeof(Bricked_Brick_Task), num_threads);
+  free(brick_tasks);
+  free(inputMulW);
+}
+
+// Forward Pass
+int forward_bricked_fastgrnn_lr(float* output_signal, unsigned rnn_hidden, 
+  float* input_signal, unsigned in_time, unsigned in_dims, 
+  unsigned window, unsigned hop, const void* params,
+  unsigned bi_direction, unsigned sample_first_brick) {
+  
+  // Buffers and params
+  const BrickedFastGRNN_LR_Params* tparams = (const BrickedFastGRNN_LR_Params*)params;
+
+  unsigned rnn_assign_offset = rnn_hidden, out_index = 0;
+  unsigned num_bricks = (in_time - window) / hop + 1;
+  // If bi-directional is True(non-zero) then the actual output hidden state(allocated space) is twice rnn_hidden
+  // This function only processes the forward context
+  if (bi_direction) {
+    rnn_assign_offset <<= 1;
+  }
+  
+  float* hiddenState = (float*)calloc(num_bricks * rnn_hidden, sizeof(float));
+  // Sample first block if necessary. Every hop-th hidden state of the first brick is written from index 0
+  bricked_fastgrnn_lr(hiddenState, rnn_hidden, input_signal, in_time, in_dims,
+    window, hop, tparams, 0, sample_first_brick ? output_signal : 0,
+    rnn_assign_offset, 0);
+  if (sample_first_brick) {
+    out_index = (window + hop - 1) / hop;
+  }
   if (bi_direction) {
     // If bi-directional then a gap would need to be left for the backward outputs
     float* hiddenState_offset = hiddenState;
@@ -147,9 +267,6 @@ int forward_bricked_fastgrnn_lr(float* output_signal, unsigned rnn_hidden,
       hiddenState, num_bricks * rnn_hidden * sizeof(float));
   }
   free(hiddenState);
-  free(inputMulW);
-  free(preComp);
-  free(tempLR);
   return 0;
 }
 
@@ -171,114 +288,11 @@ int backward_bricked_fastgrnn_lr(float* output_signal, unsigned rnn_hidden,
     rnn_assign_offset <<= 1;
   }
   
-  // Compute W1 * W2 * X
-  float* inputMulW = (float*)calloc(in_time * rnn_hidden, sizeof(float));
-  float* tempLR = (float*)calloc(in_time * tparams->wRank, sizeof(float));
   float* hiddenState = (float*)calloc(num_bricks * rnn_hidden, sizeof(float));
-  float* preComp = (float*)calloc(num_bricks * rnn_hidden, sizeof(float));
-  transposed_tiledMatMul(input_signal, tparams->W1, in_time, in_dims,
-    tparams->wRank, in_dims, in_dims,
-    tempLR, tparams->block_size_w_to_lr);
-  transposed_tiledMatMul(tempLR, tparams->W2, in_time, tparams->wRank,
-    rnn_hidden, tparams->wRank, tparams->wRank,
-    inputMulW, tparams->block_size_w_from_lr);
-  free(tempLR);
-  // We can reuse the low-rank buffer from Wx to Uh, since Wx is computed at one stretch
-  tempLR = (float*)calloc(num_bricks * tparams->uRank, sizeof(float));
-  for (int t = window - 1; t >= 0; t--) {
-    // From higher dims to lower dims
-    memset(tempLR, 0, num_bricks * tparams->uRank * sizeof(float));
-    transposed_tiledMatMul(hiddenState, tparams->U1, num_bricks, rnn_hidden,
-      tparams->uRank, rnn_hidden, rnn_hidden,
-      tempLR, tparams->block_size_u_to_lr);
-        // From lower dims to higher dims
-    // Add Wx with Uh
-    // The tiled MatMuls are codes such that they yield result += matA * matB
-    // Hence we use calloc and memset to equate the result to 0
-    // But since we want Wx + Uh, we can store Wx and use the MatMul to add the result over the input
-    float* preComp_offset = (float*)preComp;
-    for (unsigned n = 0; n < num_bricks; n++) {
-      float* inputMulW_offset = (float*)inputMulW + (n * hop + t) * rnn_hidden;
-      unsigned hidden = rnn_hidden;
-
-      #ifdef LOOP_UNROLL
-        unsigned len_unroll = hidden >> 2;
-        hidden %= 4;
-        while (len_unroll--) {
-          *preComp_offset++ = *inputMulW_offset++;
-          *preComp_offset++ = *inputMulW_offset++;
-          *preComp_offset++ = *inputMulW_offset++;
-          *preComp_offset++ = *inputMulW_offset++;
-        }
-      #endif
-
-      while (hidden--) {
-        *preComp_offset++ = *inputMulW_offset++;
-      }
-    }
-    transposed_tiledMatMul(tempLR, tparams->U2, num_bricks, tparams->uRank,
-      rnn_hidden, tparams->uRank, tparams->uRank,
-      preComp, tparams->block_size_u_from_lr);
-    
-    // Apply the gating
-    float* hiddenState_offset = (float*)hiddenState;
-    preComp_offset = (float*)preComp;
-    unsigned bricks = num_bricks;
-    while (bricks--) {
-      float* gateBias = (float*)tparams->Bg;
-      float* hiddenBias = (float*)tparams->Bh;
-      unsigned hidden = rnn_hidden;
-      
-      #ifdef LOOP_UNROLL
-        unsigned len_unroll = hidden >> 2;
-        hidden = rnn_hidden % 4;
-        float gate, update;
-        while (len_unroll--) {
-          gate = sigmoid((*preComp_offset) + (*gateBias++));
-          update = tanh((*preComp_offset++) + (*hiddenBias++));
-          *hiddenState_offset = gate * (*hiddenState_offset) + 
-                                (tparams->sigmoid_zeta * (1.0 - gate) + 
-                                tparams->sigmoid_nu) * update;
-          hiddenState_offset++;
-          gate = sigmoid((*preComp_offset) + (*gateBias++));
-          update = tanh((*preComp_offset++) + (*hiddenBias++));
-          *hiddenState_offset = gate * (*hiddenState_offset) + 
-                                (tparams->sigmoid_zeta * (1.0 - gate) + 
-                                tparams->sigmoid_nu) * update;
-          hiddenState_offset++;
-          gate = sigmoid((*preComp_offset) + (*gateBias++));
-          update = tanh((*preComp_offset++) + (*hiddenBias++));
-          *hiddenState_offset = gate * (*hiddenState_offset) + 
-                                (tparams->sigmoid_zeta * (1.0 - gate) + 
-                                tparams->sigmoid_nu) * update;
-          hiddenState_offset++;
-          gate = sigmoid((*preComp_offset) + (*gateBias++));
-          update = tanh((*preComp_offset++) + (*hiddenBias++));
-          *hiddenState_offset = gate * (*hiddenState_offset) + 
-                                (tparams->sigmoid_zeta * (1.0 - gate) + 
-                                tparams->sigmoid_nu) * update;
-          hiddenState_offset++;
-        }
-      #endif
-
-      while (hidden--) {
-        float gate = sigmoid((*preComp_offset) + (*gateBias++));
-        float update = tanh((*preComp_offset++) + (*hiddenBias++));
-        *hiddenState_offset = gate * (*hiddenState_offset) + 
-                              (tparams->sigmoid_zeta * (1.0 - gate) + 
-                              tparams->sigmoid_nu) * update;
-        hiddenState_offset++;
-      }
-    }
-    // Sample first block if necessary
-    if (sample_last_brick) {
-      if ((window - 1 - t) % hop == 0) {
-        // Iterate over the output in reverse
-        memcpy(output_signal + (out_index--) * rnn_assign_offset,
-          hiddenState + (num_bricks - 1) * rnn_hidden, rnn_hidden * sizeof(float));
-      }
-    }
-  }
+  // Sample last block if necessary. Every hop-th hidden state of the last brick is written in reverse from index out_time - 1
+  bricked_fastgrnn_lr(hiddenState, rnn_hidden, input_signal, in_time, in_dims,
+    window, hop, tparams, 1, sample_last_brick ? output_signal : 0,
+    rnn_assign_offset, out_index);
   // Since the all first (final in reverse) hiddenstates are calculated, we assign the whole block
   out_index = 0;
   if (bi_direction) {
@@ -296,8 +310,5 @@ int backward_bricked_fastgrnn_lr(float* output_signal, unsigned rnn_hidden,
       hiddenState, num_bricks * rnn_hidden * sizeof(float));
   }
   free(hiddenState);
-  free(inputMulW);
-  free(preComp);
-  free(tempLR);
   return 0;
 }
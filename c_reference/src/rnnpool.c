@@ -7,6 +7,7 @@
 int rnnpool_block(const float* const patch, unsigned inputDims,
   unsigned patchDim, unsigned stride,
   rnn_t rnn1, unsigned hiddenDims1, const void* rnn1_params, void* rnn1_buffers,
+  rnn_batch_t rnn1_batch, void* rnn1_batch_buffers,
   rnn_t rnn2, unsigned hiddenDims2, const void* rnn2_params, void* rnn2_buffers,
   float* const output, float* const buffer) {
 
@@ -15,10 +16,19 @@ int rnnpool_block(const float* const patch, unsigned inputDims,
 
   // Horizontal pass over each row with RNN1
   memset(buffer, 0, sizeof(float) * hiddenDims1 * patchDim);
-  for (unsigned r = 0; r < patchDim; ++r)
-    rnn1(buffer + r * hiddenDims1, hiddenDims1,
-      patch + stride * r * inputDims, inputDims, patchDim,
-      rnn1_params, rnn1_buffers, 0, 0);
+  if (rnn1_batch) {
+    // All the rows advance together by one column. The pixels of a column are
+    // stride pixels apart, the hidden states of the rows are contiguous
+    for (unsigned c = 0; c < patchDim; ++c)
+      rnn1_batch(buffer, hiddenDims1, patch + c * inputDims, inputDims,
+        stride * inputDims, patchDim, rnn1_params, rnn1_batch_buffers, 0);
+  }
+  else {
+    for (unsigned r = 0; r < patchDim; ++r)
+      rnn1(buffer + r * hiddenDims1, hiddenDims1,
+        patch + stride * r * inputDims, inputDims, patchDim,
+        rnn1_params, rnn1_buffers, 0, 0);
+  }
 
   // Bi-directional vertical pass over the row summaries
   rnn2(output, hiddenDims2, buffer, hiddenDims1, patchDim, rnn2_params, rnn2_buffers, 0, 0);
@@ -26,11 +36,20 @@ int rnnpool_block(const float* const patch, unsigned inputDims,
 
   // Vertical pass over each column with RNN1
   memset(buffer, 0, sizeof(float) * hiddenDims1 * patchDim);
-  for (unsigned c = 0; c < patchDim; ++c)
+  if (rnn1_batch) {
+    // All the columns advance together by one row. The pixels of a row are
+    // contiguous, and so are the hidden states of the columns in the buffer
     for (unsigned r = 0; r < patchDim; ++r)
-      rnn1(buffer + c * hiddenDims1, hiddenDims1,
-        patch + (stride * r + c) * inputDims, inputDims, 1,
-        rnn1_params, rnn1_buffers, 0, 0);
+      rnn1_batch(buffer, hiddenDims1, patch + stride * r * inputDims, inputDims,
+        inputDims, patchDim, rnn1_params, rnn1_batch_buffers, 0);
+  }
+  else {
+    for (unsigned c = 0; c < patchDim; ++c)
+      for (unsigned r = 0; r < patchDim; ++r)
+        rnn1(buffer + c * hiddenDims1, hiddenDims1,
+          patch + (stride * r + c) * inputDims, inputDims, 1,
+          rnn1_params, rnn1_buffers, 0, 0);
+  }
 
   // Bi-directional horizontal pass over the columns summaries
   rnn2(output + 2 * hiddenDims2, hiddenDims2, buffer, hiddenDims1, patchDim, rnn2_params, rnn2_buffers, 0, 0);
@@ -193,6 +193,69 @@ void transposed_tiledMatMul(const float* const matA, const float* const matB,
   }
 }
 
+void pack_transposed_matB(const float* const matB, unsigned ncols, unsigned ncommon,
+  unsigned total_comm_B, float* const packed) {
+  float* packed_offset = packed;
+  for (unsigned col = 0; col < ncols; col += PACKED_MATMUL_COLS) {
+    unsigned panel_cols = (col + PACKED_MATMUL_COLS < ncols) ? PACKED_MATMUL_COLS : ncols - col;
+    for (unsigned comm = 0; comm < ncommon; comm++) {
+      for (unsigned c = 0; c < PACKED_MATMUL_COLS; c++) {
+        *packed_offset++ = (c < panel_cols) ? matB[(col + c) * total_comm_B + comm] : 0.0f;
+      }
+    }
+  }
+}
+
+// GCC otherwise vectorizes the ncommon loop of the register block as a reduction (with shuffles and spills),
+// instead of the independent accumulator columns. The SLP vectorizer still packs the accumulator rows into vectors
+// With the loop vectorizer, conv1d_im2col drops from ~11 to ~3.5 GFLOP/s (gcc -O3, 4000 steps, 64 -> 128 channels, k = 5)
+#if defined(__GNUC__) && !defined(__clang__)
+__attribute__((optimize("no-tree-loop-vectorize")))
+#endif
+void packed_tiledMatMul(const float* const matA, const float* const packedB,
+  unsigned nrows, unsigned ncommon, unsigned ncols,
+  unsigned total_comm_A, float* const ret, unsigned block_size) {
+  if (block_size == 0 || block_size > ncommon) {
+    block_size = ncommon;
+  }
+  for (unsigned comm = 0; comm < ncommon; comm += block_size) {
+    unsigned comm_block_size = (comm + block_size < ncommon) ? block_size : ncommon - comm;
+    for (unsigned row = 0; row < nrows; row += PACKED_MATMUL_ROWS) {
+      unsigned row_block_size = (row + PACKED_MATMUL_ROWS < nrows) ? PACKED_MATMUL_ROWS : nrows - row;
+      // For the last (partial) row block, the missing rows re-use the last valid row of matA
+      // The duplicate results are computed in registers and discarded. This avoids a separate tail loop
+      const float* matA_row0 = matA + row * total_comm_A + comm;
+      const float* matA_row1 = matA_row0 + ((row_block_size > 1) ? 1 : 0) * total_comm_A;
+      const float* matA_row2 = matA_row0 + ((row_block_size > 2) ? 2 : row_block_size - 1) * total_comm_A;
+      const float* matA_row3 = matA_row0 + ((row_block_size > 3) ? 3 : row_block_size - 1) * total_comm_A;
+      for (unsigned col = 0; col < ncols; col += PACKED_MATMUL_COLS) {
+        unsigned col_block_size = (col + PACKED_MATMUL_COLS < ncols) ? PACKED_MATMUL_COLS : ncols - col;
+        const float* packed_offset = packedB + col * ncommon + comm * PACKED_MATMUL_COLS;
+        // One accumulator row per matA row. Kept as separate arrays so that they can stay in the registers
+        float acc0[PACKED_MATMUL_COLS] = {0}, acc1[PACKED_MATMUL_COLS] = {0};
+        float acc2[PACKED_MATMUL_COLS] = {0}, acc3[PACKED_MATMUL_COLS] = {0};
+        for (unsigned k = 0; k < comm_block_size; k++) {
+          float a0 = matA_row0[k], a1 = matA_row1[k], a2 = matA_row2[k], a3 = matA_row3[k];
+          for (unsigned c = 0; c < PACKED_MATMUL_COLS; c++) {
+            acc0[c] += a0 * packed_offset[c];
+            acc1[c] += a1 * packed_offset[c];
+            acc2[c] += a2 * packed_offset[c];
+            acc3[c] += a3 * packed_offset[c];
+          }
+          packed_offset += PACKED_MATMUL_COLS;
+        }
+        float* acc[PACKED_MATMUL_ROWS] = {acc0, acc1, acc2, acc3};
+        for (unsigned r = 0; r < row_block_size; r++) {
+          float* ret_offset = ret + (row + r) * ncols + col;
+          for (unsigned c = 0; c < col_block_size; c++) {
+            ret_offset[c] += acc[r][c];
+          }
+        }
+      }
+    }
+  }
+}
+
 void v_add(float scalar1, const float* const vec1,
   float scalar2, const float* const vec2,
   unsigned len, float* const ret) {
@@ -0,0 +1,215 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "bench.h"
+#include "quantized_simd.h"
+
+static double samples[BENCH_MAX_REPS];
+static double single_samples[BENCH_MAX_SINGLE_CALLS];
+
+// Optional flags of the build, written in the JSON output
+static const char build_flags[] = ""
+  #ifdef SHIFT
+    " SHIFT"
+  #endif
+  #ifdef SIMD
+    " SIMD"
+  #endif
+  #ifdef LOOP_UNROLL
+    " LOOP_UNROLL"
+  #endif
+  #ifdef MULTITHREADED
+    " MULTITHREADED"
+  #endif
+  ;
+
+static double now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static double time_calls(bench_fn fn, unsigned calls) {
+  double begin = now_ns();
+  for (unsigned i = 0; i < calls; i++) {
+    fn();
+  }
+  return now_ns() - begin;
+}
+
+static int compare_doubles(const void* a, const void* b) {
+  const double da = *(const double*)a;
+  const double db = *(const double*)b;
+  return (da > db) - (da < db);
+}
+
+static int parse_count(const char* arg, unsigned max, unsigned* ret) {
+  char* end;
+  long value = strtol(arg, &end, 10);
+  if (*end != '\0' || value < 0 || value > (long)max) {
+    return ERR_BENCH_ARGS;
+  }
+  *ret = (unsigned)value;
+  return 0;
+}
+
+int bench_init(Bench_Suite* suite, const char* name, int argc, char** argv) {
+  suite->suite = name;
+  suite->warmup = BENCH_DEFAULT_WARMUP;
+  suite->reps = BENCH_DEFAULT_REPS;
+  suite->threads = BENCH_DEFAULT_THREADS;
+  suite->filter = NULL;
+  suite->json_path = NULL;
+  suite->num_results = 0;
+
+  for (int i = 1; i < argc; i++) {
+    if (i + 1 == argc) {
+      fprintf(stderr, "Missing value of option %s\n", argv[i]);
+      return ERR_BENCH_ARGS;
+    }
+    const char* value = argv[++i];
+    int ret = 0;
+    if (strcmp(argv[i - 1], "--reps") == 0) {
+      ret = parse_count(value, BENCH_MAX_REPS, &suite->reps);
+      ret = ret ? ret : (suite->reps == 0 ? ERR_BENCH_ARGS : 0);
+    } else if (strcmp(argv[i - 1], "--warmup") == 0) {
+      ret = parse_count(value, BENCH_MAX_REPS, &suite->warmup);
+    } else if (strcmp(argv[i - 1], "--threads") == 0) {
+      ret = parse_count(value, 64, &suite->threads);
+      ret = ret ? ret : (suite->threads == 0 ? ERR_BENCH_ARGS : 0);
+    } else if (strcmp(argv[i - 1], "--filter") == 0) {
+      suite->filter = value;
+    } else if (strcmp(argv[i - 1], "--json") == 0) {
+      suite->json_path = value;
+    } else {
+      ret = ERR_BENCH_ARGS;
+    }
+    if (ret) {
+      fprintf(stderr, "Invalid option %s %s\n", argv[i - 1], value);
+      fprintf(stderr, "Usage : %s [--reps <n>] [--warmup <n>] [--threads <n>] [--filter <substring>] [--json <file>]\n", argv[0]);
+      return ret;
+    }
+  }
+
+  printf("%-36s %-44s %8s %12s %12s %12s\n", "name", "shape", "calls",
+    "min (us)", "median (us)", "p99 (us)");
+  return 0;
+}
+
+int bench_run(Bench_Suite* suite, const char* name, const char* shape,
+  bench_fn fn) {
+  if (suite->filter != NULL && strstr(name, suite->filter) == NULL) {
+    return 0;
+  }
+  if (suite->num_results == BENCH_MAX_RESULTS) {
+    printf("Error, more than %d benchmarks\n", BENCH_MAX_RESULTS);
+    return ERR_BENCH_FULL;
+  }
+
+  int status = fn();
+  if (status != 0) {
+    printf("%-36s failed with %d\n", name, status);
+    return status;
+  }
+
+  // Double the number of calls until a repetition lasts BENCH_MIN_REP_NS. The calibration also warms up the caches
+  unsigned calls = 1;
+  while (time_calls(fn, calls) < BENCH_MIN_REP_NS && calls < (1u << 20)) {
+    calls <<= 1;
+  }
+  for (unsigned r = 0; r < suite->warmup; r++) {
+    time_calls(fn, calls);
+  }
+  double sum = 0;
+  for (unsigned r = 0; r < suite->reps; r++) {
+    samples[r] = time_calls(fn, calls) / calls;
+    sum += samples[r];
+  }
+  qsort(samples, suite->reps, sizeof(double), compare_doubles);
+
+  Bench_Result* result = &suite->results[suite->num_results++];
+  snprintf(result->name, BENCH_NAME_LEN, "%s", name);
+  snprintf(result->shape, BENCH_SHAPE_LEN, "%s", shape);
+  result->reps = suite->reps;
+  result->calls = calls;
+  result->min_ns = samples[0];
+  result->median_ns = (suite->reps & 1) ? samples[suite->reps / 2] :
+    (samples[suite->reps / 2 - 1] + samples[suite->reps / 2]) / 2;
+  result->mean_ns = sum / suite->reps;
+
+  // The tail is taken from single calls, as many as in the repetitions
+  unsigned long long total_calls = (unsigned long long)calls * suite->reps;
+  unsigned single_calls = total_calls < BENCH_MIN_SINGLE_CALLS ? BENCH_MIN_SINGLE_CALLS :
+    (total_calls > BENCH_MAX_SINGLE_CALLS ? BENCH_MAX_SINGLE_CALLS : (unsigned)total_calls);
+  for (unsigned c = 0; c < single_calls; c++) {
+    single_samples[c] = time_calls(fn, 1);
+  }
+  qsort(single_samples, single_calls, sizeof(double), compare_doubles);
+  result->single_calls = single_calls;
+  // Nearest-rank percentile
+  unsigned p99 = (99 * single_calls + 99) / 100;
+  result->p99_ns = single_samples[p99 - 1];
+  result->max_ns = single_samples[single_calls - 1];
+
+  printf("%-36s %-44s %8u %12.3f %12.3f %12.3f\n", result->name,
+    result->shape, calls, result->min_ns / 1e3, result->median_ns / 1e3,
+    result->p99_ns / 1e3);
+  fflush(stdout);
+  return 0;
+}
+
+static const char* simd_level_name(int level) {
+  switch (level) {
+    case Q_SIMD_SSE41: return "sse4.1";
+    case Q_SIMD_AVX2: return "avx2";
+    case Q_SIMD_NEON: return "neon";
+    default: return "none";
+  }
+}
+
+int bench_finish(const Bench_Suite* suite) {
+  if (suite->json_path == NULL) {
+    return 0;
+  }
+  FILE* file = fopen(suite->json_path, "w");
+  if (file == NULL) {
+    fprintf(stderr, "An error occured while opening %s\n", suite->json_path);
+    return ERR_BENCH_FILE;
+  }
+
+  fprintf(file, "{\n  \"suite\": \"%s\",\n  \"config\": {\n", suite->suite);
+  #ifdef __VERSION__
+    fprintf(file, "    \"compiler\": \"%s\",\n", __VERSION__);
+  #endif
+  fprintf(file, "    \"flags\": \"%s\",\n", build_flags + (build_flags[0] == ' '));
+  #ifdef SIMD
+    fprintf(file, "    \"simd_level\": \"%s\",\n", simd_level_name(q_simd_level()));
+  #else
+    fprintf(file, "    \"simd_level\": \"%s\",\n", simd_level_name(Q_SIMD_NONE));
+  #endif
+  fprintf(file, "    \"threads\": %u,\n    \"warmup\": %u,\n    \"min_rep_ns\": %d\n  },\n",
+    suite->threads, suite->warmup, BENCH_MIN_REP_NS);
+
+  fprintf(file, "  \"results\": [\n");
+  for (unsigned i = 0; i < suite->num_results; i++) {
+    const Bench_Result* r = &suite->results[i];
+    fprintf(file, "    {\"name\": \"%s\", \"shape\": \"%s\", \"reps\": %u, \"calls\": %u, \"single_calls\": %u, "
+      "\"min_ns\": %.1f, \"median_ns\": %.1f, \"p99_ns\": %.1f, \"mean_ns\": %.1f, \"max_ns\": %.1f}%s\n",
+      r->name, r->shape, r->reps, r->calls, r->single_calls, r->min_ns,
+      r->median_ns, r->p99_ns, r->mean_ns, r->max_ns,
+      (i + 1 < suite->num_results) ? "," : "");
+  }
+  fprintf(file, "  ]\n}\n");
+
+  if (fclose(file) != 0) {
+    return ERR_BENCH_FILE;
+  }
+  printf("Results written to %s\n", suite->json_path);
+  return 0;
+}
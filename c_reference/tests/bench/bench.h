@@ -0,0 +1,108 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#ifndef __BENCH_H__
+#define __BENCH_H__
+
+/* Benchmark harness for the kernels and the end-to-end models
+
+   Every benchmark is a function run without arguments on buffers set up beforehand. The function is first called
+   until it has run for BENCH_MIN_REP_NS, which sets the number of calls per repetition, so that the clock resolution
+   does not matter for the small kernels. Then it is run for the warm-up repetitions, whose timings are discarded,
+   and for the timed repetitions. The minimum, median and mean are the ones of the repetitions, i.e. of the mean time
+   of a call over a repetition.
+
+   A mean over many calls hides the slow ones, hence the 99th percentile and the maximum are the ones of single calls,
+   timed one by one after the repetitions. There are as many of them as calls in the repetitions, within
+   [BENCH_MIN_SINGLE_CALLS, BENCH_MAX_SINGLE_CALLS], so that the 99th percentile is never the maximum. The single calls
+   of the small kernels include the overhead of reading the clock (a few tens of ns).
+
+   The results are printed as a table and, with --json <file>, written as JSON along with the build configuration:
+   {"suite": ..., "config": {...}, "results": [{"name": ..., "shape": ..., "median_ns": ..., ...}, ...]}
+*/
+
+#define ERR_BENCH_ARGS -1
+#define ERR_BENCH_FULL -2
+#define ERR_BENCH_FILE -3
+
+#define BENCH_MAX_RESULTS 128
+#define BENCH_MAX_REPS 10000
+#define BENCH_MIN_SINGLE_CALLS 200
+#define BENCH_MAX_SINGLE_CALLS 10000
+#define BENCH_NAME_LEN 64
+#define BENCH_SHAPE_LEN 96
+// Minimum duration of a repetition, in ns
+#define BENCH_MIN_REP_NS 200000
+#define BENCH_DEFAULT_WARMUP 5
+#define BENCH_DEFAULT_REPS 50
+#define BENCH_DEFAULT_THREADS 4
+
+// A benchmark returns the return code of the benchmarked function, 0 for the functions without one
+typedef int (*bench_fn)(void);
+
+/**
+ * @brief Timings of one benchmark. The times are the ones of a single call, in ns
+ * @var   name           name of the benchmarked function
+ * @var   shape          shape of the inputs, as a free-form string
+ * @var   reps           number of timed repetitions
+ * @var   calls          number of calls per repetition
+ * @var   single_calls   number of calls timed one by one, for p99_ns and max_ns
+ */
+typedef struct Bench_Result {
+  char name[BENCH_NAME_LEN];
+  char shape[BENCH_SHAPE_LEN];
+  unsigned reps;
+  unsigned calls;
+  unsigned single_calls;
+  double min_ns;
+  double median_ns;
+  double p99_ns;
+  double mean_ns;
+  double max_ns;
+} Bench_Result;
+
+/**
+ * @brief Options and results of a run of benchmarks
+ * @var   suite       name of the suite, written in the JSON output
+ * @var   warmup      number of warm-up repetitions, set with --warmup
+ * @var   reps        number of timed repetitions, set with --reps
+ * @var   threads     number of threads of the multi-threaded variants, set with --threads
+ * @var   filter      only the benchmarks whose name contains filter are run, set with --filter. NULL runs all of them
+ * @var   json_path   path of the JSON output, set with --json. NULL for no JSON output
+ */
+typedef struct Bench_Suite {
+  const char* suite;
+  unsigned warmup;
+  unsigned reps;
+  unsigned threads;
+  const char* filter;
+  const char* json_path;
+  unsigned num_results;
+  Bench_Result results[BENCH_MAX_RESULTS];
+} Bench_Suite;
+
+/**
+ * @brief Parses the command line options: --reps <n> --warmup <n> --threads <n> --filter <substring> --json <file>
+ * @return     The function returns <code>0</code> on success, <code>ERR_BENCH_ARGS</code> on an unknown or invalid option
+ */
+int bench_init(Bench_Suite* suite, const char* name, int argc, char** argv);
+
+/**
+ * @brief Times fn and appends its result to the suite. Skipped (returning 0) if its name does not match the filter
+ * @return     The function returns <code>0</code> on success, <code>ERR_BENCH_FULL</code> if there are already BENCH_MAX_RESULTS results,
+ *             and the return code of fn if its first call fails
+ */
+int bench_run(Bench_Suite* suite, const char* name, const char* shape,
+  bench_fn fn);
+
+/**
+ * @brief Writes the results to suite->json_path, if set
+ * @return     The function returns <code>0</code> on success, <code>ERR_BENCH_FILE</code> if the file cannot be written
+ */
+int bench_finish(const Bench_Suite* suite);
+
+// Benchmarks of the quantized layers with the Wider Regression model, one file per model since their headers share names
+int bench_q_rnnpool(Bench_Suite* suite);
+int bench_q_mbconv(Bench_Suite* suite);
+
+#endif
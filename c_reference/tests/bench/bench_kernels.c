@@ -0,0 +1,441 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+#include "conv1d.h"
+#include "fastgrnn.h"
+#include "rnnpool.h"
+#include "rnn_bricked.h"
+#include "quantized_utils.h"
+#include "quantized_sparse_conv.h"
+
+/* Benchmarks of the kernels, on random weights and inputs of representative shapes
+   The float layers use the shapes of the KWS pipeline (64 channels over 128 time steps) and of the VWW RNNPool
+   The quantized convolutions use the shapes of the MBConv blocks of the face detection models
+   The quantized RNNPool and MBConv layers run with the Wider Regression model in bench_q_rnnpool.c and bench_q_mbconv.c
+*/
+
+// 1D convolutions
+#define CONV_TIME 128
+#define CONV_CHANNELS 64
+#define CONV_KERNEL 5
+#define CONV_PAD 2
+#define CONV_RANK 16
+#define CONV_POOL 3
+
+static float conv_input[CONV_TIME * CONV_CHANNELS];
+static float conv_output[CONV_TIME * CONV_CHANNELS];
+static float conv_W[CONV_CHANNELS * CONV_KERNEL * CONV_CHANNELS];
+static float conv_W1[CONV_CHANNELS * CONV_RANK];
+static float conv_W2[CONV_RANK * CONV_KERNEL * CONV_CHANNELS];
+static float conv_B[CONV_CHANNELS];
+static float conv_mean[CONV_CHANNELS], conv_var[CONV_CHANNELS];
+static float conv_gamma[CONV_CHANNELS], conv_beta[CONV_CHANNELS];
+
+static const ConvLayers_Params conv_params = { conv_W, conv_B, 0 };
+static const ConvLayers_Params conv_depth_params = { conv_W, conv_B, 1 };
+static const ConvLayers_LR_Params conv_lr_params = { conv_W1, conv_W2, conv_B, CONV_RANK };
+static ConvLayers_Parallel_Params conv_parallel_params = { conv_W, conv_B, 100, 1 };
+static ConvLayers_LR_Parallel_Params conv_lr_parallel_params = { conv_W1, conv_W2, conv_B, CONV_RANK, 100, 100, 1 };
+static const ConvLayers_Fused_Params conv_fused_params = { conv_W, 0, conv_B, 0, 0, 0 };
+
+// FastGRNN cells, with the hidden size of the KWS RNN
+#define RNN_STEPS 128
+#define RNN_INPUT 64
+#define RNN_HIDDEN 32
+#define RNN_RANK 16
+#define RNN_BATCH 8
+#define RNN_WINDOW 60
+#define RNN_HOP 3
+
+static float rnn_input[RNN_STEPS * RNN_INPUT];
+static float rnn_hidden[RNN_BATCH * RNN_HIDDEN];
+static float rnn_output[(RNN_STEPS / RNN_HOP + 1) * RNN_HIDDEN];
+static float rnn_W[RNN_HIDDEN * RNN_INPUT], rnn_U[RNN_HIDDEN * RNN_HIDDEN];
+static float rnn_W1[RNN_HIDDEN * RNN_RANK], rnn_W2[RNN_RANK * RNN_INPUT];
+static float rnn_U1[RNN_HIDDEN * RNN_RANK], rnn_U2[RNN_RANK * RNN_HIDDEN];
+static float rnn_Bg[RNN_HIDDEN], rnn_Bh[RNN_HIDDEN];
+static float rnn_preComp[RNN_BATCH * RNN_HIDDEN], rnn_tempLRW[RNN_RANK], rnn_tempLRU[RNN_RANK];
+static float rnn_normFeatures[RNN_BATCH * RNN_INPUT];
+
+static FastGRNN_Params rnn_params = { 0, 0, rnn_W, rnn_U, rnn_Bg, rnn_Bh, 1.0f, 0.0f };
+static FastGRNN_Buffers rnn_buffers = { rnn_preComp, rnn_normFeatures };
+static FastGRNN_LR_Params rnn_lr_params = {
+  0, 0, rnn_W1, rnn_W2, RNN_RANK, rnn_U1, rnn_U2, RNN_RANK, rnn_Bg, rnn_Bh, 1.0f, 0.0f
+};
+static FastGRNN_LR_Buffers rnn_lr_buffers = { rnn_preComp, rnn_tempLRW, rnn_tempLRU, rnn_normFeatures };
+static BrickedFastGRNN_LR_Params rnn_bricked_params = {
+  rnn_W1, rnn_W2, RNN_RANK, rnn_U1, rnn_U2, RNN_RANK, rnn_Bg, rnn_Bh, 1.0f, 0.0f,
+  100, 100, 100, 100, 1
+};
+
+// RNNPool, with the shape of the VWW model
+#define POOL_INPUT 4
+#define POOL_PATCH 8
+#define POOL_HIDDEN1 8
+#define POOL_HIDDEN2 8
+
+static float pool_patch[POOL_PATCH * POOL_PATCH * POOL_INPUT];
+static float pool_output[4 * POOL_HIDDEN2];
+static float pool_buffer[POOL_HIDDEN1 * POOL_PATCH];
+static float pool_W1[POOL_HIDDEN1 * POOL_INPUT], pool_U1[POOL_HIDDEN1 * POOL_HIDDEN1];
+static float pool_W2[POOL_HIDDEN2 * POOL_HIDDEN1], pool_U2[POOL_HIDDEN2 * POOL_HIDDEN2];
+static float pool_Bg1[POOL_HIDDEN1], pool_Bh1[POOL_HIDDEN1];
+static float pool_Bg2[POOL_HIDDEN2], pool_Bh2[POOL_HIDDEN2];
+static float pool_preComp1[POOL_HIDDEN1], pool_preComp1_batch[POOL_HIDDEN1 * POOL_PATCH];
+static float pool_preComp2[POOL_HIDDEN2];
+static float pool_normFeatures1[POOL_INPUT], pool_normFeatures2[POOL_HIDDEN1];
+
+static FastGRNN_Params pool_rnn1_params = { 0, 0, pool_W1, pool_U1, pool_Bg1, pool_Bh1, 1.0f, 0.0f };
+static FastGRNN_Params pool_rnn2_params = { 0, 0, pool_W2, pool_U2, pool_Bg2, pool_Bh2, 1.0f, 0.0f };
+static FastGRNN_Buffers pool_rnn1_buffers = { pool_preComp1, pool_normFeatures1 };
+static FastGRNN_Buffers pool_rnn1_batch_buffers = { pool_preComp1_batch, 0 };
+static FastGRNN_Buffers pool_rnn2_buffers = { pool_preComp2, pool_normFeatures2 };
+
+// Quantized kernels. The convolutions have the shapes of the MBConv blocks of the face detection models
+#define Q_VEC_LEN 1024
+#define Q_MAT_ROWS 64
+#define Q_MAT_COLS 64
+#define Q_CONV_H 30
+#define Q_CONV_W 40
+#define Q_CONV_CIN 32
+#define Q_CONV_CTEMP 64
+#define Q_CONV_COUT 32
+// One in Q_SPARSE_KEEP weights of the sparse filters is non-zero
+#define Q_SPARSE_KEEP 16
+
+static Q15_T q_vec[Q_VEC_LEN], q_vec_out[Q_VEC_LEN];
+static Q15_T q_mat[Q_MAT_ROWS * Q_MAT_COLS], q_mat_vec[Q_MAT_COLS], q_mat_out[Q_MAT_ROWS];
+static Q7_T q_mat_vec_q7[Q_MAT_COLS];
+static Q15_T q_conv_input[Q_CONV_H * Q_CONV_W * Q_CONV_CTEMP];
+static Q7_T q_conv_input_q7[Q_CONV_H * Q_CONV_W * Q_CONV_CTEMP];
+static Q15_T q_conv_output[Q_CONV_H * Q_CONV_W * Q_CONV_CTEMP];
+static Q7_T q_conv_output_q7[Q_CONV_H * Q_CONV_W * Q_CONV_CTEMP];
+static Q15_T q_conv_filter[3 * 3 * Q_CONV_CIN * Q_CONV_COUT];
+static Q15_T q_pointwise_filter[Q_CONV_CIN * Q_CONV_CTEMP];
+static Q15_T q_depthwise_filter[Q_CONV_CTEMP * 3 * 3];
+static Q15_T q_sparse_dense[Q_CONV_CIN * Q_CONV_CTEMP];
+static ITER_T q_sparse_row_ptr[Q_CONV_CTEMP + 1];
+static ITER_T q_sparse_col_idx[Q_CONV_CIN * Q_CONV_CTEMP];
+static Q15_T q_sparse_values[Q_CONV_CIN * Q_CONV_CTEMP];
+static Q15_Sparse_Filter q_sparse_filter;
+
+#ifdef SHIFT
+  #define Q_SCMAT 7
+  #define Q_SCVEC 6
+  #define Q_SCINPUT 2
+  #define Q_SCOUTPUT 2
+  #define Q_DEMOTE 3
+#else
+  #define Q_SCMAT 128
+  #define Q_SCVEC 64
+  #define Q_SCINPUT 4
+  #define Q_SCOUTPUT 4
+  #define Q_DEMOTE 8
+#endif
+
+static void fill_float(float* vec, unsigned len, float range) {
+  for (unsigned i = 0; i < len; i++) {
+    vec[i] = range * (2.0f * rand() / RAND_MAX - 1.0f);
+  }
+}
+
+static void fill_q15(Q15_T* vec, unsigned len, Q15_T range) {
+  for (unsigned i = 0; i < len; i++) {
+    vec[i] = (Q15_T)(rand() % (2 * range + 1) - range);
+  }
+}
+
+static void fill_q7(Q7_T* vec, unsigned len) {
+  for (unsigned i = 0; i < len; i++) {
+    vec[i] = (Q7_T)(rand() % 256 - 128);
+  }
+}
+
+static int setup(unsigned num_threads) {
+  srand(42);
+  fill_float(conv_input, CONV_TIME * CONV_CHANNELS, 1.0f);
+  fill_float(conv_W, CONV_CHANNELS * CONV_KERNEL * CONV_CHANNELS, 0.1f);
+  fill_float(conv_W1, CONV_CHANNELS * CONV_RANK, 0.3f);
+  fill_float(conv_W2, CONV_RANK * CONV_KERNEL * CONV_CHANNELS, 0.1f);
+  fill_float(conv_B, CONV_CHANNELS, 0.1f);
+  fill_float(conv_mean, CONV_CHANNELS, 0.1f);
+  fill_float(conv_gamma, CONV_CHANNELS, 1.0f);
+  fill_float(conv_beta, CONV_CHANNELS, 0.1f);
+  for (unsigned i = 0; i < CONV_CHANNELS; i++) {
+    conv_var[i] = 1.0f + 0.5f * rand() / RAND_MAX;
+  }
+  conv_parallel_params.num_threads = num_threads;
+  conv_lr_parallel_params.num_threads = num_threads;
+
+  fill_float(rnn_input, RNN_STEPS * RNN_INPUT, 1.0f);
+  fill_float(rnn_W, RNN_HIDDEN * RNN_INPUT, 0.1f);
+  fill_float(rnn_U, RNN_HIDDEN * RNN_HIDDEN, 0.1f);
+  fill_float(rnn_W1, RNN_HIDDEN * RNN_RANK, 0.3f);
+  fill_float(rnn_W2, RNN_RANK * RNN_INPUT, 0.1f);
+  fill_float(rnn_U1, RNN_HIDDEN * RNN_RANK, 0.3f);
+  fill_float(rnn_U2, RNN_RANK * RNN_HIDDEN, 0.1f);
+  fill_float(rnn_Bg, RNN_HIDDEN, 1.0f);
+  fill_float(rnn_Bh, RNN_HIDDEN, 1.0f);
+  rnn_bricked_params.num_threads = num_threads;
+
+  fill_float(pool_patch, POOL_PATCH * POOL_PATCH * POOL_INPUT, 1.0f);
+  fill_float(pool_W1, POOL_HIDDEN1 * POOL_INPUT, 0.3f);
+  fill_float(pool_U1, POOL_HIDDEN1 * POOL_HIDDEN1, 0.3f);
+  fill_float(pool_W2, POOL_HIDDEN2 * POOL_HIDDEN1, 0.3f);
+  fill_float(pool_U2, POOL_HIDDEN2 * POOL_HIDDEN2, 0.3f);
+  fill_float(pool_Bg1, POOL_HIDDEN1, 1.0f);
+  fill_float(pool_Bh1, POOL_HIDDEN1, 1.0f);
+  fill_float(pool_Bg2, POOL_HIDDEN2, 1.0f);
+  fill_float(pool_Bh2, POOL_HIDDEN2, 1.0f);
+
+  fill_q15(q_vec, Q_VEC_LEN, 8192);
+  fill_q15(q_mat, Q_MAT_ROWS * Q_MAT_COLS, 8192);
+  fill_q15(q_mat_vec, Q_MAT_COLS, 4096);
+  fill_q7(q_mat_vec_q7, Q_MAT_COLS);
+  fill_q15(q_conv_input, Q_CONV_H * Q_CONV_W * Q_CONV_CTEMP, 2048);
+  fill_q7(q_conv_input_q7, Q_CONV_H * Q_CONV_W * Q_CONV_CTEMP);
+  fill_q15(q_conv_filter, 3 * 3 * Q_CONV_CIN * Q_CONV_COUT, 8192);
+  fill_q15(q_pointwise_filter, Q_CONV_CIN * Q_CONV_CTEMP, 8192);
+  fill_q15(q_depthwise_filter, Q_CONV_CTEMP * 3 * 3, 8192);
+  for (unsigned i = 0; i < Q_CONV_CIN * Q_CONV_CTEMP; i++) {
+    q_sparse_dense[i] = (i % Q_SPARSE_KEEP == 0) ? q_pointwise_filter[i] : 0;
+  }
+  return q15_sparse_filter_pack(q_sparse_dense, 1, 1, Q_CONV_CIN, Q_CONV_CTEMP,
+    1, q_sparse_row_ptr, q_sparse_col_idx, q_sparse_values,
+    Q_CONV_CIN * Q_CONV_CTEMP, &q_sparse_filter);
+}
+
+static int run_conv1d(void) {
+  return conv1d(conv_output, CONV_TIME, CONV_CHANNELS, conv_input, CONV_TIME,
+    CONV_CHANNELS, CONV_PAD, CONV_KERNEL, &conv_params, 1, 2);
+}
+
+static int run_conv1d_depthwise(void) {
+  return conv1d(conv_output, CONV_TIME, CONV_CHANNELS, conv_input, CONV_TIME,
+    CONV_CHANNELS, CONV_PAD, CONV_KERNEL, &conv_depth_params, 1, 2);
+}
+
+static int run_conv1d_parallel(void) {
+  return conv1d_parallel(conv_output, CONV_TIME, CONV_CHANNELS, conv_input,
+    CONV_TIME, CONV_CHANNELS, CONV_PAD, CONV_KERNEL, &conv_parallel_params, 1, 2);
+}
+
+static int run_conv1d_im2col(void) {
+  return conv1d_im2col(conv_output, CONV_TIME, CONV_CHANNELS, conv_input, CONV_TIME,
+    CONV_CHANNELS, CONV_PAD, CONV_KERNEL, &conv_parallel_params, 1, 2);
+}
+
+static int run_conv1d_auto(void) {
+  return conv1d_auto(conv_output, CONV_TIME, CONV_CHANNELS, conv_input, CONV_TIME,
+    CONV_CHANNELS, CONV_PAD, CONV_KERNEL, &conv_parallel_params, 1, 2);
+}
+
+static int run_conv1d_lr(void) {
+  return conv1d_lr(conv_output, CONV_TIME, CONV_CHANNELS, conv_input, CONV_TIME,
+    CONV_CHANNELS, CONV_PAD, CONV_KERNEL, &conv_lr_params, 1, 2);
+}
+
+static int run_conv1d_lr_parallel(void) {
+  return conv1d_lr_parallel(conv_output, CONV_TIME, CONV_CHANNELS, conv_input,
+    CONV_TIME, CONV_CHANNELS, CONV_PAD, CONV_KERNEL, &conv_lr_parallel_params,
+    1, 2);
+}
+
+static int run_conv1d_fused(void) {
+  return conv1d_fused(conv_output, CONV_TIME, CONV_CHANNELS, conv_input, CONV_TIME,
+    CONV_CHANNELS, CONV_PAD, CONV_KERNEL, &conv_fused_params, 1, 3,
+    CONV_POOL / 2, CONV_POOL, 1, 2);
+}
+
+static int run_avgpool1d(void) {
+  return avgpool1d(conv_output, CONV_TIME, conv_input, CONV_TIME, CONV_CHANNELS,
+    CONV_POOL / 2, CONV_POOL, 1, 0);
+}
+
+static int run_batchnorm1d(void) {
+  return batchnorm1d(conv_output, conv_input, CONV_TIME, CONV_CHANNELS, conv_mean,
+    conv_var, 1, conv_gamma, conv_beta, 0, 0.00001f);
+}
+
+static int run_fastgrnn(void) {
+  return fastgrnn(rnn_hidden, RNN_HIDDEN, rnn_input, RNN_INPUT, RNN_STEPS,
+    &rnn_params, &rnn_buffers, 0, 0);
+}
+
+static int run_fastgrnn_lr(void) {
+  return fastgrnn_lr(rnn_hidden, RNN_HIDDEN, rnn_input, RNN_INPUT, RNN_STEPS,
+    &rnn_lr_params, &rnn_lr_buffers, 0, 0);
+}
+
+static int run_fastgrnn_batch(void) {
+  return fastgrnn_batch(rnn_hidden, RNN_HIDDEN, rnn_input, RNN_INPUT, RNN_INPUT,
+    RNN_BATCH, &rnn_params, &rnn_buffers, 0);
+}
+
+static int run_forward_bricked_fastgrnn_lr(void) {
+  return forward_bricked_fastgrnn_lr(rnn_output, RNN_HIDDEN, rnn_input, RNN_STEPS,
+    RNN_INPUT, RNN_WINDOW, RNN_HOP, &rnn_bricked_params, 0, 1);
+}
+
+static int run_rnnpool_block(void) {
+  return rnnpool_block(pool_patch, POOL_INPUT, POOL_PATCH, POOL_PATCH, fastgrnn,
+    POOL_HIDDEN1, &pool_rnn1_params, &pool_rnn1_buffers, fastgrnn_batch,
+    &pool_rnn1_batch_buffers, fastgrnn, POOL_HIDDEN2, &pool_rnn2_params,
+    &pool_rnn2_buffers, pool_output, pool_buffer);
+}
+
+static int run_q15_v_add(void) {
+  q15_v_add(q_vec, q_vec, Q_VEC_LEN, q_vec_out, 1, 1, 1, 1);
+  return 0;
+}
+
+static int run_q15_v_sigmoid_hard(void) {
+  q15_v_sigmoid(q_vec, Q_VEC_LEN, q_vec_out, 2, 1024, 2048, 11, 14,
+    Q_ACTIVATION_HARD);
+  return 0;
+}
+
+static int run_q15_v_sigmoid_exp_tables(void) {
+  q15_v_sigmoid(q_vec, Q_VEC_LEN, q_vec_out, 2, 1024, 2048, 11, 14,
+    Q_ACTIVATION_EXP_TABLES);
+  return 0;
+}
+
+static int run_q15_v_sigmoid_lut(void) {
+  q15_v_sigmoid_lut(q_vec, Q_VEC_LEN, q_vec_out);
+  return 0;
+}
+
+static int run_q15_v_tanh_hard(void) {
+  q15_v_tanh(q_vec, Q_VEC_LEN, q_vec_out, 11, 11, Q_ACTIVATION_HARD);
+  return 0;
+}
+
+static int run_q15_v_tanh_exp_tables(void) {
+  q15_v_tanh(q_vec, Q_VEC_LEN, q_vec_out, 11, 14, Q_ACTIVATION_EXP_TABLES);
+  return 0;
+}
+
+static int run_q15_v_tanh_lut(void) {
+  q15_v_tanh_lut(q_vec, Q_VEC_LEN, q_vec_out);
+  return 0;
+}
+
+static int run_q15_m_mulvec(void) {
+  q15_m_mulvec(q_mat, q_mat_vec, Q_MAT_ROWS, Q_MAT_COLS, q_mat_out, Q_SCMAT,
+    Q_SCVEC, 6, 0);
+  return 0;
+}
+
+static int run_q15xq7_q15_m_mulvec(void) {
+  q15xq7_q15_m_mulvec(q_mat, q_mat_vec_q7, Q_MAT_ROWS, Q_MAT_COLS, q_mat_out,
+    Q_SCMAT, Q_SCVEC, 6, 0);
+  return 0;
+}
+
+static int run_q15_convolution_3x3(void) {
+  q15_convolution(q_conv_input, q_conv_filter, q_conv_output, 1, Q_CONV_H,
+    Q_CONV_W, Q_CONV_CIN, 3, 3, Q_CONV_CIN, Q_CONV_COUT, Q_CONV_H, Q_CONV_W, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, Q_SCINPUT, Q_SCOUTPUT, Q_DEMOTE);
+  return 0;
+}
+
+static int run_q7xq15_q7_convolution_3x3(void) {
+  q7xq15_q7_convolution(q_conv_input_q7, q_conv_filter, q_conv_output_q7, 1,
+    Q_CONV_H, Q_CONV_W, Q_CONV_CIN, 3, 3, Q_CONV_CIN, Q_CONV_COUT, Q_CONV_H,
+    Q_CONV_W, 1, 1, 1, 1, 1, 1, 1, 1, 1, Q_SCINPUT, Q_SCOUTPUT, Q_DEMOTE);
+  return 0;
+}
+
+static int run_q15_convolution_pointwise(void) {
+  q15_convolution(q_conv_input, q_pointwise_filter, q_conv_output, 1, Q_CONV_H,
+    Q_CONV_W, Q_CONV_CIN, 1, 1, Q_CONV_CIN, Q_CONV_CTEMP, Q_CONV_H, Q_CONV_W, 1,
+    0, 0, 0, 0, 1, 1, 1, 1, Q_SCINPUT, Q_SCOUTPUT, Q_DEMOTE);
+  return 0;
+}
+
+static int run_q15_convolution_depthwise(void) {
+  q15_convolution(q_conv_input, q_depthwise_filter, q_conv_output, 1, Q_CONV_H,
+    Q_CONV_W, Q_CONV_CTEMP, 3, 3, 1, 1, Q_CONV_H, Q_CONV_W, Q_CONV_CTEMP, 1, 1,
+    1, 1, 1, 1, 1, 1, Q_SCINPUT, Q_SCOUTPUT, Q_DEMOTE);
+  return 0;
+}
+
+static int run_q15_sparse_convolution_pointwise(void) {
+  q15_sparse_convolution(q_conv_input, &q_sparse_filter, q_conv_output, 1,
+    Q_CONV_H, Q_CONV_W, Q_CONV_CIN, Q_CONV_H, Q_CONV_W, 0, 0, 0, 0, 1, 1, 1, 1,
+    Q_SCINPUT, Q_SCOUTPUT, Q_DEMOTE);
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  static Bench_Suite suite;
+  char shape[BENCH_SHAPE_LEN];
+  int ret = 0;
+
+  if (bench_init(&suite, "kernels", argc, argv) || setup(suite.threads)) {
+    return -1;
+  }
+
+  snprintf(shape, BENCH_SHAPE_LEN, "T=%d C=%d->%d K=%d", CONV_TIME, CONV_CHANNELS, CONV_CHANNELS, CONV_KERNEL);
+  ret |= bench_run(&suite, "conv1d", shape, run_conv1d);
+  ret |= bench_run(&suite, "conv1d_depthwise", shape, run_conv1d_depthwise);
+  ret |= bench_run(&suite, "conv1d_im2col", shape, run_conv1d_im2col);
+  ret |= bench_run(&suite, "conv1d_auto", shape, run_conv1d_auto);
+  snprintf(shape, BENCH_SHAPE_LEN, "T=%d C=%d->%d K=%d threads=%u", CONV_TIME, CONV_CHANNELS, CONV_CHANNELS, CONV_KERNEL, suite.threads);
+  ret |= bench_run(&suite, "conv1d_parallel", shape, run_conv1d_parallel);
+  snprintf(shape, BENCH_SHAPE_LEN, "T=%d C=%d->%d K=%d rank=%d", CONV_TIME, CONV_CHANNELS, CONV_CHANNELS, CONV_KERNEL, CONV_RANK);
+  ret |= bench_run(&suite, "conv1d_lr", shape, run_conv1d_lr);
+  snprintf(shape, BENCH_SHAPE_LEN, "T=%d C=%d->%d K=%d rank=%d threads=%u", CONV_TIME, CONV_CHANNELS, CONV_CHANNELS, CONV_KERNEL, CONV_RANK, suite.threads);
+  ret |= bench_run(&suite, "conv1d_lr_parallel", shape, run_conv1d_lr_parallel);
+  snprintf(shape, BENCH_SHAPE_LEN, "T=%d C=%d->%d K=%d pool=%d", CONV_TIME, CONV_CHANNELS, CONV_CHANNELS, CONV_KERNEL, CONV_POOL);
+  ret |= bench_run(&suite, "conv1d_fused", shape, run_conv1d_fused);
+  snprintf(shape, BENCH_SHAPE_LEN, "T=%d C=%d K=%d", CONV_TIME, CONV_CHANNELS, CONV_POOL);
+  ret |= bench_run(&suite, "avgpool1d", shape, run_avgpool1d);
+  snprintf(shape, BENCH_SHAPE_LEN, "T=%d C=%d", CONV_TIME, CONV_CHANNELS);
+  ret |= bench_run(&suite, "batchnorm1d", shape, run_batchnorm1d);
+
+  snprintf(shape, BENCH_SHAPE_LEN, "steps=%d in=%d hidden=%d", RNN_STEPS, RNN_INPUT, RNN_HIDDEN);
+  ret |= bench_run(&suite, "fastgrnn", shape, run_fastgrnn);
+  snprintf(shape, BENCH_SHAPE_LEN, "steps=%d in=%d hidden=%d rank=%d", RNN_STEPS, RNN_INPUT, RNN_HIDDEN, RNN_RANK);
+  ret |= bench_run(&suite, "fastgrnn_lr", shape, run_fastgrnn_lr);
+  snprintf(shape, BENCH_SHAPE_LEN, "batch=%d in=%d hidden=%d", RNN_BATCH, RNN_INPUT, RNN_HIDDEN);
+  ret |= bench_run(&suite, "fastgrnn_batch", shape, run_fastgrnn_batch);
+  snprintf(shape, BENCH_SHAPE_LEN, "T=%d in=%d hidden=%d window=%d hop=%d", RNN_STEPS, RNN_INPUT, RNN_HIDDEN, RNN_WINDOW, RNN_HOP);
+  ret |= bench_run(&suite, "forward_bricked_fastgrnn_lr", shape, run_forward_bricked_fastgrnn_lr);
+  snprintf(shape, BENCH_SHAPE_LEN, "patch=%dx%dx%d hidden=%d,%d", POOL_PATCH, POOL_PATCH, POOL_INPUT, POOL_HIDDEN1, POOL_HIDDEN2);
+  ret |= bench_run(&suite, "rnnpool_block", shape, run_rnnpool_block);
+
+  snprintf(shape, BENCH_SHAPE_LEN, "len=%d", Q_VEC_LEN);
+  ret |= bench_run(&suite, "q15_v_add", shape, run_q15_v_add);
+  ret |= bench_run(&suite, "q15_v_sigmoid_hard", shape, run_q15_v_sigmoid_hard);
+  ret |= bench_run(&suite, "q15_v_sigmoid_exp_tables", shape, run_q15_v_sigmoid_exp_tables);
+  ret |= bench_run(&suite, "q15_v_sigmoid_lut", shape, run_q15_v_sigmoid_lut);
+  ret |= bench_run(&suite, "q15_v_tanh_hard", shape, run_q15_v_tanh_hard);
+  ret |= bench_run(&suite, "q15_v_tanh_exp_tables", shape, run_q15_v_tanh_exp_tables);
+  ret |= bench_run(&suite, "q15_v_tanh_lut", shape, run_q15_v_tanh_lut);
+  snprintf(shape, BENCH_SHAPE_LEN, "%dx%d", Q_MAT_ROWS, Q_MAT_COLS);
+  ret |= bench_run(&suite, "q15_m_mulvec", shape, run_q15_m_mulvec);
+  ret |= bench_run(&suite, "q15xq7_q15_m_mulvec", shape, run_q15xq7_q15_m_mulvec);
+  snprintf(shape, BENCH_SHAPE_LEN, "%dx%dx%d->%d F=3x3", Q_CONV_H, Q_CONV_W, Q_CONV_CIN, Q_CONV_COUT);
+  ret |= bench_run(&suite, "q15_convolution", shape, run_q15_convolution_3x3);
+  ret |= bench_run(&suite, "q7xq15_q7_convolution", shape, run_q7xq15_q7_convolution_3x3);
+  snprintf(shape, BENCH_SHAPE_LEN, "%dx%dx%d->%d F=1x1", Q_CONV_H, Q_CONV_W, Q_CONV_CIN, Q_CONV_CTEMP);
+  ret |= bench_run(&suite, "q15_convolution_pointwise", shape, run_q15_convolution_pointwise);
+  snprintf(shape, BENCH_SHAPE_LEN, "%dx%dx%d->%d F=1x1 density=1/%d", Q_CONV_H, Q_CONV_W, Q_CONV_CIN, Q_CONV_CTEMP, Q_SPARSE_KEEP);
+  ret |= bench_run(&suite, "q15_sparse_convolution_pointwise", shape, run_q15_sparse_convolution_pointwise);
+  snprintf(shape, BENCH_SHAPE_LEN, "%dx%dx%d F=3x3 depthwise", Q_CONV_H, Q_CONV_W, Q_CONV_CTEMP);
+  ret |= bench_run(&suite, "q15_convolution_depthwise", shape, run_q15_convolution_depthwise);
+
+  ret |= bench_q_rnnpool(&suite);
+  ret |= bench_q_mbconv(&suite);
+
+  if (ret) {
+    return -1;
+  }
+  return bench_finish(&suite);
+}
@@ -0,0 +1,155 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+#include "quantized_face_detection.h"
+#include "quantized_face_detection_fast.h"
+#include "quantized_face_detection_sparse.h"
+
+#include "../kws/keyword_spotting_io_2.h"
+#include "../kws/phoneme_det_cnn_rnn.h"
+
+/* End-to-end benchmarks of the models: the three face detection models on a random 240x320 image
+   and the KWS phoneme detection pipeline on the input of the KWS test
+   The models overwrite their memory buffer, hence every call after the first one runs on the intermediate values
+   of the previous call instead of the image. The amount of computation does not depend on the values
+*/
+
+#define FACE_DETECTION_INPUT_SIZE (240 * 320)
+
+static char* face_buf;
+static char* face_batch_buf;
+static char* face_scratch_buf;
+static char* kws_arena;
+static MemPlan_Tensor kws_plan[NUM_TENSORS];
+static unsigned num_threads;
+
+static void fill_image(char* buf, unsigned num_frames, unsigned buf_size) {
+  for (unsigned f = 0; f < num_frames; f++) {
+    for (unsigned i = 0; i < FACE_DETECTION_INPUT_SIZE; i++) {
+      buf[f * buf_size + i] = (char)(rand() % 256 - 128);
+    }
+  }
+}
+
+static int run_q_face_detection(void) {
+  q_face_detection(face_buf);
+  return 0;
+}
+
+static int run_q_face_detection_threaded(void) {
+  q_face_detection_threaded(face_buf, face_scratch_buf, num_threads);
+  return 0;
+}
+
+static int run_q_face_detection_batch(void) {
+  q_face_detection_batch(face_batch_buf, face_scratch_buf, num_threads,
+    num_threads);
+  return 0;
+}
+
+static int run_q_face_detection_fast(void) {
+  q_face_detection_fast(face_buf);
+  return 0;
+}
+
+static int run_q_face_detection_fast_threaded(void) {
+  q_face_detection_fast_threaded(face_buf, face_scratch_buf, num_threads);
+  return 0;
+}
+
+static int run_q_face_detection_fast_batch(void) {
+  q_face_detection_fast_batch(face_batch_buf, face_scratch_buf, num_threads,
+    num_threads);
+  return 0;
+}
+
+static int run_q_face_detection_sparse(void) {
+  q_face_detection_sparse(face_buf);
+  return 0;
+}
+
+static int run_q_face_detection_sparse_threaded(void) {
+  q_face_detection_sparse_threaded(face_buf, face_scratch_buf, num_threads);
+  return 0;
+}
+
+static int run_q_face_detection_sparse_batch(void) {
+  q_face_detection_sparse_batch(face_batch_buf, face_scratch_buf, num_threads,
+    num_threads);
+  return 0;
+}
+
+static int run_phoneme_prediction(void) {
+  phoneme_prediction(INPUT, KWS_IN_TIME, kws_arena, kws_plan);
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  static Bench_Suite suite;
+  char shape[BENCH_SHAPE_LEN];
+  unsigned peak;
+  int ret = 0;
+
+  if (bench_init(&suite, "models", argc, argv)) {
+    return -1;
+  }
+  num_threads = suite.threads;
+  if (plan_phoneme_prediction(kws_plan, KWS_IN_TIME, &peak)) {
+    printf("Error, static memory plan could not be computed\n");
+    return -1;
+  }
+  face_buf = (char*)malloc(FACE_DETECTION_MEM_BUF_SIZE);
+  face_batch_buf = (char*)malloc((size_t)num_threads * FACE_DETECTION_MEM_BUF_SIZE);
+  // The scratch buffer of the threads after the first, shared by the models
+  unsigned scratch_size = q_face_detection_scratch_size(num_threads);
+  if (q_face_detection_fast_scratch_size(num_threads) > scratch_size) {
+    scratch_size = q_face_detection_fast_scratch_size(num_threads);
+  }
+  if (q_face_detection_sparse_scratch_size(num_threads) > scratch_size) {
+    scratch_size = q_face_detection_sparse_scratch_size(num_threads);
+  }
+  face_scratch_buf = (char*)malloc(scratch_size);
+  kws_arena = (char*)malloc(peak);
+  if (face_buf == NULL || face_batch_buf == NULL ||
+      (face_scratch_buf == NULL && scratch_size > 0) || kws_arena == NULL) {
+    printf("Error, the memory buffers could not be allocated\n");
+    return -1;
+  }
+
+  // The buffers of the largest model fit the other two. All the models read a 240x320 Q7 image at byte 0
+  srand(42);
+  fill_image(face_buf, 1, FACE_DETECTION_MEM_BUF_SIZE);
+  fill_image(face_batch_buf, num_threads, FACE_DETECTION_MEM_BUF_SIZE);
+  snprintf(shape, BENCH_SHAPE_LEN, "240x320");
+  ret |= bench_run(&suite, "q_face_detection", shape, run_q_face_detection);
+  ret |= bench_run(&suite, "q_face_detection_fast", shape, run_q_face_detection_fast);
+  ret |= bench_run(&suite, "q_face_detection_sparse", shape, run_q_face_detection_sparse);
+  snprintf(shape, BENCH_SHAPE_LEN, "240x320 threads=%u", num_threads);
+  ret |= bench_run(&suite, "q_face_detection_threaded", shape, run_q_face_detection_threaded);
+  ret |= bench_run(&suite, "q_face_detection_fast_threaded", shape, run_q_face_detection_fast_threaded);
+  ret |= bench_run(&suite, "q_face_detection_sparse_threaded", shape, run_q_face_detection_sparse_threaded);
+
+  // The fast model uses a smaller buffer per frame
+  fill_image(face_batch_buf, num_threads, FACE_DETECTION_FAST_MEM_BUF_SIZE);
+  snprintf(shape, BENCH_SHAPE_LEN, "240x320 frames=%u threads=%u", num_threads, num_threads);
+  ret |= bench_run(&suite, "q_face_detection_fast_batch", shape, run_q_face_detection_fast_batch);
+  fill_image(face_batch_buf, num_threads, FACE_DETECTION_MEM_BUF_SIZE);
+  ret |= bench_run(&suite, "q_face_detection_batch", shape, run_q_face_detection_batch);
+  ret |= bench_run(&suite, "q_face_detection_sparse_batch", shape, run_q_face_detection_sparse_batch);
+
+  snprintf(shape, BENCH_SHAPE_LEN, "T=%d features=%u", KWS_IN_TIME, phoneme_in_features);
+  ret |= bench_run(&suite, "phoneme_prediction", shape, run_phoneme_prediction);
+
+  free(face_buf);
+  free(face_batch_buf);
+  free(face_scratch_buf);
+  free(kws_arena);
+  if (ret) {
+    return -1;
+  }
+  return bench_finish(&suite);
+}
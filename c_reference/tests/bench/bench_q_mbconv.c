@@ -0,0 +1,110 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+#include "quantized_mbconv.h"
+#include "quantized_sparse_conv.h"
+
+#include "../mbconv/q_wider_regression_model/mbconv.h"
+
+// The MBConv block of the Wider Regression model. The sparse block runs on its filters pruned to one in SPARSE_KEEP weights
+#define SPARSE_KEEP 16
+
+static Q15_T input[N * H * W * CIN];
+static Q7_T input_q7[N * H * W * CIN];
+static Q15_T output[N * HOUT * WOUT * COUT];
+static Q15_T buffer1[HF * W * CTEMP], buffer2[CTEMP];
+static Q15_T* band_buffers;
+static size_t band_buffers_size;
+static unsigned num_threads;
+
+static Q15_T sparse_F1[CIN * CTEMP], sparse_F2[CTEMP * HF * WF], sparse_F3[CTEMP * COUT];
+static ITER_T row_ptr[3][CTEMP + COUT + 1];
+static ITER_T col_idx[3][CIN * CTEMP + CTEMP * COUT];
+static Q15_T values[3][CIN * CTEMP + CTEMP * COUT];
+static Q15_Sparse_Filter filters[3];
+
+static int pack_filters(void) {
+  for (unsigned i = 0; i < CIN * CTEMP; i++) {
+    sparse_F1[i] = (i % SPARSE_KEEP == 0) ? F1[i] : 0;
+  }
+  for (unsigned i = 0; i < CTEMP * HF * WF; i++) {
+    sparse_F2[i] = (i % SPARSE_KEEP == 0) ? F2[i] : 0;
+  }
+  for (unsigned i = 0; i < CTEMP * COUT; i++) {
+    sparse_F3[i] = (i % SPARSE_KEEP == 0) ? F3[i] : 0;
+  }
+  return q15_sparse_filter_pack(sparse_F1, 1, 1, CIN, CTEMP, 1, row_ptr[0], col_idx[0], values[0], CIN * CTEMP, &filters[0]) ||
+         q15_sparse_filter_pack(sparse_F2, HF, WF, 1, 1, CTEMP, row_ptr[1], col_idx[1], values[1], CTEMP * HF * WF, &filters[1]) ||
+         q15_sparse_filter_pack(sparse_F3, 1, 1, CTEMP, COUT, 1, row_ptr[2], col_idx[2], values[2], CTEMP * COUT, &filters[2]);
+}
+
+static int run_q15_mbconv_block(void) {
+  q15_mbconv_block(input, F1, W1, B1, F2, W2, B2, F3, W3, B3, output, buffer1,
+    buffer2, N, H, W, CIN, CTEMP, HF, WF, COUT, HOUT, WOUT, HPADL, HPADR, WPADL,
+    WPADR, HSTRIDE, WSTRIDE, Limit1, Limit2, ShRU1, ShRX1, ShRU2, ShRX2, ShRU3,
+    ShRW3, ShLU1, ShLX1, ShLU2, ShLX2, ShLU3, ShLW3);
+  return 0;
+}
+
+static int run_q7xq15_q15_mbconv_block(void) {
+  q7xq15_q15_mbconv_block(input_q7, F1, W1, B1, F2, W2, B2, F3, W3, B3, output,
+    buffer1, buffer2, N, H, W, CIN, CTEMP, HF, WF, COUT, HOUT, WOUT, HPADL,
+    HPADR, WPADL, WPADR, HSTRIDE, WSTRIDE, Limit1, Limit2, ShRU1, ShRX1, ShRU2,
+    ShRX2, ShRU3, ShRW3, ShLU1, ShLX1, ShLU2, ShLX2, ShLU3, ShLW3);
+  return 0;
+}
+
+static int run_q15_mbconv_block_threaded(void) {
+  q15_mbconv_block_threaded(input, F1, W1, B1, F2, W2, B2, F3, W3, B3, output,
+    buffer1, buffer2, N, H, W, CIN, CTEMP, HF, WF, COUT, HOUT, WOUT, HPADL,
+    HPADR, WPADL, WPADR, HSTRIDE, WSTRIDE, Limit1, Limit2, ShRU1, ShRX1, ShRU2,
+    ShRX2, ShRU3, ShRW3, ShLU1, ShLX1, ShLU2, ShLX2, ShLU3, ShLW3, band_buffers,
+    band_buffers_size, num_threads);
+  return 0;
+}
+
+static int run_q15_sparse_mbconv_block(void) {
+  q15_sparse_mbconv_block(input, &filters[0], W1, B1, &filters[1], W2, B2,
+    &filters[2], W3, B3, output, buffer1, buffer2, N, H, W, CIN, CTEMP, HF, WF,
+    COUT, HOUT, WOUT, HPADL, HPADR, WPADL, WPADR, HSTRIDE, WSTRIDE, Limit1,
+    Limit2, ShRU1, ShRX1, ShRU2, ShRX2, ShRU3, ShRW3, ShLU1, ShLX1, ShLU2,
+    ShLX2, ShLU3, ShLW3);
+  return 0;
+}
+
+int bench_q_mbconv(Bench_Suite* suite) {
+  char shape[BENCH_SHAPE_LEN];
+  int ret = 0;
+
+  srand(11);
+  for (unsigned i = 0; i < N * H * W * CIN; i++) {
+    input[i] = (Q15_T)(rand() % 4097 - 2048);
+    input_q7[i] = (Q7_T)(rand() % 256 - 128);
+  }
+  if (pack_filters()) {
+    printf("Error, the sparse MBConv filters could not be packed\n");
+    return ERR_BENCH_ARGS;
+  }
+  num_threads = suite->threads;
+  // The buffers of the bands after the first, allocated once for all the calls
+  band_buffers_size = (num_threads > 1 ? num_threads - 1 : 0) * (HF * W * CTEMP + CTEMP) * sizeof(Q15_T);
+  band_buffers = (Q15_T*)malloc(band_buffers_size ? band_buffers_size : 1);
+  if (band_buffers == NULL) {
+    printf("Error, could not allocate the buffers of the MBConv bands\n");
+    return ERR_BENCH_ARGS;
+  }
+
+  snprintf(shape, BENCH_SHAPE_LEN, "%dx%dx%d->%d->%dx%dx%d F=%dx%d", H, W, CIN, CTEMP, HOUT, WOUT, COUT, HF, WF);
+  ret |= bench_run(suite, "q15_mbconv_block", shape, run_q15_mbconv_block);
+  ret |= bench_run(suite, "q7xq15_q15_mbconv_block", shape, run_q7xq15_q15_mbconv_block);
+  snprintf(shape, BENCH_SHAPE_LEN, "%dx%dx%d->%d->%dx%dx%d F=%dx%d threads=%u", H, W, CIN, CTEMP, HOUT, WOUT, COUT, HF, WF, num_threads);
+  ret |= bench_run(suite, "q15_mbconv_block_threaded", shape, run_q15_mbconv_block_threaded);
+  snprintf(shape, BENCH_SHAPE_LEN, "%dx%dx%d->%d->%dx%dx%d F=%dx%d density=1/%d", H, W, CIN, CTEMP, HOUT, WOUT, COUT, HF, WF, SPARSE_KEEP);
+  ret |= bench_run(suite, "q15_sparse_mbconv_block", shape, run_q15_sparse_mbconv_block);
+  free(band_buffers);
+  return ret;
+}
@@ -0,0 +1,84 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+#include "quantized_fastgrnn.h"
+#include "quantized_rnnpool.h"
+
+#include "../rnnpool/q_wider_regression_model/rnn1.h"
+#include "../rnnpool/q_wider_regression_model/rnn2.h"
+
+// The FastGRNN cells and the RNNPool block of the Wider Regression model, on one 8x8 patch
+static Q15_T patch[PATCH_DIM * PATCH_DIM * INPUT_CHANNELS];
+static Q15_T hidden1[PATCH_DIM * HIDDEN_DIM1];
+static Q15_T hidden2[HIDDEN_DIM2];
+static Q15_T output[4 * HIDDEN_DIM2];
+static Q15_T buffer[HIDDEN_DIM1 * PATCH_DIM];
+
+static Q15_T normFeatures_batch[INPUT_CHANNELS * PATCH_DIM];
+static Q15_T preComp1_batch[HIDDEN_DIM1 * PATCH_DIM];
+static Q15_T preComp2_batch[HIDDEN_DIM1 * PATCH_DIM];
+static Q15_T preComp3_batch[HIDDEN_DIM1 * PATCH_DIM];
+static Q15_FastGRNN_Buffers rnn1_batch_buffers = {
+  .preComp1 = preComp1_batch,
+  .preComp2 = preComp2_batch,
+  .preComp3 = preComp3_batch,
+  .normFeatures = normFeatures_batch
+};
+
+static int run_q15_fastgrnn(void) {
+  return q15_fastgrnn(hidden1, HIDDEN_DIM1, patch, INPUT_CHANNELS, PATCH_DIM,
+    &rnn1_params, &rnn1_buffers, &rnn1_scales, 0, 0);
+}
+
+static int run_q15_fastgrnn_batch(void) {
+  return q15_fastgrnn_batch(hidden1, HIDDEN_DIM1, patch, INPUT_CHANNELS,
+    INPUT_CHANNELS * PATCH_DIM, PATCH_DIM, &rnn1_params, &rnn1_batch_buffers,
+    &rnn1_scales, 0);
+}
+
+static int run_q15_fastgrnn_backward(void) {
+  return q15_fastgrnn(hidden2, HIDDEN_DIM2, hidden1, HIDDEN_DIM1, PATCH_DIM,
+    &rnn2_params, &rnn2_buffers, &rnn2_scales, 1, 0);
+}
+
+static int run_q15_rnnpool_block(void) {
+  return q15_rnnpool_block(patch, INPUT_CHANNELS, PATCH_DIM, PATCH_DIM, q15_fastgrnn,
+    HIDDEN_DIM1, &rnn1_params, &rnn1_buffers, &rnn1_scales, q15_fastgrnn_batch,
+    &rnn1_batch_buffers, q15_fastgrnn, HIDDEN_DIM2, &rnn2_params,
+    &rnn2_buffers, &rnn2_scales, output, buffer, ShR1, ShL1, ShR2, ShL2);
+}
+
+static int run_q15_rnnpool_block_unbatched(void) {
+  return q15_rnnpool_block(patch, INPUT_CHANNELS, PATCH_DIM, PATCH_DIM, q15_fastgrnn,
+    HIDDEN_DIM1, &rnn1_params, &rnn1_buffers, &rnn1_scales, NULL, NULL,
+    q15_fastgrnn, HIDDEN_DIM2, &rnn2_params, &rnn2_buffers, &rnn2_scales,
+    output, buffer, ShR1, ShL1, ShR2, ShL2);
+}
+
+int bench_q_rnnpool(Bench_Suite* suite) {
+  char shape[BENCH_SHAPE_LEN];
+  int ret = 0;
+
+  srand(7);
+  for (unsigned i = 0; i < PATCH_DIM * PATCH_DIM * INPUT_CHANNELS; i++) {
+    patch[i] = (Q15_T)(rand() % 4097 - 2048);
+  }
+  for (unsigned i = 0; i < PATCH_DIM * HIDDEN_DIM1; i++) {
+    hidden1[i] = (Q15_T)(rand() % 4097 - 2048);
+  }
+
+  snprintf(shape, BENCH_SHAPE_LEN, "steps=%d in=%d hidden=%d", PATCH_DIM, INPUT_CHANNELS, HIDDEN_DIM1);
+  ret |= bench_run(suite, "q15_fastgrnn", shape, run_q15_fastgrnn);
+  snprintf(shape, BENCH_SHAPE_LEN, "batch=%d in=%d hidden=%d", PATCH_DIM, INPUT_CHANNELS, HIDDEN_DIM1);
+  ret |= bench_run(suite, "q15_fastgrnn_batch", shape, run_q15_fastgrnn_batch);
+  snprintf(shape, BENCH_SHAPE_LEN, "steps=%d in=%d hidden=%d backward", PATCH_DIM, HIDDEN_DIM1, HIDDEN_DIM2);
+  ret |= bench_run(suite, "q15_fastgrnn_backward", shape, run_q15_fastgrnn_backward);
+  snprintf(shape, BENCH_SHAPE_LEN, "patch=%dx%dx%d hidden=%d,%d", PATCH_DIM, PATCH_DIM, INPUT_CHANNELS, HIDDEN_DIM1, HIDDEN_DIM2);
+  ret |= bench_run(suite, "q15_rnnpool_block", shape, run_q15_rnnpool_block);
+  ret |= bench_run(suite, "q15_rnnpool_block_unbatched", shape, run_q15_rnnpool_block_unbatched);
+  return ret;
+}
@@ -24,6 +24,23 @@ void errorCheck(float* pred, float* label, unsigned out_time, int out_features)
   printf("Agg Squared Error: %f ; MSE: %f ; RMSE: %f\n", error, avg_error, rmse);
 }
 
+// Compare the output of a multi-threaded layer with the output of the same layer on 1 thread
+// The layers split the time steps differently with more threads, hence a few outputs can differ in the last bits
+int threadCheck(const float* pred, const float* serial, unsigned len, unsigned num_threads) {
+  float max_diff = 0, max_val = 0;
+  for (unsigned i = 0; i < len; i++) {
+    float diff = pred[i] - serial[i];
+    diff = diff < 0 ? -diff : diff;
+    max_diff = diff > max_diff ? diff : max_diff;
+    float val = serial[i] < 0 ? -serial[i] : serial[i];
+    max_val = val > max_val ? val : max_val;
+  }
+  int failed = max_diff > 1e-5f * (max_val + 1.0f);
+  printf("%u threads : Max difference with 1 thread : %e, %s\n", num_threads, max_diff,
+    failed ? "Failed" : "Passed");
+  return failed;
+}
+
 void conv1d_check() {
   ConvLayers_Params conv_params = {
     .W = CONV1D_CONV_WEIGHT,
@@ -58,6 +75,327 @@ void conv1d_parallel_check() {
   free(pred);
 }
 
+int conv1d_parallel_threads_check() {
+  unsigned len = CONV1D_OUT_TIME * CONV1D_OUT_FEATURES;
+  float* serial = (float*)malloc(len * sizeof(float));
+  float* pred = (float*)malloc(len * sizeof(float));
+  unsigned threads[] = {1, 2, 3, 4, 7};
+  int failed = 0;
+
+  printf("Testing Multi-threaded Parallel Convolution\n");
+  for (unsigned i = 0; i < sizeof(threads) / sizeof(threads[0]); i++) {
+    ConvLayers_Parallel_Params conv_params = {
+      .W = CONV1D_CONV_WEIGHT,
+      .B = CONV1D_CONV_BIAS,
+      .block_size = 100,
+      .num_threads = threads[i],
+    };
+    conv1d_parallel(i ? pred : serial, CONV1D_OUT_TIME, CONV1D_OUT_FEATURES, CONV1D_INPUT,
+      CONV1D_IN_TIME, CONV1D_IN_FEATURES, CONV1D_PAD, CONV1D_FILT,
+      &conv_params, CONV1D_STRIDE, CONV1D_ACT);
+    if (i) {
+      failed |= threadCheck(pred, serial, len, threads[i]);
+    }
+  }
+  free(pred);
+  free(serial);
+  return failed;
+}
+
+void conv1d_im2col_check() {
+  ConvLayers_Parallel_Params conv_params = {
+    .W = CONV1D_CONV_WEIGHT,
+    .B = CONV1D_CONV_BIAS,
+    .block_size = 100,
+  };
+  
+  float* pred = (float*)malloc(CONV1D_OUT_TIME * CONV1D_OUT_FEATURES * sizeof(float));
+  conv1d_im2col(pred, CONV1D_OUT_TIME, CONV1D_OUT_FEATURES, CONV1D_INPUT,
+    CONV1D_IN_TIME, CONV1D_IN_FEATURES, CONV1D_PAD, CONV1D_FILT,
+    &conv_params, CONV1D_STRIDE, CONV1D_ACT);
+
+  printf("Testing im2col Convolution\n");
+  errorCheck(pred, CONV1D_OUTPUT, CONV1D_OUT_TIME, CONV1D_OUT_FEATURES);
+  free(pred);
+}
+
+// Shapes of conv1d_auto : {in_time, in_channels, out_channels, kernel_size, padding, stride, activation}
+// The first three have enough time steps and channels for conv1d_im2col, the last three use conv1d
+static const unsigned auto_shapes[][7] = {
+  {40, 6, 16, 5, 2, 1, 2},    // im2col, full panels
+  {150, 7, 5, 3, 1, 2, 3},    // im2col, a partial panel and several blocks of CONV1D_IM2COL_STEPS
+  {16, 3, 4, 1, 0, 1, 0},     // im2col, the smallest shape taking the path
+  {5, 6, 16, 3, 1, 1, 1},     // conv1d, too few time steps
+  {40, 6, 3, 5, 2, 1, 2},     // conv1d, too few output channels
+  {9, 4, 4, 3, 0, 2, 0},      // conv1d, out_time of 4 with a stride
+};
+
+// Compare conv1d_auto with conv1d on synthetic data, for shapes picking either implementation
+int conv1d_auto_check() {
+  int failed = 0;
+
+  printf("Testing Convolution with the implementation selected by the shape\n");
+  for (unsigned s = 0; s < sizeof(auto_shapes) / sizeof(auto_shapes[0]); s++) {
+    unsigned in_time = auto_shapes[s][0], in_channels = auto_shapes[s][1];
+    unsigned out_channels = auto_shapes[s][2], kernel_size = auto_shapes[s][3];
+    unsigned padding = auto_shapes[s][4], stride = auto_shapes[s][5], activation = auto_shapes[s][6];
+    unsigned out_time = (in_time + 2 * padding - kernel_size) / stride + 1;
+    unsigned len = out_time * out_channels;
+
+    float* input = (float*)malloc(in_time * in_channels * sizeof(float));
+    float* W = (float*)malloc(out_channels * kernel_size * in_channels * sizeof(float));
+    float* B = (float*)malloc(out_channels * sizeof(float));
+    for (unsigned i = 0; i < in_time * in_channels; i++) {
+      input[i] = (float)((int)((i * 37) % 23) - 11) / 8.0f;
+    }
+    for (unsigned i = 0; i < out_channels * kernel_size * in_channels; i++) {
+      W[i] = (float)((int)((i * 53) % 29) - 14) / 32.0f;
+    }
+    for (unsigned i = 0; i < out_channels; i++) {
+      B[i] = (float)((int)(i % 5) - 2) / 4.0f;
+    }
+
+    ConvLayers_Params conv_params = {
+      .W = W,
+      .B = B,
+      .depthwise = 0,
+    };
+    ConvLayers_Parallel_Params auto_params = {
+      .W = W,
+      .B = B,
+      .block_size = 0,
+    };
+    float* expected = (float*)malloc(len * sizeof(float));
+    float* pred = (float*)malloc(len * sizeof(float));
+    conv1d(expected, out_time, out_channels, input, in_time, in_channels,
+      padding, kernel_size, &conv_params, stride, activation);
+    conv1d_auto(pred, out_time, out_channels, input, in_time, in_channels,
+      padding, kernel_size, &auto_params, stride, activation);
+
+    float max_diff = 0;
+    for (unsigned i = 0; i < len; i++) {
+      float diff = pred[i] - expected[i];
+      diff = diff < 0 ? -diff : diff;
+      max_diff = diff > max_diff ? diff : max_diff;
+    }
+    int shape_failed = max_diff > 1e-5f;
+    printf("%ux%u -> %ux%u, kernel %u, stride %u : Max difference with conv1d : %e, %s\n",
+      in_time, in_channels, out_time, out_channels, kernel_size, stride, max_diff,
+      shape_failed ? "Failed" : "Passed");
+    failed |= shape_failed;
+
+    free(pred);
+    free(expected);
+    free(B);
+    free(W);
+    free(input);
+  }
+  return failed;
+}
+
+void conv1d_fused_check() {
+  // Identity batchnorm (scale = 1, offset = 0) folded into the regular conv. No pooling
+  float* gamma = (float*)malloc(CONV1D_IN_FEATURES * sizeof(float));
+  float* beta = (float*)malloc(CONV1D_IN_FEATURES * sizeof(float));
+  for (unsigned ci = 0; ci < CONV1D_IN_FEATURES; ci++) {
+    gamma[ci] = 1.0f;
+    beta[ci] = 0.0f;
+  }
+  float* W = (float*)malloc(CONV1D_OUT_FEATURES * CONV1D_FILT * CONV1D_IN_FEATURES * sizeof(float));
+  float* B = (float*)malloc(CONV1D_OUT_FEATURES * sizeof(float));
+  float* tap_bias = (float*)malloc(CONV1D_OUT_FEATURES * CONV1D_FILT * sizeof(float));
+  conv1d_fold_batchnorm(W, B, tap_bias, CONV1D_CONV_WEIGHT, CONV1D_CONV_BIAS,
+    CONV1D_OUT_FEATURES, CONV1D_IN_FEATURES, CONV1D_FILT, 0,
+    0, 0, 2, gamma, beta, 0.00001);
+
+  ConvLayers_Fused_Params conv_params = {
+    .W = W,
+    .W1 = 0,
+    .B = B,
+    .tap_bias = tap_bias,
+    .rank = 0,
+    .depthwise = 0,
+  };
+
+  float* pred = (float*)malloc(CONV1D_OUT_TIME * CONV1D_OUT_FEATURES * sizeof(float));
+  conv1d_fused(pred, CONV1D_OUT_TIME, CONV1D_OUT_FEATURES, CONV1D_INPUT,
+    CONV1D_IN_TIME, CONV1D_IN_FEATURES, CONV1D_PAD, CONV1D_FILT,
+    &conv_params, CONV1D_STRIDE, CONV1D_ACT, 0, 0, 0, 0);
+
+  printf("Testing Fused Convolution\n");
+  errorCheck(pred, CONV1D_OUTPUT, CONV1D_OUT_TIME, CONV1D_OUT_FEATURES);
+  free(pred);
+  free(tap_bias);
+  free(B);
+  free(W);
+  free(beta);
+  free(gamma);
+}
+
+// Compare a fused layer with the same batchnorm1d -> conv -> avgpool1d sequence run layer by layer
+// The folded weights and the pool change the order of the float operations, hence a tolerance
+int unfusedCheck(const float* pred, const float* unfused, unsigned len) {
+  float max_diff = 0, max_val = 0;
+  for (unsigned i = 0; i < len; i++) {
+    float diff = pred[i] - unfused[i];
+    diff = diff < 0 ? -diff : diff;
+    max_diff = diff > max_diff ? diff : max_diff;
+    float val = unfused[i] < 0 ? -unfused[i] : unfused[i];
+    max_val = val > max_val ? val : max_val;
+  }
+  int failed = max_diff > 1e-4f * (max_val + 1.0f);
+  printf("Max difference with the unfused layers : %e, %s\n", max_diff,
+    failed ? "Failed" : "Passed");
+  return failed;
+}
+
+// Non-trivial batchnorm statistics and affine parameters for the input channels
+void fill_batchnorm(float* mean, float* var, float* gamma, float* beta,
+  unsigned in_channels) {
+  for (unsigned ci = 0; ci < in_channels; ci++) {
+    mean[ci] = 0.1f * (float)((int)(ci % 7) - 3);
+    var[ci] = 0.5f + 0.25f * (float)(ci % 5);
+    gamma[ci] = 0.75f + 0.1f * (float)(ci % 4);
+    beta[ci] = 0.2f * (float)((int)(ci % 3) - 1);
+  }
+}
+
+#define FUSED_POOL_PAD 1
+#define FUSED_POOL_FILT 3
+#define FUSED_POOL_STRIDE 2
+#define FUSED_POOL_ACT 3
+
+int conv1d_fused_bn_pool_check() {
+  unsigned pool_out_time = (CONV1D_OUT_TIME + 2 * FUSED_POOL_PAD - FUSED_POOL_FILT) / FUSED_POOL_STRIDE + 1;
+  float* mean = (float*)malloc(CONV1D_IN_FEATURES * sizeof(float));
+  float* var = (float*)malloc(CONV1D_IN_FEATURES * sizeof(float));
+  float* gamma = (float*)malloc(CONV1D_IN_FEATURES * sizeof(float));
+  float* beta = (float*)malloc(CONV1D_IN_FEATURES * sizeof(float));
+  fill_batchnorm(mean, var, gamma, beta, CONV1D_IN_FEATURES);
+
+  // Unfused : batchnorm1d -> conv1d -> avgpool1d
+  float* norm = (float*)malloc(CONV1D_IN_TIME * CONV1D_IN_FEATURES * sizeof(float));
+  float* conv = (float*)malloc(CONV1D_OUT_TIME * CONV1D_OUT_FEATURES * sizeof(float));
+  float* unfused = (float*)malloc(pool_out_time * CONV1D_OUT_FEATURES * sizeof(float));
+  for (unsigned i = 0; i < CONV1D_IN_TIME * CONV1D_IN_FEATURES; i++) {
+    norm[i] = CONV1D_INPUT[i];
+  }
+  batchnorm1d(0, norm, CONV1D_IN_TIME, CONV1D_IN_FEATURES,
+    mean, var, 1, gamma, beta, 1, 0.00001);
+  ConvLayers_Params conv_params = {
+    .W = CONV1D_CONV_WEIGHT,
+    .B = CONV1D_CONV_BIAS,
+    .depthwise = 0,
+  };
+  conv1d(conv, CONV1D_OUT_TIME, CONV1D_OUT_FEATURES, norm,
+    CONV1D_IN_TIME, CONV1D_IN_FEATURES, CONV1D_PAD, CONV1D_FILT,
+    &conv_params, CONV1D_STRIDE, CONV1D_ACT);
+  avgpool1d(unfused, pool_out_time, conv, CONV1D_OUT_TIME, CONV1D_OUT_FEATURES,
+    FUSED_POOL_PAD, FUSED_POOL_FILT, FUSED_POOL_STRIDE, FUSED_POOL_ACT);
+
+  // Fused
+  float* W = (float*)malloc(CONV1D_OUT_FEATURES * CONV1D_FILT * CONV1D_IN_FEATURES * sizeof(float));
+  float* B = (float*)malloc(CONV1D_OUT_FEATURES * sizeof(float));
+  float* tap_bias = (float*)malloc(CONV1D_OUT_FEATURES * CONV1D_FILT * sizeof(float));
+  conv1d_fold_batchnorm(W, B, tap_bias, CONV1D_CONV_WEIGHT, CONV1D_CONV_BIAS,
+    CONV1D_OUT_FEATURES, CONV1D_IN_FEATURES, CONV1D_FILT, 0,
+    mean, var, 1, gamma, beta, 0.00001);
+  ConvLayers_Fused_Params fused_params = {
+    .W = W,
+    .W1 = 0,
+    .B = B,
+    .tap_bias = tap_bias,
+    .rank = 0,
+    .depthwise = 0,
+  };
+  float* pred = (float*)malloc(pool_out_time * CONV1D_OUT_FEATURES * sizeof(float));
+  conv1d_fused(pred, pool_out_time, CONV1D_OUT_FEATURES, CONV1D_INPUT,
+    CONV1D_IN_TIME, CONV1D_IN_FEATURES, CONV1D_PAD, CONV1D_FILT,
+    &fused_params, CONV1D_STRIDE, CONV1D_ACT,
+    FUSED_POOL_PAD, FUSED_POOL_FILT, FUSED_POOL_STRIDE, FUSED_POOL_ACT);
+
+  printf("Testing Fused Convolution with Batchnorm and Avgpool\n");
+  int failed = unfusedCheck(pred, unfused, pool_out_time * CONV1D_OUT_FEATURES);
+  free(pred);
+  free(tap_bias);
+  free(B);
+  free(W);
+  free(unfused);
+  free(conv);
+  free(norm);
+  free(beta);
+  free(gamma);
+  free(var);
+  free(mean);
+  return failed;
+}
+
+int conv1d_lr_fused_bn_pool_check() {
+  unsigned pool_out_time = (CONV1D_LR_OUT_TIME + 2 * FUSED_POOL_PAD - FUSED_POOL_FILT) / FUSED_POOL_STRIDE + 1;
+  float* mean = (float*)malloc(CONV1D_LR_IN_FEATURES * sizeof(float));
+  float* var = (float*)malloc(CONV1D_LR_IN_FEATURES * sizeof(float));
+  float* gamma = (float*)malloc(CONV1D_LR_IN_FEATURES * sizeof(float));
+  float* beta = (float*)malloc(CONV1D_LR_IN_FEATURES * sizeof(float));
+  fill_batchnorm(mean, var, gamma, beta, CONV1D_LR_IN_FEATURES);
+
+  // Unfused : batchnorm1d -> conv1d_lr -> avgpool1d
+  float* norm = (float*)malloc(CONV1D_LR_IN_TIME * CONV1D_LR_IN_FEATURES * sizeof(float));
+  float* conv = (float*)malloc(CONV1D_LR_OUT_TIME * CONV1D_LR_OUT_FEATURES * sizeof(float));
+  float* unfused = (float*)malloc(pool_out_time * CONV1D_LR_OUT_FEATURES * sizeof(float));
+  for (unsigned i = 0; i < CONV1D_LR_IN_TIME * CONV1D_LR_IN_FEATURES; i++) {
+    norm[i] = CONV1D_LR_INPUT[i];
+  }
+  batchnorm1d(0, norm, CONV1D_LR_IN_TIME, CONV1D_LR_IN_FEATURES,
+    mean, var, 1, gamma, beta, 1, 0.00001);
+  ConvLayers_LR_Params conv_params = {
+    .W1 = CONV1D_LR_CONV_W1,
+    .W2 = CONV1D_LR_CONV_W2,
+    .B = CONV1D_LR_CONV_BIAS,
+    .rank = CONV1D_LR_LOW_RANK
+  };
+  conv1d_lr(conv, CONV1D_LR_OUT_TIME, CONV1D_LR_OUT_FEATURES, norm,
+    CONV1D_LR_IN_TIME, CONV1D_LR_IN_FEATURES, CONV1D_LR_PAD, CONV1D_LR_FILT,
+    &conv_params, CONV1D_LR_STRIDE, CONV1D_LR_ACT);
+  avgpool1d(unfused, pool_out_time, conv, CONV1D_LR_OUT_TIME, CONV1D_LR_OUT_FEATURES,
+    FUSED_POOL_PAD, FUSED_POOL_FILT, FUSED_POOL_STRIDE, FUSED_POOL_ACT);
+
+  // Fused
+  float* W2 = (float*)malloc(CONV1D_LR_LOW_RANK * CONV1D_LR_FILT * CONV1D_LR_IN_FEATURES * sizeof(float));
+  float* B = (float*)malloc(CONV1D_LR_OUT_FEATURES * sizeof(float));
+  float* tap_bias = (float*)malloc(CONV1D_LR_OUT_FEATURES * CONV1D_LR_FILT * sizeof(float));
+  conv1d_lr_fold_batchnorm(W2, B, tap_bias, CONV1D_LR_CONV_W1, CONV1D_LR_CONV_W2,
+    CONV1D_LR_CONV_BIAS, CONV1D_LR_LOW_RANK, CONV1D_LR_OUT_FEATURES,
+    CONV1D_LR_IN_FEATURES, CONV1D_LR_FILT, mean, var, 1, gamma, beta, 0.00001);
+  ConvLayers_Fused_Params fused_params = {
+    .W = W2,
+    .W1 = CONV1D_LR_CONV_W1,
+    .B = B,
+    .tap_bias = tap_bias,
+    .rank = CONV1D_LR_LOW_RANK,
+    .depthwise = 0,
+  };
+  float* pred = (float*)malloc(pool_out_time * CONV1D_LR_OUT_FEATURES * sizeof(float));
+  conv1d_fused(pred, pool_out_time, CONV1D_LR_OUT_FEATURES, CONV1D_LR_INPUT,
+    CONV1D_LR_IN_TIME, CONV1D_LR_IN_FEATURES, CONV1D_LR_PAD, CONV1D_LR_FILT,
+    &fused_params, CONV1D_LR_STRIDE, CONV1D_LR_ACT,
+    FUSED_POOL_PAD, FUSED_POOL_FILT, FUSED_POOL_STRIDE, FUSED_POOL_ACT);
+
+  printf("Testing Fused Low-Rank Convolution with Batchnorm and Avgpool\n");
+  int failed = unfusedCheck(pred, unfused, pool_out_time * CONV1D_LR_OUT_FEATURES);
+  free(pred);
+  free(tap_bias);
+  free(B);
+  free(W2);
+  free(unfused);
+  free(conv);
+  free(norm);
+  free(beta);
+  free(gamma);
+  free(var);
+  free(mean);
+  return failed;
+}
+
 void conv1d_depth_check() {
   ConvLayers_Params conv_params = {
     .W = CONV1D_DEPTH_CONV_WEIGHT,
@@ -117,14 +455,51 @@ void conv1d_lr_parallel_check() {
   free(pred);
 }
 
+int conv1d_lr_parallel_threads_check() {
+  unsigned len = CONV1D_LR_OUT_TIME * CONV1D_LR_OUT_FEATURES;
+  float* serial = (float*)malloc(len * sizeof(float));
+  float* pred = (float*)malloc(len * sizeof(float));
+  unsigned threads[] = {1, 2, 3, 4, 7};
+  int failed = 0;
+
+  printf("Testing Multi-threaded Low-Rank Parallel Convolution\n");
+  for (unsigned i = 0; i < sizeof(threads) / sizeof(threads[0]); i++) {
+    ConvLayers_LR_Parallel_Params conv_params = {
+      .W1 = CONV1D_LR_CONV_W1,
+      .W2 = CONV1D_LR_CONV_W2,
+      .B = CONV1D_LR_CONV_BIAS,
+      .rank = CONV1D_LR_LOW_RANK,
+      .block_size_to_lr = 100,
+      .block_size_from_lr = 100,
+      .num_threads = threads[i],
+    };
+    conv1d_lr_parallel(i ? pred : serial, CONV1D_LR_OUT_TIME, CONV1D_LR_OUT_FEATURES, CONV1D_LR_INPUT,
+      CONV1D_LR_IN_TIME, CONV1D_LR_IN_FEATURES, CONV1D_LR_PAD, CONV1D_LR_FILT,
+      &conv_params, CONV1D_LR_STRIDE, CONV1D_LR_ACT);
+    if (i) {
+      failed |= threadCheck(pred, serial, len, threads[i]);
+    }
+  }
+  free(pred);
+  free(serial);
+  return failed;
+}
+
 int main() {
   #ifdef LOOP_UNROLL
     printf("Loop Unrolling Active\n");
   #endif
   conv1d_check();
   conv1d_parallel_check();
+  conv1d_im2col_check();
+  conv1d_fused_check();
   conv1d_lr_check();
   conv1d_depth_check();
   conv1d_lr_parallel_check();
-  return 0;
+  int failed = conv1d_fused_bn_pool_check();
+  failed |= conv1d_lr_fused_bn_pool_check();
+  failed |= conv1d_parallel_threads_check();
+  failed |= conv1d_lr_parallel_threads_check();
+  failed |= conv1d_auto_check();
+  return failed;
 }
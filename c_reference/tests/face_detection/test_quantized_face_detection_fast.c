@@ -10,9 +10,13 @@
 #include "quantized_datatypes.h"
 #include "quantized_face_detection_fast.h"
 
-#define MEM_BUF_SIZE 165840
+#define MEM_BUF_SIZE FACE_DETECTION_FAST_MEM_BUF_SIZE
 #define INPUT_IMG_HEIGHT 240
 #define INPUT_IMG_WIDTH 320
+// Number of threads of the batched (throughput) run
+#ifndef BATCH_THREADS
+  #define BATCH_THREADS 4
+#endif
 #define OUTPUT_SIZE 5400
 
 // Fixed Point Output Corresponding To SCUT-HEAD Face-3 Image: 1
@@ -47,6 +51,37 @@ float compute_error(const Q15_T* const pred, const float* const label,
   return agg_diff;
 }
 
+// Synthetic video for the streaming mode, made from one image: a window of
+// STREAM_OBJECT x STREAM_OBJECT pixels of the image moves over the static
+// image by STREAM_STEP pixels per frame, and all the other pixels flicker by
+// up to STREAM_NOISE, as the noise of a camera
+#define STREAM_FRAMES 24
+#define STREAM_OBJECT 48
+#define STREAM_STEP 4
+#define STREAM_NOISE 2
+
+void stream_frame(Q7_T* const frame, const Q7_T* const image, unsigned f) {
+  for (unsigned h = 0; h < INPUT_IMG_HEIGHT; h++) {
+    for (unsigned w = 0; w < INPUT_IMG_WIDTH; w++) {
+      int noise = (int)((h * 7 + w * 13 + f * 3) % (2 * STREAM_NOISE + 1)) - STREAM_NOISE;
+      int val = image[h * INPUT_IMG_WIDTH + w] + noise;
+      frame[h * INPUT_IMG_WIDTH + w] = (Q7_T)(val > 127 ? 127 : (val < -128 ? -128 : val));
+    }
+  }
+  unsigned top = 96, left = 16 + f * STREAM_STEP;
+  for (unsigned h = 0; h < STREAM_OBJECT; h++) {
+    memcpy(&frame[(top + h) * INPUT_IMG_WIDTH + left],
+           &image[(16 + h) * INPUT_IMG_WIDTH + 16], STREAM_OBJECT * sizeof(Q7_T));
+  }
+}
+
+// Wall clock time in seconds, for the throughput of the multi-threaded runs.
+double wall_time() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
 // Function for computing the 95th percentile deviation among all the outputs.
 float aggregate_error(float* errors, unsigned len) {
   qsort(errors, len, sizeof(float), compare_floats);
@@ -153,6 +188,10 @@ int main(int argc, char **argv) {
   float* xLine = malloc(INPUT_IMG_HEIGHT * INPUT_IMG_WIDTH * sizeof(float));
   float* yLine = malloc(OUTPUT_SIZE * sizeof(float));
   float* allErrors = malloc(patches * OUTPUT_SIZE * (sizeof(float)));
+  char* batch_mem_buf = malloc((size_t)patches * MEM_BUF_SIZE * sizeof(char));
+  Q15_T* single_outputs = malloc((size_t)patches * OUTPUT_SIZE * sizeof(Q15_T));
+  char* scratch_buf = malloc(q_face_detection_fast_scratch_size(BATCH_THREADS));
+  Q7_T* first_image = malloc(INPUT_IMG_HEIGHT * INPUT_IMG_WIDTH * sizeof(Q7_T));
 
   float time_spent = 0.0;
   Q7_T* mem_buf_input_offset = (Q7_T *)mem_buf;
@@ -164,6 +203,11 @@ int main(int argc, char **argv) {
     for (unsigned j = 0; j < INPUT_IMG_HEIGHT * INPUT_IMG_WIDTH; j++) {
       mem_buf_input_offset[j] = (Q7_T)(xLine[j] * pow(2, XScale));
     }
+    memcpy(batch_mem_buf + (size_t)i * MEM_BUF_SIZE, mem_buf,
+           INPUT_IMG_HEIGHT * INPUT_IMG_WIDTH * sizeof(Q7_T));
+    if (i == 0) {
+      memcpy(first_image, mem_buf, INPUT_IMG_HEIGHT * INPUT_IMG_WIDTH * sizeof(Q7_T));
+    }
 
     fprintf(outputLog, "Running Quantized Face Detection Model on Patch %d\n", i + 1);
     clock_t begin = clock();
@@ -180,6 +224,8 @@ int main(int argc, char **argv) {
       float val = ((float)mem_buf_output_offset[j]) / pow(2, YScale);
       fwrite((char*)&val, sizeof(float), 1, yFile);
     }
+    memcpy(single_outputs + i * OUTPUT_SIZE, mem_buf_output_offset,
+           OUTPUT_SIZE * sizeof(Q15_T));
 
     if (i == 0) {
       fprintf(outputLog, "Checking Fixed Point Outputs on Patch 1\n");
@@ -195,6 +241,88 @@ int main(int argc, char **argv) {
     }
   }
 
+  fprintf(outputLog, "Single Frame Throughput: %f FPS (CPU time)\n",
+          patches / time_spent);
+
+  fprintf(outputLog, "Running Quantized Face Detection Model on a Batch of %d Images with %d Threads\n",
+          patches, BATCH_THREADS);
+  double batch_begin = wall_time();
+  q_face_detection_fast_batch(batch_mem_buf, scratch_buf, patches, BATCH_THREADS);
+  double batch_time = wall_time() - batch_begin;
+  fprintf(outputLog, "Batch Throughput: %f FPS (wall clock time)\n",
+          patches / batch_time);
+
+  int batch_failed = 0;
+  for (unsigned i = 0; i < patches; i++) {
+    const Q15_T* batch_output = (const Q15_T*)(batch_mem_buf +
+      (size_t)i * MEM_BUF_SIZE + FACE_DETECTION_FAST_OUTPUT_OFFSET);
+    if (memcmp(batch_output, single_outputs + i * OUTPUT_SIZE,
+               OUTPUT_SIZE * sizeof(Q15_T)) != 0) {
+      fprintf(outputLog, "Batch Output Mismatch on Patch %d\n", i + 1);
+      batch_failed = 1;
+    }
+  }
+  if (batch_failed) {
+    fprintf(outputLog, "Quantized Face Detection Batch Test Failed!\n");
+    return -1;
+  }
+  fprintf(outputLog, "Quantized Face Detection Batch Test Passed!\n");
+
+  // Streaming mode over a synthetic video made from the first image, see
+  // stream_frame(). Every frame is also run through the whole model for the
+  // reference outputs and the time of the full pipeline. Threshold 0 has to
+  // match them exactly, the others trade accuracy for the recomputed work.
+  // Thresholds below 2 * STREAM_NOISE recompute the flickering background
+  Q15_T* stream_outputs = malloc(STREAM_FRAMES * OUTPUT_SIZE * sizeof(Q15_T));
+  float full_time = 0.0;
+  for (unsigned i = 0; i < STREAM_FRAMES; i++) {
+    stream_frame(mem_buf_input_offset, first_image, i);
+    clock_t begin = clock();
+    q_face_detection_fast(mem_buf);
+    clock_t end = clock();
+    full_time += (float)(end - begin) / CLOCKS_PER_SEC;
+    memcpy(stream_outputs + i * OUTPUT_SIZE, mem_buf_output_offset,
+           OUTPUT_SIZE * sizeof(Q15_T));
+  }
+  fprintf(outputLog, "Streaming Video: %d Frames, %dx%d Window Moving by %d Pixels per Frame, Noise %d, Full Pipeline %f FPS\n",
+          STREAM_FRAMES, STREAM_OBJECT, STREAM_OBJECT, STREAM_STEP, STREAM_NOISE,
+          STREAM_FRAMES / full_time);
+
+  const Q7_T thresholds[] = {0, 2, 4, 8, 16};
+  Q_Face_Detection_Fast_Stream* stream = malloc(sizeof(Q_Face_Detection_Fast_Stream));
+  for (unsigned t = 0; t < sizeof(thresholds) / sizeof(thresholds[0]); t++) {
+    q_face_detection_fast_stream_init(stream);
+    float stream_time = 0.0;
+    Q31_T stream_max_diff = 0;
+    double stream_sum_diff = 0.0;
+    for (unsigned i = 0; i < STREAM_FRAMES; i++) {
+      stream_frame(mem_buf_input_offset, first_image, i);
+      clock_t begin = clock();
+      q_face_detection_fast_stream(mem_buf, NULL, stream, thresholds[t], 1);
+      clock_t end = clock();
+      stream_time += (float)(end - begin) / CLOCKS_PER_SEC;
+
+      for (unsigned j = 0; j < OUTPUT_SIZE; j++) {
+        Q31_T diff = (Q31_T)mem_buf_output_offset[j] - stream_outputs[i * OUTPUT_SIZE + j];
+        diff = diff < 0 ? -diff : diff;
+        stream_max_diff = diff > stream_max_diff ? diff : stream_max_diff;
+        stream_sum_diff += diff;
+      }
+    }
+    fprintf(outputLog, "Streaming Threshold %d: %f FPS, Speedup %f, Conv2D Rows Computed %lu / %lu, Patches Computed %lu / %lu, Output Deviation Maximum %ld Mean %f\n",
+            thresholds[t], STREAM_FRAMES / stream_time, full_time / stream_time,
+            stream->conv2d_rows_computed, stream->conv2d_rows_total,
+            stream->patches_computed, stream->patches_total, (long)stream_max_diff,
+            stream_sum_diff / (STREAM_FRAMES * OUTPUT_SIZE));
+    if (thresholds[t] == 0 && stream_max_diff != 0) {
+      fprintf(outputLog, "Quantized Face Detection Streaming Test Failed!\n");
+      return -1;
+    }
+  }
+  fprintf(outputLog, "Quantized Face Detection Streaming Test Passed!\n");
+  free(stream);
+  free(stream_outputs);
+
   fclose(xFile);
   fclose(yFile);
   fclose(floatResFile);
@@ -212,6 +340,10 @@ int main(int argc, char **argv) {
   free(xLine);
   free(yLine);
   free(allErrors);
+  free(batch_mem_buf);
+  free(single_outputs);
+  free(scratch_buf);
+  free(first_image);
 
   return 0;
 }
@@ -0,0 +1,225 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "quantized_face_detection_post.h"
+
+// Synthetic output tensors of the 18000 output (3000 prior) models, in Q12
+#define NUM_PRIORS 3000
+#define OUTPUT_SCALE 12
+#define MAX_DETECTIONS 128
+// Prior boxes of the 5400 output fast model
+#define NUM_FAST_PRIORS 900
+
+static Q15_T output[6 * NUM_PRIORS];
+static Q15_T scores[NUM_PRIORS];
+static ITER_T order[2 * NUM_PRIORS];
+static Q_Face_Detection_Box detections[MAX_DETECTIONS];
+
+// All the priors are background, except the ones set with set_prior()
+static void clear_output() {
+  for (unsigned p = 0; p < NUM_PRIORS; p++) {
+    output[2 * p] = 0;
+    output[2 * p + 1] = -20000;
+  }
+  for (unsigned i = 2 * NUM_PRIORS; i < 6 * NUM_PRIORS; i++) {
+    output[i] = 0;
+  }
+}
+
+static void set_prior(unsigned prior, Q15_T logit, Q15_T lx, Q15_T ly,
+                      Q15_T lw, Q15_T lh) {
+  output[2 * prior + 1] = logit;
+  output[2 * NUM_PRIORS + 4 * prior] = lx;
+  output[2 * NUM_PRIORS + 4 * prior + 1] = ly;
+  output[2 * NUM_PRIORS + 4 * prior + 2] = lw;
+  output[2 * NUM_PRIORS + 4 * prior + 3] = lh;
+}
+
+static void default_params(Q_Face_Detection_Post_Params* params) {
+  params->heads = q_face_detection_qvga_heads;
+  params->num_heads = Q_FACE_DETECTION_QVGA_NUM_HEADS;
+  params->img_h = 240;
+  params->img_w = 320;
+  params->scale = OUTPUT_SCALE;
+  params->conf_thresh = Q_FACE_DETECTION_CONF_THRESH;
+  params->nms_thresh = Q_FACE_DETECTION_NMS_THRESH;
+  params->top_k = MAX_DETECTIONS;
+  params->max_detections = MAX_DETECTIONS;
+}
+
+// The fixed point sigmoid is within 4 / 2^15 of the floating point one
+static int check_score(const Q_Face_Detection_Box* box) {
+  float logit = (float)(output[2 * box->prior + 1] - output[2 * box->prior]) / (1 << OUTPUT_SCALE);
+  int expected = (int)(32768.0f / (1.0f + expf(-logit)));
+  if (abs(box->score - expected) > 4) {
+    printf("Score: %d, Expected: %d for Prior: %u\n", box->score, expected, box->prior);
+    return 1;
+  }
+  return 0;
+}
+
+// The box coordinates are within one unit (1 / 16 pixel) of the floating point ones
+static int check_box(const Q_Face_Detection_Box* box, ITER_T prior,
+                     const Q15_T* expected) {
+  const Q15_T pred[4] = {box->x1, box->y1, box->x2, box->y2};
+  if (box->prior != prior) {
+    printf("Prior: %u, Expected: %u\n", box->prior, prior);
+    return 1;
+  }
+  for (unsigned i = 0; i < 4; i++) {
+    if (abs(pred[i] - expected[i]) > 1) {
+      printf("Output: %d, Expected: %d at Index: %d of Prior: %u\n", pred[i], expected[i], i, prior);
+      return 1;
+    }
+  }
+  return check_score(box);
+}
+
+// Test the decoding, the thresholding, the NMS and the order of the detections.
+int test_q_face_detection_postprocess() {
+  Q_Face_Detection_Post_Params params;
+  Q_Face_Detection_Post_Buffers buffers = {scores, order};
+  ITER_T num_detections;
+  default_params(&params);
+  clear_output();
+
+  // Head 3 (step 16, anchor 48), i = 7, j = 10. Shifted by 0.1 * 2.5 * 48 = 12 pixels, width doubled (log(2) / 0.2 = 3.4657)
+  set_prior(2850, 12288, 10240, 0, 14196, 0);
+  // Head 2 (step 16, anchor 32), i = 3, j = 5. The prior box itself
+  set_prior(2465, 8192, 0, 0, 0, 0);
+  // Head 1 (step 8, anchor 16), i = 10, j = 10, 11 and 12. 1611 overlaps 1610 with IoU 1 / 3, 1612 only touches 1610
+  set_prior(1610, 6000, 0, 0, 0, 0);
+  set_prior(1611, 5500, 0, 0, 0, 0);
+  set_prior(1612, 5000, 0, 0, 0, 0);
+  // Head 0 (step 8, anchor 8), around the threshold : logit(0.05) = -2.944 (-12059 in Q12). 3, 5 and 7 tie
+  set_prior(3, -11900, 0, 0, 0, 0);
+  set_prior(5, -11900, 0, 0, 0, 0);
+  set_prior(6, -12200, 0, 0, 0, 0);
+  set_prior(7, -11900, 0, 0, 0, 0);
+
+  const ITER_T expected_priors[7] = {2850, 2465, 1610, 1612, 3, 5, 7};
+  const Q15_T expected_boxes[7][4] = {
+    {2112, 1536, 3648, 2304},
+    {1152, 640, 1664, 1152},
+    {1216, 1216, 1472, 1472},
+    {1472, 1216, 1728, 1472},
+    {384, 0, 512, 128},
+    {640, 0, 768, 128},
+    {896, 0, 1024, 128}
+  };
+
+  if (q_face_detection_postprocess(output, &params, &buffers, detections, &num_detections)) {
+    return 1;
+  }
+  if (num_detections != 7) {
+    printf("Detections: %u, Expected: 7\n", num_detections);
+    return 1;
+  }
+  for (unsigned d = 0; d < 7; d++) {
+    if (check_box(&detections[d], expected_priors[d], expected_boxes[d])) {
+      return 1;
+    }
+  }
+
+  // Only the first 4 candidates are visited (1611 is suppressed), then at most 4 boxes are kept
+  params.top_k = 4;
+  if (q_face_detection_postprocess(output, &params, &buffers, detections, &num_detections) ||
+      num_detections != 3 || detections[2].prior != 1610) {
+    return 1;
+  }
+  params.top_k = MAX_DETECTIONS;
+  params.max_detections = 4;
+  if (q_face_detection_postprocess(output, &params, &buffers, detections, &num_detections) ||
+      num_detections != 4 || detections[3].prior != 1612) {
+    return 1;
+  }
+
+  // Without NMS (threshold of 1), 1611 is kept
+  params.max_detections = MAX_DETECTIONS;
+  params.nms_thresh = Q15_TMAX;
+  if (q_face_detection_postprocess(output, &params, &buffers, detections, &num_detections) ||
+      num_detections != 8 || detections[3].prior != 1611) {
+    return 1;
+  }
+  return 0;
+}
+
+// Test the top-k sort with large buckets of close scores.
+int test_q_face_detection_postprocess_sort() {
+  Q_Face_Detection_Post_Params params;
+  Q_Face_Detection_Post_Buffers buffers = {scores, order};
+  ITER_T num_detections;
+  default_params(&params);
+  clear_output();
+
+  // The priors of head 0 do not overlap. Around a probability of 0.5, a bucket of 128 scores spans 64 logits (Q12)
+  for (unsigned k = 0; k < 100; k++) {
+    set_prior(100 + k, (Q15_T)((k * 7) % 60), 0, 0, 0, 0);
+  }
+
+  if (q_face_detection_postprocess(output, &params, &buffers, detections, &num_detections)) {
+    return 1;
+  }
+  if (num_detections != 100) {
+    printf("Detections: %u, Expected: 100\n", num_detections);
+    return 1;
+  }
+  unsigned found[100] = {0};
+  for (unsigned d = 0; d < num_detections; d++) {
+    if (detections[d].prior < 100 || detections[d].prior >= 200 ||
+        found[detections[d].prior - 100]++ || check_score(&detections[d])) {
+      return 1;
+    }
+    if (d > 0 && (detections[d].score > detections[d - 1].score ||
+        (detections[d].score == detections[d - 1].score &&
+         detections[d].prior < detections[d - 1].prior))) {
+      printf("Detection %u (Prior: %u, Score: %d) out of order\n", d, detections[d].prior, detections[d].score);
+      return 1;
+    }
+  }
+  return 0;
+}
+
+// Test the error codes.
+int test_q_face_detection_postprocess_errors() {
+  Q_Face_Detection_Post_Params params;
+  Q_Face_Detection_Post_Buffers buffers = {scores, order};
+  Q_Face_Detection_Post_Buffers no_buffers = {scores, 0};
+  ITER_T num_detections;
+  default_params(&params);
+
+  if (q_face_detection_postprocess(output, &params, &no_buffers, detections, &num_detections) != ERR_FACE_DETECTION_POST_NOT_INIT) {
+    return 1;
+  }
+  params.scale = 17;
+  if (q_face_detection_postprocess(output, &params, &buffers, detections, &num_detections) != ERR_FACE_DETECTION_POST_INVALID_PARAMS) {
+    return 1;
+  }
+  params.scale = OUTPUT_SCALE;
+  params.heads = 0;
+  if (q_face_detection_postprocess(output, &params, &buffers, detections, &num_detections) != ERR_FACE_DETECTION_POST_INVALID_PARAMS) {
+    return 1;
+  }
+  if (q_face_detection_num_priors(q_face_detection_qvga_heads, Q_FACE_DETECTION_QVGA_NUM_HEADS) != NUM_PRIORS) {
+    return 1;
+  }
+  return q_face_detection_num_priors(q_face_detection_qvga_fast_heads, Q_FACE_DETECTION_QVGA_FAST_NUM_HEADS) != NUM_FAST_PRIORS;
+}
+
+int main() {
+  if (test_q_face_detection_postprocess()) {
+    printf("Test Failure for q_face_detection_postprocess()!\n");
+  } else if (test_q_face_detection_postprocess_sort()) {
+    printf("Test Failure for q_face_detection_postprocess() (top-k sort)!\n");
+  } else if (test_q_face_detection_postprocess_errors()) {
+    printf("Test Failure for q_face_detection_postprocess() (error codes)!\n");
+  } else {
+    printf("All Tests Passed!\n");
+    return 0;
+  }
+  return -1;
+}
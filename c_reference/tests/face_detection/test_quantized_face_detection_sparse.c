@@ -10,9 +10,13 @@
 #include "quantized_datatypes.h"
 #include "quantized_face_detection_sparse.h"
 
-#define MEM_BUF_SIZE 188160
+#define MEM_BUF_SIZE FACE_DETECTION_SPARSE_MEM_BUF_SIZE
 #define INPUT_IMG_HEIGHT 240
 #define INPUT_IMG_WIDTH 320
+// Number of threads of the batched (throughput) run
+#ifndef BATCH_THREADS
+  #define BATCH_THREADS 4
+#endif
 #define OUTPUT_SIZE 18000
 
 // Fixed Point Output Corresponding To SCUT-HEAD Face-4 Image: 1
@@ -47,6 +51,13 @@ double compute_error(const Q15_T* const pred, const double* const label,
   return agg_diff;
 }
 
+// Wall clock time in seconds, for the throughput of the multi-threaded runs.
+double wall_time() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
 // Function for computing the 95th percentile deviation among all the outputs.
 double aggregate_error(double* errors, unsigned len) {
   qsort(errors, len, sizeof(double), compare_doubles);
@@ -153,6 +164,9 @@ int main(int argc, char **argv) {
   double* xLine = malloc(INPUT_IMG_HEIGHT * INPUT_IMG_WIDTH * sizeof(double));
   double* yLine = malloc(OUTPUT_SIZE * sizeof(double));
   double* allErrors = malloc(patches * OUTPUT_SIZE * (sizeof(double)));
+  char* batch_mem_buf = malloc((size_t)patches * MEM_BUF_SIZE * sizeof(char));
+  Q15_T* single_outputs = malloc((size_t)patches * OUTPUT_SIZE * sizeof(Q15_T));
+  char* scratch_buf = malloc(q_face_detection_sparse_scratch_size(BATCH_THREADS));
 
   float time_spent = 0.0;
   Q7_T* mem_buf_input_offset = (Q7_T *)mem_buf;
@@ -164,6 +178,8 @@ int main(int argc, char **argv) {
     for (unsigned j = 0; j < INPUT_IMG_HEIGHT * INPUT_IMG_WIDTH; j++) {
       mem_buf_input_offset[j] = (Q7_T)(xLine[j] * pow(2, XScale));
     }
+    memcpy(batch_mem_buf + (size_t)i * MEM_BUF_SIZE, mem_buf,
+           INPUT_IMG_HEIGHT * INPUT_IMG_WIDTH * sizeof(Q7_T));
 
     fprintf(outputLog, "Running Quantized Face Detection Model on Patch %d\n", i + 1);
     clock_t begin = clock();
@@ -180,6 +196,8 @@ int main(int argc, char **argv) {
       double val = ((double)mem_buf_output_offset[j]) / pow(2, YScale);
       fwrite((char*)&val, sizeof(double), 1, yFile);
     }
+    memcpy(single_outputs + i * OUTPUT_SIZE, mem_buf_output_offset,
+           OUTPUT_SIZE * sizeof(Q15_T));
 
     if (i == 0) {
       fprintf(outputLog, "Checking Fixed Point Outputs on Patch 1\n");
@@ -195,6 +213,33 @@ int main(int argc, char **argv) {
     }
   }
 
+  fprintf(outputLog, "Single Frame Throughput: %f FPS (CPU time)\n",
+          patches / time_spent);
+
+  fprintf(outputLog, "Running Quantized Face Detection Model on a Batch of %d Images with %d Threads\n",
+          patches, BATCH_THREADS);
+  double batch_begin = wall_time();
+  q_face_detection_sparse_batch(batch_mem_buf, scratch_buf, patches, BATCH_THREADS);
+  double batch_time = wall_time() - batch_begin;
+  fprintf(outputLog, "Batch Throughput: %f FPS (wall clock time)\n",
+          patches / batch_time);
+
+  int batch_failed = 0;
+  for (unsigned i = 0; i < patches; i++) {
+    const Q15_T* batch_output = (const Q15_T*)(batch_mem_buf +
+      (size_t)i * MEM_BUF_SIZE + FACE_DETECTION_SPARSE_OUTPUT_OFFSET);
+    if (memcmp(batch_output, single_outputs + i * OUTPUT_SIZE,
+               OUTPUT_SIZE * sizeof(Q15_T)) != 0) {
+      fprintf(outputLog, "Batch Output Mismatch on Patch %d\n", i + 1);
+      batch_failed = 1;
+    }
+  }
+  if (batch_failed) {
+    fprintf(outputLog, "Quantized Face Detection Batch Test Failed!\n");
+    return -1;
+  }
+  fprintf(outputLog, "Quantized Face Detection Batch Test Passed!\n");
+
   fclose(xFile);
   fclose(yFile);
   fclose(floatResFile);
@@ -212,6 +257,9 @@ int main(int argc, char **argv) {
   free(xLine);
   free(yLine);
   free(allErrors);
+  free(batch_mem_buf);
+  free(single_outputs);
+  free(scratch_buf);
 
   return 0;
 }
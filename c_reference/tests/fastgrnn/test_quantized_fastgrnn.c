@@ -14,6 +14,43 @@ const Q15_T patch[INPUT_CHANNELS] = {1040, 1919, 4254, 4024};
   const Q15_T expected[HIDDEN_DIM1] = {1423, 7085, -16378, 8209, -12067, 6805, 6475, 6897};
 #endif
 
+#define BATCH 3
+
+// Test the batched cell on a batch of three copies of the patch, stored with a
+// gap between them. Every cell of the batch must produce the same output as the
+// single cell.
+int test_quantized_fastgrnn_batch() {
+  Q15_T patches[BATCH * 2 * INPUT_CHANNELS];
+  Q15_T normFeatures[BATCH * INPUT_CHANNELS];
+  Q15_T buffer[BATCH * HIDDEN_DIM1];
+  Q15_T preComp1[BATCH * HIDDEN_DIM1];
+  Q15_T preComp2[BATCH * HIDDEN_DIM1];
+  Q15_T preComp3[BATCH * HIDDEN_DIM1];
+  Q15_FastGRNN_Buffers batch_buffers = {
+    .preComp1 = preComp1,
+    .preComp2 = preComp2,
+    .preComp3 = preComp3,
+    .normFeatures = normFeatures
+  };
+
+  for (unsigned b = 0; b < BATCH; b++) {
+    memcpy(patches + b * 2 * INPUT_CHANNELS, patch, sizeof(Q15_T) * INPUT_CHANNELS);
+  }
+  memset(buffer, 0, sizeof(Q15_T) * BATCH * HIDDEN_DIM1);
+
+  q15_fastgrnn_batch(buffer, HIDDEN_DIM1, patches, INPUT_CHANNELS,
+                     2 * INPUT_CHANNELS, BATCH, (const void*)(&rnn1_params),
+                     (void*)(&batch_buffers), (const void*)(&rnn1_scales), 0);
+
+  for (unsigned i = 0; i < BATCH * HIDDEN_DIM1; i++){
+    if (buffer[i] != expected[i % HIDDEN_DIM1]) {
+      printf("Output: %d, Expected: %d at Index: %d\n", buffer[i], expected[i % HIDDEN_DIM1], i);
+      return -1;
+    }
+  }
+  return 0;
+}
+
 // Simple test for comparing Seedot's quantized FastGRNN output with our
 // implementation. All values generated from Seedot on Wider Regression dataset.
 // By default, all tests run without using bit-shifting operations.
@@ -33,6 +70,11 @@ int main() {
     }
   }
 
+  if (test_quantized_fastgrnn_batch()) {
+    printf("Batched Quantized FastGRNN Test Failed!\n");
+    return -1;
+  }
+
   printf("All Tests Passed!\n");
   return 0;
 }
@@ -0,0 +1,255 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include "conv1d.h"
+#include "dscnn.h"
+#include "utils.h"
+#include "rnn_bricked.h"
+#include "phoneme_det_cnn_rnn.h"
+
+#include "precnn_params.h"
+#include "rnn_params.h"
+#include "postcnn_params.h"
+
+const unsigned phoneme_in_features = PRE_CNN_IN_FEATURES;
+const unsigned phoneme_out_features = POST_CNN_OUT_FEATURES;
+
+// Describe the size and lifetime of every inter-block tensor and compute the static memory plan
+// The sizes follow the time-step reduction of each block exactly as computed in phoneme_prediction()
+int plan_phoneme_prediction(MemPlan_Tensor* tensors, unsigned in_time, unsigned* peak) {
+  unsigned out_time;
+
+  out_time = in_time - PRE_CNN_FILT + (PRE_CNN_FILT_PAD << 1) + 1;
+  tensors[CNN1_OUT] = (MemPlan_Tensor){ out_time * PRE_CNN_OUT_FEATURES * sizeof(float),
+                                        LAYER_CNN1, LAYER_RNN, 0 };
+
+  out_time = in_time/RNN_HOP + 1;
+  tensors[RNN_OUT] = (MemPlan_Tensor){ out_time * RNN_OUT_FEATURES * sizeof(float),
+                                       LAYER_RNN, LAYER_CNN2, 0 };
+
+  for (unsigned i = CNN2_OUT; i <= PRED; i++) {
+    in_time = out_time;
+    out_time = in_time - POST_CNN_DEPTH_FILT + (POST_CNN_DEPTH_PAD << 1) + 1;
+    out_time = out_time - POST_CNN_POOL + (POST_CNN_POOL_PAD << 1) + 1;
+    unsigned features = (i == PRED) ? POST_CNN_OUT_FEATURES : POST_CNN_INTER_FEATURES;
+    // The tensor produced by CNN(k) is consumed by CNN(k + 1). The final prediction is read by the output check
+    tensors[i] = (MemPlan_Tensor){ out_time * features * sizeof(float),
+                                   LAYER_CNN2 + i - CNN2_OUT, LAYER_CNN2 + i - CNN2_OUT + 1, 0 };
+  }
+
+  return plan_static_memory(tensors, NUM_TENSORS, sizeof(float), peak);
+}
+
+/* CNN-RNN based Phoneme Detection Model
+ 
+  The phoneme detection model used consists of 6 blocks.
+  1st block is a CNN, where kernel size is 5 and regular tanh activation
+  2nd block is an RNN, which has a specified forward and a backward context running at a stride/hop of 3.
+  Hence it reduces the sequence length by a factor of 3.
+  Rest of the blocks(3rd, 4th, 5th and 6th) are a combination of CNNs
+  Each of the final 4 blocks consist of a depth cnn (kernel size of 5) and a point cnn (kernel size of 1)
+
+  Input to the architecture is of the form (seq_len, feature_dim) where feature dim refers to n_mels (number of mel features/number of features from the featurizer).
+  Output is of the form (seq_len/3, 41) where 41 is the number of phonemes over which the classification is performed. 
+  Phonemes are predicted for every 3rd time frame, operating under the assumption that they don't vary faster than that.
+
+  Returns the number of output time steps, the prediction is at the offset plan[PRED].offset of the arena.
+  The outputs of the blocks are placed in a single pre-allocated buffer(arena) at the offsets computed by plan_phoneme_prediction().
+  Tensors which are no longer live share memory with the later ones, hence the arena only needs to hold the peak of the inter-block tensors.
+  The scratch buffers inside each block are allocated and freed by the block.
+
+  NOTE: Before deployment for real-time streaming applications, we would need to make minor modification
+  These changes are subject to the input specs i.e fixing input buffer time steps, number of features from the deployed featurizer, method of reading the input into a buffer
+*/
+unsigned phoneme_prediction(float* mem_buf, unsigned in_time, char* const arena, const MemPlan_Tensor* plan) {
+  ConvLayers_LR_Parallel_Params conv_params = {
+    .W1 = CNN1_W1,
+    .W2 = CNN1_W2,
+    .B = CNN1_BIAS,
+    .rank = PRE_CNN_LOW_RANK,
+    .block_size_to_lr = 100,
+    .block_size_from_lr = 100,
+  };
+
+  ConvLayers_Params depth_param_2 = {
+    .W = CNN2_DEPTH_W,
+    .B = CNN2_DEPTH_BIAS,
+    .depthwise = 1,
+  };
+
+  ConvLayers_LR_Parallel_Params point_param_2 = {
+    .W1 = CNN2_POINT_W1,
+    .W2 = CNN2_POINT_W2,
+    .B = CNN2_POINT_BIAS,
+    .rank = POST_CNN_LOW_RANK,
+    .block_size_to_lr = 100,
+    .block_size_from_lr = 100,
+  };
+
+  ConvLayers_Params depth_param_3 = {
+    .W = CNN3_DEPTH_W,
+    .B = CNN3_DEPTH_BIAS,
+    .depthwise = 1,
+  };
+
+  ConvLayers_LR_Parallel_Params point_param_3 = {
+    .W1 = CNN3_POINT_W1,
+    .W2 = CNN3_POINT_W2,
+    .B = CNN3_POINT_BIAS,
+    .rank = POST_CNN_LOW_RANK,
+    .block_size_to_lr = 100,
+    .block_size_from_lr = 100,
+  };
+
+  ConvLayers_Params depth_param_4 = {
+    .W = CNN4_DEPTH_W,
+    .B = CNN4_DEPTH_BIAS,
+    .depthwise = 1,
+  };
+
+  ConvLayers_LR_Parallel_Params point_param_4 = {
+    .W1 = CNN4_POINT_W1,
+    .W2 = CNN4_POINT_W2,
+    .B = CNN4_POINT_BIAS,
+    .rank = POST_CNN_LOW_RANK,
+    .block_size_to_lr = 100,
+    .block_size_from_lr = 100,
+  };
+
+  ConvLayers_Params depth_param_5 = {
+    .W = CNN5_DEPTH_W,
+    .B = CNN5_DEPTH_BIAS,
+    .depthwise = 1,
+  };
+
+  ConvLayers_LR_Parallel_Params point_param_5 = {
+    .W1 = CNN5_POINT_W1,
+    .W2 = CNN5_POINT_W2,
+    .B = CNN5_POINT_BIAS,
+    .rank = POST_CNN_LOW_RANK,
+    .block_size_to_lr = 100,
+    .block_size_from_lr = 100,
+  };
+
+  BrickedFastGRNN_LR_Params bwd_RNN_params = {
+    .W1     = B_W1,
+    .W2     = B_W2,
+    .wRank  = RNN_LOW_RANK,
+    .U1     = B_U1,
+    .U2     = B_U2,
+    .uRank  = RNN_LOW_RANK,
+    .Bg     = B_BIAS_GATE,
+    .Bh     = B_BIAS_UPDATE,
+    .sigmoid_zeta = sigmoid(B_ZETA),
+    .sigmoid_nu   = sigmoid(B_NU),
+    .block_size_u_from_lr = 100,
+    .block_size_u_to_lr = 100,
+    .block_size_w_from_lr = 100,
+    .block_size_w_to_lr = 100,
+  };
+
+  BrickedFastGRNN_LR_Params fwd_RNN_params = {
+    .W1     = F_W1,
+    .W2     = F_W2,
+    .wRank  = RNN_LOW_RANK,
+    .U1     = F_U1,
+    .U2     = F_U2,
+    .uRank  = RNN_LOW_RANK,
+    .Bg     = F_BIAS_GATE,
+    .Bh     = F_BIAS_UPDATE,
+    .sigmoid_zeta = sigmoid(F_ZETA),
+    .sigmoid_nu   = sigmoid(F_NU),
+    .block_size_u_from_lr = 100,
+    .block_size_u_to_lr = 100,
+    .block_size_w_from_lr = 100,
+    .block_size_w_to_lr = 100,
+  };
+
+  unsigned out_time;
+
+  /* Pre-CNN */
+  out_time = in_time - PRE_CNN_FILT + (PRE_CNN_FILT_PAD << 1) + 1;
+  float* cnn1_out = (float*)(arena + plan[CNN1_OUT].offset);
+  // Since batchnorm1d is the first layer and in-place will alter the input. 
+  // Use the in-place computation only if the input can be discarded/altered. Else avoid in-place computation for this layer
+  phon_pred_lr_cnn(cnn1_out, mem_buf,
+    conv1d_lr_parallel, in_time, PRE_CNN_IN_FEATURES,
+    0, 0, PRE_CNN_BNORM_AFFINE, CNN1_SCALE, CNN1_OFFSET, PRE_CNN_BNORM_INPLACE,
+    PRE_CNN_OUT_FEATURES, PRE_CNN_FILT_PAD, PRE_CNN_FILT,
+    &conv_params, PRE_CNN_STRIDE, PRE_CNN_FILT_ACT); // regular tanh activation
+
+  batchnorm1d(0, cnn1_out, in_time, RNN_IN_FEATURES, 
+    0, 0, RNN_BNORM_AFFINE, RNN_SCALE, RNN_OFFSET, 1, 0.00001);
+
+  /* Bricked Bi-FastGRNN Block */
+  out_time = in_time/RNN_HOP + 1;
+  float* rnn_out = (float*)(arena + plan[RNN_OUT].offset);
+  forward_bricked_fastgrnn_lr(rnn_out, RNN_OUT_FEATURES >> 1, cnn1_out,
+    in_time, RNN_IN_FEATURES, RNN_FWD_WINDOW, RNN_HOP,
+    &fwd_RNN_params, RNN_BI_DIR, RNN_SAMPLE_FIRST_BRICK);
+
+  backward_bricked_fastgrnn_lr(rnn_out + (RNN_OUT_FEATURES >> 1), 
+    RNN_OUT_FEATURES >> 1, cnn1_out,
+    in_time, RNN_IN_FEATURES, RNN_BWD_WINDOW, RNN_HOP,
+    &bwd_RNN_params, RNN_BI_DIR, RNN_SAMPLE_LAST_BRICK);
+
+  /* Post-CNN */
+  // Since all inputs to the subsequent layers are temporary, in-place batchnorm1d can be used without any input(initial buffer)/output(final layer) data alteration/corruption
+  // CNN2
+  in_time = out_time;
+  out_time = in_time - POST_CNN_DEPTH_FILT + (POST_CNN_DEPTH_PAD << 1) + 1;
+  out_time = out_time - POST_CNN_POOL + (POST_CNN_POOL_PAD << 1) + 1;
+  float* cnn2_out = (float*)(arena + plan[CNN2_OUT].offset);
+  phon_pred_depth_point_lr_cnn(cnn2_out, rnn_out,
+    conv1d_lr_parallel, in_time, POST_CNN_INTER_FEATURES,
+    0, 0, POST_CNN_BNORM_AFFINE, CNN2_SCALE, CNN2_OFFSET, POST_CNN_BNORM_INPLACE,
+    POST_CNN_DEPTH_PAD, POST_CNN_DEPTH_FILT,
+    &depth_param_2, POST_CNN_DEPTH_STRIDE, POST_CNN_DEPTH_ACT,
+    POST_CNN_INTER_FEATURES, POST_CNN_POINT_PAD, POST_CNN_POINT_FILT,
+    &point_param_2, POST_CNN_POINT_STRIDE, POST_CNN_POINT_ACT,
+    POST_CNN_POOL_PAD, POST_CNN_POOL, POST_CNN_POOL_STRIDE, POST_CNN_POOL_ACT);
+
+  // CNN3
+  in_time = out_time;
+  out_time = in_time - POST_CNN_DEPTH_FILT + (POST_CNN_DEPTH_PAD << 1) + 1;
+  out_time = out_time - POST_CNN_POOL + (POST_CNN_POOL_PAD << 1) + 1;
+  float* cnn3_out = (float*)(arena + plan[CNN3_OUT].offset);
+  phon_pred_depth_point_lr_cnn(cnn3_out, cnn2_out,
+    conv1d_lr_parallel, in_time, POST_CNN_INTER_FEATURES,
+    0, 0, POST_CNN_BNORM_AFFINE, CNN3_SCALE, CNN3_OFFSET, POST_CNN_BNORM_INPLACE,
+    POST_CNN_DEPTH_PAD, POST_CNN_DEPTH_FILT,
+    &depth_param_3, POST_CNN_DEPTH_STRIDE, POST_CNN_DEPTH_ACT,
+    POST_CNN_INTER_FEATURES, POST_CNN_POINT_PAD, POST_CNN_POINT_FILT,
+    &point_param_3, POST_CNN_POINT_STRIDE, POST_CNN_POINT_ACT,
+    POST_CNN_POOL_PAD, POST_CNN_POOL, POST_CNN_POOL_STRIDE, POST_CNN_POOL_ACT);
+
+  // CNN4
+  in_time = out_time;
+  out_time = in_time - POST_CNN_DEPTH_FILT + (POST_CNN_DEPTH_PAD << 1) + 1;
+  out_time = out_time - POST_CNN_POOL + (POST_CNN_POOL_PAD << 1) + 1;
+  float* cnn4_out = (float*)(arena + plan[CNN4_OUT].offset);
+  phon_pred_depth_point_lr_cnn(cnn4_out, cnn3_out,
+    conv1d_lr_parallel, in_time, POST_CNN_INTER_FEATURES,
+    0, 0, POST_CNN_BNORM_AFFINE, CNN4_SCALE, CNN4_OFFSET, POST_CNN_BNORM_INPLACE,
+    POST_CNN_DEPTH_PAD, POST_CNN_DEPTH_FILT,
+    &depth_param_4, POST_CNN_DEPTH_STRIDE, POST_CNN_DEPTH_ACT,
+    POST_CNN_INTER_FEATURES, POST_CNN_POINT_PAD, POST_CNN_POINT_FILT,
+    &point_param_4, POST_CNN_POINT_STRIDE, POST_CNN_POINT_ACT,
+    POST_CNN_POOL_PAD, POST_CNN_POOL, POST_CNN_POOL_STRIDE, POST_CNN_POOL_ACT);
+
+  // CNN5
+  in_time = out_time;
+  out_time = in_time - POST_CNN_DEPTH_FILT + (POST_CNN_DEPTH_PAD << 1) + 1;
+  out_time = out_time - POST_CNN_POOL + (POST_CNN_POOL_PAD << 1) + 1;
+  float* pred = (float*)(arena + plan[PRED].offset);
+  phon_pred_depth_point_lr_cnn(pred, cnn4_out,
+    conv1d_lr_parallel, in_time, POST_CNN_INTER_FEATURES,
+    0, 0, POST_CNN_BNORM_AFFINE, CNN5_SCALE, CNN5_OFFSET, POST_CNN_BNORM_INPLACE,
+    POST_CNN_DEPTH_PAD, POST_CNN_DEPTH_FILT,
+    &depth_param_5, POST_CNN_DEPTH_STRIDE, POST_CNN_DEPTH_ACT,
+    POST_CNN_OUT_FEATURES, POST_CNN_POINT_PAD, POST_CNN_POINT_FILT,
+    &point_param_5, POST_CNN_POINT_STRIDE, POST_CNN_POINT_ACT,
+    POST_CNN_POOL_PAD, POST_CNN_POOL, POST_CNN_POOL_STRIDE, POST_CNN_POOL_ACT);
+
+  return out_time;
+}
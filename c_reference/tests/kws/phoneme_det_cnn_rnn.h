@@ -0,0 +1,49 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#ifndef __PHONEME_DET_CNN_RNN_H__
+#define __PHONEME_DET_CNN_RNN_H__
+
+// CNN-RNN phoneme detection pipeline, shared by the test and the benchmark
+// The pipeline and its weights are compiled once in phoneme_det_cnn_rnn.c
+#include "mem_planner.h"
+
+// Number of input features per time step and of phonemes predicted per output time step
+extern const unsigned phoneme_in_features;
+extern const unsigned phoneme_out_features;
+
+// Inter-block tensors of the pipeline, in the order of the layers producing them
+// Only the outputs of the blocks are planned. The scratch buffers inside a block are still allocated by the block
+// itself: the batchnorm, activation, depthwise and pointwise outputs of dscnn.c, the low-rank and output buffers of
+// conv1d.c and the low-rank buffer of rnn_bricked.c. They come on top of the planned peak
+enum {
+  CNN1_OUT = 0,
+  RNN_OUT,
+  CNN2_OUT,
+  CNN3_OUT,
+  CNN4_OUT,
+  PRED,
+  NUM_TENSORS
+};
+
+// Layer indices. A tensor is live from the layer producing it up to the last layer consuming it
+enum {
+  LAYER_CNN1 = 0,
+  LAYER_RNN,
+  LAYER_CNN2,
+  LAYER_CNN3,
+  LAYER_CNN4,
+  LAYER_CNN5,
+  LAYER_CHECK
+};
+
+// Describe the size and lifetime of every inter-block tensor of a KWS_IN_TIME = in_time input and compute the static memory plan
+// Returns the error code of plan_static_memory()
+int plan_phoneme_prediction(MemPlan_Tensor* tensors, unsigned in_time, unsigned* peak);
+
+// Run the pipeline on an input of in_time steps of PRE_CNN_IN_FEATURES features, with the outputs of the blocks placed
+// in the arena at the offsets of the plan computed by plan_phoneme_prediction() for the same in_time
+// Returns the number of output time steps, the prediction is at the offset plan[PRED].offset of the arena
+unsigned phoneme_prediction(float* mem_buf, unsigned in_time, char* const arena, const MemPlan_Tensor* plan);
+
+#endif
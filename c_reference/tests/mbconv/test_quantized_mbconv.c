@@ -7,6 +7,7 @@
 #include <string.h>
 
 #include "quantized_mbconv.h"
+#include "quantized_sparse_conv.h"
 #include "q_wider_regression_model/mbconv.h"
 
 // Comparator function for sorting floats.
@@ -41,6 +42,200 @@ float aggregate_error(float* errors, unsigned len) {
   return errors[index];
 }
 
+// Shapes of the tests of the threaded blocks against the single-threaded ones.
+// With 5 threads, the bottom bands of the first shape get fewer input rows than
+// the margin of its filter, and the top band of the second one is clipped
+typedef struct Threaded_Shape {
+  ITER_T batch, rows, cols, in_channels, temp_channels, filter_rows,
+    filter_cols, out_channels;
+  S_ITER_T pad_top, pad_bottom, pad_left, pad_right;
+  ITER_T stride_rows, stride_cols;
+} Threaded_Shape;
+
+static const Threaded_Shape threaded_shapes[] = {
+  {2, 6, 2, 3, 4, 5, 3, 3, 1, 2, 1, 1, 1, 1},
+  {1, 11, 5, 4, 6, 3, 3, 5, 1, 1, 1, 1, 2, 2},
+  {2, 9, 4, 2, 5, 3, 3, 4, 0, 0, 0, 0, 1, 1},
+};
+
+#define THREADED_SHAPES (sizeof(threaded_shapes) / sizeof(threaded_shapes[0]))
+#define THREADED_VARIANTS 7
+#define THREADED_MAX_THREADS 7
+#define THREADED_MAX_SIZE 512
+#define THREADED_MAX_FILTER 64
+#define THREADED_MAX_BUFFER1 128
+#define THREADED_MAX_CTEMP 8
+
+#ifdef SHIFT
+  #define THREADED_SHR 2
+  #define THREADED_SHL 0
+#else
+  #define THREADED_SHR 4
+  #define THREADED_SHL 1
+#endif
+
+// The inputs are allocated with the size of each shape, for the address
+// sanitizer to catch the reads past their end
+static Q15_T t_input_values[THREADED_MAX_SIZE];
+static Q15_T* t_input;
+static Q7_T* t_input_q7;
+static Q15_T t_filters[3][THREADED_MAX_FILTER];
+static Q7_T t_filters_q7[3][THREADED_MAX_FILTER];
+static Q15_T t_bn[6][THREADED_MAX_CTEMP];
+static Q7_T t_bn_q7[6][THREADED_MAX_CTEMP];
+static Q15_Sparse_Filter t_sparse[3];
+static ITER_T t_row_ptr[3][THREADED_MAX_FILTER + 1];
+static ITER_T t_col_idx[3][THREADED_MAX_FILTER];
+static Q15_T t_values[3][THREADED_MAX_FILTER];
+static Q15_T t_buffer1[THREADED_MAX_BUFFER1], t_buffer2[THREADED_MAX_CTEMP];
+static Q15_T t_band_buffers[(THREADED_MAX_THREADS - 1) * (THREADED_MAX_BUFFER1 + THREADED_MAX_CTEMP)];
+static Q15_T t_expected[THREADED_MAX_SIZE], t_pred[THREADED_MAX_SIZE];
+
+// Arguments of the blocks from N to WStride, and from shrU1 to shlW3
+#define THREADED_SHAPE_ARGS(s, HOut, WOut) (s)->batch, (s)->rows, (s)->cols, \
+  (s)->in_channels, (s)->temp_channels, (s)->filter_rows, (s)->filter_cols, \
+  (s)->out_channels, HOut, WOut, (s)->pad_top, (s)->pad_bottom, \
+  (s)->pad_left, (s)->pad_right, (s)->stride_rows, (s)->stride_cols
+#define THREADED_SCALE_ARGS THREADED_SHR, THREADED_SHR, THREADED_SHR, \
+  THREADED_SHR, THREADED_SHR, THREADED_SHR, THREADED_SHL, THREADED_SHL, \
+  THREADED_SHL, THREADED_SHL, THREADED_SHL, THREADED_SHL
+
+// Runs the threaded block of variant v (q7, q7xq15_q15, q15xq7_q7,
+// q15xq7_q15, q15, and the sparse q7xq15_q15 and q15) on shape s
+static void run_threaded_variant(unsigned v, const Threaded_Shape* s,
+  ITER_T HOut, ITER_T WOut, void* output, void* bandBuffers,
+  size_t bandBuffersSize, ITER_T num_threads) {
+  switch (v) {
+    case 0:
+      q7_mbconv_block_threaded(t_input_q7, t_filters_q7[0], t_bn_q7[0],
+        t_bn_q7[1], t_filters_q7[1], t_bn_q7[2], t_bn_q7[3], t_filters_q7[2],
+        t_bn_q7[4], t_bn_q7[5], (Q7_T*)output, (Q7_T*)t_buffer1,
+        (Q7_T*)t_buffer2, THREADED_SHAPE_ARGS(s, HOut, WOut), 100, 100,
+        THREADED_SCALE_ARGS, bandBuffers, bandBuffersSize, num_threads);
+      break;
+    case 1:
+      q7xq15_q15_mbconv_block_threaded(t_input_q7, t_filters[0], t_bn[0],
+        t_bn[1], t_filters[1], t_bn[2], t_bn[3], t_filters[2], t_bn[4],
+        t_bn[5], (Q15_T*)output, t_buffer1, t_buffer2,
+        THREADED_SHAPE_ARGS(s, HOut, WOut), 2000, 2000, THREADED_SCALE_ARGS,
+        bandBuffers, bandBuffersSize, num_threads);
+      break;
+    case 2:
+      q15xq7_q7_mbconv_block_threaded(t_input, t_filters_q7[0], t_bn_q7[0],
+        t_bn[1], t_filters_q7[1], t_bn_q7[2], t_bn[3], t_filters_q7[2],
+        t_bn_q7[4], t_bn[5], (Q7_T*)output, t_buffer1, t_buffer2,
+        THREADED_SHAPE_ARGS(s, HOut, WOut), 2000, 2000, THREADED_SCALE_ARGS,
+        bandBuffers, bandBuffersSize, num_threads);
+      break;
+    case 3:
+      q15xq7_q15_mbconv_block_threaded(t_input, t_filters_q7[0], t_bn_q7[0],
+        t_bn[1], t_filters_q7[1], t_bn_q7[2], t_bn[3], t_filters_q7[2],
+        t_bn_q7[4], t_bn[5], (Q15_T*)output, t_buffer1, t_buffer2,
+        THREADED_SHAPE_ARGS(s, HOut, WOut), 2000, 2000, THREADED_SCALE_ARGS,
+        bandBuffers, bandBuffersSize, num_threads);
+      break;
+    case 4:
+      q15_mbconv_block_threaded(t_input, t_filters[0], t_bn[0], t_bn[1],
+        t_filters[1], t_bn[2], t_bn[3], t_filters[2], t_bn[4], t_bn[5],
+        (Q15_T*)output, t_buffer1, t_buffer2,
+        THREADED_SHAPE_ARGS(s, HOut, WOut), 2000, 2000, THREADED_SCALE_ARGS,
+        bandBuffers, bandBuffersSize, num_threads);
+      break;
+    case 5:
+      q7xq15_q15_sparse_mbconv_block_threaded(t_input_q7, &t_sparse[0],
+        t_bn[0], t_bn[1], &t_sparse[1], t_bn[2], t_bn[3], &t_sparse[2],
+        t_bn[4], t_bn[5], (Q15_T*)output, t_buffer1, t_buffer2,
+        THREADED_SHAPE_ARGS(s, HOut, WOut), 2000, 2000, THREADED_SCALE_ARGS,
+        bandBuffers, bandBuffersSize, num_threads);
+      break;
+    default:
+      q15_sparse_mbconv_block_threaded(t_input, &t_sparse[0], t_bn[0],
+        t_bn[1], &t_sparse[1], t_bn[2], t_bn[3], &t_sparse[2], t_bn[4],
+        t_bn[5], (Q15_T*)output, t_buffer1, t_buffer2,
+        THREADED_SHAPE_ARGS(s, HOut, WOut), 2000, 2000, THREADED_SCALE_ARGS,
+        bandBuffers, bandBuffersSize, num_threads);
+      break;
+  }
+}
+
+// Test the threaded blocks, with random weights, against the same blocks on
+// one thread. Returns the number of runs with a differing output
+unsigned test_mbconv_block_threaded(FILE* outputLog) {
+  // The last run has the buffers of fewer bands than threads
+  const ITER_T threads[] = {2, 3, 5, THREADED_MAX_THREADS, 5};
+  const unsigned runs = sizeof(threads) / sizeof(threads[0]);
+  unsigned failures = 0;
+
+  srand(7);
+  for (unsigned i = 0; i < THREADED_MAX_SIZE; i++) {
+    t_input_values[i] = (Q15_T)(rand() % 129 - 64);
+  }
+  for (unsigned f = 0; f < 3; f++) {
+    for (unsigned i = 0; i < THREADED_MAX_FILTER; i++) {
+      // The sparse blocks run on the same filters, pruned to one weight in 16
+      t_filters[f][i] = (i % 16 == 0) ? (Q15_T)(rand() % 17 - 8) : 0;
+      t_filters_q7[f][i] = (Q7_T)t_filters[f][i];
+    }
+  }
+  for (unsigned b = 0; b < 6; b++) {
+    for (unsigned i = 0; i < THREADED_MAX_CTEMP; i++) {
+      t_bn[b][i] = (Q15_T)((b % 2) ? rand() % 33 - 16 : rand() % 4 + 1);
+      t_bn_q7[b][i] = (Q7_T)t_bn[b][i];
+    }
+  }
+
+  for (unsigned k = 0; k < THREADED_SHAPES; k++) {
+    const Threaded_Shape* s = &threaded_shapes[k];
+    ITER_T HOut = (ITER_T)(((S_ITER_T)s->rows + s->pad_top + s->pad_bottom -
+                            (S_ITER_T)s->filter_rows) / (S_ITER_T)s->stride_rows + 1);
+    ITER_T WOut = (ITER_T)(((S_ITER_T)s->cols + s->pad_left + s->pad_right -
+                            (S_ITER_T)s->filter_cols) / (S_ITER_T)s->stride_cols + 1);
+    size_t one_band = (s->filter_rows * s->cols * s->temp_channels +
+                       s->temp_channels) * sizeof(Q15_T);
+    size_t in_len = (size_t)s->batch * s->rows * s->cols * s->in_channels;
+    t_input = malloc(in_len * sizeof(Q15_T));
+    t_input_q7 = malloc(in_len * sizeof(Q7_T));
+    for (size_t i = 0; i < in_len; i++) {
+      t_input[i] = t_input_values[i];
+      t_input_q7[i] = (Q7_T)t_input_values[i];
+    }
+    if (q15_sparse_filter_pack(t_filters[0], 1, 1, s->in_channels, s->temp_channels, 1,
+          t_row_ptr[0], t_col_idx[0], t_values[0], THREADED_MAX_FILTER, &t_sparse[0]) ||
+        q15_sparse_filter_pack(t_filters[1], s->filter_rows, s->filter_cols, 1, 1, s->temp_channels,
+          t_row_ptr[1], t_col_idx[1], t_values[1], THREADED_MAX_FILTER, &t_sparse[1]) ||
+        q15_sparse_filter_pack(t_filters[2], 1, 1, s->temp_channels, s->out_channels, 1,
+          t_row_ptr[2], t_col_idx[2], t_values[2], THREADED_MAX_FILTER, &t_sparse[2])) {
+      fprintf(outputLog, "The filters of threaded shape %u could not be packed\n", k);
+      failures++;
+      free(t_input);
+      free(t_input_q7);
+      continue;
+    }
+
+    for (unsigned v = 0; v < THREADED_VARIANTS; v++) {
+      // The q7 and q15xq7_q7 blocks have Q7 outputs
+      size_t out_bytes = (size_t)s->batch * HOut * WOut * s->out_channels *
+                         ((v == 0 || v == 2) ? sizeof(Q7_T) : sizeof(Q15_T));
+      memset(t_expected, 0, sizeof(t_expected));
+      run_threaded_variant(v, s, HOut, WOut, t_expected, NULL, 0, 1);
+
+      for (unsigned t = 0; t < runs; t++) {
+        memset(t_pred, 0, sizeof(t_pred));
+        run_threaded_variant(v, s, HOut, WOut, t_pred, t_band_buffers,
+          t + 1 < runs ? sizeof(t_band_buffers) : one_band, threads[t]);
+        if (memcmp(t_pred, t_expected, out_bytes)) {
+          fprintf(outputLog, "Threaded MBConv variant %u on shape %u differs with %u threads\n",
+                  v, k, (unsigned)threads[t]);
+          failures++;
+        }
+      }
+    }
+    free(t_input);
+    free(t_input_q7);
+  }
+  return failures;
+}
+
 /**
  *  By default, all tests run without using bit-shifting operations.
  */
@@ -189,6 +384,12 @@ int main(int argc, char **argv) {
   }
 
   fprintf(outputLog, "Quantized MBConv Fixed Point Test Passed!\n");
+
+  if (test_mbconv_block_threaded(outputLog)) {
+    fprintf(outputLog, "Quantized MBConv Threaded Test Failed!\n");
+    return -1;
+  }
+  fprintf(outputLog, "Quantized MBConv Threaded Test Passed!\n");
   free(reshapedXLine);
   free(output_test);
   free(X);
@@ -0,0 +1,183 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "mem_planner.h"
+
+// Hand-made lifetimes for plan_static_memory(). Every plan is checked for
+// tensors with overlapping lifetimes sharing memory, aligned offsets and a
+// peak between the largest live total of a layer and the no-reuse total.
+static unsigned aligned_size(unsigned size, unsigned alignment) {
+  if (alignment <= 1) {
+    return size;
+  }
+  return ((size + alignment - 1) / alignment) * alignment;
+}
+
+static int check_plan(const MemPlan_Tensor* tensors, unsigned num_tensors,
+                      unsigned alignment, unsigned peak) {
+  unsigned max_layer = 0;
+  for (unsigned i = 0; i < num_tensors; i++) {
+    const MemPlan_Tensor* a = &tensors[i];
+    if (alignment > 1 && a->offset % alignment) {
+      printf("Tensor %u: offset %u is not aligned to %u\n", i, a->offset, alignment);
+      return 1;
+    }
+    if (a->offset + a->size > peak) {
+      printf("Tensor %u: [%u, %u) is beyond the peak %u\n", i, a->offset, a->offset + a->size, peak);
+      return 1;
+    }
+    for (unsigned j = i + 1; j < num_tensors; j++) {
+      const MemPlan_Tensor* b = &tensors[j];
+      unsigned live = a->first_use <= b->last_use && b->first_use <= a->last_use;
+      unsigned shared = a->offset < b->offset + b->size && b->offset < a->offset + a->size;
+      if (live && shared) {
+        printf("Tensors %u and %u are live at the same time and share memory\n", i, j);
+        return 1;
+      }
+    }
+    if (a->last_use > max_layer) {
+      max_layer = a->last_use;
+    }
+  }
+
+  for (unsigned layer = 0; layer <= max_layer; layer++) {
+    unsigned live = 0;
+    for (unsigned i = 0; i < num_tensors; i++) {
+      if (tensors[i].first_use <= layer && layer <= tensors[i].last_use) {
+        live += aligned_size(tensors[i].size, alignment);
+      }
+    }
+    if (peak < live) {
+      printf("Peak %u is below the %u bytes live at layer %u\n", peak, live, layer);
+      return 1;
+    }
+  }
+  if (peak > naive_memory_size(tensors, num_tensors, alignment)) {
+    printf("Peak %u is above the no-reuse total\n", peak);
+    return 1;
+  }
+  return 0;
+}
+
+// A -> B -> C -> D: the tensors two layers apart share memory
+int test_chain() {
+  MemPlan_Tensor tensors[4] = {
+    { 400, 0, 1, 0 },
+    { 300, 1, 2, 0 },
+    { 400, 2, 3, 0 },
+    { 100, 3, 4, 0 },
+  };
+  unsigned peak;
+  if (plan_static_memory(tensors, 4, 0, &peak) || check_plan(tensors, 4, 0, peak)) {
+    return 1;
+  }
+  return peak != 700 || tensors[0].offset != tensors[2].offset;
+}
+
+// A long-lived tensor alongside short ones, with a layer where only it is live
+int test_overlaps_and_gaps() {
+  MemPlan_Tensor tensors[7] = {
+    { 1000, 0, 6, 0 },  // live during the whole pipeline
+    {  600, 0, 1, 0 },
+    {  200, 1, 2, 0 },
+    {  500, 2, 3, 0 },
+    {  100, 3, 3, 0 },
+    {  800, 5, 6, 0 },  // layer 4 is a gap for every tensor but the first
+    {  300, 6, 7, 0 },
+  };
+  unsigned peak;
+  if (plan_static_memory(tensors, 7, 0, &peak) || check_plan(tensors, 7, 0, peak)) {
+    return 1;
+  }
+  // The largest live total is 2100 bytes at layer 6
+  return peak != 2100;
+}
+
+// A freed large tensor leaves a gap below a live one, reused by the smaller tensors
+int test_best_fit() {
+  MemPlan_Tensor tensors[4] = {
+    { 1000, 0, 1, 0 },
+    {  500, 0, 3, 0 },
+    {  600, 2, 3, 0 },
+    {  300, 2, 3, 0 },
+  };
+  unsigned peak;
+  if (plan_static_memory(tensors, 4, 0, &peak) || check_plan(tensors, 4, 0, peak)) {
+    return 1;
+  }
+  return peak != 1500;
+}
+
+// Sizes which are not multiples of the alignment
+int test_alignment() {
+  MemPlan_Tensor tensors[5] = {
+    { 13, 0, 1, 0 },
+    {  7, 1, 2, 0 },
+    { 33, 1, 3, 0 },
+    {  1, 2, 2, 0 },
+    { 20, 3, 4, 0 },
+  };
+  unsigned peak;
+  if (plan_static_memory(tensors, 5, 16, &peak)) {
+    return 1;
+  }
+  return check_plan(tensors, 5, 16, peak);
+}
+
+// Random lifetimes and sizes, some of the tensors being used by a single layer
+int test_random() {
+  MemPlan_Tensor tensors[40];
+  unsigned seed = 12345;
+  for (unsigned t = 0; t < 200; t++) {
+    unsigned num_tensors = 1 + t % 40;
+    for (unsigned i = 0; i < num_tensors; i++) {
+      seed = seed * 1103515245 + 12345;
+      unsigned first_use = (seed >> 8) % 20;
+      seed = seed * 1103515245 + 12345;
+      unsigned length = (seed >> 8) % 6;
+      seed = seed * 1103515245 + 12345;
+      tensors[i] = (MemPlan_Tensor){ 1 + (seed >> 8) % 4096, first_use, first_use + length, 0 };
+    }
+    unsigned peak, alignment = (t & 1) ? 4 : 0;
+    if (plan_static_memory(tensors, num_tensors, alignment, &peak) ||
+        check_plan(tensors, num_tensors, alignment, peak)) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+int test_invalid() {
+  MemPlan_Tensor tensors[2] = {
+    { 100, 0, 1, 0 },
+    { 100, 3, 2, 0 },
+  };
+  unsigned peak = 1;
+  if (plan_static_memory(tensors, 0, 0, &peak) || peak != 0) {
+    return 1;
+  }
+  return plan_static_memory(tensors, 2, 0, &peak) != ERR_MEM_PLAN_INVALID_TENSOR;
+}
+
+int main() {
+  if (test_chain()) {
+    printf("Test Failure for a chain of tensors!\n");
+  } else if (test_overlaps_and_gaps()) {
+    printf("Test Failure for overlapping lifetimes with gaps!\n");
+  } else if (test_best_fit()) {
+    printf("Test Failure for the reuse of a freed tensor!\n");
+  } else if (test_alignment()) {
+    printf("Test Failure for the aligned offsets!\n");
+  } else if (test_random()) {
+    printf("Test Failure for random lifetimes!\n");
+  } else if (test_invalid()) {
+    printf("Test Failure for invalid lifetimes!\n");
+  } else {
+    printf("All Tests Passed!\n");
+    return 0;
+  }
+
+  return -1;
+}
@@ -0,0 +1,234 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "quantized_model_blob.h"
+#include "../rnnpool/q_wider_regression_model/rnn1.h"
+#include "../rnnpool/q_wider_regression_model/rnn2.h"
+
+// The weights are packed from the compiled-in headers of the Wider Regression model, loaded back from the blob file,
+// and the layers are run with both. The outputs have to be bit-exact
+#define BLOB_PATH "test_quantized_model_blob.bin"
+#define STEPS 8
+
+static Q_Model_Blob_Packer packer;
+
+static void fill_input(Q15_T* input, unsigned len, unsigned seed, Q15_T range) {
+  srand(seed);
+  for (unsigned i = 0; i < len; i++) {
+    input[i] = (Q15_T)(rand() % (2 * range + 1) - range);
+  }
+}
+
+static int check_output_q15(const Q15_T* const pred, const Q15_T* const expected,
+                            unsigned len) {
+  for (unsigned i = 0; i < len; i++)
+  {
+    if (pred[i] != expected[i]) {
+      printf("Output: %d, Expected: %d at Index: %d\n", pred[i], expected[i], i);
+      return 1;
+    }
+  }
+  return 0;
+}
+
+// Pointers loaded from a mapped blob have to point into the mapping
+static int in_blob(const Q_Model_Blob* blob, const void* ptr) {
+  const unsigned char* p = (const unsigned char*)ptr;
+  return p >= blob->data && p < blob->data + blob->size;
+}
+
+// Test q_model_blob_q15_fastgrnn() against the compiled-in FastGRNN cells.
+int test_q_model_blob_fastgrnn(const Q_Model_Blob* blob) {
+  Q15_FastGRNN_Params params1, params2;
+  const Q15_FastGRNN_Scales* scales1;
+  const Q15_FastGRNN_Scales* scales2;
+  if (q_model_blob_q15_fastgrnn(blob, "rnn1", INPUT_CHANNELS, HIDDEN_DIM1, &params1, &scales1) ||
+      q_model_blob_q15_fastgrnn(blob, "rnn2", HIDDEN_DIM1, HIDDEN_DIM2, &params2, &scales2)) {
+    return 1;
+  }
+  if (!in_blob(blob, params1.W) || !in_blob(blob, params2.U) ||
+      !in_blob(blob, scales1) || params1.Wids != NULL || params1.mean != NULL ||
+      params1.sigmoid_zeta != rnn1_params.sigmoid_zeta ||
+      params2.sigmoid_nu != rnn2_params.sigmoid_nu ||
+      memcmp(scales2, &rnn2_scales, sizeof(Q15_FastGRNN_Scales)) != 0) {
+    return 1;
+  }
+
+  Q15_T input1[STEPS * INPUT_CHANNELS], input2[STEPS * HIDDEN_DIM1];
+  Q15_T pred1[HIDDEN_DIM1] = {0}, expected1[HIDDEN_DIM1] = {0};
+  Q15_T pred2[HIDDEN_DIM2] = {0}, expected2[HIDDEN_DIM2] = {0};
+  fill_input(input1, STEPS * INPUT_CHANNELS, 1, 2048);
+  fill_input(input2, STEPS * HIDDEN_DIM1, 2, 2048);
+
+  q15_fastgrnn(expected1, HIDDEN_DIM1, input1, INPUT_CHANNELS, STEPS,
+               (const void*)(&rnn1_params), (void*)(&rnn1_buffers),
+               (const void*)(&rnn1_scales), 0, 0);
+  q15_fastgrnn(pred1, HIDDEN_DIM1, input1, INPUT_CHANNELS, STEPS,
+               (const void*)(&params1), (void*)(&rnn1_buffers),
+               (const void*)scales1, 0, 0);
+  q15_fastgrnn(expected2, HIDDEN_DIM2, input2, HIDDEN_DIM1, STEPS,
+               (const void*)(&rnn2_params), (void*)(&rnn2_buffers),
+               (const void*)(&rnn2_scales), 1, 0);
+  q15_fastgrnn(pred2, HIDDEN_DIM2, input2, HIDDEN_DIM1, STEPS,
+               (const void*)(&params2), (void*)(&rnn2_buffers),
+               (const void*)scales2, 1, 0);
+  return check_output_q15(pred1, expected1, HIDDEN_DIM1) ||
+         check_output_q15(pred2, expected2, HIDDEN_DIM2);
+}
+
+// Runs an MBConv block loaded from a blob. Defined before the MBConv header, whose shape macros hide the fields of the config
+static void run_mbconv(const Q_MBConv_Params* params, const Q15_T* input,
+                       Q15_T* output, Q15_T* buffer1, Q15_T* buffer2) {
+  const Q_MBConv_Config* c = params->config;
+  q15_mbconv_block(input, params->filter1, params->BN1W, params->BN1B,
+    params->filter2, params->BN2W, params->BN2B, params->filter3, params->BN3W,
+    params->BN3B, output, buffer1, buffer2, c->N, c->H, c->W, c->CIn, c->CTemp,
+    c->HF, c->WF, c->COut, c->HOut, c->WOut, c->HPadU, c->HPadD, c->WPadL,
+    c->WPadR, c->HStride, c->WStride, c->limit1, c->limit2, c->shrU1, c->shrX1,
+    c->shrU2, c->shrX2, c->shrU3, c->shrW3, c->shlU1, c->shlX1, c->shlU2,
+    c->shlX2, c->shlU3, c->shlW3);
+}
+
+// The MBConv header uses the names W1 and W2 of the RNN headers, and the macros H and W
+#define W1 mbconv_W1
+#define W2 mbconv_W2
+#define W3 mbconv_W3
+#include "../mbconv/q_wider_regression_model/mbconv.h"
+
+static const Q_MBConv_Config mbconv_config = {
+  N, H, W, CIN, CTEMP, HF, WF, COUT, HOUT, WOUT, HPADL, HPADR, WPADL, WPADR,
+  HSTRIDE, WSTRIDE, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
+static Q_MBConv_Config mbconv_scales(void) {
+  Q_MBConv_Config config = mbconv_config;
+  config.limit1 = Limit1;
+  config.limit2 = Limit2;
+  config.shrU1 = ShRU1;
+  config.shrX1 = ShRX1;
+  config.shrU2 = ShRU2;
+  config.shrX2 = ShRX2;
+  config.shrU3 = ShRU3;
+  config.shrW3 = ShRW3;
+  config.shlU1 = ShLU1;
+  config.shlX1 = ShLX1;
+  config.shlU2 = ShLU2;
+  config.shlX2 = ShLX2;
+  config.shlU3 = ShLU3;
+  config.shlW3 = ShLW3;
+  return config;
+}
+
+static Q15_T mbconv_input[N * H * W * CIN];
+static Q15_T mbconv_pred[N * HOUT * WOUT * COUT];
+static Q15_T mbconv_expected[N * HOUT * WOUT * COUT];
+static Q15_T mbconv_buffer1[HF * W * CTEMP];
+static Q15_T mbconv_buffer2[CTEMP];
+
+// Test q_model_blob_mbconv() against the compiled-in MBConv block.
+int test_q_model_blob_mbconv(const Q_Model_Blob* blob) {
+  Q_MBConv_Params params;
+  if (q_model_blob_mbconv(blob, "mbconv", Q_MODEL_BLOB_Q15, Q_MODEL_BLOB_Q15, &params) ||
+      !in_blob(blob, params.config) || !in_blob(blob, params.filter2)) {
+    return 1;
+  }
+  // The element types are checked
+  Q_MBConv_Params q7_params;
+  if (q_model_blob_mbconv(blob, "mbconv", Q_MODEL_BLOB_Q7, Q_MODEL_BLOB_Q15, &q7_params) != ERR_MODEL_BLOB_ENTRY_MISMATCH) {
+    return 1;
+  }
+
+  fill_input(mbconv_input, N * H * W * CIN, 3, 2048);
+  q15_mbconv_block(mbconv_input, F1, mbconv_W1, B1, F2, mbconv_W2, B2, F3,
+    mbconv_W3, B3, mbconv_expected, mbconv_buffer1, mbconv_buffer2, N, H, W,
+    CIN, CTEMP, HF, WF, COUT, HOUT, WOUT, HPADL, HPADR, WPADL, WPADR, HSTRIDE,
+    WSTRIDE, Limit1, Limit2, ShRU1, ShRX1, ShRU2, ShRX2, ShRU3, ShRW3, ShLU1,
+    ShLX1, ShLU2, ShLX2, ShLU3, ShLW3);
+  run_mbconv(&params, mbconv_input, mbconv_pred, mbconv_buffer1, mbconv_buffer2);
+  return check_output_q15(mbconv_pred, mbconv_expected, N * HOUT * WOUT * COUT);
+}
+
+// Test the checks of the header and of the entry table.
+int test_q_model_blob_format(const Q_Model_Blob* blob) {
+  static Q63_T copy[1 << 16];
+  Q_Model_Blob other;
+  const void* data;
+  if (blob->size > sizeof(copy)) {
+    return 1;
+  }
+  Q_Model_Blob_Header* header = (Q_Model_Blob_Header*)copy;
+  Q_Model_Blob_Entry* entry = (Q_Model_Blob_Entry*)(header + 1);
+
+  memcpy(copy, blob->data, blob->size);
+  if (q_model_blob_init(copy, blob->size, &other) != 0 ||
+      q_model_blob_array(&other, "rnn1.Bg", Q_MODEL_BLOB_Q15, HIDDEN_DIM1, &data) != 0 ||
+      q_model_blob_array(&other, "rnn1.Bg", Q_MODEL_BLOB_Q15, HIDDEN_DIM1 + 1, &data) != ERR_MODEL_BLOB_ENTRY_MISMATCH ||
+      q_model_blob_array(&other, "rnn3.Bg", Q_MODEL_BLOB_Q15, 0, &data) != ERR_MODEL_BLOB_MISSING_ENTRY) {
+    return 1;
+  }
+  if (q_model_blob_init(copy, blob->size - Q_MODEL_BLOB_ALIGN, &other) != ERR_MODEL_BLOB_FORMAT) {
+    return 1;
+  }
+  header->version_minor++;
+  if (q_model_blob_init(copy, blob->size, &other) != 0) {
+    return 1;
+  }
+  header->version_major++;
+  if (q_model_blob_init(copy, blob->size, &other) != ERR_MODEL_BLOB_VERSION) {
+    return 1;
+  }
+  header->version_major--;
+  // A blob of the other scale mode would be run with the wrong scales
+  if (header->scale_mode != Q_MODEL_BLOB_SCALE_MODE) {
+    return 1;
+  }
+  header->scale_mode = Q_MODEL_BLOB_SCALE_MODE == Q_MODEL_BLOB_SCALE_SHIFT ? Q_MODEL_BLOB_SCALE_DIV : Q_MODEL_BLOB_SCALE_SHIFT;
+  if (q_model_blob_init(copy, blob->size, &other) != ERR_MODEL_BLOB_SCALE_MODE) {
+    return 1;
+  }
+  header->scale_mode = Q_MODEL_BLOB_SCALE_MODE;
+  entry->count = blob->size;
+  if (q_model_blob_init(copy, blob->size, &other) != ERR_MODEL_BLOB_FORMAT) {
+    return 1;
+  }
+  header->magic = 0;
+  return q_model_blob_init(copy, blob->size, &other) != ERR_MODEL_BLOB_FORMAT;
+}
+
+int main() {
+  Q_Model_Blob blob;
+  const Q_MBConv_Config config = mbconv_scales();
+  const Q_MBConv_Params mbconv_params = {
+    F1, mbconv_W1, B1, F2, mbconv_W2, B2, F3, mbconv_W3, B3, &config
+  };
+
+  packer.num_entries = 0;
+  if (q_model_blob_pack_q15_fastgrnn(&packer, "rnn1", &rnn1_params, &rnn1_scales, INPUT_CHANNELS, HIDDEN_DIM1) ||
+      q_model_blob_pack_q15_fastgrnn(&packer, "rnn2", &rnn2_params, &rnn2_scales, HIDDEN_DIM1, HIDDEN_DIM2) ||
+      q_model_blob_pack_mbconv(&packer, "mbconv", &mbconv_params, Q_MODEL_BLOB_Q15, Q_MODEL_BLOB_Q15) ||
+      q_model_blob_write(&packer, BLOB_PATH) ||
+      q_model_blob_open(BLOB_PATH, &blob)) {
+    printf("Test Failure for q_model_blob_write() / q_model_blob_open()!\n");
+    remove(BLOB_PATH);
+    return -1;
+  }
+
+  int ret = -1;
+  if (test_q_model_blob_fastgrnn(&blob)) {
+    printf("Test Failure for q_model_blob_q15_fastgrnn()!\n");
+  } else if (test_q_model_blob_mbconv(&blob)) {
+    printf("Test Failure for q_model_blob_mbconv()!\n");
+  } else if (test_q_model_blob_format(&blob)) {
+    printf("Test Failure for q_model_blob_init()!\n");
+  } else {
+    printf("All Tests Passed!\n");
+    ret = 0;
+  }
+  q_model_blob_close(&blob);
+  remove(BLOB_PATH);
+  return ret;
+}
@@ -72,6 +72,31 @@ int main() {
   #endif
   printf("Testing Bricked RNNs Bi-Directional\n");
   printf("Agg Squared Error: %f ; MSE: %f ; RMSE: %f\n", error, avg_error, rmse);
+
+  // The bricks are split over the threads, but each brick is computed in the same order. Hence the output is identical for any number of threads
+  printf("Testing Multi-threaded Bricked RNNs Bi-Directional\n");
+  float* pred_threaded = (float*)malloc(RNN_OUT_TIME * RNN_OUT_FEATURES * sizeof(float));
+  unsigned threads[] = {2, 3, 4, 7};
+  int failed = 0;
+  for (unsigned i = 0; i < sizeof(threads) / sizeof(threads[0]); i++) {
+    fwd_RNN_params.num_threads = threads[i];
+    bwd_RNN_params.num_threads = threads[i];
+    forward_bricked_fastgrnn_lr(pred_threaded, RNN_OUT_FEATURES >> 1, INPUT,
+      RNN_IN_TIME, RNN_IN_FEATURES, FWD_WINDOW, HOP,
+      &fwd_RNN_params, 1, 1);
+    backward_bricked_fastgrnn_lr(pred_threaded + (RNN_OUT_FEATURES >> 1), RNN_OUT_FEATURES >> 1, INPUT,
+      RNN_IN_TIME, RNN_IN_FEATURES, BWD_WINDOW, HOP,
+      &bwd_RNN_params, 1, 1);
+
+    unsigned mismatches = 0;
+    for (unsigned j = 0; j < RNN_OUT_TIME * RNN_OUT_FEATURES; j++) {
+      mismatches += (pred_threaded[j] != pred[j]);
+    }
+    printf("%u threads : %u outputs differ from 1 thread, %s\n", threads[i], mismatches,
+      mismatches ? "Failed" : "Passed");
+    failed |= (mismatches != 0);
+  }
+  free(pred_threaded);
   free(pred);
-  return 0;
+  return failed;
 }
@@ -37,6 +37,15 @@ float compute_error(Q15_T pred[4 * HIDDEN_DIM2], float label[4 * HIDDEN_DIM2],
   return agg_diff;
 }
 
+// Number of outputs which differ between two runs of the RNNPool block.
+unsigned count_mismatches(const Q15_T* pred, const Q15_T* ref, unsigned len) {
+  unsigned mismatches = 0;
+  for (unsigned i = 0; i < len; i++) {
+    mismatches += (pred[i] != ref[i]);
+  }
+  return mismatches;
+}
+
 // Function for computing the 95th percentile deviation among all the outputs.
 float aggregate_error(float* errors, unsigned len) {
   qsort(errors, len, sizeof(float), compare_floats);
@@ -44,6 +53,134 @@ float aggregate_error(float* errors, unsigned len) {
   return errors[index];
 }
 
+// Buffers of the workers of the threaded tests of the RNNPool patches. The Q15
+// and the Q7xQ15 runs share the precomputation buffers
+#define MAX_WORKERS 7
+static Q15_T worker_rnn1_preComp[MAX_WORKERS][3][HIDDEN_DIM1];
+static Q15_T worker_rnn1_normFeatures[MAX_WORKERS][HIDDEN_DIM1];
+static Q7_T worker_rnn1_normFeatures_q7[MAX_WORKERS][HIDDEN_DIM1];
+static Q15_T worker_rnn1_batch_preComp[MAX_WORKERS][3][HIDDEN_DIM1 * PATCH_DIM];
+static Q15_T worker_rnn1_batch_normFeatures[MAX_WORKERS][INPUT_CHANNELS * PATCH_DIM];
+static Q7_T worker_rnn1_batch_normFeatures_q7[MAX_WORKERS][INPUT_CHANNELS * PATCH_DIM];
+static Q15_T worker_rnn2_preComp[MAX_WORKERS][3][HIDDEN_DIM2];
+static Q15_T worker_rnn2_normFeatures[MAX_WORKERS][HIDDEN_DIM1];
+static Q15_T worker_output[MAX_WORKERS][4 * HIDDEN_DIM2];
+static Q15_T worker_buffer[MAX_WORKERS][HIDDEN_DIM1 * PATCH_DIM];
+static Q15_FastGRNN_Buffers worker_rnn1[MAX_WORKERS], worker_rnn1_batch[MAX_WORKERS];
+static Q7xQ15_FastGRNN_Buffers worker_rnn1_q7[MAX_WORKERS], worker_rnn1_batch_q7[MAX_WORKERS];
+static Q15_FastGRNN_Buffers worker_rnn2[MAX_WORKERS];
+static Q_RNNPool_Worker_Buffers workers[MAX_WORKERS], workers_q7[MAX_WORKERS];
+
+static void setup_workers(void) {
+  for (unsigned i = 0; i < MAX_WORKERS; i++) {
+    Q15_FastGRNN_Buffers rnn1 = {worker_rnn1_preComp[i][0], worker_rnn1_preComp[i][1],
+      worker_rnn1_preComp[i][2], worker_rnn1_normFeatures[i]};
+    Q15_FastGRNN_Buffers rnn1_batch = {worker_rnn1_batch_preComp[i][0],
+      worker_rnn1_batch_preComp[i][1], worker_rnn1_batch_preComp[i][2],
+      worker_rnn1_batch_normFeatures[i]};
+    Q7xQ15_FastGRNN_Buffers rnn1_q7 = {worker_rnn1_preComp[i][0], worker_rnn1_preComp[i][1],
+      worker_rnn1_preComp[i][2], worker_rnn1_normFeatures_q7[i]};
+    Q7xQ15_FastGRNN_Buffers rnn1_batch_q7 = {worker_rnn1_batch_preComp[i][0],
+      worker_rnn1_batch_preComp[i][1], worker_rnn1_batch_preComp[i][2],
+      worker_rnn1_batch_normFeatures_q7[i]};
+    Q15_FastGRNN_Buffers rnn2 = {worker_rnn2_preComp[i][0], worker_rnn2_preComp[i][1],
+      worker_rnn2_preComp[i][2], worker_rnn2_normFeatures[i]};
+    worker_rnn1[i] = rnn1;
+    worker_rnn1_batch[i] = rnn1_batch;
+    worker_rnn1_q7[i] = rnn1_q7;
+    worker_rnn1_batch_q7[i] = rnn1_batch_q7;
+    worker_rnn2[i] = rnn2;
+
+    workers[i].rnn1_buffers = (void*)(&worker_rnn1[i]);
+    workers[i].rnn1_batch_buffers = (void*)(&worker_rnn1_batch[i]);
+    workers[i].rnn2_buffers = (void*)(&worker_rnn2[i]);
+    workers[i].output = worker_output[i];
+    workers[i].buffer = worker_buffer[i];
+    workers_q7[i] = workers[i];
+    workers_q7[i].rnn1_buffers = (void*)(&worker_rnn1_q7[i]);
+    workers_q7[i].rnn1_batch_buffers = (void*)(&worker_rnn1_batch_q7[i]);
+  }
+}
+
+// Test q15_rnnpool_patches() and q7xq15_q15_rnnpool_patches() on more than one
+// thread against one thread, on a grid of patchesX * 2 patches, with and
+// without a mask. Returns the number of runs with a differing output
+unsigned test_rnnpool_patches_threaded(const Q15_T* patches_q15,
+  const Q7_T* patches_q7, ITER_T patchesX,
+  const Q7xQ15_FastGRNN_Params* rnn1_q7_params, FILE* outputLog) {
+  const ITER_T threads[] = {2, 3, 5, MAX_WORKERS};
+  const ITER_T patchSize = INPUT_CHANNELS * PATCH_DIM * PATCH_DIM;
+  const ITER_T outDims = 4 * HIDDEN_DIM2;
+  ITER_T num_patches = 2 * patchesX;
+  unsigned char* mask = malloc(num_patches);
+  Q15_T* expected = malloc(num_patches * outDims * sizeof(Q15_T));
+  Q15_T* pred = malloc(num_patches * outDims * sizeof(Q15_T));
+  Q7_T* expected_q7 = malloc(num_patches * outDims * sizeof(Q7_T));
+  Q7_T* pred_q7 = malloc(num_patches * outDims * sizeof(Q7_T));
+  unsigned failures = 0;
+
+  setup_workers();
+  for (ITER_T p = 0; p < num_patches; p++) {
+    mask[p] = (p % 3 != 1);
+  }
+
+  for (unsigned m = 0; m < 2; m++) {
+    const unsigned char* patch_mask = m ? mask : NULL;
+    memset(expected, 0, num_patches * outDims * sizeof(Q15_T));
+    memset(expected_q7, 0, num_patches * outDims * sizeof(Q7_T));
+    failures += (q15_rnnpool_patches(patches_q15, INPUT_CHANNELS, PATCH_DIM,
+      PATCH_DIM, patchesX, 2, 2 * patchSize, patchSize, q15_fastgrnn,
+      HIDDEN_DIM1, (const void*)(&rnn1_params), (const void*)(&rnn1_scales),
+      q15_fastgrnn_batch, q15_fastgrnn, HIDDEN_DIM2,
+      (const void*)(&rnn2_params), (const void*)(&rnn2_scales), expected,
+      2 * outDims, ShR1, ShL1, ShR2, ShL2, patch_mask, workers, 1) != 0);
+    failures += (q7xq15_q15_rnnpool_patches(patches_q7, INPUT_CHANNELS,
+      PATCH_DIM, PATCH_DIM, patchesX, 2, 2 * patchSize, patchSize,
+      q7xq15_q15_fastgrnn, HIDDEN_DIM1, (const void*)rnn1_q7_params,
+      (const void*)(&rnn1_scales), q7xq15_q15_fastgrnn_batch, q15_fastgrnn,
+      HIDDEN_DIM2, (const void*)(&rnn2_params), (const void*)(&rnn2_scales),
+      expected_q7, 2 * outDims, ShR1, ShL1, ShR2, ShL2, patch_mask,
+      workers_q7, 1) != 0);
+
+    for (unsigned t = 0; t < sizeof(threads) / sizeof(threads[0]); t++) {
+      memset(pred, 0, num_patches * outDims * sizeof(Q15_T));
+      memset(pred_q7, 0, num_patches * outDims * sizeof(Q7_T));
+      failures += (q15_rnnpool_patches(patches_q15, INPUT_CHANNELS, PATCH_DIM,
+        PATCH_DIM, patchesX, 2, 2 * patchSize, patchSize, q15_fastgrnn,
+        HIDDEN_DIM1, (const void*)(&rnn1_params), (const void*)(&rnn1_scales),
+        q15_fastgrnn_batch, q15_fastgrnn, HIDDEN_DIM2,
+        (const void*)(&rnn2_params), (const void*)(&rnn2_scales), pred,
+        2 * outDims, ShR1, ShL1, ShR2, ShL2, patch_mask, workers,
+        threads[t]) != 0);
+      failures += (q7xq15_q15_rnnpool_patches(patches_q7, INPUT_CHANNELS,
+        PATCH_DIM, PATCH_DIM, patchesX, 2, 2 * patchSize, patchSize,
+        q7xq15_q15_fastgrnn, HIDDEN_DIM1, (const void*)rnn1_q7_params,
+        (const void*)(&rnn1_scales), q7xq15_q15_fastgrnn_batch, q15_fastgrnn,
+        HIDDEN_DIM2, (const void*)(&rnn2_params), (const void*)(&rnn2_scales),
+        pred_q7, 2 * outDims, ShR1, ShL1, ShR2, ShL2, patch_mask,
+        workers_q7, threads[t]) != 0);
+
+      if (count_mismatches(pred, expected, num_patches * outDims)) {
+        fprintf(outputLog, "Q15 RNNPool patches differ with %u threads%s\n",
+                (unsigned)threads[t], m ? " and a mask" : "");
+        failures++;
+      }
+      if (memcmp(pred_q7, expected_q7, num_patches * outDims * sizeof(Q7_T))) {
+        fprintf(outputLog, "Q7xQ15 RNNPool patches differ with %u threads%s\n",
+                (unsigned)threads[t], m ? " and a mask" : "");
+        failures++;
+      }
+    }
+  }
+
+  free(mask);
+  free(expected);
+  free(pred);
+  free(expected_q7);
+  free(pred_q7);
+  return failures;
+}
+
 /**
  *  By default, all tests run without using bit-shifting operations.
  */
@@ -141,9 +278,58 @@ int main(int argc, char **argv) {
 
   Q15_T output_test[4 * HIDDEN_DIM2];
   Q15_T buffer[HIDDEN_DIM1 * PATCH_DIM];
+  Q15_T normFeatures_batch[INPUT_CHANNELS * PATCH_DIM];
+  Q15_T preComp1_batch[HIDDEN_DIM1 * PATCH_DIM];
+  Q15_T preComp2_batch[HIDDEN_DIM1 * PATCH_DIM];
+  Q15_T preComp3_batch[HIDDEN_DIM1 * PATCH_DIM];
+  Q15_FastGRNN_Buffers rnn1_batch_buffers = {
+    .preComp1 = preComp1_batch,
+    .preComp2 = preComp2_batch,
+    .preComp3 = preComp3_batch,
+    .normFeatures = normFeatures_batch
+  };
+  Q15_T output_unbatched[4 * HIDDEN_DIM2];
+
+  // RNN1 with 8-bit inputs, using the same weights. The batched and the
+  // per-pixel paths of q7xq15_q15_rnnpool_block are compared with each other
+  Q7xQ15_FastGRNN_Params rnn1_q7_params = {
+    .mean = NULL,
+    .stdDev = NULL,
+    .W = rnn1_params.W,
+    .Wids = NULL,
+    .Wvals = NULL,
+    .U = rnn1_params.U,
+    .Uids = NULL,
+    .Uvals = NULL,
+    .Bg = rnn1_params.Bg,
+    .Bh = rnn1_params.Bh,
+    .sigmoid_zeta = rnn1_params.sigmoid_zeta,
+    .sigmoid_nu = rnn1_params.sigmoid_nu
+  };
+  Q7_T normFeatures_q7[INPUT_CHANNELS];
+  Q7xQ15_FastGRNN_Buffers rnn1_q7_buffers = {
+    .preComp1 = rnn1_buffers.preComp1,
+    .preComp2 = rnn1_buffers.preComp2,
+    .preComp3 = rnn1_buffers.preComp3,
+    .normFeatures = normFeatures_q7
+  };
+  Q7_T normFeatures_q7_batch[INPUT_CHANNELS * PATCH_DIM];
+  Q7xQ15_FastGRNN_Buffers rnn1_q7_batch_buffers = {
+    .preComp1 = preComp1_batch,
+    .preComp2 = preComp2_batch,
+    .preComp3 = preComp3_batch,
+    .normFeatures = normFeatures_q7_batch
+  };
+  Q7_T q7XLine[INPUT_CHANNELS * PATCH_DIM * PATCH_DIM];
+  Q15_T output_q7[4 * HIDDEN_DIM2];
+  Q15_T output_q7_unbatched[4 * HIDDEN_DIM2];
+  unsigned mismatches = 0, q7_mismatches = 0;
+
   float xLine[INPUT_CHANNELS * PATCH_DIM * PATCH_DIM];
   float yLine[4 * HIDDEN_DIM2];
   float* allErrors = malloc(patches * 4 * HIDDEN_DIM2 * (sizeof(float)));
+  Q15_T* allX = malloc(patches * INPUT_CHANNELS * PATCH_DIM * PATCH_DIM * sizeof(Q15_T));
+  Q7_T* allXq7 = malloc(patches * INPUT_CHANNELS * PATCH_DIM * PATCH_DIM * sizeof(Q7_T));
 
   double time_spent = 0.0;
   for (unsigned i = 0; i < patches; i++) {
@@ -165,6 +351,7 @@ int main(int argc, char **argv) {
     q15_rnnpool_block(reshapedXLine, INPUT_CHANNELS, PATCH_DIM, PATCH_DIM,
                       q15_fastgrnn, HIDDEN_DIM1, (const void*)(&rnn1_params),
                       (void*)(&rnn1_buffers), (const void*)(&rnn1_scales),
+                      q15_fastgrnn_batch, (void*)(&rnn1_batch_buffers),
                       q15_fastgrnn, HIDDEN_DIM2, (const void*)(&rnn2_params),
                       (void*)(&rnn2_buffers), (const void*)(&rnn2_scales),
                       output_test, buffer, ShR1, ShL1, ShR2, ShL2);
@@ -172,6 +359,37 @@ int main(int argc, char **argv) {
     time_spent += (double)(end - begin) / CLOCKS_PER_SEC;
     fprintf(outputLog, "Time elapsed is %f seconds\n", time_spent);
 
+    // Without the batched cell, both passes run one sequence at a time
+    q15_rnnpool_block(reshapedXLine, INPUT_CHANNELS, PATCH_DIM, PATCH_DIM,
+                      q15_fastgrnn, HIDDEN_DIM1, (const void*)(&rnn1_params),
+                      (void*)(&rnn1_buffers), (const void*)(&rnn1_scales),
+                      NULL, NULL,
+                      q15_fastgrnn, HIDDEN_DIM2, (const void*)(&rnn2_params),
+                      (void*)(&rnn2_buffers), (const void*)(&rnn2_scales),
+                      output_unbatched, buffer, ShR1, ShL1, ShR2, ShL2);
+    mismatches += count_mismatches(output_unbatched, output_test, 4 * HIDDEN_DIM2);
+
+    for (unsigned j = 0; j < INPUT_CHANNELS * PATCH_DIM * PATCH_DIM; j++) {
+      q7XLine[j] = (Q7_T)(reshapedXLine[j] / 256);
+      allX[i * INPUT_CHANNELS * PATCH_DIM * PATCH_DIM + j] = reshapedXLine[j];
+      allXq7[i * INPUT_CHANNELS * PATCH_DIM * PATCH_DIM + j] = q7XLine[j];
+    }
+    q7xq15_q15_rnnpool_block(q7XLine, INPUT_CHANNELS, PATCH_DIM, PATCH_DIM,
+                             q7xq15_q15_fastgrnn, HIDDEN_DIM1, (const void*)(&rnn1_q7_params),
+                             (void*)(&rnn1_q7_buffers), (const void*)(&rnn1_scales),
+                             q7xq15_q15_fastgrnn_batch, (void*)(&rnn1_q7_batch_buffers),
+                             q15_fastgrnn, HIDDEN_DIM2, (const void*)(&rnn2_params),
+                             (void*)(&rnn2_buffers), (const void*)(&rnn2_scales),
+                             output_q7, buffer, ShR1, ShL1, ShR2, ShL2);
+    q7xq15_q15_rnnpool_block(q7XLine, INPUT_CHANNELS, PATCH_DIM, PATCH_DIM,
+                             q7xq15_q15_fastgrnn, HIDDEN_DIM1, (const void*)(&rnn1_q7_params),
+                             (void*)(&rnn1_q7_buffers), (const void*)(&rnn1_scales),
+                             NULL, NULL,
+                             q15_fastgrnn, HIDDEN_DIM2, (const void*)(&rnn2_params),
+                             (void*)(&rnn2_buffers), (const void*)(&rnn2_scales),
+                             output_q7_unbatched, buffer, ShR1, ShL1, ShR2, ShL2);
+    q7_mismatches += count_mismatches(output_q7_unbatched, output_q7, 4 * HIDDEN_DIM2);
+
     float max_diff = compute_error(output_test, yLine,
                                    allErrors + i * 4 * HIDDEN_DIM2, YScale);
     fprintf(outputLog, "Maximum Observed Deviation: %f percent\n", max_diff);
@@ -186,6 +404,21 @@ int main(int argc, char **argv) {
   fclose(yFile);
   fclose(floatResFile);
 
+  fprintf(outputLog, "Outputs differing between the batched and the per-pixel Q15 RNNPool: %u\n", mismatches);
+  fprintf(outputLog, "Outputs differing between the batched and the per-pixel Q7xQ15 RNNPool: %u\n", q7_mismatches);
+  if (mismatches || q7_mismatches) {
+    fprintf(outputLog, "Quantized RNNPool Batched Test Failed!\n");
+    return -1;
+  }
+
+  // The patches of the file as a grid of (patches / 2) * 2 patches
+  if (test_rnnpool_patches_threaded(allX, allXq7, patches / 2, &rnn1_q7_params, outputLog)) {
+    fprintf(outputLog, "Quantized RNNPool Threaded Patches Test Failed!\n");
+    return -1;
+  }
+  free(allX);
+  free(allXq7);
+
   float aggregate = aggregate_error(allErrors, patches * 4 * HIDDEN_DIM2);
   fprintf(outputLog, "Aggregated 95th Percentile Error: %f\n", aggregate);
   if (aggregate < 1.61) {
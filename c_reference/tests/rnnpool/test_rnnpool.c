@@ -46,6 +46,13 @@ int main() {
     .normFeatures = normFeatures1
   };
 
+  float preComp1_batch[HIDDEN_DIMS1 * PATCH_DIM];
+  memset(preComp1_batch, 0, sizeof(float) * HIDDEN_DIMS1 * PATCH_DIM);
+  FastGRNN_Buffers rnn1_batch_buffers = {
+    .preComp = preComp1_batch,
+    .normFeatures = NULL
+  };
+
   float preComp2[HIDDEN_DIMS2];
   float normFeatures2[HIDDEN_DIMS1];
   memset(preComp2, 0, sizeof(float) * HIDDEN_DIMS2);
@@ -61,8 +68,20 @@ int main() {
   memset(buffer, 0, sizeof(float) * HIDDEN_DIMS1 * PATCH_DIM);
   rnnpool_block(input, INPUT_DIMS, PATCH_DIM, PATCH_DIM,
     fastgrnn, HIDDEN_DIMS1, (const void*)(&rnn1_params), (void*)(&rnn1_buffers),
+    fastgrnn_batch, (void*)(&rnn1_batch_buffers),
     fastgrnn, HIDDEN_DIMS2, (const void*)(&rnn2_params), (void*)(&rnn2_buffers),
     output_test, buffer);
 
   printf("Error: %f\n", l2squared(output, output_test, 4 * HIDDEN_DIMS2));
+
+  // Same block without the batched cell: both passes run one sequence at a time
+  memset(output_test, 0, sizeof(float) * 4 * HIDDEN_DIMS2);
+  memset(buffer, 0, sizeof(float) * HIDDEN_DIMS1 * PATCH_DIM);
+  rnnpool_block(input, INPUT_DIMS, PATCH_DIM, PATCH_DIM,
+    fastgrnn, HIDDEN_DIMS1, (const void*)(&rnn1_params), (void*)(&rnn1_buffers),
+    NULL, NULL,
+    fastgrnn, HIDDEN_DIMS2, (const void*)(&rnn2_params), (void*)(&rnn2_buffers),
+    output_test, buffer);
+
+  printf("Error (unbatched): %f\n", l2squared(output, output_test, 4 * HIDDEN_DIMS2));
 }
@@ -0,0 +1,369 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "quantized_sparse_conv.h"
+#include "quantized_mbconv.h"
+
+// The sparse kernels have to be bit-exact with the dense ones, on the test vectors of test_quantized_utils.c and on pruned random filters
+#define MAX_FILTER 4096
+#define MAX_OUTPUT 4096
+
+static ITER_T row_ptr[3][MAX_FILTER + 1];
+static ITER_T col_idx[3][MAX_FILTER];
+static Q15_T values[3][MAX_FILTER];
+
+static int check_output_q7(const Q7_T* const pred, const Q7_T* const expected,
+                           unsigned len) {
+  for (unsigned i = 0; i < len; i++)
+  {
+    if (pred[i] != expected[i]) {
+      printf("Output: %d, Expected: %d at Index: %d\n", pred[i], expected[i], i);
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static int check_output_q15(const Q15_T* const pred, const Q15_T* const expected,
+                            unsigned len) {
+  for (unsigned i = 0; i < len; i++)
+  {
+    if (pred[i] != expected[i]) {
+      printf("Output: %d, Expected: %d at Index: %d\n", pred[i], expected[i], i);
+      return 1;
+    }
+  }
+  return 0;
+}
+
+// Random weights in [-range, range], of which one in keep is kept
+static void fill_pruned(Q15_T* filter, unsigned len, Q15_T range, unsigned keep) {
+  for (unsigned i = 0; i < len; i++) {
+    Q15_T v = (Q15_T)(rand() % (2 * range + 1) - range);
+    filter[i] = (rand() % keep == 0) ? v : 0;
+  }
+}
+
+// Test q15_sparse_filter_pack() and q15_sparse_filter_write().
+int test_q15_sparse_filter_pack() {
+  const Q15_T filter[12 * 2] = {0, 3,
+                                0, 0,
+                                5, 0,
+                                0, 0,
+                                0, 0,
+                                0, 0,
+                                0, 0,
+                                0, 0,
+                                0, 0,
+                                0, 0,
+                                0, 0,
+                                0, 0};
+  const Q15_T dense[2 * 2] = {1, 0,
+                              2, 3};
+  const ITER_T expected_row_ptr[3] = {0, 1, 2};
+  const ITER_T expected_col_idx[2] = {2, 0};
+  const Q15_T expected_values[2] = {5, 3};
+  const char expected_source[] =
+    "static const ITER_T f_row_ptr[3] = {0, 1, 2};\n"
+    "static const ITER_T f_col_idx[2] = {2, 0};\n"
+    "static const Q15_T f_values[2] = {5, 3};\n"
+    "static const Q15_Sparse_Filter f = {F, f_row_ptr, f_col_idx, f_values, 1, 1, 12, 2, 1, 2};\n";
+  Q15_Sparse_Filter packed;
+
+  if (q15_sparse_filter_pack(filter, 1, 1, 12, 2, 1, row_ptr[0], col_idx[0], values[0], 2, &packed) ||
+      packed.row_ptr != row_ptr[0] || packed.nnz != 2 ||
+      memcmp(row_ptr[0], expected_row_ptr, sizeof(expected_row_ptr)) ||
+      memcmp(col_idx[0], expected_col_idx, sizeof(expected_col_idx)) ||
+      memcmp(values[0], expected_values, sizeof(expected_values))) {
+    return 1;
+  }
+
+  char source[256] = {0};
+  FILE* file = tmpfile();
+  if (file == NULL || q15_sparse_filter_write(file, "f", "F", &packed)) {
+    return 1;
+  }
+  rewind(file);
+  size_t len = fread(source, 1, sizeof(source) - 1, file);
+  fclose(file);
+  if (len != strlen(expected_source) || strcmp(source, expected_source)) {
+    printf("Source: %s, Expected: %s\n", source, expected_source);
+    return 1;
+  }
+
+  // The storage is too small, the filter is too dense or it has too many taps
+  if (q15_sparse_filter_pack(filter, 1, 1, 12, 2, 1, row_ptr[0], col_idx[0], values[0], 1, &packed) != ERR_SPARSE_FILTER_FULL ||
+      packed.nnz != 2 || packed.row_ptr != 0) {
+    return 1;
+  }
+  if (q15_sparse_filter_pack(dense, 1, 1, 2, 2, 1, row_ptr[0], col_idx[0], values[0], 4, &packed) ||
+      packed.row_ptr != 0 || packed.dense != dense || packed.nnz != 3) {
+    return 1;
+  }
+  return q15_sparse_filter_pack(filter, 9, 9, 1, 1, 1, row_ptr[0], col_idx[0], values[0], 2, &packed) != ERR_SPARSE_FILTER_INVALID_PARAMS;
+}
+
+// Test q15_sparse_convolution() on the test vectors of test_q15_convolution(). The filters are too small to be packed in CSR form,
+// so qmat_D is also run in the form q15_sparse_filter_write() gives for it.
+int test_q15_sparse_convolution_vectors() {
+  const Q15_T qmat_A[2 * 2 * 2 * 2] = {11, 220,
+                                       130, 40,
+
+                                       50, 60,
+                                       66, 76,
+
+
+                                       86, 910,
+                                       411, 312,
+
+                                       513, 514,
+                                       715, 716};
+  const Q15_T qmat_B[2 * 2 * 2 * 1 * 1] = {0, 1,
+                                           1, 0,
+
+
+                                           0, 1,
+                                           1, 0,};
+  const Q15_T qmat_C[1 * 2 * 2 * 2 * 1] = {0, 1,
+                                           1, 0,
+
+                                           1, 0,
+                                           0, 1};
+  const Q15_T qmat_D[2 * 3 * 3 * 1 * 1] = {0, 0, 1,
+                                           0, 1, 0,
+                                           1, 0, 0,
+
+
+                                           0, 0, 1,
+                                           0, 1, 0,
+                                           1, 0, 0};
+
+  const Q15_T expected_A[2 * 1 * 1 * 2] = {45, 25,
+
+
+                                           231, 206};
+  const Q15_T expected_B[2 * 1 * 1 * 1] = {59,
+
+
+                                           318};
+  const Q15_T expected_C[2 * 2 * 2 * 2] = {1, 27,
+                                           22, 12,
+
+                                           22, 12,
+                                           8, 9,
+
+
+                                           10, 113,
+                                           115, 103,
+
+                                           115, 103,
+                                           89, 89};
+  Q15_T pred_A[2 * 1 * 1 * 2], pred_B[2 * 1 * 1 * 1], pred_C[2 * 2 * 2 * 2];
+  const ITER_T row_ptr_D[3] = {0, 3, 6};
+  const ITER_T col_idx_D[6] = {2 << Q_SPARSE_FILTER_TAP_SHIFT, 4 << Q_SPARSE_FILTER_TAP_SHIFT, 6 << Q_SPARSE_FILTER_TAP_SHIFT,
+                               2 << Q_SPARSE_FILTER_TAP_SHIFT, 4 << Q_SPARSE_FILTER_TAP_SHIFT, 6 << Q_SPARSE_FILTER_TAP_SHIFT};
+  const Q15_T values_D[6] = {1, 1, 1, 1, 1, 1};
+  const Q15_Sparse_Filter sparse_D = {qmat_D, row_ptr_D, col_idx_D, values_D, 3, 3, 1, 1, 2, 6};
+  Q15_T pred_D[2 * 2 * 2 * 2];
+  Q15_Sparse_Filter filter_B, filter_C, filter_D;
+
+  if (q15_sparse_filter_pack(qmat_B, 2, 2, 1, 1, 2, row_ptr[0], col_idx[0], values[0], MAX_FILTER, &filter_B) ||
+      q15_sparse_filter_pack(qmat_C, 2, 2, 2, 1, 1, row_ptr[1], col_idx[1], values[1], MAX_FILTER, &filter_C) ||
+      q15_sparse_filter_pack(qmat_D, 3, 3, 1, 1, 2, row_ptr[2], col_idx[2], values[2], MAX_FILTER, &filter_D) ||
+      filter_B.row_ptr != 0 || filter_C.row_ptr != 0 || filter_D.row_ptr != 0) {
+    return 1;
+  }
+
+  #ifdef SHIFT
+    q15_sparse_convolution(qmat_A, &filter_B, pred_A, 2, 2, 2, 2, 1, 1, 0, 0, 0, 0, 1, 1, 1, 1, 0, 0, 2);
+    q15_sparse_convolution(qmat_A, &filter_C, pred_B, 2, 2, 2, 2, 1, 1, 0, 0, 0, 0, 1, 1, 1, 1, 0, 0, 3);
+    q15_sparse_convolution(qmat_A, &filter_D, pred_C, 2, 2, 2, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 3);
+    q15_sparse_convolution(qmat_A, &sparse_D, pred_D, 2, 2, 2, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 3);
+  #else
+    q15_sparse_convolution(qmat_A, &filter_B, pred_A, 2, 2, 2, 2, 1, 1, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 4);
+    q15_sparse_convolution(qmat_A, &filter_C, pred_B, 2, 2, 2, 2, 1, 1, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 8);
+    q15_sparse_convolution(qmat_A, &filter_D, pred_C, 2, 2, 2, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 8);
+    q15_sparse_convolution(qmat_A, &sparse_D, pred_D, 2, 2, 2, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 8);
+  #endif
+
+  return (check_output_q15(pred_A, expected_A, 4) || check_output_q15(pred_B, expected_B, 2) || check_output_q15(pred_C, expected_C, 16) ||
+          check_output_q15(pred_D, expected_C, 16));
+}
+
+// Shape of a convolution of the random tests
+typedef struct Conv_Shape {
+  ITER_T H, W, CIn, HF, WF, CF, COut, G;
+  S_ITER_T HPad, WPad;
+  ITER_T HStride, WStride, HDilation, WDilation;
+} Conv_Shape;
+
+// Test the three sparse convolutions against the dense ones on pruned random filters.
+int test_sparse_convolution_random() {
+  const Conv_Shape shapes[4] = {
+    // 1x1, depthwise 3x3 with stride 2, grouped 3x3 with dilation 2, depthwise 1x1 in place
+    {6, 5, 24, 1, 1, 24, 20, 1, 0, 0, 1, 1, 1, 1},
+    {7, 6, 16, 3, 3, 1, 1, 16, 1, 1, 2, 2, 1, 1},
+    {6, 7, 8, 3, 3, 4, 3, 2, 2, 2, 1, 1, 2, 2},
+    {4, 4, 12, 1, 1, 1, 1, 12, 0, 0, 1, 1, 1, 1}
+  };
+  static Q15_T filter[MAX_FILTER], input_q15[2 * MAX_OUTPUT];
+  static Q7_T input_q7[2 * MAX_OUTPUT];
+  static Q15_T expected_q15[2 * MAX_OUTPUT], pred_q15[2 * MAX_OUTPUT];
+  static Q7_T expected_q7[2 * MAX_OUTPUT], pred_q7[2 * MAX_OUTPUT];
+  // The Q7 outputs are scaled down 16 times more to stay in range
+  #ifdef SHIFT
+    const SCALE_T scinput = 4, scoutput = 4, demote = 2;
+    const SCALE_T scoutput_q7 = scoutput + 4;
+  #else
+    const SCALE_T scinput = 16, scoutput = 16, demote = 4;
+    const SCALE_T scoutput_q7 = scoutput * 16;
+  #endif
+
+  srand(7);
+  for (unsigned s = 0; s < 4; s++) {
+    const Conv_Shape* c = &shapes[s];
+    ITER_T HOut = (c->H + 2 * c->HPad - c->HDilation * (c->HF - 1) - 1) / c->HStride + 1;
+    ITER_T WOut = (c->W + 2 * c->WPad - c->WDilation * (c->WF - 1) - 1) / c->WStride + 1;
+    unsigned len_in = 2 * c->H * c->W * c->CIn;
+    unsigned len_out = 2 * HOut * WOut * c->COut * c->G;
+    Q15_Sparse_Filter packed;
+
+    fill_pruned(filter, c->G * c->HF * c->WF * c->CF * c->COut, 4096, 20);
+    for (unsigned i = 0; i < len_in; i++) {
+      input_q15[i] = (Q15_T)(rand() % 4097 - 2048);
+      input_q7[i] = (Q7_T)(rand() % 256 - 128);
+    }
+    if (q15_sparse_filter_pack(filter, c->HF, c->WF, c->CF, c->COut, c->G, row_ptr[0], col_idx[0], values[0], MAX_FILTER, &packed) ||
+        packed.row_ptr == 0) {
+      return 1;
+    }
+
+    q15_convolution(input_q15, filter, expected_q15, 2, c->H, c->W, c->CIn, c->HF, c->WF, c->CF, c->COut, HOut, WOut, c->G, c->HPad, c->HPad, c->WPad, c->WPad, c->HStride, c->WStride, c->HDilation, c->WDilation, scinput, scoutput, demote);
+    q15_sparse_convolution(input_q15, &packed, pred_q15, 2, c->H, c->W, c->CIn, HOut, WOut, c->HPad, c->HPad, c->WPad, c->WPad, c->HStride, c->WStride, c->HDilation, c->WDilation, scinput, scoutput, demote);
+    if (check_output_q15(pred_q15, expected_q15, len_out)) {
+      return 1;
+    }
+    q7xq15_q15_convolution(input_q7, filter, expected_q15, 2, c->H, c->W, c->CIn, c->HF, c->WF, c->CF, c->COut, HOut, WOut, c->G, c->HPad, c->HPad, c->WPad, c->WPad, c->HStride, c->WStride, c->HDilation, c->WDilation, scinput, scoutput, demote);
+    q7xq15_q15_sparse_convolution(input_q7, &packed, pred_q15, 2, c->H, c->W, c->CIn, HOut, WOut, c->HPad, c->HPad, c->WPad, c->WPad, c->HStride, c->WStride, c->HDilation, c->WDilation, scinput, scoutput, demote);
+    if (check_output_q15(pred_q15, expected_q15, len_out)) {
+      return 1;
+    }
+    q7xq15_q7_convolution(input_q7, filter, expected_q7, 2, c->H, c->W, c->CIn, c->HF, c->WF, c->CF, c->COut, HOut, WOut, c->G, c->HPad, c->HPad, c->WPad, c->WPad, c->HStride, c->WStride, c->HDilation, c->WDilation, scinput, scoutput_q7, demote);
+    q7xq15_q7_sparse_convolution(input_q7, &packed, pred_q7, 2, c->H, c->W, c->CIn, HOut, WOut, c->HPad, c->HPad, c->WPad, c->WPad, c->HStride, c->WStride, c->HDilation, c->WDilation, scinput, scoutput_q7, demote);
+    if (check_output_q7(pred_q7, expected_q7, len_out)) {
+      return 1;
+    }
+  }
+
+  // In place, as in the normalization layers of the face detection models
+  const Conv_Shape* c = &shapes[3];
+  Q15_Sparse_Filter packed;
+  q15_sparse_filter_pack(filter, c->HF, c->WF, c->CF, c->COut, c->G, row_ptr[0], col_idx[0], values[0], MAX_FILTER, &packed);
+  memcpy(pred_q15, input_q15, 2 * c->H * c->W * c->CIn * sizeof(Q15_T));
+  q15_convolution(input_q15, filter, expected_q15, 2, c->H, c->W, c->CIn, 1, 1, 1, 1, c->H, c->W, c->G, 0, 0, 0, 0, 1, 1, 1, 1, scinput, scoutput, demote);
+  q15_sparse_convolution(pred_q15, &packed, pred_q15, 2, c->H, c->W, c->CIn, c->H, c->W, 0, 0, 0, 0, 1, 1, 1, 1, scinput, scoutput, demote);
+  return check_output_q15(pred_q15, expected_q15, 2 * c->H * c->W * c->CIn);
+}
+
+// The MBConv block of the Wider Regression model, with pruned filters. Its macros hide the names above, hence the include here
+#include "../mbconv/q_wider_regression_model/mbconv.h"
+// The input has an odd number of rows, so that the last band reads a row of padding under the input
+#define H_ODD (H - 1)
+
+static Q15_T mbconv_F1[CIN * CTEMP], mbconv_F2[CTEMP * HF * WF], mbconv_F3[CTEMP * COUT];
+static Q15_T mbconv_input[N * H * W * CIN];
+static Q7_T mbconv_input_q7[N * H * W * CIN];
+static Q15_T mbconv_expected[N * HOUT * WOUT * COUT], mbconv_pred[N * HOUT * WOUT * COUT];
+static Q15_T mbconv_buffer1[HF * W * CTEMP], mbconv_buffer2[CTEMP];
+static Q15_T mbconv_band_buffers[2 * (HF * W * CTEMP + CTEMP)];
+static ITER_T mbconv_row_ptr[3][CTEMP + COUT + 1];
+static ITER_T mbconv_col_idx[3][CIN * CTEMP + CTEMP * COUT];
+static Q15_T mbconv_values[3][CIN * CTEMP + CTEMP * COUT];
+
+// Packs the three filters of the block, F1 and F3 pruned to one in keep1 weights and F2 to one in keep2
+static int pack_mbconv(unsigned keep1, unsigned keep2, Q15_Sparse_Filter* filters) {
+  for (unsigned i = 0; i < CIN * CTEMP; i++) {
+    mbconv_F1[i] = (i % keep1 == 0) ? F1[i] : 0;
+  }
+  for (unsigned i = 0; i < CTEMP * HF * WF; i++) {
+    mbconv_F2[i] = (i % keep2 == 0) ? F2[i] : 0;
+  }
+  for (unsigned i = 0; i < CTEMP * COUT; i++) {
+    mbconv_F3[i] = (i % keep1 == 0) ? F3[i] : 0;
+  }
+  return q15_sparse_filter_pack(mbconv_F1, 1, 1, CIN, CTEMP, 1, mbconv_row_ptr[0], mbconv_col_idx[0], mbconv_values[0], CIN * CTEMP, &filters[0]) ||
+         q15_sparse_filter_pack(mbconv_F2, HF, WF, 1, 1, CTEMP, mbconv_row_ptr[1], mbconv_col_idx[1], mbconv_values[1], CTEMP * HF * WF, &filters[1]) ||
+         q15_sparse_filter_pack(mbconv_F3, 1, 1, CTEMP, COUT, 1, mbconv_row_ptr[2], mbconv_col_idx[2], mbconv_values[2], CTEMP * COUT, &filters[2]);
+}
+
+// Test q15_sparse_mbconv_block() and q7xq15_q15_sparse_mbconv_block() against the dense blocks.
+int test_sparse_mbconv_block() {
+  Q15_Sparse_Filter filters[3];
+  srand(11);
+  for (unsigned i = 0; i < N * H * W * CIN; i++) {
+    mbconv_input[i] = (Q15_T)(rand() % 4097 - 2048);
+    mbconv_input_q7[i] = (Q7_T)(rand() % 256 - 128);
+  }
+
+  // The unpruned filters stay dense. Pruned, F1 and F3 are sparse with F2 dense, then all three are sparse
+  const unsigned keep[3][2] = {{1, 1}, {16, 1}, {12, 12}};
+  for (unsigned k = 0; k < 3; k++) {
+    if (pack_mbconv(keep[k][0], keep[k][1], filters) ||
+        (filters[0].row_ptr != 0) != (k > 0) || (filters[1].row_ptr != 0) != (k > 1)) {
+      return 1;
+    }
+
+    q15_mbconv_block(mbconv_input, mbconv_F1, W1, B1, mbconv_F2, W2, B2,
+      mbconv_F3, W3, B3, mbconv_expected, mbconv_buffer1, mbconv_buffer2, N, H,
+      W, CIN, CTEMP, HF, WF, COUT, HOUT, WOUT, HPADL, HPADR, WPADL, WPADR,
+      HSTRIDE, WSTRIDE, Limit1, Limit2, ShRU1, ShRX1, ShRU2, ShRX2, ShRU3,
+      ShRW3, ShLU1, ShLX1, ShLU2, ShLX2, ShLU3, ShLW3);
+    for (unsigned num_threads = 1; num_threads <= 3; num_threads += 2) {
+      memset(mbconv_pred, 0, sizeof(mbconv_pred));
+      q15_sparse_mbconv_block_threaded(mbconv_input, &filters[0], W1, B1,
+        &filters[1], W2, B2, &filters[2], W3, B3, mbconv_pred, mbconv_buffer1,
+        mbconv_buffer2, N, H, W, CIN, CTEMP, HF, WF, COUT, HOUT, WOUT, HPADL,
+        HPADR, WPADL, WPADR, HSTRIDE, WSTRIDE, Limit1, Limit2, ShRU1, ShRX1,
+        ShRU2, ShRX2, ShRU3, ShRW3, ShLU1, ShLX1, ShLU2, ShLX2, ShLU3, ShLW3,
+        mbconv_band_buffers, sizeof(mbconv_band_buffers), num_threads);
+      if (check_output_q15(mbconv_pred, mbconv_expected, N * HOUT * WOUT * COUT)) {
+        return 1;
+      }
+    }
+
+    q7xq15_q15_mbconv_block(mbconv_input_q7, mbconv_F1, W1, B1, mbconv_F2, W2,
+      B2, mbconv_F3, W3, B3, mbconv_expected, mbconv_buffer1, mbconv_buffer2, N,
+      H_ODD, W, CIN, CTEMP, HF, WF, COUT, HOUT, WOUT, HPADL, HPADR, WPADL,
+      WPADR, HSTRIDE, WSTRIDE, Limit1, Limit2, ShRU1, ShRX1, ShRU2, ShRX2,
+      ShRU3, ShRW3, ShLU1, ShLX1, ShLU2, ShLX2, ShLU3, ShLW3);
+    q7xq15_q15_sparse_mbconv_block(mbconv_input_q7, &filters[0], W1, B1,
+      &filters[1], W2, B2, &filters[2], W3, B3, mbconv_pred, mbconv_buffer1,
+      mbconv_buffer2, N, H_ODD, W, CIN, CTEMP, HF, WF, COUT, HOUT, WOUT, HPADL,
+      HPADR, WPADL, WPADR, HSTRIDE, WSTRIDE, Limit1, Limit2, ShRU1, ShRX1,
+      ShRU2, ShRX2, ShRU3, ShRW3, ShLU1, ShLX1, ShLU2, ShLX2, ShLU3, ShLW3);
+    if (check_output_q15(mbconv_pred, mbconv_expected, N * HOUT * WOUT * COUT)) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+int main() {
+  if (test_q15_sparse_filter_pack()) {
+    printf("Test Failure for q15_sparse_filter_pack()!\n");
+  } else if (test_q15_sparse_convolution_vectors()) {
+    printf("Test Failure for q15_sparse_convolution()!\n");
+  } else if (test_sparse_convolution_random()) {
+    printf("Test Failure for the sparse convolutions (pruned filters)!\n");
+  } else if (test_sparse_mbconv_block()) {
+    printf("Test Failure for the sparse MBConv blocks!\n");
+  } else {
+    printf("All Tests Passed!\n");
+    return 0;
+  }
+  return -1;
+}
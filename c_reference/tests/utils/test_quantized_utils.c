@@ -2,7 +2,11 @@
 // Licensed under the MIT license.
 
 #include <stdio.h>
+#include <stdlib.h>
 #include "quantized_utils.h"
+#ifdef SIMD
+  #include "quantized_simd.h"
+#endif
 
 // All values generated from Seedot on Wider Regression dataset.
 // By default, all tests run without using bit-shifting operations.
@@ -140,6 +144,43 @@ int test_q15_v_tanh() {
   return (check_output_q15(pred_A, expected_A, 8) || check_output_q15(pred_B, expected_B, 8));
 }
 
+// Test q15_v_sigmoid_lut() and q15_v_tanh_lut() functions, and their bound on the error over every input.
+int test_q15_v_activation_lut() {
+  const Q15_T qvec_A[8] = {-2772, -1358, -3028, -389, -1666, -2070, -608, -699};
+  const Q15_T qvec_B[8] = {178, 1064, -4162, 1718, -1663, 853, 1244, 1282};
+  const Q15_T expected_A[8] = {3363, 5571, 3042, 7416, 5032, 4371, 6985, 6807};
+  const Q15_T expected_B[8] = {1420, 7821, -15830, 11226, -10989, 6454, 8884, 9097};
+  static Q15_T qvec_C[65536], pred_exp[65536], pred_lut[65536];
+  Q15_T pred_A[8], pred_B[8];
+
+  q15_v_sigmoid(&qvec_A[0], 8, &pred_A[0], 2, 1024, 2048, 11, 14, Q_ACTIVATION_LUT);
+  q15_v_tanh_lut(&qvec_B[0], 8, &pred_B[0]);
+  if (check_output_q15(pred_A, expected_A, 8) || check_output_q15(pred_B, expected_B, 8)) {
+    return 1;
+  }
+
+  for (unsigned i = 0; i < 65536; i++) {
+    qvec_C[i] = (Q15_T)((int)i - 32768);
+  }
+  q15_v_sigmoid(qvec_C, 65536, pred_exp, 2, 1024, 2048, 11, 14, Q_ACTIVATION_EXP_TABLES);
+  q15_v_sigmoid_lut(qvec_C, 65536, pred_lut);
+  for (unsigned i = 0; i < 65536; i++) {
+    if (pred_lut[i] - pred_exp[i] > 2 || pred_exp[i] - pred_lut[i] > 2) {
+      printf("Output: %d, Expected: %d at Index: %d\n", pred_lut[i], pred_exp[i], i);
+      return 1;
+    }
+  }
+  q15_v_tanh(qvec_C, 65536, pred_exp, 11, 11, Q_ACTIVATION_EXP_TABLES);
+  q15_v_tanh(qvec_C, 65536, pred_lut, 11, 11, Q_ACTIVATION_LUT);
+  for (unsigned i = 0; i < 65536; i++) {
+    if (pred_lut[i] - pred_exp[i] > 3 || pred_exp[i] - pred_lut[i] > 3) {
+      printf("Output: %d, Expected: %d at Index: %d\n", pred_lut[i], pred_exp[i], i);
+      return 1;
+    }
+  }
+  return 0;
+}
+
 // Test q15_v_scalar_add() function.
 int test_q15_v_scalar_add() {
   const Q15_T qscalar_A = 30111;
@@ -821,6 +862,143 @@ int test_q15_convolution() {
   return (check_output_q15(pred_A, expected_A, 4) || check_output_q15(pred_B, expected_B, 2) || check_output_q15(pred_C, expected_C, 16) || check_output_q15(pred_D, expected_D, 36));
 }
 
+// Test the pointwise (1x1, one group, no padding) and depthwise (CF = COut = 1) shapes, which run specialized kernels.
+// There are more channels than Q_CONV_TILE, and the depthwise output has both border and interior receptive fields.
+int test_q_convolution_pointwise_depthwise() {
+  Q15_T qmat_A[4 * 4 * 17], qmat_B[18 * 3], qmat_C[17 * 3 * 3];
+  Q7_T qmat_D[4 * 4 * 17];
+  for (unsigned i = 0; i < 4 * 4 * 17; i++) {
+    qmat_A[i] = (Q15_T)(((i * 13) ^ (i >> 2)) % 7) - 3;
+    qmat_D[i] = (Q7_T)qmat_A[i];
+  }
+  for (unsigned i = 0; i < 18 * 3; i++) {
+    qmat_B[i] = (Q15_T)(((i * 11) ^ (i >> 2)) % 7) - 3;
+  }
+  for (unsigned i = 0; i < 17 * 3 * 3; i++) {
+    qmat_C[i] = (Q15_T)(((i * 11) ^ (i >> 2)) % 7) - 3;
+  }
+
+  const Q15_T expected_A[2 * 2 * 18] = {17, -7, -9, -15, -9, -8, 2, -2, -14, -16, 3, -4, 2, 6, -13, 6, -7, 1,
+                                        7, 3, -1, 1, 3, 0, 0, -4, -16, -2, 15, 6, 8, 0, 1, -2, 5, -9,
+
+                                        5, 1, 15, 1, 7, -4, -6, -14, -10, -4, 3, 0, 6, 10, -5, -14, -3, 1,
+                                        -5, 6, 12, 10, 10, 3, -4, -7, -3, 7, 6, 5, 5, 1, 6, -11, 5, -4};
+  const Q15_T expected_B[2 * 2 * 17] = {-21, -17, 1, 5, -7, -6, 8, -3, 3, 1, -4, -15, -4, -1, 10, -6, -20,
+                                        -2, 5, -9, -12, -14, -14, 5, 16, -17, -10, -5, 16, -2, -4, 13, 6, 22,
+
+                                        4, 14, 0, -6, 8, 1, 12, -9, 2, 5, 10, 0, 2, 5, 9, -9, 29,
+                                        0, -19, -8, -2, -1, 11, 23, 10, 11, -1, 1, -29, -14, 2, -21, -9, -31};
+  Q7_T expected_q7_A[2 * 2 * 18], pred_q7_A[2 * 2 * 18];
+  Q15_T pred_A[2 * 2 * 18], pred_B[2 * 2 * 17], pred_q15_B[2 * 2 * 17];
+  for (unsigned i = 0; i < 2 * 2 * 18; i++) {
+    expected_q7_A[i] = (Q7_T)expected_A[i];
+  }
+
+  #ifdef SHIFT
+    SCALE_T scale = 0;
+  #else
+    SCALE_T scale = 1;
+  #endif
+  // 2x3x3 input, 1x1 filter with 18 output channels, column stride 2
+  q15_convolution(qmat_A, qmat_B, pred_A, 1, 2, 3, 3, 1, 1, 3, 18, 2, 2, 1, 0, 0, 0, 0, 1, 2, 1, 1, scale, scale, scale);
+  q7xq15_q7_convolution(qmat_D, qmat_B, pred_q7_A, 1, 2, 3, 3, 1, 1, 3, 18, 2, 2, 1, 0, 0, 0, 0, 1, 2, 1, 1, scale, scale, scale);
+  // 4x4x17 input, 3x3 depthwise filter, padding 1 and stride 2
+  q15_convolution(qmat_A, qmat_C, pred_B, 1, 4, 4, 17, 3, 3, 1, 1, 2, 2, 17, 1, 1, 1, 1, 2, 2, 1, 1, scale, scale, scale);
+  q7xq15_q15_convolution(qmat_D, qmat_C, pred_q15_B, 1, 4, 4, 17, 3, 3, 1, 1, 2, 2, 17, 1, 1, 1, 1, 2, 2, 1, 1, scale, scale, scale);
+
+  return (check_output_q15(pred_A, expected_A, 2 * 2 * 18) || check_output_q7(pred_q7_A, expected_q7_A, 2 * 2 * 18) ||
+          check_output_q15(pred_B, expected_B, 2 * 2 * 17) || check_output_q15(pred_q15_B, expected_B, 2 * 2 * 17));
+}
+
+#ifdef SIMD
+// Runs the vectorized operators on random data with every supported SIMD level
+// and compares them against the scalar code (Q_SIMD_NONE).
+// The lengths and the channel counts are chosen such that both the vector code
+// and the scalar remainder loops are exercised.
+#define SIMD_TEST_LEN 77
+#define SIMD_TEST_ROWS 5
+#define SIMD_TEST_H 5
+#define SIMD_TEST_W 6
+#define SIMD_TEST_CIN 11
+#define SIMD_TEST_COUT 19
+
+static void run_simd_ops(const Q15_T* qvec_A, const Q15_T* qvec_B,
+                         const Q7_T* qvec_C, const Q15_T* qmat,
+                         Q15_T* pred_q15, Q7_T* pred_q7) {
+  #ifdef SHIFT
+    q15_v_add(qvec_A, qvec_B, SIMD_TEST_LEN, pred_q15, 0, 3, 1, 1);
+    q15_v_hadamard(qvec_A, qvec_B, SIMD_TEST_LEN, pred_q15 + SIMD_TEST_LEN, 5, 6);
+    q15xq7_q15_m_mulvec(qmat, qvec_C, SIMD_TEST_ROWS, SIMD_TEST_LEN, pred_q15 + 2 * SIMD_TEST_LEN, 5, 3, 2, 0);
+    q15_m_mulvec(qmat, qvec_A, SIMD_TEST_ROWS, SIMD_TEST_LEN, pred_q15 + 3 * SIMD_TEST_LEN, 8, 8, 2, 0);
+    q15_t_add_vec(qvec_A, qvec_B, 1, 1, 4, 19, pred_q15 + 4 * SIMD_TEST_LEN, 1, 2, 1);
+    q7xq15_q7_convolution(qvec_C, qmat, pred_q7, 1, SIMD_TEST_H, SIMD_TEST_W, SIMD_TEST_CIN, 3, 3, SIMD_TEST_CIN, SIMD_TEST_COUT, SIMD_TEST_H, SIMD_TEST_W, 1, 1, 1, 1, 1, 1, 1, 1, 1, 8, 4, 4);
+    q7xq15_q15_convolution(qvec_C, qmat, pred_q15 + 5 * SIMD_TEST_LEN, 1, SIMD_TEST_H, SIMD_TEST_W, SIMD_TEST_CIN, 3, 3, SIMD_TEST_CIN, SIMD_TEST_COUT, SIMD_TEST_H, SIMD_TEST_W, 1, 1, 1, 1, 1, 1, 1, 1, 1, 4, 4, 2);
+    q15_convolution(qmat, qmat, pred_q15 + 5 * SIMD_TEST_LEN + SIMD_TEST_H * SIMD_TEST_W * SIMD_TEST_COUT, 1, SIMD_TEST_H, SIMD_TEST_W, SIMD_TEST_CIN, 3, 3, SIMD_TEST_CIN, SIMD_TEST_COUT, SIMD_TEST_H, SIMD_TEST_W, 1, 1, 1, 1, 1, 1, 1, 1, 1, 8, 8, 8);
+  #else
+    q15_v_add(qvec_A, qvec_B, SIMD_TEST_LEN, pred_q15, 1, 8, 2, 2);
+    q15_v_hadamard(qvec_A, qvec_B, SIMD_TEST_LEN, pred_q15 + SIMD_TEST_LEN, 32, 64);
+    q15xq7_q15_m_mulvec(qmat, qvec_C, SIMD_TEST_ROWS, SIMD_TEST_LEN, pred_q15 + 2 * SIMD_TEST_LEN, 32, 8, 4, 1);
+    q15_m_mulvec(qmat, qvec_A, SIMD_TEST_ROWS, SIMD_TEST_LEN, pred_q15 + 3 * SIMD_TEST_LEN, 256, 256, 4, 1);
+    q15_t_add_vec(qvec_A, qvec_B, 1, 1, 4, 19, pred_q15 + 4 * SIMD_TEST_LEN, 2, 3, 2);
+    q7xq15_q7_convolution(qvec_C, qmat, pred_q7, 1, SIMD_TEST_H, SIMD_TEST_W, SIMD_TEST_CIN, 3, 3, SIMD_TEST_CIN, SIMD_TEST_COUT, SIMD_TEST_H, SIMD_TEST_W, 1, 1, 1, 1, 1, 1, 1, 1, 1, 256, 16, 16);
+    q7xq15_q15_convolution(qvec_C, qmat, pred_q15 + 5 * SIMD_TEST_LEN, 1, SIMD_TEST_H, SIMD_TEST_W, SIMD_TEST_CIN, 3, 3, SIMD_TEST_CIN, SIMD_TEST_COUT, SIMD_TEST_H, SIMD_TEST_W, 1, 1, 1, 1, 1, 1, 1, 1, 1, 16, 16, 3);
+    q15_convolution(qmat, qmat, pred_q15 + 5 * SIMD_TEST_LEN + SIMD_TEST_H * SIMD_TEST_W * SIMD_TEST_COUT, 1, SIMD_TEST_H, SIMD_TEST_W, SIMD_TEST_CIN, 3, 3, SIMD_TEST_CIN, SIMD_TEST_COUT, SIMD_TEST_H, SIMD_TEST_W, 1, 1, 1, 1, 1, 1, 1, 1, 1, 256, 256, 256);
+  #endif
+  q15_v_sigmoid_lut(qvec_A, SIMD_TEST_LEN, pred_q15 + 5 * SIMD_TEST_LEN + 2 * SIMD_TEST_H * SIMD_TEST_W * SIMD_TEST_COUT);
+  q15_v_tanh_lut(qvec_B, SIMD_TEST_LEN, pred_q15 + 6 * SIMD_TEST_LEN + 2 * SIMD_TEST_H * SIMD_TEST_W * SIMD_TEST_COUT);
+}
+
+// Test the SIMD kernels against the scalar code.
+int test_simd_levels() {
+  // The matrix doubles as the convolution input and filter, hence its size
+  static Q15_T qvec_A[SIMD_TEST_LEN], qvec_B[SIMD_TEST_LEN], qmat[3 * 3 * SIMD_TEST_H * SIMD_TEST_W * SIMD_TEST_CIN * SIMD_TEST_COUT];
+  static Q7_T qvec_C[SIMD_TEST_H * SIMD_TEST_W * SIMD_TEST_CIN];
+  static Q15_T expected_q15[7 * SIMD_TEST_LEN + 2 * SIMD_TEST_H * SIMD_TEST_W * SIMD_TEST_COUT], pred_q15[7 * SIMD_TEST_LEN + 2 * SIMD_TEST_H * SIMD_TEST_W * SIMD_TEST_COUT];
+  static Q7_T expected_q7[SIMD_TEST_H * SIMD_TEST_W * SIMD_TEST_COUT], pred_q7[SIMD_TEST_H * SIMD_TEST_W * SIMD_TEST_COUT];
+  const unsigned len_q15 = 7 * SIMD_TEST_LEN + 2 * SIMD_TEST_H * SIMD_TEST_W * SIMD_TEST_COUT;
+  const unsigned len_q7 = SIMD_TEST_H * SIMD_TEST_W * SIMD_TEST_COUT;
+  const unsigned len_mat = sizeof(qmat) / sizeof(qmat[0]);
+  int default_level = q_simd_level();
+
+  srand(42);
+  for (unsigned i = 0; i < SIMD_TEST_LEN; i++) {
+    qvec_A[i] = (Q15_T)(rand() % 65536 - 32768);
+    qvec_B[i] = (Q15_T)(rand() % 65536 - 32768);
+  }
+  for (unsigned i = 0; i < len_mat; i++) {
+    qmat[i] = (Q15_T)(rand() % 65536 - 32768);
+  }
+  for (unsigned i = 0; i < SIMD_TEST_H * SIMD_TEST_W * SIMD_TEST_CIN; i++) {
+    qvec_C[i] = (Q7_T)(rand() % 256 - 128);
+  }
+  // Extreme values, including a -32768 * -32768 pair which overflows pmaddwd
+  // in q15_m_mulvec() and one in q15_convolution() (centre tap of the first output)
+  qvec_A[0] = qvec_A[1] = Q15_TMIN;
+  qmat[0] = qmat[1] = Q15_TMIN;
+  qmat[4 * SIMD_TEST_CIN * SIMD_TEST_COUT] = qmat[4 * SIMD_TEST_CIN * SIMD_TEST_COUT + SIMD_TEST_COUT] = Q15_TMIN;
+  qvec_B[0] = Q15_TMIN;
+  qvec_B[1] = Q15_TMAX;
+
+  q_simd_set_level(Q_SIMD_NONE);
+  run_simd_ops(qvec_A, qvec_B, qvec_C, qmat, expected_q15, expected_q7);
+
+  for (int level = Q_SIMD_SSE41; level <= Q_SIMD_NEON; level++) {
+    if (q_simd_set_level(level) != level) {
+      continue;
+    }
+    run_simd_ops(qvec_A, qvec_B, qvec_C, qmat, pred_q15, pred_q7);
+    if (check_output_q15(pred_q15, expected_q15, len_q15) || check_output_q7(pred_q7, expected_q7, len_q7)) {
+      printf("Mismatch for SIMD level: %d\n", level);
+      q_simd_set_level(default_level);
+      return 1;
+    }
+  }
+
+  q_simd_set_level(default_level);
+  return 0;
+}
+#endif
+
 int main() {
   if (test_q15_v_add()) {
     printf("Test Failure for q15_v_add()!\n");
@@ -836,6 +1014,8 @@ int main() {
     printf("Test Failure for q15_v_sigmoid()!\n");
   } else if (test_q15_v_tanh()) {
     printf("Test Failure for q15_v_tanh()!\n");
+  } else if (test_q15_v_activation_lut()) {
+    printf("Test Failure for q15_v_sigmoid_lut() / q15_v_tanh_lut()!\n");
   } else if (test_q15_v_scalar_add()) {
     printf("Test Failure for q15_v_scalar_add()!\n");
   } else if (test_q15_v_scalar_sub()) {
@@ -874,7 +1054,15 @@ int main() {
     printf("Test Failure for q7xq15_q15_convolution()!\n");
   } else if (test_q15_convolution()) {
     printf("Test Failure for q15_convolution()!\n");
-  } else {
+  } else if (test_q_convolution_pointwise_depthwise()) {
+    printf("Test Failure for the pointwise and depthwise convolutions!\n");
+  }
+  #ifdef SIMD
+    else if (test_simd_levels()) {
+      printf("Test Failure for the SIMD kernels!\n");
+    }
+  #endif
+  else {
     printf("All Tests Passed!\n");
     return 0;
   }
@@ -12,6 +12,7 @@ import traceback
 
 import seedot.common as Common
 from seedot.main import Main
+from seedot.tuner import Tuner
 import seedot.util as Util
 
 
@@ -34,6 +35,24 @@ class MainDriver:
                             help="Scratch directory for intermediate files")
         parser.add_argument("-o", "--outdir", metavar='',
                             help="Directory to output the generated Arduino sketch")
+        parser.add_argument("--shift", action="store_true",
+                            help="Scale with arithmetic shifts instead of divisions")
+        parser.add_argument("--no-templates", action="store_true",
+                            help="Call the functions of library.cpp from the x86 code instead of instantiating library_template.h")
+        parser.add_argument("--tune", action="store_true",
+                            help="Explore the bitwidths, exp table lengths, scaling operations and scale factors, and report the Pareto frontier")
+        parser.add_argument("--workers", type=int, default=os.cpu_count(), metavar='',
+                            help="Number of worker processes compiling and evaluating the candidates of --tune, which are then timed one at a time")
+        parser.add_argument("--bitwidths", type=int, nargs='+', choices=[16, 32], default=[16, 32], metavar='',
+                            help="Bitwidths explored by --tune")
+        parser.add_argument("--exp-lengths", type=int, nargs='+', metavar='',
+                            help="Exp table lengths explored by --tune (default: 5 6 7 for ProtoNN)")
+        parser.add_argument("--scalings", nargs='+', choices=["div", "shift"], metavar='',
+                            help="Scaling operations explored by --tune (default: div, or shift with --shift). With both, the accuracy of shift is reported against div")
+        parser.add_argument("--target-accuracy", type=float, metavar='',
+                            help="Accuracy (%%) for which --tune reports the fastest configuration")
+        parser.add_argument("--profile-ranges", choices=["range", "histogram"],
+                            help="Profile the range of each variable of the fixed-point code on the training dataset, optionally with a histogram of its number of bits")
 
         self.args = parser.parse_args()
 
@@ -59,6 +78,15 @@ class MainDriver:
             Common.outdir = os.path.join(Common.tempdir, "arduino")
             os.makedirs(Common.outdir, exist_ok=True)
 
+        if self.args.shift:
+            Util.setShrType("shift")
+
+        Util.setProfileRanges(self.args.profile_ranges)
+        Util.setLibraryTemplates(not self.args.no_templates)
+
+        if self.args.workers < 1:
+            parser.error("--workers must be positive")
+
     def checkMSBuildPath(self):
         found = False
         for path in Common.msbuildPathOptions:
@@ -70,6 +98,20 @@ class MainDriver:
             raise Exception("Msbuild.exe not found at the following locations:\n%s\nPlease change the path and run again" % (
                 Common.msbuildPathOptions))
 
+    def tune(self):
+        # Shifts are only explored on request, as their accuracy against divisions depends on the dataset.
+        # Bonsai has no exponentiation
+        shrTypes = self.args.scalings
+        if shrTypes is None:
+            shrTypes = ["shift"] if self.args.shift else ["div"]
+        expBitLengths = self.args.exp_lengths
+        if expBitLengths is None:
+            expBitLengths = [5, 6, 7] if self.args.algo == Common.Algo.Protonn else [Util.getExpBitLength()]
+
+        obj = Tuner(self.args.algo, self.args.train, self.args.test, self.args.model, self.args.bitwidths,
+                    expBitLengths, shrTypes, self.args.workers, self.args.target_accuracy)
+        obj.run()
+
     def run(self):
         if Util.windows():
             self.checkMSBuildPath()
@@ -84,6 +126,10 @@ class MainDriver:
         print("Model directory: %s" % (modelDir))
         print("================================\n")
 
+        if self.args.tune:
+            self.tune()
+            return
+
         obj = Main(algo, version, Common.Target.Arduino,
                    trainingInput, testingInput, modelDir, None)
         obj.run()
@@ -3,8 +3,11 @@
 
 #pragma once
 
+// INT32 can also be set with -DINT32
+#if !defined(INT16) && !defined(INT32)
 #define INT16
 //#define INT32
+#endif
 
 
 #ifdef INT16
@@ -16,3 +19,14 @@ typedef int32_t MYINT;
 #endif
 
 typedef uint16_t MYUINT;
+
+// With SHIFT, the scales given to the library are shift amounts and scaling down rounds toward -infinity.
+// Otherwise they are powers of two and scaling down is a division, rounding toward zero. SHIFT is set by
+// "make DEFINES=-DSHIFT" for the code generated with --shift
+#ifdef SHIFT
+#define SCALE_DOWN(x, shr) ((x) >> (shr))
+#define HALVE(x) ((x) >> 1)
+#else
+#define SCALE_DOWN(x, shr) ((x) / (shr))
+#define HALVE(x) ((x) / 2)
+#endif
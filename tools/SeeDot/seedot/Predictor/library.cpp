@@ -5,6 +5,7 @@
 
 #include "datatypes.h"
 #include "library.h"
+#include "treesum.h"
 
 // This file contains implementations of the linear algebra operators supported by SeeDot.
 // Each function takes the scaling factors as arguments along with the pointers to the operands.
@@ -16,11 +17,11 @@ void MatAdd(MYINT *A, MYINT *B, MYINT *C, MYINT I, MYINT J, MYINT shrA, MYINT sh
 			MYINT a = A[i * J + j];
 			MYINT b = B[i * J + j];
 
-			a = a / shrA;
-			b = b / shrB;
+			a = SCALE_DOWN(a, shrA);
+			b = SCALE_DOWN(b, shrB);
 
 			MYINT c = a + b;
-			c = c / shrC;
+			c = SCALE_DOWN(c, shrC);
 
 			C[i * J + j] = c;
 		}
@@ -35,11 +36,11 @@ void MatSub(MYINT *A, const MYINT *B, MYINT *C, MYINT I, MYINT J, MYINT shrA, MY
 			MYINT a = A[i * J + j];
 			MYINT b = B[i * J + j];
 
-			a = a / shrA;
-			b = b / shrB;
+			a = SCALE_DOWN(a, shrA);
+			b = SCALE_DOWN(b, shrB);
 
 			MYINT c = a - b;
-			c = c / shrC;
+			c = SCALE_DOWN(c, shrC);
 
 			C[i * J + j] = c;
 		}
@@ -47,191 +48,86 @@ void MatSub(MYINT *A, const MYINT *B, MYINT *C, MYINT I, MYINT J, MYINT shrA, MY
 	return;
 }
 
-// C = A * B
-void MatMulNN(MYINT *A, MYINT *B, MYINT *C, MYINT *tmp, MYINT I, MYINT K, MYINT J, MYINT shrA, MYINT shrB, MYINT H1, MYINT H2) {
-
-	for (MYINT i = 0; i < I; i++) {
-		for (MYINT j = 0; j < J; j++) {
-			for (MYINT k = 0; k < K; k++) {
-				MYINT a = A[i * K + k];
-				MYINT b = B[k * J + j];
-
-				a = a / shrA;
-				b = b / shrB;
-
-				tmp[k] = a * b;
-			}
-
-			MYINT count = K, depth = 0;
-			bool shr = true;
-
-			while (depth < (H1 + H2)) {
-				if (depth >= H1)
-					shr = false;
-
-				for (MYINT p = 0; p < (K / 2 + 1); p++) {
-					MYINT sum;
-					if (p < (count >> 1))
-						sum = tmp[2 * p] + tmp[(2 * p) + 1];
-					else if ((p == (count >> 1)) && ((count & 1) == 1))
-						sum = tmp[2 * p];
-					else
-						sum = 0;
-
-					if (shr)
-						tmp[p] = sum / 2;
-					else
-						tmp[p] = sum;
+// C = A * B. The tree sums of C[i][j0..j0 + TREESUM_LANES) take their products from a row of B, or when B has fewer
+// columns than A has rows, as in matrix-vector products, the ones of C[i0..i0 + TREESUM_LANES)[j] from a column of A
+static void MatMul(const MYINT *A, const MYINT *B, MYINT *C, MYINT I, MYINT K, MYINT J, MYINT shrA, MYINT shrB, MYINT H1, MYINT H2) {
+	MYINT pending[TREESUM_LEVELS][TREESUM_LANES];
+	MYINT node[TREESUM_LANES];
+	MYINT result[TREESUM_LANES];
+	Scale scaleA = makeScale(shrA);
+	Scale scaleB = makeScale(shrB);
+	MYINT count = treeSumCount(K, H1, H2);
+
+	if (J < TREESUM_LANES && J < I) {
+		for (MYINT i0 = 0; i0 < I; i0 += TREESUM_LANES) {
+			MYINT lanes = (I - i0) < TREESUM_LANES ? (I - i0) : TREESUM_LANES;
+
+			for (MYINT j = 0; j < J; j++) {
+				for (MYINT k = 0; k < count; k++) {
+					for (MYINT l = 0; l < lanes; l++)
+						node[l] = A[(i0 + l) * K + k];
+					scaleLanes(node, node, lanes, scaleA);
+
+					MYINT b = B[k * J + j];
+					b = SCALE_DOWN(b, shrB);
+					for (MYINT l = 0; l < lanes; l++)
+						node[l] = node[l] * b;
+
+					treeSumPush(pending, node, k, lanes, H1);
 				}
-				count = (count + 1) >> 1;
 
-				depth++;
+				treeSumResult(pending, node, count, lanes, H1, H2, result);
+				for (MYINT l = 0; l < lanes; l++)
+					C[(i0 + l) * J + j] = result[l];
 			}
-
-			C[i * J + j] = tmp[0];
 		}
+		return;
 	}
-	return;
-}
 
-// C = A * B
-void MatMulCN(const MYINT *A, MYINT *B, MYINT *C, MYINT *tmp, MYINT I, MYINT K, MYINT J, MYINT shrA, MYINT shrB, MYINT H1, MYINT H2) {
+	// A block of columns of B is reused for all the rows of A
+	for (MYINT j0 = 0; j0 < J; j0 += TREESUM_LANES) {
+		MYINT lanes = (J - j0) < TREESUM_LANES ? (J - j0) : TREESUM_LANES;
 
-	for (MYINT i = 0; i < I; i++) {
-		for (MYINT j = 0; j < J; j++) {
-			for (MYINT k = 0; k < K; k++) {
+		for (MYINT i = 0; i < I; i++) {
+			for (MYINT k = 0; k < count; k++) {
 				MYINT a = A[i * K + k];
-				MYINT b = B[k * J + j];
+				a = SCALE_DOWN(a, shrA);
 
-				a = a / shrA;
-				b = b / shrB;
+				scaleLanes(&B[k * J + j0], node, lanes, scaleB);
+				for (MYINT l = 0; l < lanes; l++)
+					node[l] = a * node[l];
 
-				tmp[k] = a * b;
+				treeSumPush(pending, node, k, lanes, H1);
 			}
 
-			MYINT count = K, depth = 0;
-			bool shr = true;
-
-			while (depth < (H1 + H2)) {
-				if (depth >= H1)
-					shr = false;
-
-				for (MYINT p = 0; p < (K / 2 + 1); p++) {
-					MYINT sum;
-					if (p < (count >> 1))
-						sum = tmp[2 * p] + tmp[(2 * p) + 1];
-					else if ((p == (count >> 1)) && ((count & 1) == 1))
-						sum = tmp[2 * p];
-					else
-						sum = 0;
-
-					if (shr)
-						tmp[p] = sum / 2;
-					else
-						tmp[p] = sum;
-				}
-				count = (count + 1) >> 1;
-
-				depth++;
-			}
-
-			C[i * J + j] = tmp[0];
+			treeSumResult(pending, node, count, lanes, H1, H2, &C[i * J + j0]);
 		}
 	}
 	return;
 }
 
 // C = A * B
-void MatMulNC(MYINT *A, const MYINT *B, MYINT *C, MYINT *tmp, MYINT I, MYINT K, MYINT J, MYINT shrA, MYINT shrB, MYINT H1, MYINT H2) {
-
-	for (MYINT i = 0; i < I; i++) {
-		for (MYINT j = 0; j < J; j++) {
-			for (MYINT k = 0; k < K; k++) {
-				MYINT a = A[i * K + k];
-				MYINT b = B[k * J + j];
-
-				a = a / shrA;
-				b = b / shrB;
-
-				tmp[k] = a * b;
-			}
-
-			MYINT count = K, depth = 0;
-			bool shr = true;
-
-			while (depth < (H1 + H2)) {
-				if (depth >= H1)
-					shr = false;
-
-				for (MYINT p = 0; p < (K / 2 + 1); p++) {
-					MYINT sum;
-					if (p < (count >> 1))
-						sum = tmp[2 * p] + tmp[(2 * p) + 1];
-					else if ((p == (count >> 1)) && ((count & 1) == 1))
-						sum = tmp[2 * p];
-					else
-						sum = 0;
-
-					if (shr)
-						tmp[p] = sum / 2;
-					else
-						tmp[p] = sum;
-				}
-				count = (count + 1) >> 1;
+// tmp is not used, the tree sums are computed by MatMul
+void MatMulNN(MYINT *A, MYINT *B, MYINT *C, MYINT *tmp, MYINT I, MYINT K, MYINT J, MYINT shrA, MYINT shrB, MYINT H1, MYINT H2) {
+	MatMul(A, B, C, I, K, J, shrA, shrB, H1, H2);
+	return;
+}
 
-				depth++;
-			}
+// C = A * B
+void MatMulCN(const MYINT *A, MYINT *B, MYINT *C, MYINT *tmp, MYINT I, MYINT K, MYINT J, MYINT shrA, MYINT shrB, MYINT H1, MYINT H2) {
+	MatMul(A, B, C, I, K, J, shrA, shrB, H1, H2);
+	return;
+}
 
-			C[i * J + j] = tmp[0];
-		}
-	}
+// C = A * B
+void MatMulNC(MYINT *A, const MYINT *B, MYINT *C, MYINT *tmp, MYINT I, MYINT K, MYINT J, MYINT shrA, MYINT shrB, MYINT H1, MYINT H2) {
+	MatMul(A, B, C, I, K, J, shrA, shrB, H1, H2);
 	return;
 }
 
 // C = A * B
 void MatMulCC(const MYINT *A, const MYINT *B, MYINT *C, MYINT *tmp, MYINT I, MYINT K, MYINT J, MYINT shrA, MYINT shrB, MYINT H1, MYINT H2) {
-
-	for (MYINT i = 0; i < I; i++) {
-		for (MYINT j = 0; j < J; j++) {
-			for (MYINT k = 0; k < K; k++) {
-				MYINT a = A[i * K + k];
-				MYINT b = B[k * J + j];
-
-				a = a / shrA;
-				b = b / shrB;
-
-				tmp[k] = a * b;
-			}
-
-			MYINT count = K, depth = 0;
-			bool shr = true;
-
-			while (depth < (H1 + H2)) {
-				if (depth >= H1)
-					shr = false;
-
-				for (MYINT p = 0; p < (K / 2 + 1); p++) {
-					MYINT sum;
-					if (p < (count >> 1))
-						sum = tmp[2 * p] + tmp[(2 * p) + 1];
-					else if ((p == (count >> 1)) && ((count & 1) == 1))
-						sum = tmp[2 * p];
-					else
-						sum = 0;
-
-					if (shr)
-						tmp[p] = sum / 2;
-					else
-						tmp[p] = sum;
-				}
-				count = (count + 1) >> 1;
-
-				depth++;
-			}
-
-			C[i * J + j] = tmp[0];
-		}
-	}
+	MatMul(A, B, C, I, K, J, shrA, shrB, H1, H2);
 	return;
 }
 
@@ -242,15 +138,15 @@ void SparseMatMul(const MYINT *Aidx, const MYINT *Aval, MYINT **B, MYINT *C, MYI
 	for (MYINT k = 0; k < K; k++) {
 		// MYINT b = getIntFeature(k);
 		MYINT b = B[k * 1][0];
-		b = b / shrB;
+		b = SCALE_DOWN(b, shrB);
 
 		MYINT idx = Aidx[ite_idx];
 		while (idx != 0) {
 			MYINT a = Aval[ite_val];
-			a = a / shrA;
+			a = SCALE_DOWN(a, shrA);
 
 			MYINT c = a * b;
-			c = c / shrC;
+			c = SCALE_DOWN(c, shrC);
 
 			C[idx - 1] += c;
 
@@ -272,8 +168,8 @@ void MulCir(MYINT *A, MYINT *B, MYINT *C, MYINT I, MYINT J, MYINT shrA, MYINT sh
 			MYINT a = A[i * J + j];
 			MYINT b = B[i * J + j];
 
-			a = a / shrA;
-			b = b / shrB;
+			a = SCALE_DOWN(a, shrA);
+			b = SCALE_DOWN(b, shrB);
 
 			C[i * J + j] = a * b;
 		}
@@ -337,12 +233,12 @@ void Transpose(MYINT *A, MYINT *B, MYINT I, MYINT J) {
 void ScalarMul(MYINT *A, MYINT *B, MYINT *C, MYINT I, MYINT J, MYINT shrA, MYINT shrB) {
 
 	MYINT a = *A;
-	a = a / shrA;
+	a = SCALE_DOWN(a, shrA);
 
 	for (MYINT i = 0; i < I; i++) {
 		for (MYINT j = 0; j < J; j++) {
 			MYINT b = B[i * J + j];
-			b = b / shrB;
+			b = SCALE_DOWN(b, shrB);
 
 			C[i * J + j] = a * b;
 		}
@@ -353,59 +249,42 @@ void ScalarMul(MYINT *A, MYINT *B, MYINT *C, MYINT I, MYINT J, MYINT shrA, MYINT
 
 // C = A # B
 // A[N][H][W][CI], B[HF][WF][CI][CO], C[N][H][W][CO]
+// tmp is not used, the tree sums of C[n][h][w][co0..co0 + TREESUM_LANES) are computed together
 void Conv(MYINT *A, const MYINT *B, MYINT *C, MYINT *tmp, MYINT N, MYINT H, MYINT W, MYINT CI, MYINT HF, MYINT WF, MYINT CO, MYINT shrA, MYINT shrB, MYINT H1, MYINT H2) {
 	MYINT padH = (HF - 1) / 2;
 	MYINT padW = (WF - 1) / 2;
 
-	for (MYINT n = 0; n < N; n++) {
-		for (MYINT h = 0; h < H; h++) {
-			for (MYINT w = 0; w < W; w++) {
-				for (MYINT co = 0; co < CO; co++) {
+	MYINT pending[TREESUM_LEVELS][TREESUM_LANES];
+	MYINT node[TREESUM_LANES];
+	Scale scaleB = makeScale(shrB);
+	MYINT count = treeSumCount(HF * WF * CI, H1, H2);
+
+	// A block of output channels of B is reused for all the pixels
+	for (MYINT co0 = 0; co0 < CO; co0 += TREESUM_LANES) {
+		MYINT lanes = (CO - co0) < TREESUM_LANES ? (CO - co0) : TREESUM_LANES;
+
+		for (MYINT n = 0; n < N; n++) {
+			for (MYINT h = 0; h < H; h++) {
+				for (MYINT w = 0; w < W; w++) {
 
 					MYINT counter = 0;
-					for (MYINT hf = 0; hf < HF; hf++) {
-						for (MYINT wf = 0; wf < WF; wf++) {
-							for (MYINT ci = 0; ci < CI; ci++) {
+					for (MYINT hf = 0; hf < HF && counter < count; hf++) {
+						for (MYINT wf = 0; wf < WF && counter < count; wf++) {
+							for (MYINT ci = 0; ci < CI && counter < count; ci++) {
 								MYINT a = (((((h + hf) < padH) || ((h + hf) >= (H + padH))) || (((w + wf) < padW) || ((w + wf) >= (W + padW)))) ? 0 : A[n * H * W * CI + ((h + hf) - padH) * W * CI + ((w + wf) - padW) * CI + ci]);
-								a = a / shrA;
+								a = SCALE_DOWN(a, shrA);
 
-								MYINT b = B[hf * WF * CI * CO + wf * CI * CO + ci * CO + co];
-								b = b / shrB;
+								scaleLanes(&B[hf * WF * CI * CO + wf * CI * CO + ci * CO + co0], node, lanes, scaleB);
+								for (MYINT l = 0; l < lanes; l++)
+									node[l] = a * node[l];
 
-								tmp[counter] = a * b;
+								treeSumPush(pending, node, counter, lanes, H1);
 								counter++;
 							}
 						}
 					}
 
-					MYINT totalEle = HF * WF * CI;
-					MYINT count = HF * WF * CI, depth = 0;
-					bool shr = true;
-
-					while (depth < (H1 + H2)) {
-						if (depth >= H1)
-							shr = false;
-
-						for (MYINT p = 0; p < (totalEle / 2 + 1); p++) {
-							MYINT sum;
-							if (p < (count >> 1))
-								sum = tmp[2 * p] + tmp[(2 * p) + 1];
-							else if ((p == (count >> 1)) && ((count & 1) == 1))
-								sum = tmp[2 * p];
-							else
-								sum = 0;
-
-							if (shr)
-								tmp[p] = sum / 2;
-							else
-								tmp[p] = sum;
-						}
-						count = (count + 1) >> 1;
-
-						depth++;
-					}
-
-					C[n * H * W * CO + h * W * CO + w * CO + co] = tmp[0];
+					treeSumResult(pending, node, count, lanes, H1, H2, &C[n * H * W * CO + h * W * CO + w * CO + co0]);
 				}
 			}
 		}
@@ -423,10 +302,10 @@ void AddOrSubCir4D(MYINT *A, const MYINT *B, MYINT N, MYINT H, MYINT W, MYINT C,
 			for (MYINT w = 0; w < W; w++) {
 				for (MYINT c = 0; c < C; c++) {
 					MYINT a = A[n * H * W * C + h * W * C + w * C + c];
-					a = a / shrA;
+					a = SCALE_DOWN(a, shrA);
 
 					MYINT b = B[c];
-					b = b / shrB;
+					b = SCALE_DOWN(b, shrB);
 
 					MYINT res;
 					if (add)
@@ -434,7 +313,7 @@ void AddOrSubCir4D(MYINT *A, const MYINT *B, MYINT N, MYINT H, MYINT W, MYINT C,
 					else
 						res = a - b;
 
-					res = res / shrC;
+					res = SCALE_DOWN(res, shrC);
 
 					A[n * H * W * C + h * W * C + w * C + c] = res;
 				}
@@ -452,10 +331,10 @@ void AddOrSubCir2D(MYINT *A, const MYINT *B, MYINT H, MYINT W, MYINT shrA, MYINT
 	for (MYINT h = 0; h < H; h++) {
 		for (MYINT w = 0; w < W; w++) {
 			MYINT a = A[h * W + w];
-			a = a / shrA;
+			a = SCALE_DOWN(a, shrA);
 
 			MYINT b = B[w];
-			b = b / shrB;
+			b = SCALE_DOWN(b, shrB);
 
 			MYINT res;
 			if (add)
@@ -463,7 +342,7 @@ void AddOrSubCir2D(MYINT *A, const MYINT *B, MYINT H, MYINT W, MYINT shrA, MYINT
 			else
 				res = a - b;
 
-			res = res / shrC;
+			res = SCALE_DOWN(res, shrC);
 
 			A[h * W + w] = res;
 		}
@@ -0,0 +1,426 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#pragma once
+
+#include "treesum.h"
+
+// Variant of library.h whose dimensions and scaling factors are template parameters. The generated code always passes
+// constants, so each call is compiled for its shapes: the loops have constant trip counts, which the compiler unrolls
+// and vectorizes, and the divisions by the scaling factors become shifts and multiplications.
+// The template parameters are the integer arguments of the function of library.cpp, in the same order, and the
+// results are the same.
+
+// C = A + B
+template<MYINT I, MYINT J, MYINT shrA, MYINT shrB, MYINT shrC>
+inline void MatAdd(MYINT *A, MYINT *B, MYINT *C) {
+	for (MYINT i = 0; i < I; i++) {
+		for (MYINT j = 0; j < J; j++) {
+			MYINT a = A[i * J + j];
+			MYINT b = B[i * J + j];
+
+			a = SCALE_DOWN(a, shrA);
+			b = SCALE_DOWN(b, shrB);
+
+			MYINT c = a + b;
+			c = SCALE_DOWN(c, shrC);
+
+			C[i * J + j] = c;
+		}
+	}
+	return;
+}
+
+// C = A - B
+template<MYINT I, MYINT J, MYINT shrA, MYINT shrB, MYINT shrC>
+inline void MatSub(MYINT *A, const MYINT *B, MYINT *C) {
+	for (MYINT i = 0; i < I; i++) {
+		for (MYINT j = 0; j < J; j++) {
+			MYINT a = A[i * J + j];
+			MYINT b = B[i * J + j];
+
+			a = SCALE_DOWN(a, shrA);
+			b = SCALE_DOWN(b, shrB);
+
+			MYINT c = a - b;
+			c = SCALE_DOWN(c, shrC);
+
+			C[i * J + j] = c;
+		}
+	}
+	return;
+}
+
+// C = A * B, with the tree sums of MatMul in library.cpp
+template<MYINT I, MYINT K, MYINT J, MYINT shrA, MYINT shrB, MYINT H1, MYINT H2>
+inline void MatMulTemplate(const MYINT *A, const MYINT *B, MYINT *C) {
+	MYINT pending[TREESUM_LEVELS][TREESUM_LANES];
+	MYINT node[TREESUM_LANES];
+	MYINT result[TREESUM_LANES];
+	const Scale scaleA = makeScale(shrA);
+	const Scale scaleB = makeScale(shrB);
+	const MYINT count = treeSumCount(K, H1, H2);
+
+	if (J < TREESUM_LANES && J < I) {
+		for (MYINT i0 = 0; i0 < I; i0 += TREESUM_LANES) {
+			MYINT lanes = (I - i0) < TREESUM_LANES ? (I - i0) : TREESUM_LANES;
+
+			for (MYINT j = 0; j < J; j++) {
+				for (MYINT k = 0; k < count; k++) {
+					for (MYINT l = 0; l < lanes; l++)
+						node[l] = A[(i0 + l) * K + k];
+					scaleLanes(node, node, lanes, scaleA);
+
+					MYINT b = B[k * J + j];
+					b = SCALE_DOWN(b, shrB);
+					for (MYINT l = 0; l < lanes; l++)
+						node[l] = node[l] * b;
+
+					treeSumPush(pending, node, k, lanes, H1);
+				}
+
+				treeSumResult(pending, node, count, lanes, H1, H2, result);
+				for (MYINT l = 0; l < lanes; l++)
+					C[(i0 + l) * J + j] = result[l];
+			}
+		}
+		return;
+	}
+
+	for (MYINT j0 = 0; j0 < J; j0 += TREESUM_LANES) {
+		MYINT lanes = (J - j0) < TREESUM_LANES ? (J - j0) : TREESUM_LANES;
+
+		for (MYINT i = 0; i < I; i++) {
+			for (MYINT k = 0; k < count; k++) {
+				MYINT a = A[i * K + k];
+				a = SCALE_DOWN(a, shrA);
+
+				scaleLanes(&B[k * J + j0], node, lanes, scaleB);
+				for (MYINT l = 0; l < lanes; l++)
+					node[l] = a * node[l];
+
+				treeSumPush(pending, node, k, lanes, H1);
+			}
+
+			treeSumResult(pending, node, count, lanes, H1, H2, &C[i * J + j0]);
+		}
+	}
+	return;
+}
+
+// C = A * B
+template<MYINT I, MYINT K, MYINT J, MYINT shrA, MYINT shrB, MYINT H1, MYINT H2>
+inline void MatMulNN(MYINT *A, MYINT *B, MYINT *C, MYINT *tmp) {
+	MatMulTemplate<I, K, J, shrA, shrB, H1, H2>(A, B, C);
+	return;
+}
+
+// C = A * B
+template<MYINT I, MYINT K, MYINT J, MYINT shrA, MYINT shrB, MYINT H1, MYINT H2>
+inline void MatMulCN(const MYINT *A, MYINT *B, MYINT *C, MYINT *tmp) {
+	MatMulTemplate<I, K, J, shrA, shrB, H1, H2>(A, B, C);
+	return;
+}
+
+// C = A * B
+template<MYINT I, MYINT K, MYINT J, MYINT shrA, MYINT shrB, MYINT H1, MYINT H2>
+inline void MatMulNC(MYINT *A, const MYINT *B, MYINT *C, MYINT *tmp) {
+	MatMulTemplate<I, K, J, shrA, shrB, H1, H2>(A, B, C);
+	return;
+}
+
+// C = A * B
+template<MYINT I, MYINT K, MYINT J, MYINT shrA, MYINT shrB, MYINT H1, MYINT H2>
+inline void MatMulCC(const MYINT *A, const MYINT *B, MYINT *C, MYINT *tmp) {
+	MatMulTemplate<I, K, J, shrA, shrB, H1, H2>(A, B, C);
+	return;
+}
+
+// C = A |*| B
+template<MYINT K, MYINT shrA, MYINT shrB, MYINT shrC>
+inline void SparseMatMul(const MYINT *Aidx, const MYINT *Aval, MYINT **B, MYINT *C) {
+	MYINT ite_idx = 0, ite_val = 0;
+	for (MYINT k = 0; k < K; k++) {
+		MYINT b = B[k * 1][0];
+		b = SCALE_DOWN(b, shrB);
+
+		MYINT idx = Aidx[ite_idx];
+		while (idx != 0) {
+			MYINT a = Aval[ite_val];
+			a = SCALE_DOWN(a, shrA);
+
+			MYINT c = a * b;
+			c = SCALE_DOWN(c, shrC);
+
+			C[idx - 1] += c;
+
+			ite_idx++;
+			ite_val++;
+
+			idx = Aidx[ite_idx];
+		}
+		ite_idx++;
+	}
+
+	return;
+}
+
+// C = A <*> B
+template<MYINT I, MYINT J, MYINT shrA, MYINT shrB>
+inline void MulCir(MYINT *A, MYINT *B, MYINT *C) {
+	for (MYINT i = 0; i < I; i++) {
+		for (MYINT j = 0; j < J; j++) {
+			MYINT a = A[i * J + j];
+			MYINT b = B[i * J + j];
+
+			a = SCALE_DOWN(a, shrA);
+			b = SCALE_DOWN(b, shrB);
+
+			C[i * J + j] = a * b;
+		}
+	}
+	return;
+}
+
+// A = tanh(A)
+template<MYINT I, MYINT J, MYINT tanh_limit>
+inline void TanH(MYINT *A) {
+	for (MYINT i = 0; i < I; i++) {
+		for (MYINT j = 0; j < J; j++) {
+			MYINT x = A[i * J + j], y;
+
+			if (x >= tanh_limit)
+				y = tanh_limit;
+			else if (x <= -tanh_limit)
+				y = -tanh_limit;
+			else
+				y = x;
+
+			A[i * J + j] = y;
+		}
+	}
+	return;
+}
+
+// index = argmax(A)
+template<MYINT I, MYINT J>
+inline void ArgMax(MYINT *A, MYINT *index) {
+	MYINT max = A[0], maxIndex = 0;
+	MYINT counter = 0;
+	for (MYINT i = 0; i < I; i++) {
+		for (MYINT j = 0; j < J; j++) {
+			MYINT x = A[i * J + j];
+
+			if (max < x) {
+				maxIndex = counter;
+				max = x;
+			}
+
+			counter++;
+		}
+	}
+
+	*index = maxIndex;
+
+	return;
+}
+
+// A = A^T
+template<MYINT I, MYINT J>
+inline void Transpose(MYINT *A, MYINT *B) {
+	for (MYINT i = 0; i < I; i++) {
+		for (MYINT j = 0; j < J; j++) {
+			B[i * J + j] = A[j * I + i];
+		}
+	}
+	return;
+}
+
+// C = a * B
+template<MYINT I, MYINT J, MYINT shrA, MYINT shrB>
+inline void ScalarMul(MYINT *A, MYINT *B, MYINT *C) {
+	MYINT a = *A;
+	a = SCALE_DOWN(a, shrA);
+
+	for (MYINT i = 0; i < I; i++) {
+		for (MYINT j = 0; j < J; j++) {
+			MYINT b = B[i * J + j];
+			b = SCALE_DOWN(b, shrB);
+
+			C[i * J + j] = a * b;
+		}
+	}
+
+	return;
+}
+
+// C = A # B, with the tree sums of Conv in library.cpp
+// A[N][H][W][CI], B[HF][WF][CI][CO], C[N][H][W][CO]
+template<MYINT N, MYINT H, MYINT W, MYINT CI, MYINT HF, MYINT WF, MYINT CO, MYINT shrA, MYINT shrB, MYINT H1, MYINT H2>
+inline void Conv(MYINT *A, const MYINT *B, MYINT *C, MYINT *tmp) {
+	const MYINT padH = (HF - 1) / 2;
+	const MYINT padW = (WF - 1) / 2;
+
+	MYINT pending[TREESUM_LEVELS][TREESUM_LANES];
+	MYINT node[TREESUM_LANES];
+	const Scale scaleB = makeScale(shrB);
+	const MYINT count = treeSumCount(HF * WF * CI, H1, H2);
+
+	for (MYINT co0 = 0; co0 < CO; co0 += TREESUM_LANES) {
+		MYINT lanes = (CO - co0) < TREESUM_LANES ? (CO - co0) : TREESUM_LANES;
+
+		for (MYINT n = 0; n < N; n++) {
+			for (MYINT h = 0; h < H; h++) {
+				for (MYINT w = 0; w < W; w++) {
+
+					MYINT counter = 0;
+					for (MYINT hf = 0; hf < HF && counter < count; hf++) {
+						for (MYINT wf = 0; wf < WF && counter < count; wf++) {
+							for (MYINT ci = 0; ci < CI && counter < count; ci++) {
+								MYINT a = (((((h + hf) < padH) || ((h + hf) >= (H + padH))) || (((w + wf) < padW) || ((w + wf) >= (W + padW)))) ? 0 : A[n * H * W * CI + ((h + hf) - padH) * W * CI + ((w + wf) - padW) * CI + ci]);
+								a = SCALE_DOWN(a, shrA);
+
+								scaleLanes(&B[hf * WF * CI * CO + wf * CI * CO + ci * CO + co0], node, lanes, scaleB);
+								for (MYINT l = 0; l < lanes; l++)
+									node[l] = a * node[l];
+
+								treeSumPush(pending, node, counter, lanes, H1);
+								counter++;
+							}
+						}
+					}
+
+					treeSumResult(pending, node, count, lanes, H1, H2, &C[n * H * W * CO + h * W * CO + w * CO + co0]);
+				}
+			}
+		}
+	}
+
+	return;
+}
+
+// A = A <+> B
+// A[N][H][W][C], B[C]
+template<MYINT N, MYINT H, MYINT W, MYINT C, MYINT shrA, MYINT shrB, MYINT shrC, bool add>
+inline void AddOrSubCir4D(MYINT *A, const MYINT *B) {
+	for (MYINT n = 0; n < N; n++) {
+		for (MYINT h = 0; h < H; h++) {
+			for (MYINT w = 0; w < W; w++) {
+				for (MYINT c = 0; c < C; c++) {
+					MYINT a = A[n * H * W * C + h * W * C + w * C + c];
+					a = SCALE_DOWN(a, shrA);
+
+					MYINT b = B[c];
+					b = SCALE_DOWN(b, shrB);
+
+					MYINT res;
+					if (add)
+						res = a + b;
+					else
+						res = a - b;
+
+					res = SCALE_DOWN(res, shrC);
+
+					A[n * H * W * C + h * W * C + w * C + c] = res;
+				}
+			}
+		}
+	}
+
+	return;
+}
+
+// A = A <+> B
+// A[H][W], B[W]
+template<MYINT H, MYINT W, MYINT shrA, MYINT shrB, MYINT shrC, bool add>
+inline void AddOrSubCir2D(MYINT *A, const MYINT *B) {
+	for (MYINT h = 0; h < H; h++) {
+		for (MYINT w = 0; w < W; w++) {
+			MYINT a = A[h * W + w];
+			a = SCALE_DOWN(a, shrA);
+
+			MYINT b = B[w];
+			b = SCALE_DOWN(b, shrB);
+
+			MYINT res;
+			if (add)
+				res = a + b;
+			else
+				res = a - b;
+
+			res = SCALE_DOWN(res, shrC);
+
+			A[h * W + w] = res;
+		}
+	}
+
+	return;
+}
+
+// A = relu(A)
+// A[N][H][W][C]
+template<MYINT N, MYINT H, MYINT W, MYINT C>
+inline void Relu4D(MYINT *A) {
+	for (MYINT n = 0; n < N; n++) {
+		for (MYINT h = 0; h < H; h++) {
+			for (MYINT w = 0; w < W; w++) {
+				for (MYINT c = 0; c < C; c++) {
+					MYINT a = A[n * H * W * C + h * W * C + w * C + c];
+					if (a < 0)
+						a = 0;
+
+					A[n * H * W * C + h * W * C + w * C + c] = a;
+				}
+			}
+		}
+	}
+
+	return;
+}
+
+// A = relu(A)
+// A[H][W]
+template<MYINT H, MYINT W>
+inline void Relu2D(MYINT *A) {
+	for (MYINT h = 0; h < H; h++) {
+		for (MYINT w = 0; w < W; w++) {
+			MYINT a = A[h * W + w];
+			if (a < 0)
+				a = 0;
+
+			A[h * W + w] = a;
+		}
+	}
+
+	return;
+}
+
+// B = maxpool(A)
+// A[N][H][W][C], B[N][H / stride][W / stride][C]
+template<MYINT N, MYINT H, MYINT W, MYINT C, MYINT stride>
+inline void Maxpool(MYINT *A, MYINT *B) {
+	const MYINT HO = H / stride;
+	const MYINT WO = W / stride;
+
+	for (MYINT n = 0; n < N; n++) {
+		for (MYINT ho = 0; ho < HO; ho++) {
+			for (MYINT wo = 0; wo < WO; wo++) {
+				for (MYINT c = 0; c < C; c++) {
+
+					MYINT max = A[n * H * W * C + (stride * ho) * W * C + (stride * wo) * C + c];
+					for (MYINT hs = 0; hs < stride; hs++) {
+						for (MYINT ws = 0; ws < stride; ws++) {
+							MYINT a = A[n * H * W * C + ((stride * ho) + hs) * W * C + ((stride * wo) + ws) * C + c];
+							if (a > max)
+								max = a;
+						}
+					}
+
+					B[n * HO * WO * C + ho * WO * C + wo * C + c] = max;
+				}
+			}
+		}
+	}
+
+	return;
+}
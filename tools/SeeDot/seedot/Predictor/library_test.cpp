@@ -0,0 +1,463 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "datatypes.h"
+#include "library.h"
+#include "library_template.h"
+
+using namespace std;
+
+// Checks that MatMul and Conv of library.cpp are bit-exact with the scalar tree sums they replace, on random inputs
+// and scales, and reports the speedup. Every function of library_template.h is also checked against library.cpp on a few instantiations. Build with "make LibraryTest", and with
+// "make clean LibraryTest DEFINES=-DINT32" for 32-bit MYINT or DEFINES=-DSHIFT for shift amounts as scales.
+
+// C = A * B, as computed by library.cpp before the tree sums were vectorized
+void RefMatMul(const MYINT *A, const MYINT *B, MYINT *C, MYINT *tmp, MYINT I, MYINT K, MYINT J, MYINT shrA, MYINT shrB, MYINT H1, MYINT H2) {
+
+	for (MYINT i = 0; i < I; i++) {
+		for (MYINT j = 0; j < J; j++) {
+			for (MYINT k = 0; k < K; k++) {
+				MYINT a = A[i * K + k];
+				MYINT b = B[k * J + j];
+
+				a = SCALE_DOWN(a, shrA);
+				b = SCALE_DOWN(b, shrB);
+
+				tmp[k] = a * b;
+			}
+
+			MYINT count = K, depth = 0;
+			bool shr = true;
+
+			while (depth < (H1 + H2)) {
+				if (depth >= H1)
+					shr = false;
+
+				for (MYINT p = 0; p < (K / 2 + 1); p++) {
+					MYINT sum;
+					if (p < (count >> 1))
+						sum = tmp[2 * p] + tmp[(2 * p) + 1];
+					else if ((p == (count >> 1)) && ((count & 1) == 1))
+						sum = tmp[2 * p];
+					else
+						sum = 0;
+
+					if (shr)
+						tmp[p] = HALVE(sum);
+					else
+						tmp[p] = sum;
+				}
+				count = (count + 1) >> 1;
+
+				depth++;
+			}
+
+			C[i * J + j] = tmp[0];
+		}
+	}
+	return;
+}
+
+// C = A # B, as computed by library.cpp before the tree sums were vectorized
+// A[N][H][W][CI], B[HF][WF][CI][CO], C[N][H][W][CO]
+void RefConv(const MYINT *A, const MYINT *B, MYINT *C, MYINT *tmp, MYINT N, MYINT H, MYINT W, MYINT CI, MYINT HF, MYINT WF, MYINT CO, MYINT shrA, MYINT shrB, MYINT H1, MYINT H2) {
+	MYINT padH = (HF - 1) / 2;
+	MYINT padW = (WF - 1) / 2;
+
+	for (MYINT n = 0; n < N; n++) {
+		for (MYINT h = 0; h < H; h++) {
+			for (MYINT w = 0; w < W; w++) {
+				for (MYINT co = 0; co < CO; co++) {
+
+					MYINT counter = 0;
+					for (MYINT hf = 0; hf < HF; hf++) {
+						for (MYINT wf = 0; wf < WF; wf++) {
+							for (MYINT ci = 0; ci < CI; ci++) {
+								MYINT a = (((((h + hf) < padH) || ((h + hf) >= (H + padH))) || (((w + wf) < padW) || ((w + wf) >= (W + padW)))) ? 0 : A[n * H * W * CI + ((h + hf) - padH) * W * CI + ((w + wf) - padW) * CI + ci]);
+								a = SCALE_DOWN(a, shrA);
+
+								MYINT b = B[hf * WF * CI * CO + wf * CI * CO + ci * CO + co];
+								b = SCALE_DOWN(b, shrB);
+
+								tmp[counter] = a * b;
+								counter++;
+							}
+						}
+					}
+
+					MYINT totalEle = HF * WF * CI;
+					MYINT count = HF * WF * CI, depth = 0;
+					bool shr = true;
+
+					while (depth < (H1 + H2)) {
+						if (depth >= H1)
+							shr = false;
+
+						for (MYINT p = 0; p < (totalEle / 2 + 1); p++) {
+							MYINT sum;
+							if (p < (count >> 1))
+								sum = tmp[2 * p] + tmp[(2 * p) + 1];
+							else if ((p == (count >> 1)) && ((count & 1) == 1))
+								sum = tmp[2 * p];
+							else
+								sum = 0;
+
+							if (shr)
+								tmp[p] = HALVE(sum);
+							else
+								tmp[p] = sum;
+						}
+						count = (count + 1) >> 1;
+
+						depth++;
+					}
+
+					C[n * H * W * CO + h * W * CO + w * CO + co] = tmp[0];
+				}
+			}
+		}
+	}
+
+	return;
+}
+
+
+#ifdef INT16
+// The full range, the products and sums wrap around as in the generated code
+const int maxValue = 32767;
+#else
+// Small enough for the products and the sums not to overflow
+const int maxValue = 4095;
+#endif
+
+mt19937 generator(42);
+
+int randomInt(int lo, int hi) {
+	return uniform_int_distribution<int>(lo, hi)(generator);
+}
+
+vector<MYINT> randomMatrix(int size) {
+	vector<MYINT> X(size);
+	for (int i = 0; i < size; i++)
+		X[i] = (MYINT)randomInt(-maxValue, maxValue);
+	return X;
+}
+
+// Scales are powers of two, as generated by SeeDot, and sometimes any positive value. They are shift amounts with SHIFT
+MYINT randomScale() {
+#ifdef SHIFT
+	return (MYINT)randomInt(0, 8);
+#else
+	if (randomInt(0, 3) == 0)
+		return (MYINT)randomInt(1, 100);
+	return (MYINT)(1 << randomInt(0, 8));
+#endif
+}
+
+// Tree heights around the one of the sum, including the ones stopping the sum early
+void randomHeights(int K, MYINT &H1, MYINT &H2) {
+	int height = 0;
+	while ((1 << height) < K)
+		height++;
+	int total = max(0, height + randomInt(-2, 2));
+	H1 = (MYINT)randomInt(0, total);
+	H2 = (MYINT)(total - H1);
+}
+
+int countMismatches(const vector<MYINT> &expected, const vector<MYINT> &C) {
+	int mismatches = 0;
+	for (size_t i = 0; i < C.size(); i++)
+		mismatches += expected[i] != C[i];
+	return mismatches;
+}
+
+// Runs of a timed function, at least TIMING_MIN_RUNS and until TIMING_MIN_US have elapsed
+#define TIMING_MIN_RUNS 5
+#define TIMING_MIN_US 20000.0
+
+// Best time of f in microseconds, after a first run warming up the caches. A single cold run of the small shapes is
+// dominated by the first execution of the code, which is new for every instantiation of a template
+template<class F>
+double timeUs(F f) {
+	f();
+	double best = 0, total = 0;
+	for (int run = 0; run < TIMING_MIN_RUNS || total < TIMING_MIN_US; run++) {
+		auto start = chrono::high_resolution_clock::now();
+		f();
+		double time = chrono::duration<double, micro>(chrono::high_resolution_clock::now() - start).count();
+		if (run == 0 || time < best)
+			best = time;
+		total += time;
+	}
+	return best;
+}
+
+int checkMatMul(int I, int K, int J, bool report) {
+	vector<MYINT> A = randomMatrix(I * K), B = randomMatrix(K * J), expected(I * J), C(I * J), tmp(K);
+	MYINT shrA = randomScale(), shrB = randomScale(), H1, H2;
+	randomHeights(K, H1, H2);
+
+	RefMatMul(&A[0], &B[0], &expected[0], &tmp[0], I, K, J, shrA, shrB, H1, H2);
+
+	MatMulNN(&A[0], &B[0], &C[0], &tmp[0], I, K, J, shrA, shrB, H1, H2);
+	int mismatches = countMismatches(expected, C);
+	MatMulCC(&A[0], &B[0], &C[0], &tmp[0], I, K, J, shrA, shrB, H1, H2);
+	mismatches += countMismatches(expected, C);
+
+	if (mismatches != 0)
+		cout << "MatMul " << I << "x" << K << "x" << J << " shrA=" << shrA << " shrB=" << shrB << " H1=" << H1 << " H2=" << H2 << ": " << mismatches << " mismatches" << endl;
+	else if (report) {
+		double refTime = timeUs([&] { RefMatMul(&A[0], &B[0], &expected[0], &tmp[0], I, K, J, shrA, shrB, H1, H2); });
+		double time = timeUs([&] { MatMulNN(&A[0], &B[0], &C[0], &tmp[0], I, K, J, shrA, shrB, H1, H2); });
+		cout << "MatMul " << I << "x" << K << "x" << J << ": " << refTime << " us -> " << time << " us (" << refTime / time << "x)" << endl;
+	}
+	return mismatches;
+}
+
+int checkConv(int N, int H, int W, int CI, int HF, int WF, int CO, bool report) {
+	vector<MYINT> A = randomMatrix(N * H * W * CI), B = randomMatrix(HF * WF * CI * CO), expected(N * H * W * CO), C(N * H * W * CO), tmp(HF * WF * CI);
+	MYINT shrA = randomScale(), shrB = randomScale(), H1, H2;
+	randomHeights(HF * WF * CI, H1, H2);
+
+	RefConv(&A[0], &B[0], &expected[0], &tmp[0], N, H, W, CI, HF, WF, CO, shrA, shrB, H1, H2);
+
+	Conv(&A[0], &B[0], &C[0], &tmp[0], N, H, W, CI, HF, WF, CO, shrA, shrB, H1, H2);
+	int mismatches = countMismatches(expected, C);
+
+	if (mismatches != 0)
+		cout << "Conv " << N << "x" << H << "x" << W << "x" << CI << " # " << HF << "x" << WF << "x" << CO << " shrA=" << shrA << " shrB=" << shrB << " H1=" << H1 << " H2=" << H2 << ": " << mismatches << " mismatches" << endl;
+	else if (report) {
+		double refTime = timeUs([&] { RefConv(&A[0], &B[0], &expected[0], &tmp[0], N, H, W, CI, HF, WF, CO, shrA, shrB, H1, H2); });
+		double time = timeUs([&] { Conv(&A[0], &B[0], &C[0], &tmp[0], N, H, W, CI, HF, WF, CO, shrA, shrB, H1, H2); });
+		cout << "Conv " << N << "x" << H << "x" << W << "x" << CI << " # " << HF << "x" << WF << "x" << CO << ": " << refTime << " us -> " << time << " us (" << refTime / time << "x)" << endl;
+	}
+	return mismatches;
+}
+
+// Scale 2^n, as a shift amount with SHIFT
+#ifdef SHIFT
+#define SCALE(n) (n)
+#else
+#define SCALE(n) (1 << (n))
+#endif
+
+template<MYINT I, MYINT K, MYINT J, MYINT shrA, MYINT shrB, MYINT H1, MYINT H2>
+int checkMatMulTemplate() {
+	vector<MYINT> A = randomMatrix(I * K), B = randomMatrix(K * J), expected(I * J), C(I * J), tmp(K);
+
+	RefMatMul(&A[0], &B[0], &expected[0], &tmp[0], I, K, J, shrA, shrB, H1, H2);
+
+	MatMulNN<I, K, J, shrA, shrB, H1, H2>(&A[0], &B[0], &C[0], &tmp[0]);
+	int mismatches = countMismatches(expected, C);
+	MatMulCN<I, K, J, shrA, shrB, H1, H2>(&A[0], &B[0], &C[0], &tmp[0]);
+	mismatches += countMismatches(expected, C);
+	MatMulNC<I, K, J, shrA, shrB, H1, H2>(&A[0], &B[0], &C[0], &tmp[0]);
+	mismatches += countMismatches(expected, C);
+	MatMulCC<I, K, J, shrA, shrB, H1, H2>(&A[0], &B[0], &C[0], &tmp[0]);
+	mismatches += countMismatches(expected, C);
+	if (mismatches != 0) {
+		cout << "MatMul template " << I << "x" << K << "x" << J << ": " << mismatches << " mismatches" << endl;
+		return mismatches;
+	}
+
+	double runtimeTime = timeUs([&] { MatMulNN(&A[0], &B[0], &C[0], &tmp[0], I, K, J, shrA, shrB, H1, H2); });
+	double time = timeUs([&] { MatMulNN<I, K, J, shrA, shrB, H1, H2>(&A[0], &B[0], &C[0], &tmp[0]); });
+	cout << "MatMul template " << I << "x" << K << "x" << J << ": " << runtimeTime << " us -> " << time << " us (" << runtimeTime / time << "x)" << endl;
+	return mismatches;
+}
+
+template<MYINT N, MYINT H, MYINT W, MYINT CI, MYINT HF, MYINT WF, MYINT CO, MYINT shrA, MYINT shrB, MYINT H1, MYINT H2>
+int checkConvTemplate() {
+	vector<MYINT> A = randomMatrix(N * H * W * CI), B = randomMatrix(HF * WF * CI * CO), expected(N * H * W * CO), C(N * H * W * CO), tmp(HF * WF * CI);
+
+	RefConv(&A[0], &B[0], &expected[0], &tmp[0], N, H, W, CI, HF, WF, CO, shrA, shrB, H1, H2);
+
+	Conv<N, H, W, CI, HF, WF, CO, shrA, shrB, H1, H2>(&A[0], &B[0], &C[0], &tmp[0]);
+	int mismatches = countMismatches(expected, C);
+	if (mismatches != 0) {
+		cout << "Conv template " << N << "x" << H << "x" << W << "x" << CI << " # " << HF << "x" << WF << "x" << CO << ": " << mismatches << " mismatches" << endl;
+		return mismatches;
+	}
+
+	double runtimeTime = timeUs([&] { Conv(&A[0], &B[0], &C[0], &tmp[0], N, H, W, CI, HF, WF, CO, shrA, shrB, H1, H2); });
+	double time = timeUs([&] { Conv<N, H, W, CI, HF, WF, CO, shrA, shrB, H1, H2>(&A[0], &B[0], &C[0], &tmp[0]); });
+	cout << "Conv template " << N << "x" << H << "x" << W << "x" << CI << " # " << HF << "x" << WF << "x" << CO << ": " << runtimeTime << " us -> " << time << " us (" << runtimeTime / time << "x)" << endl;
+	return mismatches;
+}
+
+// Mismatches between the output of library.cpp and of an instantiation of library_template.h
+int checkTemplateOutput(const string &name, const vector<MYINT> &expected, const vector<MYINT> &C) {
+	int mismatches = countMismatches(expected, C);
+	if (mismatches != 0)
+		cout << name << " template: " << mismatches << " mismatches" << endl;
+	return mismatches;
+}
+
+template<MYINT I, MYINT J, MYINT shrA, MYINT shrB, MYINT shrC>
+int checkMatAddTemplate() {
+	vector<MYINT> A = randomMatrix(I * J), B = randomMatrix(I * J), expected(I * J), C(I * J);
+
+	MatAdd(&A[0], &B[0], &expected[0], I, J, shrA, shrB, shrC);
+	MatAdd<I, J, shrA, shrB, shrC>(&A[0], &B[0], &C[0]);
+	int mismatches = checkTemplateOutput("MatAdd", expected, C);
+
+	MatSub(&A[0], &B[0], &expected[0], I, J, shrA, shrB, shrC);
+	MatSub<I, J, shrA, shrB, shrC>(&A[0], &B[0], &C[0]);
+	mismatches += checkTemplateOutput("MatSub", expected, C);
+	return mismatches;
+}
+
+// A[I][K] in the sparse format of SeeDot: for each column, the 1-based row indices of its non-zero
+// values followed by a 0 in Aidx, and the values in Aval. B[K][1] is read through row pointers
+template<MYINT I, MYINT K, MYINT shrA, MYINT shrB, MYINT shrC>
+int checkSparseMatMulTemplate() {
+	vector<MYINT> Aidx, Aval, B = randomMatrix(K), expected = randomMatrix(I), C = expected;
+	for (MYINT k = 0; k < K; k++) {
+		for (MYINT i = 0; i < I; i++) {
+			if (randomInt(0, 3) == 0) {
+				Aidx.push_back(i + 1);
+				Aval.push_back((MYINT)randomInt(-maxValue, maxValue));
+			}
+		}
+		Aidx.push_back(0);
+	}
+	Aval.push_back(0);
+	vector<MYINT *> rows(K);
+	for (MYINT k = 0; k < K; k++)
+		rows[k] = &B[k];
+
+	SparseMatMul(&Aidx[0], &Aval[0], &rows[0], &expected[0], K, shrA, shrB, shrC);
+	SparseMatMul<K, shrA, shrB, shrC>(&Aidx[0], &Aval[0], &rows[0], &C[0]);
+	return checkTemplateOutput("SparseMatMul", expected, C);
+}
+
+template<MYINT I, MYINT J, MYINT shrA, MYINT shrB>
+int checkMulTemplate() {
+	vector<MYINT> A = randomMatrix(I * J), B = randomMatrix(I * J), expected(I * J), C(I * J);
+
+	MulCir(&A[0], &B[0], &expected[0], I, J, shrA, shrB);
+	MulCir<I, J, shrA, shrB>(&A[0], &B[0], &C[0]);
+	int mismatches = checkTemplateOutput("MulCir", expected, C);
+
+	ScalarMul(&A[0], &B[0], &expected[0], I, J, shrA, shrB);
+	ScalarMul<I, J, shrA, shrB>(&A[0], &B[0], &C[0]);
+	mismatches += checkTemplateOutput("ScalarMul", expected, C);
+	return mismatches;
+}
+
+// The functions which only move or clamp the values of A[I][J]
+template<MYINT I, MYINT J, MYINT tanh_limit>
+int checkUnaryTemplates() {
+	vector<MYINT> A = randomMatrix(I * J), expected = A, C = A;
+
+	TanH(&expected[0], I, J, tanh_limit);
+	TanH<I, J, tanh_limit>(&C[0]);
+	int mismatches = checkTemplateOutput("TanH", expected, C);
+
+	expected = A;
+	C = A;
+	Relu2D(&expected[0], I, J);
+	Relu2D<I, J>(&C[0]);
+	mismatches += checkTemplateOutput("Relu2D", expected, C);
+
+	Transpose(&A[0], &expected[0], J, I);
+	Transpose<J, I>(&A[0], &C[0]);
+	mismatches += checkTemplateOutput("Transpose", expected, C);
+
+	vector<MYINT> index(1), expectedIndex(1);
+	ArgMax(&A[0], I, J, &expectedIndex[0]);
+	ArgMax<I, J>(&A[0], &index[0]);
+	mismatches += checkTemplateOutput("ArgMax", expectedIndex, index);
+	return mismatches;
+}
+
+// The functions on A[N][H][W][C]
+template<MYINT N, MYINT H, MYINT W, MYINT C, MYINT shrA, MYINT shrB, MYINT shrC, MYINT stride>
+int check4DTemplates() {
+	vector<MYINT> A = randomMatrix(N * H * W * C), B = randomMatrix(C), expected = A, out = A;
+
+	AddOrSubCir4D(&expected[0], &B[0], N, H, W, C, shrA, shrB, shrC, true);
+	AddOrSubCir4D<N, H, W, C, shrA, shrB, shrC, true>(&out[0], &B[0]);
+	int mismatches = checkTemplateOutput("AddOrSubCir4D", expected, out);
+
+	expected = A;
+	out = A;
+	AddOrSubCir4D(&expected[0], &B[0], N, H, W, C, shrA, shrB, shrC, false);
+	AddOrSubCir4D<N, H, W, C, shrA, shrB, shrC, false>(&out[0], &B[0]);
+	mismatches += checkTemplateOutput("AddOrSubCir4D", expected, out);
+
+	// A[N * H * W][C] with B[C] as the rows
+	expected = A;
+	out = A;
+	AddOrSubCir2D(&expected[0], &B[0], N * H * W, C, shrA, shrB, shrC, true);
+	AddOrSubCir2D<N * H * W, C, shrA, shrB, shrC, true>(&out[0], &B[0]);
+	mismatches += checkTemplateOutput("AddOrSubCir2D", expected, out);
+
+	expected = A;
+	out = A;
+	AddOrSubCir2D(&expected[0], &B[0], N * H * W, C, shrA, shrB, shrC, false);
+	AddOrSubCir2D<N * H * W, C, shrA, shrB, shrC, false>(&out[0], &B[0]);
+	mismatches += checkTemplateOutput("AddOrSubCir2D", expected, out);
+
+	expected = A;
+	out = A;
+	Relu4D(&expected[0], N, H, W, C);
+	Relu4D<N, H, W, C>(&out[0]);
+	mismatches += checkTemplateOutput("Relu4D", expected, out);
+
+	vector<MYINT> pooled(N * (H / stride) * (W / stride) * C), expectedPooled(pooled.size());
+	Maxpool(&A[0], &expectedPooled[0], N, H, W, C, stride);
+	Maxpool<N, H, W, C, stride>(&A[0], &pooled[0]);
+	mismatches += checkTemplateOutput("Maxpool", expectedPooled, pooled);
+	return mismatches;
+}
+
+int main() {
+	int mismatches = 0;
+
+	for (int t = 0; t < 2000; t++)
+		mismatches += checkMatMul(randomInt(1, 8), randomInt(1, 70), randomInt(1, 40), false);
+	for (int t = 0; t < 300; t++)
+		mismatches += checkConv(randomInt(1, 2), randomInt(1, 8), randomInt(1, 8), randomInt(1, 6), randomInt(1, 5), randomInt(1, 5), randomInt(1, 20), false);
+
+	// Shapes of the Bonsai and ProtoNN models, and of a small CNN
+	mismatches += checkMatMul(1, 64, 256, true);
+	mismatches += checkMatMul(10, 256, 1, true);
+	mismatches += checkMatMul(60, 400, 20, true);
+	mismatches += checkMatMul(64, 512, 64, true);
+	mismatches += checkConv(1, 28, 28, 1, 5, 5, 32, true);
+	mismatches += checkConv(1, 14, 14, 32, 3, 3, 64, true);
+
+	// Against the runtime library
+	mismatches += checkMatMulTemplate<1, 64, 256, SCALE(4), SCALE(6), 6, 0>();
+	mismatches += checkMatMulTemplate<10, 256, 1, SCALE(3), SCALE(5), 5, 3>();
+	mismatches += checkMatMulTemplate<60, 400, 20, SCALE(7), SCALE(2), 9, 0>();
+	mismatches += checkMatMulTemplate<7, 33, 5, SCALE(0), SCALE(8), 2, 2>();
+	mismatches += checkConvTemplate<1, 28, 28, 1, 5, 5, 32, SCALE(5), SCALE(4), 3, 2>();
+	mismatches += checkConvTemplate<1, 14, 14, 32, 3, 3, 64, SCALE(6), SCALE(3), 6, 3>();
+	mismatches += checkConvTemplate<2, 5, 6, 3, 2, 4, 7, SCALE(1), SCALE(0), 1, 3>();
+	mismatches += checkMatAddTemplate<10, 1, SCALE(1), SCALE(2), SCALE(0)>();
+	mismatches += checkMatAddTemplate<7, 13, SCALE(3), SCALE(0), SCALE(1)>();
+	mismatches += checkSparseMatMulTemplate<10, 256, SCALE(4), SCALE(3), SCALE(2)>();
+	mismatches += checkSparseMatMulTemplate<7, 33, SCALE(0), SCALE(5), SCALE(1)>();
+	mismatches += checkMulTemplate<10, 1, SCALE(2), SCALE(3)>();
+	mismatches += checkMulTemplate<6, 11, SCALE(6), SCALE(0)>();
+	mismatches += checkUnaryTemplates<10, 1, 2048>();
+	mismatches += checkUnaryTemplates<9, 14, 1000>();
+	mismatches += check4DTemplates<1, 28, 28, 32, SCALE(1), SCALE(2), SCALE(0), 2>();
+	mismatches += check4DTemplates<2, 7, 9, 5, SCALE(0), SCALE(3), SCALE(1), 3>();
+
+	if (mismatches != 0) {
+		cout << mismatches << " mismatches" << endl;
+		return 1;
+	}
+	cout << "All outputs are bit-exact" << endl;
+	return 0;
+}
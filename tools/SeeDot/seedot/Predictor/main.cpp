@@ -3,9 +3,13 @@
 
 #include <iostream>
 #include <fstream>
-#include <sstream>
+#include <iterator>
+#include <algorithm>
 #include <vector>
+#include <thread>
+#include <chrono>
 #include <cstring>
+#include <cstdlib>
 
 #include "datatypes.h"
 #include "predictors.h"
@@ -17,45 +21,118 @@ enum Algo { Bonsai, Protonn };
 enum Version { Fixed, Float };
 enum DatasetType { Training, Testing };
 
-// Split the CSV row into multiple values
-vector<string> readCSVLine(string line) {
-	vector<string> tokens;
+// Read the whole file into memory
+string readFile(string path) {
+	ifstream file(path, ios::in | ios::binary);
 
-	stringstream stream(line);
-	string str;
+	if (file.good() == false)
+		throw "Input files doesn't exist";
 
-	while (getline(stream, str, ','))
-		tokens.push_back(str);
+	return string(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+}
 
-	return tokens;
+// Skip the rest of a CSV value, as atol and atof ignore trailing characters
+inline void skipValue(const char *&p) {
+	while (*p != ',' && *p != '\n' && *p != '\r' && *p != '\0')
+		p++;
 }
 
-vector<string> getFeatures(string line) {
-	static int featuresLength = -1;
+inline long long parseInteger(const char *&p) {
+	while (*p == ' ' || *p == '\t')
+		p++;
 
-	vector<string> features = readCSVLine(line);
+	bool negative = (*p == '-');
+	if (*p == '-' || *p == '+')
+		p++;
 
-	if (featuresLength == -1)
-		featuresLength = (int)features.size();
+	long long value = 0;
+	while (*p >= '0' && *p <= '9') {
+		value = value * 10 + (*p - '0');
+		p++;
+	}
 
-	if ((int)features.size() != featuresLength)
-		throw "Number of row entries in X is inconsistent";
+	skipValue(p);
+	return negative ? -value : value;
+}
 
-	return features;
+MYINT parseFixed(const char *&p) {
+	return (MYINT)parseInteger(p);
 }
 
-int getLabel(string line) {
-	static int labelLength = -1;
+float parseFloat(const char *&p) {
+	char *next;
+	float value = strtof(p, &next);
+	p = next;
+	skipValue(p);
+	return value;
+}
 
-	vector<string> labels = readCSVLine(line);
+int parseLabel(const char *&p) {
+	return (int)parseInteger(p);
+}
 
-	if (labelLength == -1)
-		labelLength = (int)labels.size();
+// Parse the CSV text into a contiguous row-major matrix and return the number of rows
+template<class T>
+int parseCSV(const string &text, vector<T> &matrix, int &cols, T (*parse)(const char *&)) {
+	const char *p = text.c_str();
+	int rows = 0;
+	cols = -1;
+
+	while (*p != '\0') {
+		// Skip empty lines
+		if (*p == '\n' || *p == '\r') {
+			p++;
+			continue;
+		}
 
-	if ((int)labels.size() != labelLength || labels.size() != 1)
-		throw "Number of row entries in Y is inconsistent";
+		int n = 1;
+		matrix.push_back(parse(p));
+		while (*p == ',') {
+			p++;
+			matrix.push_back(parse(p));
+			n++;
+		}
+
+		if (cols == -1)
+			cols = n;
+		else if (n != cols)
+			return -1;
+
+		rows++;
+	}
+
+	return rows;
+}
+
+// Invoke the predictor on the rows [begin, end) of the features. The predictors keep their
+// temporaries on the stack, so the rows are evaluated concurrently by several threads.
+// elapsed is set to the time spent in the predictor, in microseconds
+void predictRows(Algo algo, Version version, vector<MYINT> &features_int, vector<float> &features_float, int features_size, int begin, int end, vector<int> &res, double &elapsed) {
+	// The fixed-point predictor reads feature i at X[i][0]
+	vector<MYINT *> X(features_size);
+
+	auto start = chrono::steady_clock::now();
+
+	for (int row = begin; row < end; row++) {
+		if (version == Fixed)
+			for (int i = 0; i < features_size; i++)
+				X[i] = &features_int[(size_t)row * features_size + i];
+
+		float *X_float = version == Float ? &features_float[(size_t)row * features_size] : NULL;
+
+		if (algo == Bonsai && version == Fixed)
+			res[row] = seedotFixed(X.data());
+		else if (algo == Bonsai && version == Float)
+			res[row] = bonsaiFloat(X_float);
+		else if (algo == Protonn && version == Fixed)
+			res[row] = seedotFixed(X.data());
+		else if (algo == Protonn && version == Float)
+			res[row] = protonnFloat(X_float);
+	}
+
+	elapsed = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
 
-	return (int)atoi(labels.front().c_str());
+	mergeRange();
 }
 
 int main(int argc, char *argv[]) {
@@ -98,14 +175,18 @@ int main(int argc, char *argv[]) {
 	}
 	string datasetTypeStr = argv[3];
 
+	// Number of threads evaluating the rows, all the hardware threads by default
+	int numThreads = (int)thread::hardware_concurrency();
+	if (argc > 4)
+		numThreads = atoi(argv[4]);
+	if (numThreads < 1)
+		numThreads = 1;
+
 	// Reading the dataset
 	string inputDir = "input/";
 
-	ifstream featuresFile(inputDir + "X.csv");
-	ifstream lablesFile(inputDir + "Y.csv");
-
-	if (featuresFile.good() == false || lablesFile.good() == false)
-		throw "Input files doesn't exist";
+	string featuresText = readFile(inputDir + "X.csv");
+	string labelsText = readFile(inputDir + "Y.csv");
 
 	// Create output directory and files
 	string outputDir = "output/" + algoStr + "-" + versionStr;
@@ -116,88 +197,66 @@ int main(int argc, char *argv[]) {
 	ofstream output(outputFile);
 	ofstream stats(statsFile);
 
-	int correct = 0, total = 0;
+	// Parse the CSVs once into contiguous matrices
+	int features_size = -1, labels_size = -1;
+	vector<MYINT> features_int;
+	vector<float> features_float;
+	vector<int> labels;
 
-	bool alloc = false;
-	int features_size = -1;
-	MYINT **features_int = NULL;
-	float *features_float = NULL;
+	int featuresRows;
+	if (version == Fixed)
+		featuresRows = parseCSV(featuresText, features_int, features_size, parseFixed);
+	else
+		featuresRows = parseCSV(featuresText, features_float, features_size, parseFloat);
+	if (featuresRows < 0)
+		throw "Number of row entries in X is inconsistent";
 
-	// Initialize variables used for profiling
-	initializeProfiling();
+	int labelsRows = parseCSV(labelsText, labels, labels_size, parseLabel);
+	if (labelsRows < 0 || (labelsRows > 0 && labels_size != 1))
+		throw "Number of row entries in Y is inconsistent";
 
-	string line1, line2;
-	while (getline(featuresFile, line1) && getline(lablesFile, line2)) {
-		// Read the feature vector and class ID
-		vector<string> features = getFeatures(line1);
-		int label = getLabel(line2);
-
-		// Allocate memory to store the feature vector as arrays
-		if (alloc == false) {
-			features_size = (int)features.size();
-
-			if (version == Fixed) {
-				features_int = new MYINT*[features_size];
-				for (int i = 0; i < features_size; i++)
-					features_int[i] = new MYINT[1];
-			}
-			else
-				features_float = new float[features_size];
-
-			alloc = true;
-		}
+	int total = min(featuresRows, labelsRows);
 
-		// Populate the array using the feature vector
-		if (version == Fixed)
-			for (int i = 0; i < features_size; i++) {
-#ifdef INT16
-				features_int[i][0] = (MYINT)(atol(features.at(i).c_str()));
-#endif
-#ifdef INT32
-				features_int[i][0] = (MYINT)(atoll(features.at(i).c_str()));
-#endif
-			}
-		else
-			for (int i = 0; i < features_size; i++)
-				features_float[i] = (float)(atof(features.at(i).c_str()));
+	// Initialize variables used for profiling
+	initializeProfiling();
 
-		// Invoke the predictor function
-		int res = -1;
-		if (algo == Bonsai && version == Fixed)
-			res = seedotFixed(features_int);
-		else if (algo == Bonsai && version == Float)
-			res = bonsaiFloat(features_float);
-		else if (algo == Protonn && version == Fixed)
-			res = seedotFixed(features_int);
-		else if (algo == Protonn && version == Float)
-			res = protonnFloat(features_float);
+	// Invoke the predictor on contiguous blocks of rows
+	vector<int> res(total, -1);
+	vector<thread> threads;
+	numThreads = min(numThreads, total);
+	vector<double> elapsed(numThreads, 0);
+	for (int t = 0; t < numThreads; t++) {
+		int begin = (int)((long long)total * t / numThreads);
+		int end = (int)((long long)total * (t + 1) / numThreads);
+		threads.push_back(thread(predictRows, algo, version, ref(features_int), ref(features_float), features_size, begin, end, ref(res), ref(elapsed[t])));
+	}
+	for (auto &t : threads)
+		t.join();
 
-		if ((res) == label) {
+	int correct = 0;
+	for (int i = 0; i < total; i++) {
+		if (res[i] == labels[i]) {
 			correct++;
 		}
 		else {
-			output << "Incorrect prediction for input " << total + 1 << ". Predicted " << res + 1 << " Expected " << label << endl;
+			output << "Incorrect prediction for input " << i + 1 << ". Predicted " << res[i] + 1 << " Expected " << labels[i] << endl;
 		}
-
-		total++;
-	}
-
-	// Deallocate memory
-	if (version == Fixed) {
-		for (int i = 0; i < features_size; i++)
-			delete features_int[i];
-		delete features_int;
 	}
-	else
-		delete features_float;
 
 	float accuracy = (float)correct / total * 100.0f;
 
+	// Average latency of a prediction, which does not depend on the number of threads
+	double timePerPrediction = 0;
+	for (double e : elapsed)
+		timePerPrediction += e;
+	timePerPrediction /= max(total, 1);
+
 	cout.precision(3);
 	cout << fixed;
 	cout << "\n\n#test points = " << total << endl;
 	cout << "Correct predictions = " << correct << endl;
-	cout << "Accuracy = " << accuracy << "\n\n";
+	cout << "Accuracy = " << accuracy << endl;
+	cout << "Time per prediction = " << timePerPrediction << " us\n\n";
 
 	output.precision(3);
 	output << fixed;
@@ -209,10 +268,14 @@ int main(int argc, char *argv[]) {
 	stats.precision(3);
 	stats << fixed;
 	stats << accuracy << "\n";
+	stats << timePerPrediction << "\n";
 	stats.close();
 
 	if (datasetType == Training)
 		dumpRange(outputDir + "/profile.txt");
 
+	if (version == Fixed)
+		dumpVarRanges(outputDir + "/var-ranges-" + datasetTypeStr + ".txt");
+
 	return 0;
 }
@@ -4,20 +4,49 @@
 #include <iostream>
 #include <fstream>
 #include <limits>
+#include <algorithm>
+#include <mutex>
+#include <vector>
 
 #include "profile.h"
 
 using namespace std;
 
-float m_all, M_all;
-float m_exp, M_exp;
+// Ranges seen by each thread, merged into the ranges of the whole run by mergeRange()
+thread_local float m_all = numeric_limits<float>::max(), M_all = -numeric_limits<float>::max();
+thread_local float m_exp = numeric_limits<float>::max(), M_exp = -numeric_limits<float>::max();
+
+float m_all_run, M_all_run;
+float m_exp_run, M_exp_run;
+mutex rangeMutex;
+
+// Bins of the histograms, indexed by the number of significant bits of the magnitude of a value
+const int histogramBins = 8 * sizeof(MYINT);
+
+struct VarRange {
+	MYINT min, max;
+#ifdef PROFILE_HISTOGRAM
+	long long count[histogramBins];
+#endif
+
+	VarRange() : min(numeric_limits<MYINT>::max()), max(numeric_limits<MYINT>::min()) {
+#ifdef PROFILE_HISTOGRAM
+		fill(count, count + histogramBins, 0);
+#endif
+	}
+};
+
+thread_local vector<VarRange> varRanges;
+vector<VarRange> varRanges_run;
 
 void initializeProfiling() {
-	m_all = numeric_limits<float>::max();
-	M_all = -numeric_limits<float>::max();
+	m_all_run = m_all = numeric_limits<float>::max();
+	M_all_run = M_all = -numeric_limits<float>::max();
+
+	m_exp_run = m_exp = numeric_limits<float>::max();
+	M_exp_run = M_exp = -numeric_limits<float>::max();
 
-	m_exp = numeric_limits<float>::max();
-	M_exp = -numeric_limits<float>::max();
+	varRanges_run.clear();
 
 	return;
 }
@@ -38,13 +67,93 @@ void updateRangeOfExp(float x) {
 	return;
 }
 
+// The slots are allocated on their first update, the compiler numbering them from 0
+inline VarRange &getVarRange(int id) {
+	if (id >= (int)varRanges.size())
+		varRanges.resize(id + 1);
+	return varRanges[id];
+}
+
+inline void updateVarRange(VarRange &range, MYINT x) {
+	if (x < range.min)
+		range.min = x;
+	if (x > range.max)
+		range.max = x;
+
+#ifdef PROFILE_HISTOGRAM
+	// The magnitude of x is ~x for negative values, so that x fits in bits + 1 signed bits
+	int32_t m = x < 0 ? ~(int32_t)x : (int32_t)x;
+	int bits = 0;
+	while (m != 0) {
+		bits++;
+		m >>= 1;
+	}
+	range.count[bits]++;
+#endif
+	return;
+}
+
+void updateVarRange(int id, const MYINT *A, int size) {
+	VarRange &range = getVarRange(id);
+	for (int i = 0; i < size; i++)
+		updateVarRange(range, A[i]);
+	return;
+}
+
+void updateVarRange(int id, MYINT x) {
+	updateVarRange(getVarRange(id), x);
+	return;
+}
+
+void mergeRange() {
+	lock_guard<mutex> lock(rangeMutex);
+
+	m_all_run = min(m_all_run, m_all);
+	M_all_run = max(M_all_run, M_all);
+
+	m_exp_run = min(m_exp_run, m_exp);
+	M_exp_run = max(M_exp_run, M_exp);
+
+	if (varRanges_run.size() < varRanges.size())
+		varRanges_run.resize(varRanges.size());
+	for (size_t i = 0; i < varRanges.size(); i++) {
+		varRanges_run[i].min = min(varRanges_run[i].min, varRanges[i].min);
+		varRanges_run[i].max = max(varRanges_run[i].max, varRanges[i].max);
+#ifdef PROFILE_HISTOGRAM
+		for (int b = 0; b < histogramBins; b++)
+			varRanges_run[i].count[b] += varRanges[i].count[b];
+#endif
+	}
+	varRanges.clear();
+
+	return;
+}
+
 void dumpRange(string outputFile) {
 	ofstream fout(outputFile);
 
 	fout.precision(6);
 	fout << fixed;
-	fout << m_all << ", " << M_all << endl;
-	fout << m_exp << ", " << M_exp << endl;
+	fout << m_all_run << ", " << M_all_run << endl;
+	fout << m_exp_run << ", " << M_exp_run << endl;
+
+	return;
+}
+
+void dumpVarRanges(string outputFile) {
+	if (varRanges_run.empty())
+		return;
+
+	ofstream fout(outputFile);
+
+	for (size_t i = 0; i < varRanges_run.size(); i++) {
+		fout << i << ", " << varRanges_run[i].min << ", " << varRanges_run[i].max;
+#ifdef PROFILE_HISTOGRAM
+		for (int b = 0; b < histogramBins; b++)
+			fout << ", " << varRanges_run[i].count[b];
+#endif
+		fout << endl;
+	}
 
 	return;
 }
@@ -3,11 +3,27 @@
 
 #pragma once
 
+#include <cstdint>
 #include <string>
 
+#include "datatypes.h"
+
 void initializeProfiling();
 
 void updateRange(float x);
 void updateRangeOfExp(float x);
 
+// Folds the ranges seen by the calling thread into the ranges dumped by dumpRange()
+void mergeRange();
+
 void dumpRange(std::string outputFile);
+
+// Ranges of the variables of the fixed-point code generated with --profile-ranges, in the slots numbered by the
+// compiler. Only integer comparisons are done. With PROFILE_HISTOGRAM, the values are also counted by their number
+// of significant bits
+void updateVarRange(int id, const MYINT *A, int size);
+void updateVarRange(int id, MYINT x);
+
+// Writes one line per slot: its id, minimum and maximum, followed by the histogram with PROFILE_HISTOGRAM.
+// Nothing is written if no variable was profiled
+void dumpVarRanges(std::string outputFile);
@@ -0,0 +1,114 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#pragma once
+
+// The tree sums of MatMul and Conv are computed for TREESUM_LANES outputs at once, whose products are pushed in
+// lockstep into running tree sums. Every addition and halving of a level then runs on TREESUM_LANES contiguous values,
+// which the compiler vectorizes, and a running tree sum only keeps one pending node per level instead of the products.
+// The results are the same as summing the products in tmp level by level: a node of a level is the sum of its two
+// children, halved for the first H1 levels, a missing child counts as 0 and the sum stops after H1 + H2 levels.
+#define TREESUM_LANES 16
+#define TREESUM_LEVELS (8 * sizeof(MYINT) + 1)
+
+// SCALE_DOWN by a scale. Without SHIFT, the division toward zero is done with a shift when the scale is a power of two
+struct Scale {
+	MYINT div;
+	MYINT shift;
+	bool pow2;
+};
+
+static inline Scale makeScale(MYINT shr) {
+#ifdef SHIFT
+	Scale s = { 0, shr, true };
+#else
+	Scale s = { shr, 0, shr > 0 && (shr & (shr - 1)) == 0 };
+	while (s.pow2 && (1 << s.shift) < shr)
+		s.shift++;
+#endif
+	return s;
+}
+
+// y = SCALE_DOWN(x, s)
+static inline void scaleLanes(const MYINT *x, MYINT *y, MYINT lanes, const Scale &s) {
+#ifdef SHIFT
+	for (MYINT l = 0; l < lanes; l++)
+		y[l] = x[l] >> s.shift;
+#else
+	if (s.pow2) {
+		MYINT mask = s.div - 1;
+		for (MYINT l = 0; l < lanes; l++)
+			y[l] = (x[l] + ((x[l] >> (8 * sizeof(MYINT) - 1)) & mask)) >> s.shift;
+	}
+	else {
+		for (MYINT l = 0; l < lanes; l++)
+			y[l] = x[l] / s.div;
+	}
+#endif
+}
+
+// node = HALVE(left + node) or left + node
+static inline void treeSumNode(const MYINT *left, MYINT *node, MYINT lanes, bool shr) {
+	if (shr) {
+		for (MYINT l = 0; l < lanes; l++) {
+			MYINT sum = left[l] + node[l];
+			node[l] = HALVE(sum);
+		}
+	}
+	else {
+		for (MYINT l = 0; l < lanes; l++)
+			node[l] = left[l] + node[l];
+	}
+}
+
+// Only the first 2^(H1 + H2) products reach the root of the tree
+static inline MYINT treeSumCount(MYINT K, MYINT H1, MYINT H2) {
+	MYINT depth = H1 + H2;
+	if (depth < (MYINT)(8 * sizeof(MYINT) - 1) && ((MYINT)1 << depth) < K)
+		return (MYINT)1 << depth;
+	return K;
+}
+
+// Pushes the products of index k. Each trailing 1 bit of k completes a pair of nodes, carried to the next level
+static inline void treeSumPush(MYINT pending[][TREESUM_LANES], MYINT *node, MYINT k, MYINT lanes, MYINT H1) {
+	MYINT level = 0;
+	for (; (k & 1) == 1; k >>= 1, level++)
+		treeSumNode(pending[level], node, lanes, level < H1);
+
+	for (MYINT l = 0; l < lanes; l++)
+		pending[level][l] = node[l];
+}
+
+// Writes the tree sums of the count products pushed so far to C[0..lanes)
+static inline void treeSumResult(MYINT pending[][TREESUM_LANES], MYINT *node, MYINT count, MYINT lanes, MYINT H1, MYINT H2, MYINT *C) {
+	MYINT levels = 0;
+	while (((count - 1) >> levels) > 0)
+		levels++;
+
+	if (count == ((MYINT)1 << levels)) {
+		for (MYINT l = 0; l < lanes; l++)
+			node[l] = pending[levels][l];
+	}
+	else {
+		// The last node of each level has no right sibling. It is paired with the pending node when there is one
+		for (MYINT l = 0; l < lanes; l++)
+			node[l] = 0;
+		for (MYINT level = 0; level < levels; level++) {
+			if (((count >> level) & 1) == 1)
+				treeSumNode(pending[level], node, lanes, level < H1);
+			else if (level < H1) {
+				for (MYINT l = 0; l < lanes; l++)
+					node[l] = HALVE(node[l]);
+			}
+		}
+	}
+
+	// The root is halved by the remaining levels
+	for (MYINT level = levels; level < H1; level++) {
+		for (MYINT l = 0; l < lanes; l++)
+			node[l] = HALVE(node[l]);
+	}
+
+	for (MYINT l = 0; l < lanes; l++)
+		C[l] = node[l];
+}
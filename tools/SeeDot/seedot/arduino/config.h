@@ -34,3 +34,17 @@ typedef int32_t MYINT;
 #endif
 
 typedef uint16_t MYUINT;
+
+
+// The scaling mode of the library is selected below. SHIFT is defined by predict.cpp when SeeDot generates the code
+// with --shift: the scales are then shift amounts and scaling down rounds toward -infinity.
+// Otherwise the scales are powers of two and scaling down is a division, rounding toward zero.
+
+
+#ifdef SHIFT
+#define SCALE_DOWN(x, shr) ((x) >> (shr))
+#define HALVE(x) ((x) >> 1)
+#else
+#define SCALE_DOWN(x, shr) ((x) / (shr))
+#define HALVE(x) ((x) / 2)
+#endif
@@ -18,11 +18,11 @@ inline __attribute__((always_inline)) void MatAdd(MYINT *A, MYINT *B, MYINT *C,
 			MYINT a = A[i * J + j];
 			MYINT b = B[i * J + j];
 
-			a = a / shrA;
-			b = b / shrB;
+			a = SCALE_DOWN(a, shrA);
+			b = SCALE_DOWN(b, shrB);
 
 			MYINT c = a + b;
-			c = c / shrC;
+			c = SCALE_DOWN(c, shrC);
 
 			C[i * J + j] = c;
 		}
@@ -37,11 +37,11 @@ inline __attribute__((always_inline)) void MatSub(MYINT *A, const MYINT *B, MYIN
 			MYINT a = A[i * J + j];
 			MYINT b = ((MYINT) pgm_read_word_near(&B[i * J + j]));
 
-			a = a / shrA;
-			b = b / shrB;
+			a = SCALE_DOWN(a, shrA);
+			b = SCALE_DOWN(b, shrB);
 
 			MYINT c = a - b;
-			c = c / shrC;
+			c = SCALE_DOWN(c, shrC);
 
 			C[i * J + j] = c;
 		}
@@ -58,8 +58,8 @@ inline __attribute__((always_inline)) void MatMulNN(MYINT *A, MYINT *B, MYINT *C
 				MYINT a = A[i * K + k];
 				MYINT b = B[k * J + j];
 
-				a = a / shrA;
-				b = b / shrB;
+				a = SCALE_DOWN(a, shrA);
+				b = SCALE_DOWN(b, shrB);
 
 				tmp[k] = a * b;
 			}
@@ -81,7 +81,7 @@ inline __attribute__((always_inline)) void MatMulNN(MYINT *A, MYINT *B, MYINT *C
 						sum = 0;
 
 					if (shr)
-						tmp[p] = sum / 2;
+						tmp[p] = HALVE(sum);
 					else
 						tmp[p] = sum;
 				}
@@ -105,8 +105,8 @@ inline __attribute__((always_inline)) void MatMulCN(const MYINT *A, MYINT *B, MY
 				MYINT a = ((MYINT) pgm_read_word_near(&A[i * K + k]));
 				MYINT b = B[k * J + j];
 
-				a = a / shrA;
-				b = b / shrB;
+				a = SCALE_DOWN(a, shrA);
+				b = SCALE_DOWN(b, shrB);
 
 				tmp[k] = a * b;
 			}
@@ -128,7 +128,7 @@ inline __attribute__((always_inline)) void MatMulCN(const MYINT *A, MYINT *B, MY
 						sum = 0;
 
 					if (shr)
-						tmp[p] = sum / 2;
+						tmp[p] = HALVE(sum);
 					else
 						tmp[p] = sum;
 				}
@@ -152,8 +152,8 @@ inline __attribute__((always_inline)) void MatMulNC(MYINT *A, const MYINT *B, MY
 				MYINT a = A[i * K + k];
 				MYINT b = ((MYINT) pgm_read_word_near(&B[k * J + j]));
 
-				a = a / shrA;
-				b = b / shrB;
+				a = SCALE_DOWN(a, shrA);
+				b = SCALE_DOWN(b, shrB);
 
 				tmp[k] = a * b;
 			}
@@ -175,7 +175,7 @@ inline __attribute__((always_inline)) void MatMulNC(MYINT *A, const MYINT *B, MY
 						sum = 0;
 
 					if (shr)
-						tmp[p] = sum / 2;
+						tmp[p] = HALVE(sum);
 					else
 						tmp[p] = sum;
 				}
@@ -199,8 +199,8 @@ inline __attribute__((always_inline)) void MatMulCC(const MYINT *A, const MYINT
 				MYINT a = ((MYINT) pgm_read_word_near(&A[i * K + k]));
 				MYINT b = ((MYINT) pgm_read_word_near(&B[k * J + j]));
 
-				a = a / shrA;
-				b = b / shrB;
+				a = SCALE_DOWN(a, shrA);
+				b = SCALE_DOWN(b, shrB);
 
 				tmp[k] = a * b;
 			}
@@ -222,7 +222,7 @@ inline __attribute__((always_inline)) void MatMulCC(const MYINT *A, const MYINT
 						sum = 0;
 
 					if (shr)
-						tmp[p] = sum / 2;
+						tmp[p] = HALVE(sum);
 					else
 						tmp[p] = sum;
 				}
@@ -244,15 +244,15 @@ inline __attribute__((always_inline)) void SparseMatMul(const MYINT *Aidx, const
 	for (MYINT k = 0; k < K; k++) {
 		MYINT b = getIntFeature(k);
 		//MYINT b = B[k * 1][0];
-		b = b / shrB;
+		b = SCALE_DOWN(b, shrB);
 
 		MYINT idx = ((MYINT) pgm_read_word_near(&Aidx[ite_idx]));
 		while (idx != 0) {
 			MYINT a = ((MYINT) pgm_read_word_near(&Aval[ite_val]));
-			a = a / shrA;
+			a = SCALE_DOWN(a, shrA);
 
 			MYINT c = a * b;
-			c = c / shrC;
+			c = SCALE_DOWN(c, shrC);
 
 			C[idx - 1] += c;
 
@@ -274,8 +274,8 @@ inline __attribute__((always_inline)) void MulCir(MYINT *A, MYINT *B, MYINT *C,
 			MYINT a = A[i * J + j];
 			MYINT b = B[i * J + j];
 
-			a = a / shrA;
-			b = b / shrB;
+			a = SCALE_DOWN(a, shrA);
+			b = SCALE_DOWN(b, shrB);
 
 			C[i * J + j] = a * b;
 		}
@@ -339,12 +339,12 @@ inline __attribute__((always_inline)) void Transpose(MYINT *A, MYINT *B, MYINT I
 inline __attribute__((always_inline)) void ScalarMul(MYINT *A, MYINT *B, MYINT *C, MYINT I, MYINT J, MYINT shrA, MYINT shrB) {
 
 	MYINT a = *A;
-	a = a / shrA;
+	a = SCALE_DOWN(a, shrA);
 
 	for (MYINT i = 0; i < I; i++) {
 		for (MYINT j = 0; j < J; j++) {
 			MYINT b = B[i * J + j];
-			b = b / shrB;
+			b = SCALE_DOWN(b, shrB);
 
 			C[i * J + j] = a * b;
 		}
@@ -369,10 +369,10 @@ inline __attribute__((always_inline)) void Conv(MYINT *A, const MYINT *B, MYINT
 						for (MYINT wf = 0; wf < WF; wf++) {
 							for (MYINT ci = 0; ci < CI; ci++) {
 								MYINT a = (((((h + hf) < padH) || ((h + hf) >= (H + padH))) || (((w + wf) < padW) || ((w + wf) >= (W + padW)))) ? 0 : A[n * H * W * CI + ((h + hf) - padH) * W * CI + ((w + wf) - padW) * CI + ci]);
-								a = a / shrA;
+								a = SCALE_DOWN(a, shrA);
 
 								MYINT b = ((MYINT) pgm_read_word_near(&B[hf * WF * CI * CO + wf * CI * CO + ci * CO + co]));
-								b = b / shrB;
+								b = SCALE_DOWN(b, shrB);
 
 								tmp[counter] = a * b;
 								counter++;
@@ -398,7 +398,7 @@ inline __attribute__((always_inline)) void Conv(MYINT *A, const MYINT *B, MYINT
 								sum = 0;
 
 							if (shr)
-								tmp[p] = sum / 2;
+								tmp[p] = HALVE(sum);
 							else
 								tmp[p] = sum;
 						}
@@ -425,10 +425,10 @@ inline __attribute__((always_inline)) void AddOrSubCir4D(MYINT *A, const MYINT *
 			for (MYINT w = 0; w < W; w++) {
 				for (MYINT c = 0; c < C; c++) {
 					MYINT a = A[n * H * W * C + h * W * C + w * C + c];
-					a = a / shrA;
+					a = SCALE_DOWN(a, shrA);
 
 					MYINT b = ((MYINT) pgm_read_word_near(&B[c]));
-					b = b / shrB;
+					b = SCALE_DOWN(b, shrB);
 
 					MYINT res;
 					if (add)
@@ -436,7 +436,7 @@ inline __attribute__((always_inline)) void AddOrSubCir4D(MYINT *A, const MYINT *
 					else
 						res = a - b;
 
-					res = res / shrC;
+					res = SCALE_DOWN(res, shrC);
 
 					A[n * H * W * C + h * W * C + w * C + c] = res;
 				}
@@ -454,10 +454,10 @@ inline __attribute__((always_inline)) void AddOrSubCir2D(MYINT *A, const MYINT *
 	for (MYINT h = 0; h < H; h++) {
 		for (MYINT w = 0; w < W; w++) {
 			MYINT a = A[h * W + w];
-			a = a / shrA;
+			a = SCALE_DOWN(a, shrA);
 
 			MYINT b = ((MYINT) pgm_read_word_near(&B[w]));
-			b = b / shrB;
+			b = SCALE_DOWN(b, shrB);
 
 			MYINT res;
 			if (add)
@@ -465,7 +465,7 @@ inline __attribute__((always_inline)) void AddOrSubCir2D(MYINT *A, const MYINT *
 			else
 				res = a - b;
 
-			res = res / shrC;
+			res = SCALE_DOWN(res, shrC);
 
 			A[h * W + w] = res;
 		}
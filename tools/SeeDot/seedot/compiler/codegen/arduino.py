@@ -20,7 +20,7 @@ from seedot.util import *
 
 class Arduino(CodegenBase):
 
-    def __init__(self, writer, decls, scales, intvs, cnsts, expTables, globalVars):
+    def __init__(self, writer, decls, scales, intvs, cnsts, expTables, globalVars, buffers, bufferOf):
         self.out = writer
         self.decls = decls
         self.scales = scales
@@ -28,6 +28,8 @@ class Arduino(CodegenBase):
         self.cnsts = cnsts
         self.expTables = expTables
         self.globalVars = globalVars
+        self.buffers = buffers
+        self.bufferOf = bufferOf
 
     def printPrefix(self):
         self.printArduinoIncludes()
@@ -43,6 +45,10 @@ class Arduino(CodegenBase):
         self.out.printf('\n')
 
     def printArduinoIncludes(self):
+        # The scales are shift amounts, for the functions of library.h included below
+        if useShift():
+            self.out.printf('#define SHIFT\n\n', indent=True)
+
         self.out.printf('#include <Arduino.h>\n\n', indent=True)
         self.out.printf('#include "config.h"\n', indent=True)
         self.out.printf('#include "predict.h"\n', indent=True)
@@ -160,7 +160,11 @@ class CodegenBase:
 
     def printFuncCall(self, ir):
         self.out.printf("%s(" % ir.name, indent=True)
-        keys = list(ir.argList)
+        self.printFuncArgs(list(ir.argList))
+        self.out.printf(");\n\n")
+
+    # Tensors are passed as pointers to their first element
+    def printFuncArgs(self, keys):
         for i in range(len(keys)):
             arg = keys[i]
             if isinstance(arg, IR.Var) and arg.idf in self.decls.keys() and not arg.idf == 'X':
@@ -181,7 +185,6 @@ class CodegenBase:
                 self.out.printf("[0]" * x)
             if i != len(keys) - 1:
                 self.out.printf(", ")
-        self.out.printf(");\n\n")
 
     def printMemset(self, ir):
         self.out.printf('memset(', indent=True)
@@ -266,6 +269,8 @@ class CodegenBase:
         self.printSuffix(expr)
 
     def printVarDecls(self):
+        self.printBufferDecls()
+
         for decl in self.decls:
             if decl in self.globalVars:
                 continue
@@ -276,8 +281,22 @@ class CodegenBase:
                 shape_str = ''
             elif Type.isTensor(type):
                 shape_str = ''.join(['[' + str(n) + ']' for n in type.shape])
-            self.out.printf('%s %s%s;\n', typ_str, idf_str,
-                            shape_str, indent=True)
+            if decl in self.bufferOf:
+                # Reference to the shared buffer, viewed with the shape of the temporary
+                self.out.printf('%s (&%s)%s = *(%s (*)%s)%s;\n', typ_str, idf_str, shape_str,
+                                typ_str, shape_str, self.bufferOf[decl], indent=True)
+            else:
+                self.out.printf('%s %s%s;\n', typ_str, idf_str,
+                                shape_str, indent=True)
+        self.out.printf('\n')
+
+    # Buffers shared by the temporaries whose live ranges do not overlap
+    def printBufferDecls(self):
+        if len(self.buffers) == 0:
+            return
+        typ_str = IR.DataType.getIntStr()
+        for buffer, size in self.buffers.items():
+            self.out.printf('%s %s[%d];\n', typ_str, buffer, size, indent=True)
         self.out.printf('\n')
 
     def printConstDecls(self):
@@ -11,10 +11,39 @@ import seedot.compiler.ir.irUtil as IRUtil
 import seedot.compiler.type as Type
 from seedot.util import *
 
+# Functions of library.h also defined in library_template.h, with their integer
+# arguments as template parameters
+templateFuncs = ["MatAdd", "MatSub", "MatMulNN", "MatMulCN", "MatMulNC", "MatMulCC",
+                 "SparseMatMul", "MulCir", "TanH", "ArgMax", "Transpose", "ScalarMul",
+                 "Conv", "AddOrSubCir4D", "AddOrSubCir2D", "Relu4D", "Relu2D", "Maxpool"]
+
+# Argument of the library functions holding the result, profiled with --profile-ranges
+resultArgs = {
+    "MatAdd": "C",
+    "MatSub": "C",
+    "MatMulNN": "C",
+    "MatMulCN": "C",
+    "MatMulNC": "C",
+    "MatMulCC": "C",
+    "SparseMatMul": "C",
+    "MulCir": "C",
+    "TanH": "A",
+    "Transpose": "B",
+    "ScalarMul": "C",
+    "Conv": "C",
+    "AddOrSubCir4D": "A",
+    "AddOrSubCir2D": "A",
+    "Relu4D": "A",
+    "Relu2D": "A",
+    "Maxpool": "B",
+}
+
 
 class X86(CodegenBase):
 
-    def __init__(self, writer, decls, scales, intvs, cnsts, expTables, globalVars):
+    # With profileRanges, the range of every temporary is recorded after each
+    # command writing it, in the slot of profiledVars[idf]
+    def __init__(self, writer, decls, scales, intvs, cnsts, expTables, globalVars, buffers, bufferOf, profileRanges=False):
         self.out = writer
         self.decls = decls
         self.scales = scales
@@ -22,6 +51,10 @@ class X86(CodegenBase):
         self.cnsts = cnsts
         self.expTables = expTables
         self.globalVars = globalVars
+        self.buffers = buffers
+        self.bufferOf = bufferOf
+        self.profileRanges = profileRanges
+        self.profiledVars = {}
 
     def printPrefix(self):
         self.printCincludes()
@@ -43,7 +76,17 @@ class X86(CodegenBase):
         self.out.printf('#include "datatypes.h"\n', indent=True)
         self.out.printf('#include "predictors.h"\n', indent=True)
         self.out.printf('#include "library.h"\n', indent=True)
+        if useLibraryTemplates():
+            self.out.printf('#include "library_template.h"\n', indent=True)
+        if self.profileRanges:
+            self.out.printf('#include "profile.h"\n', indent=True)
         self.out.printf('#include "seedot_fixed_model.h"\n\n', indent=True)
+
+        # The scales are shift amounts, which library.cpp only handles when built with SHIFT
+        if useShift():
+            self.out.printf('#ifndef SHIFT\n', indent=True)
+            self.out.printf('#error "The code is generated with --shift, build it with make DEFINES=-DSHIFT"\n', indent=True)
+            self.out.printf('#endif\n\n', indent=True)
         self.out.printf('using namespace std;\n', indent=True)
         self.out.printf('using namespace %s_fixed;\n\n' %
                         (getAlgo()), indent=True)
@@ -68,6 +111,55 @@ class X86(CodegenBase):
         self.out.printf('int seedotFixed(MYINT **X) {\n', indent=True)
         self.out.increaseIndent()
 
+    def printFuncCall(self, ir):
+        self.printLibraryCall(ir)
+
+        if not self.profileRanges or ir.name not in resultArgs:
+            return
+        for arg, name in ir.argList.items():
+            if name == resultArgs[ir.name] and isinstance(arg, IR.Var) and self.isProfiled(arg.idf):
+                shape = self.decls[arg.idf].shape[len(arg.idx):]
+                size = 1
+                for n in shape:
+                    size *= n
+                self.out.printf("updateVarRange(%d, " % (self.getSlot(arg.idf)), indent=True)
+                self.printFuncArgs([arg])
+                self.out.printf(", %d);\n\n" % (size))
+
+    def printAssn(self, ir):
+        CodegenBase.printAssn(self, ir)
+
+        if self.profileRanges and self.isProfiled(ir.var.idf):
+            self.out.printf("updateVarRange(%d, " % (self.getSlot(ir.var.idf)), indent=True)
+            self.print(ir.var)
+            self.out.printf(");\n")
+
+    # The temporaries of the program, which the model and the input are not
+    def isProfiled(self, idf):
+        return idf in self.decls and idf not in self.globalVars and idf != 'X' and Type.isTensor(self.decls[idf])
+
+    def getSlot(self, idf):
+        return self.profiledVars.setdefault(idf, len(self.profiledVars))
+
+    # The calls to the library whose integer arguments are all constants are
+    # instantiated from library_template.h
+    def printLibraryCall(self, ir):
+        keys = list(ir.argList)
+        consts = [arg for arg in keys if isinstance(arg, (IR.Int, IR.Bool))]
+        args = [arg for arg in keys if isinstance(arg, IR.Var)]
+        if not useLibraryTemplates() or ir.name not in templateFuncs or len(consts) + len(args) != len(keys):
+            CodegenBase.printFuncCall(self, ir)
+            return
+
+        self.out.printf("%s<" % ir.name, indent=True)
+        for i in range(len(consts)):
+            self.print(consts[i])
+            if i != len(consts) - 1:
+                self.out.printf(", ")
+        self.out.printf(">(")
+        self.printFuncArgs(args)
+        self.out.printf(");\n\n")
+
     def printSuffix(self, expr: IR.Expr):
         self.out.printf('\n')
 
@@ -17,6 +17,7 @@ from seedot.compiler.codegen.x86 import X86 as X86Codegen
 
 from seedot.compiler.ir.irBuilder import IRBuilder
 import seedot.compiler.ir.irUtil as IRUtil
+from seedot.compiler.ir.liveness import BufferAllocator
 
 from seedot.compiler.type import InferType
 from seedot.util import *
@@ -25,10 +26,15 @@ from seedot.writer import Writer
 
 class Compiler:
 
-    def __init__(self, algo, target, inputFile, outputFile, profileLogFile, maxExpnt):
+    # With profileRanges, the x86 code records the range of each temporary. After run(),
+    # profiledVars lists the (name, scale) of the temporary of each slot
+    def __init__(self, algo, target, inputFile, outputFile, profileLogFile, maxExpnt, profileRanges=False):
         if os.path.isfile(inputFile) == False:
             raise Exception("Input file doesn't exist")
 
+        self.profileRanges = profileRanges
+        self.profiledVars = []
+
         setAlgo(algo)
         setTarget(target)
         self.input = FileStream(inputFile)
@@ -61,7 +67,7 @@ class Compiler:
         if forArduino():
             codegen = ArduinoCodegen(writer, *state)
         elif forX86():
-            codegen = X86Codegen(writer, *state)
+            codegen = X86Codegen(writer, *state, profileRanges=self.profileRanges)
         else:
             assert False
 
@@ -69,6 +75,11 @@ class Compiler:
 
         writer.close()
 
+        if forX86() and self.profileRanges:
+            scales = state[1]
+            slots = sorted(codegen.profiledVars.items(), key=lambda item: item[1])
+            self.profiledVars = [(idf, scales.get(idf)) for idf, slot in slots]
+
     def compile(self, ast):
         return self.genCodeWithFuncCalls(ast)
 
@@ -78,6 +89,12 @@ class Compiler:
 
         res = compiler.visit(ast)
 
-        state = compiler.decls, compiler.scales, compiler.intvs, compiler.cnsts, compiler.expTables, compiler.globalVars
+        # Temporaries which are never live at the same time share a buffer
+        buffers, bufferOf = {}, {}
+        if reuseBuffers():
+            allocator = BufferAllocator(compiler.decls, compiler.globalVars)
+            buffers, bufferOf = allocator.allocate(*res)
+
+        state = compiler.decls, compiler.scales, compiler.intvs, compiler.cnsts, compiler.expTables, compiler.globalVars, buffers, bufferOf
 
         return res, state
@@ -1560,7 +1560,7 @@ class IRBuilder(ASTVisitor):
 
         shrType = getShrType()
 
-        if shrType == "shr" or shrType == "shr+":
+        if shrType == "shr" or shrType == "shr+" or shrType == "shift":
             return IR.Int(n)
         elif shrType == "div":
             intVar = IR.Int(2 ** n)
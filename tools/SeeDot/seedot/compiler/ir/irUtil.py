@@ -110,6 +110,8 @@ def shr(e: Expr, n: int) -> Expr:
         return div(e, intVar)
     elif getShrType() == "negate":
         return cond_zero(e, IntBop(e, Op.Op['>>'], Int(n)), IntBop(IntBop(IntBop(e, Op.Op['^'], negone), Op.Op['>>'], Int(n)), Op.Op['^'], negone))
+    elif getShrType() == "shift":
+        return IntBop(e, Op.Op['>>'], Int(n))
     else:
         assert False
 
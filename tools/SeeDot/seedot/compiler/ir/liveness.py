@@ -0,0 +1,215 @@
+# Copyright (c) Microsoft Corporation. All rights reserved.
+# Licensed under the MIT license.
+
+'''
+Liveness analysis of the tensors of the IR, used to let temporaries whose
+live ranges do not overlap share the same buffer.
+
+The commands are numbered in program order, descending into loops and
+branches. A tensor is live from its first to its last reference. A tensor
+referenced both inside and outside a loop, or read in a loop body before being
+written in it, carries its value across iterations and is live during the whole
+loop.
+'''
+
+import seedot.compiler.ir.ir as IR
+
+import seedot.compiler.type as Type
+
+# Arguments of the library functions which are completely overwritten before
+# being read. The in-place functions (TanH, Relu, AddOrSubCir), SparseMatMul,
+# which accumulates into C, and the uninterpreted functions have none
+outputArgs = {
+    "MatAdd": ["C"],
+    "MatSub": ["C"],
+    "Transpose": ["B"],
+    "Maxpool": ["B"],
+    "ScalarMul": ["C"],
+    "MatMulNN": ["C", "T"],
+    "MatMulNC": ["C", "T"],
+    "MatMulCN": ["C", "T"],
+    "MatMulCC": ["C", "T"],
+    "MulCir": ["C"],
+    "Conv": ["C", "tmp"],
+    "ArgMax": ["index"],
+}
+
+
+class Liveness:
+
+    def __init__(self, decls, globalVars):
+        self.decls = decls
+        self.globalVars = globalVars
+
+    # Tensors which can be placed in a shared buffer
+    def isCandidate(self, idf):
+        if idf not in self.decls or idf in self.globalVars or idf == 'X':
+            return False
+        type = self.decls[idf]
+        return Type.isTensor(type) and type.dim > 0
+
+    # Returns {idf: [start, end]}, the live interval of each candidate tensor
+    def analyse(self, prog: IR.Prog, expr: IR.Expr):
+        # Event lists (index, isDef) of the candidates, and the ranges of the loops
+        self.events = {}
+        self.loops = []
+        self.index = 0
+
+        self.visitCmds(prog.cmd_l)
+
+        # The result is read after the last command
+        if isinstance(expr, IR.Var) and self.isCandidate(expr.idf):
+            self.events.setdefault(expr.idf, []).append((self.index, False))
+
+        intervals = {}
+        for idf, events in self.events.items():
+            intervals[idf] = [events[0][0], events[-1][0]]
+
+        # The loops are recorded innermost first, so the extension of an interval to
+        # an inner loop is seen by the enclosing ones
+        for start, end in self.loops:
+            for idf, interval in intervals.items():
+                if interval[1] < start or interval[0] > end:
+                    continue
+                if interval[0] < start or interval[1] > end or not self.definedInLoop(idf, start, end):
+                    interval[0] = min(interval[0], start)
+                    interval[1] = max(interval[1], end)
+
+        return intervals
+
+    # True if the first reference to idf in the loop body overwrites it
+    def definedInLoop(self, idf, start, end):
+        for index, isDef in self.events[idf]:
+            if start <= index <= end:
+                return isDef
+        return False
+
+    def addEvent(self, idf, isDef):
+        if self.isCandidate(idf):
+            events = self.events.setdefault(idf, [])
+            # A tensor both read and overwritten by a command is read
+            if len(events) > 0 and events[-1][0] == self.index:
+                events[-1] = (self.index, events[-1][1] and isDef)
+            else:
+                events.append((self.index, isDef))
+
+    def visitExpr(self, expr):
+        if isinstance(expr, IR.Var):
+            self.addEvent(expr.idf, False)
+            for e in expr.idx:
+                self.visitExpr(e)
+        elif isinstance(expr, (IR.IntUop, IR.BoolUop, IR.Exp)):
+            self.visitExpr(expr.e)
+        elif isinstance(expr, (IR.IntBop, IR.BoolBop, IR.BoolCop)):
+            self.visitExpr(expr.e1)
+            self.visitExpr(expr.e2)
+        elif isinstance(expr, IR.CExpr):
+            self.visitExpr(expr.cond)
+            self.visitExpr(expr.et)
+            self.visitExpr(expr.ef)
+        elif isinstance(expr, IR.TypeCast):
+            self.visitExpr(expr.expr)
+
+    def visitCmds(self, cmds):
+        for cmd in cmds:
+            self.visitCmd(cmd)
+
+    def visitCmd(self, cmd):
+        if isinstance(cmd, IR.Comment):
+            return
+
+        self.index += 1
+
+        if isinstance(cmd, IR.Assn):
+            # Only an assignment to a whole single-element tensor defines it
+            for e in cmd.var.idx:
+                self.visitExpr(e)
+            self.visitExpr(cmd.e)
+            type = self.decls.get(cmd.var.idf)
+            isDef = Type.isTensor(type) and type.size() == 1
+            self.addEvent(cmd.var.idf, isDef)
+        elif isinstance(cmd, IR.FuncCall):
+            outputs = outputArgs.get(cmd.name, [])
+            for arg, name in cmd.argList.items():
+                if isinstance(arg, IR.Var) and name in outputs and len(arg.idx) == 0:
+                    continue
+                self.visitExpr(arg)
+            for arg, name in cmd.argList.items():
+                if isinstance(arg, IR.Var) and name in outputs and len(arg.idx) == 0:
+                    self.addEvent(arg.idf, True)
+        elif isinstance(cmd, IR.Memset):
+            type = self.decls.get(cmd.e.idf)
+            isDef = len(cmd.e.idx) == 0 and Type.isTensor(type) and cmd.len == type.size()
+            for e in cmd.e.idx:
+                self.visitExpr(e)
+            self.addEvent(cmd.e.idf, isDef)
+        elif isinstance(cmd, IR.For):
+            start = self.index
+            self.visitExpr(cmd.cond)
+            self.visitCmds(cmd.cmd_l)
+            self.loops.append((start, self.index))
+        elif isinstance(cmd, IR.While):
+            start = self.index
+            self.visitExpr(cmd.expr)
+            self.visitCmds(cmd.cmds)
+            self.loops.append((start, self.index))
+        elif isinstance(cmd, IR.If):
+            self.visitExpr(cmd.cond)
+            self.visitCmds(cmd.trueCmds)
+            self.visitCmds(cmd.falseCmds)
+        elif isinstance(cmd, (IR.Print, IR.PrintAsFloat)):
+            self.visitExpr(cmd.expr)
+        else:
+            assert False
+
+
+class BufferAllocator:
+
+    def __init__(self, decls, globalVars):
+        self.decls = decls
+        self.globalVars = globalVars
+
+    # Assigns the temporaries to buffers such that the temporaries of a buffer are
+    # never live at the same time. Returns (buffers, bufferOf), where buffers maps
+    # the name of each buffer shared by several temporaries to its size and
+    # bufferOf maps each of these temporaries to its buffer
+    def allocate(self, prog: IR.Prog, expr: IR.Expr):
+        intervals = Liveness(self.decls, self.globalVars).analyse(prog, expr)
+
+        # Greedy interval partitioning in order of the start of the live ranges. Among
+        # the buffers free at that point, the smallest one holding the temporary is
+        # picked, else the largest one, which is grown
+        allocs = []
+        for idf in sorted(intervals, key=lambda idf: (intervals[idf][0], idf)):
+            start, end = intervals[idf]
+            size = self.decls[idf].size()
+            free = [alloc for alloc in allocs if alloc['end'] < start]
+            fits = [alloc for alloc in free if alloc['size'] >= size]
+            if len(fits) > 0:
+                alloc = min(fits, key=lambda alloc: alloc['size'])
+            elif len(free) > 0:
+                alloc = max(free, key=lambda alloc: alloc['size'])
+            else:
+                alloc = {'size': 0, 'end': 0, 'idfs': []}
+                allocs.append(alloc)
+            alloc['size'] = max(alloc['size'], size)
+            alloc['end'] = end
+            alloc['idfs'].append(idf)
+
+        buffers = {}
+        bufferOf = {}
+        for alloc in allocs:
+            if len(alloc['idfs']) < 2:
+                continue
+            name = self.newBufferName(len(buffers))
+            buffers[name] = alloc['size']
+            for idf in alloc['idfs']:
+                bufferOf[idf] = name
+
+        return buffers, bufferOf
+
+    def newBufferName(self, i):
+        name = "buf%d" % (i)
+        while name in self.decls or name in self.globalVars:
+            name = "_" + name
+        return name
@@ -0,0 +1,128 @@
+# Copyright (c) Microsoft Corporation. All rights reserved.
+# Licensed under the MIT license.
+
+'''
+Unit tests of the liveness analysis and of the buffer allocation. Run from
+tools/SeeDot with: python -m unittest seedot.compiler.ir.test_liveness
+'''
+
+import unittest
+
+import seedot.common as Common
+import seedot.compiler.ir.ir as IR
+import seedot.compiler.type as Type
+from seedot.compiler.ir.liveness import Liveness, BufferAllocator
+from seedot.util import *
+
+
+def matAdd(a, b, c):
+    return IR.FuncCall("MatAdd", {IR.Var(a): "A", IR.Var(b): "B", IR.Var(c): "C"})
+
+
+def loop(cmds, n=4):
+    i = IR.Var('i')
+    return IR.For(i, 0, IR.BoolCop(i, IR.Op.Op['<'], IR.Int(n)), cmds)
+
+
+class TestLiveness(unittest.TestCase):
+
+    def setUp(self):
+        setTarget(Common.Target.X86)
+        # X is the input and W a global, neither of which is a candidate
+        self.decls = {'X': Type.Tensor([2, 2]), 'W': Type.Tensor([2, 2])}
+        self.globalVars = ['W']
+
+    def declare(self, shape, *idfs):
+        for idf in idfs:
+            self.decls[idf] = Type.Tensor(shape)
+
+    def analyse(self, cmds, expr):
+        return Liveness(self.decls, self.globalVars).analyse(IR.Prog(cmds), IR.Var(expr))
+
+    def allocate(self, cmds, expr):
+        return BufferAllocator(self.decls, self.globalVars).allocate(IR.Prog(cmds), IR.Var(expr))
+
+    def test_loop_carried(self):
+        self.declare([2, 2], 'S', 'T', 'R')
+        cmds = [
+            IR.Comment("S is read in the loop before being written"),
+            loop([
+                matAdd('S', 'W', 'T'),
+                matAdd('T', 'W', 'S'),
+            ]),
+            matAdd('X', 'W', 'R'),
+        ]
+        intervals = self.analyse(cmds, 'R')
+
+        # The comment is not numbered, the loop is command 1
+        self.assertEqual(intervals['S'], [1, 3])
+        # T is overwritten before being read in every iteration
+        self.assertEqual(intervals['T'], [2, 3])
+        self.assertEqual(intervals['R'], [4, 4])
+        self.assertNotIn('X', intervals)
+        self.assertNotIn('W', intervals)
+
+        # S and T are live at the same time, R can reuse either of them
+        buffers, bufferOf = self.allocate(cmds, 'R')
+        self.assertNotEqual(bufferOf.get('S'), bufferOf.get('T'))
+        self.assertIn(bufferOf['R'], [bufferOf.get('S'), bufferOf.get('T')])
+        self.assertEqual(len(buffers), 1)
+
+    def test_same_command_read_write(self):
+        # An in-place addition both reads and overwrites T, which is a read
+        self.declare([2, 2], 'T')
+        cmds = [
+            loop([
+                IR.FuncCall("MatAdd", {IR.Var('T'): "A", IR.Var('W'): "B", IR.Var('T'): "C"}),
+            ]),
+        ]
+        intervals = self.analyse(cmds, 'T')
+        self.assertEqual(intervals['T'], [1, 2])
+
+        # So is an accumulation into a single-element tensor
+        self.declare([1, 1], 'acc')
+        acc = IR.Var('acc', [IR.Int(0), IR.Int(0)])
+        cmds = [
+            loop([
+                IR.Assn(acc, IR.IntBop(acc, IR.Op.Op['+'], IR.Var('X', [IR.Var('i'), IR.Int(0)]))),
+            ]),
+        ]
+        intervals = self.analyse(cmds, 'acc')
+        self.assertEqual(intervals['acc'], [1, 2])
+
+        # Whereas an assignment which does not read it defines it
+        cmds = [
+            loop([
+                IR.Assn(acc, IR.Var('X', [IR.Var('i'), IR.Int(0)])),
+            ]),
+        ]
+        intervals = self.analyse(cmds, 'X')
+        self.assertEqual(intervals['acc'], [2, 2])
+
+    def test_disjoint_intervals_share_buffer(self):
+        self.declare([2, 2], 'A', 'C')
+        self.declare([4, 2], 'B')
+        cmds = [
+            matAdd('X', 'W', 'A'),
+            IR.FuncCall("Transpose", {IR.Var('A'): "A", IR.Var('B'): "B"}),
+            IR.FuncCall("Transpose", {IR.Var('B'): "A", IR.Var('C'): "B"}),
+        ]
+        intervals = self.analyse(cmds, 'C')
+        self.assertEqual(intervals['A'], [1, 2])
+        self.assertEqual(intervals['B'], [2, 3])
+        self.assertEqual(intervals['C'], [3, 3])
+
+        # A ends before C starts, B overlaps both
+        buffers, bufferOf = self.allocate(cmds, 'C')
+        self.assertEqual(bufferOf['A'], bufferOf['C'])
+        self.assertNotIn('B', bufferOf)
+        self.assertEqual(buffers, {bufferOf['A']: 4})
+
+        # The buffer is sized for the largest of its temporaries
+        self.declare([8, 2], 'C')
+        buffers, bufferOf = self.allocate(cmds, 'C')
+        self.assertEqual(buffers, {bufferOf['A']: 16})
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -38,7 +38,8 @@ class Main:
 
     # Generate the fixed-point code using the input generated from the
     # Converter project
-    def compile(self, target, sf):
+    # With profileRanges, the x86 code records the ranges of its temporaries
+    def compile(self, target, sf, profileRanges=False):
         print("Generating code...", end='')
 
         # Set input and output files
@@ -53,8 +54,9 @@ class Main:
 
         try:
             obj = Compiler(self.algo, target, inputFile,
-                           outputFile, profileLogFile, sf)
+                           outputFile, profileLogFile, sf, profileRanges)
             obj.run()
+            self.profiledVars = obj.profiledVars
         except:
             print("failed!\n")
             #traceback.print_exc()
@@ -228,6 +230,67 @@ class Main:
 
         print("Accuracy is %.3f%%\n" % (acc))
 
+    # Run the code of the best scaling factor on the training dataset, recording the
+    # range of each temporary, and report the bits each temporary leaves unused
+    def profileVarRanges(self):
+        print("\n-------------------------------------")
+        print("Profiling the ranges of the variables")
+        print("-------------------------------------\n")
+
+        res = self.compile(Common.Target.X86, self.sf, profileRanges=True)
+        if res == False:
+            return False
+
+        acc = self.predict(Common.Version.Fixed, Common.DatasetType.Training)
+        if acc == None:
+            return False
+
+        rangesFile = os.path.join(Common.tempdir, "output", self.algo + "-" +
+                                  Common.Version.Fixed, "var-ranges-" + Common.DatasetType.Training + ".txt")
+        ranges = {}
+        with open(rangesFile, 'r') as file:
+            for line in file:
+                row = list(map(int, line.strip().split(", ")))
+                ranges[row[0]] = row[1:]
+
+        # The number of bits of a value, including its sign
+        def bitsOf(x):
+            return (~x if x < 0 else x).bit_length() + 1
+
+        histogram = Util.profileHistogram()
+        header = ["name", "scale", "min", "max", "minFloat", "maxFloat", "bits", "unusedBits"]
+        if histogram:
+            header += ["bits%d" % (b + 1) for b in range(Common.wordLength)]
+
+        reportFile = os.path.join(Common.outdir, "var-ranges.csv")
+        loose = 0
+        with open(reportFile, 'w') as file:
+            file.write(",".join(header) + "\n")
+            for slot, (idf, scale) in enumerate(self.profiledVars):
+                # The temporaries which are never written on the dataset have no range
+                if slot not in ranges or ranges[slot][0] > ranges[slot][1]:
+                    continue
+                minVal, maxVal = ranges[slot][0], ranges[slot][1]
+                bits = max(bitsOf(minVal), bitsOf(maxVal))
+                row = [idf, scale, minVal, maxVal]
+                if scale is None:
+                    row += ["", ""]
+                else:
+                    row += [minVal * 2.0 ** scale, maxVal * 2.0 ** scale]
+                row += [bits, Common.wordLength - bits]
+                if histogram:
+                    row += ranges[slot][2:]
+                file.write(",".join(map(str, row)) + "\n")
+
+                if Common.wordLength - bits >= 2:
+                    loose += 1
+
+        print("\n%d of %d variables leave at least 2 bits unused, which a smaller scale would use" % (
+            loose, len(self.profiledVars)))
+        print("Ranges of the variables written to %s\n" % (reportFile))
+
+        return True
+
     # Generate code for Arduino
     def compileForTarget(self):
         print("------------------------------")
@@ -261,6 +324,11 @@ class Main:
             if res == False:
                 return False
 
+        if Util.getProfileRanges() != None:
+            res = self.profileVarRanges()
+            if res == False:
+                return False
+
         res = self.runOnTestingDataset()
         if res == False:
             return False
@@ -344,6 +412,24 @@ class MainDriver:
         parser.add_argument("--tempdir", metavar='', help="Scratch directory")
         parser.add_argument("-o", "--outdir", metavar='',
                             help="Directory to output the generated Arduino sketch")
+        parser.add_argument("--shift", action="store_true",
+                            help="Scale with arithmetic shifts instead of divisions")
+        parser.add_argument("--no-templates", action="store_true",
+                            help="Call the functions of library.cpp from the x86 code instead of instantiating library_template.h")
+        parser.add_argument("--tune", action="store_true",
+                            help="Explore the bitwidths, exp table lengths, scaling operations and scale factors, and report the Pareto frontier")
+        parser.add_argument("--workers", type=int, default=os.cpu_count(), metavar='',
+                            help="Number of worker processes compiling and evaluating the candidates of --tune, which are then timed one at a time")
+        parser.add_argument("--bitwidths", type=int, nargs='+', choices=[16, 32], default=[16, 32], metavar='',
+                            help="Bitwidths explored by --tune")
+        parser.add_argument("--exp-lengths", type=int, nargs='+', metavar='',
+                            help="Exp table lengths explored by --tune (default: 5 6 7 for ProtoNN)")
+        parser.add_argument("--scalings", nargs='+', choices=["div", "shift"], metavar='',
+                            help="Scaling operations explored by --tune (default: div, or shift with --shift). With both, the accuracy of shift is reported against div")
+        parser.add_argument("--target-accuracy", type=float, metavar='',
+                            help="Accuracy (%%) for which --tune reports the fastest configuration")
+        parser.add_argument("--profile-ranges", choices=["range", "histogram"],
+                            help="Profile the range of each variable of the fixed-point code on the training dataset, optionally with a histogram of its number of bits")
 
         self.args = parser.parse_args()
 
@@ -369,6 +455,15 @@ class MainDriver:
             Common.outdir = os.path.join(Common.tempdir, "arduino")
             os.makedirs(Common.outdir, exist_ok=True)
 
+        if self.args.shift:
+            Util.setShrType("shift")
+
+        Util.setProfileRanges(self.args.profile_ranges)
+        Util.setLibraryTemplates(not self.args.no_templates)
+
+        if self.args.workers < 1:
+            parser.error("--workers must be positive")
+
     def checkMSBuildPath(self):
         found = False
         for path in Common.msbuildPathOptions:
@@ -380,6 +475,23 @@ class MainDriver:
             raise Exception("Msbuild.exe not found at the following locations:\n%s\nPlease change the path and run again" % (
                 Common.msbuildPathOptions))
 
+    def tune(self):
+        # Imported here as the tuner itself depends on Main
+        from seedot.tuner import Tuner
+
+        # Shifts are only explored on request, as their accuracy against divisions depends on the dataset.
+        # Bonsai has no exponentiation
+        shrTypes = self.args.scalings
+        if shrTypes is None:
+            shrTypes = ["shift"] if self.args.shift else ["div"]
+        expBitLengths = self.args.exp_lengths
+        if expBitLengths is None:
+            expBitLengths = [5, 6, 7] if self.args.algo == Common.Algo.Protonn else [Util.getExpBitLength()]
+
+        obj = Tuner(self.args.algo, self.args.train, self.args.test, self.args.model, self.args.bitwidths,
+                    expBitLengths, shrTypes, self.args.workers, self.args.target_accuracy)
+        obj.run()
+
     def run(self):
         if Util.windows():
             self.checkMSBuildPath()
@@ -394,6 +506,10 @@ class MainDriver:
         print("Model directory: %s" % (modelDir))
         print("================================\n")
 
+        if self.args.tune:
+            self.tune()
+            return
+
         obj = Main(algo, Common.Version.Fixed, Common.Target.Arduino,
                    trainingInput, testingInput, modelDir, None)
         obj.run()
@@ -13,8 +13,11 @@ import seedot.util as Util
 
 class Predictor:
 
-    def __init__(self, algo, version, datasetType, outputDir):
+    # numThreads is the number of threads evaluating the dataset, all the hardware threads if None
+    def __init__(self, algo, version, datasetType, outputDir, numThreads=None):
         self.algo, self.version, self.datasetType = algo, version, datasetType
+        self.numThreads = numThreads
+        self.timePerPrediction = None
 
         self.outputDir = outputDir
         os.makedirs(self.outputDir, exist_ok=True)
@@ -30,9 +33,13 @@ class Predictor:
         args = [Common.msbuildPath, projFile, r"/t:Build",
                 r"/p:Configuration=Release", r"/p:Platform=x64"]
 
+        # The compiler reads additional options from the CL environment variable
+        env = dict(os.environ)
+        env["CL"] = " ".join(["/D" + define for define in self.getDefines()])
+
         logFile = os.path.join(self.outputDir, "msbuild.txt")
         with open(logFile, 'w') as file:
-            process = subprocess.call(args, stdout=file)
+            process = subprocess.call(args, stdout=file, env=env)
 
         if process == 1:
             print("FAILED!!\n")
@@ -45,6 +52,9 @@ class Predictor:
         print("Build...", end='')
 
         args = ["make"]
+        defines = self.getDefines()
+        if len(defines) > 0:
+            args.append("DEFINES=" + " ".join(["-D" + define for define in defines]))
 
         logFile = os.path.join(self.outputDir, "msbuild.txt")
         with open(logFile, 'w') as file:
@@ -57,6 +67,17 @@ class Predictor:
             print("success")
             return True
 
+    # Macros of datatypes.h matching the configuration of the generated code
+    def getDefines(self):
+        defines = []
+        if Util.useShift():
+            defines.append("SHIFT")
+        if Common.wordLength == 32:
+            defines.append("INT32")
+        if Util.profileHistogram():
+            defines.append("PROFILE_HISTOGRAM")
+        return defines
+
     def build(self):
         if Util.windows():
             return self.buildForWindows()
@@ -71,6 +92,8 @@ class Predictor:
 
         exeFile = os.path.join("x64", "Release", "Predictor.exe")
         args = [exeFile, self.algo, self.version, self.datasetType]
+        if self.numThreads is not None:
+            args.append(str(self.numThreads))
 
         logFile = os.path.join(self.outputDir, "exec.txt")
         with open(logFile, 'w') as file:
@@ -89,6 +112,8 @@ class Predictor:
 
         exeFile = os.path.join("./Predictor")
         args = [exeFile, self.algo, self.version, self.datasetType]
+        if self.numThreads is not None:
+            args.append(str(self.numThreads))
 
         logFile = os.path.join(self.outputDir, "exec.txt")
         with open(logFile, 'w') as file:
@@ -108,7 +133,7 @@ class Predictor:
         else:
             return self.executeForLinux()
 
-    # Read statistics of execution (currently only accuracy)
+    # Read statistics of execution: the accuracy, followed by the time per prediction in microseconds
     def readStatsFile(self):
         statsFile = os.path.join(
             "output", self.algo + "-" + self.version, "stats-" + self.datasetType + ".txt")
@@ -118,6 +143,9 @@ class Predictor:
 
         stats = [x.strip() for x in content]
 
+        if len(stats) > 1:
+            self.timePerPrediction = float(stats[1])
+
         return float(stats[0])
 
     def run(self):
@@ -0,0 +1,312 @@
+# Copyright (c) Microsoft Corporation. All rights reserved.
+# Licensed under the MIT license.
+
+'''
+Exploration of the configurations of the fixed-point code: the bitwidth, the
+length of the exponentiation tables, the scaling operation and the maximum
+scale factor. Every candidate is compiled and evaluated on the training dataset
+in a worker process. The candidates are then timed one at a time, once all the
+workers are done, and the candidates on the Pareto frontier of accuracy, model
+size and time per prediction are reported.
+'''
+
+import contextlib
+import multiprocessing
+import os
+import re
+import shutil
+
+import seedot.common as Common
+from seedot.main import Main
+from seedot.predictor import Predictor
+import seedot.util as Util
+
+fields = ["bitwidth", "expBitLength", "shrType", "maxScale",
+          "accuracy", "accuracyDelta", "modelSize", "timePerPrediction", "pareto"]
+
+
+# Bytes of the constants of the generated code: the model and the exponentiation tables
+def getModelSize(tempdir, bitwidth):
+    size = 0
+    for fileName in ["seedot_fixed_model.h", "seedot_fixed.cpp"]:
+        with open(os.path.join(tempdir, fileName), 'r') as file:
+            content = file.read()
+        for shape in re.findall(r'const MYINT \w+((?:\[\d+\])+)', content):
+            elements = 1
+            for n in re.findall(r'\d+', shape):
+                elements *= int(n)
+            size += elements * bitwidth // 8
+    return size
+
+
+# Remove the build of a candidate, only keeping its log
+def cleanup(tempdir):
+    for entry in os.listdir(tempdir):
+        path = os.path.join(tempdir, entry)
+        if os.path.isdir(path):
+            shutil.rmtree(path)
+        elif entry != "log.txt":
+            os.remove(path)
+
+
+# Compile and evaluate one candidate in its own scratch directory. Runs in a
+# worker process, hence the configuration is passed explicitly instead of
+# through the globals of the parent process. The build of a candidate which
+# could be evaluated is kept for timing it
+def evaluate(job):
+    tempdir, candidate = job[4], job[-1]
+    curDir = os.getcwd()
+    try:
+        result = evaluateInTempdir(job)
+    except Exception:
+        result = None
+    os.chdir(curDir)
+    if result is None:
+        cleanup(tempdir)
+    return candidate, tempdir, result
+
+
+def evaluateInTempdir(job):
+    algo, trainingFile, testingFile, modelDir, tempdir, profileFile, msbuildPath, libraryTemplates, candidate = job
+
+    Common.wordLength = candidate["bitwidth"]
+    Common.maxScaleRange = 0, -Common.wordLength
+    Common.msbuildPath = msbuildPath
+    Common.tempdir = tempdir
+    Common.outdir = os.path.join(tempdir, "arduino")
+    os.makedirs(Common.outdir, exist_ok=True)
+    Util.setExpBitLength(candidate["expBitLength"])
+    Util.setShrType(candidate["shrType"])
+    Util.setLibraryTemplates(libraryTemplates)
+
+    with open(os.path.join(tempdir, "log.txt"), 'w') as log, contextlib.redirect_stdout(log), contextlib.redirect_stderr(log):
+        obj = Main(algo, Common.Version.Fixed, Common.Target.X86,
+                   trainingFile, testingFile, modelDir, candidate["maxScale"])
+        obj.setup()
+
+        if profileFile is not None:
+            profileDir = os.path.join(tempdir, "output", algo + "-float")
+            os.makedirs(profileDir, exist_ok=True)
+            shutil.copyfile(profileFile, os.path.join(profileDir, "profile.txt"))
+
+        if obj.convert(Common.Version.Fixed, Common.DatasetType.Training, Common.Target.X86) == False:
+            return None
+        if obj.compile(Common.Target.X86, candidate["maxScale"]) == False:
+            return None
+
+        # The workers already use all the cores, so each predictor runs on one thread.
+        # Its time is not used, being inflated by the other workers
+        outputDir = os.path.join(tempdir, "output", algo + "-fixed")
+        os.chdir(tempdir)
+        predictor = Predictor(algo, Common.Version.Fixed,
+                              Common.DatasetType.Training, outputDir, numThreads=1)
+        acc = predictor.run()
+
+    if acc is None:
+        return None
+
+    result = dict(candidate)
+    result["accuracy"] = acc
+    result["modelSize"] = getModelSize(tempdir, candidate["bitwidth"])
+    return result
+
+
+# Time the predictor built by evaluate in tempdir, on one thread. Runs in the
+# parent process after the workers are done, so that the candidates do not
+# compete for the cores, the caches and the memory bandwidth while being timed
+def timePrediction(algo, tempdir):
+    curDir = os.getcwd()
+    try:
+        os.chdir(tempdir)
+        with open(os.path.join(tempdir, "log.txt"), 'a') as log, contextlib.redirect_stdout(log), contextlib.redirect_stderr(log):
+            outputDir = os.path.join(tempdir, "output", algo + "-fixed")
+            predictor = Predictor(algo, Common.Version.Fixed,
+                                  Common.DatasetType.Training, outputDir, numThreads=1)
+            acc = predictor.execute()
+    except Exception:
+        acc = None
+    os.chdir(curDir)
+    cleanup(tempdir)
+
+    if acc is None:
+        return None
+    return predictor.timePerPrediction
+
+
+def describe(candidate):
+    return "bitwidth %d, exp length %d, %s, max scale %d" % (
+        candidate["bitwidth"], candidate["expBitLength"], candidate["shrType"], candidate["maxScale"])
+
+
+# The configuration of a candidate, apart from its scaling operation
+def configuration(candidate):
+    return (candidate["bitwidth"], candidate["expBitLength"], candidate["maxScale"])
+
+
+# a is at least as good as b on every objective and better on one
+def dominates(a, b):
+    notWorse = a["accuracy"] >= b["accuracy"] and a["modelSize"] <= b["modelSize"] and a["timePerPrediction"] <= b["timePerPrediction"]
+    better = a["accuracy"] > b["accuracy"] or a["modelSize"] < b["modelSize"] or a["timePerPrediction"] < b["timePerPrediction"]
+    return notWorse and better
+
+
+class Tuner:
+
+    def __init__(self, algo, trainingFile, testingFile, modelDir, bitwidths, expBitLengths, shrTypes, numWorkers, targetAccuracy):
+        self.algo = algo
+        self.trainingFile, self.testingFile, self.modelDir = trainingFile, testingFile, modelDir
+        self.bitwidths, self.expBitLengths, self.shrTypes = bitwidths, expBitLengths, shrTypes
+        self.numWorkers = numWorkers
+        self.targetAccuracy = targetAccuracy
+
+    # Every valid maximum scale factor is explored, as in Main.performSearch
+    def getCandidates(self):
+        candidates = []
+        for bitwidth in self.bitwidths:
+            for expBitLength in self.expBitLengths:
+                for shrType in self.shrTypes:
+                    for maxScale in range(0, -bitwidth, -1):
+                        candidates.append({"bitwidth": bitwidth, "expBitLength": expBitLength,
+                                           "shrType": shrType, "maxScale": maxScale})
+        return candidates
+
+    # The profile of the floating-point code does not depend on the candidate, so it
+    # is collected once and copied to the scratch directory of each candidate
+    def collectProfileData(self):
+        if self.algo != Common.Algo.Protonn:
+            return None
+
+        tempdir, outdir = Common.tempdir, Common.outdir
+        Common.tempdir = os.path.join(tempdir, "profile")
+        Common.outdir = os.path.join(Common.tempdir, "arduino")
+        os.makedirs(Common.outdir, exist_ok=True)
+
+        obj = Main(self.algo, Common.Version.Float, Common.Target.X86,
+                   self.trainingFile, self.testingFile, self.modelDir, None)
+        obj.setup()
+        obj.collectProfileData()
+        profileFile = os.path.join(
+            Common.tempdir, "output", self.algo + "-float", "profile.txt")
+
+        Common.tempdir, Common.outdir = tempdir, outdir
+
+        if not os.path.isfile(profileFile):
+            return False
+        return profileFile
+
+    def run(self):
+        profileFile = self.collectProfileData()
+        if profileFile == False:
+            return False
+
+        candidates = self.getCandidates()
+        jobs = []
+        for i in range(len(candidates)):
+            tempdir = os.path.join(Common.tempdir, "candidate%d" % (i))
+            os.makedirs(tempdir, exist_ok=True)
+            jobs.append((self.algo, self.trainingFile, self.testingFile, self.modelDir,
+                         tempdir, profileFile, getattr(Common, "msbuildPath", None), Util.useLibraryTemplates(), candidates[i]))
+
+        print("\n-------------------------------------------------")
+        print("Evaluating %d configurations with %d workers" %
+              (len(jobs), self.numWorkers))
+        print("-------------------------------------------------\n")
+
+        evaluated = []
+        with multiprocessing.Pool(self.numWorkers) as pool:
+            for candidate, tempdir, result in pool.imap_unordered(evaluate, jobs):
+                if result is None:
+                    print("%s: failed" % (describe(candidate)))
+                    continue
+                print("%s: accuracy %.3f%%, %d bytes" % (
+                    describe(candidate), result["accuracy"], result["modelSize"]))
+                evaluated.append((tempdir, result))
+
+        print("\n-------------------------------------------------")
+        print("Timing %d configurations one at a time" % (len(evaluated)))
+        print("-------------------------------------------------\n")
+
+        results = []
+        for tempdir, result in evaluated:
+            result["timePerPrediction"] = timePrediction(self.algo, tempdir)
+            if result["timePerPrediction"] is None:
+                print("%s: failed" % (describe(result)))
+                continue
+            print("%s: %.3f us" % (describe(result), result["timePerPrediction"]))
+            results.append(result)
+
+        if len(results) == 0:
+            print("\nNo configuration could be evaluated")
+            return False
+
+        for result in results:
+            result["pareto"] = int(not any(dominates(other, result) for other in results))
+
+        # Accuracy of a shift candidate minus the one of the div candidate of the same configuration
+        divAccuracy = {configuration(r): r["accuracy"] for r in results if r["shrType"] == "div"}
+        for result in results:
+            result["accuracyDelta"] = ""
+            if result["shrType"] == "shift" and configuration(result) in divAccuracy:
+                result["accuracyDelta"] = round(result["accuracy"] - divAccuracy[configuration(result)], 3)
+
+        self.writeResults(results)
+        self.printShiftAccuracy(results)
+        self.printFrontier(results)
+
+        return True
+
+    def writeResults(self, results):
+        resultsFile = os.path.join(Common.outdir, "tuning.csv")
+        results = sorted(results, key=lambda r: (r["bitwidth"], r["expBitLength"], r["shrType"], -r["maxScale"]))
+        with open(resultsFile, 'w') as file:
+            file.write(",".join(fields) + "\n")
+            for result in results:
+                file.write(",".join([str(result[field]) for field in fields]) + "\n")
+
+        print("\nResults of all the configurations written to %s" % (resultsFile))
+
+    # For each bitwidth and exp table length explored with both scaling operations, the best accuracy of each and the
+    # accuracy delta of shift over the max scales evaluated with both
+    def printShiftAccuracy(self, results):
+        deltas = [r for r in results if r["accuracyDelta"] != ""]
+        if len(deltas) == 0:
+            return
+
+        print("\n-------------------------------------------------")
+        print("Accuracy of shift against div")
+        print("-------------------------------------------------")
+        print("%8s %8s %10s %10s %10s %10s %10s" % ("bitwidth", "exp", "best div", "best shift",
+                                                  "delta", "mean delta", "min delta"))
+        for bitwidth, expBitLength in sorted(set((r["bitwidth"], r["expBitLength"]) for r in deltas)):
+            group = [r for r in results if r["bitwidth"] == bitwidth and r["expBitLength"] == expBitLength]
+            bestDiv = max(r["accuracy"] for r in group if r["shrType"] == "div")
+            bestShift = max(r["accuracy"] for r in group if r["shrType"] == "shift")
+            groupDeltas = [r["accuracyDelta"] for r in group if r["accuracyDelta"] != ""]
+            print("%8d %8d %9.3f%% %9.3f%% %9.3f%% %9.3f%% %9.3f%%" % (bitwidth, expBitLength, bestDiv, bestShift,
+                                                                bestShift - bestDiv, sum(groupDeltas) / len(groupDeltas), min(groupDeltas)))
+
+    def printFrontier(self, results):
+        frontier = sorted([r for r in results if r["pareto"]],
+                          key=lambda r: (r["timePerPrediction"], r["modelSize"], -r["accuracy"]))
+
+        print("\n-------------------------------------------------")
+        print("Pareto frontier (accuracy, model size, time per prediction)")
+        print("-------------------------------------------------")
+        print("%8s %8s %8s %9s %10s %12s %10s" % ("bitwidth", "exp", "shr",
+                                               "max scale", "accuracy", "size (B)", "time (us)"))
+        for r in frontier:
+            print("%8d %8d %8s %9d %9.3f%% %12d %10.3f" % (r["bitwidth"], r["expBitLength"], r["shrType"],
+                                                        r["maxScale"], r["accuracy"], r["modelSize"], r["timePerPrediction"]))
+
+        if self.targetAccuracy is None:
+            return
+
+        # The fastest configuration reaching the target is on the frontier
+        eligible = [r for r in frontier if r["accuracy"] >= self.targetAccuracy]
+        if len(eligible) == 0:
+            print("\nNo configuration reaches an accuracy of %.3f%%" % (self.targetAccuracy))
+            return
+
+        best = eligible[0]
+        print("\nFastest configuration with an accuracy of at least %.3f%%: bitwidth %d, exp length %d, %s, max scale %d" % (
+            self.targetAccuracy, best["bitwidth"], best["expBitLength"], best["shrType"], best["maxScale"]))
@@ -10,6 +10,10 @@ class Config:
     expBigLength = 6
     exp = "table"  # "table" "math"
     codegen = "funcCall"  # "funcCall" "inline"
+    shrType = "div"  # "shr" "shr+" "div" "negate" "shift"
+    reuseBuffers = True
+    libraryTemplates = True
+    profileRanges = None  # None "range" "histogram"
 
 
 def windows():
@@ -56,6 +60,10 @@ def getExpBitLength():
     return Config.expBigLength
 
 
+def setExpBitLength(length: int):
+    Config.expBigLength = length
+
+
 def getMaxScale():
     return Config.maxExpnt
 
@@ -65,8 +73,52 @@ def setMaxExpnt(x: int):
 
 
 def getShrType():
-    # "shr" "shr+" "div" "negate"
-    return "div"
+    return Config.shrType
+
+
+# "div" scales by dividing by powers of two, rounding toward zero
+# "shift" scales by arithmetic right shifts, rounding toward -infinity, and passes the shift amounts to the library
+def setShrType(shrType: str):
+    Config.shrType = shrType
+
+
+def useShift():
+    return Config.shrType == "shift"
+
+
+# Temporaries with disjoint live ranges share the same buffer in the generated code
+def reuseBuffers():
+    return Config.reuseBuffers
+
+
+def setReuseBuffers(reuse: bool):
+    Config.reuseBuffers = reuse
+
+
+# The x86 code calls the library functions of library_template.h, specialized
+# for the shapes and scales of each call. The Arduino code keeps the functions
+# of library.cpp, as every instantiation adds to the size of the sketch
+def useLibraryTemplates():
+    return Config.libraryTemplates
+
+
+def setLibraryTemplates(use: bool):
+    Config.libraryTemplates = use
+
+
+# The ranges of the temporaries of the fixed-point code are profiled on the
+# training dataset, with a histogram of their number of significant bits
+# in the "histogram" mode
+def getProfileRanges():
+    return Config.profileRanges
+
+
+def setProfileRanges(mode):
+    Config.profileRanges = mode
+
+
+def profileHistogram():
+    return Config.profileRanges == "histogram"
 
 
 def useMathExp():